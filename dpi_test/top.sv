@@ -0,0 +1,23 @@
+//----------------------------------------------------------------------------
+// Copyright (c) 2019 by Ando Ki.
+// All right reserved.
+//----------------------------------------------------------------------------
+// top.sv
+//----------------------------------------------------------------------------
+// VERSION: 2019.05.20.
+//----------------------------------------------------------------------------
+module top;
+    `include "network_dpi_lib.svh"
+    initial begin
+        if (1) test_compare;
+        if ($test$plusargs("bench")) test_bench;
+        #10; $finish(2);
+    end
+    //------------------------------------------------------------------------
+    `include "top_tasks_bench.sv"
+endmodule
+//----------------------------------------------------------------------------
+// Revision history:
+//
+// 2019.05.20: Started by Ando Ki (andoki@gmail.com)
+//----------------------------------------------------------------------------
@@ -0,0 +1,91 @@
+`ifndef TOP_TASKS_BENCH_SV
+`define TOP_TASKS_BENCH_SV
+//----------------------------------------------------------------------------
+// It builds the same UDP/IP/Ethernet frame by VPI task and DPI-C function
+// and checks both are the same.
+task test_compare;
+    reg  [ 7:0] pkt_vpi[0:4095];
+    byte unsigned pkt_dpi[0:4095];
+    reg  [ 7:0] payload_vpi[0:4095];
+    byte unsigned payload_dpi[0:4095];
+    reg  [15:0] bnum_vpi;
+    int         bnum_dpi;
+    int         idx, err;
+begin
+        for (idx=0; idx<4096; idx=idx+1) begin
+             payload_vpi[idx] = idx*7+1;
+             payload_dpi[idx] = idx*7+1;
+        end
+        $pkt_udp_ip_ethernet( pkt_vpi, bnum_vpi
+                            , 16'h2112, 16'h1221
+                            , 32'hC0ABCDEF, 32'hC1234567, 8'h1
+                            , 48'h02_12_34_56_78_9A, 48'h02_11_22_33_44_55
+                            , 16'd100, payload_vpi
+                            , 1, 1);
+        bnum_dpi = dpi_pkt_udp_ip_ethernet( pkt_dpi
+                            , 16'h2112, 16'h1221
+                            , 32'hC0ABCDEF, 32'hC1234567, 8'h1
+                            , 48'h02_12_34_56_78_9A, 48'h02_11_22_33_44_55
+                            , 16'd100, payload_dpi
+                            , 1, 1);
+        err = (bnum_vpi!=bnum_dpi);
+        for (idx=0; idx<bnum_dpi; idx=idx+1) begin
+             if (pkt_vpi[idx]!==pkt_dpi[idx]) err = err + 1;
+        end
+        if (err) $display("%m ERROR %0d mismatches between VPI and DPI-C", err);
+        else     $display("%m OK %0d bytes", bnum_dpi);
+        void'(dpi_pkt_ethernet_parser(pkt_dpi, bnum_dpi, 1, 1));
+end
+endtask
+
+//----------------------------------------------------------------------------
+// It builds 1500-byte UDP/IP/Ethernet frames repeatedly by VPI task and
+// by DPI-C function and reports frames per second in host wall-clock.
+// Run with '+bench' and optionally '+bench_num=<num-of-frames>'.
+task test_bench;
+    reg  [ 7:0] pkt_vpi[0:4095];
+    byte unsigned pkt_dpi[0:4095];
+    reg  [ 7:0] payload_vpi[0:4095];
+    byte unsigned payload_dpi[0:4095];
+    reg  [15:0] bnum_pkt;
+    reg  [15:0] bnum_payload;
+    int         idx, num;
+    reg  [63:0] start, stop;
+begin
+        if (!$value$plusargs("bench_num=%d", num)) num = 10000;
+        bnum_payload=1500-14-20-8; // 1500-byte frame without FCS
+        for (idx=0; idx<4096; idx=idx+1) begin
+             payload_vpi[idx] = idx+1;
+             payload_dpi[idx] = idx+1;
+        end
+        //--------------------------------------------------------------------
+        start = $pkt_wallclock;
+        for (idx=0; idx<num; idx=idx+1) begin
+            $pkt_udp_ip_ethernet( pkt_vpi, bnum_pkt
+                                , 16'h2112, 16'h1221
+                                , 32'hC0ABCDEF, 32'hC1234567, 8'h1
+                                , 48'h02_12_34_56_78_9A, 48'h02_11_22_33_44_55
+                                , bnum_payload, payload_vpi
+                                , 0, 0);
+        end
+        stop = $pkt_wallclock;
+        if (stop==start) stop = start + 1;
+        $display("%m VPI   %0d frames of %0d bytes in %0d usec: %0d frames/sec",
+                  num, bnum_pkt, stop-start, (num*64'd1000000)/(stop-start));
+        //--------------------------------------------------------------------
+        start = $pkt_wallclock;
+        for (idx=0; idx<num; idx=idx+1) begin
+            bnum_pkt = dpi_pkt_udp_ip_ethernet( pkt_dpi
+                                , 16'h2112, 16'h1221
+                                , 32'hC0ABCDEF, 32'hC1234567, 8'h1
+                                , 48'h02_12_34_56_78_9A, 48'h02_11_22_33_44_55
+                                , bnum_payload, payload_dpi
+                                , 0, 0);
+        end
+        stop = $pkt_wallclock;
+        if (stop==start) stop = start + 1;
+        $display("%m DPI-C %0d frames of %0d bytes in %0d usec: %0d frames/sec",
+                  num, bnum_pkt, stop-start, (num*64'd1000000)/(stop-start));
+end
+endtask
+`endif
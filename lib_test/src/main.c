@@ -1,13 +1,84 @@
 //----------------------------------------------------------------------------
 #include <stdio.h>
 #include <stdint.h>
+#include <string.h>
 
 extern int test_checksum();
+extern int test_checksum_kernel();
+extern int test_checksum_bench();
+extern int test_crc();
+extern int test_crc_bench();
+extern int test_build();
+extern int test_build_bench();
+extern int test_template();
+extern int test_template_bench();
+extern int test_pkt_buf();
+extern int test_iov();
+extern int test_iov_bench();
+extern int test_jumbo();
+extern int test_jumbo_bench();
+extern int test_segment();
+extern int test_segment_bench();
+extern int test_fragment();
+extern int test_fragment_bench();
+extern int test_reasm();
+extern int test_reasm_bench();
+extern int test_stream();
+extern int test_stream_bench();
+extern int test_vlan();
+extern int test_vlan_bench();
+extern int test_ipv6();
+extern int test_ipv6_bench();
+extern int test_arp();
+extern int test_arp_bench();
+extern int test_icmp();
+extern int test_icmp_bench();
+extern int test_ptpv2();
+extern int test_ptpv2_bench();
+extern int test_ptpv2_sequence();
+extern int test_ptpv2_sequence_bench();
 
 //----------------------------------------------------------------------------
-int main()
+// Run with 'bench' to measure throughput.
+int main(int argc, char *argv[])
 {
+    if ((argc>1)&&!strcmp(argv[1], "bench")) {
+        test_checksum_bench();
+        test_crc_bench();
+        test_build_bench();
+        test_template_bench();
+        test_iov_bench();
+        test_jumbo_bench();
+        test_segment_bench();
+        test_fragment_bench();
+        test_reasm_bench();
+        test_stream_bench();
+        test_vlan_bench();
+        test_ipv6_bench();
+        test_arp_bench();
+        test_icmp_bench();
+        test_ptpv2_bench();
+        test_ptpv2_sequence_bench();
+        return 0;
+    }
     test_checksum();
+    test_checksum_kernel();
+    test_crc();
+    test_build();
+    test_template();
+    test_pkt_buf();
+    test_iov();
+    test_jumbo();
+    test_segment();
+    test_fragment();
+    test_reasm();
+    test_stream();
+    test_vlan();
+    test_ipv6();
+    test_arp();
+    test_icmp();
+    test_ptpv2();
+    test_ptpv2_sequence();
     return 0;
 }
 //----------------------------------------------------------------------------
@@ -0,0 +1,183 @@
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include "eth_ip_udp_tcp_pkt.h"
+#include "test_util.h"
+#include "pkt_arp.h"
+
+//----------------------------------------------------------------------------
+#define ARP_HOSTS 4096
+#define ARP_FRAME (8+ETH_HDR_LEN+(PKT_VLAN_MAX+2)*ETH_VLAN_TAG_LEN+46+4)
+
+static uint8_t request[ARP_FRAME];
+static uint8_t reply[ARP_FRAME];
+
+static uint8_t  dut_mac[6] = { 0x02, 0xDD, 0x00, 0x00, 0x00, 0x01 };
+static uint8_t  bcast[6]   = { 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF };
+static uint32_t dut_ip     = 0x0A000001;
+
+//----------------------------------------------------------------------------
+// MAC address of host 'idx'
+static void host_mac(int idx, uint8_t mac[6])
+{
+    mac[0] = 0x02; mac[1] = 0x00; mac[2] = 0x5E;
+    mac[3] = (idx>>16)&0xFF; mac[4] = (idx>>8)&0xFF; mac[5] = idx&0xFF;
+}
+static uint32_t host_ip(int idx) { return 0xC0A80000+idx+1; }
+
+//----------------------------------------------------------------------------
+// It checks 'pkt' of 'bnum' bytes is the reply of host 'idx' to DUT
+// with 'vlan_num' tags.
+static int reply_check(const uint8_t *pkt, int bnum, int idx, int vlan_num)
+{
+    const uint8_t *arp;
+    uint8_t mac[6];
+    uint16_t type_len;
+    int hdr;
+    host_mac(idx, mac);
+    hdr = get_eth_type(pkt, bnum, &type_len);
+    if ((hdr!=(ETH_HDR_LEN+vlan_num*ETH_VLAN_TAG_LEN))||(type_len!=ETH_TYPE_ARP)) return 1;
+    if (bnum!=(hdr+((ARP_HDR_LEN<(46-vlan_num*ETH_VLAN_TAG_LEN)) ? (46-vlan_num*ETH_VLAN_TAG_LEN) : ARP_HDR_LEN)+4)) return 1;
+    if (memcmp(&pkt[0], dut_mac, 6)||memcmp(&pkt[6], mac, 6)) return 1;
+    arp = &pkt[hdr];
+    if ((arp[6]!=0)||(arp[7]!=ARP_OP_REPLY)) return 1;
+    if (memcmp(&arp[8], mac, 6)||memcmp(&arp[18], dut_mac, 6)) return 1;
+    if ((((uint32_t)arp[14]<<24)|(arp[15]<<16)|(arp[16]<<8)|arp[17])!=host_ip(idx)) return 1;
+    if ((((uint32_t)arp[24]<<24)|(arp[25]<<16)|(arp[26]<<8)|arp[27])!=dut_ip) return 1;
+    if (vlan_num&&memcmp(&pkt[12], &request[12], vlan_num*ETH_VLAN_TAG_LEN)) return 1;
+    if (check_eth_crc((uint8_t*)pkt, bnum)) return 1;
+    return 0;
+}
+
+//----------------------------------------------------------------------------
+// It answers requests of DUT for thousands of local hosts, learns DUT,
+// and drops the least recently used learned entries when full.
+// Return 0 on success, 1 on failure
+int test_arp(void)
+{
+    pkt_arp_t *arp;
+    pkt_arp_entry_t *entry;
+    uint8_t mac[6];
+    int idx, num, bnum, err=0;
+
+    my_srand(22);
+    arp = pkt_arp_create(ARP_HOSTS+16, 8);
+    if (arp==NULL) {
+        printf("ARP error: create\n");
+        return 1;
+    }
+    for (idx=0; idx<ARP_HOSTS; idx++) {
+         host_mac(idx, mac);
+         if (pkt_arp_add(arp, host_ip(idx), mac, 1)) err = 1;
+    }
+    //-----------------------------------------------------------------------
+    // requests in random order with 0, 1 and 2 tags, where CRC is checked
+    for (num=0; num<2*ARP_HOSTS; num++) {
+         int tags = num%(PKT_VLAN_MAX+1);
+         idx  = my_rand()%ARP_HOSTS;
+         bnum = gen_eth_arp_packet_vlan(request, dut_mac, bcast, &vlan_tags[PKT_VLAN_MAX-tags], tags
+                                       , ARP_OP_REQUEST, dut_ip, host_ip(idx), 1, 0);
+         if (check_eth_crc(request, bnum)||(pkt_arp_put(arp, request, bnum)!=1)) {
+             printf("ARP error: request %d\n", idx);
+             err = 1;
+             continue;
+         }
+         bnum = pkt_arp_get(arp, reply, 1, 0);
+         if (reply_check(reply, bnum, idx, tags)) {
+             printf("ARP error: reply %d with %d tags\n", idx, tags);
+             err = 1;
+         }
+    }
+    entry = pkt_arp_lookup(arp, dut_ip);
+    if ((entry==NULL)||entry->local||memcmp(entry->mac, dut_mac, 6)||
+        (pkt_arp_get(arp, reply, 1, 0)!=0)) {
+        printf("ARP error: learning\n");
+        err = 1;
+    }
+    //-----------------------------------------------------------------------
+    // no reply for other hosts nor replies; queue full
+    bnum = gen_eth_arp_packet(request, dut_mac, bcast, ARP_OP_REQUEST, dut_ip, 0x0B000001, 1, 0);
+    if (pkt_arp_put(arp, request, bnum)!=0) err = 1;
+    bnum = gen_eth_arp_packet(request, dut_mac, bcast, ARP_OP_REPLY, dut_ip, host_ip(0), 1, 0);
+    if (pkt_arp_put(arp, request, bnum)!=0) err = 1;
+    bnum = gen_eth_ip_udp_packet(request, dut_mac, bcast, dut_ip, host_ip(0)
+                                , 1, 2, 10, NULL, 1, 1, 0);
+    if (pkt_arp_put(arp, request, bnum)!=0) err = 1;
+    bnum = gen_eth_arp_packet(request, dut_mac, bcast, ARP_OP_REQUEST, dut_ip, host_ip(1), 1, 0);
+    for (idx=0; idx<10; idx++) pkt_arp_put(arp, request, bnum);
+    if ((arp->queue_num!=8)||(arp->drops!=2)) err = 1;
+    while (pkt_arp_get(arp, reply, 1, 0)>0);
+    bnum = gen_eth_arp_packet(request, dut_mac, bcast, ARP_OP_REQUEST, dut_ip, host_ip(1), 0, 0);
+    bnum = push_tags(request, bnum, PKT_VLAN_MAX+2); // more tags than a reply carries
+    if ((pkt_arp_put(arp, request, bnum)!=0)||(arp->queue_num!=0)) err = 1;
+    if (err) printf("ARP error: filter\n");
+    //-----------------------------------------------------------------------
+    // learned entries dropped in order of use, local hosts kept
+    for (idx=0; idx<64; idx++) {
+         host_mac(0x10000+idx, mac);
+         if (pkt_arp_add(arp, 0x0A000100+idx, mac, 0)) err = 1;
+         pkt_arp_lookup(arp, dut_ip); // keeps DUT
+    }
+    if ((arp->entries!=(ARP_HOSTS+16))||(pkt_arp_lookup(arp, dut_ip)==NULL)||
+        (pkt_arp_lookup(arp, 0x0A000100)!=NULL)||(pkt_arp_lookup(arp, 0x0A000100+63)==NULL)||
+        (pkt_arp_lookup(arp, host_ip(ARP_HOSTS-1))==NULL)) {
+        printf("ARP error: eviction\n");
+        err = 1;
+    }
+    for (idx=0; idx<ARP_HOSTS; idx++) pkt_arp_delete(arp, host_ip(idx));
+    if ((arp->entries!=16)||(pkt_arp_lookup(arp, host_ip(0))!=NULL)) {
+        printf("ARP error: delete\n");
+        err = 1;
+    }
+    pkt_arp_release(arp);
+    if (err) printf("ARP error\n");
+    else     printf("ARP OK\n");
+    return err;
+}
+
+//----------------------------------------------------------------------------
+// It measures request-reply pairs per second and lookups per second
+// over thousands of local hosts.
+int test_arp_bench(void)
+{
+    pkt_arp_t *arp;
+    uint8_t mac[6];
+    volatile int dummy=0;
+    int idx, num, bnum;
+    double sec;
+    clock_t start;
+
+    arp = pkt_arp_create(ARP_HOSTS, 8);
+    if (arp==NULL) return 1;
+    for (idx=0; idx<ARP_HOSTS; idx++) {
+         host_mac(idx, mac);
+         pkt_arp_add(arp, host_ip(idx), mac, 1);
+    }
+    num = 1<<20;
+    start = clock();
+    for (idx=0; idx<num; idx++) {
+         bnum = gen_eth_arp_packet(request, dut_mac, bcast, ARP_OP_REQUEST
+                                  , dut_ip, host_ip(idx&(ARP_HOSTS-1)), 1, 0);
+         pkt_arp_put(arp, request, bnum);
+         dummy ^= pkt_arp_get(arp, reply, 1, 0);
+    }
+    sec = (double)(clock()-start)/CLOCKS_PER_SEC;
+    if (sec<=0.0) sec = 1.0/CLOCKS_PER_SEC;
+    printf("ARP %d hosts %8.2f M pairs/sec", ARP_HOSTS, (double)num/sec/1.0e6);
+    num = 1<<24;
+    start = clock();
+    for (idx=0; idx<num; idx++) {
+         dummy ^= (pkt_arp_lookup(arp, host_ip((idx*2654435761U)&(ARP_HOSTS-1)))!=NULL);
+    }
+    sec = (double)(clock()-start)/CLOCKS_PER_SEC;
+    if (sec<=0.0) sec = 1.0/CLOCKS_PER_SEC;
+    printf(" %8.2f M lookups/sec\n", (double)num/sec/1.0e6);
+    pkt_arp_release(arp);
+    return dummy&0;
+}
+
+//----------------------------------------------------------------------------
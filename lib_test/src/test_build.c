@@ -0,0 +1,194 @@
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#if defined(__x86_64__)||defined(__i386__)
+#include <x86intrin.h>
+#define BUILD_CYCLES() __rdtsc()
+#elif defined(_M_X64)||defined(_M_IX86)
+#include <intrin.h>
+#define BUILD_CYCLES() __rdtsc()
+#else
+#define BUILD_CYCLES() ((uint64_t)clock()) // clock ticks instead of cycles
+#endif
+#include "eth_ip_udp_tcp_pkt.h"
+#include "test_util.h"
+
+//----------------------------------------------------------------------------
+extern uint8_t  mac_src[6];
+extern uint8_t  mac_dst[6];
+extern uint32_t ip_src;
+extern uint32_t ip_dst;
+extern uint16_t port_src;
+extern uint16_t port_dst;
+
+//----------------------------------------------------------------------------
+#define BUILD_MAX  9216
+
+//----------------------------------------------------------------------------
+// It builds the same packet as gen_eth_ip_udp_packet() or
+// gen_eth_ip_tcp_packet() in three passes; copy, checksum, then CRC.
+// return num of bytes of the packet
+static int build_three_pass( uint8_t *packet
+                           , uint8_t  protocol
+                           , uint16_t payload_len
+                           , uint8_t *payload
+                           , int add_preamble
+                           , int bitwise) // bit-serial CRC when 1
+{
+    pseudo_ip_hdr_t piphdr;
+    uint8_t *eth = (add_preamble) ? &packet[8] : packet;
+    uint8_t *l4 = &eth[ETH_HDR_LEN+IP_HDR_LEN];
+    int hdr_len, leng, idx;
+    uint32_t crc;
+
+    if (protocol==IP_PROTO_UDP) {
+        hdr_len = UDP_HDR_LEN;
+        leng = gen_eth_ip_udp_packet( packet, mac_src, mac_dst, ip_src, ip_dst
+                                    , port_src, port_dst, payload_len, payload
+                                    , 0, 0, add_preamble);
+        populate_pseudo_ip_hdr(&piphdr, ip_src, ip_dst, protocol, hdr_len+payload_len);
+        if (payload_len) ((udp_hdr_t*)l4)->udp_sum = htons(compute_udp_checksum(&piphdr, (udp_hdr_t*)l4));
+    } else {
+        hdr_len = TCP_HDR_LEN;
+        leng = gen_eth_ip_tcp_packet( packet, mac_src, mac_dst, ip_src, ip_dst
+                                    , port_src, port_dst, 1, 2, payload_len, payload
+                                    , 0, 0, add_preamble);
+        if (payload_len==0) return leng; // no checksum nor crc
+        populate_pseudo_ip_hdr(&piphdr, ip_src, ip_dst, protocol, hdr_len+payload_len);
+        ((tcp_hdr_t*)l4)->tcp_sum = htons(compute_tcp_checksum(&piphdr, (tcp_hdr_t*)l4));
+    }
+    for (idx=payload_len; idx<(46-IP_HDR_LEN-hdr_len); idx++) l4[hdr_len+idx] = 0;
+    leng = ETH_HDR_LEN+IP_HDR_LEN+hdr_len+idx;
+    crc = (bitwise) ? compute_eth_crc_bitwise(eth, leng) : compute_eth_crc(eth, leng);
+    memcpy(&eth[leng], &crc, 4);
+    return leng+4+((add_preamble) ? 8 : 0);
+}
+
+//----------------------------------------------------------------------------
+// It compares single pass builders with three pass composition
+// for random payloads in all combinations of checksum and CRC modes.
+// Return 0 on success, 1 on failure
+int test_build(void)
+{
+    static uint8_t payload[BUILD_MAX+8], packet[BUILD_MAX+128], ref[BUILD_MAX+128];
+    int crc_mode, sum_mode, idx, idy, leng, ref_leng, pleng, offset, err=0;
+    uint8_t protocol;
+    uint16_t sum, ref_sum;
+    uint32_t crc, ref_crc;
+
+    for (crc_mode=ETH_CRC_MODE_BITWISE; crc_mode<=ETH_CRC_MODE_PCLMUL; crc_mode++) {
+    for (sum_mode=CHECKSUM_MODE_SCALAR; sum_mode<=CHECKSUM_MODE_AVX2; sum_mode++) {
+         if (set_eth_crc_mode(crc_mode)!=crc_mode) continue;
+         if (set_checksum_mode(sum_mode)!=sum_mode) continue;
+         my_srand(crc_mode*3+sum_mode+1);
+         for (idx=0; idx<300; idx++) {
+              pleng  = (idx<140) ? idx : (int)(my_rand()%(BUILD_MAX-64));
+              offset = my_rand()&0x7;
+              for (idy=0; idy<pleng; idy++) payload[offset+idy] = my_rand()&0xFF;
+              protocol = (idx&1) ? IP_PROTO_TCP : IP_PROTO_UDP;
+              //--------------------------------------------------------------
+              // Ethernet/IP/UDP or TCP
+              memset(packet, 0xA5, sizeof(packet));
+              memset(ref, 0xA5, sizeof(ref));
+              if (protocol==IP_PROTO_UDP)
+                  leng = gen_eth_ip_udp_packet( packet, mac_src, mac_dst, ip_src, ip_dst
+                                              , port_src, port_dst, pleng, &payload[offset]
+                                              , 1, 1, idx&2);
+              else
+                  leng = gen_eth_ip_tcp_packet( packet, mac_src, mac_dst, ip_src, ip_dst
+                                              , port_src, port_dst, 1, 2, pleng, &payload[offset]
+                                              , 1, 1, idx&2);
+              ref_leng = build_three_pass(ref, protocol, pleng, &payload[offset], idx&2, 1);
+              if ((leng!=ref_leng)||memcmp(packet, ref, sizeof(packet))) {
+                  printf("Packet build error: %s leng=%d\n", (protocol==IP_PROTO_UDP) ? "UDP" : "TCP", pleng);
+                  err = 1;
+              }
+              //--------------------------------------------------------------
+              // in place, i.e., payload has been built in the packet
+              if (protocol==IP_PROTO_UDP)
+                  leng = gen_eth_ip_udp_packet( packet, mac_src, mac_dst, ip_src, ip_dst
+                                              , port_src, port_dst, pleng, 0
+                                              , 1, 1, idx&2);
+              else
+                  leng = gen_eth_ip_tcp_packet( packet, mac_src, mac_dst, ip_src, ip_dst
+                                              , port_src, port_dst, 1, 2, pleng, 0
+                                              , 1, 1, idx&2);
+              if ((leng!=ref_leng)||memcmp(packet, ref, sizeof(packet))) {
+                  printf("Packet build in place error: leng=%d\n", pleng);
+                  err = 1;
+              }
+              //--------------------------------------------------------------
+              // IP carrying UDP or TCP segment with checksum
+              if (pleng>=TCP_HDR_LEN) {
+                  pseudo_ip_hdr_t piphdr;
+                  populate_pseudo_ip_hdr(&piphdr, ip_src, ip_dst, protocol, pleng);
+                  gen_ip_packet(packet, ip_src, ip_dst, protocol, 1, pleng, &payload[offset], 1);
+                  if (((protocol==IP_PROTO_UDP)&&check_udp_checksum(&piphdr, (udp_hdr_t*)&packet[IP_HDR_LEN]))||
+                      ((protocol==IP_PROTO_TCP)&&check_tcp_checksum(&piphdr, (tcp_hdr_t*)&packet[IP_HDR_LEN]))) {
+                      printf("IP packet checksum error: leng=%d\n", pleng);
+                      err = 1;
+                  }
+              }
+              //--------------------------------------------------------------
+              // raw copy in two pieces
+              idy = (pleng) ? (int)(my_rand()%pleng)&~1 : 0;
+              crc = 0;
+              sum = copy_checksum_crc(packet, &payload[offset], idy, &crc);
+              ref_sum = copy_checksum_crc(&packet[idy], &payload[offset+idy], pleng-idy, &crc);
+              sum = ((uint32_t)sum+ref_sum+(((uint32_t)sum+ref_sum)>>16))&0xFFFF;
+              ref_sum = compute_checksum(&payload[offset], pleng);
+              ref_crc = compute_eth_crc_bitwise(&payload[offset], pleng);
+              if ((crc!=ref_crc)||(sum!=ref_sum)||memcmp(packet, &payload[offset], pleng)) {
+                  printf("Copy checksum crc error: leng=%d 0x%04X:0x%04X 0x%08X:0x%08X\n"
+                        , pleng, sum, ref_sum, crc, ref_crc);
+                  err = 1;
+              }
+         }
+    }
+    }
+    set_eth_crc_mode(ETH_CRC_MODE_PCLMUL);
+    set_checksum_mode(CHECKSUM_MODE_AVX2);
+    if (err) printf("Single pass packet build error\n");
+    else     printf("Single pass packet build OK\n");
+    return err;
+}
+
+//----------------------------------------------------------------------------
+// It measures cycles per payload byte of building Ethernet/IP/UDP packet
+// in three passes (before) and in single pass (after).
+int test_build_bench(void)
+{
+    static const int size[] = { 64, 256, 512, 1024, 1472, 4096, 8972 };
+    static uint8_t payload[BUILD_MAX], packet[BUILD_MAX+128];
+    volatile uint8_t dummy=0;
+    uint64_t start, cycles;
+    int pass, idx, idy, num;
+
+    for (idx=0; idx<BUILD_MAX; idx++) payload[idx] = my_rand()&0xFF;
+    printf("%-14s", "payload bytes");
+    for (idx=0; idx<(int)(sizeof(size)/sizeof(size[0])); idx++) printf("%8d", size[idx]);
+    printf("\n");
+    for (pass=3; pass>=1; pass-=2) {
+         printf("%-14s", (pass==3) ? "three pass" : "single pass");
+         for (idx=0; idx<(int)(sizeof(size)/sizeof(size[0])); idx++) {
+              num = (1<<25)/size[idx];
+              start = BUILD_CYCLES();
+              for (idy=0; idy<num; idy++) {
+                   if (pass==3) build_three_pass(packet, IP_PROTO_UDP, size[idx], payload, 0, 0);
+                   else         gen_eth_ip_udp_packet( packet, mac_src, mac_dst, ip_src, ip_dst
+                                                     , port_src, port_dst, size[idx], payload
+                                                     , 1, 1, 0);
+                   dummy ^= packet[ETH_HDR_LEN+IP_HDR_LEN+6];
+              }
+              cycles = BUILD_CYCLES()-start;
+              printf("%8.3f", (double)cycles/((double)num*size[idx]));
+         }
+         printf(" cycles/byte\n");
+    }
+    return (int)(dummy&0);
+}
+
+//----------------------------------------------------------------------------
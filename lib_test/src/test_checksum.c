@@ -1,11 +1,10 @@
 //----------------------------------------------------------------------------
 #include <stdio.h>
 #include <stdint.h>
+#include <string.h>
+#include <time.h>
 #include "eth_ip_udp_tcp_pkt.h"
-
-//----------------------------------------------------------------------------
-static uint32_t my_rand(void);
-static void my_srand(uint32_t seed);
+#include "test_util.h"
 
 //----------------------------------------------------------------------------
 uint8_t  mac_src[6] = { 0x02, 0x11, 0x22, 0x33, 0x44, 0x55};
@@ -92,17 +91,113 @@ int test_checksum(void)
 }
 
 //----------------------------------------------------------------------------
-#define MY_RAND_MAX 0xFFFFFFFF
-static uint32_t _Randseed = 1;
+static const char *mode_name[] = { "scalar", "sse2", "avx2" };
+
+//----------------------------------------------------------------------------
+// It compares compute_checksum() and UDP/TCP checksum of 'mode' with
+// scalar compute_checksum_d8/d16/d32() for random lengths 0..9216 and
+// random alignments of the buffer.
+// Return 0 on success, 1 on failure
+static int test_checksum_mode(int mode)
+{
+    int idx, idy, leng, offset, err=0;
+    uint8_t  buff[9216+32+8];
+    uint8_t  segment[12+9216]; // pseudo header and segment
+    uint8_t *pkt;
+    uint16_t sum, ref;
+    pseudo_ip_hdr_t piphdr;
+
+    if (set_checksum_mode(mode)!=mode) {
+        printf("Internet checksum %s not supported\n", mode_name[mode]);
+        return 0;
+    }
+    my_srand(1071);
+    for (idx=0; idx<2000; idx++) {
+         leng   = (idx<128) ? idx : (int)(my_rand()%(9216+1));
+         offset = my_rand()&0x1F;
+         pkt    = &buff[offset];
+         for (idy=0; idy<leng; idy++) pkt[idy] = my_rand()&0xFF;
+         if (idx&1) for (idy=0; idy<leng; idy++) pkt[idy] |= 0xF0; // many carries
+         sum = compute_checksum(pkt, leng);
+         ref = compute_checksum_d16(pkt, leng);
+         if ((sum!=ref)||(sum!=compute_checksum_d8(pkt, leng))
+                       ||(sum!=compute_checksum_d32(pkt, leng))) {
+             printf("Internet checksum error: leng=%d 0x%04X:0x%04X\n", leng, sum, ref);
+             err = 1;
+         }
+         if (leng<TCP_HDR_LEN) continue;
+         //-------------------------------------------------------------------
+         populate_pseudo_ip_hdr(&piphdr, ip_src, ip_dst, IP_PROTO_TCP, leng);
+         memcpy(segment, &piphdr, 12);
+         memcpy(segment+12, pkt, leng);
+         segment[12+16] = segment[12+17] = 0; // TCP checksum field
+         ref = ~compute_checksum_d16(segment, 12+leng);
+         if (compute_tcp_checksum(&piphdr, (tcp_hdr_t*)pkt)!=ref) {
+             printf("TCP checksum error: leng=%d\n", leng);
+             err = 1;
+         }
+         populate_pseudo_ip_hdr(&piphdr, ip_src, ip_dst, IP_PROTO_UDP, leng);
+         pkt[4] = (leng>>8)&0xFF; // UDP length
+         pkt[5] =  leng    &0xFF;
+         memcpy(segment, &piphdr, 12);
+         memcpy(segment+12, pkt, leng);
+         segment[12+6] = segment[12+7] = 0; // UDP checksum field
+         ref = ~compute_checksum_d16(segment, 12+leng);
+         if (compute_udp_checksum(&piphdr, (udp_hdr_t*)pkt)!=ref) {
+             printf("UDP checksum error: leng=%d\n", leng);
+             err = 1;
+         }
+    }
+    if (err) printf("Internet checksum %s error\n", mode_name[mode]);
+    else     printf("Internet checksum %s OK\n", mode_name[mode]);
+
+    return err;
+}
 
-static uint32_t my_rand(void)
+//----------------------------------------------------------------------------
+// Return 0 on success, 1 on failure
+int test_checksum_kernel(void)
 {
-  _Randseed = _Randseed * 1103515245 + 12345;
-  return((uint32_t)_Randseed);
+    int mode, err=0;
+    for (mode=CHECKSUM_MODE_SCALAR; mode<=CHECKSUM_MODE_AVX2; mode++) {
+         err |= test_checksum_mode(mode);
+    }
+    set_checksum_mode(CHECKSUM_MODE_AVX2);
+    return err;
 }
 
-static void my_srand(uint32_t seed)
+//----------------------------------------------------------------------------
+// It reports throughput of compute_checksum() in GB/s for each mode
+// across frame sizes.
+int test_checksum_bench(void)
 {
-  _Randseed = seed;
+    static const int size[] = { 64, 128, 256, 512, 1024, 1518, 4096, 9216 };
+    static uint8_t pkt[9216];
+    volatile uint16_t sum=0;
+    int mode, idx, idy, num;
+    double sec;
+    clock_t start;
+
+    for (idx=0; idx<9216; idx++) pkt[idx] = my_rand()&0xFF;
+    printf("%-14s", "frame bytes");
+    for (idx=0; idx<(int)(sizeof(size)/sizeof(size[0])); idx++) printf("%8d", size[idx]);
+    printf("\n");
+    for (mode=CHECKSUM_MODE_SCALAR-1; mode<=CHECKSUM_MODE_AVX2; mode++) {
+         if ((mode>=0)&&(set_checksum_mode(mode)!=mode)) continue;
+         printf("%-14s", (mode<0) ? "checksum_d16" : mode_name[mode]);
+         for (idx=0; idx<(int)(sizeof(size)/sizeof(size[0])); idx++) {
+              num = (1<<26)/size[idx];
+              start = clock();
+              if (mode<0) for (idy=0; idy<num; idy++) sum ^= compute_checksum_d16(pkt, size[idx]);
+              else        for (idy=0; idy<num; idy++) sum ^= compute_checksum(pkt, size[idx]);
+              sec = (double)(clock()-start)/CLOCKS_PER_SEC;
+              if (sec<=0.0) sec = 1.0/CLOCKS_PER_SEC;
+              printf("%8.2f", ((double)num*size[idx])/sec/1.0e9);
+         }
+         printf(" GB/s\n");
+    }
+    set_checksum_mode(CHECKSUM_MODE_AVX2);
+    return (int)(sum&0);
 }
+
 //----------------------------------------------------------------------------
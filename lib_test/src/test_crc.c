@@ -0,0 +1,165 @@
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+#include "eth_ip_udp_tcp_pkt.h"
+#include "test_util.h"
+
+//----------------------------------------------------------------------------
+static const char *mode_name[] = { "bitwise", "slicing-by-8", "pclmul" };
+
+//----------------------------------------------------------------------------
+// It compares compute_eth_crc()/check_eth_crc() of 'mode' with
+// their bit-serial references for random lengths 0..9216 and
+// random alignments of the message.
+// Return 0 on success, 1 on failure
+static int test_crc_mode(int mode)
+{
+    int idx, idy, leng, offset, err=0;
+    uint8_t  buff[9216+8+4];
+    uint8_t *message;
+    uint32_t crc, ref;
+
+    if (set_eth_crc_mode(mode)!=mode) {
+        printf("Ethernet CRC %s not supported\n", mode_name[mode]);
+        return 0;
+    }
+    my_srand(9216);
+    for (idx=0; idx<2000; idx++) {
+         leng   = (idx<64) ? idx : (int)(my_rand()%(9216+1));
+         offset = my_rand()&0x7;
+         message = &buff[offset];
+         for (idy=0; idy<leng; idy++) {
+              message[idy] = my_rand()&0xFF;
+         }
+         crc = compute_eth_crc(message, leng);
+         ref = compute_eth_crc_bitwise(message, leng);
+         if (crc!=ref) {
+             printf("Ethernet CRC error: leng=%d 0x%08X:0x%08X\n", leng, crc, ref);
+             err = 1;
+         }
+         // append FCS, LSByte first
+         message[leng+0] = (crc>> 0)&0xFF;
+         message[leng+1] = (crc>> 8)&0xFF;
+         message[leng+2] = (crc>>16)&0xFF;
+         message[leng+3] = (crc>>24)&0xFF;
+         if (check_eth_crc(message, leng+4)||
+             (check_eth_crc(message, leng+4)!=check_eth_crc_bitwise(message, leng+4))) {
+             printf("Ethernet CRC check error: leng=%d\n", leng);
+             err = 1;
+         }
+         if (leng>0) {
+             message[my_rand()%leng] ^= 1<<(my_rand()&0x7); // corrupt a bit
+             if (!check_eth_crc(message, leng+4)||
+                 (check_eth_crc(message, leng+4)!=check_eth_crc_bitwise(message, leng+4))) {
+                 printf("Ethernet CRC corruption not detected: leng=%d\n", leng);
+                 err = 1;
+             }
+         }
+    }
+    for (leng=0; leng<4; leng++) { // shorter than FCS
+         if (check_eth_crc(buff, leng)!=check_eth_crc_bitwise(buff, leng)) {
+             printf("Ethernet CRC check error: leng=%d\n", leng);
+             err = 1;
+         }
+    }
+    if (err) printf("Ethernet CRC %s error\n", mode_name[mode]);
+    else     printf("Ethernet CRC %s OK\n", mode_name[mode]);
+
+    return err;
+}
+
+//----------------------------------------------------------------------------
+// It checks combine_eth_crc() and patch_eth_crc() against
+// compute_eth_crc() over the whole message.
+// Return 0 on success, 1 on failure
+static int test_crc_incremental(void)
+{
+    int idx, idy, leng, lengA, offset, num, err=0;
+    uint8_t  message[9216+4];
+    uint8_t  data[256];
+    uint32_t crc, crcA, crcB;
+
+    my_srand(1518);
+    for (idx=0; idx<500; idx++) {
+         leng  = (idx<32) ? idx : (int)(my_rand()%(9216+1));
+         lengA = (leng>0) ? (int)(my_rand()%(leng+1)) : 0;
+         for (idy=0; idy<leng; idy++) message[idy] = my_rand()&0xFF;
+         crc  = compute_eth_crc(message, leng);
+         crcA = compute_eth_crc(message, lengA);
+         crcB = compute_eth_crc(&message[lengA], leng-lengA);
+         if (combine_eth_crc(crcA, crcB, leng-lengA)!=crc) {
+             printf("Ethernet CRC combine error: leng=%d:%d\n", lengA, leng-lengA);
+             err |= 1;
+         }
+         message[leng+0] = (crc>> 0)&0xFF;
+         message[leng+1] = (crc>> 8)&0xFF;
+         message[leng+2] = (crc>>16)&0xFF;
+         message[leng+3] = (crc>>24)&0xFF;
+         num    = (leng>0) ? (int)(my_rand()%(((leng<256) ? leng : 256)+1)) : 0;
+         offset = (int)(my_rand()%(leng-num+1));
+         for (idy=0; idy<num; idy++) data[idy] = my_rand()&0xFF;
+         if (patch_eth_crc(message, leng+4, offset, data, num)||
+             check_eth_crc(message, leng+4)) {
+             printf("Ethernet FCS patch error: leng=%d offset=%d num=%d\n", leng, offset, num);
+             err |= 2;
+         }
+    }
+    if (!patch_eth_crc(message, 3, 0, data, 0)) err |= 2; // shorter than FCS
+    if (!patch_eth_crc(message, 64, 60, data, 1)) err |= 2; // on FCS
+    if (err&1) printf("Ethernet CRC combine error\n");
+    else       printf("Ethernet CRC combine OK\n");
+    if (err&2) printf("Ethernet FCS patch error\n");
+    else       printf("Ethernet FCS patch OK\n");
+
+    return (err) ? 1 : 0;
+}
+
+//----------------------------------------------------------------------------
+// Return 0 on success, 1 on failure
+int test_crc(void)
+{
+    int mode, err=0;
+    for (mode=ETH_CRC_MODE_BITWISE; mode<=ETH_CRC_MODE_PCLMUL; mode++) {
+         err |= test_crc_mode(mode);
+    }
+    set_eth_crc_mode(ETH_CRC_MODE_PCLMUL);
+    err |= test_crc_incremental();
+    return err;
+}
+
+//----------------------------------------------------------------------------
+// It reports throughput of compute_eth_crc() in GB/s for each mode
+// across frame sizes.
+int test_crc_bench(void)
+{
+    static const int size[] = { 64, 128, 256, 512, 1024, 1518, 4096, 9216 };
+    static uint8_t message[9216];
+    volatile uint32_t crc=0;
+    int mode, idx, idy, num;
+    double sec;
+    clock_t start;
+
+    for (idx=0; idx<9216; idx++) message[idx] = my_rand()&0xFF;
+    printf("%-14s", "frame bytes");
+    for (idx=0; idx<(int)(sizeof(size)/sizeof(size[0])); idx++) printf("%8d", size[idx]);
+    printf("\n");
+    for (mode=ETH_CRC_MODE_BITWISE; mode<=ETH_CRC_MODE_PCLMUL; mode++) {
+         if (set_eth_crc_mode(mode)!=mode) continue;
+         printf("%-14s", mode_name[mode]);
+         for (idx=0; idx<(int)(sizeof(size)/sizeof(size[0])); idx++) {
+              num = (mode==ETH_CRC_MODE_BITWISE) ? (1<<20)/size[idx] : (1<<26)/size[idx];
+              start = clock();
+              for (idy=0; idy<num; idy++) crc ^= compute_eth_crc(message, size[idx]);
+              sec = (double)(clock()-start)/CLOCKS_PER_SEC;
+              if (sec<=0.0) sec = 1.0/CLOCKS_PER_SEC;
+              printf("%8.2f", ((double)num*size[idx])/sec/1.0e9);
+         }
+         printf(" GB/s\n");
+    }
+    set_eth_crc_mode(ETH_CRC_MODE_PCLMUL);
+    return (int)(crc&0);
+}
+
+//----------------------------------------------------------------------------
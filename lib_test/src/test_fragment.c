@@ -0,0 +1,184 @@
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include "eth_ip_udp_tcp_pkt.h"
+#include "test_util.h"
+#include "pkt_segment.h"
+
+//----------------------------------------------------------------------------
+extern uint8_t  mac_src[6];
+extern uint8_t  mac_dst[6];
+extern uint32_t ip_src;
+extern uint32_t ip_dst;
+
+//----------------------------------------------------------------------------
+#define FRAG_PAYLOAD (IP_PKT_MAX-IP_HDR_LEN)
+#define FRAG_MAX     (FRAG_PAYLOAD/8+1)
+
+static uint8_t payload[FRAG_PAYLOAD], datagram[FRAG_PAYLOAD];
+static uint8_t frames[FRAG_PAYLOAD+FRAG_MAX*80];
+static pkt_ip_frag_t frag[FRAG_MAX];
+static int     leng[FRAG_MAX];
+
+//----------------------------------------------------------------------------
+// It checks IP header of fragment 'idx' of 'num' and puts its payload
+// back to 'datagram'; returns num of payload bytes, -1 on failure.
+static int frag_check(const uint8_t *ip, int idx, int num, int mtu, uint16_t ip_id)
+{
+    int len = (ip[2]<<8)|ip[3];
+    int off = ((ip[6]<<8)|ip[7])&IP_FRAG_OFFMASK;
+    int mf  = ((ip[6]<<8)|ip[7])&IP_FRAG_MF;
+    if ((len>mtu)||(len<IP_HDR_LEN)||
+        (((ip[4]<<8)|ip[5])!=ip_id)||
+        (ip[6]&(IP_FRAG_DF>>8))||
+        ((mf!=0)!=(idx!=(num-1)))||
+        (mf&&((len-IP_HDR_LEN)%8))||
+        check_ip_checksum((ip_hdr_t*)ip)) return -1;
+    memcpy(&datagram[off*8], &ip[IP_HDR_LEN], len-IP_HDR_LEN);
+    return len-IP_HDR_LEN;
+}
+
+//----------------------------------------------------------------------------
+// It cuts IP payload into fragments of descriptors and of frames,
+// and checks fragments make the datagram again.
+// Return 0 on success, 1 on failure
+int test_fragment(void)
+{
+    static const int mtu[] = { 28, 68, 576, 1500, 9000 };
+    uint8_t ip[PKT_FRAGMENT_FRAME_MAX(9000)];
+    int idx, idy, num, pleng, crc, pre, off, sum, len, m, err=0;
+    uint16_t ip_id;
+
+    my_srand(17);
+    for (idx=0; idx<FRAG_PAYLOAD; idx++) payload[idx] = my_rand()&0xFF;
+    for (idx=0; idx<200; idx++) {
+         m = mtu[idx%(sizeof(mtu)/sizeof(mtu[0]))];
+         pleng = (idx<40) ? idx : (int)(my_rand()%(((m*40)<FRAG_PAYLOAD) ? (m*40+1) : FRAG_PAYLOAD+1));
+         crc = (idx&1)!=0;
+         pre = ((idx&2)!=0) ? 8 : 0;
+         ip_id = pkt_ip_flow_id(ip_src, ip_dst, IP_PROTO_UDP);
+         //-------------------------------------------------------------------
+         num = gen_ip_fragments( frag, FRAG_MAX, ip_src, ip_dst, IP_PROTO_UDP, 64
+                               , ip_id, m, pleng, payload);
+         if (num!=pkt_ip_fragment_num(pleng, m)) {
+             printf("IP fragment error: num=%d mtu=%d leng=%d\n", num, m, pleng);
+             err = 1;
+             continue;
+         }
+         memset(datagram, 0, pleng);
+         for (idy=0, sum=0; idy<num; idy++) {
+              memcpy(ip, frag[idy].iov[0].base, frag[idy].iov[0].len);
+              memcpy(&ip[IP_HDR_LEN], frag[idy].iov[1].base, frag[idy].iov[1].len);
+              if (frag[idy].iov[1].base!=&payload[idy*(((m-IP_HDR_LEN)/8)*8)]) len = -1; // not shared
+              else len = frag_check(ip, idy, num, m, ip_id);
+              if (len<0) {
+                  printf("IP fragment error: fragment %d of %d mtu=%d leng=%d\n", idy, num, m, pleng);
+                  err = 1;
+                  break;
+              }
+              sum += len;
+         }
+         if ((sum!=pleng)||memcmp(datagram, payload, pleng)) {
+             printf("IP fragment error: datagram mtu=%d leng=%d\n", m, pleng);
+             err = 1;
+         }
+         //-------------------------------------------------------------------
+         num = gen_eth_ip_fragments( frames, (idx&4) ? 0 : PKT_FRAGMENT_FRAME_MAX(m), leng, FRAG_MAX
+                                   , mac_src, mac_dst, ip_src, ip_dst, IP_PROTO_UDP, 64
+                                   , ip_id, m, pleng, payload, crc, pre!=0);
+         memset(datagram, 0, pleng);
+         for (idy=0, off=0, sum=0; idy<num; idy++) {
+              const uint8_t *eth = &frames[off+pre];
+              len = frag_check(&eth[ETH_HDR_LEN], idy, num, m, ip_id);
+              if ((len<0)||(leng[idy]<(pre+ETH_HDR_LEN+IP_HDR_LEN+len))||
+                  (crc&&check_eth_crc((uint8_t*)eth, leng[idy]-pre))) {
+                  printf("IP fragment error: frame %d of %d mtu=%d leng=%d\n", idy, num, m, pleng);
+                  err = 1;
+                  break;
+              }
+              sum += len;
+              off += (idx&4) ? leng[idy] : PKT_FRAGMENT_FRAME_MAX(m);
+         }
+         if ((sum!=pleng)||memcmp(datagram, payload, pleng)) {
+             printf("IP fragment error: frames mtu=%d leng=%d\n", m, pleng);
+             err = 1;
+         }
+    }
+    //-----------------------------------------------------------------------
+    // IP ID advances for each flow
+    pkt_ip_flow_reset();
+    if ((pkt_ip_flow_id(ip_src, ip_dst, IP_PROTO_UDP)!=0)||
+        (pkt_ip_flow_id(ip_src, ip_dst, IP_PROTO_UDP)!=1)||
+        (pkt_ip_flow_id(ip_src, ip_dst, IP_PROTO_TCP)!=0)||
+        (pkt_ip_flow_id(ip_dst, ip_src, IP_PROTO_UDP)!=0)||
+        (pkt_ip_flow_id(ip_src, ip_dst, IP_PROTO_UDP)!=2)) {
+        printf("IP fragment error: flow ID\n");
+        err = 1;
+    }
+    //-----------------------------------------------------------------------
+    if ((pkt_ip_fragment_num(100, 27)!=-1)||
+        (pkt_ip_fragment_num(FRAG_PAYLOAD+1, 1500)!=-1)||
+        (pkt_ip_fragment_num(1480, 1500)!=1)||
+        (pkt_ip_fragment_num(1481, 1500)!=2)||
+        (gen_ip_fragments( frag, 1, ip_src, ip_dst, IP_PROTO_UDP, 64, 0
+                         , 1500, 1481, payload)!=-1)||
+        (gen_eth_ip_fragments( frames, 100, leng, FRAG_MAX, mac_src, mac_dst
+                             , ip_src, ip_dst, IP_PROTO_UDP, 64, 0
+                             , 1500, 1481, payload, 1, 0)!=-1)) {
+        printf("IP fragment error: limits\n");
+        err = 1;
+    }
+    if (err) printf("IP fragment error\n");
+    else     printf("IP fragment OK\n");
+    return err;
+}
+
+//----------------------------------------------------------------------------
+// It measures fragments per second of cutting 64 KiB datagram
+// at MTU 576 and 1500 into descriptors and into frames.
+int test_fragment_bench(void)
+{
+    static const int mtu[] = { 576, 1500 };
+    static const int size[] = { 8192+8, FRAG_PAYLOAD };
+    volatile uint8_t dummy=0;
+    int pass, idx, idy, idz, num, cnt;
+    double sec;
+    clock_t start;
+
+    for (idx=0; idx<FRAG_PAYLOAD; idx++) payload[idx] = my_rand()&0xFF;
+    printf("%-14s", "mtu/bytes");
+    for (idx=0; idx<(int)(sizeof(mtu)/sizeof(mtu[0])); idx++)
+    for (idz=0; idz<(int)(sizeof(size)/sizeof(size[0])); idz++) printf("%5d/%-5d", mtu[idx], size[idz]);
+    printf("\n");
+    for (pass=0; pass<2; pass++) {
+         printf("%-14s", (pass==0) ? "descriptors" : "frames");
+         for (idx=0; idx<(int)(sizeof(mtu)/sizeof(mtu[0])); idx++)
+         for (idz=0; idz<(int)(sizeof(size)/sizeof(size[0])); idz++) {
+              num = (1<<24)/size[idz];
+              cnt = 0;
+              start = clock();
+              for (idy=0; idy<num; idy++) {
+                   if (pass==0) {
+                       cnt += gen_ip_fragments( frag, FRAG_MAX, ip_src, ip_dst, IP_PROTO_UDP, 64
+                                              , (uint16_t)idy, mtu[idx], size[idz], payload);
+                       dummy ^= frag[0].hdr[10];
+                   } else {
+                       cnt += gen_eth_ip_fragments( frames, 0, leng, FRAG_MAX, mac_src, mac_dst
+                                                  , ip_src, ip_dst, IP_PROTO_UDP, 64
+                                                  , (uint16_t)idy, mtu[idx], size[idz], payload, 1, 0);
+                       dummy ^= frames[ETH_HDR_LEN+10];
+                   }
+              }
+              sec = (double)(clock()-start)/CLOCKS_PER_SEC;
+              if (sec<=0.0) sec = 1.0/CLOCKS_PER_SEC;
+              printf("%11.2f", (double)cnt/sec/1.0e6);
+         }
+         printf(" M fragments/sec\n");
+    }
+    return (int)(dummy&0);
+}
+
+//----------------------------------------------------------------------------
@@ -0,0 +1,173 @@
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include "eth_ip_udp_tcp_pkt.h"
+#include "test_util.h"
+
+//----------------------------------------------------------------------------
+extern uint8_t  mac_src[6];
+extern uint8_t  mac_dst[6];
+extern uint32_t ip_src;
+extern uint32_t ip_dst;
+
+//----------------------------------------------------------------------------
+#define ICMP_DATA  1500
+#define ICMP_FRAME (8+ETH_HDR_LEN+PKT_VLAN_MAX*ETH_VLAN_TAG_LEN+IPV6_HDR_LEN+ICMP_ECHO_HDR_LEN+ICMP_DATA+4)
+
+static uint8_t data[ICMP_DATA];
+static uint8_t request[ICMP_FRAME];
+static uint8_t reply[ICMP_FRAME];
+static uint8_t expect[ICMP_FRAME];
+static uint8_t sum_buf[PSEUDO_IPV6_HDR_LEN+ICMP_ECHO_HDR_LEN+ICMP_DATA];
+
+static uint8_t ip6_src[16] = { 0x20,0x01,0x0D,0xB8,0,0,0,0,0,0,0,0,0,0,0,0x01 };
+static uint8_t ip6_dst[16] = { 0xFE,0x80,0,0,0,0,0,0,0x02,0x11,0x22,0xFF,0xFE,0x33,0x44,0x55 };
+
+//----------------------------------------------------------------------------
+// It checks IP and ICMP checksums of echo frame 'pkt' with 'hdr'-byte
+// Ethernet header and 'len'-byte echo data.
+static int icmp_check(const uint8_t *pkt, int bnum, int hdr, int len, int v6)
+{
+    const uint8_t *ip = &pkt[hdr];
+    pseudo_ipv6_hdr_t pseudo;
+    if (check_eth_crc((uint8_t*)pkt, bnum)) return 1;
+    if (!v6) {
+        if (check_checksum((uint8_t*)ip, IP_HDR_LEN)) return 1;
+        if (((ip[2]<<8)|ip[3])!=(IP_HDR_LEN+ICMP_ECHO_HDR_LEN+len)) return 1;
+        return check_checksum((uint8_t*)&ip[IP_HDR_LEN], ICMP_ECHO_HDR_LEN+len);
+    }
+    if ((ip[6]!=IPV6_NEXT_ICMPV6)||(((ip[4]<<8)|ip[5])!=(ICMP_ECHO_HDR_LEN+len))) return 1;
+    populate_pseudo_ipv6_hdr(&pseudo, (uint8_t*)&ip[8], (uint8_t*)&ip[24]
+                            , IPV6_NEXT_ICMPV6, ICMP_ECHO_HDR_LEN+len);
+    memcpy(sum_buf, &pseudo, PSEUDO_IPV6_HDR_LEN);
+    memcpy(&sum_buf[PSEUDO_IPV6_HDR_LEN], &ip[IPV6_HDR_LEN], ICMP_ECHO_HDR_LEN+len);
+    return check_checksum(sum_buf, PSEUDO_IPV6_HDR_LEN+ICMP_ECHO_HDR_LEN+len);
+}
+
+//----------------------------------------------------------------------------
+// It builds ICMP and ICMPv6 echo requests, turns them into replies
+// and checks replies against those built directly.
+// Return 0 on success, 1 on failure
+int test_icmp(void)
+{
+    int idx, num, pre, len, bnum, rnum, xnum, hdr, err=0;
+
+    my_srand(23);
+    for (idx=0; idx<ICMP_DATA; idx++) data[idx] = my_rand()&0xFF;
+    for (num=0; num<=PKT_VLAN_MAX; num++) {
+    hdr = ETH_HDR_LEN+num*ETH_VLAN_TAG_LEN;
+    for (pre=0; pre<=1; pre++) {
+    for (len=0; len<=ICMP_DATA-IPV6_HDR_LEN; len+=(len<64) ? 1 : 89) {
+         //-------------------------------------------------------------------
+         bnum = gen_eth_ip_icmp_echo_packet_vlan(request, mac_src, mac_dst, &vlan_tags[PKT_VLAN_MAX-num], num
+                                                , ip_src, ip_dst, 64, ICMP_TYPE_ECHO_REQUEST
+                                                , 0x1234, len, len, data, 1, 0);
+         if (icmp_check(request, bnum, hdr, len, 0)) {
+             printf("ICMP error: request %d tags %d bytes\n", num, len);
+             err = 1;
+         }
+         rnum = gen_eth_icmp_echo_reply(reply, request, bnum, 1, pre);
+         xnum = gen_eth_ip_icmp_echo_packet_vlan(expect, mac_dst, mac_src, &vlan_tags[PKT_VLAN_MAX-num], num
+                                                , ip_dst, ip_src, 64, ICMP_TYPE_ECHO_REPLY
+                                                , 0x1234, len, len, data, 1, pre);
+         if ((rnum!=xnum)||memcmp(reply, expect, rnum)) {
+             printf("ICMP error: reply %d tags %d bytes\n", num, len);
+             err = 1;
+         }
+         //-------------------------------------------------------------------
+         bnum = gen_eth_ipv6_icmp_echo_packet_vlan(request, mac_src, mac_dst, &vlan_tags[PKT_VLAN_MAX-num], num
+                                                  , ip6_src, ip6_dst, 255, ICMPV6_TYPE_ECHO_REQUEST
+                                                  , 0x4321, len, len, data, 1, 0);
+         if (icmp_check(request, bnum, hdr, len, 1)) {
+             printf("ICMPv6 error: request %d tags %d bytes\n", num, len);
+             err = 1;
+         }
+         rnum = gen_eth_icmp_echo_reply(reply, request, bnum, 1, pre);
+         xnum = gen_eth_ipv6_icmp_echo_packet_vlan(expect, mac_dst, mac_src, &vlan_tags[PKT_VLAN_MAX-num], num
+                                                  , ip6_dst, ip6_src, 255, ICMPV6_TYPE_ECHO_REPLY
+                                                  , 0x4321, len, len, data, 1, pre);
+         if ((rnum!=xnum)||memcmp(reply, expect, rnum)) {
+             printf("ICMPv6 error: reply %d tags %d bytes\n", num, len);
+             err = 1;
+         }
+    }}}
+    //-----------------------------------------------------------------------
+    // in place, where payload has been built in 'request' already
+    memcpy(&request[ETH_HDR_LEN+IP_HDR_LEN+ICMP_ECHO_HDR_LEN], data, 100);
+    bnum = gen_eth_ip_icmp_echo_packet(request, mac_src, mac_dst, ip_src, ip_dst, 64
+                                      , ICMP_TYPE_ECHO_REQUEST, 1, 2, 100, NULL, 1, 0);
+    rnum = gen_eth_icmp_echo_reply(request, request, bnum, 1, 0);
+    xnum = gen_eth_ip_icmp_echo_packet(expect, mac_dst, mac_src, ip_dst, ip_src, 64
+                                      , ICMP_TYPE_ECHO_REPLY, 1, 2, 100, data, 1, 0);
+    if ((rnum!=xnum)||memcmp(request, expect, rnum)) {
+        printf("ICMP error: in place\n");
+        err = 1;
+    }
+    //-----------------------------------------------------------------------
+    // no reply for other than echo request
+    bnum = gen_eth_ip_icmp_echo_packet(request, mac_src, mac_dst, ip_src, ip_dst, 64
+                                      , ICMP_TYPE_ECHO_REPLY, 1, 2, 10, data, 1, 0);
+    if (gen_eth_icmp_echo_reply(reply, request, bnum, 1, 0)!=0) err = 1;
+    bnum = gen_eth_ipv6_icmp_echo_packet(request, mac_src, mac_dst, ip6_src, ip6_dst, 64
+                                        , ICMPV6_TYPE_ECHO_REPLY, 1, 2, 10, data, 1, 0);
+    if (gen_eth_icmp_echo_reply(reply, request, bnum, 1, 0)!=0) err = 1;
+    bnum = gen_eth_ip_udp_packet(request, mac_src, mac_dst, ip_src, ip_dst, 1, 2, 10, data, 1, 1, 0);
+    if (gen_eth_icmp_echo_reply(reply, request, bnum, 1, 0)!=0) err = 1;
+    bnum = gen_eth_ip_icmp_echo_packet(request, mac_src, mac_dst, ip_src, ip_dst, 64
+                                      , ICMP_TYPE_ECHO_REQUEST, 1, 2, 100, data, 1, 0);
+    if (gen_eth_icmp_echo_reply(reply, request, ETH_HDR_LEN+IP_HDR_LEN+50, 1, 0)!=0) err = 1; // truncated
+    xnum = gen_eth_ip_icmp_echo_packet(reply, mac_src, mac_dst, ip_src, ip_dst, 64
+                                      , ICMP_TYPE_ECHO_REQUEST, 1, 2, 100, data, 0, 0);
+    xnum = push_tags(reply, xnum, PKT_VLAN_MAX+2); // more tags than a reply carries
+    if (gen_eth_icmp_echo_reply(expect, reply, xnum, 1, 0)!=0) err = 1;
+    request[ETH_HDR_LEN+6] |= IP_FRAG_MF>>8; // fragment
+    if (gen_eth_icmp_echo_reply(reply, request, bnum, 1, 0)!=0) err = 1;
+    if (gen_eth_ip_icmp_echo_packet(request, mac_src, mac_dst, ip_src, ip_dst, 64
+                                   , ICMP_TYPE_ECHO_REQUEST, 1, 2, ICMP_PAYLOAD_MAX+1, data, 1, 0)!=-1) err = 1;
+    if (err) printf("ICMP error\n");
+    else     printf("ICMP OK\n");
+    return err;
+}
+
+//----------------------------------------------------------------------------
+// It measures echo request-reply pairs per second, where the request
+// is built and the reply is made from it.
+int test_icmp_bench(void)
+{
+    static const int size[] = { 56, 1472 };
+    volatile int dummy=0;
+    int idx, idy, idz, v6, bnum;
+    double sec;
+    clock_t start;
+
+    printf("%-14s%8s%8s\n", "echo", "IPv4", "IPv6");
+    for (idx=0; idx<(int)(sizeof(size)/sizeof(size[0])); idx++) {
+         char name[16];
+         sprintf(name, "ping %d", size[idx]);
+         printf("%-14s", name);
+         for (v6=0; v6<=1; v6++) {
+              idz = (1<<26)/(size[idx]+64);
+              start = clock();
+              for (idy=0; idy<idz; idy++) {
+                   if (v6) bnum = gen_eth_ipv6_icmp_echo_packet(request, mac_src, mac_dst, ip6_src, ip6_dst
+                                                               , 64, ICMPV6_TYPE_ECHO_REQUEST, 1, idy
+                                                               , size[idx], data, 1, 0);
+                   else    bnum = gen_eth_ip_icmp_echo_packet(request, mac_src, mac_dst, ip_src, ip_dst
+                                                             , 64, ICMP_TYPE_ECHO_REQUEST, 1, idy
+                                                             , size[idx], data, 1, 0);
+                   dummy ^= gen_eth_icmp_echo_reply(reply, request, bnum, 1, 0);
+              }
+              sec = (double)(clock()-start)/CLOCKS_PER_SEC;
+              if (sec<=0.0) sec = 1.0/CLOCKS_PER_SEC;
+              printf("%8.2f", (double)idz/sec/1.0e6);
+         }
+         printf(" M pairs/sec\n");
+    }
+    return dummy&0;
+}
+
+//----------------------------------------------------------------------------
@@ -0,0 +1,179 @@
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#if defined(__x86_64__)||defined(__i386__)
+#include <x86intrin.h>
+#define IOV_CYCLES() __rdtsc()
+#elif defined(_M_X64)||defined(_M_IX86)
+#include <intrin.h>
+#define IOV_CYCLES() __rdtsc()
+#else
+#define IOV_CYCLES() ((uint64_t)clock()) // clock ticks instead of cycles
+#endif
+#include "eth_ip_udp_tcp_pkt.h"
+#include "test_util.h"
+
+//----------------------------------------------------------------------------
+extern uint8_t  mac_src[6];
+extern uint8_t  mac_dst[6];
+extern uint32_t ip_src;
+extern uint32_t ip_dst;
+extern uint16_t port_src;
+extern uint16_t port_dst;
+
+//----------------------------------------------------------------------------
+#define IOV_MAX   9216
+#define IOV_FRAG  8
+
+//----------------------------------------------------------------------------
+// It cuts 'num' bytes of 'payload' into random fragments of any length
+// including zero.
+// return num of fragments
+static int split_iov(pkt_iovec_t *iov, const uint8_t *payload, int num)
+{
+    int cnt=0, len;
+    while ((num>0)&&(cnt<(IOV_FRAG-1))) {
+        len = (my_rand()&1) ? (int)(my_rand()%8) : (int)(my_rand()%(num+1));
+        if (len>num) len = num;
+        iov[cnt].base = payload;
+        iov[cnt].len  = len;
+        payload += len;
+        num     -= len;
+        cnt++;
+    }
+    iov[cnt].base = payload;
+    iov[cnt].len  = num;
+    return cnt+1;
+}
+
+//----------------------------------------------------------------------------
+static int iov_compare(const char *name, int lengA, const uint8_t *pktA
+                                       , int lengB, const uint8_t *pktB, int pleng)
+{
+    if ((lengA!=lengB)||memcmp(pktA, pktB, lengA)) {
+        printf("Scatter-gather error: %s leng=%d\n", name, pleng);
+        return 1;
+    }
+    return 0;
+}
+
+//----------------------------------------------------------------------------
+// It compares builders on fragments with the ones on a single payload.
+// Return 0 on success, 1 on failure
+int test_iov(void)
+{
+    static uint8_t payload[IOV_MAX], pktA[IOV_MAX+128], pktB[IOV_MAX+128];
+    pkt_iovec_t iov[IOV_FRAG];
+    int idx, idy, cnt, lengA, lengB, pleng, crc, pre, err=0;
+    uint8_t protocol;
+
+    my_srand(14);
+    for (idx=0; idx<400; idx++) {
+         pleng = (idx<100) ? idx : (int)(my_rand()%(IOV_MAX-128));
+         for (idy=0; idy<pleng; idy++) payload[idy] = my_rand()&0xFF;
+         cnt = split_iov(iov, payload, pleng);
+         protocol = (idx&1) ? IP_PROTO_TCP : IP_PROTO_UDP;
+         crc = (idx&2)!=0;
+         pre = (idx&4)!=0;
+         //-------------------------------------------------------------------
+         lengA = gen_eth_packet(pktA, mac_src, mac_dst, 0x88B5, pleng, payload, crc, pre);
+         lengB = gen_eth_packet_iov(pktB, mac_src, mac_dst, 0x88B5, iov, cnt, crc, pre);
+         err |= iov_compare("Ethernet", lengA, pktA, lengB, pktB, pleng);
+         //-------------------------------------------------------------------
+         lengA = gen_udp_packet(pktA, port_src, port_dst, pleng, payload);
+         lengB = gen_udp_packet_iov(pktB, port_src, port_dst, iov, cnt);
+         err |= iov_compare("UDP", lengA, pktA, lengB, pktB, pleng);
+         //-------------------------------------------------------------------
+         lengA = gen_tcp_packet(pktA, port_src, port_dst, idx, ~idx, pleng, payload);
+         lengB = gen_tcp_packet_iov(pktB, port_src, port_dst, idx, ~idx, iov, cnt);
+         err |= iov_compare("TCP", lengA, pktA, lengB, pktB, pleng);
+         //-------------------------------------------------------------------
+         // payload is taken as UDP/TCP packet with random checksum field
+         lengA = gen_ip_packet(pktA, ip_src, ip_dst, protocol, 64, pleng, payload, 1);
+         lengB = gen_ip_packet_iov(pktB, ip_src, ip_dst, protocol, 64, iov, cnt, 1);
+         err |= iov_compare("IP", lengA, pktA, lengB, pktB, pleng);
+         //-------------------------------------------------------------------
+         if (protocol==IP_PROTO_UDP) {
+             lengA = gen_eth_ip_udp_packet( pktA, mac_src, mac_dst, ip_src, ip_dst
+                                          , port_src, port_dst, pleng, payload, 1, crc, pre);
+             lengB = gen_eth_ip_udp_packet_iov( pktB, mac_src, mac_dst, ip_src, ip_dst
+                                              , port_src, port_dst, iov, cnt, 1, crc, pre);
+         } else {
+             lengA = gen_eth_ip_tcp_packet( pktA, mac_src, mac_dst, ip_src, ip_dst
+                                          , port_src, port_dst, 1, 2, pleng, payload, 1, crc, pre);
+             lengB = gen_eth_ip_tcp_packet_iov( pktB, mac_src, mac_dst, ip_src, ip_dst
+                                              , port_src, port_dst, 1, 2, iov, cnt, 1, crc, pre);
+         }
+         err |= iov_compare("Ethernet/IP/UDP/TCP", lengA, pktA, lengB, pktB, pleng);
+         //-------------------------------------------------------------------
+         // the first fragment is in place already
+         if (pleng>0) {
+             memcpy(&pktB[ETH_HDR_LEN+IP_HDR_LEN+UDP_HDR_LEN], payload, iov[0].len);
+             iov[0].base = 0;
+             lengB = gen_eth_ip_udp_packet_iov( pktB, mac_src, mac_dst, ip_src, ip_dst
+                                              , port_src, port_dst, iov, cnt, 1, 1, 0);
+             lengA = gen_eth_ip_udp_packet( pktA, mac_src, mac_dst, ip_src, ip_dst
+                                          , port_src, port_dst, pleng, payload, 1, 1, 0);
+             err |= iov_compare("in place", lengA, pktA, lengB, pktB, pleng);
+         }
+    }
+    if (err) printf("Scatter-gather error\n");
+    else     printf("Scatter-gather OK\n");
+    return err;
+}
+
+//----------------------------------------------------------------------------
+// It measures building UDP/IP/Ethernet packet of three fragments,
+// i.e., 16-byte header, body and 4-byte trailer,
+// by staging fragments into a contiguous payload and by fragments.
+int test_iov_bench(void)
+{
+    static const int size[] = { 64, 256, 512, 1024, 1472, 4096, 8972 };
+    static uint8_t payload[IOV_MAX], staged[IOV_MAX], packet[IOV_MAX+128];
+    volatile uint8_t dummy=0;
+    pkt_iovec_t iov[3];
+    uint64_t start, cycles;
+    int pass, idx, idy, num;
+
+    for (idx=0; idx<IOV_MAX; idx++) payload[idx] = my_rand()&0xFF;
+    printf("%-14s", "payload bytes");
+    for (idx=0; idx<(int)(sizeof(size)/sizeof(size[0])); idx++) printf("%8d", size[idx]);
+    printf("\n");
+    for (pass=0; pass<2; pass++) {
+         printf("%-14s", (pass==0) ? "staged" : "scatter-gather");
+         for (idx=0; idx<(int)(sizeof(size)/sizeof(size[0])); idx++) {
+              iov[0].base = payload;
+              iov[0].len  = 16;
+              iov[1].base = payload+16;
+              iov[1].len  = size[idx]-16-4;
+              iov[2].base = payload+IOV_MAX-4;
+              iov[2].len  = 4;
+              num = (1<<25)/size[idx];
+              start = IOV_CYCLES();
+              for (idy=0; idy<num; idy++) {
+                   if (pass==0) {
+                       memcpy(staged, iov[0].base, iov[0].len);
+                       memcpy(staged+iov[0].len, iov[1].base, iov[1].len);
+                       memcpy(staged+iov[0].len+iov[1].len, iov[2].base, iov[2].len);
+                       gen_eth_ip_udp_packet( packet, mac_src, mac_dst, ip_src, ip_dst
+                                            , port_src, port_dst, size[idx], staged
+                                            , 1, 1, 0);
+                   } else {
+                       gen_eth_ip_udp_packet_iov( packet, mac_src, mac_dst, ip_src, ip_dst
+                                                , port_src, port_dst, iov, 3
+                                                , 1, 1, 0);
+                   }
+                   dummy ^= packet[ETH_HDR_LEN+IP_HDR_LEN+6];
+              }
+              cycles = IOV_CYCLES()-start;
+              printf("%8.3f", (double)cycles/((double)num*size[idx]));
+         }
+         printf(" cycles/byte\n");
+    }
+    return (int)(dummy&0);
+}
+
+//----------------------------------------------------------------------------
@@ -0,0 +1,209 @@
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include "eth_ip_udp_tcp_pkt.h"
+#include "test_util.h"
+
+//----------------------------------------------------------------------------
+extern uint8_t  mac_src[6];
+extern uint8_t  mac_dst[6];
+extern uint32_t ip_src;
+extern uint32_t ip_dst;
+
+//----------------------------------------------------------------------------
+#define IPV6_FRAME (8+ETH_HDR_LEN+PKT_VLAN_MAX*ETH_VLAN_TAG_LEN+ETH_PAYLOAD_MAX+4)
+
+static uint8_t payload[UDP6_PAYLOAD_MAX];
+static uint8_t frame[IPV6_FRAME];
+static uint8_t plain[IPV6_FRAME];
+static uint8_t ref[PSEUDO_IPV6_HDR_LEN+IPV6_PAYLOAD_MAX];
+
+static uint8_t ip6_src[16] = { 0x20,0x01,0x0D,0xB8,0x00,0x00,0x00,0x01
+                             , 0x02,0x11,0x22,0xFF,0xFE,0x33,0x44,0x55 };
+static uint8_t ip6_dst[16] = { 0xFE,0x80,0x00,0x00,0x00,0x00,0x00,0x00
+                             , 0xF1,0xAA,0xBB,0xFF,0xFE,0xCC,0xDD,0xEE };
+
+//----------------------------------------------------------------------------
+// It checks UDP/TCP over IPv6 frame of 'bnum' bytes without preamble,
+// where checksum is verified against the pseudo header built byte by byte.
+static int ipv6_check( const uint8_t *pkt, int bnum, int hdr
+                     , uint8_t nxt, int l4_len, int payload_len)
+{
+    int seg = l4_len+payload_len;
+    int len = ((IPV6_HDR_LEN+seg)<(46-hdr+ETH_HDR_LEN)) ? (46-hdr+ETH_HDR_LEN) : (IPV6_HDR_LEN+seg);
+    const uint8_t *ip = pkt+hdr;
+    uint16_t type_len;
+
+    if (bnum!=(hdr+len+4)) return 1;
+    if ((get_eth_type(pkt, bnum, &type_len)!=hdr)||(type_len!=ETH_TYPE_IPV6)) return 1;
+    if ((ip[0]!=0x60)||ip[1]||ip[2]||ip[3]) return 1;
+    if (((ip[4]<<8)|ip[5])!=seg) return 1;
+    if ((ip[6]!=nxt)||(ip[7]!=64)) return 1;
+    if (memcmp(&ip[8], ip6_src, 16)||memcmp(&ip[24], ip6_dst, 16)) return 1;
+    if (memcmp(&ip[IPV6_HDR_LEN+l4_len], payload, payload_len)) return 1;
+    // pseudo header: src, dst, 32-bit length, 3 zeros, next header
+    memcpy(&ref[0] , ip6_src, 16);
+    memcpy(&ref[16], ip6_dst, 16);
+    ref[32] = 0; ref[33] = 0; ref[34] = seg>>8; ref[35] = seg&0xFF;
+    ref[36] = 0; ref[37] = 0; ref[38] = 0; ref[39] = nxt;
+    memcpy(&ref[40], &ip[IPV6_HDR_LEN], seg);
+    if (compute_checksum_d8(ref, 40+seg)!=0xFFFF) return 1;
+    if (check_eth_crc((uint8_t*)pkt, bnum)) return 1;
+    return 0;
+}
+
+//----------------------------------------------------------------------------
+// It builds UDP/TCP over IPv6 frames and checks them, where checksum
+// covers IPv6 pseudo header, and walks over extension headers.
+// Return 0 on success, 1 on failure
+int test_ipv6(void)
+{
+    static const pkt_vlan_t vlan = { ETH_TYPE_VLAN, PKT_VLAN_TCI(0,0,10) };
+    uint8_t nxt;
+    int idx, len, bnum, pnum, off, err=0;
+
+    my_srand(21);
+    for (idx=0; idx<UDP6_PAYLOAD_MAX; idx++) payload[idx] = my_rand()&0xFF;
+    for (len=0; len<=9000; len+=(len<64) ? 1 : 331) {
+         bnum = gen_eth_ipv6_udp_packet(frame, mac_src, mac_dst, ip6_src, ip6_dst, 64
+                                       , 0x1234, 0x5678, len, payload, 1, 1, 0);
+         if (ipv6_check(frame, bnum, ETH_HDR_LEN, IP_PROTO_UDP, UDP_HDR_LEN, len)) {
+             printf("IPv6 error: UDP %d bytes\n", len);
+             err = 1;
+         }
+         bnum = gen_eth_ipv6_tcp_packet(frame, mac_src, mac_dst, ip6_src, ip6_dst, 64
+                                       , 0x1234, 0x5678, 1000, 2000, len, payload, 1, 1, 0);
+         if (ipv6_check(frame, bnum, ETH_HDR_LEN, IP_PROTO_TCP, TCP_HDR_LEN, len)) {
+             printf("IPv6 error: TCP %d bytes\n", len);
+             err = 1;
+         }
+         // IPv6 packet built on UDP packet is the same as in the frame
+         if (len<(46-IPV6_HDR_LEN-UDP_HDR_LEN)) continue;
+         gen_udp_packet(&plain[IPV6_HDR_LEN], 0x1234, 0x5678, len, payload);
+         pnum = gen_ipv6_packet(plain, ip6_src, ip6_dst, IP_PROTO_UDP, 64
+                               , UDP_HDR_LEN+len, NULL, 1);
+         bnum = gen_eth_ipv6_udp_packet_vlan(frame, mac_src, mac_dst, &vlan, 1, ip6_src, ip6_dst, 64
+                                            , 0x1234, 0x5678, len, payload, 1, 1, 1);
+         if ((pnum!=(IPV6_HDR_LEN+UDP_HDR_LEN+len))||
+             ipv6_check(frame+8, bnum-8, ETH_HDR_LEN+ETH_VLAN_TAG_LEN, IP_PROTO_UDP, UDP_HDR_LEN, len)||
+             memcmp(plain, frame+8+ETH_HDR_LEN+ETH_VLAN_TAG_LEN, pnum)) {
+             printf("IPv6 error: IP %d bytes\n", len);
+             err = 1;
+         }
+    }
+    //-----------------------------------------------------------------------
+    // UDP checksum computed as 0 goes as 0xFFFF
+    payload[98] = payload[99] = 0;
+    gen_eth_ipv6_udp_packet(frame, mac_src, mac_dst, ip6_src, ip6_dst, 64
+                           , 0x1234, 0x5678, 100, payload, 1, 1, 0);
+    off = ETH_HDR_LEN+IPV6_HDR_LEN+6;
+    payload[98] = frame[off]; payload[99] = frame[off+1]; // makes sum 0xFFFF
+    bnum = gen_eth_ipv6_udp_packet(frame, mac_src, mac_dst, ip6_src, ip6_dst, 64
+                                  , 0x1234, 0x5678, 100, payload, 1, 1, 0);
+    if ((frame[off]!=0xFF)||(frame[off+1]!=0xFF)||
+        ipv6_check(frame, bnum, ETH_HDR_LEN, IP_PROTO_UDP, UDP_HDR_LEN, 100)) {
+        printf("IPv6 error: UDP zero checksum\n");
+        err = 1;
+    }
+    gen_ipv6_packet(plain, ip6_src, ip6_dst, IP_PROTO_UDP, 64, UDP_HDR_LEN+100
+                   , &frame[ETH_HDR_LEN+IPV6_HDR_LEN], 1);
+    if ((plain[IPV6_HDR_LEN+6]!=0xFF)||(plain[IPV6_HDR_LEN+7]!=0xFF)) {
+        printf("IPv6 error: IP zero checksum\n");
+        err = 1;
+    }
+    //-----------------------------------------------------------------------
+    // extension headers: Hop-by-Hop, Routing, Fragment, AH and then UDP
+    memset(ref, 0, 8+16+8+16);
+    ref[0]  = IPV6_NEXT_ROUTING;  ref[1]  = 0; // 8 bytes
+    ref[8]  = IPV6_NEXT_FRAGMENT; ref[9]  = 1; // 16 bytes
+    ref[24] = IPV6_NEXT_AH;                    // 8 bytes
+    ref[32] = IP_PROTO_UDP;       ref[33] = 2; // 16 bytes
+    gen_udp_packet(&ref[48], 0x1234, 0x5678, 10, payload);
+    pnum = gen_ipv6_packet(plain, ip6_src, ip6_dst, IPV6_NEXT_HOPOPTS, 64, 48+UDP_HDR_LEN+10, ref, 0);
+    if ((get_ipv6_upper(plain, pnum, &nxt, &off)!=(IPV6_HDR_LEN+48))||(nxt!=IP_PROTO_UDP)||off||
+        (get_ipv6_upper(plain, IPV6_HDR_LEN+47, &nxt, &off)!=-1)) {
+        printf("IPv6 error: extension headers\n");
+        err = 1;
+    }
+    plain[IPV6_HDR_LEN+24+2] = 0x05; plain[IPV6_HDR_LEN+24+3] = 0xC9; // offset 1480, more
+    if ((get_ipv6_upper(plain, pnum, &nxt, &off)!=(IPV6_HDR_LEN+48))||(off!=1480)) {
+        printf("IPv6 error: fragment header\n");
+        err = 1;
+    }
+    pnum = gen_ipv6_packet(plain, ip6_src, ip6_dst, IPV6_NEXT_NONE, 64, 0, NULL, 0);
+    if ((get_ipv6_upper(plain, pnum, &nxt, NULL)!=IPV6_HDR_LEN)||(nxt!=IPV6_NEXT_NONE)||
+        (get_ipv6_upper(plain, IPV6_HDR_LEN-1, &nxt, NULL)!=-1)) {
+        printf("IPv6 error: no next header\n");
+        err = 1;
+    }
+    //-----------------------------------------------------------------------
+    // bounds
+    bnum = gen_eth_ipv6_udp_packet(frame, mac_src, mac_dst, ip6_src, ip6_dst, 64
+                                  , 0x1234, 0x5678, UDP6_PAYLOAD_MAX, payload, 1, 1, 1);
+    if ((bnum!=(8+ETH_HDR_LEN+ETH_PAYLOAD_MAX+4))||
+        ipv6_check(frame+8, bnum-8, ETH_HDR_LEN, IP_PROTO_UDP, UDP_HDR_LEN, UDP6_PAYLOAD_MAX)||
+        (gen_eth_ipv6_udp_packet(frame, mac_src, mac_dst, ip6_src, ip6_dst, 64
+                                , 0x1234, 0x5678, UDP6_PAYLOAD_MAX+1, payload, 1, 1, 1)!=-1)||
+        (gen_eth_ipv6_tcp_packet(frame, mac_src, mac_dst, ip6_src, ip6_dst, 64
+                                , 0x1234, 0x5678, 0, 0, TCP6_PAYLOAD_MAX+1, payload, 1, 1, 1)!=-1)||
+        (gen_ipv6_packet(plain, ip6_src, ip6_dst, IP_PROTO_UDP, 64, IPV6_PAYLOAD_MAX+1, NULL, 0)!=-1)) {
+        printf("IPv6 error: bounds\n");
+        err = 1;
+    }
+    if (err) printf("IPv6 error\n");
+    else     printf("IPv6 OK\n");
+    return err;
+}
+
+//----------------------------------------------------------------------------
+// It measures frames per second of UDP and TCP over IPv4 and IPv6.
+int test_ipv6_bench(void)
+{
+    static const int size[] = { 6, 1452 };
+    volatile int dummy=0;
+    int idx, idy, idz, tcp, ver;
+    double sec;
+    clock_t start;
+
+    printf("%-14s%8s%8s\n", "", "IPv4", "IPv6");
+    for (tcp=0; tcp<=1; tcp++) {
+    for (idx=0; idx<(int)(sizeof(size)/sizeof(size[0])); idx++) {
+         char name[16];
+         sprintf(name, "%s %d", (tcp) ? "TCP" : "UDP", size[idx]);
+         printf("%-14s", name);
+         for (ver=4; ver<=6; ver+=2) {
+              idz = (1<<26)/(size[idx]+64);
+              start = clock();
+              for (idy=0; idy<idz; idy++) {
+                   if (tcp&&(ver==4)) {
+                       dummy ^= gen_eth_ip_tcp_packet( frame, mac_src, mac_dst, ip_src, ip_dst
+                                                     , 0x1234, 0x5678, 1000, 2000
+                                                     , size[idx], payload, 1, 1, 0);
+                   } else if (tcp) {
+                       dummy ^= gen_eth_ipv6_tcp_packet( frame, mac_src, mac_dst, ip6_src, ip6_dst, 64
+                                                       , 0x1234, 0x5678, 1000, 2000
+                                                       , size[idx], payload, 1, 1, 0);
+                   } else if (ver==4) {
+                       dummy ^= gen_eth_ip_udp_packet( frame, mac_src, mac_dst, ip_src, ip_dst
+                                                     , 0x1234, 0x5678
+                                                     , size[idx], payload, 1, 1, 0);
+                   } else {
+                       dummy ^= gen_eth_ipv6_udp_packet( frame, mac_src, mac_dst, ip6_src, ip6_dst, 64
+                                                       , 0x1234, 0x5678
+                                                       , size[idx], payload, 1, 1, 0);
+                   }
+              }
+              sec = (double)(clock()-start)/CLOCKS_PER_SEC;
+              if (sec<=0.0) sec = 1.0/CLOCKS_PER_SEC;
+              printf("%8.2f", (double)idz/sec/1.0e6);
+         }
+         printf(" M frames/sec\n");
+    }}
+    return dummy&0;
+}
+
+//----------------------------------------------------------------------------
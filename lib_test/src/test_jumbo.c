@@ -0,0 +1,166 @@
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#if defined(__x86_64__)||defined(__i386__)
+#include <x86intrin.h>
+#define JUMBO_CYCLES() __rdtsc()
+#elif defined(_M_X64)||defined(_M_IX86)
+#include <intrin.h>
+#define JUMBO_CYCLES() __rdtsc()
+#else
+#define JUMBO_CYCLES() ((uint64_t)clock()) // clock ticks instead of cycles
+#endif
+#include "eth_ip_udp_tcp_pkt.h"
+#include "test_util.h"
+#include "pkt_template.h"
+
+//----------------------------------------------------------------------------
+extern uint8_t  mac_src[6];
+extern uint8_t  mac_dst[6];
+extern uint32_t ip_src;
+extern uint32_t ip_dst;
+extern uint16_t port_src;
+extern uint16_t port_dst;
+
+//----------------------------------------------------------------------------
+static uint8_t payload[ETH_FRAME_MAX], packet[ETH_FRAME_MAX+PKT_BUF_HEADROOM];
+
+//----------------------------------------------------------------------------
+// It checks FCS, IP checksum and UDP/TCP checksum of 'leng'-byte frame.
+static int jumbo_check(const char *name, int leng, int pleng, uint8_t protocol)
+{
+    pseudo_ip_hdr_t piphdr;
+    uint8_t *l4 = &packet[ETH_HDR_LEN+IP_HDR_LEN];
+    int l4_len = pleng+((protocol==IP_PROTO_UDP) ? UDP_HDR_LEN : TCP_HDR_LEN);
+    if (leng!=(ETH_HDR_LEN+IP_HDR_LEN+l4_len+4)) {
+        printf("Jumbo error: %s leng=%d\n", name, leng);
+        return 1;
+    }
+    populate_pseudo_ip_hdr(&piphdr, ip_src, ip_dst, protocol, l4_len);
+    if (check_eth_crc(packet, leng)||
+        check_ip_checksum((ip_hdr_t*)&packet[ETH_HDR_LEN])||
+        ((protocol==IP_PROTO_UDP)&&check_udp_checksum(&piphdr, (udp_hdr_t*)l4))||
+        ((protocol==IP_PROTO_TCP)&&check_tcp_checksum(&piphdr, (tcp_hdr_t*)l4))||
+        memcmp(l4+l4_len-pleng, payload, pleng)) {
+        printf("Jumbo error: %s checksum leng=%d\n", name, leng);
+        return 1;
+    }
+    return 0;
+}
+
+//----------------------------------------------------------------------------
+// It builds jumbo frames and 64 KiB IP datagrams,
+// and checks lengths just beyond the size model are refused.
+// Return 0 on success, 1 on failure
+int test_jumbo(void)
+{
+    static const int size[] = { 1500, 9000, 9600, TCP_PAYLOAD_MAX, UDP_PAYLOAD_MAX };
+    pkt_template_t *tpl;
+    pkt_iovec_t iov[1];
+    pkt_buf_t buf;
+    int idx, leng, err=0;
+
+    my_srand(15);
+    for (idx=0; idx<ETH_FRAME_MAX; idx++) payload[idx] = my_rand()&0xFF;
+    for (idx=0; idx<(int)(sizeof(size)/sizeof(size[0])); idx++) {
+         //-------------------------------------------------------------------
+         leng = gen_eth_ip_udp_packet( packet, mac_src, mac_dst, ip_src, ip_dst
+                                     , port_src, port_dst, size[idx], payload, 1, 1, 0);
+         err |= jumbo_check("UDP", leng, size[idx], IP_PROTO_UDP);
+         //-------------------------------------------------------------------
+         if (size[idx]<=TCP_PAYLOAD_MAX) {
+             leng = gen_eth_ip_tcp_packet( packet, mac_src, mac_dst, ip_src, ip_dst
+                                         , port_src, port_dst, 1, 2, size[idx], payload, 1, 1, 0);
+             err |= jumbo_check("TCP", leng, size[idx], IP_PROTO_TCP);
+         }
+    }
+    //-----------------------------------------------------------------------
+    // largest Ethernet payload
+    leng = gen_eth_packet(packet, mac_src, mac_dst, 0x88B5, ETH_PAYLOAD_MAX, payload, 1, 1);
+    if ((leng!=ETH_FRAME_MAX)||check_eth_crc(&packet[8], leng-8)) {
+        printf("Jumbo error: Ethernet leng=%d\n", leng);
+        err = 1;
+    }
+    //-----------------------------------------------------------------------
+    // just beyond the size model
+    iov[0].base = payload;
+    iov[0].len  = UDP_PAYLOAD_MAX+1;
+    pkt_buf_init(&buf, packet, sizeof(packet), PKT_BUF_HEADROOM);
+    pkt_buf_put(&buf, UDP_PAYLOAD_MAX+1);
+    if ((gen_eth_packet(packet, mac_src, mac_dst, 0x88B5, ETH_PAYLOAD_MAX+1, payload, 1, 0)!=-1)||
+        (gen_ip_packet(packet, ip_src, ip_dst, IP_PROTO_UDP, 64, IP_PKT_MAX-IP_HDR_LEN+1, payload, 0)!=-1)||
+        (gen_udp_packet(packet, port_src, port_dst, UDP_PAYLOAD_MAX+1, payload)!=-1)||
+        (gen_tcp_packet(packet, port_src, port_dst, 1, 2, TCP_PAYLOAD_MAX+1, payload)!=-1)||
+        (gen_eth_ip_udp_packet( packet, mac_src, mac_dst, ip_src, ip_dst
+                              , port_src, port_dst, UDP_PAYLOAD_MAX+1, payload, 1, 1, 0)!=-1)||
+        (gen_eth_ip_tcp_packet( packet, mac_src, mac_dst, ip_src, ip_dst
+                              , port_src, port_dst, 1, 2, TCP_PAYLOAD_MAX+1, payload, 1, 1, 0)!=-1)||
+        (gen_eth_ip_udp_packet_iov( packet, mac_src, mac_dst, ip_src, ip_dst
+                                  , port_src, port_dst, iov, 1, 1, 1, 0)!=-1)||
+        (gen_eth_ip_udp_packet_buf( &buf, mac_src, mac_dst, ip_src, ip_dst
+                                  , port_src, port_dst, 1, 1, 0)!=-1)||
+        (gen_udp_packet(packet, port_src, port_dst, -1, payload)!=-1)) {
+        printf("Jumbo error: beyond the size model\n");
+        err = 1;
+    }
+    //-----------------------------------------------------------------------
+    // template up to 64 KiB datagram
+    tpl = pkt_template_create( IP_PROTO_UDP, mac_src, mac_dst, ip_src, ip_dst
+                             , port_src, port_dst, 0, 0, UDP_PAYLOAD_MAX+1, 1, 1, 0);
+    if (tpl!=NULL) {
+        printf("Jumbo error: template beyond the size model\n");
+        pkt_template_release(tpl);
+        err = 1;
+    }
+    tpl = pkt_template_create( IP_PROTO_UDP, mac_src, mac_dst, ip_src, ip_dst
+                             , port_src, port_dst, UDP_PAYLOAD_MAX, payload, UDP_PAYLOAD_MAX, 1, 1, 0);
+    if (tpl==NULL) {
+        printf("Jumbo error: template\n");
+        err = 1;
+    } else {
+        leng = pkt_template_emit(tpl, packet);
+        err |= jumbo_check("template", leng, UDP_PAYLOAD_MAX, IP_PROTO_UDP);
+        pkt_template_release(tpl);
+    }
+    if (err) printf("Jumbo error\n");
+    else     printf("Jumbo OK\n");
+    return err;
+}
+
+//----------------------------------------------------------------------------
+// It measures building UDP/IP/Ethernet packet of standard, jumbo and
+// 64 KiB datagram, i.e., 65535-byte IP packet.
+int test_jumbo_bench(void)
+{
+    static const int size[] = { 1500-IP_HDR_LEN-UDP_HDR_LEN
+                              , 9000-IP_HDR_LEN-UDP_HDR_LEN
+                              , UDP_PAYLOAD_MAX };
+    volatile uint8_t dummy=0;
+    uint64_t start, cycles;
+    int idx, idy, num;
+
+    for (idx=0; idx<ETH_FRAME_MAX; idx++) payload[idx] = my_rand()&0xFF;
+    printf("%-14s", "IP bytes");
+    for (idx=0; idx<(int)(sizeof(size)/sizeof(size[0])); idx++) printf("%8d", IP_HDR_LEN+UDP_HDR_LEN+size[idx]);
+    printf("\n");
+    printf("%-14s", "single pass");
+    for (idx=0; idx<(int)(sizeof(size)/sizeof(size[0])); idx++) {
+         num = (1<<25)/size[idx];
+         start = JUMBO_CYCLES();
+         for (idy=0; idy<num; idy++) {
+              gen_eth_ip_udp_packet( packet, mac_src, mac_dst, ip_src, ip_dst
+                                   , port_src, port_dst, size[idx], payload
+                                   , 1, 1, 0);
+              dummy ^= packet[ETH_HDR_LEN+IP_HDR_LEN+6];
+         }
+         cycles = JUMBO_CYCLES()-start;
+         printf("%8.3f", (double)cycles/((double)num*size[idx]));
+    }
+    printf(" cycles/byte\n");
+    return (int)(dummy&0);
+}
+
+//----------------------------------------------------------------------------
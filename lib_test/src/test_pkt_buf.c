@@ -0,0 +1,180 @@
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include "eth_ip_udp_tcp_pkt.h"
+#include "test_util.h"
+#include "ptpv2_message.h"
+#include "pkt_buf.h"
+
+//----------------------------------------------------------------------------
+extern uint8_t  mac_src[6];
+extern uint8_t  mac_dst[6];
+extern uint32_t ip_src;
+extern uint32_t ip_dst;
+extern uint16_t port_src;
+extern uint16_t port_dst;
+
+//----------------------------------------------------------------------------
+#define PKT_BUF_MAX  9216
+
+//----------------------------------------------------------------------------
+// It places 'num' bytes of 'payload' in 'buf' after headroom.
+static void buf_payload(pkt_buf_t *buf, uint8_t *mem, const uint8_t *payload, int num)
+{
+    memset(mem, 0xA5, PKT_BUF_MAX+128);
+    pkt_buf_init(buf, mem, PKT_BUF_MAX+128, PKT_BUF_HEADROOM);
+    memcpy(pkt_buf_put(buf, num), payload, num);
+}
+
+//----------------------------------------------------------------------------
+// It compares 'leng' bytes of 'ref' and the packet in 'buf'.
+static int buf_compare(const char *name, pkt_buf_t *buf, int leng, const uint8_t *ref, int pleng)
+{
+    if ((buf->len!=leng)||memcmp(buf->data, ref, leng)) {
+        printf("Packet buffer error: %s leng=%d\n", name, pleng);
+        return 1;
+    }
+    return 0;
+}
+
+//----------------------------------------------------------------------------
+// It builds PTPv2 frame in the way before packet buffer,
+// i.e., walking offset backwards through gen_udp/ip/eth_packet().
+static int ptpv2_reference( uint8_t *msg, ptpv2_msg_hdr_t *hdr, Timestamp_t *time
+                          , PortIdentity_t *port, int add_crc, int add_preamble)
+{
+    uint8_t mac_ptp[6] = { 0x01, 0x00, 0x5E, 0x00, 0x01, 0x81 };
+    uint16_t port_ptp = 319;
+    uint32_t ip_ptp = 0xE0000181;
+    int loc, leng;
+    if (hdr->messageType>=0x8) port_ptp = 320;
+    if ((hdr->messageType==0x2)||(hdr->messageType==0x3)||(hdr->messageType==0xA)) { // peer delay
+        mac_ptp[4] = 0x00; mac_ptp[5] = 0x6B;
+        ip_ptp     = 0xE000006B;
+    }
+    loc  = ((add_preamble) ? 8 : 0)+ETH_HDR_LEN+IP_HDR_LEN+UDP_HDR_LEN;
+    leng = (gen_ptpv2_msg[hdr->messageType])(get_ptpv2_context(), &msg[loc], hdr, time, port);
+    loc -= UDP_HDR_LEN;
+    leng = gen_udp_packet(&msg[loc], port_ptp, port_ptp, leng, 0);
+    loc -= IP_HDR_LEN;
+    leng = gen_ip_packet(&msg[loc], ip_src, ip_ptp, IP_PROTO_UDP, 0, leng, 0, 0);
+    return gen_eth_packet(msg, mac_src, mac_ptp, ETH_TYPE_IP, leng, 0, add_crc, add_preamble);
+}
+
+//----------------------------------------------------------------------------
+// It compares builders on packet buffer with the ones on plain array.
+// Return 0 on success, 1 on failure
+int test_pkt_buf(void)
+{
+    static uint8_t payload[PKT_BUF_MAX], mem[PKT_BUF_MAX+128], ref[PKT_BUF_MAX+128];
+    static const uint8_t ptp_type[] = { 0x0, 0x1, 0x8, 0x9 };
+    pkt_buf_t buf;
+    ptpv2_msg_hdr_t hdr;
+    Timestamp_t time;
+    PortIdentity_t port;
+    int idx, idy, leng, pleng, crc, pre, err=0;
+    uint8_t protocol;
+
+    my_srand(13);
+    for (idx=0; idx<200; idx++) {
+         pleng = (idx<80) ? idx : (int)(my_rand()%(PKT_BUF_MAX-128));
+         for (idy=0; idy<pleng; idy++) payload[idy] = my_rand()&0xFF;
+         protocol = (idx&1) ? IP_PROTO_TCP : IP_PROTO_UDP;
+         crc = (idx&2)!=0;
+         pre = (idx&4)!=0;
+         //-------------------------------------------------------------------
+         leng = gen_eth_packet(ref, mac_src, mac_dst, 0x88B5, pleng, payload, crc, pre);
+         buf_payload(&buf, mem, payload, pleng);
+         gen_eth_packet_buf(&buf, mac_src, mac_dst, 0x88B5, crc, pre);
+         err |= buf_compare("Ethernet", &buf, leng, ref, pleng);
+         //-------------------------------------------------------------------
+         leng = gen_udp_packet(ref, port_src, port_dst, pleng, payload);
+         buf_payload(&buf, mem, payload, pleng);
+         gen_udp_packet_buf(&buf, port_src, port_dst);
+         err |= buf_compare("UDP", &buf, leng, ref, pleng);
+         //-------------------------------------------------------------------
+         leng = gen_tcp_packet(ref, port_src, port_dst, idx, ~idx, pleng, payload);
+         buf_payload(&buf, mem, payload, pleng);
+         gen_tcp_packet_buf(&buf, port_src, port_dst, idx, ~idx);
+         err |= buf_compare("TCP", &buf, leng, ref, pleng);
+         //-------------------------------------------------------------------
+         leng = gen_ip_packet(ref, ip_src, ip_dst, protocol, 64, pleng, payload, 1);
+         buf_payload(&buf, mem, payload, pleng);
+         gen_ip_packet_buf(&buf, ip_src, ip_dst, protocol, 64, 1);
+         err |= buf_compare("IP", &buf, leng, ref, pleng);
+         //-------------------------------------------------------------------
+         if (protocol==IP_PROTO_UDP) {
+             leng = gen_eth_ip_udp_packet( ref, mac_src, mac_dst, ip_src, ip_dst
+                                         , port_src, port_dst, pleng, payload, 1, crc, pre);
+             buf_payload(&buf, mem, payload, pleng);
+             gen_eth_ip_udp_packet_buf( &buf, mac_src, mac_dst, ip_src, ip_dst
+                                      , port_src, port_dst, 1, crc, pre);
+         } else {
+             leng = gen_eth_ip_tcp_packet( ref, mac_src, mac_dst, ip_src, ip_dst
+                                         , port_src, port_dst, 1, 2, pleng, payload, 1, crc, pre);
+             buf_payload(&buf, mem, payload, pleng);
+             gen_eth_ip_tcp_packet_buf( &buf, mac_src, mac_dst, ip_src, ip_dst
+                                      , port_src, port_dst, 1, 2, 1, crc, pre);
+         }
+         err |= buf_compare("Ethernet/IP/UDP/TCP", &buf, leng, ref, pleng);
+         //-------------------------------------------------------------------
+         // layer by layer gives the same as the composite builder
+         if (protocol==IP_PROTO_UDP) {
+             buf_payload(&buf, mem, payload, pleng);
+             gen_udp_packet_buf(&buf, port_src, port_dst);
+             gen_ip_packet_buf(&buf, ip_src, ip_dst, protocol, 1, pleng!=0);
+             gen_eth_packet_buf(&buf, mac_src, mac_dst, ETH_TYPE_IP, crc, pre);
+             err |= buf_compare("layers", &buf, leng, ref, pleng);
+         }
+    }
+    //-----------------------------------------------------------------------
+    // ARP; it is compared without CRC and FCS is checked.
+    pkt_buf_init(&buf, mem, 128, PKT_BUF_HEADROOM);
+    leng = gen_eth_arp_packet(ref, mac_src, mac_dst, 1, ip_src, ip_dst, 0, 0);
+    gen_eth_arp_packet_buf(&buf, mac_src, mac_dst, 1, ip_src, ip_dst, 0, 0);
+    err |= buf_compare("ARP", &buf, leng, ref, ARP_HDR_LEN);
+    pkt_buf_init(&buf, mem, 128, PKT_BUF_HEADROOM);
+    leng = gen_eth_arp_packet_buf(&buf, mac_src, mac_dst, 1, ip_src, ip_dst, 1, 0);
+    if ((leng!=(ETH_HDR_LEN+46+4))||check_eth_crc(buf.data, leng)) {
+        printf("Packet buffer error: ARP FCS\n");
+        err = 1;
+    }
+    //-----------------------------------------------------------------------
+    // PTPv2 over UDP/IP/Ethernet
+    for (idx=0; idx<(int)(sizeof(ptp_type)*4); idx++) {
+         memset(&port, 0, sizeof(port));
+         time.secondsField.msb = 0;
+         time.secondsField.lsb = my_rand();
+         time.nanosecondsField = my_rand()%1000000000;
+         fill_ptpv2_msg_hdr(&hdr, ptp_type[idx%sizeof(ptp_type)], 0, 0
+                           , 0x0011223344556677ULL, 1, idx);
+         memset(ref, 0, sizeof(ref));
+         memset(mem, 0, sizeof(mem));
+         crc = (idx>>2)&1;
+         pre = (idx>>3)&1;
+         leng = ptpv2_reference(ref, &hdr, &time, &port, crc, pre);
+         pleng = gen_ptpv2_msg_udp_ip_ethernet( get_ptpv2_context(), mem, mac_src, ip_src
+                                              , &hdr, &time, &port, crc, pre);
+         if ((leng!=pleng)||memcmp(ref, mem, sizeof(mem))) {
+             printf("Packet buffer error: PTPv2 type=%d\n", hdr.messageType);
+             err = 1;
+         }
+    }
+    //-----------------------------------------------------------------------
+    // no room
+    pkt_buf_init(&buf, mem, 64, ETH_HDR_LEN+IP_HDR_LEN);
+    if ((gen_eth_ip_udp_packet_buf(&buf, mac_src, mac_dst, ip_src, ip_dst
+                                  , port_src, port_dst, 1, 0, 0)!=-1)||
+        (buf.len!=0)||(pkt_buf_push(&buf, 35)!=NULL)||(pkt_buf_pull(&buf, 1)!=NULL)||
+        (pkt_buf_put(&buf, 64-ETH_HDR_LEN-IP_HDR_LEN+1)!=NULL)) {
+        printf("Packet buffer error: room\n");
+        err = 1;
+    }
+    if (err) printf("Packet buffer error\n");
+    else     printf("Packet buffer OK\n");
+    return err;
+}
+
+//----------------------------------------------------------------------------
@@ -0,0 +1,425 @@
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include "eth_ip_udp_tcp_pkt.h"
+#include "test_util.h"
+#include "ptpv2_message.h"
+
+//----------------------------------------------------------------------------
+extern uint8_t  mac_src[6];
+extern uint32_t ip_src;
+
+//----------------------------------------------------------------------------
+static uint8_t frame[PTPV2_FRAME_MAX];
+static uint8_t expect[PTPV2_FRAME_MAX];
+
+// message types and their lengths without TLVs
+static const uint8_t ptp_type[] = { 0x0, 0x1, 0x2, 0x3, 0x8, 0x9, 0xA, 0xB, 0xC, 0xD };
+static const int     ptp_len [] = {  44,  44,  54,  54,  44,  54,  54,  64,  44,  48 };
+
+//----------------------------------------------------------------------------
+static int ptp_build( uint8_t *pkt, int udp, int tags, uint8_t type, uint16_t seq
+                    , Timestamp_t *time, PortIdentity_t *port, int crc, int pre)
+{
+    ptpv2_msg_hdr_t hdr;
+    fill_ptpv2_msg_hdr(&hdr, type, 0x0200, 0x1234, 0x0011223344556677ULL, 1, seq);
+    if (udp) return gen_ptpv2_msg_udp_ip_ethernet_vlan( get_ptpv2_context(), pkt, mac_src
+                                                      , &vlan_tags[PKT_VLAN_MAX-tags], tags, ip_src
+                                                      , &hdr, time, port, crc, pre);
+    return gen_ptpv2_msg_ethernet_vlan( get_ptpv2_context(), pkt, mac_src
+                                      , &vlan_tags[PKT_VLAN_MAX-tags], tags
+                                      , &hdr, time, port, crc, pre);
+}
+
+//----------------------------------------------------------------------------
+// It checks destination of frame at 'eth', where peer delay messages
+// and the others go to each address of IEEE.Std 1588-2008 Annex D and F,
+// and UDP port is 319 for event and 320 for general messages.
+static int ptp_dest(const uint8_t *eth, int udp, int tags, uint8_t type)
+{
+    static const uint8_t mac_peer[6]  = { 0x01, 0x80, 0xC2, 0x00, 0x00, 0x0E };
+    static const uint8_t mac_other[6] = { 0x01, 0x1B, 0x19, 0x00, 0x00, 0x00 };
+    static const uint8_t ip_peer[4]   = { 224, 0, 0, 107 };
+    static const uint8_t ip_other[4]  = { 224, 0, 1, 129 };
+    const uint8_t *ip = &eth[ETH_HDR_LEN+tags*ETH_VLAN_TAG_LEN];
+    const uint8_t *dst;
+    int peer = (type==PTPV2_MSG_Pdelay_Req)||(type==PTPV2_MSG_Pdelay_Resp)||
+               (type==PTPV2_MSG_Pdelay_Resp_Follow_Up);
+    int port = (type<0x8) ? 319 : 320;
+    if (!udp) return memcmp(eth, (peer) ? mac_peer : mac_other, 6)!=0;
+    dst = (peer) ? ip_peer : ip_other;
+    if (memcmp(&ip[16], dst, 4)||(((ip[IP_HDR_LEN+2]<<8)|ip[IP_HDR_LEN+3])!=port)) return 1;
+    return (eth[0]!=0x01)||(eth[1]!=0x00)||(eth[2]!=0x5E)||
+           (eth[3]!=(dst[1]&0x7F))||(eth[4]!=dst[2])||(eth[5]!=dst[3]);
+}
+
+//----------------------------------------------------------------------------
+// It checks message body of type 'idx' of 'ptp_type[]' at 'msg'.
+static int ptp_check(const uint8_t *msg, int idx, Timestamp_t *time, PortIdentity_t *port)
+{
+    ptpv2_ctx_t *ctx = get_ptpv2_context();
+    uint8_t ts[10], zero[10], *tlv;
+    int leng, time_on, port_off=0;
+    uint8_t type = ptp_type[idx];
+
+    ts[0] = time->secondsField.msb>>8;  ts[1] = time->secondsField.msb;
+    ts[2] = time->secondsField.lsb>>24; ts[3] = time->secondsField.lsb>>16;
+    ts[4] = time->secondsField.lsb>>8;  ts[5] = time->secondsField.lsb;
+    ts[6] = time->nanosecondsField>>24; ts[7] = time->nanosecondsField>>16;
+    ts[8] = time->nanosecondsField>>8;  ts[9] = time->nanosecondsField;
+    memset(zero, 0, sizeof(zero));
+    leng = ptp_len[idx]+ctx->tlv_len[type];
+    if (((msg[0]&0xF)!=type)||(((msg[2]<<8)|msg[3])!=leng)||(msg[30]!=0x56)||(msg[31]!=0x78)) return 1;
+    switch (type) {
+    case PTPV2_MSG_Follow_Up:
+    case PTPV2_MSG_Delay_Resp:
+    case PTPV2_MSG_Pdelay_Resp_Follow_Up:
+    case PTPV2_MSG_Announce: time_on = 1; break;
+    case PTPV2_MSG_Signaling:
+    case PTPV2_MSG_Management: time_on = -1; break;
+    default: time_on = !ctx->one_step_clock; break;
+    }
+    if ((time_on>=0)&&memcmp(&msg[34], (time_on) ? ts : zero, 10)) return 1;
+    switch (type) {
+    case PTPV2_MSG_Pdelay_Req:
+         if (memcmp(&msg[44], zero, 10)) return 1;
+         break;
+    case PTPV2_MSG_Pdelay_Resp:
+    case PTPV2_MSG_Delay_Resp:
+    case PTPV2_MSG_Pdelay_Resp_Follow_Up: port_off = 44; break;
+    case PTPV2_MSG_Signaling: port_off = 34; break;
+    case PTPV2_MSG_Management:
+         port_off = 34;
+         if ((msg[44]!=ctx->boundary_hops)||(msg[45]!=ctx->boundary_hops)||(msg[46]!=ctx->action)||msg[47]) return 1;
+         break;
+    case PTPV2_MSG_Announce:
+         if ((((msg[44]<<8)|msg[45])!=ctx->utc_offset)||msg[46]||(msg[47]!=ctx->gm_priority1)||
+             (msg[48]!=ctx->gm_clock_class)||(msg[49]!=ctx->gm_clock_accuracy)||
+             (((msg[50]<<8)|msg[51])!=ctx->gm_clock_variance)||(msg[52]!=ctx->gm_priority2)||
+             (msg[53]!=(ctx->gm_identity>>56))||(msg[60]!=(ctx->gm_identity&0xFF))||
+             (((msg[61]<<8)|msg[62])!=ctx->steps_removed)||(msg[63]!=ctx->time_source)) return 1;
+         break;
+    }
+    if (port_off&&memcmp(&msg[port_off], port, sizeof(PortIdentity_t))) return 1;
+    tlv = ctx->tlv[type];
+    if (memcmp(&msg[ptp_len[idx]], tlv, ctx->tlv_len[type])) return 1;
+    return 0;
+}
+
+//----------------------------------------------------------------------------
+// It builds all message types over Ethernet and UDP/IP with and without TLVs,
+// checks their fields, and checks that templates give the same frames
+// as those built fully.
+// Return 0 on success, 1 on failure
+int test_ptpv2(void)
+{
+    ptpv2_ctx_t *ctx = get_ptpv2_context();
+    ptpv2_ctx_t *saved;
+    ptpv2_template_t *tpl;
+    ptpv2_msg_hdr_t hdr;
+    Timestamp_t time, next;
+    PortIdentity_t port;
+    uint8_t value[8];
+    int idx, idy, pass, one_step, udp, tags, crc, pre, bnum, xnum, msg, err=0;
+
+    my_srand(24);
+    saved = (ptpv2_ctx_t*)malloc(sizeof(ptpv2_ctx_t));
+    memcpy(saved, ctx, sizeof(ptpv2_ctx_t));
+    set_ptpv2_announce(ctx, 37, 100, 6, 0x21, 0x4E5D, 110, 0x0011223344556677ULL, 3, 0x20);
+    set_ptpv2_management(ctx, PTPV2_MGT_SET, 4);
+    for (idx=0; idx<8; idx++) port.clockIdentity[idx] = 0xA0+idx;
+    port.portNumber = htons(0x0102);
+    for (pass=0; pass<2; pass++) {
+    if (pass==1) {
+        for (idx=0; idx<8; idx++) value[idx] = 0x10+idx;
+        if ((add_ptpv2_tlv(ctx, PTPV2_MSG_Announce, PTPV2_TLV_PATH_TRACE, value, 8)!=12)||
+            (add_ptpv2_tlv(ctx, PTPV2_MSG_Signaling, PTPV2_TLV_REQUEST_UNICAST_TRANSMISSION, value, 6)!=10)||
+            (add_ptpv2_tlv(ctx, PTPV2_MSG_Signaling, PTPV2_TLV_ORGANIZATION_EXTENSION, value, 3)!=18)||
+            (add_ptpv2_tlv(ctx, PTPV2_MSG_Management, PTPV2_TLV_MANAGEMENT, NULL, 2)!=6)||
+            (add_ptpv2_tlv(ctx, PTPV2_MSG_Follow_Up, PTPV2_TLV_ORGANIZATION_EXTENSION, value, 8)!=12)) {
+            printf("PTPv2 error: TLV\n");
+            err = 1;
+        }
+        if ((ctx->tlv[PTPV2_MSG_Signaling][13]!=4)||(ctx->tlv[PTPV2_MSG_Signaling][17]!=0)||
+            (fill_ptpv2_msg_hdr(&hdr, PTPV2_MSG_Signaling, 0, 0, 0, 0, 0)!=(44+18))) {
+            printf("PTPv2 error: TLV padding\n");
+            err = 1;
+        }
+    }
+    for (one_step=0; one_step<=1; one_step++) {
+    ctx->one_step_clock = one_step;
+    for (idx=0; idx<(int)sizeof(ptp_type); idx++) {
+    for (idy=0; idy<4*(PKT_VLAN_MAX+1)*2; idy++) {
+         udp  = idy&1;
+         crc  = (idy>>1)&1;
+         pre  = (idy>>2)&1;
+         tags = (idy>>3)%(PKT_VLAN_MAX+1);
+         msg  = ((pre) ? 8 : 0)+ETH_HDR_LEN+tags*ETH_VLAN_TAG_LEN+((udp) ? IP_HDR_LEN+UDP_HDR_LEN : 0);
+         time.secondsField.msb = my_rand()&0xFFFF;
+         time.secondsField.lsb = my_rand();
+         time.nanosecondsField = my_rand()%1000000000;
+         bnum = ptp_build(frame, udp, tags, ptp_type[idx], 0x5678, &time, &port, crc, pre);
+         if ((bnum<=0)||(crc&&check_eth_crc(&frame[(pre) ? 8 : 0], bnum-((pre) ? 8 : 0)))||
+             ptp_check(&frame[msg], idx, &time, &port)||
+             ptp_dest(&frame[(pre) ? 8 : 0], udp, tags, ptp_type[idx])) {
+             printf("PTPv2 error: type 0x%X one-step %d udp %d tags %d\n", ptp_type[idx], one_step, udp, tags);
+             err = 1;
+             continue;
+         }
+         //------------------------------------------------------------------
+         // template patches sequenceId and timestamp only
+         fill_ptpv2_msg_hdr(&hdr, ptp_type[idx], 0x0200, 0x1234, 0x0011223344556677ULL, 1, 0);
+         tpl = ptpv2_template_create(ctx, mac_src, &vlan_tags[PKT_VLAN_MAX-tags], tags, udp, ip_src
+                                    , &hdr, &time, &port, crc, pre);
+         next.secondsField.msb = time.secondsField.msb;
+         next.secondsField.lsb = time.secondsField.lsb+1;
+         next.nanosecondsField = (time.nanosecondsField+125000000)%1000000000;
+         xnum = ptp_build(expect, udp, tags, ptp_type[idx], 0xBEEF, &next, &port, crc, pre);
+         if ((tpl==NULL)||(ptpv2_template_emit(tpl, frame, 0xBEEF, &next)!=xnum)||
+             memcmp(frame, expect, xnum)) {
+             printf("PTPv2 error: template 0x%X one-step %d udp %d tags %d\n", ptp_type[idx], one_step, udp, tags);
+             err = 1;
+         }
+         xnum = ptp_build(expect, udp, tags, ptp_type[idx], 0x0001, &next, &port, crc, pre);
+         if ((tpl!=NULL)&&((ptpv2_template_emit(tpl, frame, 0x0001, NULL)!=xnum)||
+             memcmp(frame, expect, xnum))) {
+             printf("PTPv2 error: template 0x%X keeps time\n", ptp_type[idx]);
+             err = 1;
+         }
+         ptpv2_template_release(tpl);
+    }}}}
+    //-----------------------------------------------------------------------
+    // target of all ports, requesting port of zero and no room for TLVs
+    fill_ptpv2_msg_hdr(&hdr, PTPV2_MSG_Signaling, 0, 0, 0, 0, 0);
+    bnum = gen_ptpv2_msg_signaling(ctx, frame, &hdr, &time, NULL);
+    if ((bnum!=(44+18))||(frame[34]!=0xFF)||(frame[43]!=0xFF)) err = 1;
+    fill_ptpv2_msg_hdr(&hdr, PTPV2_MSG_Pdelay_Resp, 0, 0, 0, 0, 0);
+    bnum = gen_ptpv2_msg_pdelay_resp(ctx, frame, &hdr, &time, NULL);
+    if ((bnum!=54)||frame[44]||frame[53]) err = 1;
+    for (idx=0; add_ptpv2_tlv(ctx, PTPV2_MSG_Sync, PTPV2_TLV_PATH_TRACE, NULL, 96)>0; idx++);
+    if ((idx!=(PTPV2_TLV_MAX/100))||(fill_ptpv2_msg_hdr(&hdr, PTPV2_MSG_Sync, 0, 0, 0, 0, 0)!=(44+idx*100))) err = 1;
+    for (idx=0; idx<16; idx++) clear_ptpv2_tlv(ctx, idx);
+    if (fill_ptpv2_msg_hdr(&hdr, PTPV2_MSG_Management, 0, 0, 0, 0, 0)!=48) err = 1;
+    memcpy(ctx, saved, sizeof(ptpv2_ctx_t));
+    free(saved);
+    if (err) printf("PTPv2 error\n");
+    else     printf("PTPv2 OK\n");
+    return err;
+}
+
+//----------------------------------------------------------------------------
+// It measures messages per second of each type over UDP/IP with FCS,
+// where each is built fully or emitted from a template.
+int test_ptpv2_bench(void)
+{
+    static const char *name[] = { "Sync", "Delay_Req", "Pdelay_Req", "Pdelay_Resp"
+                                , "Follow_Up", "Delay_Resp", "Pdelay_Resp_FU"
+                                , "Announce", "Signaling", "Management" };
+    ptpv2_template_t *tpl;
+    ptpv2_msg_hdr_t hdr;
+    Timestamp_t time;
+    PortIdentity_t port;
+    volatile int dummy=0;
+    int idx, idy, num, pass;
+    double sec, rate[2];
+    clock_t start;
+
+    memset(&port, 0, sizeof(port));
+    memset(&time, 0, sizeof(time));
+    printf("%-16s%10s%10s\n", "PTPv2", "build", "template");
+    for (idx=0; idx<(int)sizeof(ptp_type); idx++) {
+         fill_ptpv2_msg_hdr(&hdr, ptp_type[idx], 0, 0, 0x0011223344556677ULL, 1, 0);
+         tpl = ptpv2_template_create(get_ptpv2_context(), mac_src, NULL, 0, 1, ip_src
+                                    , &hdr, &time, &port, 1, 0);
+         if (tpl==NULL) return 1;
+         num = 1<<20;
+         for (pass=0; pass<2; pass++) {
+              start = clock();
+              for (idy=0; idy<num; idy++) {
+                   time.secondsField.lsb = idy>>3;
+                   time.nanosecondsField = (idy&7)*125000000;
+                   if (pass) dummy ^= ptpv2_template_emit(tpl, frame, idy, &time);
+                   else      dummy ^= ptp_build(frame, 1, 0, ptp_type[idx], idy, &time, &port, 1, 0);
+              }
+              sec = (double)(clock()-start)/CLOCKS_PER_SEC;
+              if (sec<=0.0) sec = 1.0/CLOCKS_PER_SEC;
+              rate[pass] = (double)num/sec/1.0e6;
+         }
+         printf("%-16s%10.2f%10.2f M msgs/sec\n", name[idx], rate[0], rate[1]);
+         ptpv2_template_release(tpl);
+    }
+    return dummy&0;
+}
+
+//----------------------------------------------------------------------------
+static uint8_t  mac_peer[6] = { 0x02, 0xDD, 0x00, 0x00, 0x00, 0x01 };
+static uint32_t ip_peer     = 0x0A000001;
+
+// message types of each exchange for two-step clock, one-step drops the last of Sync and Pdelay
+static const uint8_t seq_type[3][3] = {
+    { PTPV2_MSG_Sync     , PTPV2_MSG_Follow_Up , 0 },
+    { PTPV2_MSG_Delay_Req, PTPV2_MSG_Delay_Resp, 0 },
+    { PTPV2_MSG_Pdelay_Req, PTPV2_MSG_Pdelay_Resp, PTPV2_MSG_Pdelay_Resp_Follow_Up }
+};
+
+//----------------------------------------------------------------------------
+// It checks message 'idx' of an exchange of 'kind' that started at 'ns'.
+static int seq_check( const uint8_t *pkt, int bnum, int eth, int msg, int kind, int idx
+                    , uint16_t seq_id, uint64_t ns, uint32_t delay, uint32_t turnaround
+                    , PortIdentity_t *port_src, PortIdentity_t *port_peer, int one_step)
+{
+    uint8_t ts[10];
+    uint8_t type = seq_type[kind][idx];
+    uint64_t sec, corr;
+    int resp = (idx>0)&&(kind!=PTPV2_SEQ_SYNC);
+    int ts_on;
+
+    if (resp) ns += delay;
+    if (idx==2) ns += turnaround;
+    sec = ns/1000000000;
+    ts[0] = sec>>40; ts[1] = sec>>32; ts[2] = sec>>24; ts[3] = sec>>16; ts[4] = sec>>8; ts[5] = sec;
+    ns %= 1000000000;
+    ts[6] = ns>>24; ts[7] = ns>>16; ts[8] = ns>>8; ts[9] = ns;
+    corr = ((type==PTPV2_MSG_Pdelay_Resp)&&one_step) ? (uint64_t)turnaround<<16 : 0;
+
+    if (check_eth_crc((uint8_t*)&pkt[eth], bnum-eth)) return 1;
+    if (memcmp(&pkt[eth+6], (resp) ? mac_peer : mac_src, 6)) return 1;
+    if (((pkt[msg]&0xF)!=type)||(((pkt[msg+30]<<8)|pkt[msg+31])!=seq_id)) return 1;
+    if ((type==PTPV2_MSG_Sync)||(type==PTPV2_MSG_Pdelay_Resp)) {
+        if (((((pkt[msg+6]<<8)|pkt[msg+7])&PTPV2_MSG_FLAG_twoStepFlag)!=0)==one_step) return 1;
+    }
+    for (idx=0; idx<8; idx++) if (pkt[msg+8+idx]!=((corr>>(8*(7-idx)))&0xFF)) return 1;
+    if (memcmp(&pkt[msg+20], (resp) ? port_peer : port_src, sizeof(PortIdentity_t))) return 1;
+    ts_on = (type==PTPV2_MSG_Follow_Up)||(type==PTPV2_MSG_Delay_Resp)||
+            (type==PTPV2_MSG_Pdelay_Resp_Follow_Up)||!one_step;
+    for (idx=0; idx<10; idx++) if (pkt[msg+34+idx]!=((ts_on) ? ts[idx] : 0)) return 1;
+    if (resp&&memcmp(&pkt[msg+44], port_src, sizeof(PortIdentity_t))) return 1;
+    return 0;
+}
+
+//----------------------------------------------------------------------------
+// It emits exchanges of Sync, Delay and Pdelay for one-step and two-step clock,
+// and checks sequenceId, timestamps advanced over second boundaries,
+// ports and correctionField of each message.
+// Return 0 on success, 1 on failure
+int test_ptpv2_sequence(void)
+{
+    ptpv2_ctx_t *ctx = get_ptpv2_context();
+    ptpv2_sequence_t *seq;
+    PortIdentity_t port_src, port_peer;
+    Timestamp_t start;
+    uint64_t ns, interval;
+    uint32_t delay, turnaround, one_step;
+    uint16_t seq_id;
+    int idx, num, kind, udp, tags, pre, eth, msg, bnum, err=0;
+
+    my_srand(25);
+    one_step = ctx->one_step_clock;
+    for (idx=0; idx<8; idx++) port_src.clockIdentity[idx]  = 0xA0+idx;
+    for (idx=0; idx<8; idx++) port_peer.clockIdentity[idx] = 0xB0+idx;
+    port_src.portNumber  = htons(1);
+    port_peer.portNumber = htons(2);
+    for (kind=PTPV2_SEQ_SYNC; kind<=PTPV2_SEQ_PDELAY; kind++) {
+    for (ctx->one_step_clock=0; ctx->one_step_clock<=1; ctx->one_step_clock++) {
+    for (idx=0; idx<2*(PKT_VLAN_MAX+1)*2; idx++) {
+         udp  = idx&1;
+         pre  = (idx>>1)&1;
+         tags = (idx>>2)%(PKT_VLAN_MAX+1);
+         eth  = (pre) ? 8 : 0;
+         msg  = eth+ETH_HDR_LEN+tags*ETH_VLAN_TAG_LEN+((udp) ? IP_HDR_LEN+UDP_HDR_LEN : 0);
+         seq_id     = 0xFFF0+(my_rand()&0x7); // wraps
+         start.secondsField.msb = 0;
+         start.secondsField.lsb = 0xFFFFFFF0+(my_rand()&0x7); // carries to msb
+         start.nanosecondsField = 999000000+my_rand()%1000000;
+         interval   = 125000000+my_rand()%1000;
+         delay      = 1000+my_rand()%100000;
+         turnaround = 500+my_rand()%10000;
+         seq = ptpv2_sequence_create( ctx, kind
+                                    , mac_src, ip_src, &port_src
+                                    , mac_peer, ip_peer, &port_peer
+                                    , &vlan_tags[PKT_VLAN_MAX-tags], tags, udp
+                                    , seq_id, &start, interval, delay, turnaround, 1, pre);
+         if ((seq==NULL)||(seq->num_msg!=((kind==PTPV2_SEQ_PDELAY) ? 3 : 2)-
+                                          ((kind!=PTPV2_SEQ_DELAY)&&ctx->one_step_clock))) {
+             printf("PTPv2 error: sequence %d create\n", kind);
+             ptpv2_sequence_release(seq);
+             err = 1;
+             continue;
+         }
+         ns = (((uint64_t)start.secondsField.msb<<32)|start.secondsField.lsb)*1000000000ULL
+            + start.nanosecondsField;
+         for (num=0; num<20*seq->num_msg; num++) {
+              bnum = ptpv2_sequence_emit(seq, frame);
+              if (seq_check(frame, bnum, eth, msg, kind, num%seq->num_msg
+                           , seq_id+num/seq->num_msg, ns+(num/seq->num_msg)*interval
+                           , delay, turnaround, &port_src, &port_peer, ctx->one_step_clock)) {
+                  printf("PTPv2 error: sequence %d one-step %d udp %d tags %d message %d\n"
+                        , kind, ctx->one_step_clock, udp, tags, num);
+                  err = 1;
+                  break;
+              }
+         }
+         ptpv2_sequence_release(seq);
+    }}}
+    ctx->one_step_clock = one_step;
+    if (ptpv2_sequence_create(ctx, 3, mac_src, ip_src, NULL, mac_peer, ip_peer, NULL
+                             , NULL, 0, 1, 0, &start, 0, 0, 0, 1, 0)!=NULL) err = 1;
+    if (err) printf("PTPv2 sequence error\n");
+    else     printf("PTPv2 sequence OK\n");
+    return err;
+}
+
+//----------------------------------------------------------------------------
+// It measures exchanges per second of two-step clock over UDP/IP with FCS,
+// where each message is built fully or emitted from the sequence.
+int test_ptpv2_sequence_bench(void)
+{
+    static const char *name[] = { "Sync+Follow_Up", "Delay", "Pdelay" };
+    ptpv2_ctx_t *ctx = get_ptpv2_context();
+    ptpv2_sequence_t *seq;
+    PortIdentity_t port;
+    Timestamp_t time;
+    volatile int dummy=0;
+    uint32_t one_step;
+    int kind, idx, idy, num, pass;
+    double sec, rate[2];
+    clock_t start;
+
+    one_step = ctx->one_step_clock;
+    ctx->one_step_clock = 0;
+    memset(&port, 0, sizeof(port));
+    memset(&time, 0, sizeof(time));
+    printf("%-16s%10s%10s\n", "PTPv2 exchange", "build", "sequence");
+    for (kind=PTPV2_SEQ_SYNC; kind<=PTPV2_SEQ_PDELAY; kind++) {
+         seq = ptpv2_sequence_create(ctx, kind, mac_src, ip_src, &port, mac_peer, ip_peer, &port
+                                    , NULL, 0, 1, 0, &time, 125000000, 1000, 500, 1, 0);
+         if (seq==NULL) return 1;
+         num = 1<<19;
+         for (pass=0; pass<2; pass++) {
+              start = clock();
+              for (idx=0; idx<num; idx++) {
+              for (idy=0; idy<seq->num_msg; idy++) {
+                   if (pass) {
+                       dummy ^= ptpv2_sequence_emit(seq, frame);
+                   } else {
+                       time.secondsField.lsb = idx>>3;
+                       time.nanosecondsField = (idx&7)*125000000+idy*1000;
+                       dummy ^= ptp_build(frame, 1, 0, seq_type[kind][idy], idx, &time, &port, 1, 0);
+                   }
+              }}
+              sec = (double)(clock()-start)/CLOCKS_PER_SEC;
+              if (sec<=0.0) sec = 1.0/CLOCKS_PER_SEC;
+              rate[pass] = (double)num/sec/1.0e6;
+         }
+         printf("%-16s%10.2f%10.2f M exchanges/sec\n", name[kind], rate[0], rate[1]);
+         ptpv2_sequence_release(seq);
+    }
+    ctx->one_step_clock = one_step;
+    return dummy&0;
+}
+
+//----------------------------------------------------------------------------
@@ -0,0 +1,220 @@
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include "eth_ip_udp_tcp_pkt.h"
+#include "test_util.h"
+#include "pkt_segment.h"
+#include "pkt_reasm.h"
+
+//----------------------------------------------------------------------------
+extern uint32_t ip_src;
+extern uint32_t ip_dst;
+
+//----------------------------------------------------------------------------
+#define REASM_FLOWS   4096
+#define REASM_PAYLOAD 3000
+#define REASM_FRAG    ((REASM_PAYLOAD+7)/8)
+
+static uint8_t payload[REASM_PAYLOAD+REASM_FLOWS];
+static pkt_ip_frag_t frag[REASM_FRAG];
+
+//----------------------------------------------------------------------------
+// A fragment as IP packet.
+typedef struct reasm_pkt {
+    uint8_t *ip;
+    int      leng;
+} reasm_pkt_t;
+
+//----------------------------------------------------------------------------
+// It cuts datagram of 'pleng' bytes of 'payload+flow' into fragments
+// and appends them to 'list' from 'num'; returns num of them in 'list'.
+static int reasm_make( reasm_pkt_t *list, int num, int flow, int pleng, int mtu)
+{
+    int idx, cnt;
+    cnt = gen_ip_fragments( frag, REASM_FRAG, ip_src, ip_dst+flow, IP_PROTO_UDP, 64
+                          , (uint16_t)flow, mtu, pleng, &payload[flow]);
+    for (idx=0; idx<cnt; idx++, num++) {
+         list[num].leng = IP_HDR_LEN+frag[idx].iov[1].len;
+         list[num].ip   = (uint8_t*)malloc(list[num].leng);
+         memcpy(list[num].ip, frag[idx].hdr, IP_HDR_LEN);
+         memcpy(list[num].ip+IP_HDR_LEN, frag[idx].iov[1].base, frag[idx].iov[1].len);
+    }
+    return num;
+}
+
+//----------------------------------------------------------------------------
+// It checks reassembled datagram of 'bnum' bytes.
+static int reasm_check(const uint8_t *ip, int bnum, const int *pleng)
+{
+    int flow = (int)(((ip[16]<<24)|(ip[17]<<16)|(ip[18]<<8)|ip[19])-ip_dst);
+    if ((flow<0)||(flow>=REASM_FLOWS)||
+        (bnum!=(IP_HDR_LEN+pleng[flow]))||(((ip[2]<<8)|ip[3])!=bnum)||
+        (((ip[4]<<8)|ip[5])!=flow)||ip[6]||ip[7]||
+        check_ip_checksum((ip_hdr_t*)ip)||
+        memcmp(&ip[IP_HDR_LEN], &payload[flow], pleng[flow])) return 1;
+    return 0;
+}
+
+//----------------------------------------------------------------------------
+// It reassembles datagrams of thousands of flows from fragments in
+// random order with duplicates and overlaps, where late ones may make
+// a datagram again, and checks timeout and bounds.
+// Return 0 on success, 1 on failure
+int test_reasm(void)
+{
+    static int pleng[REASM_FLOWS], completed[REASM_FLOWS];
+    reasm_pkt_t *list, tmp;
+    pkt_reasm_t *ctx;
+    const uint8_t *dgram;
+    int idx, idy, num=0, done=0, bnum, err=0;
+
+    my_srand(18);
+    for (idx=0; idx<(int)sizeof(payload); idx++) payload[idx] = my_rand()&0xFF;
+    list = (reasm_pkt_t*)malloc(3*REASM_FLOWS*(REASM_PAYLOAD/40+2)*sizeof(reasm_pkt_t));
+    ctx  = pkt_reasm_create(REASM_FLOWS, 64*1024*1024, 0);
+    if ((list==NULL)||(ctx==NULL)) {
+        printf("IP reassembly error: malloc\n");
+        return 1;
+    }
+    //-----------------------------------------------------------------------
+    for (idx=0; idx<REASM_FLOWS; idx++) {
+         pleng[idx] = 9+(int)(my_rand()%(REASM_PAYLOAD-8));
+         num = reasm_make(list, num, idx, pleng[idx], 68+8*(int)(my_rand()%180));
+         if ((idx%8)==0) num = reasm_make(list, num, idx, pleng[idx], 68+8*(int)(my_rand()%180)); // overlaps
+         if ((idx%5)==0) { // duplicate
+             list[num].leng = list[num-1].leng;
+             list[num].ip   = (uint8_t*)malloc(list[num].leng);
+             memcpy(list[num].ip, list[num-1].ip, list[num].leng);
+             num++;
+         }
+    }
+    for (idx=num-1; idx>0; idx--) {
+         idy = (int)(my_rand()%(uint32_t)(idx+1));
+         tmp = list[idx]; list[idx] = list[idy]; list[idy] = tmp;
+    }
+    for (idx=0; idx<num; idx++) {
+         bnum = pkt_reasm_put(ctx, list[idx].ip, list[idx].leng, idx, &dgram);
+         if (bnum>0) {
+             if (reasm_check(dgram, bnum, pleng)) {
+                 printf("IP reassembly error: datagram %d bytes\n", bnum);
+                 err = 1;
+             } else if (!completed[(((dgram[16]<<24)|(dgram[17]<<16)|(dgram[18]<<8)|dgram[19])-ip_dst)]++) done++;
+         }
+         if (ctx->bytes>ctx->max_bytes) err = 1;
+    }
+    if ((done!=REASM_FLOWS)||(ctx->stat.timeouts!=0)||(ctx->stat.drops!=0)||
+        (ctx->stat.errors!=0)||(ctx->stat.overlaps==0)) {
+        printf("IP reassembly error: %d of %d datagrams, stat %llu %llu %llu %llu %llu\n"
+              , done, REASM_FLOWS
+              , (unsigned long long)ctx->stat.datagrams, (unsigned long long)ctx->stat.overlaps
+              , (unsigned long long)ctx->stat.timeouts, (unsigned long long)ctx->stat.drops
+              , (unsigned long long)ctx->stat.errors);
+        err = 1;
+    }
+    //-----------------------------------------------------------------------
+    // not a fragment; remaining are late duplicates and overlaps.
+    tmp.ip = (uint8_t*)malloc(IP_HDR_LEN+100);
+    gen_ip_packet(tmp.ip, ip_src, ip_dst, IP_PROTO_UDP, 64, 100, payload, 0);
+    if ((pkt_reasm_put(ctx, tmp.ip, IP_HDR_LEN+100, 0, &dgram)!=(IP_HDR_LEN+100))||(dgram!=tmp.ip)) {
+        printf("IP reassembly error: not a fragment\n");
+        err = 1;
+    }
+    free(tmp.ip);
+    for (idx=0; idx<num; idx++) free(list[idx].ip);
+    pkt_reasm_release(ctx);
+    //-----------------------------------------------------------------------
+    // timeout, num of flows and num of bytes
+    num = 0;
+    for (idx=0; idx<10; idx++) num = reasm_make(list, num, idx, 2000, 1500); // 2 fragments each
+    ctx = pkt_reasm_create(4, 4*2048, 100);
+    pkt_reasm_put(ctx, list[0].ip, list[0].leng, 0, &dgram);
+    pkt_reasm_put(ctx, list[2].ip, list[2].leng, 50, &dgram);
+    if ((pkt_reasm_put(ctx, list[5].ip, list[5].leng, 120, &dgram)!=0)||
+        (ctx->stat.timeouts!=1)||(ctx->flows!=2)||
+        (pkt_reasm_put(ctx, list[1].ip, list[1].leng, 130, &dgram)!=0)|| // the first is gone
+        (pkt_reasm_put(ctx, list[3].ip, list[3].leng, 140, &dgram)!=(IP_HDR_LEN+2000))) {
+        printf("IP reassembly error: timeout\n");
+        err = 1;
+    }
+    for (idx=0; idx<20; idx+=2) {
+         pkt_reasm_put(ctx, list[idx].ip, list[idx].leng, 140, &dgram);
+         if ((ctx->flows>4)||(ctx->bytes>(4*2048))) err = 1;
+    }
+    if (ctx->stat.drops==0) {
+        printf("IP reassembly error: bounds\n");
+        err = 1;
+    }
+    list[0].ip[7] = 1; list[0].ip[3] -= 1; // MF with 1479 bytes
+    if (pkt_reasm_put(ctx, list[0].ip, list[0].leng-1, 140, &dgram)!=-1) {
+        printf("IP reassembly error: malformed\n");
+        err = 1;
+    }
+    for (idx=0; idx<20; idx++) free(list[idx].ip);
+    pkt_reasm_release(ctx);
+    free(list);
+    if (err) printf("IP reassembly error\n");
+    else     printf("IP reassembly OK\n");
+    return err;
+}
+
+//----------------------------------------------------------------------------
+// It measures fragments per second of reassembly, where fragments of
+// all flows are interleaved so that all of them are in reassembly.
+int test_reasm_bench(void)
+{
+    static const int flows[] = { 1024, 4096, 16384 };
+    reasm_pkt_t *list;
+    pkt_reasm_t *ctx;
+    const uint8_t *dgram;
+    volatile int dummy=0;
+    int idx, idy, idz, num, cnt, rep;
+    double sec;
+    clock_t start;
+
+    list = (reasm_pkt_t*)malloc(4*16384*sizeof(reasm_pkt_t));
+    if (list==NULL) return 1;
+    printf("%-14s", "flows");
+    for (idx=0; idx<(int)(sizeof(flows)/sizeof(flows[0])); idx++) printf("%8d", flows[idx]);
+    printf("\n");
+    printf("%-14s", "reassembly");
+    for (idx=0; idx<(int)(sizeof(flows)/sizeof(flows[0])); idx++) {
+         //-------------------------------------------------------------------
+         // 4 fragments of 576-byte MTU for each flow, interleaved
+         for (idy=0; idy<flows[idx]; idy++) {
+              gen_ip_fragments( frag, REASM_FRAG, ip_src, ip_dst+idy, IP_PROTO_UDP, 64
+                              , (uint16_t)idy, 576, 2000, payload);
+              for (idz=0; idz<4; idz++) {
+                   reasm_pkt_t *pt = &list[idz*flows[idx]+idy];
+                   pt->leng = IP_HDR_LEN+frag[idz].iov[1].len;
+                   pt->ip   = (uint8_t*)malloc(pt->leng);
+                   memcpy(pt->ip, frag[idz].hdr, IP_HDR_LEN);
+                   memcpy(pt->ip+IP_HDR_LEN, frag[idz].iov[1].base, frag[idz].iov[1].len);
+              }
+         }
+         num = 4*flows[idx];
+         ctx = pkt_reasm_create(flows[idx], 64*1024*1024, 0);
+         cnt = 0;
+         rep = (1<<21)/num;
+         start = clock();
+         for (idy=0; idy<rep; idy++) {
+              for (idz=0; idz<num; idz++) {
+                   if (pkt_reasm_put(ctx, list[idz].ip, list[idz].leng, idz, &dgram)>0) dummy ^= dgram[10];
+              }
+              cnt += num;
+         }
+         sec = (double)(clock()-start)/CLOCKS_PER_SEC;
+         if (sec<=0.0) sec = 1.0/CLOCKS_PER_SEC;
+         printf("%8.2f", (double)cnt/sec/1.0e6);
+         pkt_reasm_release(ctx);
+         for (idz=0; idz<num; idz++) free(list[idz].ip);
+    }
+    printf(" M fragments/sec\n");
+    free(list);
+    return dummy&0;
+}
+
+//----------------------------------------------------------------------------
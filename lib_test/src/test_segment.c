@@ -0,0 +1,178 @@
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#if defined(__x86_64__)||defined(__i386__)
+#include <x86intrin.h>
+#define SEG_CYCLES() __rdtsc()
+#elif defined(_M_X64)||defined(_M_IX86)
+#include <intrin.h>
+#define SEG_CYCLES() __rdtsc()
+#else
+#define SEG_CYCLES() ((uint64_t)clock()) // clock ticks instead of cycles
+#endif
+#include "eth_ip_udp_tcp_pkt.h"
+#include "test_util.h"
+#include "pkt_segment.h"
+
+//----------------------------------------------------------------------------
+extern uint8_t  mac_src[6];
+extern uint8_t  mac_dst[6];
+extern uint32_t ip_src;
+extern uint32_t ip_dst;
+extern uint16_t port_src;
+extern uint16_t port_dst;
+
+//----------------------------------------------------------------------------
+#define SEG_PAYLOAD  (64*1024)
+#define SEG_MAX      (SEG_PAYLOAD/64+1)
+#define SEG_STRIDE   PKT_SEGMENT_FRAME_MAX(1460)
+
+static uint8_t payload[SEG_PAYLOAD], frames[SEG_PAYLOAD+SEG_MAX*128];
+static uint8_t ref[SEG_STRIDE];
+static int     leng[SEG_MAX];
+
+//----------------------------------------------------------------------------
+// It checks segment 'idx' of 'num', i.e., length, IP ID, sequence number,
+// flags, payload, checksums and FCS.
+static int seg_check( const uint8_t *frame, int bnum, int idx, int num
+                    , int mss, int pleng, int crc, int pre)
+{
+    pseudo_ip_hdr_t piphdr;
+    uint8_t pkt[SEG_STRIDE];
+    uint8_t *ip, *tcp;
+    int len = ((pleng-idx*mss)<mss) ? (pleng-idx*mss) : mss;
+    int min = (crc&&(len<6)) ? 6 : len;
+    uint32_t seq;
+    uint8_t ctl = TCP_FLAG_ACK|((idx==(num-1)) ? (TCP_FLAG_PSH|TCP_FLAG_FIN) : 0);
+
+    pre = (pre) ? 8 : 0;
+    memcpy(pkt, frame, bnum);
+    ip  = &pkt[pre+ETH_HDR_LEN];
+    tcp = &ip[IP_HDR_LEN];
+    seq = ((uint32_t)tcp[4]<<24)|((uint32_t)tcp[5]<<16)|((uint32_t)tcp[6]<<8)|tcp[7];
+    populate_pseudo_ip_hdr(&piphdr, ip_src, ip_dst, IP_PROTO_TCP, TCP_HDR_LEN+len);
+    if ((bnum!=(pre+ETH_HDR_LEN+IP_HDR_LEN+TCP_HDR_LEN+min+((crc) ? 4 : 0)))||
+        (((ip[4]<<8)|ip[5])!=((0xFFF0+idx)&0xFFFF))||
+        (seq!=(0xFFFFF000+(uint32_t)(idx*mss)))||(tcp[13]!=ctl)||
+        memcmp(&tcp[TCP_HDR_LEN], &payload[idx*mss], len)||
+        check_ip_checksum((ip_hdr_t*)ip)||
+        check_tcp_checksum(&piphdr, (tcp_hdr_t*)tcp)||
+        (crc&&check_eth_crc(&pkt[pre], bnum-pre))) {
+        printf("TCP segment error: segment %d of %d mss=%d leng=%d\n", idx, num, mss, pleng);
+        return 1;
+    }
+    return 0;
+}
+
+//----------------------------------------------------------------------------
+// It cuts payload into segments in 2-D memory and in a stream,
+// and checks each segment.
+// Return 0 on success, 1 on failure
+int test_segment(void)
+{
+    static const int mss[] = { 1, 5, 64, 536, 1460 };
+    int idx, idy, num, pleng, crc, pre, off, err=0;
+
+    my_srand(16);
+    for (idx=0; idx<SEG_PAYLOAD; idx++) payload[idx] = my_rand()&0xFF;
+    for (idx=0; idx<200; idx++) {
+         int m = mss[idx%(sizeof(mss)/sizeof(mss[0]))];
+         pleng = (idx<50) ? idx : (int)(my_rand()%(((m*64)<SEG_PAYLOAD) ? (m*64+1) : SEG_PAYLOAD));
+         crc = (idx&1)!=0;
+         pre = (idx&2)!=0;
+         //-------------------------------------------------------------------
+         num = gen_eth_ip_tcp_segments( frames, (idx&4) ? 0 : SEG_STRIDE, leng, SEG_MAX
+                                      , mac_src, mac_dst, ip_src, ip_dst, 0xFFF0
+                                      , port_src, port_dst, 0xFFFFF000, 0x12345678
+                                      , TCP_FLAG_ACK, TCP_FLAG_PSH|TCP_FLAG_FIN
+                                      , m, pleng, payload, crc, pre);
+         if (num!=pkt_tcp_segment_num(pleng, m)) {
+             printf("TCP segment error: num=%d mss=%d leng=%d\n", num, m, pleng);
+             err = 1;
+             continue;
+         }
+         for (idy=0, off=0; idy<num; idy++) {
+              err |= seg_check(&frames[off], leng[idy], idy, num, m, pleng, crc, pre);
+              off += (idx&4) ? leng[idy] : SEG_STRIDE;
+         }
+         //-------------------------------------------------------------------
+         // the first segment is the same as the single segment builder
+         // except for IP ID and flags
+         if (pleng>0) {
+             int len = (pleng<m) ? pleng : m;
+             int bnum = gen_eth_ip_tcp_packet( ref, mac_src, mac_dst, ip_src, ip_dst
+                                             , port_src, port_dst, 0xFFFFF000, 0x12345678
+                                             , len, payload, 1, crc, pre);
+             num = gen_eth_ip_tcp_segments( frames, 0, leng, SEG_MAX
+                                          , mac_src, mac_dst, ip_src, ip_dst, 0
+                                          , port_src, port_dst, 0xFFFFF000, 0x12345678
+                                          , 0, 0, m, pleng, payload, crc, pre);
+             if ((num<1)||(leng[0]!=bnum)||memcmp(frames, ref, bnum)) {
+                 printf("TCP segment error: first segment mss=%d leng=%d\n", m, pleng);
+                 err = 1;
+             }
+         }
+    }
+    //-----------------------------------------------------------------------
+    if ((gen_eth_ip_tcp_segments( frames, 0, leng, 2, mac_src, mac_dst, ip_src, ip_dst, 0
+                                , port_src, port_dst, 0, 0, 0, 0, 100, 201, payload, 1, 0)!=-1)||
+        (gen_eth_ip_tcp_segments( frames, 100, leng, SEG_MAX, mac_src, mac_dst, ip_src, ip_dst, 0
+                                , port_src, port_dst, 0, 0, 0, 0, 100, 201, payload, 1, 0)!=-1)||
+        (pkt_tcp_segment_num(10, 0)!=-1)||(pkt_tcp_segment_num(0, 1460)!=1)) {
+        printf("TCP segment error: limits\n");
+        err = 1;
+    }
+    if (err) printf("TCP segment error\n");
+    else     printf("TCP segment OK\n");
+    return err;
+}
+
+//----------------------------------------------------------------------------
+// It measures cutting 64 KiB payload into MSS-byte segments
+// by calling gen_eth_ip_tcp_packet() for each and by one call.
+int test_segment_bench(void)
+{
+    static const int mss[] = { 536, 1460, 8960 };
+    volatile uint8_t dummy=0;
+    uint64_t start, cycles;
+    int pass, idx, idy, idz, num, len;
+
+    for (idx=0; idx<SEG_PAYLOAD; idx++) payload[idx] = my_rand()&0xFF;
+    printf("%-14s", "mss");
+    for (idx=0; idx<(int)(sizeof(mss)/sizeof(mss[0])); idx++) printf("%8d", mss[idx]);
+    printf("\n");
+    for (pass=0; pass<2; pass++) {
+         printf("%-14s", (pass==0) ? "per segment" : "segmentation");
+         for (idx=0; idx<(int)(sizeof(mss)/sizeof(mss[0])); idx++) {
+              num = 512;
+              start = SEG_CYCLES();
+              for (idy=0; idy<num; idy++) {
+                   if (pass==0) {
+                       uint8_t *frame = frames;
+                       for (idz=0; idz<SEG_PAYLOAD; idz+=mss[idx]) {
+                            len = ((SEG_PAYLOAD-idz)<mss[idx]) ? (SEG_PAYLOAD-idz) : mss[idx];
+                            frame += gen_eth_ip_tcp_packet( frame, mac_src, mac_dst, ip_src, ip_dst
+                                                          , port_src, port_dst, idz, 0
+                                                          , len, &payload[idz], 1, 1, 0);
+                       }
+                   } else {
+                       gen_eth_ip_tcp_segments( frames, 0, leng, SEG_MAX
+                                              , mac_src, mac_dst, ip_src, ip_dst, 0
+                                              , port_src, port_dst, 0, 0
+                                              , TCP_FLAG_ACK, TCP_FLAG_PSH
+                                              , mss[idx], SEG_PAYLOAD, payload, 1, 0);
+                   }
+                   dummy ^= frames[ETH_HDR_LEN+IP_HDR_LEN+16];
+              }
+              cycles = SEG_CYCLES()-start;
+              printf("%8.3f", (double)cycles/((double)num*SEG_PAYLOAD));
+         }
+         printf(" cycles/byte\n");
+    }
+    return (int)(dummy&0);
+}
+
+//----------------------------------------------------------------------------
@@ -0,0 +1,310 @@
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include "eth_ip_udp_tcp_pkt.h"
+#include "test_util.h"
+#include "pkt_segment.h"
+#include "pkt_stream.h"
+
+//----------------------------------------------------------------------------
+extern uint8_t  mac_src[6];
+extern uint8_t  mac_dst[6];
+extern uint32_t ip_src;
+extern uint32_t ip_dst;
+
+//----------------------------------------------------------------------------
+#define STREAM_CONNS   2048
+#define STREAM_PAYLOAD 8000
+#define STREAM_SEG     (STREAM_PAYLOAD/64+2)
+
+static uint8_t payload[STREAM_PAYLOAD+STREAM_CONNS];
+static uint8_t frames[STREAM_PAYLOAD+STREAM_SEG*(8+ETH_HDR_LEN+IP_HDR_LEN+TCP_HDR_LEN+4)];
+static int     leng[STREAM_SEG];
+
+//----------------------------------------------------------------------------
+// A segment as IP packet.
+typedef struct stream_pkt {
+    uint8_t *ip;
+    int      leng;
+} stream_pkt_t;
+
+// Bytes delivered to each connection, which is known by source port.
+typedef struct stream_rx {
+    uint8_t *data[STREAM_CONNS];
+    int      num[STREAM_CONNS];
+    int      closed[STREAM_CONNS];
+} stream_rx_t;
+
+//----------------------------------------------------------------------------
+static void stream_rx(void *user, pkt_stream_conn_t *conn, const uint8_t *data, int num)
+{
+    stream_rx_t *rx = (stream_rx_t*)user;
+    int idx = conn->port_src-1024;
+    if ((idx<0)||(idx>=STREAM_CONNS)) return;
+    if (num==0) {
+        rx->closed[idx]++;
+        return;
+    }
+    if ((rx->num[idx]+num)<=STREAM_PAYLOAD) memcpy(&rx->data[idx][rx->num[idx]], data, num);
+    rx->num[idx] += num;
+}
+
+//----------------------------------------------------------------------------
+// It cuts bytes from 'off' to 'off+len-1' of stream of connection 'conn'
+// into 'mss'-byte segments from sequence number 'seq', and appends them
+// to 'list' from 'num'; returns num of them in 'list'.
+static int stream_make( stream_pkt_t *list, int num, int conn, uint32_t seq
+                      , int off, int len, int mss, uint8_t flags, uint8_t flags_last)
+{
+    uint8_t *frame=frames;
+    int idx, cnt;
+    cnt = gen_eth_ip_tcp_segments( frames, 0, leng, STREAM_SEG, mac_src, mac_dst
+                                 , ip_src, ip_dst, 0, (uint16_t)(1024+conn), 80
+                                 , seq, 0, flags, flags_last
+                                 , mss, len, &payload[conn+off], 0, 0);
+    for (idx=0; idx<cnt; idx++, num++) {
+         list[num].leng = leng[idx]-ETH_HDR_LEN;
+         list[num].ip   = (uint8_t*)malloc(list[num].leng);
+         memcpy(list[num].ip, frame+ETH_HDR_LEN, list[num].leng);
+         frame += leng[idx];
+    }
+    return num;
+}
+
+//----------------------------------------------------------------------------
+// It reassembles streams of thousands of connections from segments
+// in random order with retransmits and overlaps, and checks window,
+// RST, num of connections and num of bytes.
+// Return 0 on success, 1 on failure
+int test_stream(void)
+{
+    static stream_rx_t rx;
+    static int pleng[STREAM_CONNS];
+    static uint32_t isn[STREAM_CONNS];
+    stream_pkt_t *list, tmp;
+    pkt_stream_t *ctx;
+    pkt_stream_conn_t *conn;
+    uint64_t retransmits=0, overlaps=0, gaps=0, violations=0;
+    int idx, idy, num=0, syn, err=0;
+
+    my_srand(19);
+    for (idx=0; idx<(int)sizeof(payload); idx++) payload[idx] = my_rand()&0xFF;
+    list = (stream_pkt_t*)malloc(4*STREAM_CONNS*STREAM_SEG*sizeof(stream_pkt_t));
+    ctx  = pkt_stream_create(STREAM_CONNS, 64*1024*1024, 65535, stream_rx, (void*)&rx);
+    if ((list==NULL)||(ctx==NULL)) {
+        printf("TCP stream error: malloc\n");
+        return 1;
+    }
+    //-----------------------------------------------------------------------
+    // SYN of all first, and then the others in random order.
+    for (idx=0; idx<STREAM_CONNS; idx++) {
+         rx.data[idx] = (uint8_t*)malloc(STREAM_PAYLOAD);
+         pleng[idx] = 1+(int)(my_rand()%STREAM_PAYLOAD);
+         isn[idx]   = (idx%4) ? my_rand() : 0xFFFFFFFF-(my_rand()%STREAM_PAYLOAD); // wraps
+         num = stream_make(list, num, idx, isn[idx], 0, 0, 1460, TCP_FLAG_SYN, 0);
+    }
+    syn = num;
+    for (idx=0; idx<STREAM_CONNS; idx++) {
+         num = stream_make(list, num, idx, isn[idx]+1, 0, pleng[idx], 64+(int)(my_rand()%1400)
+                          , TCP_FLAG_ACK, TCP_FLAG_FIN);
+         if ((idx%8)==0) { // overlaps
+             idy = (int)(my_rand()%pleng[idx]);
+             num = stream_make(list, num, idx, isn[idx]+1+(uint32_t)idy, idy, pleng[idx]-idy, 64+(int)(my_rand()%1400)
+                              , TCP_FLAG_ACK, 0);
+         }
+         if ((idx%5)==0) { // retransmit
+             list[num].leng = list[num-1].leng;
+             list[num].ip   = (uint8_t*)malloc(list[num].leng);
+             memcpy(list[num].ip, list[num-1].ip, list[num].leng);
+             num++;
+         }
+    }
+    for (idx=num-1; idx>syn; idx--) {
+         idy = syn+(int)(my_rand()%(uint32_t)(idx-syn+1));
+         tmp = list[idx]; list[idx] = list[idy]; list[idy] = tmp;
+    }
+    for (idx=0; idx<num; idx++) {
+         if (pkt_stream_put(ctx, list[idx].ip, list[idx].leng)<0) err = 1;
+         if (ctx->bytes>ctx->max_bytes) err = 1;
+    }
+    for (idx=0; idx<STREAM_CONNS; idx++) {
+         conn = pkt_stream_find(ctx, ip_src, ip_dst, (uint16_t)(1024+idx), 80);
+         if ((conn==NULL)||(rx.num[idx]!=pleng[idx])||(rx.closed[idx]!=1)||
+             memcmp(rx.data[idx], &payload[idx], pleng[idx])||
+             (conn->next_seq!=(isn[idx]+1+(uint32_t)pleng[idx]+1))||conn->ooo_bytes) {
+             printf("TCP stream error: connection %d %d of %d bytes\n", idx, rx.num[idx], pleng[idx]);
+             err = 1;
+             break;
+         }
+         retransmits += conn->retransmits;
+         overlaps    += conn->overlaps;
+         gaps        += conn->gaps;
+         violations  += conn->window_violations;
+    }
+    if ((retransmits==0)||(overlaps==0)||(gaps==0)||(violations!=0)||
+        (ctx->bytes!=0)||(ctx->evictions!=0)) {
+        printf("TCP stream error: %llu retransmits, %llu overlaps, %llu gaps, %llu window violations\n"
+              , (unsigned long long)retransmits, (unsigned long long)overlaps
+              , (unsigned long long)gaps, (unsigned long long)violations);
+        err = 1;
+    }
+    for (idx=0; idx<num; idx++) free(list[idx].ip);
+    pkt_stream_release(ctx);
+    //-----------------------------------------------------------------------
+    // window advertised by the other direction, RST and malformed
+    memset((void*)rx.num, 0, sizeof(rx.num));
+    memset((void*)rx.closed, 0, sizeof(rx.closed));
+    ctx = pkt_stream_create(4, 1000, 65535, stream_rx, (void*)&rx);
+    num = stream_make(list, 0, 0, 1000, 0, 3000, 1000, TCP_FLAG_ACK, 0); // seq 1000, 2000, 3000
+    pkt_stream_put(ctx, list[0].ip, list[0].leng);
+    stream_make(&tmp, 0, 0, 1, 0, 0, 1000, TCP_FLAG_ACK, 0); // the other direction
+    for (idx=0; idx<4; idx++) { // addresses and ports swapped
+         idy = tmp.ip[12+idx]; tmp.ip[12+idx] = tmp.ip[16+idx]; tmp.ip[16+idx] = (uint8_t)idy;
+         if (idx<2) { idy = tmp.ip[IP_HDR_LEN+idx]; tmp.ip[IP_HDR_LEN+idx] = tmp.ip[IP_HDR_LEN+2+idx]; tmp.ip[IP_HDR_LEN+2+idx] = (uint8_t)idy; }
+    }
+    tmp.ip[IP_HDR_LEN+10] = 2000>>8;  // ACK 2000
+    tmp.ip[IP_HDR_LEN+11] = 2000&0xFF;
+    tmp.ip[IP_HDR_LEN+14] = 1000>>8;  // window of 1000 bytes
+    tmp.ip[IP_HDR_LEN+15] = 1000&0xFF;
+    pkt_stream_put(ctx, tmp.ip, tmp.leng);
+    conn = pkt_stream_find(ctx, ip_src, ip_dst, 1024, 80);
+    if ((conn==NULL)||(conn->wnd_end!=3000)||
+        (pkt_stream_put(ctx, list[2].ip, list[2].leng)!=0)|| // beyond window and 1000 bytes kept
+        (conn->window_violations!=1)||(conn->gaps!=1)||(ctx->bytes!=1000)||
+        (pkt_stream_put(ctx, list[2].ip, list[2].leng)!=0)||(conn->retransmits!=1)||
+        (pkt_stream_put(ctx, list[1].ip, list[1].leng)!=2000)||(rx.num[0]!=3000)) {
+        printf("TCP stream error: window\n");
+        err = 1;
+    }
+    list[0].ip[IP_HDR_LEN+13] = TCP_FLAG_RST;
+    if ((pkt_stream_put(ctx, list[0].ip, list[0].leng)!=0)||!conn->closed||(rx.closed[0]!=1)||
+        (pkt_stream_put(ctx, list[1].ip, list[1].leng)!=0)||(rx.num[0]!=3000)) {
+        printf("TCP stream error: RST\n");
+        err = 1;
+    }
+    if ((pkt_stream_put(ctx, tmp.ip, tmp.leng-1)!=-1)|| // shorter than IP length
+        (pkt_stream_put(ctx, tmp.ip, IP_HDR_LEN)!=-1)) {
+        printf("TCP stream error: malformed\n");
+        err = 1;
+    }
+    free(tmp.ip);
+    for (idx=0; idx<num; idx++) free(list[idx].ip);
+    //-----------------------------------------------------------------------
+    // port reused by SYN after RST, and a segment between two kept side by side
+    stream_make(list, 0, 0, 4999, 0, 0, 1000, TCP_FLAG_SYN, 0);
+    stream_make(list, 1, 0, 5100, 100, 200, 100, TCP_FLAG_ACK, 0); // seq 5100, 5200
+    stream_make(list, 3, 0, 5150, 150, 100, 100, TCP_FLAG_ACK, 0); // covered by the two
+    stream_make(list, 4, 0, 5000, 0, 100, 100, TCP_FLAG_ACK, 0);
+    if ((pkt_stream_put(ctx, list[0].ip, list[0].leng)!=0)||conn->closed||(conn->next_seq!=5000)||
+        (pkt_stream_put(ctx, list[1].ip, list[1].leng)!=0)||
+        (pkt_stream_put(ctx, list[2].ip, list[2].leng)!=0)||
+        (pkt_stream_put(ctx, list[3].ip, list[3].leng)!=0)||(conn->gaps!=3)||(ctx->bytes!=200)||
+        (pkt_stream_put(ctx, list[0].ip, list[0].leng)!=0)||(conn->next_seq!=5000)||
+        (pkt_stream_put(ctx, list[4].ip, list[4].leng)!=300)||(rx.num[0]!=3300)||
+        memcmp(&rx.data[0][3000], &payload[0], 300)) {
+        printf("TCP stream error: SYN\n");
+        err = 1;
+    }
+    list[4].ip[IP_HDR_LEN+12] = 0x40; // 16-byte header
+    if (pkt_stream_put(ctx, list[4].ip, list[4].leng)!=-1) {
+        printf("TCP stream error: header length\n");
+        err = 1;
+    }
+    for (idx=0; idx<5; idx++) free(list[idx].ip);
+    //-----------------------------------------------------------------------
+    // num of connections and num of bytes
+    for (idx=0, num=0; idx<10; idx++) {
+         stream_make(list, 0, idx, 0, 0, 1, 600, TCP_FLAG_ACK, 0);
+         stream_make(list, 1, idx, 500, 500, 600, 600, TCP_FLAG_ACK, 0); // beyond a hole
+         pkt_stream_put(ctx, list[0].ip, list[0].leng);
+         pkt_stream_put(ctx, list[1].ip, list[1].leng);
+         conn = pkt_stream_find(ctx, ip_src, ip_dst, (uint16_t)(1024+idx), 80);
+         if ((conn==NULL)||(ctx->conns>4)||(ctx->bytes>1000)) err = 1;
+         else num += (int)conn->drops;
+         free(list[0].ip);
+         free(list[1].ip);
+    }
+    if ((ctx->conns!=4)||(ctx->evictions!=7)||
+        (pkt_stream_find(ctx, ip_src, ip_dst, 1024+9, 80)==NULL)||
+        (pkt_stream_find(ctx, ip_src, ip_dst, 1024+5, 80)!=NULL)) {
+        printf("TCP stream error: connections %d evictions %llu\n", ctx->conns
+              , (unsigned long long)ctx->evictions);
+        err = 1;
+    }
+    if (num==0) {
+        printf("TCP stream error: bytes\n");
+        err = 1;
+    }
+    pkt_stream_release(ctx);
+    for (idx=0; idx<STREAM_CONNS; idx++) free(rx.data[idx]);
+    free(list);
+    if (err) printf("TCP stream error\n");
+    else     printf("TCP stream OK\n");
+    return err;
+}
+
+//----------------------------------------------------------------------------
+// It measures segments per second of reassembly, where segments of
+// all connections are interleaved, in order and out of order.
+int test_stream_bench(void)
+{
+    static const int conns[] = { 1024, 16384, 65536 };
+    stream_pkt_t *list, seg[4], tmp;
+    pkt_stream_t *ctx;
+    volatile int dummy=0;
+    int idx, idy, idz, num, cnt, rep, ooo;
+    double sec;
+    clock_t start;
+
+    list = (stream_pkt_t*)malloc(4*65536*sizeof(stream_pkt_t));
+    if (list==NULL) return 1;
+    printf("%-14s", "connections");
+    for (idx=0; idx<(int)(sizeof(conns)/sizeof(conns[0])); idx++) printf("%8d", conns[idx]);
+    printf("\n");
+    for (ooo=0; ooo<2; ooo++) {
+         printf("%-14s", (ooo) ? "out-of-order" : "in-order");
+         for (idx=0; idx<(int)(sizeof(conns)/sizeof(conns[0])); idx++) {
+              //--------------------------------------------------------------
+              // 4 segments of 256 bytes for each connection, interleaved
+              for (idy=0; idy<conns[idx]; idy++) {
+                   stream_make(seg, 0, 0, 0, 0, 4*256, 256, TCP_FLAG_ACK, 0);
+                   for (idz=0; idz<4; idz++) {
+                        seg[idz].ip[IP_HDR_LEN+0] = (uint8_t)(idy>>8); // port per connection
+                        seg[idz].ip[IP_HDR_LEN+1] = (uint8_t)(idy&0xFF);
+                        list[idz*conns[idx]+idy] = seg[idz];
+                   }
+              }
+              num = 4*conns[idx];
+              if (ooo) { // the 2nd and 3rd swapped
+                  for (idz=0; idz<conns[idx]; idz++) {
+                       tmp = list[conns[idx]+idz];
+                       list[conns[idx]+idz] = list[2*conns[idx]+idz];
+                       list[2*conns[idx]+idz] = tmp;
+                  }
+              }
+              cnt = 0;
+              sec = 0.0;
+              rep = (1<<21)/num;
+              for (idy=0; idy<rep; idy++) {
+                   ctx = pkt_stream_create(conns[idx], 64*1024*1024, 65535, NULL, NULL);
+                   start = clock();
+                   for (idz=0; idz<num; idz++) dummy ^= pkt_stream_put(ctx, list[idz].ip, list[idz].leng);
+                   sec += (double)(clock()-start)/CLOCKS_PER_SEC;
+                   cnt += num;
+                   pkt_stream_release(ctx);
+              }
+              if (sec<=0.0) sec = 1.0/CLOCKS_PER_SEC;
+              printf("%8.2f", (double)cnt/sec/1.0e6);
+              for (idz=0; idz<num; idz++) free(list[idz].ip);
+         }
+         printf(" M segments/sec\n");
+    }
+    free(list);
+    return dummy&0;
+}
+
+//----------------------------------------------------------------------------
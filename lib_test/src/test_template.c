@@ -0,0 +1,214 @@
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include "eth_ip_udp_tcp_pkt.h"
+#include "test_util.h"
+#include "pkt_template.h"
+
+//----------------------------------------------------------------------------
+#define TPL_MAX  1600
+
+//----------------------------------------------------------------------------
+// Fields expected in the template.
+typedef struct tpl_ref {
+    uint8_t  protocol;
+    uint64_t field[PKT_FIELD_NUM];
+    uint8_t  payload[TPL_MAX];
+    int      check;
+    int      add_crc;
+    int      add_preamble;
+} tpl_ref_t;
+
+//----------------------------------------------------------------------------
+static void tpl_mac(uint8_t mac[6], uint64_t value)
+{
+    int idx;
+    for (idx=5; idx>=0; idx--) { mac[idx] = value&0xFF; value >>= 8; }
+}
+
+//----------------------------------------------------------------------------
+// It builds the frame from scratch with full checksum and CRC computation.
+static int tpl_build_ref(tpl_ref_t *ref, uint8_t *packet)
+{
+    uint8_t  mac_src[6], mac_dst[6];
+    uint8_t *eth = (ref->add_preamble) ? &packet[8] : packet;
+    ip_hdr_t *ip_hdr = (ip_hdr_t*)&eth[ETH_HDR_LEN];
+    uint8_t *l4 = &eth[ETH_HDR_LEN+IP_HDR_LEN];
+    int leng = (int)ref->field[PKT_FIELD_BNUM_PAYLOAD];
+    int hdr_len = (ref->protocol==IP_PROTO_UDP) ? UDP_HDR_LEN : TCP_HDR_LEN;
+    pseudo_ip_hdr_t piphdr;
+    uint32_t crc;
+    int idx;
+
+    tpl_mac(mac_src, ref->field[PKT_FIELD_MAC_SRC]);
+    tpl_mac(mac_dst, ref->field[PKT_FIELD_MAC_DST]);
+    if (ref->protocol==IP_PROTO_UDP)
+         gen_eth_ip_udp_packet( packet, mac_src, mac_dst
+                              , ref->field[PKT_FIELD_IP_SRC], ref->field[PKT_FIELD_IP_DST]
+                              , ref->field[PKT_FIELD_PORT_SRC], ref->field[PKT_FIELD_PORT_DST]
+                              , leng, ref->payload, 0, 0, ref->add_preamble);
+    else gen_eth_ip_tcp_packet( packet, mac_src, mac_dst
+                              , ref->field[PKT_FIELD_IP_SRC], ref->field[PKT_FIELD_IP_DST]
+                              , ref->field[PKT_FIELD_PORT_SRC], ref->field[PKT_FIELD_PORT_DST]
+                              , ref->field[PKT_FIELD_SEQ_NUM], ref->field[PKT_FIELD_ACK_NUM]
+                              , leng, ref->payload, 0, 0, ref->add_preamble);
+    ip_hdr->ip_id  = htons(ref->field[PKT_FIELD_IP_ID]);
+    ip_hdr->ip_ttl = ref->field[PKT_FIELD_TTL];
+    ip_hdr->ip_sum = 0;
+    ip_hdr->ip_sum = htons(compute_ip_checksum(ip_hdr));
+    if (ref->check) {
+        populate_pseudo_ip_hdr( &piphdr, ref->field[PKT_FIELD_IP_SRC], ref->field[PKT_FIELD_IP_DST]
+                              , ref->protocol, hdr_len+leng);
+        if (ref->protocol==IP_PROTO_UDP)
+             ((udp_hdr_t*)l4)->udp_sum = htons(compute_udp_checksum(&piphdr, (udp_hdr_t*)l4));
+        else ((tcp_hdr_t*)l4)->tcp_sum = htons(compute_tcp_checksum(&piphdr, (tcp_hdr_t*)l4));
+    }
+    idx = leng;
+    if (ref->add_crc) for (; idx<(46-IP_HDR_LEN-hdr_len); idx++) l4[hdr_len+idx] = 0;
+    idx = ETH_HDR_LEN+IP_HDR_LEN+hdr_len+idx;
+    if (ref->add_crc) {
+        crc = compute_eth_crc_bitwise(eth, idx);
+        memcpy(&eth[idx], &crc, 4);
+        idx += 4;
+    }
+    return idx+((ref->add_preamble) ? 8 : 0);
+}
+
+//----------------------------------------------------------------------------
+// It patches random fields of templates and compares emitted frames
+// with frames built from scratch.
+// Return 0 on success, 1 on failure
+int test_template(void)
+{
+    static tpl_ref_t ref;
+    static uint8_t packet[TPL_MAX+128], expect[TPL_MAX+128], data[16];
+    static const int bits[PKT_FIELD_NUM] = { 48, 48, 16, 8, 32, 32, 16, 16, 32, 32, 0 };
+    pkt_template_t *tpl;
+    uint8_t mac_src[6], mac_dst[6];
+    int idx, idy, idz, field, leng, ref_leng, offset, num, err=0;
+
+    my_srand(1624);
+    for (idx=0; idx<64; idx++) {
+         memset(&ref, 0, sizeof(ref));
+         ref.protocol     = (idx&1) ? IP_PROTO_TCP : IP_PROTO_UDP;
+         ref.check        = (idx&6)!=6;
+         ref.add_crc      = (idx&8)==0;
+         ref.add_preamble = (idx>>4)&1;
+         ref.field[PKT_FIELD_MAC_SRC]  = 0x021122334455ULL;
+         ref.field[PKT_FIELD_MAC_DST]  = 0xF3AABBCCDDEEULL;
+         ref.field[PKT_FIELD_TTL]      = 1;
+         ref.field[PKT_FIELD_IP_SRC]   = my_rand();
+         ref.field[PKT_FIELD_IP_DST]   = my_rand();
+         ref.field[PKT_FIELD_PORT_SRC] = my_rand()&0xFFFF;
+         ref.field[PKT_FIELD_PORT_DST] = my_rand()&0xFFFF;
+         ref.field[PKT_FIELD_BNUM_PAYLOAD] = (idx<8) ? idx : my_rand()%1460;
+         for (idy=0; idy<ref.field[PKT_FIELD_BNUM_PAYLOAD]; idy++) ref.payload[idy] = my_rand()&0xFF;
+         tpl_mac(mac_src, ref.field[PKT_FIELD_MAC_SRC]);
+         tpl_mac(mac_dst, ref.field[PKT_FIELD_MAC_DST]);
+         tpl = pkt_template_create( ref.protocol, mac_src, mac_dst
+                                  , ref.field[PKT_FIELD_IP_SRC], ref.field[PKT_FIELD_IP_DST]
+                                  , ref.field[PKT_FIELD_PORT_SRC], ref.field[PKT_FIELD_PORT_DST]
+                                  , ref.field[PKT_FIELD_BNUM_PAYLOAD], ref.payload, TPL_MAX-64
+                                  , ref.check, ref.add_crc, ref.add_preamble);
+         if (tpl==NULL) {
+             printf("Packet template create error\n");
+             return 1;
+         }
+         for (idy=0; idy<200; idy++) {
+              field = my_rand()%(PKT_FIELD_NUM+1);
+              if (field==PKT_FIELD_NUM) { // payload bytes
+                  leng = ref.field[PKT_FIELD_BNUM_PAYLOAD];
+                  if (leng==0) continue;
+                  offset = my_rand()%leng;
+                  num = (my_rand()&1) ? 8 : 1+(my_rand()%((sizeof(data)<(leng-offset)) ? sizeof(data) : (leng-offset)));
+                  if ((offset+num)>leng) offset = leng-num;
+                  if (offset<0) continue;
+                  for (idz=0; idz<num; idz++) data[idz] = ref.payload[offset+idz] = my_rand()&0xFF;
+                  if (pkt_template_set_payload(tpl, offset, data, num)) err = 1;
+              } else {
+                  uint64_t value;
+                  if ((ref.protocol==IP_PROTO_UDP)&&
+                      ((field==PKT_FIELD_SEQ_NUM)||(field==PKT_FIELD_ACK_NUM))) {
+                      if (!pkt_template_set(tpl, field, 0)) err = 1; // should fail
+                      continue;
+                  }
+                  if (field==PKT_FIELD_BNUM_PAYLOAD) {
+                      value = my_rand()%(TPL_MAX-64+1);
+                      for (idz=ref.field[field]; idz<value; idz++) ref.payload[idz] = 0;
+                  } else {
+                      value = ((uint64_t)my_rand()<<32)|my_rand();
+                      value &= (((uint64_t)1)<<bits[field])-1;
+                  }
+                  ref.field[field] = value;
+                  if (pkt_template_set(tpl, field, value)) err = 1;
+              }
+              memset(packet, 0, sizeof(packet));
+              memset(expect, 0, sizeof(expect));
+              leng = pkt_template_emit(tpl, packet);
+              ref_leng = tpl_build_ref(&ref, expect);
+              if ((leng!=ref_leng)||memcmp(packet, expect, sizeof(packet))) {
+                  printf("Packet template error: field=%d leng=%d:%d\n", field, leng, ref_leng);
+                  err = 1;
+                  break;
+              }
+         }
+         pkt_template_release(tpl);
+    }
+    if (pkt_template_field("seq_num")!=PKT_FIELD_SEQ_NUM) err = 1;
+    if (pkt_template_field("unknown")!=-1) err = 1;
+    if (err) printf("Packet template error\n");
+    else     printf("Packet template OK\n");
+    return err;
+}
+
+//----------------------------------------------------------------------------
+// It measures frames per second of emitting variants of a template
+// compared with building each frame.
+int test_template_bench(void)
+{
+    static uint8_t payload[1472], packet[2048];
+    uint8_t mac_src[6] = { 0x02, 0x11, 0x22, 0x33, 0x44, 0x55};
+    uint8_t mac_dst[6] = { 0xF3, 0xAA, 0xBB, 0xCC, 0xDD, 0xEE};
+    static const int size[] = { 18, 256, 1024, 1460 };
+    volatile uint8_t dummy=0;
+    pkt_template_t *tpl;
+    int pass, idx, idy, num=1<<18;
+    double sec;
+    clock_t start;
+
+    for (idx=0; idx<(int)sizeof(payload); idx++) payload[idx] = my_rand()&0xFF;
+    printf("%-14s", "payload bytes");
+    for (idx=0; idx<(int)(sizeof(size)/sizeof(size[0])); idx++) printf("%8d", size[idx]);
+    printf("\n");
+    for (pass=0; pass<2; pass++) {
+         printf("%-14s", (pass==0) ? "build" : "template");
+         for (idx=0; idx<(int)(sizeof(size)/sizeof(size[0])); idx++) {
+              tpl = pkt_template_create( IP_PROTO_TCP, mac_src, mac_dst, 0xC0A80001, 0xC0A80002
+                                       , 1024, 80, size[idx], payload, size[idx], 1, 1, 0);
+              start = clock();
+              for (idy=0; idy<num; idy++) {
+                   if (pass==0) {
+                       gen_eth_ip_tcp_packet( packet, mac_src, mac_dst, 0xC0A80001, 0xC0A80002
+                                            , 1024, 80, idy*size[idx], 0, size[idx], payload
+                                            , 1, 1, 0);
+                   } else {
+                       pkt_template_set(tpl, PKT_FIELD_SEQ_NUM, idy*size[idx]);
+                       pkt_template_set(tpl, PKT_FIELD_IP_ID, idy);
+                       pkt_template_emit(tpl, packet);
+                   }
+                   dummy ^= packet[ETH_HDR_LEN+IP_HDR_LEN+16];
+              }
+              sec = (double)(clock()-start)/CLOCKS_PER_SEC;
+              if (sec<=0.0) sec = 1.0/CLOCKS_PER_SEC;
+              printf("%8.2f", (double)num/sec/1.0e6);
+              pkt_template_release(tpl);
+         }
+         printf(" Mfps\n");
+    }
+    return (int)(dummy&0);
+}
+
+//----------------------------------------------------------------------------
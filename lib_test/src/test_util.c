@@ -0,0 +1,42 @@
+//----------------------------------------------------------------------------
+// Fixtures shared by tests.
+//----------------------------------------------------------------------------
+#include <stdint.h>
+#include <string.h>
+#include "eth_ip_udp_tcp_pkt.h"
+#include "test_util.h"
+
+//----------------------------------------------------------------------------
+const pkt_vlan_t vlan_tags[PKT_VLAN_MAX] = {
+    { ETH_TYPE_QINQ, PKT_VLAN_TCI(5,0,100) },  // S-tag
+    { ETH_TYPE_VLAN, PKT_VLAN_TCI(3,1,4094) }  // C-tag
+};
+
+//----------------------------------------------------------------------------
+int push_tags(uint8_t *pkt, int bnum, int num)
+{
+    int idx;
+    memmove(&pkt[12+num*ETH_VLAN_TAG_LEN], &pkt[12], bnum-12);
+    for (idx=0; idx<num; idx++) {
+         pkt[12+idx*ETH_VLAN_TAG_LEN] = ETH_TYPE_VLAN>>8;
+         pkt[13+idx*ETH_VLAN_TAG_LEN] = ETH_TYPE_VLAN&0xFF;
+         pkt[14+idx*ETH_VLAN_TAG_LEN] = 0;
+         pkt[15+idx*ETH_VLAN_TAG_LEN] = idx+1;
+    }
+    return bnum+num*ETH_VLAN_TAG_LEN;
+}
+
+//----------------------------------------------------------------------------
+static uint32_t _Randseed = 1;
+
+uint32_t my_rand(void)
+{
+  _Randseed = _Randseed * 1103515245 + 12345;
+  return((uint32_t)_Randseed);
+}
+
+void my_srand(uint32_t seed)
+{
+  _Randseed = seed;
+}
+//----------------------------------------------------------------------------
@@ -0,0 +1,24 @@
+#ifndef TEST_UTIL_H
+#define TEST_UTIL_H
+//----------------------------------------------------------------------------
+// Fixtures shared by tests.
+//----------------------------------------------------------------------------
+#include <stdint.h>
+#include "eth_ip_udp_tcp_pkt.h"
+
+//----------------------------------------------------------------------------
+#define MY_RAND_MAX 0xFFFFFFFF
+extern uint32_t my_rand(void);
+extern void     my_srand(uint32_t seed);
+
+//----------------------------------------------------------------------------
+// S-tag and C-tag, where '&vlan_tags[PKT_VLAN_MAX-num]' gives 'num' tags
+// with C-tag only for a single tag.
+extern const pkt_vlan_t vlan_tags[PKT_VLAN_MAX];
+
+// It inserts 'num' 802.1Q tags after MAC addresses of 'pkt' without FCS.
+// return num of bytes of 'pkt'
+extern int push_tags(uint8_t *pkt, int bnum, int num);
+
+//----------------------------------------------------------------------------
+#endif
@@ -0,0 +1,166 @@
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include "eth_ip_udp_tcp_pkt.h"
+#include "test_util.h"
+
+//----------------------------------------------------------------------------
+extern uint8_t  mac_src[6];
+extern uint8_t  mac_dst[6];
+extern uint32_t ip_src;
+extern uint32_t ip_dst;
+
+//----------------------------------------------------------------------------
+#define VLAN_PAYLOAD 1500
+#define VLAN_FRAME   (8+ETH_HDR_LEN+PKT_VLAN_MAX*ETH_VLAN_TAG_LEN+VLAN_PAYLOAD+4+64)
+
+static uint8_t payload[VLAN_PAYLOAD];
+static uint8_t plain[VLAN_FRAME];
+static uint8_t tagged[VLAN_FRAME];
+static uint8_t room[VLAN_FRAME];
+
+//----------------------------------------------------------------------------
+// It checks tagged frame of 'bnum' bytes against untagged one of 'pnum' bytes
+// built from the same data, where 'vlan_num' tags are taken from 'vlan'.
+// Frames have preamble when 'pre' is 1 and CRC always.
+static int vlan_check( const uint8_t *pkt, int bnum
+                     , const uint8_t *ref, int pnum
+                     , int vlan_num, int pre, int payload_len)
+{
+    int tag = vlan_num*ETH_VLAN_TAG_LEN;
+    int hdr = ETH_HDR_LEN+tag;
+    int len = (payload_len<(46-tag)) ? (46-tag) : payload_len;
+    uint16_t type_len;
+    int idx;
+
+    if (bnum!=(pre+hdr+len+4)) return 1; // 64-byte minimum with tags
+    if (memcmp(pkt, ref, pre+12)) return 1;
+    for (idx=0; idx<vlan_num; idx++) {
+         const uint8_t *t = &pkt[pre+12+idx*ETH_VLAN_TAG_LEN];
+         if ((((t[0]<<8)|t[1])!=vlan_tags[PKT_VLAN_MAX-vlan_num+idx].tpid)||
+             (((t[2]<<8)|t[3])!=vlan_tags[PKT_VLAN_MAX-vlan_num+idx].tci)) return 1;
+    }
+    if (get_eth_type(pkt+pre, bnum-pre, &type_len)!=hdr) return 1;
+    if (type_len!=((ref[pre+12]<<8)|ref[pre+13])) return 1;
+    // headers and payload following type-length as in untagged one
+    if (memcmp(&pkt[pre+hdr-2], &ref[pre+12], payload_len+2)) return 1;
+    if (pnum<(pre+ETH_HDR_LEN+payload_len+4)) return 1;
+    for (idx=payload_len; idx<len; idx++) if (pkt[pre+hdr+idx]) return 1;
+    if (check_eth_crc((uint8_t*)pkt+pre, bnum-pre)) return 1;
+    return 0;
+}
+
+//----------------------------------------------------------------------------
+// It builds 802.1Q and 802.1ad frames and checks them against untagged ones,
+// where padding keeps 64-byte minimum and CRC covers tags.
+// Return 0 on success, 1 on failure
+int test_vlan(void)
+{
+    const pkt_vlan_t *tag;
+    pkt_buf_t buf;
+    int idx, num, pre, len, bnum, pnum, err=0;
+    uint16_t type_len;
+
+    my_srand(20);
+    for (idx=0; idx<VLAN_PAYLOAD; idx++) payload[idx] = my_rand()&0xFF;
+    for (num=0; num<=PKT_VLAN_MAX; num++) {
+    tag = &vlan_tags[PKT_VLAN_MAX-num]; // C-tag only for single tag
+    for (pre=0; pre<=1; pre++) {
+    for (len=1; len<=VLAN_PAYLOAD; len+=(len<64) ? 1 : 97) {
+         //-------------------------------------------------------------------
+         pnum = gen_eth_packet(plain, mac_src, mac_dst, 0x88B5, len, payload, 1, pre);
+         bnum = gen_eth_packet_vlan(tagged, mac_src, mac_dst, tag, num, 0x88B5, len, payload, 1, pre);
+         if (vlan_check(tagged, bnum, plain, pnum, num, 8*pre, len)) {
+             printf("VLAN error: Ethernet %d tags %d bytes\n", num, len);
+             err = 1;
+         }
+         pkt_buf_init(&buf, room, sizeof(room), 8+ETH_HDR_LEN+PKT_VLAN_MAX*ETH_VLAN_TAG_LEN);
+         memcpy(pkt_buf_put(&buf, len), payload, len);
+         if ((gen_eth_packet_vlan_buf(&buf, mac_src, mac_dst, tag, num, 0x88B5, 1, pre)!=bnum)||
+             memcmp(buf.data, tagged, bnum)) {
+             printf("VLAN error: Ethernet buffer %d tags %d bytes\n", num, len);
+             err = 1;
+         }
+         //-------------------------------------------------------------------
+         if (len>UDP_PAYLOAD_MAX) continue;
+         pnum = gen_eth_ip_udp_packet(plain, mac_src, mac_dst, ip_src, ip_dst
+                                     , 0x1234, 0x5678, len, payload, 1, 1, pre);
+         bnum = gen_eth_ip_udp_packet_vlan(tagged, mac_src, mac_dst, tag, num, ip_src, ip_dst
+                                          , 0x1234, 0x5678, len, payload, 1, 1, pre);
+         if (vlan_check(tagged, bnum, plain, pnum, num, 8*pre, IP_HDR_LEN+UDP_HDR_LEN+len)) {
+             printf("VLAN error: UDP %d tags %d bytes\n", num, len);
+             err = 1;
+         }
+         pnum = gen_eth_ip_tcp_packet(plain, mac_src, mac_dst, ip_src, ip_dst
+                                     , 0x1234, 0x5678, 1000, 2000, len, payload, 1, 1, pre);
+         bnum = gen_eth_ip_tcp_packet_vlan(tagged, mac_src, mac_dst, tag, num, ip_src, ip_dst
+                                          , 0x1234, 0x5678, 1000, 2000, len, payload, 1, 1, pre);
+         if (vlan_check(tagged, bnum, plain, pnum, num, 8*pre, IP_HDR_LEN+TCP_HDR_LEN+len)) {
+             printf("VLAN error: TCP %d tags %d bytes\n", num, len);
+             err = 1;
+         }
+    }}}
+    //-----------------------------------------------------------------------
+    // payload built in place after tags
+    memcpy(&tagged[ETH_HDR_LEN+2*ETH_VLAN_TAG_LEN+IP_HDR_LEN+UDP_HDR_LEN], payload, 100);
+    bnum = gen_eth_ip_udp_packet_vlan(tagged, mac_src, mac_dst, vlan_tags, 2, ip_src, ip_dst
+                                     , 0x1234, 0x5678, 100, NULL, 1, 1, 0);
+    pnum = gen_eth_ip_udp_packet(plain, mac_src, mac_dst, ip_src, ip_dst
+                                , 0x1234, 0x5678, 100, payload, 1, 1, 0);
+    if (vlan_check(tagged, bnum, plain, pnum, 2, 0, IP_HDR_LEN+UDP_HDR_LEN+100)) {
+        printf("VLAN error: in place\n");
+        err = 1;
+    }
+    //-----------------------------------------------------------------------
+    // bounds
+    if ((gen_eth_packet_vlan(tagged, mac_src, mac_dst, vlan_tags, PKT_VLAN_MAX+1, 0x88B5, 10, payload, 1, 0)!=-1)||
+        (gen_eth_packet_vlan(tagged, mac_src, mac_dst, NULL, 1, 0x88B5, 10, payload, 1, 0)!=-1)||
+        (get_eth_type(tagged, ETH_HDR_LEN+ETH_VLAN_TAG_LEN, &type_len)!=-1)|| // QinQ truncated
+        (get_eth_type(tagged, ETH_HDR_LEN-1, &type_len)!=-1)) {
+        printf("VLAN error: bounds\n");
+        err = 1;
+    }
+    if (err) printf("VLAN error\n");
+    else     printf("VLAN OK\n");
+    return err;
+}
+
+//----------------------------------------------------------------------------
+// It measures frames per second of UDP over IP over Ethernet
+// with 0, 1 and 2 tags.
+int test_vlan_bench(void)
+{
+    static const int size[] = { 18, 1472 };
+    volatile int dummy=0;
+    int idx, idy, idz, num;
+    double sec;
+    clock_t start;
+
+    printf("%-14s%8s%8s%8s\n", "tags", "0", "1", "2");
+    for (idx=0; idx<(int)(sizeof(size)/sizeof(size[0])); idx++) {
+         char name[16];
+         sprintf(name, "UDP %d", size[idx]);
+         printf("%-14s", name);
+         for (num=0; num<=PKT_VLAN_MAX; num++) {
+              idz = (1<<26)/(size[idx]+64);
+              start = clock();
+              for (idy=0; idy<idz; idy++) {
+                   dummy ^= gen_eth_ip_udp_packet_vlan( tagged, mac_src, mac_dst
+                                                      , &vlan_tags[PKT_VLAN_MAX-num], num
+                                                      , ip_src, ip_dst, 0x1234, 0x5678
+                                                      , size[idx], payload, 1, 1, 0);
+              }
+              sec = (double)(clock()-start)/CLOCKS_PER_SEC;
+              if (sec<=0.0) sec = 1.0/CLOCKS_PER_SEC;
+              printf("%8.2f", (double)idz/sec/1.0e6);
+         }
+         printf(" M frames/sec\n");
+    }
+    return dummy&0;
+}
+
+//----------------------------------------------------------------------------
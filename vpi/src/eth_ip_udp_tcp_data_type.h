@@ -53,6 +53,10 @@ typedef struct eth_hdr
 /** DEFINES FOR ETHERNET **/
 #define ETH_TYPE_ARP  0x0806  /* Addr. resolution protocol */
 #define ETH_TYPE_IP   0x0800  /* IP protocol */
+#define ETH_TYPE_IPV6 0x86DD  /* IPv6 protocol */
+#define ETH_TYPE_VLAN 0x8100  /* IEEE 802.1Q VLAN tag (C-tag) */
+#define ETH_TYPE_QINQ 0x88A8  /* IEEE 802.1ad service tag (S-tag) */
+#define ETH_VLAN_TAG_LEN 4    /* TPID and TCI */
 
 /** ARP HEADER STRUCTURE **/
 #define ARP_HDR_LEN 28
@@ -154,6 +158,56 @@ typedef struct pseudo_ip_hdr
 } __attribute__ ((packed)) pseudo_ip_hdr_t;
 #endif
 
+/** IPv6 HEADER STRUCTURE **/
+#define IPV6_ADDR_LEN 16
+#define IPV6_HDR_LEN 40
+#if defined(_MSC_VER)
+#pragma pack(push, 1)
+typedef struct ipv6_hdr
+{
+    uint32_t ip6_vfc;  /* version[31:28], traffic class[27:20], flow label[19:0] */
+    uint16_t ip6_len;  /* payload length, i.e., following this header */
+    uint8_t  ip6_nxt;  /* next header */
+    uint8_t  ip6_hlim; /* hop limit */
+    uint8_t  ip6_src[IPV6_ADDR_LEN]; /* source address */
+    uint8_t  ip6_dst[IPV6_ADDR_LEN]; /* dest address */
+} ipv6_hdr_t;
+#pragma pack(pop)
+#else
+typedef struct ipv6_hdr
+{
+    uint32_t ip6_vfc;  /* version[31:28], traffic class[27:20], flow label[19:0] */
+    uint16_t ip6_len;  /* payload length, i.e., following this header */
+    uint8_t  ip6_nxt;  /* next header */
+    uint8_t  ip6_hlim; /* hop limit */
+    uint8_t  ip6_src[IPV6_ADDR_LEN]; /* source address */
+    uint8_t  ip6_dst[IPV6_ADDR_LEN]; /* dest address */
+} __attribute__ ((packed)) ipv6_hdr_t;
+#endif
+
+#define PSEUDO_IPV6_HDR_LEN 40
+#if defined(_MSC_VER)
+#pragma pack(push, 1)
+typedef struct pseudo_ipv6_hdr
+{
+    uint8_t  ip6_src[IPV6_ADDR_LEN]; /* source address */
+    uint8_t  ip6_dst[IPV6_ADDR_LEN]; /* dest address */
+    uint32_t ip6_len;  /* upper-layer packet length */
+    uint8_t  ip6_zro[3];
+    uint8_t  ip6_nxt;  /* next header, i.e., upper-layer protocol */
+} pseudo_ipv6_hdr_t;
+#pragma pack(pop)
+#else
+typedef struct pseudo_ipv6_hdr
+{
+    uint8_t  ip6_src[IPV6_ADDR_LEN]; /* source address */
+    uint8_t  ip6_dst[IPV6_ADDR_LEN]; /* dest address */
+    uint32_t ip6_len;  /* upper-layer packet length */
+    uint8_t  ip6_zro[3];
+    uint8_t  ip6_nxt;  /* next header, i.e., upper-layer protocol */
+} __attribute__ ((packed)) pseudo_ipv6_hdr_t;
+#endif
+
 /** UDP HEADER STRUCTURE **/
 #define UDP_HDR_LEN 8
 #if defined(_MSC_VER)
@@ -178,6 +232,12 @@ typedef struct udp_hdr
 
 /** TCP HEADER STRUCTURE **/
 #define TCP_HDR_LEN 20
+#define TCP_FLAG_FIN       0x01  // byte 13 of TCP header
+#define TCP_FLAG_SYN       0x02
+#define TCP_FLAG_RST       0x04
+#define TCP_FLAG_PSH       0x08
+#define TCP_FLAG_ACK       0x10
+#define TCP_FLAG_URG       0x20
 #if defined(_MSC_VER)
 #pragma pack(push, 1)
 typedef struct tcp_hdr
@@ -220,6 +280,16 @@ typedef struct tcp_hdr
 #define IP_FRAG_MF         0x2000  // more fragments flag
 #define IP_FRAG_OFFMASK    0x1fff  // mask for fragmenting bits
 
+/** DEFINES FOR IPv6 **/
+#define IPV6_NEXT_HOPOPTS  0   // hop-by-hop options header
+#define IPV6_NEXT_ROUTING  43  // routing header
+#define IPV6_NEXT_FRAGMENT 44  // fragment header
+#define IPV6_NEXT_ESP      50  // encapsulating security payload
+#define IPV6_NEXT_AH       51  // authentication header
+#define IPV6_NEXT_ICMPV6   58  // ICMPv6
+#define IPV6_NEXT_NONE     59  // no next header
+#define IPV6_NEXT_DSTOPTS  60  // destination options header
+
 /** ICMP HEADER STRUCTURE **/
 #if defined(_MSC_VER)
 #pragma pack(push, 1)
@@ -239,6 +309,30 @@ typedef struct icmp_hdr
 } __attribute__ ((packed)) icmp_hdr_t;
 #endif
 
+/** ICMP/ICMPv6 ECHO HEADER STRUCTURE **/
+#define ICMP_ECHO_HDR_LEN 8
+#if defined(_MSC_VER)
+#pragma pack(push, 1)
+typedef struct icmp_echo_hdr
+{
+    uint8_t  icmp_type;
+    uint8_t  icmp_code;
+    uint16_t icmp_sum;
+    uint16_t icmp_id;  // identifier
+    uint16_t icmp_seq; // sequence number
+} icmp_echo_hdr_t;
+#pragma pack(pop)
+#else
+typedef struct icmp_echo_hdr
+{
+    uint8_t  icmp_type;
+    uint8_t  icmp_code;
+    uint16_t icmp_sum;
+    uint16_t icmp_id;  // identifier
+    uint16_t icmp_seq; // sequence number
+} __attribute__ ((packed)) icmp_echo_hdr_t;
+#endif
+
 /** DEFINES FOR ICMP **/
 #define ICMP_TYPE_DESTINATION_UNREACHABLE  0x3
 #define ICMP_CODE_NET_UNREACHABLE          0x0
@@ -254,6 +348,10 @@ typedef struct icmp_hdr
 #define ICMP_TYPE_ECHO_REPLY               0x0
 #define ICMP_CODE_ECHO                     0x0
 
+/** DEFINES FOR ICMPv6 **/
+#define ICMPV6_TYPE_ECHO_REQUEST           128
+#define ICMPV6_TYPE_ECHO_REPLY             129
+
 #ifdef __cplusplus
 }
 #endif
@@ -5,9 +5,49 @@
 // VERSION = 2019.05.20.
 //----------------------------------------------------------------------------
 #include <stdio.h>
+#include <stdlib.h>
 #include <stdint.h>
 #include <string.h>
 #include "eth_ip_udp_tcp_pkt.h"
+#include "eth_crc_table.h"
+
+//-----------------------------------------------------
+// Carry-less multiply (PCLMULQDQ) CRC is built for x86 hosts
+// and used when the CPU supports it.
+// Define NO_ETH_CRC_PCLMUL when the compiler does not carry the intrinsics.
+#if (defined(__x86_64__)||defined(__i386__)||defined(_M_X64)||defined(_M_IX86))\
+    &&!defined(NO_ETH_CRC_PCLMUL)
+#define ETH_CRC_PCLMUL
+#include <emmintrin.h>
+#include <wmmintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define ETH_CRC_TARGET
+#else
+#include <cpuid.h>
+#define ETH_CRC_TARGET __attribute__((target("sse2,pclmul")))
+#endif
+#endif
+
+//-----------------------------------------------------
+// SSE2/AVX2 Internet checksum is built for x86 hosts
+// and used when the CPU supports it.
+// Define NO_CHECKSUM_SIMD when the compiler does not carry the intrinsics.
+#if (defined(__x86_64__)||defined(__i386__)||defined(_M_X64)||defined(_M_IX86))\
+    &&!defined(NO_CHECKSUM_SIMD)
+#define CHECKSUM_SIMD
+#include <emmintrin.h>
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define CHECKSUM_TARGET_SSE2
+#define CHECKSUM_TARGET_AVX2
+#else
+#include <cpuid.h>
+#define CHECKSUM_TARGET_SSE2 __attribute__((target("sse2")))
+#define CHECKSUM_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
 
 //-----------------------------------------------------
 #define TEXTIFY(T) #T
@@ -16,29 +56,13 @@
         printf("mis-aligned %s %zd\n", TEXTIFY(A), ((uintptr_t)(const void*)&((A)))%(B))
 
 //-----------------------------------------------------
-static uint32_t crc_table[] = {
-  0x4DBDF21C, 0x500AE278, 0x76D3D2D4, 0x6B64C2B0,
-  0x3B61B38C, 0x26D6A3E8, 0x000F9344, 0x1DB88320,
-  0xA005713C, 0xBDB26158, 0x9B6B51F4, 0x86DC4190,
-  0xD6D930AC, 0xCB6E20C8, 0xEDB71064, 0xF0000000
-};
-//-----------------------------------------------------
-// 1. calculate Etherent CRC checksum
-// 2. return the host order checksum (after inversion)
-uint32_t compute_eth_crc_ref(uint8_t *pkt, uint32_t bnum) {
-  unsigned int n;
-  uint32_t crc=0;
-  for (n=0; n<bnum; n++) {
-    crc = (crc>>4)^crc_table[(crc^(pkt[n]>>0))&0x0F]; /* lower nibble */
-    crc = (crc>>4)^crc_table[(crc^(pkt[n]>>4))&0x0F]; /* upper nibble */
-  }
-  return ~crc;
-}
+// Bit-serial reference of compute_eth_crc() and check_eth_crc(),
+// which is kept to verify table-driven ones.
 // It is assumed that bit0 of pkt[0] comes first in
 // terms of bit-stream.
 // message: pointer to the message that contains 'len' bytes.
 // return: 32-bit CRC; LSbyte should sent first with inversion.
-uint32_t compute_eth_crc(uint8_t *message, int len) {
+uint32_t compute_eth_crc_bitwise(uint8_t *message, int len) {
    int i, j;
    uint32_t word, crc, mask;
    crc = 0xFFFFFFFF;
@@ -54,7 +78,7 @@ uint32_t compute_eth_crc(uint8_t *message, int len) {
 }
 // len includes 4-byte FCS
 // return 0 on success, 1 on failure
-int check_eth_crc(uint8_t *message, int len) {
+int check_eth_crc_bitwise(uint8_t *message, int len) {
    int i, j;
    uint32_t word, crc, mask;
    crc = 0xFFFFFFFF;
@@ -70,23 +94,658 @@ int check_eth_crc(uint8_t *message, int len) {
    return crc;
 }
 
+//-----------------------------------------------------
+// Slicing-by-8: it folds 8 bytes with 8 table look-ups.
+// Bytes are picked one by one, so that it does not depend on
+// alignment of 'message' nor endianness of the host.
+// crc: CRC so far without inversion, i.e., 0xFFFFFFFF at the beginning.
+static uint32_t update_eth_crc_slice8(uint32_t crc, const uint8_t *message, int len) {
+   while (len>=8) {
+      crc ^= (uint32_t)message[0]
+          | ((uint32_t)message[1]<<8)
+          | ((uint32_t)message[2]<<16)
+          | ((uint32_t)message[3]<<24);
+      crc = eth_crc_table[7][ crc     &0xFF]
+          ^ eth_crc_table[6][(crc>> 8)&0xFF]
+          ^ eth_crc_table[5][(crc>>16)&0xFF]
+          ^ eth_crc_table[4][ crc>>24      ]
+          ^ eth_crc_table[3][message[4]]
+          ^ eth_crc_table[2][message[5]]
+          ^ eth_crc_table[1][message[6]]
+          ^ eth_crc_table[0][message[7]];
+      message += 8;
+      len     -= 8;
+   }
+   while (len>0) {
+      crc = (crc>>8)^eth_crc_table[0][(crc^*message++)&0xFF];
+      len--;
+   }
+   return crc;
+}
+//-----------------------------------------------------
+// Bit-serial; crc: CRC so far without inversion.
+static uint32_t update_eth_crc_bitwise(uint32_t crc, const uint8_t *message, int len) {
+   int i, j;
+   uint32_t mask;
+   for (i=0; i<len; i++) {
+      crc = crc ^ message[i];
+      for (j = 7; j >= 0; j--) {
+         mask = -(crc & 1);
+         crc = (crc >> 1) ^ (0xEDB88320 & mask); // reverse(0x04C11DB7)
+      }
+   }
+   return crc;
+}
+
+#if defined(ETH_CRC_PCLMUL)
+//-----------------------------------------------------
+// Folding by carry-less multiply, which follows
+// "Fast CRC Computation for Generic Polynomials Using PCLMULQDQ Instruction"
+// by Intel with bit-reflected constants as zlib does.
+static const uint64_t eth_crc_k1k2[2] = { 0x0154442bd4, 0x01c6e41596 };
+static const uint64_t eth_crc_k3k4[2] = { 0x01751997d0, 0x00ccaa009e };
+static const uint64_t eth_crc_k5k0[2] = { 0x0163cd6124, 0x0000000000 };
+static const uint64_t eth_crc_poly[2] = { 0x01db710641, 0x01f7011641 };
+
+// It folds 4 blocks of 16 into 128-bit.
+ETH_CRC_TARGET
+static __m128i fold4_eth_crc_pclmul(__m128i x1, __m128i x2, __m128i x3, __m128i x4) {
+   __m128i x0, x5;
+   x0 = _mm_loadu_si128((const __m128i*)eth_crc_k3k4);
+   x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+   x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+   x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+   x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+   x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+   x1 = _mm_xor_si128(_mm_xor_si128(x1, x3), x5);
+   x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+   x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+   x1 = _mm_xor_si128(_mm_xor_si128(x1, x4), x5);
+   return x1;
+}
+
+// It reduces 128-bit into 32-bit CRC without inversion.
+ETH_CRC_TARGET
+static uint32_t reduce_eth_crc_pclmul(__m128i x1) {
+   __m128i x0, x2, x3;
+
+   // fold 128-bit to 64-bit
+   x0 = _mm_loadu_si128((const __m128i*)eth_crc_k3k4);
+   x2 = _mm_clmulepi64_si128(x1, x0, 0x10);
+   x3 = _mm_setr_epi32(~0, 0, ~0, 0);
+   x1 = _mm_srli_si128(x1, 8);
+   x1 = _mm_xor_si128(x1, x2);
+   x0 = _mm_loadl_epi64((const __m128i*)eth_crc_k5k0);
+   x2 = _mm_srli_si128(x1, 4);
+   x1 = _mm_and_si128(x1, x3);
+   x1 = _mm_clmulepi64_si128(x1, x0, 0x00);
+   x1 = _mm_xor_si128(x1, x2);
+
+   // Barrett reduction to 32-bit
+   x0 = _mm_loadu_si128((const __m128i*)eth_crc_poly);
+   x2 = _mm_and_si128(x1, x3);
+   x2 = _mm_clmulepi64_si128(x2, x0, 0x10);
+   x2 = _mm_and_si128(x2, x3);
+   x2 = _mm_clmulepi64_si128(x2, x0, 0x00);
+   x1 = _mm_xor_si128(x1, x2);
+
+   return (uint32_t)_mm_cvtsi128_si32(_mm_srli_si128(x1, 4));
+}
+
+// 'len' should be a multiple of 16 and 64 at least.
+// crc: CRC so far without inversion.
+ETH_CRC_TARGET
+static uint32_t fold_eth_crc_pclmul(uint32_t crc, const uint8_t *message, int len) {
+   __m128i x0, x1, x2, x3, x4, x5, x6, x7, x8, y5, y6, y7, y8;
+
+   // there is at least one block of 64.
+   x1 = _mm_loadu_si128((const __m128i*)(message+0x00));
+   x2 = _mm_loadu_si128((const __m128i*)(message+0x10));
+   x3 = _mm_loadu_si128((const __m128i*)(message+0x20));
+   x4 = _mm_loadu_si128((const __m128i*)(message+0x30));
+   x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128((int)crc));
+   x0 = _mm_loadu_si128((const __m128i*)eth_crc_k1k2);
+   message += 64;
+   len     -= 64;
+
+   // fold 4 blocks of 16 in parallel
+   while (len>=64) {
+      x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+      x6 = _mm_clmulepi64_si128(x2, x0, 0x00);
+      x7 = _mm_clmulepi64_si128(x3, x0, 0x00);
+      x8 = _mm_clmulepi64_si128(x4, x0, 0x00);
+      x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+      x2 = _mm_clmulepi64_si128(x2, x0, 0x11);
+      x3 = _mm_clmulepi64_si128(x3, x0, 0x11);
+      x4 = _mm_clmulepi64_si128(x4, x0, 0x11);
+      y5 = _mm_loadu_si128((const __m128i*)(message+0x00));
+      y6 = _mm_loadu_si128((const __m128i*)(message+0x10));
+      y7 = _mm_loadu_si128((const __m128i*)(message+0x20));
+      y8 = _mm_loadu_si128((const __m128i*)(message+0x30));
+      x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), y5);
+      x2 = _mm_xor_si128(_mm_xor_si128(x2, x6), y6);
+      x3 = _mm_xor_si128(_mm_xor_si128(x3, x7), y7);
+      x4 = _mm_xor_si128(_mm_xor_si128(x4, x8), y8);
+      message += 64;
+      len     -= 64;
+   }
+
+   // fold into 128-bit
+   x1 = fold4_eth_crc_pclmul(x1, x2, x3, x4);
+
+   // fold remaining blocks of 16
+   x0 = _mm_loadu_si128((const __m128i*)eth_crc_k3k4);
+   while (len>=16) {
+      x2 = _mm_loadu_si128((const __m128i*)message);
+      x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+      x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+      x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+      message += 16;
+      len     -= 16;
+   }
+
+   return reduce_eth_crc_pclmul(x1);
+}
+
+//-----------------------------------------------------
+// crc: CRC so far without inversion.
+static uint32_t update_eth_crc_pclmul(uint32_t crc, const uint8_t *message, int len) {
+   if (len>=64) {
+      int num = len&~15;
+      crc = fold_eth_crc_pclmul(crc, message, num);
+      message += num;
+      len     -= num;
+   }
+   return update_eth_crc_slice8(crc, message, len);
+}
+
+//-----------------------------------------------------
+static int eth_crc_pclmul_supported(void) {
+#if defined(_MSC_VER)
+   int info[4];
+   __cpuid(info, 1);
+   return ((info[2]>>1)&1)&&((info[3]>>26)&1); // PCLMULQDQ and SSE2
+#else
+   unsigned int eax, ebx, ecx, edx;
+   if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) return 0;
+   return ((ecx&bit_PCLMUL)!=0)&&((edx&bit_SSE2)!=0);
+#endif
+}
+#endif
+
+//-----------------------------------------------------
+// It selects the way to compute CRC;
+// the fastest one supported by the CPU unless 'NETWORK_VPI_CRC' environment
+// variable forces it ("pclmul", "slice8", or "bitwise").
+static int m_crc_mode=-1;
+static uint32_t (*m_crc_update)(uint32_t crc, const uint8_t *message, int len)=NULL;
+
+int eth_crc_mode(void) {
+   if (m_crc_mode<0) {
+      char *str = getenv("NETWORK_VPI_CRC");
+      int mode = ETH_CRC_MODE_PCLMUL;
+      if (str!=NULL) {
+              if (!strcmp(str, "slice8" )) mode = ETH_CRC_MODE_SLICE8;
+         else if (!strcmp(str, "bitwise")) mode = ETH_CRC_MODE_BITWISE;
+      }
+      set_eth_crc_mode(mode);
+   }
+   return m_crc_mode;
+}
+
+// It returns the mode actually taken,
+// which is ETH_CRC_MODE_SLICE8 when PCLMULQDQ is not available.
+int set_eth_crc_mode(int mode) {
+#if defined(ETH_CRC_PCLMUL)
+   if ((mode==ETH_CRC_MODE_PCLMUL)&&!eth_crc_pclmul_supported()) mode = ETH_CRC_MODE_SLICE8;
+#else
+   if (mode==ETH_CRC_MODE_PCLMUL) mode = ETH_CRC_MODE_SLICE8;
+#endif
+   switch (mode) {
+#if defined(ETH_CRC_PCLMUL)
+   case ETH_CRC_MODE_PCLMUL : m_crc_update = update_eth_crc_pclmul ; break;
+#endif
+   case ETH_CRC_MODE_BITWISE: m_crc_update = update_eth_crc_bitwise; break;
+   default: mode = ETH_CRC_MODE_SLICE8;
+            m_crc_update = update_eth_crc_slice8; break;
+   }
+   m_crc_mode = mode;
+   return mode;
+}
+
+static uint32_t update_eth_crc(uint32_t crc, const uint8_t *message, int len) {
+   if (m_crc_update==NULL) eth_crc_mode();
+   return m_crc_update(crc, message, len);
+}
+
+// It is assumed that bit0 of pkt[0] comes first in
+// terms of bit-stream.
+// message: pointer to the message that contains 'len' bytes.
+// return: 32-bit CRC; LSbyte should sent first with inversion.
+uint32_t compute_eth_crc(uint8_t *message, int len) {
+   return ~update_eth_crc(0xFFFFFFFF, message, len); // LSByte should be sent first
+}
+// len includes 4-byte FCS
+// return 0 on success, 1 on failure
+int check_eth_crc(uint8_t *message, int len) {
+   uint8_t fcs[4];
+   int i, num;
+   uint32_t crc;
+   num = (len<4) ? len : 4; // num of FCS bytes
+   crc = update_eth_crc(0xFFFFFFFF, message, len-num);
+   for (i=0; i<num; i++) fcs[i] = ~message[len-num+i];
+   return update_eth_crc(crc, fcs, num);
+}
+
+//-----------------------------------------------------
+// Polynomial arithmetic modulo the Ethernet CRC polynomial
+// in bit-reflected form, i.e., bit31 is x^0.
+// It returns a(x)*b(x) modulo p(x).
+static uint32_t mult_mod_eth_crc(uint32_t a, uint32_t b) {
+   uint32_t m = (uint32_t)1<<31;
+   uint32_t p = 0;
+   for (;;) {
+      if (a&m) {
+         p ^= b;
+         if ((a&(m-1))==0) break;
+      }
+      m >>= 1;
+      b = (b&1) ? (b>>1)^0xEDB88320 : b>>1;
+   }
+   return p;
+}
+// It returns x^(8*bnum) modulo p(x), which shifts CRC over 'bnum' zero bytes.
+static uint32_t shift_mod_eth_crc(uint32_t bnum) {
+   static uint32_t x2n[32]; // x^(2^n) modulo p(x)
+   uint32_t p = (uint32_t)1<<31; // x^0
+   int n;
+   if (x2n[0]==0) {
+      uint32_t q = (uint32_t)1<<30; // x^1
+      for (n=0; n<32; n++) { x2n[n] = q; q = mult_mod_eth_crc(q, q); }
+   }
+   for (n=3; bnum; bnum>>=1, n++) { // 8=2^3
+      if (bnum&1) p = mult_mod_eth_crc(x2n[n&31], p);
+   }
+   return p;
+}
+
+//-----------------------------------------------------
+// It returns CRC of 'A' followed by 'B' from CRC of each,
+// where all are what compute_eth_crc() returns.
+// crcA: compute_eth_crc(A, lenA)
+// crcB: compute_eth_crc(B, lenB)
+// It takes O(log(lenB)) regardless of contents.
+uint32_t combine_eth_crc(uint32_t crcA, uint32_t crcB, int lenB) {
+   if (lenB<=0) return crcA;
+   return mult_mod_eth_crc(shift_mod_eth_crc((uint32_t)lenB), crcA)^crcB;
+}
+
+//-----------------------------------------------------
+// It replaces 'num' bytes of 'pkt' at 'offset' by 'data' and
+// updates the 4-byte FCS at the end of 'pkt' accordingly,
+// which takes O(num+log(bnum)) instead of O(bnum).
+// pkt: Ethernet frame without preamble, which ends with FCS
+// bnum: num of bytes of 'pkt' including FCS
+// Note that CRC is linear, so that changes of FCS only depends on
+// XOR of old and new bytes and num of bytes following them.
+// return 0 on success, -1 on failure
+int patch_eth_crc(uint8_t *pkt, int bnum, int offset, const uint8_t *data, int num) {
+   uint8_t  delta[64];
+   uint32_t crc=0, fcs;
+   int i, idx, chunk;
+   if ((bnum<4)||(offset<0)||(num<0)||((offset+num)>(bnum-4))) return -1;
+   for (idx=0; idx<num; idx+=chunk) {
+      chunk = ((num-idx)<(int)sizeof(delta)) ? (num-idx) : (int)sizeof(delta);
+      for (i=0; i<chunk; i++) {
+         delta[i] = pkt[offset+idx+i]^data[idx+i];
+         pkt[offset+idx+i] = data[idx+i];
+      }
+      crc = update_eth_crc(crc, delta, chunk); // no initial value nor inversion
+   }
+   crc = mult_mod_eth_crc(shift_mod_eth_crc((uint32_t)(bnum-4-offset-num)), crc);
+   fcs = (uint32_t)pkt[bnum-4]
+       | ((uint32_t)pkt[bnum-3]<<8)
+       | ((uint32_t)pkt[bnum-2]<<16)
+       | ((uint32_t)pkt[bnum-1]<<24); // LSByte first
+   fcs ^= crc;
+   pkt[bnum-4] = (fcs>> 0)&0xFF;
+   pkt[bnum-3] = (fcs>> 8)&0xFF;
+   pkt[bnum-2] = (fcs>>16)&0xFF;
+   pkt[bnum-1] = (fcs>>24)&0xFF;
+   return 0;
+}
+
+//-----------------------------------------------------
+// Internet checksum kernel (RFC 1071).
+// 32-bit words are added in host order into 64-bit accumulators
+// and folded only once at the end, which is possible since
+// the one's complement sum does not depend on byte order
+// except swapping bytes of the result (RFC 1071 section 2(B)).
+// All of them return the sum of 16-bit host order words, which is
+// not folded nor swapped; see sum_checksum().
+static uint64_t add_checksum_scalar(const uint8_t *pkt, int bnum) {
+    uint64_t sum = 0;
+    uint32_t w32;
+    uint16_t w16=0;
+    while (bnum>=4) {
+        memcpy(&w32, pkt, 4); // no alignment nor aliasing assumed
+        sum  += w32;
+        pkt  += 4;
+        bnum -= 4;
+    }
+    if (bnum>=2) {
+        memcpy(&w16, pkt, 2);
+        sum  += w16;
+        pkt  += 2;
+        bnum -= 2;
+    }
+    if (bnum>0) {
+        w16 = 0;
+        memcpy(&w16, pkt, 1); // the first byte of 16-bit word
+        sum += w16;
+    }
+    return sum;
+}
+
+#if defined(CHECKSUM_SIMD)
+//-----------------------------------------------------
+CHECKSUM_TARGET_SSE2
+static uint64_t add_checksum_sse2(const uint8_t *pkt, int bnum) {
+    const __m128i zero = _mm_setzero_si128();
+    __m128i acc0 = _mm_setzero_si128();
+    __m128i acc1 = _mm_setzero_si128();
+    __m128i v;
+    uint64_t sum[2];
+    while (bnum>=16) {
+        v = _mm_loadu_si128((const __m128i*)pkt);
+        acc0 = _mm_add_epi64(acc0, _mm_unpacklo_epi32(v, zero));
+        acc1 = _mm_add_epi64(acc1, _mm_unpackhi_epi32(v, zero));
+        pkt  += 16;
+        bnum -= 16;
+    }
+    _mm_storeu_si128((__m128i*)sum, _mm_add_epi64(acc0, acc1));
+    return sum[0] + sum[1] + add_checksum_scalar(pkt, bnum);
+}
+
+//-----------------------------------------------------
+CHECKSUM_TARGET_AVX2
+static uint64_t add_checksum_avx2(const uint8_t *pkt, int bnum) {
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i acc0 = _mm256_setzero_si256();
+    __m256i acc1 = _mm256_setzero_si256();
+    __m256i acc2 = _mm256_setzero_si256();
+    __m256i acc3 = _mm256_setzero_si256();
+    __m256i v, w;
+    uint64_t sum[4];
+    while (bnum>=64) {
+        v = _mm256_loadu_si256((const __m256i*)pkt);
+        w = _mm256_loadu_si256((const __m256i*)(pkt+32));
+        acc0 = _mm256_add_epi64(acc0, _mm256_unpacklo_epi32(v, zero));
+        acc1 = _mm256_add_epi64(acc1, _mm256_unpackhi_epi32(v, zero));
+        acc2 = _mm256_add_epi64(acc2, _mm256_unpacklo_epi32(w, zero));
+        acc3 = _mm256_add_epi64(acc3, _mm256_unpackhi_epi32(w, zero));
+        pkt  += 64;
+        bnum -= 64;
+    }
+    acc0 = _mm256_add_epi64(_mm256_add_epi64(acc0, acc1), _mm256_add_epi64(acc2, acc3));
+    _mm256_storeu_si256((__m256i*)sum, acc0);
+    return sum[0] + sum[1] + sum[2] + sum[3] + add_checksum_scalar(pkt, bnum);
+}
+
+//-----------------------------------------------------
+static int checksum_simd_supported(int mode) {
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0]<1) return 0;
+    __cpuid(info, 1);
+    if (mode==CHECKSUM_MODE_SSE2) return (info[3]>>26)&1;
+    if (!((info[2]>>27)&1)) return 0; // OSXSAVE
+    if ((_xgetbv(0)&0x6)!=0x6) return 0; // XMM and YMM states enabled by OS
+    __cpuidex(info, 7, 0);
+    return (info[1]>>5)&1;
+#else
+    __builtin_cpu_init();
+    if (mode==CHECKSUM_MODE_SSE2) return __builtin_cpu_supports("sse2");
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+#endif
+
+//-----------------------------------------------------
+// It selects the way to compute checksum;
+// the fastest one supported by the CPU unless 'NETWORK_VPI_CHECKSUM'
+// environment variable forces it ("avx2", "sse2", or "scalar").
+static int m_checksum_mode=-1;
+static uint64_t (*m_checksum_add)(const uint8_t *pkt, int bnum)=NULL;
+
+int checksum_mode(void) {
+    if (m_checksum_mode<0) {
+        char *str = getenv("NETWORK_VPI_CHECKSUM");
+        int mode = CHECKSUM_MODE_AVX2;
+        if (str!=NULL) {
+                 if (!strcmp(str, "sse2"  )) mode = CHECKSUM_MODE_SSE2;
+            else if (!strcmp(str, "scalar")) mode = CHECKSUM_MODE_SCALAR;
+        }
+        set_checksum_mode(mode);
+    }
+    return m_checksum_mode;
+}
+
+// It returns the mode actually taken,
+// which falls back to the next one when the CPU does not support it.
+int set_checksum_mode(int mode) {
+#if defined(CHECKSUM_SIMD)
+    if ((mode==CHECKSUM_MODE_AVX2)&&!checksum_simd_supported(CHECKSUM_MODE_AVX2)) mode = CHECKSUM_MODE_SSE2;
+    if ((mode==CHECKSUM_MODE_SSE2)&&!checksum_simd_supported(CHECKSUM_MODE_SSE2)) mode = CHECKSUM_MODE_SCALAR;
+#endif
+    switch (mode) {
+#if defined(CHECKSUM_SIMD)
+    case CHECKSUM_MODE_AVX2: m_checksum_add = add_checksum_avx2; break;
+    case CHECKSUM_MODE_SSE2: m_checksum_add = add_checksum_sse2; break;
+#endif
+    default: mode = CHECKSUM_MODE_SCALAR;
+             m_checksum_add = add_checksum_scalar; break;
+    }
+    m_checksum_mode = mode;
+    return mode;
+}
+
+//-----------------------------------------------------
+// It returns one's complement sum of 'bnum' bytes of 'pkt' as
+// big-endian 16-bit words, which is folded into 16-bit without inversion.
+// When 'bnum' is odd, the last byte is padded with zero.
+// Sums of pieces can be added and folded again by fold_checksum()
+// as far as each piece but the last starts at even offset.
+static uint32_t fold_checksum(uint64_t sum) {
+    while (sum>>16) sum = (sum&0xFFFF)+(sum>>16);
+    return (uint32_t)sum;
+}
+// It turns sum of host order words into sum of big-endian words.
+static uint32_t order_checksum(uint64_t sum) {
+    static const uint16_t endian = 0x0100;
+    uint32_t val = fold_checksum(sum);
+    if (*(const uint8_t*)&endian==0) { // little-endian host
+        val = ((val>>8)|(val<<8))&0xFFFF;
+    }
+    return val;
+}
+static uint32_t sum_checksum(const uint8_t *pkt, int bnum) {
+    if (m_checksum_add==NULL) checksum_mode();
+    if (bnum<=0) return 0;
+    return order_checksum(m_checksum_add(pkt, bnum));
+}
+
 //-----------------------------------------------------
 // It is assumed that the checksum field is zero before calling this.
 // 1. calculate IP header checksum
 // 2. return the host order checksum without inversion
 uint16_t compute_checksum(uint8_t* pkt, int bnum) {
-    int idx;
-    uint32_t sum = 0;
-    for (idx=0; idx<(bnum-1); idx+=2) {
-         sum += (pkt[idx]<<8)|pkt[idx+1];
+    return (uint16_t)sum_checksum(pkt, bnum);
+}
+
+//-----------------------------------------------------
+// Fused copy, checksum and CRC.
+// Payload is copied by blocks of 64 bytes while each block is
+// added to the checksum and folded into CRC in registers,
+// so that each byte is read once.
+#if defined(ETH_CRC_PCLMUL)&&defined(CHECKSUM_SIMD)
+// 'len' should be a multiple of 64 and 64 at least.
+// It returns checksum in the same way as add_checksum_*().
+// crc: CRC so far without inversion, which is updated.
+ETH_CRC_TARGET
+static uint64_t copy_checksum_crc_pclmul(uint8_t *dst, const uint8_t *src, int len, uint32_t *crc) {
+    const __m128i zero = _mm_setzero_si128();
+    __m128i acc0 = _mm_setzero_si128();
+    __m128i acc1 = _mm_setzero_si128();
+    __m128i x0, x1, x2, x3, x4, x5, x6, x7, x8, y5, y6, y7, y8;
+    uint64_t sum[2];
+#define COPY_CHECKSUM(V,OFF)\
+    _mm_storeu_si128((__m128i*)(dst+(OFF)), (V));\
+    acc0 = _mm_add_epi64(acc0, _mm_unpacklo_epi32((V), zero));\
+    acc1 = _mm_add_epi64(acc1, _mm_unpackhi_epi32((V), zero))
+
+    x1 = _mm_loadu_si128((const __m128i*)(src+0x00));
+    x2 = _mm_loadu_si128((const __m128i*)(src+0x10));
+    x3 = _mm_loadu_si128((const __m128i*)(src+0x20));
+    x4 = _mm_loadu_si128((const __m128i*)(src+0x30));
+    COPY_CHECKSUM(x1,0x00);
+    COPY_CHECKSUM(x2,0x10);
+    COPY_CHECKSUM(x3,0x20);
+    COPY_CHECKSUM(x4,0x30);
+    x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128((int)*crc));
+    x0 = _mm_loadu_si128((const __m128i*)eth_crc_k1k2);
+    src += 64;
+    dst += 64;
+    len -= 64;
+
+    while (len>=64) {
+       x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+       x6 = _mm_clmulepi64_si128(x2, x0, 0x00);
+       x7 = _mm_clmulepi64_si128(x3, x0, 0x00);
+       x8 = _mm_clmulepi64_si128(x4, x0, 0x00);
+       x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+       x2 = _mm_clmulepi64_si128(x2, x0, 0x11);
+       x3 = _mm_clmulepi64_si128(x3, x0, 0x11);
+       x4 = _mm_clmulepi64_si128(x4, x0, 0x11);
+       y5 = _mm_loadu_si128((const __m128i*)(src+0x00));
+       y6 = _mm_loadu_si128((const __m128i*)(src+0x10));
+       y7 = _mm_loadu_si128((const __m128i*)(src+0x20));
+       y8 = _mm_loadu_si128((const __m128i*)(src+0x30));
+       COPY_CHECKSUM(y5,0x00);
+       COPY_CHECKSUM(y6,0x10);
+       COPY_CHECKSUM(y7,0x20);
+       COPY_CHECKSUM(y8,0x30);
+       x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), y5);
+       x2 = _mm_xor_si128(_mm_xor_si128(x2, x6), y6);
+       x3 = _mm_xor_si128(_mm_xor_si128(x3, x7), y7);
+       x4 = _mm_xor_si128(_mm_xor_si128(x4, x8), y8);
+       src += 64;
+       dst += 64;
+       len -= 64;
     }
-    if (idx<bnum) {
-         sum += (pkt[idx]<<8);
+#undef COPY_CHECKSUM
+
+    *crc = reduce_eth_crc_pclmul(fold4_eth_crc_pclmul(x1, x2, x3, x4));
+    _mm_storeu_si128((__m128i*)sum, _mm_add_epi64(acc0, acc1));
+    return sum[0] + sum[1];
+}
+#endif
+
+//-----------------------------------------------------
+// It copies 'bnum' bytes from 'src' to 'dst' ('src' can be 'dst')
+// and adds them to 'sum' and 'crc' unless NULL.
+// sum: checksum in the same way as add_checksum_*()
+// crc: CRC so far without inversion
+// Without the fused kernel, it goes by chunks that stay in cache
+// between passes.
+#define COPY_CHECKSUM_CHUNK  2048 // should be even
+static void copy_checksum_crc_(uint8_t *dst, const uint8_t *src, int bnum, uint64_t *sum, uint32_t *crc) {
+    int num;
+    if (m_checksum_add==NULL) checksum_mode();
+    if (m_crc_update==NULL) eth_crc_mode();
+#if defined(ETH_CRC_PCLMUL)&&defined(CHECKSUM_SIMD)
+    if ((sum!=NULL)&&(crc!=NULL)&&(bnum>=64)&&
+        (m_crc_mode==ETH_CRC_MODE_PCLMUL)&&(m_checksum_mode!=CHECKSUM_MODE_SCALAR)) {
+        num = bnum&~63;
+        *sum += copy_checksum_crc_pclmul(dst, src, num, crc);
+        dst  += num;
+        src  += num;
+        bnum -= num;
     }
-    sum  = (sum>>16)+(sum&0xFFFF);
-    sum += (sum>>16);
+#endif
+    while (bnum>0) {
+        num = (bnum<COPY_CHECKSUM_CHUNK) ? bnum : COPY_CHECKSUM_CHUNK;
+        if (dst!=src) memcpy((void*)dst, (const void*)src, num);
+        if (sum!=NULL) *sum += m_checksum_add(dst, num);
+        if (crc!=NULL) *crc  = m_crc_update(*crc, dst, num);
+        dst  += num;
+        src  += num;
+        bnum -= num;
+    }
+}
 
-    return sum&0xFFFF;
+//-----------------------------------------------------
+// It copies 'bnum' bytes from 'src' to 'dst' in a single pass
+// while computing Internet checksum and Ethernet CRC of them.
+// crc: what compute_eth_crc() returns for bytes before them
+//      (0 when nothing before) and it is updated to include them.
+//      CRC is not computed when 'crc' is NULL.
+// return the host order checksum without inversion as compute_checksum().
+uint16_t copy_checksum_crc(uint8_t *dst, const uint8_t *src, int bnum, uint32_t *crc) {
+    uint64_t sum=0;
+    uint32_t val;
+    if (crc!=NULL) {
+        val = ~(*crc);
+        copy_checksum_crc_(dst, src, bnum, &sum, &val);
+        *crc = ~val;
+    } else {
+        copy_checksum_crc_(dst, src, bnum, &sum, NULL);
+    }
+    return (uint16_t)order_checksum(sum);
+}
+
+//-----------------------------------------------------
+int pkt_iovec_len(const pkt_iovec_t *iov, int iovcnt) {
+    int idx, num=0;
+    for (idx=0; idx<iovcnt; idx++) if (iov[idx].len>0) num += iov[idx].len;
+    return num;
+}
+
+//-----------------------------------------------------
+// It copies fragments of 'iov' to 'dst' one after another
+// as copy_checksum_crc_(), where a fragment with 0 'base' is in place.
+// sum: checksum of big-endian words as order_checksum() returns.
+//      A fragment placed at odd offset has its sum byte-swapped,
+//      so that fragments can be of any length.
+// return num of bytes copied
+static int copy_checksum_crc_iov(uint8_t *dst, const pkt_iovec_t *iov, int iovcnt, uint32_t *sum, uint32_t *crc) {
+    int idx, off=0;
+    for (idx=0; idx<iovcnt; idx++) {
+        uint64_t part=0;
+        uint32_t val;
+        if (iov[idx].len<=0) continue;
+        copy_checksum_crc_( dst+off
+                          , (iov[idx].base!=0) ? iov[idx].base : dst+off
+                          , iov[idx].len
+                          , (sum!=NULL) ? &part : NULL
+                          , crc);
+        if (sum!=NULL) {
+            val = order_checksum(part);
+            if (off&1) val = ((val>>8)|(val<<8))&0xFFFF;
+            *sum = fold_checksum((uint64_t)*sum+val);
+        }
+        off += iov[idx].len;
+    }
+    return off;
+}
+
+//-----------------------------------------------------
+// It returns CRC (without inversion) updated for 'num' bytes of 'field',
+// which were zero when CRC was computed and are followed by 'follow' bytes.
+static uint32_t patch_field_eth_crc(uint32_t crc, const uint8_t *field, int num, int follow) {
+    uint32_t delta = update_eth_crc(0, field, num);
+    return crc^mult_mod_eth_crc(shift_mod_eth_crc((uint32_t)follow), delta);
 }
 //----------------------------------------------------------------------------
 // Data in 'pkt[]' are big-endian fashion.
@@ -232,58 +891,27 @@ uint16_t checksum_incremental_d64(uint16_t old_check, uint64_t old, uint64_t new
 //----------------------------------------------------------------------------
 // return 0 on success, 1 on failure
 int check_checksum(uint8_t* pkt, int bnum) {
-    int idx;
-    uint32_t sum = 0;
-    for (idx=0; idx<(bnum-1); idx+=2) {
-         sum += (pkt[idx]<<8)|pkt[idx+1];
-    }
-    if (idx<bnum) {
-         sum += (pkt[idx]<<8);
-    }
-    sum  = (sum>>16)+(sum&0xFFFF);
-    sum += (sum>>16);
-
-    return (sum==0xFFFF) ? 0 : 1;
+    return (sum_checksum(pkt, bnum)==0xFFFF) ? 0 : 1;
 }
 //-----------------------------------------------------
 // 1. calculate IP header checksum
 // 2. return the host order checksum after inversion
+// Checksum field (the 6th 16-bit word) is skipped.
 uint16_t compute_ip_checksum(ip_hdr_t* iphdr) {
+    const uint8_t *pkt = (const uint8_t*)iphdr;
+    int bnum = iphdr->ip_hdl * 4; // ip_hdl in words
     uint32_t sum;
-    int numShorts;
-    int i;
-    uint16_t* s_ptr;
-
-    sum = 0;
-    numShorts = iphdr->ip_hdl * 2; // ip_hdl in words
-    s_ptr = (uint16_t*)iphdr;
-    for (i=0; i<numShorts; ++i) {
-         if (i!=5) sum += (uint32_t)ntohs(s_ptr[i]);
-    }
 
-    sum  = (sum >> 16) + (sum & 0xFFFF); /* sum carries */
-    sum += (sum >> 16);
+    sum = sum_checksum(pkt, 10)
+        + sum_checksum(pkt+12, bnum-12);
+    sum = fold_checksum(sum);
 
     return (~sum)&0xFFFF;
 }
 // return 0 on sucessful, 1 on failure
 int check_ip_checksum(ip_hdr_t* iphdr) {
-    uint32_t sum;
-    int numShorts;
-    int i;
-    uint16_t* s_ptr;
-
-    sum = 0;
-    numShorts = iphdr->ip_hdl * 2; // ip_hdl in words
-    s_ptr = (uint16_t*)iphdr;
-    for (i=0; i<numShorts; ++i) {
-         sum += (uint32_t)ntohs(s_ptr[i]);
-    }
-
-    sum  = (sum >> 16) + (sum & 0xFFFF); /* sum carries */
-    sum += (sum >> 16);
-
-    return (sum==0xFFFF) ? 0 : 1;
+    int bnum = iphdr->ip_hdl * 4; // ip_hdl in words
+    return (sum_checksum((const uint8_t*)iphdr, bnum)==0xFFFF) ? 0 : 1;
 }
 
 //-----------------------------------------------------
@@ -294,54 +922,39 @@ int check_ip_checksum(ip_hdr_t* iphdr) {
 //    [UDP Segment  ] Udp Header + UDP Data
 // 2. return the host order checksum with inversion
 uint16_t compute_udp_checksum(pseudo_ip_hdr_t* ip_hdr, udp_hdr_t* udp_hdr) {
-    uint32_t  sum;
+    const uint8_t *pkt = (const uint8_t*)udp_hdr;
     uint16_t  udp_len;
-    uint16_t *spt;
-    int idx;
+    uint32_t  sum;
     //-----------------------------------------------------
     // calculate checksum of pseudo-header
-    sum = 0;
-    spt = (uint16_t*)ip_hdr;
-    for (idx=0; idx<6; idx++) sum += (uint32_t)ntohs(spt[idx]);
+    sum = sum_checksum((const uint8_t*)ip_hdr, 12);
     //-----------------------------------------------------
     // calculate checksum of udp header and datagram
-    spt = (uint16_t*)udp_hdr;
+    // skipping checksum field (the 4th 16-bit word)
     udp_len = ntohs(udp_hdr->udp_len); //udp_len = ntohs(ip_hdr->ip_len);
-    for (idx=0; idx<(udp_len/2); idx++) {
-         if (idx!=3) sum += (uint32_t)ntohs(spt[idx]);
-    }
-    if (udp_len&0x1) sum += (uint32_t)(ntohs(spt[idx])&0xFF00); // when not multiple of 16-bit
+    sum += sum_checksum(pkt, (udp_len<6) ? udp_len : 6);
+    if (udp_len>8) sum += sum_checksum(pkt+8, udp_len-8);
     //-----------------------------------------------------
     // add carries
-    sum  = (sum>>16) + (sum&0xFFFF); //sum += (sum>>16) + (sum&0xFFFF);
-    sum += (sum>>16);
+    sum = fold_checksum(sum);
     //-----------------------------------------------------
     // invert and return
     return (~sum)&0xFFFF;
 }
 // return 0 on success, 1 on failture
 int check_udp_checksum(pseudo_ip_hdr_t* ip_hdr, udp_hdr_t* udp_hdr) {
-    uint32_t  sum;
     uint16_t  udp_len;
-    uint16_t *spt;
-    int idx;
+    uint32_t  sum;
     //-----------------------------------------------------
     // calculate checksum of pseudo-header
-    sum = 0;
-    spt = (uint16_t*)ip_hdr;
-    for (idx=0; idx<6; idx++) sum += (uint32_t)ntohs(spt[idx]);
+    sum = sum_checksum((const uint8_t*)ip_hdr, 12);
     //-----------------------------------------------------
     // calculate checksum of udp header and datagram
-    spt = (uint16_t*)udp_hdr;
     udp_len = ntohs(ip_hdr->ip_len);
-    for (idx=0; idx<(udp_len/2); idx++) {
-         sum += (uint32_t)ntohs(spt[idx]);
-    }
-    if (udp_len&0x1) sum += (uint32_t)(ntohs(spt[idx])&0xFF00); // when not multiple of 16-bit
+    sum += sum_checksum((const uint8_t*)udp_hdr, udp_len);
     //-----------------------------------------------------
     // add carries
-    sum  = (sum>>16) + (sum&0xFFFF); //sum += (sum>>16) + (sum&0xFFFF);
-    sum += (sum>>16);
+    sum = fold_checksum(sum);
     //-----------------------------------------------------
     // invert and return
     return (sum==0xFFFF) ? 0 : 1;
@@ -365,54 +978,39 @@ int check_udp_checksum(pseudo_ip_hdr_t* ip_hdr, udp_hdr_t* udp_hdr) {
 //
 // Note that 'pseudo_ip_hdr_t' is not the same as 'ip_hdr_t'.
 uint16_t compute_tcp_checksum(pseudo_ip_hdr_t* ip_hdr, tcp_hdr_t* tcp_hdr) {
-    uint32_t  sum;
+    const uint8_t *pkt = (const uint8_t*)tcp_hdr;
     uint16_t  tcp_len;
-    uint16_t *spt;
-    int idx;
+    uint32_t  sum;
     //-----------------------------------------------------
     // calculate checksum of pseudo-header
-    sum = 0;
-    spt = (uint16_t*)ip_hdr;
-    for (idx=0; idx<6; idx++) sum += (uint32_t)ntohs(spt[idx]);
+    sum = sum_checksum((const uint8_t*)ip_hdr, 12);
     //-----------------------------------------------------
     // calculate checksum of tcp header and datagram
-    spt = (uint16_t*)tcp_hdr;
+    // skipping checksum field (the 9th 16-bit word)
     tcp_len = ntohs(ip_hdr->ip_len);
-    for (idx=0; idx<(tcp_len/2); idx++) {
-         if (idx!=8) sum += (uint32_t)ntohs(spt[idx]);
-    }
-    if (tcp_len&0x1) sum += (uint32_t)(ntohs(spt[idx])&0xFF00); // when not multiple of 16-bit
+    sum += sum_checksum(pkt, (tcp_len<16) ? tcp_len : 16);
+    if (tcp_len>18) sum += sum_checksum(pkt+18, tcp_len-18);
     //-----------------------------------------------------
     // add carries
-    sum  = (sum>>16) + (sum&0xFFFF); //sum += (sum>>16) + (sum&0xFFFF);
-    sum += (sum>>16);
+    sum = fold_checksum(sum);
     //-----------------------------------------------------
     // invert and return
     return (~sum)&0xFFFF;
 }
 // return 0 on success, 1 on failure
 int check_tcp_checksum(pseudo_ip_hdr_t* ip_hdr, tcp_hdr_t* tcp_hdr) {
-    uint32_t  sum;
     uint16_t  tcp_len;
-    uint16_t *spt;
-    int idx;
+    uint32_t  sum;
     //-----------------------------------------------------
     // calculate checksum of pseudo-header
-    sum = 0;
-    spt = (uint16_t*)ip_hdr;
-    for (idx=0; idx<6; idx++) sum += (uint32_t)ntohs(spt[idx]);
+    sum = sum_checksum((const uint8_t*)ip_hdr, 12);
     //-----------------------------------------------------
     // calculate checksum of tcp header and datagram
-    spt = (uint16_t*)tcp_hdr;
     tcp_len = ntohs(ip_hdr->ip_len);
-    for (idx=0; idx<(tcp_len/2); idx++) {
-         sum += (uint32_t)ntohs(spt[idx]);
-    }
-    if (tcp_len&0x1) sum += (uint32_t)(ntohs(spt[idx])&0xFF00); // when not multiple of 16-bit
+    sum += sum_checksum((const uint8_t*)tcp_hdr, tcp_len);
     //-----------------------------------------------------
     // add carries
-    sum  = (sum>>16) + (sum&0xFFFF); //sum += (sum>>16) + (sum&0xFFFF);
-    sum += (sum>>16);
+    sum = fold_checksum(sum);
     //-----------------------------------------------------
     // invert and return
     return (sum==0xFFFF) ? 0 : 1;
@@ -447,6 +1045,58 @@ int populate_eth_hdr( eth_hdr_t *eth_hdr
     return ETH_HDR_LEN;
 }
 
+//-----------------------------------------------------
+// Populates an Ethernet header with VLAN tags, where tags are written
+// in place between MAC SRC and type-length, i.e., outer tag first.
+// Return the number of bytes
+int populate_eth_vlan_hdr( uint8_t  *eth
+                         , uint8_t   mac_src[6]// src MAC (network order)
+                         , uint8_t   mac_dst[6]// dest MAC (network order)
+                         , const pkt_vlan_t *vlan // tags
+                         , int       vlan_num  // num of tags
+                         , uint16_t  type_len  // leng or type (host order)
+                         )
+{
+    uint8_t *pnt;
+    int idx;
+
+    if (vlan_num<=0) return populate_eth_hdr((eth_hdr_t*)eth, mac_src, mac_dst, type_len);
+    if (mac_dst) memcpy((void*)eth, (void*)mac_dst, ETH_ADDR_LEN);
+    if (mac_src) memcpy((void*)(eth+ETH_ADDR_LEN), (void*)mac_src, ETH_ADDR_LEN);
+    pnt = eth+2*ETH_ADDR_LEN;
+    for (idx=0; idx<vlan_num; idx++) {
+         pnt[0] = (vlan[idx].tpid>>8)&0xFF;
+         pnt[1] = (vlan[idx].tpid   )&0xFF;
+         pnt[2] = (vlan[idx].tci >>8)&0xFF;
+         pnt[3] = (vlan[idx].tci    )&0xFF;
+         pnt += ETH_VLAN_TAG_LEN;
+    }
+    pnt[0] = (type_len>>8)&0xFF;
+    pnt[1] = (type_len   )&0xFF;
+
+    return ETH_HDR_LEN+vlan_num*ETH_VLAN_TAG_LEN;
+}
+
+//-----------------------------------------------------
+// It walks VLAN tags (0x8100, 0x88A8) if any and returns num of bytes
+// of Ethernet header including tags, where 'type_len' gets the type-length
+// following the tags; -1 when 'leng' is too short.
+int get_eth_type( const uint8_t *eth, int leng, uint16_t *type_len )
+{
+    int idx = 2*ETH_ADDR_LEN;
+    uint16_t type;
+
+    if (leng<ETH_HDR_LEN) return -1;
+    type = (eth[idx]<<8)|eth[idx+1];
+    while ((type==ETH_TYPE_VLAN)||(type==ETH_TYPE_QINQ)) {
+        idx += ETH_VLAN_TAG_LEN;
+        if ((idx+2)>leng) return -1;
+        type = (eth[idx]<<8)|eth[idx+1];
+    }
+    if (type_len) *type_len = type;
+    return idx+2;
+}
+
 //-----------------------------------------------------
 // Populates an ARP header
 int populate_arp_hdr( arp_hdr_t *hdr
@@ -548,6 +1198,48 @@ int populate_pseudo_ip_hdr( pseudo_ip_hdr_t *ip_hdr
     return IP_HDR_LEN;
 }
 
+//-----------------------------------------------------
+// Populates an IPv6 header with the usual data.
+// Traffic class and flow label are zero.
+int populate_ipv6_hdr( ipv6_hdr_t *ip_hdr
+                     , uint8_t     ip_src[16] // network order
+                     , uint8_t     ip_dst[16] // network order
+                     , uint8_t     next_hdr
+                     , uint8_t     hop_limit
+                     , uint16_t    payload_size // pure payload size (not including header)
+                     )
+{
+    uint32_t vfc = htonl(6<<28);
+    uint16_t len = htons(payload_size);
+    // fields can be mis-aligned, e.g., following 14-byte Ethernet header
+    memcpy((void*)&ip_hdr->ip6_vfc, (void*)&vfc, 4);
+    memcpy((void*)&ip_hdr->ip6_len, (void*)&len, 2);
+    ip_hdr->ip6_nxt  = next_hdr;
+    ip_hdr->ip6_hlim = hop_limit;
+    memcpy((void*)ip_hdr->ip6_src, (void*)ip_src, IPV6_ADDR_LEN);
+    memcpy((void*)ip_hdr->ip6_dst, (void*)ip_dst, IPV6_ADDR_LEN);
+    return IPV6_HDR_LEN;
+}
+
+//-----------------------------------------------------
+// Populates an IPv6 pseudo header for UDP/TCP checksum (RFC 8200).
+int populate_pseudo_ipv6_hdr( pseudo_ipv6_hdr_t *ip_hdr
+                            , uint8_t            ip_src[16] // network order
+                            , uint8_t            ip_dst[16] // network order
+                            , uint8_t            next_hdr   // upper-layer protocol
+                            , uint32_t           length // upper-layer packet size including its header
+                            )
+{
+    memcpy((void*)ip_hdr->ip6_src, (void*)ip_src, IPV6_ADDR_LEN);
+    memcpy((void*)ip_hdr->ip6_dst, (void*)ip_dst, IPV6_ADDR_LEN);
+    ip_hdr->ip6_len    = htonl(length);
+    ip_hdr->ip6_zro[0] = 0;
+    ip_hdr->ip6_zro[1] = 0;
+    ip_hdr->ip6_zro[2] = 0;
+    ip_hdr->ip6_nxt    = next_hdr;
+    return PSEUDO_IPV6_HDR_LEN;
+}
+
 //-----------------------------------------------------
 // Populates an UDP header with the usual data.
 // It zeros checksum.
@@ -605,9 +1297,9 @@ int populate_tcp_hdr( tcp_hdr_t *tcp_hdr
      tcp_hdr->port_dst = htons(port_dst); // what if mis-aligned
      tcp_hdr->tcp_seq  = htonl(num_seq ); // what if mis-aligned
      tcp_hdr->tcp_ack  = htonl(num_ack ); // what if mis-aligned
-     tcp_hdr->tcp_hl   = (TCP_HDR_LEN+3)/4; // it should be 5; higher 4-bit is valid
-     tcp_hdr->tcp_rsv  = 0; // reserved
-     tcp_hdr->tcp_ctl  = 0; // lower 6-bit is valid
+     // header length and control by byte, since bit-field order depends on compiler
+     ((uint8_t*)tcp_hdr)[12] = ((TCP_HDR_LEN+3)/4)<<4; // it should be 5; higher 4-bit is valid
+     ((uint8_t*)tcp_hdr)[13] = 0; // reserved and control; lower 6-bit is valid
      tcp_hdr->tcp_win  = 0;
      tcp_hdr->tcp_sum  = 0; // should be zero (to be used to calculate check sum with IP header)
      tcp_hdr->tcp_pnt  = 0;
@@ -615,30 +1307,151 @@ int populate_tcp_hdr( tcp_hdr_t *tcp_hdr
      return TCP_HDR_LEN;
 }
 
+//-----------------------------------------------------
+// Populates an ICMP/ICMPv6 echo header.
+// It zeros checksum.
+int populate_icmp_echo_hdr( icmp_echo_hdr_t *icmp_hdr
+                          , uint8_t   type // ICMP_TYPE_ECHO_* or ICMPV6_TYPE_ECHO_*
+                          , uint16_t  id   // host order
+                          , uint16_t  seq  // host order
+                          )
+{
+    uint16_t val;
+    icmp_hdr->icmp_type = type;
+    icmp_hdr->icmp_code = ICMP_CODE_ECHO;
+    // fields can be mis-aligned, e.g., following 14-byte Ethernet header and IPv6 header
+    val = 0;          memcpy((void*)&icmp_hdr->icmp_sum, (void*)&val, 2);
+    val = htons(id ); memcpy((void*)&icmp_hdr->icmp_id , (void*)&val, 2);
+    val = htons(seq); memcpy((void*)&icmp_hdr->icmp_seq, (void*)&val, 2);
+    return ICMP_ECHO_HDR_LEN;
+}
+
+//-----------------------------------------------------
+// It copies payload following headers of Ethernet packet and
+// fills UDP/TCP checksum, padding and CRC while payload is read once.
+// eth: Ethernet header
+// hdr: UDP/TCP header, which is just before payload
+// hdr_len: num of bytes of 'hdr'
+// sum_off: offset of checksum field in 'hdr', which should be zero
+// iov: payload fragments to copy, which can be just after 'hdr' already
+// min_len: num of bytes from 'hdr' that Ethernet payload should have at least
+// pseudo_hdr: IPv4 or IPv6 pseudo header for checksum, no checksum when NULL
+// pseudo_len: num of bytes of 'pseudo_hdr', i.e., 12 or 40, 0 for ICMP
+// add_crc: padding and CRC are added when 1
+// return: num of bytes from payload to CRC (if any)
+static int fill_eth_payload_pseudo_iov( uint8_t           *eth
+                                      , uint8_t           *hdr
+                                      , int                hdr_len
+                                      , int                sum_off
+                                      , const pkt_iovec_t *iov
+                                      , int                iovcnt
+                                      , int                min_len
+                                      , const void        *pseudo_hdr
+                                      , int                pseudo_len
+                                      , int                add_crc)
+{
+    uint8_t *pld = hdr+hdr_len;
+    uint32_t sum = 0;
+    uint32_t crc = 0xFFFFFFFF;
+    uint16_t check = 0;
+    int payload_len, idx;
+
+    if (add_crc) crc = update_eth_crc(crc, eth, (int)(pld-eth));
+    payload_len = copy_checksum_crc_iov( pld
+                                       , iov
+                                       , iovcnt
+                                       , (pseudo_hdr!=NULL) ? &sum : NULL
+                                       , (add_crc) ? &crc : NULL);
+    if (pseudo_hdr!=NULL) {
+        uint64_t val = sum_checksum((const uint8_t*)pseudo_hdr, pseudo_len)
+                     + sum_checksum(hdr, hdr_len)
+                     + sum;
+        check = htons((~fold_checksum(val))&0xFFFF);
+        if ((pseudo_len==PSEUDO_IPV6_HDR_LEN)&&(sum_off==6)&&(check==0)) {
+            check = 0xFFFF; // UDP over IPv6 should not carry zero checksum
+        }
+        memcpy((void*)&hdr[sum_off], (void*)&check, 2);
+    }
+    if (!add_crc) return payload_len;
+    for (idx=payload_len; idx<(min_len-hdr_len); idx++) {
+         // fill padding if packe is less than 46.
+         // Ethernet requires minimum 46-byte of its payload,
+         // which is pure Ethernet payload, i.e., excluding MAC SRC/DST/TypeLen.
+         pld[idx] = 0x00;
+    }
+    crc = update_eth_crc(crc, &pld[payload_len], idx-payload_len);
+    if (pseudo_hdr!=NULL) {
+        // CRC was computed with zero checksum field.
+        crc = patch_field_eth_crc(crc, &hdr[sum_off], 2, hdr_len-sum_off-2+idx);
+    }
+    crc = ~crc;
+    memcpy((void*)&pld[idx], (void*)&crc, 4);
+    return idx+4;
+}
+
+//-----------------------------------------------------
+// Same as fill_eth_payload_pseudo_iov() with IPv4 pseudo header.
+static int fill_eth_payload_iov( uint8_t           *eth
+                               , uint8_t           *hdr
+                               , int                hdr_len
+                               , int                sum_off
+                               , const pkt_iovec_t *iov
+                               , int                iovcnt
+                               , int                min_len
+                               , pseudo_ip_hdr_t   *pseudo_ip_hdr
+                               , int                add_crc)
+{
+    return fill_eth_payload_pseudo_iov( eth, hdr, hdr_len, sum_off, iov, iovcnt
+                                      , min_len, pseudo_ip_hdr, 12, add_crc);
+}
+
+//-----------------------------------------------------
+// Same as fill_eth_payload_iov() with a single fragment 'src'.
+static int fill_eth_payload( uint8_t         *eth
+                           , uint8_t         *hdr
+                           , int              hdr_len
+                           , int              sum_off
+                           , const uint8_t   *src
+                           , int              payload_len
+                           , int              min_len
+                           , pseudo_ip_hdr_t *pseudo_ip_hdr
+                           , int              add_crc)
+{
+    pkt_iovec_t iov;
+    iov.base = src;
+    iov.len  = payload_len;
+    return fill_eth_payload_iov( eth, hdr, hdr_len, sum_off, &iov, 1
+                               , min_len, pseudo_ip_hdr, add_crc);
+}
+
 //-----------------------------------------------------
 // It generates raw Ethernet packet.
 // 1. add preamble if 'add_preamble' is 1
-// 2. build Ethernet header
+// 2. build Ethernet header with VLAN tags if any
 // 3. copy payload data from 'payload' to 'packet'
 // 4. add padding if required
 // 5. add crc if 'add_crc' is 1
-int gen_eth_packet( uint8_t  *packet
-                  , uint8_t   mac_src[6] // network order
-                  , uint8_t   mac_dst[6] // network order
-                  , uint16_t  type_len   // type-length host order
-                  , uint16_t  payload_len // Ethernet payload length
-                  , uint8_t  *payload // pure payload
-                  , int add_crc
-                  , int add_preamble
-                  )
+int gen_eth_packet_vlan( uint8_t  *packet
+                       , uint8_t   mac_src[6] // network order
+                       , uint8_t   mac_dst[6] // network order
+                       , const pkt_vlan_t *vlan // tags, outer first
+                       , int       vlan_num   // num of tags
+                       , uint16_t  type_len   // type-length host order
+                       , int       payload_len // Ethernet payload length
+                       , uint8_t  *payload // pure payload
+                       , int add_crc
+                       , int add_preamble
+                       )
 {
-    int pkt_len=0;
+    int pkt_len=0, hdr_len;
 
     //----------------------------------------------------------------------------
     #if defined(RIGOR)
     if (type_len==0) printf("%s()@%s type-len should be positive number, but %d\n", __FUNCTION__, __FILE__, type_len);
     if (payload_len==0) printf("%s()@%s payload-len should be positive number, but %d\n", __FUNCTION__, __FILE__, payload_len);
     #endif
+    if ((payload_len<0)||(payload_len>ETH_PAYLOAD_MAX)) return -1;
+    if ((vlan_num<0)||(vlan_num>PKT_VLAN_MAX)||(vlan_num&&(vlan==NULL))) return -1;
     //----------------------------------------------------------------------------
     // add preamble
     if (add_preamble) {
@@ -650,33 +1463,31 @@ int gen_eth_packet( uint8_t  *packet
     //----------------------------------------------------------------------------
     // fill Ethernet header
     eth_hdr_t* eth_hdr = (eth_hdr_t*)&packet[pkt_len];
-    pkt_len += populate_eth_hdr( eth_hdr
-                               , mac_src
-                               , mac_dst
-                               , type_len);
+    hdr_len = populate_eth_vlan_hdr( (uint8_t*)eth_hdr
+                                   , mac_src
+                                   , mac_dst
+                                   , vlan
+                                   , vlan_num
+                                   , type_len);
+    pkt_len += hdr_len;
 
     //----------------------------------------------------------------------------
     // copy payload
-    uint8_t *pld = (uint8_t*)(((uint8_t*)eth_hdr)+ETH_HDR_LEN);
-    if (payload!=0) {
-        memcpy((void*)pld, (void*)payload, payload_len);
-    }
-
-    //----------------------------------------------------------------------------
-    // add crc if any
+    uint8_t *pld = (uint8_t*)(((uint8_t*)eth_hdr)+hdr_len);
     if (add_crc) {
-        int idx;
-        for (idx=payload_len; idx<46; idx++) {
-             // fill padding if packe is less than 46.
-             // Ethernet requires minimum 46-byte of its payload,
-             // which is pure Ethernet payload, i.e., excluding MAC SRC/DST/TypeLen.
-             pld[idx] = 0x00;
-        }
-        pkt_len += idx;
-        uint32_t crc = compute_eth_crc((uint8_t*)eth_hdr, ETH_HDR_LEN+idx);
-        memcpy((void*)&pld[idx], (void*)&crc, 4);
-        pkt_len += 4;
+        // CRC is computed while copying payload.
+        pkt_len += fill_eth_payload( (uint8_t*)eth_hdr
+                                   , pld
+                                   , 0, 0
+                                   , (payload!=0) ? payload : pld
+                                   , payload_len
+                                   , 46-vlan_num*ETH_VLAN_TAG_LEN
+                                   , NULL
+                                   , 1);
     } else {
+      if (payload!=0) {
+          memcpy((void*)pld, (void*)payload, payload_len);
+      }
       pkt_len += payload_len;
     }
 
@@ -685,6 +1496,22 @@ int gen_eth_packet( uint8_t  *packet
     return pkt_len;
 }
 
+//-----------------------------------------------------
+// Same as gen_eth_packet_vlan() without VLAN tag.
+int gen_eth_packet( uint8_t  *packet
+                  , uint8_t   mac_src[6] // network order
+                  , uint8_t   mac_dst[6] // network order
+                  , uint16_t  type_len   // type-length host order
+                  , int       payload_len // Ethernet payload length
+                  , uint8_t  *payload // pure payload
+                  , int add_crc
+                  , int add_preamble
+                  )
+{
+    return gen_eth_packet_vlan( packet, mac_src, mac_dst, NULL, 0, type_len
+                              , payload_len, payload, add_crc, add_preamble);
+}
+
 //-----------------------------------------------------
 // It generates IP packet.
 // 1. build IP header
@@ -696,13 +1523,14 @@ int gen_ip_packet( uint8_t  *packet
                  , uint32_t  ip_dst // host order order
                  , uint8_t   protocol
                  , uint8_t   ttl
-                 , uint16_t  payload_len // IP payload length
+                 , int       payload_len // IP payload length
                  , uint8_t  *payload // pure payload
                  , int       check // update UDP or TCP header checksum when 1
                  )
 {
     int pkt_len=0;
 
+    if ((payload_len<0)||(payload_len>(IP_PKT_MAX-IP_HDR_LEN))) return -1;
     //----------------------------------------------------------------------------
     // fill Ethernet header
     ip_hdr_t* ip_hdr = (ip_hdr_t*)packet;
@@ -714,32 +1542,92 @@ int gen_ip_packet( uint8_t  *packet
                               , payload_len);
 
     //----------------------------------------------------------------------------
-    // copy payload
+    // copy payload while calculating TCP/UDP packet checksum
+    // 'payload_len' covers TCP/UDP header as well as its payload.
     uint8_t *pld = (uint8_t*)(((uint8_t*)ip_hdr)+IP_HDR_LEN);
-    if (payload!=0) {
-        memcpy((void*)pld, (void*)payload, payload_len);
+    const uint8_t *src = (payload!=0) ? payload : pld;
+    int sum_off = -1;
+    if (check) {
+        if (protocol==IP_PROTO_TCP) sum_off = 16; // the 9th 16-bit word
+        else if (protocol==IP_PROTO_UDP) sum_off = 6; // the 4th 16-bit word
     }
-    pkt_len += payload_len;
-
-    //----------------------------------------------------------------------------
-    // calculate TCP/UDP packet checksum
-    if (check&&payload_len) {
+    if ((sum_off>=0)&&(payload_len>=(sum_off+2))) {
         pseudo_ip_hdr_t pseudo_ip_hdr;
+        uint64_t sum=0, val;
+        uint16_t check_sum;
         pseudo_ip_hdr.ip_src = htonl(ip_src);
         pseudo_ip_hdr.ip_dst = htonl(ip_dst);
         pseudo_ip_hdr.ip_zro = 0x00;
         pseudo_ip_hdr.ip_pro = protocol;
-        if (protocol==IP_PROTO_TCP) {
-            tcp_hdr_t* tcp_hdr = (tcp_hdr_t*)(((uint8_t*)ip_hdr)+IP_HDR_LEN);
-            pseudo_ip_hdr.ip_len = htons(TCP_HDR_LEN+payload_len);
-            tcp_hdr->tcp_sum = htons(compute_tcp_checksum(&pseudo_ip_hdr, tcp_hdr));
-        } else 
-        if (protocol==IP_PROTO_UDP) {
-            udp_hdr_t* udp_hdr = (udp_hdr_t*)(((uint8_t*)ip_hdr)+IP_HDR_LEN);
-            pseudo_ip_hdr.ip_len = htons(UDP_HDR_LEN+payload_len);
-            udp_hdr->udp_sum = htons(compute_udp_checksum(&pseudo_ip_hdr, udp_hdr));
-        }
+        pseudo_ip_hdr.ip_len = htons(payload_len);
+        copy_checksum_crc_(pld, src, sum_off, &sum, NULL);
+        copy_checksum_crc_(&pld[sum_off+2], &src[sum_off+2], payload_len-sum_off-2, &sum, NULL);
+        val = sum_checksum((const uint8_t*)&pseudo_ip_hdr, 12) + order_checksum(sum);
+        check_sum = htons((~fold_checksum(val))&0xFFFF);
+        memcpy((void*)&pld[sum_off], (void*)&check_sum, 2);
+    } else if (payload!=0) {
+        memcpy((void*)pld, (void*)payload, payload_len);
     }
+    pkt_len += payload_len;
+
+    //----------------------------------------------------------------------------
+    return pkt_len;
+}
+
+//-----------------------------------------------------
+// It generates IPv6 packet without extension header.
+// 1. build IPv6 header
+// 2. copy payload data from 'payload' to 'packet'
+// 3. update checksum for TCP, UDP or ICMPv6 with IPv6 pseudo header
+//    (to do this, 'payload' should be proper packet)
+int gen_ipv6_packet( uint8_t  *packet
+                   , uint8_t   ip_src[16] // network order
+                   , uint8_t   ip_dst[16] // network order
+                   , uint8_t   next_hdr
+                   , uint8_t   hop_limit
+                   , int       payload_len // IPv6 payload length
+                   , uint8_t  *payload // pure payload
+                   , int       check // update UDP, TCP or ICMPv6 header checksum when 1
+                   )
+{
+    int pkt_len=0;
+
+    if ((payload_len<0)||(payload_len>IPV6_PAYLOAD_MAX)) return -1;
+    //----------------------------------------------------------------------------
+    // fill IPv6 header
+    ipv6_hdr_t* ip_hdr = (ipv6_hdr_t*)packet;
+    pkt_len += populate_ipv6_hdr( ip_hdr
+                                , ip_src
+                                , ip_dst
+                                , next_hdr
+                                , hop_limit
+                                , payload_len);
+
+    //----------------------------------------------------------------------------
+    // copy payload while calculating TCP/UDP/ICMPv6 packet checksum
+    uint8_t *pld = (uint8_t*)(((uint8_t*)ip_hdr)+IPV6_HDR_LEN);
+    const uint8_t *src = (payload!=0) ? payload : pld;
+    int sum_off = -1;
+    if (check) {
+        if (next_hdr==IP_PROTO_TCP) sum_off = 16; // the 9th 16-bit word
+        else if (next_hdr==IP_PROTO_UDP) sum_off = 6; // the 4th 16-bit word
+        else if (next_hdr==IPV6_NEXT_ICMPV6) sum_off = 2; // the 2nd 16-bit word
+    }
+    if ((sum_off>=0)&&(payload_len>=(sum_off+2))) {
+        pseudo_ipv6_hdr_t pseudo_ip_hdr;
+        uint64_t sum=0, val;
+        uint16_t check_sum;
+        populate_pseudo_ipv6_hdr(&pseudo_ip_hdr, ip_src, ip_dst, next_hdr, payload_len);
+        copy_checksum_crc_(pld, src, sum_off, &sum, NULL);
+        copy_checksum_crc_(&pld[sum_off+2], &src[sum_off+2], payload_len-sum_off-2, &sum, NULL);
+        val = sum_checksum((const uint8_t*)&pseudo_ip_hdr, PSEUDO_IPV6_HDR_LEN) + order_checksum(sum);
+        check_sum = htons((~fold_checksum(val))&0xFFFF);
+        if ((next_hdr==IP_PROTO_UDP)&&(check_sum==0)) check_sum = 0xFFFF;
+        memcpy((void*)&pld[sum_off], (void*)&check_sum, 2);
+    } else if (payload!=0) {
+        memcpy((void*)pld, (void*)payload, payload_len);
+    }
+    pkt_len += payload_len;
 
     //----------------------------------------------------------------------------
     return pkt_len;
@@ -752,12 +1640,13 @@ int gen_ip_packet( uint8_t  *packet
 int gen_udp_packet( uint8_t  *packet
                   , uint16_t  port_src // host order order
                   , uint16_t  port_dst // host order order
-                  , uint16_t  payload_len // IP payload length
+                  , int       payload_len // IP payload length
                   , uint8_t  *payload // pure payload
                   )
 {
     int pkt_len=0;
 
+    if ((payload_len<0)||(payload_len>UDP_PAYLOAD_MAX)) return -1;
     //----------------------------------------------------------------------------
     // fill Ethernet header
     udp_hdr_t* udp_hdr = (udp_hdr_t*)packet;
@@ -790,12 +1679,13 @@ int gen_tcp_packet( uint8_t  *packet
                   , uint16_t  port_dst // host order order
                   , uint32_t  num_seq  // host order order
                   , uint32_t  num_ack  // host order order
-                  , uint16_t  payload_len // IP payload length
+                  , int       payload_len // IP payload length
                   , uint8_t  *payload // pure payload
                   )
 {
     int pkt_len=0;
 
+    if ((payload_len<0)||(payload_len>TCP_PAYLOAD_MAX)) return -1;
     //----------------------------------------------------------------------------
     // fill Ethernet header
     tcp_hdr_t* tcp_hdr = (tcp_hdr_t*)packet;
@@ -818,6 +1708,36 @@ int gen_tcp_packet( uint8_t  *packet
 }
 
 //-----------------------------------------------------
+// It generates Ethernet packet containing ARP.
+// 1. add preamble if 'add_preamble' is 1
+// 2. build Ethernet header with VLAN tags if any
+// 3. build ARP, where 'mac_dst' goes to target hardware address as well
+// 4. add padding and crc if 'add_crc' is 1
+int gen_eth_arp_packet_vlan( uint8_t  *packet
+                           , uint8_t   mac_src[6] // network order
+                           , uint8_t   mac_dst[6] // network order
+                           , const pkt_vlan_t *vlan // tags, outer first
+                           , int       vlan_num   // num of tags
+                           , uint16_t  type       // ARP type
+                           , uint32_t  ip_src     // host order
+                           , uint32_t  ip_dst     // host order
+                           , int add_crc
+                           , int add_preamble
+                           )
+{
+    if ((vlan_num<0)||(vlan_num>PKT_VLAN_MAX)||(vlan_num&&(vlan==NULL))) return -1;
+    //----------------------------------------------------------------------------
+    // fill ARP in place and then Ethernet header around it
+    arp_hdr_t* arp_hdr = (arp_hdr_t*)&packet[((add_preamble) ? 8 : 0)
+                                            +ETH_HDR_LEN+vlan_num*ETH_VLAN_TAG_LEN];
+    populate_arp_hdr( arp_hdr
+                    , type, mac_src, mac_dst, ip_src, ip_dst);
+    return gen_eth_packet_vlan( packet, mac_src, mac_dst, vlan, vlan_num, ETH_TYPE_ARP
+                              , ARP_HDR_LEN, 0, add_crc, add_preamble);
+}
+
+//-----------------------------------------------------
+// Same as gen_eth_arp_packet_vlan() without VLAN tag.
 int gen_eth_arp_packet( uint8_t  *packet
                       , uint8_t   mac_src[6] // network order
                       , uint8_t   mac_dst[6] // network order
@@ -828,52 +1748,14 @@ int gen_eth_arp_packet( uint8_t  *packet
                       , int add_preamble
                       )
 {
-    int pkt_len=0;
-    //----------------------------------------------------------------------------
-    // add preamble
-    if (add_preamble) {
-        int idx;
-        for (idx=0; idx<7; idx++) packet[idx] = 0x55;
-        packet[7] = 0xD5;
-        pkt_len = 8;
-    }
-    //----------------------------------------------------------------------------
-    // fill Ethernet header
-    eth_hdr_t* eth_hdr = (add_preamble) ? (eth_hdr_t*)&packet[8]
-                                        : (eth_hdr_t*)packet;
-    pkt_len += populate_eth_hdr( eth_hdr
-                               , mac_src
-                               , mac_dst
-                               , ETH_TYPE_ARP);
-    //----------------------------------------------------------------------------
-    // fill ARP
-    arp_hdr_t* arp_hdr = (arp_hdr_t*)(((uint8_t*)eth_hdr)+ETH_HDR_LEN);
-    pkt_len += populate_arp_hdr( arp_hdr
-                               , type, mac_src, mac_dst, ip_src, ip_dst);
-    //----------------------------------------------------------------------------
-    // add crc if any
-    if (add_crc) {
-        int idx;
-        uint8_t *pld = (uint8_t*)(((uint8_t*)arp_hdr)+ARP_HDR_LEN);
-        for (idx=0; idx<(46-ARP_HDR_LEN); idx++) {
-             // fill padding if packe is less than 46.
-             // Ethernet requires minimum 46-byte of its payload,
-             // which is pure Ethernet payload, i.e., excluding MAC SRC/DST/TypeLen.
-             pld[idx] = 0x00;
-        }
-        pkt_len += idx;
-        uint32_t crc = compute_eth_crc((uint8_t*)eth_hdr, ETH_HDR_LEN+ARP_HDR_LEN+idx);
-        memcpy((void*)&arp_hdr[ARP_HDR_LEN], (void*)&crc, 4);
-        pkt_len += 4;
-    }
-    //----------------------------------------------------------------------------
-    return pkt_len;
+    return gen_eth_arp_packet_vlan( packet, mac_src, mac_dst, NULL, 0, type
+                                  , ip_src, ip_dst, add_crc, add_preamble);
 }
 
 //-----------------------------------------------------
 // It generates Ethernet packet containing UDP over IP.
 // 1. add preamble if 'add_preamble' is 1
-// 2. build Ethernet header
+// 2. build Ethernet header with VLAN tags if any
 // 3. build IP header
 // 4. build UDP header
 // 5. copy payload data from 'payload' to 'packet', when 'payload' is not 0
@@ -882,21 +1764,25 @@ int gen_eth_arp_packet( uint8_t  *packet
 //
 // Note that 'payload_len' can be non-zero whiel 'payload' is 0,
 //           when UDP payload has been built before being called this.
-int gen_eth_ip_udp_packet( uint8_t  *packet
-                         , uint8_t   mac_src[6] // network order
-                         , uint8_t   mac_dst[6] // network order
-                         , uint32_t  ip_src     // host order
-                         , uint32_t  ip_dst     // host order
-                         , uint16_t  port_src   // 0x0001; host order
-                         , uint16_t  port_dst   // 0x0002; host order
-                         , uint16_t  payload_len // UDP payload length
-                         , uint8_t  *payload // udp payload (pure)
-                         , int check           // update UDP header checksum when 1
-                         , int add_crc         // add CRC at the end of packet when 1
-                         , int add_preamble    // add preamble at the beginnin of packet when 1
-                         )
+int gen_eth_ip_udp_packet_vlan( uint8_t  *packet
+                              , uint8_t   mac_src[6] // network order
+                              , uint8_t   mac_dst[6] // network order
+                              , const pkt_vlan_t *vlan // tags, outer first
+                              , int       vlan_num   // num of tags
+                              , uint32_t  ip_src     // host order
+                              , uint32_t  ip_dst     // host order
+                              , uint16_t  port_src   // 0x0001; host order
+                              , uint16_t  port_dst   // 0x0002; host order
+                              , int       payload_len // UDP payload length
+                              , uint8_t  *payload // udp payload (pure)
+                              , int check           // update UDP header checksum when 1
+                              , int add_crc         // add CRC at the end of packet when 1
+                              , int add_preamble    // add preamble at the beginnin of packet when 1
+                              )
 {
-    int pkt_len=0;
+    int pkt_len=0, hdr_len;
+    if ((payload_len<0)||(payload_len>UDP_PAYLOAD_MAX)) return -1;
+    if ((vlan_num<0)||(vlan_num>PKT_VLAN_MAX)||(vlan_num&&(vlan==NULL))) return -1;
     //----------------------------------------------------------------------------
     // add preamble
     if (add_preamble) {
@@ -909,14 +1795,17 @@ int gen_eth_ip_udp_packet( uint8_t  *packet
     // fill Ethernet header
     eth_hdr_t* eth_hdr = (add_preamble) ? (eth_hdr_t*)&packet[8]
                                         : (eth_hdr_t*)packet;
-    pkt_len += populate_eth_hdr( eth_hdr
-                               , mac_src
-                               , mac_dst
-                               , ETH_TYPE_IP);
+    hdr_len = populate_eth_vlan_hdr( (uint8_t*)eth_hdr
+                                   , mac_src
+                                   , mac_dst
+                                   , vlan
+                                   , vlan_num
+                                   , ETH_TYPE_IP);
+    pkt_len += hdr_len;
 
     //----------------------------------------------------------------------------
     // fill IP header
-    ip_hdr_t* ip_hdr = (ip_hdr_t*)(((uint8_t*)eth_hdr)+ETH_HDR_LEN);
+    ip_hdr_t* ip_hdr = (ip_hdr_t*)(((uint8_t*)eth_hdr)+hdr_len);
     pkt_len += populate_ip_hdr( ip_hdr
                               , ip_src
                               , ip_dst
@@ -933,50 +1822,55 @@ int gen_eth_ip_udp_packet( uint8_t  *packet
                                , payload_len);
 
     //----------------------------------------------------------------------------
-    // copy UDP payload
+    // copy UDP payload while calculating UDP checksum and crc if any
     uint8_t *pld = (uint8_t*)(((uint8_t*)udp_hdr)+UDP_HDR_LEN);
-    if (payload!=0) {
-        memcpy((void*)pld, (void*)payload, payload_len);
-    }
-
-    //----------------------------------------------------------------------------
-    // calculate UDP checksum
+    pseudo_ip_hdr_t pseudo_ip_hdr;
     if (check&&payload_len) {
-        pseudo_ip_hdr_t pseudo_ip_hdr;
         pseudo_ip_hdr.ip_src = htonl(ip_src);
         pseudo_ip_hdr.ip_dst = htonl(ip_dst);
         pseudo_ip_hdr.ip_zro = 0x00;
         pseudo_ip_hdr.ip_pro = IP_PROTO_UDP;
         pseudo_ip_hdr.ip_len = htons(UDP_HDR_LEN+payload_len);
-        udp_hdr->udp_sum = htons(compute_udp_checksum(&pseudo_ip_hdr, udp_hdr));
-    }
-
-    //----------------------------------------------------------------------------
-    // add crc if any
-    if (add_crc) {
-        int idx;
-        for (idx=payload_len; idx<(46-IP_HDR_LEN-UDP_HDR_LEN); idx++) {
-             // fill padding if packe is less than 46.
-             // Ethernet requires minimum 46-byte of its payload,
-             // which is pure Ethernet payload, i.e., excluding MAC SRC/DST/TypeLen.
-             pld[idx] = 0x00;
-        }
-        pkt_len += idx;
-        uint32_t crc = compute_eth_crc((uint8_t*)eth_hdr, ETH_HDR_LEN+IP_HDR_LEN+UDP_HDR_LEN+idx);
-        memcpy((void*)&pld[idx], (void*)&crc, 4);
-        pkt_len += 4;
-    } else {
-      pkt_len += payload_len;
     }
+    pkt_len += fill_eth_payload( (uint8_t*)eth_hdr
+                               , (uint8_t*)udp_hdr
+                               , UDP_HDR_LEN
+                               , 6 // checksum field (the 4th 16-bit word)
+                               , (payload!=0) ? payload : pld
+                               , payload_len
+                               , 46-vlan_num*ETH_VLAN_TAG_LEN-IP_HDR_LEN
+                               , (check&&payload_len) ? &pseudo_ip_hdr : NULL
+                               , add_crc);
 
     //----------------------------------------------------------------------------
     return pkt_len;
 }
 
+//-----------------------------------------------------
+// Same as gen_eth_ip_udp_packet_vlan() without VLAN tag.
+int gen_eth_ip_udp_packet( uint8_t  *packet
+                         , uint8_t   mac_src[6] // network order
+                         , uint8_t   mac_dst[6] // network order
+                         , uint32_t  ip_src     // host order
+                         , uint32_t  ip_dst     // host order
+                         , uint16_t  port_src   // 0x0001; host order
+                         , uint16_t  port_dst   // 0x0002; host order
+                         , int       payload_len // UDP payload length
+                         , uint8_t  *payload // udp payload (pure)
+                         , int check           // update UDP header checksum when 1
+                         , int add_crc         // add CRC at the end of packet when 1
+                         , int add_preamble    // add preamble at the beginnin of packet when 1
+                         )
+{
+    return gen_eth_ip_udp_packet_vlan( packet, mac_src, mac_dst, NULL, 0, ip_src, ip_dst
+                                     , port_src, port_dst, payload_len, payload
+                                     , check, add_crc, add_preamble);
+}
+
 //-----------------------------------------------------
 // It generates Ethernet packet containing TCP over IP.
 // 1. add preamble if 'add_preamble' is 1
-// 2. build Ethernet header
+// 2. build Ethernet header with VLAN tags if any
 // 3. build IP header
 // 4. build TCP header
 // 5. copy payload data from 'payload' to 'packet', when 'payload' is not 0
@@ -985,6 +1879,94 @@ int gen_eth_ip_udp_packet( uint8_t  *packet
 //
 // Note that 'payload_len' can be non-zero whiel 'payload' is 0,
 //           when TCP payload has been built before being called this.
+int gen_eth_ip_tcp_packet_vlan( uint8_t  *packet
+                              , uint8_t   mac_src[6] // network order
+                              , uint8_t   mac_dst[6] // network order
+                              , const pkt_vlan_t *vlan // tags, outer first
+                              , int       vlan_num   // num of tags
+                              , uint32_t  ip_src     // host order
+                              , uint32_t  ip_dst     // host order
+                              , uint16_t  port_src   // 0x0001; host order
+                              , uint16_t  port_dst   // 0x0001; host order
+                              , uint32_t  num_seq    // host order
+                              , uint32_t  num_ack    // host order
+                              , int       payload_len // TCP payload length
+                              , uint8_t  *payload   // tcp payload (pure)
+                              , int check           // update TCP header checksum when 1
+                              , int add_crc         // add CRC at the end of packet when 1
+                              , int add_preamble    // add preamble at the beginnin of packet when 1
+                              )
+{
+    int pkt_len=0, hdr_len;
+    if ((payload_len<0)||(payload_len>TCP_PAYLOAD_MAX)) return -1;
+    if ((vlan_num<0)||(vlan_num>PKT_VLAN_MAX)||(vlan_num&&(vlan==NULL))) return -1;
+    //----------------------------------------------------------------------------
+    // add preamble
+    if (add_preamble) {
+        int idx;
+        for (idx=0; idx<7; idx++) packet[idx] = 0x55;
+        packet[7] = 0xD5;
+        pkt_len = 8;
+    }
+    //----------------------------------------------------------------------------
+    // fill Ethernet header
+    eth_hdr_t* eth_hdr = (add_preamble) ? (eth_hdr_t*)&packet[8]
+                                        : (eth_hdr_t*)packet;
+    hdr_len = populate_eth_vlan_hdr( (uint8_t*)eth_hdr
+                                   , mac_src
+                                   , mac_dst
+                                   , vlan
+                                   , vlan_num
+                                   , ETH_TYPE_IP);
+    pkt_len += hdr_len;
+
+    //----------------------------------------------------------------------------
+    // fill IP header
+    ip_hdr_t* ip_hdr = (ip_hdr_t*)(((uint8_t*)eth_hdr)+hdr_len);
+    pkt_len += populate_ip_hdr( ip_hdr
+                              , ip_src
+                              , ip_dst
+                              , IP_PROTO_TCP
+                              , 0x01 // TTL
+                              , TCP_HDR_LEN + payload_len);
+
+    //----------------------------------------------------------------------------
+    // fill TCP header
+    tcp_hdr_t* tcp_hdr = (tcp_hdr_t*)(((uint8_t*)ip_hdr)+IP_HDR_LEN);
+    pkt_len += populate_tcp_hdr( tcp_hdr
+                               , port_src
+                               , port_dst
+                               , num_seq 
+                               , num_ack);
+
+    //----------------------------------------------------------------------------
+    // copy TCP payload while calculating TCP checksum and crc if any
+    // payload_len should be positive for checksum and crc
+    uint8_t *pld = (uint8_t*)(((uint8_t*)tcp_hdr)+TCP_HDR_LEN);
+    pseudo_ip_hdr_t pseudo_ip_hdr;
+    if (check&&payload_len) {
+        pseudo_ip_hdr.ip_src = htonl(ip_src);
+        pseudo_ip_hdr.ip_dst = htonl(ip_dst);
+        pseudo_ip_hdr.ip_zro = 0x00;
+        pseudo_ip_hdr.ip_pro = IP_PROTO_TCP;
+        pseudo_ip_hdr.ip_len = htons(TCP_HDR_LEN+payload_len);
+    }
+    pkt_len += fill_eth_payload( (uint8_t*)eth_hdr
+                               , (uint8_t*)tcp_hdr
+                               , TCP_HDR_LEN
+                               , 16 // checksum field (the 9th 16-bit word)
+                               , (payload!=0) ? payload : pld
+                               , payload_len
+                               , 46-vlan_num*ETH_VLAN_TAG_LEN-IP_HDR_LEN
+                               , (check&&payload_len) ? &pseudo_ip_hdr : NULL
+                               , add_crc&&payload_len);
+
+    //----------------------------------------------------------------------------
+    return pkt_len;
+}
+
+//-----------------------------------------------------
+// Same as gen_eth_ip_tcp_packet_vlan() without VLAN tag.
 int gen_eth_ip_tcp_packet( uint8_t  *packet
                          , uint8_t   mac_src[6] // network order
                          , uint8_t   mac_dst[6] // network order
@@ -994,14 +1976,69 @@ int gen_eth_ip_tcp_packet( uint8_t  *packet
                          , uint16_t  port_dst   // 0x0001; host order
                          , uint32_t  num_seq    // host order
                          , uint32_t  num_ack    // host order
-                         , uint16_t  payload_len // TCP payload length
+                         , int       payload_len // TCP payload length
                          , uint8_t  *payload   // tcp payload (pure)
                          , int check           // update TCP header checksum when 1
                          , int add_crc         // add CRC at the end of packet when 1
                          , int add_preamble    // add preamble at the beginnin of packet when 1
                          )
 {
-    int pkt_len=0;
+    return gen_eth_ip_tcp_packet_vlan( packet, mac_src, mac_dst, NULL, 0, ip_src, ip_dst
+                                     , port_src, port_dst, num_seq, num_ack, payload_len, payload
+                                     , check, add_crc, add_preamble);
+}
+
+//-----------------------------------------------------
+// Same as fill_eth_payload() with IPv6 pseudo header.
+static int fill_eth_payload_v6( uint8_t           *eth
+                              , uint8_t           *hdr
+                              , int                hdr_len
+                              , int                sum_off
+                              , const uint8_t     *src
+                              , int                payload_len
+                              , int                min_len
+                              , pseudo_ipv6_hdr_t *pseudo_ip_hdr
+                              , int                add_crc)
+{
+    pkt_iovec_t iov;
+    iov.base = src;
+    iov.len  = payload_len;
+    return fill_eth_payload_pseudo_iov( eth, hdr, hdr_len, sum_off, &iov, 1
+                                      , min_len, pseudo_ip_hdr, PSEUDO_IPV6_HDR_LEN, add_crc);
+}
+
+//-----------------------------------------------------
+// It generates Ethernet packet containing UDP over IPv6.
+// 1. add preamble if 'add_preamble' is 1
+// 2. build Ethernet header with VLAN tags if any
+// 3. build IPv6 header
+// 4. build UDP header
+// 5. copy payload data from 'payload' to 'packet', when 'payload' is not 0
+// 6. add padding if required
+// 7. add crc if 'add_crc' is 1
+//
+// Note that UDP checksum is mandatory for IPv6, so that 'check' should be 1
+//           except for testing.
+int gen_eth_ipv6_udp_packet_vlan( uint8_t  *packet
+                                , uint8_t   mac_src[6] // network order
+                                , uint8_t   mac_dst[6] // network order
+                                , const pkt_vlan_t *vlan // tags, outer first
+                                , int       vlan_num   // num of tags
+                                , uint8_t   ip_src[16] // network order
+                                , uint8_t   ip_dst[16] // network order
+                                , uint8_t   hop_limit
+                                , uint16_t  port_src   // host order
+                                , uint16_t  port_dst   // host order
+                                , int       payload_len // UDP payload length
+                                , uint8_t  *payload // udp payload (pure)
+                                , int check           // update UDP header checksum when 1
+                                , int add_crc         // add CRC at the end of packet when 1
+                                , int add_preamble    // add preamble at the beginnin of packet when 1
+                                )
+{
+    int pkt_len=0, hdr_len;
+    if ((payload_len<0)||(payload_len>UDP6_PAYLOAD_MAX)) return -1;
+    if ((vlan_num<0)||(vlan_num>PKT_VLAN_MAX)||(vlan_num&&(vlan==NULL))) return -1;
     //----------------------------------------------------------------------------
     // add preamble
     if (add_preamble) {
@@ -1014,73 +2051,1011 @@ int gen_eth_ip_tcp_packet( uint8_t  *packet
     // fill Ethernet header
     eth_hdr_t* eth_hdr = (add_preamble) ? (eth_hdr_t*)&packet[8]
                                         : (eth_hdr_t*)packet;
-    pkt_len += populate_eth_hdr( eth_hdr
-                               , mac_src
-                               , mac_dst
-                               , ETH_TYPE_IP);
+    hdr_len = populate_eth_vlan_hdr( (uint8_t*)eth_hdr
+                                   , mac_src
+                                   , mac_dst
+                                   , vlan
+                                   , vlan_num
+                                   , ETH_TYPE_IPV6);
+    pkt_len += hdr_len;
 
     //----------------------------------------------------------------------------
-    // fill IP header
-    ip_hdr_t* ip_hdr = (ip_hdr_t*)(((uint8_t*)eth_hdr)+ETH_HDR_LEN);
-    pkt_len += populate_ip_hdr( ip_hdr
-                              , ip_src
-                              , ip_dst
-                              , IP_PROTO_TCP
-                              , 0x01 // TTL
-                              , TCP_HDR_LEN + payload_len);
+    // fill IPv6 header
+    ipv6_hdr_t* ip_hdr = (ipv6_hdr_t*)(((uint8_t*)eth_hdr)+hdr_len);
+    pkt_len += populate_ipv6_hdr( ip_hdr
+                                , ip_src
+                                , ip_dst
+                                , IP_PROTO_UDP
+                                , hop_limit
+                                , UDP_HDR_LEN + payload_len);
+
+    //----------------------------------------------------------------------------
+    // fill UDP header
+    udp_hdr_t* udp_hdr = (udp_hdr_t*)(((uint8_t*)ip_hdr)+IPV6_HDR_LEN);
+    pkt_len += populate_udp_hdr( udp_hdr
+                               , port_src
+                               , port_dst
+                               , payload_len);
+
+    //----------------------------------------------------------------------------
+    // copy UDP payload while calculating UDP checksum and crc if any
+    uint8_t *pld = (uint8_t*)(((uint8_t*)udp_hdr)+UDP_HDR_LEN);
+    pseudo_ipv6_hdr_t pseudo_ip_hdr;
+    if (check) {
+        populate_pseudo_ipv6_hdr( &pseudo_ip_hdr, ip_src, ip_dst
+                                , IP_PROTO_UDP, UDP_HDR_LEN+payload_len);
+    }
+    pkt_len += fill_eth_payload_v6( (uint8_t*)eth_hdr
+                                  , (uint8_t*)udp_hdr
+                                  , UDP_HDR_LEN
+                                  , 6 // checksum field (the 4th 16-bit word)
+                                  , (payload!=0) ? payload : pld
+                                  , payload_len
+                                  , 46-vlan_num*ETH_VLAN_TAG_LEN-IPV6_HDR_LEN
+                                  , (check) ? &pseudo_ip_hdr : NULL
+                                  , add_crc);
+
+    //----------------------------------------------------------------------------
+    return pkt_len;
+}
+
+//-----------------------------------------------------
+// Same as gen_eth_ipv6_udp_packet_vlan() without VLAN tag.
+int gen_eth_ipv6_udp_packet( uint8_t  *packet
+                           , uint8_t   mac_src[6] // network order
+                           , uint8_t   mac_dst[6] // network order
+                           , uint8_t   ip_src[16] // network order
+                           , uint8_t   ip_dst[16] // network order
+                           , uint8_t   hop_limit
+                           , uint16_t  port_src   // host order
+                           , uint16_t  port_dst   // host order
+                           , int       payload_len // UDP payload length
+                           , uint8_t  *payload // udp payload (pure)
+                           , int check           // update UDP header checksum when 1
+                           , int add_crc         // add CRC at the end of packet when 1
+                           , int add_preamble    // add preamble at the beginnin of packet when 1
+                           )
+{
+    return gen_eth_ipv6_udp_packet_vlan( packet, mac_src, mac_dst, NULL, 0, ip_src, ip_dst
+                                       , hop_limit, port_src, port_dst, payload_len, payload
+                                       , check, add_crc, add_preamble);
+}
+
+//-----------------------------------------------------
+// It generates Ethernet packet containing TCP over IPv6.
+// 1. add preamble if 'add_preamble' is 1
+// 2. build Ethernet header with VLAN tags if any
+// 3. build IPv6 header
+// 4. build TCP header
+// 5. copy payload data from 'payload' to 'packet', when 'payload' is not 0
+// 6. add padding if required
+// 7. add crc if 'add_crc' is 1
+int gen_eth_ipv6_tcp_packet_vlan( uint8_t  *packet
+                                , uint8_t   mac_src[6] // network order
+                                , uint8_t   mac_dst[6] // network order
+                                , const pkt_vlan_t *vlan // tags, outer first
+                                , int       vlan_num   // num of tags
+                                , uint8_t   ip_src[16] // network order
+                                , uint8_t   ip_dst[16] // network order
+                                , uint8_t   hop_limit
+                                , uint16_t  port_src   // host order
+                                , uint16_t  port_dst   // host order
+                                , uint32_t  num_seq    // host order
+                                , uint32_t  num_ack    // host order
+                                , int       payload_len // TCP payload length
+                                , uint8_t  *payload   // tcp payload (pure)
+                                , int check           // update TCP header checksum when 1
+                                , int add_crc         // add CRC at the end of packet when 1
+                                , int add_preamble    // add preamble at the beginnin of packet when 1
+                                )
+{
+    int pkt_len=0, hdr_len;
+    if ((payload_len<0)||(payload_len>TCP6_PAYLOAD_MAX)) return -1;
+    if ((vlan_num<0)||(vlan_num>PKT_VLAN_MAX)||(vlan_num&&(vlan==NULL))) return -1;
+    //----------------------------------------------------------------------------
+    // add preamble
+    if (add_preamble) {
+        int idx;
+        for (idx=0; idx<7; idx++) packet[idx] = 0x55;
+        packet[7] = 0xD5;
+        pkt_len = 8;
+    }
+    //----------------------------------------------------------------------------
+    // fill Ethernet header
+    eth_hdr_t* eth_hdr = (add_preamble) ? (eth_hdr_t*)&packet[8]
+                                        : (eth_hdr_t*)packet;
+    hdr_len = populate_eth_vlan_hdr( (uint8_t*)eth_hdr
+                                   , mac_src
+                                   , mac_dst
+                                   , vlan
+                                   , vlan_num
+                                   , ETH_TYPE_IPV6);
+    pkt_len += hdr_len;
+
+    //----------------------------------------------------------------------------
+    // fill IPv6 header
+    ipv6_hdr_t* ip_hdr = (ipv6_hdr_t*)(((uint8_t*)eth_hdr)+hdr_len);
+    pkt_len += populate_ipv6_hdr( ip_hdr
+                                , ip_src
+                                , ip_dst
+                                , IP_PROTO_TCP
+                                , hop_limit
+                                , TCP_HDR_LEN + payload_len);
 
     //----------------------------------------------------------------------------
     // fill TCP header
-    tcp_hdr_t* tcp_hdr = (tcp_hdr_t*)(((uint8_t*)ip_hdr)+IP_HDR_LEN);
+    tcp_hdr_t* tcp_hdr = (tcp_hdr_t*)(((uint8_t*)ip_hdr)+IPV6_HDR_LEN);
     pkt_len += populate_tcp_hdr( tcp_hdr
                                , port_src
                                , port_dst
-                               , num_seq 
+                               , num_seq
                                , num_ack);
 
     //----------------------------------------------------------------------------
-    // copy TCP payload
+    // copy TCP payload while calculating TCP checksum and crc if any
     uint8_t *pld = (uint8_t*)(((uint8_t*)tcp_hdr)+TCP_HDR_LEN);
-    if (payload!=0) {
-        memcpy((void*)pld, (void*)payload, payload_len);
+    pseudo_ipv6_hdr_t pseudo_ip_hdr;
+    if (check) {
+        populate_pseudo_ipv6_hdr( &pseudo_ip_hdr, ip_src, ip_dst
+                                , IP_PROTO_TCP, TCP_HDR_LEN+payload_len);
     }
+    pkt_len += fill_eth_payload_v6( (uint8_t*)eth_hdr
+                                  , (uint8_t*)tcp_hdr
+                                  , TCP_HDR_LEN
+                                  , 16 // checksum field (the 9th 16-bit word)
+                                  , (payload!=0) ? payload : pld
+                                  , payload_len
+                                  , 46-vlan_num*ETH_VLAN_TAG_LEN-IPV6_HDR_LEN
+                                  , (check) ? &pseudo_ip_hdr : NULL
+                                  , add_crc);
 
     //----------------------------------------------------------------------------
-    // calculate TCP checksum
-    if (check&&payload_len) {
-        // payload_len should be positive
-        pseudo_ip_hdr_t pseudo_ip_hdr;
-        pseudo_ip_hdr.ip_src = htonl(ip_src);
-        pseudo_ip_hdr.ip_dst = htonl(ip_dst);
-        pseudo_ip_hdr.ip_zro = 0x00;
-        pseudo_ip_hdr.ip_pro = IP_PROTO_TCP;
-        pseudo_ip_hdr.ip_len = htons(TCP_HDR_LEN+payload_len);
-        tcp_hdr->tcp_sum = htons(compute_tcp_checksum(&pseudo_ip_hdr, tcp_hdr));
+    return pkt_len;
+}
+
+//-----------------------------------------------------
+// Same as gen_eth_ipv6_tcp_packet_vlan() without VLAN tag.
+int gen_eth_ipv6_tcp_packet( uint8_t  *packet
+                           , uint8_t   mac_src[6] // network order
+                           , uint8_t   mac_dst[6] // network order
+                           , uint8_t   ip_src[16] // network order
+                           , uint8_t   ip_dst[16] // network order
+                           , uint8_t   hop_limit
+                           , uint16_t  port_src   // host order
+                           , uint16_t  port_dst   // host order
+                           , uint32_t  num_seq    // host order
+                           , uint32_t  num_ack    // host order
+                           , int       payload_len // TCP payload length
+                           , uint8_t  *payload   // tcp payload (pure)
+                           , int check           // update TCP header checksum when 1
+                           , int add_crc         // add CRC at the end of packet when 1
+                           , int add_preamble    // add preamble at the beginnin of packet when 1
+                           )
+{
+    return gen_eth_ipv6_tcp_packet_vlan( packet, mac_src, mac_dst, NULL, 0, ip_src, ip_dst
+                                       , hop_limit, port_src, port_dst, num_seq, num_ack
+                                       , payload_len, payload, check, add_crc, add_preamble);
+}
+
+//-----------------------------------------------------
+// It generates Ethernet packet containing ICMP echo over IP.
+// 1. add preamble if 'add_preamble' is 1
+// 2. build Ethernet header with VLAN tags if any
+// 3. build IP header
+// 4. build ICMP echo header
+// 5. copy payload data from 'payload' to 'packet', when 'payload' is not 0
+// 6. add padding if required
+// 7. add crc if 'add_crc' is 1
+//
+// Note that ICMP checksum covers ICMP header and payload only.
+int gen_eth_ip_icmp_echo_packet_vlan( uint8_t  *packet
+                                    , uint8_t   mac_src[6] // network order
+                                    , uint8_t   mac_dst[6] // network order
+                                    , const pkt_vlan_t *vlan // tags, outer first
+                                    , int       vlan_num   // num of tags
+                                    , uint32_t  ip_src     // host order
+                                    , uint32_t  ip_dst     // host order
+                                    , uint8_t   ttl
+                                    , uint8_t   type       // ICMP_TYPE_ECHO_REQUEST or _REPLY
+                                    , uint16_t  id         // host order
+                                    , uint16_t  seq        // host order
+                                    , int       payload_len // ICMP echo data length
+                                    , uint8_t  *payload // echo data (pure)
+                                    , int add_crc         // add CRC at the end of packet when 1
+                                    , int add_preamble    // add preamble at the beginnin of packet when 1
+                                    )
+{
+    int pkt_len=0, hdr_len;
+    if ((payload_len<0)||(payload_len>ICMP_PAYLOAD_MAX)) return -1;
+    if ((vlan_num<0)||(vlan_num>PKT_VLAN_MAX)||(vlan_num&&(vlan==NULL))) return -1;
+    //----------------------------------------------------------------------------
+    // add preamble
+    if (add_preamble) {
+        int idx;
+        for (idx=0; idx<7; idx++) packet[idx] = 0x55;
+        packet[7] = 0xD5;
+        pkt_len = 8;
     }
+    //----------------------------------------------------------------------------
+    // fill Ethernet header
+    eth_hdr_t* eth_hdr = (add_preamble) ? (eth_hdr_t*)&packet[8]
+                                        : (eth_hdr_t*)packet;
+    hdr_len = populate_eth_vlan_hdr( (uint8_t*)eth_hdr
+                                   , mac_src
+                                   , mac_dst
+                                   , vlan
+                                   , vlan_num
+                                   , ETH_TYPE_IP);
+    pkt_len += hdr_len;
+
+    //----------------------------------------------------------------------------
+    // fill IP header
+    ip_hdr_t* ip_hdr = (ip_hdr_t*)(((uint8_t*)eth_hdr)+hdr_len);
+    pkt_len += populate_ip_hdr( ip_hdr
+                              , ip_src
+                              , ip_dst
+                              , IP_PROTO_ICMP
+                              , ttl
+                              , ICMP_ECHO_HDR_LEN + payload_len);
+
+    //----------------------------------------------------------------------------
+    // fill ICMP echo header
+    icmp_echo_hdr_t* icmp_hdr = (icmp_echo_hdr_t*)(((uint8_t*)ip_hdr)+IP_HDR_LEN);
+    pkt_len += populate_icmp_echo_hdr( icmp_hdr
+                                     , type
+                                     , id
+                                     , seq);
+
+    //----------------------------------------------------------------------------
+    // copy echo data while calculating ICMP checksum and crc if any
+    uint8_t *pld = (uint8_t*)(((uint8_t*)icmp_hdr)+ICMP_ECHO_HDR_LEN);
+    pkt_iovec_t iov;
+    iov.base = (payload!=0) ? payload : pld;
+    iov.len  = payload_len;
+    pkt_len += fill_eth_payload_pseudo_iov( (uint8_t*)eth_hdr
+                                          , (uint8_t*)icmp_hdr
+                                          , ICMP_ECHO_HDR_LEN
+                                          , 2 // checksum field (the 2nd 16-bit word)
+                                          , &iov
+                                          , 1
+                                          , 46-vlan_num*ETH_VLAN_TAG_LEN-IP_HDR_LEN
+                                          , icmp_hdr // no pseudo header
+                                          , 0
+                                          , add_crc);
 
     //----------------------------------------------------------------------------
-    // add crc if any
-    if (add_crc&&payload_len) {
-        // payload_len should be positive
+    return pkt_len;
+}
+
+//-----------------------------------------------------
+// Same as gen_eth_ip_icmp_echo_packet_vlan() without VLAN tag.
+int gen_eth_ip_icmp_echo_packet( uint8_t  *packet
+                               , uint8_t   mac_src[6] // network order
+                               , uint8_t   mac_dst[6] // network order
+                               , uint32_t  ip_src     // host order
+                               , uint32_t  ip_dst     // host order
+                               , uint8_t   ttl
+                               , uint8_t   type       // ICMP_TYPE_ECHO_REQUEST or _REPLY
+                               , uint16_t  id         // host order
+                               , uint16_t  seq        // host order
+                               , int       payload_len // ICMP echo data length
+                               , uint8_t  *payload // echo data (pure)
+                               , int add_crc         // add CRC at the end of packet when 1
+                               , int add_preamble    // add preamble at the beginnin of packet when 1
+                               )
+{
+    return gen_eth_ip_icmp_echo_packet_vlan( packet, mac_src, mac_dst, NULL, 0, ip_src, ip_dst
+                                           , ttl, type, id, seq, payload_len, payload
+                                           , add_crc, add_preamble);
+}
+
+//-----------------------------------------------------
+// It generates Ethernet packet containing ICMPv6 echo over IPv6.
+// 1. add preamble if 'add_preamble' is 1
+// 2. build Ethernet header with VLAN tags if any
+// 3. build IPv6 header
+// 4. build ICMPv6 echo header
+// 5. copy payload data from 'payload' to 'packet', when 'payload' is not 0
+// 6. add padding if required
+// 7. add crc if 'add_crc' is 1
+//
+// Note that ICMPv6 checksum covers IPv6 pseudo header.
+int gen_eth_ipv6_icmp_echo_packet_vlan( uint8_t  *packet
+                                      , uint8_t   mac_src[6] // network order
+                                      , uint8_t   mac_dst[6] // network order
+                                      , const pkt_vlan_t *vlan // tags, outer first
+                                      , int       vlan_num   // num of tags
+                                      , uint8_t   ip_src[16] // network order
+                                      , uint8_t   ip_dst[16] // network order
+                                      , uint8_t   hop_limit
+                                      , uint8_t   type       // ICMPV6_TYPE_ECHO_REQUEST or _REPLY
+                                      , uint16_t  id         // host order
+                                      , uint16_t  seq        // host order
+                                      , int       payload_len // ICMPv6 echo data length
+                                      , uint8_t  *payload // echo data (pure)
+                                      , int add_crc         // add CRC at the end of packet when 1
+                                      , int add_preamble    // add preamble at the beginnin of packet when 1
+                                      )
+{
+    int pkt_len=0, hdr_len;
+    if ((payload_len<0)||(payload_len>ICMP6_PAYLOAD_MAX)) return -1;
+    if ((vlan_num<0)||(vlan_num>PKT_VLAN_MAX)||(vlan_num&&(vlan==NULL))) return -1;
+    //----------------------------------------------------------------------------
+    // add preamble
+    if (add_preamble) {
         int idx;
-        for (idx=payload_len; idx<(46-IP_HDR_LEN-TCP_HDR_LEN); idx++) {
-             // fill padding if packe is less than 46.
-             // Ethernet requires minimum 46-byte of its payload,
-             // which is pure Ethernet payload, i.e., excluding MAC SRC/DST/TypeLen.
-             pld[idx] = 0x00;
-        }
-        pkt_len += idx;
-        uint32_t crc = compute_eth_crc((uint8_t*)eth_hdr, ETH_HDR_LEN+IP_HDR_LEN+TCP_HDR_LEN+idx);
-        memcpy((void*)&pld[idx], (void*)&crc, 4);
-        pkt_len += 4;
+        for (idx=0; idx<7; idx++) packet[idx] = 0x55;
+        packet[7] = 0xD5;
+        pkt_len = 8;
+    }
+    //----------------------------------------------------------------------------
+    // fill Ethernet header
+    eth_hdr_t* eth_hdr = (add_preamble) ? (eth_hdr_t*)&packet[8]
+                                        : (eth_hdr_t*)packet;
+    hdr_len = populate_eth_vlan_hdr( (uint8_t*)eth_hdr
+                                   , mac_src
+                                   , mac_dst
+                                   , vlan
+                                   , vlan_num
+                                   , ETH_TYPE_IPV6);
+    pkt_len += hdr_len;
+
+    //----------------------------------------------------------------------------
+    // fill IPv6 header
+    ipv6_hdr_t* ip_hdr = (ipv6_hdr_t*)(((uint8_t*)eth_hdr)+hdr_len);
+    pkt_len += populate_ipv6_hdr( ip_hdr
+                                , ip_src
+                                , ip_dst
+                                , IPV6_NEXT_ICMPV6
+                                , hop_limit
+                                , ICMP_ECHO_HDR_LEN + payload_len);
+
+    //----------------------------------------------------------------------------
+    // fill ICMPv6 echo header
+    icmp_echo_hdr_t* icmp_hdr = (icmp_echo_hdr_t*)(((uint8_t*)ip_hdr)+IPV6_HDR_LEN);
+    pkt_len += populate_icmp_echo_hdr( icmp_hdr
+                                     , type
+                                     , id
+                                     , seq);
+
+    //----------------------------------------------------------------------------
+    // copy echo data while calculating ICMPv6 checksum and crc if any
+    uint8_t *pld = (uint8_t*)(((uint8_t*)icmp_hdr)+ICMP_ECHO_HDR_LEN);
+    pseudo_ipv6_hdr_t pseudo_ip_hdr;
+    populate_pseudo_ipv6_hdr( &pseudo_ip_hdr, ip_src, ip_dst
+                            , IPV6_NEXT_ICMPV6, ICMP_ECHO_HDR_LEN+payload_len);
+    pkt_len += fill_eth_payload_v6( (uint8_t*)eth_hdr
+                                  , (uint8_t*)icmp_hdr
+                                  , ICMP_ECHO_HDR_LEN
+                                  , 2 // checksum field (the 2nd 16-bit word)
+                                  , (payload!=0) ? payload : pld
+                                  , payload_len
+                                  , 46-vlan_num*ETH_VLAN_TAG_LEN-IPV6_HDR_LEN
+                                  , &pseudo_ip_hdr
+                                  , add_crc);
+
+    //----------------------------------------------------------------------------
+    return pkt_len;
+}
+
+//-----------------------------------------------------
+// Same as gen_eth_ipv6_icmp_echo_packet_vlan() without VLAN tag.
+int gen_eth_ipv6_icmp_echo_packet( uint8_t  *packet
+                                 , uint8_t   mac_src[6] // network order
+                                 , uint8_t   mac_dst[6] // network order
+                                 , uint8_t   ip_src[16] // network order
+                                 , uint8_t   ip_dst[16] // network order
+                                 , uint8_t   hop_limit
+                                 , uint8_t   type       // ICMPV6_TYPE_ECHO_REQUEST or _REPLY
+                                 , uint16_t  id         // host order
+                                 , uint16_t  seq        // host order
+                                 , int       payload_len // ICMPv6 echo data length
+                                 , uint8_t  *payload // echo data (pure)
+                                 , int add_crc         // add CRC at the end of packet when 1
+                                 , int add_preamble    // add preamble at the beginnin of packet when 1
+                                 )
+{
+    return gen_eth_ipv6_icmp_echo_packet_vlan( packet, mac_src, mac_dst, NULL, 0, ip_src, ip_dst
+                                             , hop_limit, type, id, seq, payload_len, payload
+                                             , add_crc, add_preamble);
+}
+
+//-----------------------------------------------------
+// It turns ICMP or ICMPv6 echo request in Ethernet frame 'eth' into
+// echo reply in 'packet', where MAC and IP addresses are swapped,
+// VLAN tags are kept and the rest of IP packet is taken as it is.
+// Checksum is updated incrementally (RFC 1624) rather than computed over
+// echo data, so that a request with wrong checksum gets a wrong reply.
+// 'packet' can be 'eth' itself.
+// eth: Ethernet frame without preamble, which can have VLAN tags and CRC
+// return num of bytes of 'packet', 0 if 'eth' is not an echo request
+int gen_eth_icmp_echo_reply( uint8_t       *packet
+                           , const uint8_t *eth
+                           , int            leng // num of bytes of 'eth'
+                           , int add_crc
+                           , int add_preamble
+                           )
+{
+    pkt_vlan_t vlan[PKT_VLAN_MAX];
+    uint8_t  mac_src[6], mac_dst[6], addr[IPV6_ADDR_LEN], nxt, *ip;
+    const uint8_t *req;
+    uint16_t type_len, check, old_val, new_val;
+    int hdr, vlan_num, ip_len, off, frag, src, len, idx;
+
+    if ((packet==NULL)||(eth==NULL)) return 0;
+    hdr = get_eth_type(eth, leng, &type_len);
+    if (hdr<0) return 0;
+    req = &eth[hdr];
+    if (type_len==ETH_TYPE_IP) {
+        if ((leng<(hdr+IP_HDR_LEN))||((req[0]>>4)!=4)) return 0;
+        off    = (req[0]&0xF)*4;
+        ip_len = (req[2]<<8)|req[3];
+        if ((off<IP_HDR_LEN)||(ip_len<(off+ICMP_ECHO_HDR_LEN))||(ip_len>(leng-hdr))) return 0;
+        if ((req[9]!=IP_PROTO_ICMP)||(((req[6]<<8)|req[7])&(IP_FRAG_MF|IP_FRAG_OFFMASK))) return 0;
+        if ((req[off]!=ICMP_TYPE_ECHO_REQUEST)||(req[off+1]!=ICMP_CODE_ECHO)) return 0;
+        new_val = ICMP_TYPE_ECHO_REPLY<<8;
+        src = 12; // IP source address
+        len = 4;
+    } else if (type_len==ETH_TYPE_IPV6) {
+        if (leng<(hdr+IPV6_HDR_LEN)) return 0;
+        ip_len = IPV6_HDR_LEN+((req[4]<<8)|req[5]);
+        if (ip_len>(leng-hdr)) return 0;
+        off = get_ipv6_upper(req, ip_len, &nxt, &frag);
+        if ((off<0)||(nxt!=IPV6_NEXT_ICMPV6)||frag||(ip_len<(off+ICMP_ECHO_HDR_LEN))) return 0;
+        if ((req[off]!=ICMPV6_TYPE_ECHO_REQUEST)||(req[off+1]!=ICMP_CODE_ECHO)) return 0;
+        new_val = ICMPV6_TYPE_ECHO_REPLY<<8;
+        src = 8; // IPv6 source address
+        len = IPV6_ADDR_LEN;
     } else {
-      pkt_len += payload_len;
+        return 0;
+    }
+    //----------------------------------------------------------------------------
+    // take header of the request before 'packet' overwrites it
+    memcpy((void*)mac_src, (const void*)&eth[0], 6);
+    memcpy((void*)mac_dst, (const void*)&eth[6], 6);
+    vlan_num = (hdr-ETH_HDR_LEN)/ETH_VLAN_TAG_LEN;
+    if (vlan_num>PKT_VLAN_MAX) return 0; // too many tags to reply
+    for (idx=0; idx<vlan_num; idx++) {
+         vlan[idx].tpid = (eth[12+idx*ETH_VLAN_TAG_LEN]<<8)|eth[13+idx*ETH_VLAN_TAG_LEN];
+         vlan[idx].tci  = (eth[14+idx*ETH_VLAN_TAG_LEN]<<8)|eth[15+idx*ETH_VLAN_TAG_LEN];
+    }
+    old_val = (req[off]<<8)|req[off+1];
+    ip = &packet[((add_preamble) ? 8 : 0)+hdr];
+    if (ip!=req) memmove((void*)ip, (const void*)req, ip_len);
+
+    //----------------------------------------------------------------------------
+    // swap addresses, which keeps IP header checksum and pseudo header sum
+    memcpy((void*)addr, (void*)&ip[src], len);
+    memcpy((void*)&ip[src], (void*)&ip[src+len], len);
+    memcpy((void*)&ip[src+len], (void*)addr, len);
+    ip[off] = new_val>>8;
+    check = ~((ip[off+2]<<8)|ip[off+3]);
+    check = ~checksum_incremental_d16(check, old_val, new_val);
+    ip[off+2] = check>>8;
+    ip[off+3] = check&0xFF;
+
+    //----------------------------------------------------------------------------
+    return gen_eth_packet_vlan( packet
+                              , mac_src
+                              , mac_dst
+                              , vlan
+                              , vlan_num
+                              , type_len
+                              , ip_len
+                              , 0 // in place
+                              , add_crc
+                              , add_preamble);
+}
+
+//-----------------------------------------------------------------------------
+// Builders on packet buffer.
+// Each takes what 'buf' holds as its payload and prepends its header,
+// while padding and CRC (if any) are appended into tailroom.
+// They return num of bytes of the packet in 'buf', -1 when no room
+// or when it goes beyond the size model.
+//-----------------------------------------------------------------------------
+static int check_buf_room(pkt_buf_t *buf, int head, int tail)
+{
+    if (pkt_buf_headroom(buf)<head) return -1;
+    if (pkt_buf_tailroom(buf)<tail) return -1;
+    return 0;
+}
+
+//-----------------------------------------------------
+static void push_buf_preamble(pkt_buf_t *buf)
+{
+    uint8_t *pre = pkt_buf_push(buf, 8);
+    int idx;
+    for (idx=0; idx<7; idx++) pre[idx] = 0x55;
+    pre[7] = 0xD5;
+}
+
+//-----------------------------------------------------
+// It prepends Ethernet header with VLAN tags if any and preamble,
+// and appends padding and CRC.
+int gen_eth_packet_vlan_buf( pkt_buf_t *buf
+                           , uint8_t    mac_src[6] // network order
+                           , uint8_t    mac_dst[6] // network order
+                           , const pkt_vlan_t *vlan // tags, outer first
+                           , int        vlan_num   // num of tags
+                           , uint16_t   type_len   // type-length host order
+                           , int add_crc
+                           , int add_preamble
+                           )
+{
+    int payload_len = buf->len;
+    int min_len = 46-vlan_num*ETH_VLAN_TAG_LEN;
+    int pad = (payload_len<min_len) ? min_len-payload_len : 0;
+    int hdr_len = ETH_HDR_LEN+vlan_num*ETH_VLAN_TAG_LEN;
+    uint8_t *eth;
+
+    if (payload_len>ETH_PAYLOAD_MAX) return -1;
+    if ((vlan_num<0)||(vlan_num>PKT_VLAN_MAX)||(vlan_num&&(vlan==NULL))) return -1;
+    if (check_buf_room(buf, hdr_len+((add_preamble) ? 8 : 0)
+                          , (add_crc) ? pad+4 : 0)) return -1;
+    eth = pkt_buf_push(buf, hdr_len);
+    populate_eth_vlan_hdr(eth, mac_src, mac_dst, vlan, vlan_num, type_len);
+    if (add_crc) {
+        pkt_buf_put(buf, fill_eth_payload( eth
+                                         , eth+hdr_len
+                                         , 0, 0
+                                         , eth+hdr_len
+                                         , payload_len
+                                         , min_len
+                                         , NULL
+                                         , 1)-payload_len);
+    }
+    if (add_preamble) push_buf_preamble(buf);
+    return buf->len;
+}
+
+//-----------------------------------------------------
+// It prepends Ethernet header and preamble, and appends padding and CRC.
+int gen_eth_packet_buf( pkt_buf_t *buf
+                      , uint8_t    mac_src[6] // network order
+                      , uint8_t    mac_dst[6] // network order
+                      , uint16_t   type_len   // type-length host order
+                      , int add_crc
+                      , int add_preamble
+                      )
+{
+    return gen_eth_packet_vlan_buf(buf, mac_src, mac_dst, NULL, 0, type_len, add_crc, add_preamble);
+}
+
+//-----------------------------------------------------
+// It prepends IP header and fills UDP/TCP checksum when 'check' is 1,
+// where 'buf' should hold UDP/TCP header and its payload.
+int gen_ip_packet_buf( pkt_buf_t *buf
+                     , uint32_t   ip_src // host order
+                     , uint32_t   ip_dst // host order
+                     , uint8_t    protocol
+                     , uint8_t    ttl
+                     , int        check // update UDP or TCP header checksum when 1
+                     )
+{
+    int payload_len = buf->len;
+    uint8_t *pld = buf->data;
+    int sum_off = -1;
+
+    if (payload_len>(IP_PKT_MAX-IP_HDR_LEN)) return -1;
+    if (check_buf_room(buf, IP_HDR_LEN, 0)) return -1;
+    populate_ip_hdr( (ip_hdr_t*)pkt_buf_push(buf, IP_HDR_LEN)
+                   , ip_src
+                   , ip_dst
+                   , protocol
+                   , ttl
+                   , payload_len);
+    if (check) {
+        if (protocol==IP_PROTO_TCP) sum_off = 16; // the 9th 16-bit word
+        else if (protocol==IP_PROTO_UDP) sum_off = 6; // the 4th 16-bit word
+    }
+    if ((sum_off>=0)&&(payload_len>=(sum_off+2))) {
+        pseudo_ip_hdr_t pseudo_ip_hdr;
+        uint64_t val;
+        uint16_t check_sum;
+        populate_pseudo_ip_hdr(&pseudo_ip_hdr, ip_src, ip_dst, protocol, payload_len);
+        val = sum_checksum((const uint8_t*)&pseudo_ip_hdr, 12)
+            + sum_checksum(pld, sum_off)
+            + sum_checksum(&pld[sum_off+2], payload_len-sum_off-2);
+        check_sum = htons((~fold_checksum(val))&0xFFFF);
+        memcpy((void*)&pld[sum_off], (void*)&check_sum, 2);
+    }
+    return buf->len;
+}
+
+//-----------------------------------------------------
+// It prepends UDP header with zero checksum.
+int gen_udp_packet_buf( pkt_buf_t *buf
+                      , uint16_t   port_src // host order
+                      , uint16_t   port_dst // host order
+                      )
+{
+    int payload_len = buf->len;
+    if (payload_len>UDP_PAYLOAD_MAX) return -1;
+    if (check_buf_room(buf, UDP_HDR_LEN, 0)) return -1;
+    populate_udp_hdr( (udp_hdr_t*)pkt_buf_push(buf, UDP_HDR_LEN)
+                    , port_src
+                    , port_dst
+                    , payload_len);
+    return buf->len;
+}
+
+//-----------------------------------------------------
+// It prepends TCP header with zero checksum.
+int gen_tcp_packet_buf( pkt_buf_t *buf
+                      , uint16_t   port_src // host order
+                      , uint16_t   port_dst // host order
+                      , uint32_t   num_seq  // host order
+                      , uint32_t   num_ack  // host order
+                      )
+{
+    if (buf->len>TCP_PAYLOAD_MAX) return -1;
+    if (check_buf_room(buf, TCP_HDR_LEN, 0)) return -1;
+    populate_tcp_hdr( (tcp_hdr_t*)pkt_buf_push(buf, TCP_HDR_LEN)
+                    , port_src
+                    , port_dst
+                    , num_seq
+                    , num_ack);
+    return buf->len;
+}
+
+//-----------------------------------------------------
+// It appends ARP packet and then builds Ethernet packet of it.
+int gen_eth_arp_packet_buf( pkt_buf_t *buf
+                          , uint8_t    mac_src[6] // network order
+                          , uint8_t    mac_dst[6] // network order
+                          , uint16_t   type       // ARP type
+                          , uint32_t   ip_src     // host order
+                          , uint32_t   ip_dst     // host order
+                          , int add_crc
+                          , int add_preamble
+                          )
+{
+    uint8_t *arp;
+    if (check_buf_room(buf, ETH_HDR_LEN+((add_preamble) ? 8 : 0)
+                          , ARP_HDR_LEN+((add_crc) ? 46-ARP_HDR_LEN+4 : 0))) return -1;
+    arp = pkt_buf_put(buf, ARP_HDR_LEN);
+    populate_arp_hdr((arp_hdr_t*)arp, type, mac_src, mac_dst, ip_src, ip_dst);
+    return gen_eth_packet_buf(buf, mac_src, mac_dst, ETH_TYPE_ARP, add_crc, add_preamble);
+}
+
+//-----------------------------------------------------
+// It builds UDP/IP/Ethernet or TCP/IP/Ethernet packet over the payload
+// in 'buf', where checksum and CRC are computed in a single pass.
+static int gen_eth_ip_l4_packet_buf( pkt_buf_t *buf
+                                   , uint8_t    mac_src[6]
+                                   , uint8_t    mac_dst[6]
+                                   , uint32_t   ip_src
+                                   , uint32_t   ip_dst
+                                   , uint8_t    protocol
+                                   , uint16_t   port_src
+                                   , uint16_t   port_dst
+                                   , uint32_t   num_seq
+                                   , uint32_t   num_ack
+                                   , int check
+                                   , int add_crc
+                                   , int add_preamble)
+{
+    int payload_len = buf->len;
+    int hdr_len = (protocol==IP_PROTO_UDP) ? UDP_HDR_LEN : TCP_HDR_LEN;
+    int min_len = 46-IP_HDR_LEN;
+    int pad = (payload_len<(min_len-hdr_len)) ? min_len-hdr_len-payload_len : 0;
+    pseudo_ip_hdr_t pseudo_ip_hdr;
+    uint8_t *hdr, *eth;
+
+    if (payload_len>(IP_PKT_MAX-IP_HDR_LEN-hdr_len)) return -1;
+    if (check_buf_room(buf, ((add_preamble) ? 8 : 0)+ETH_HDR_LEN+IP_HDR_LEN+hdr_len
+                          , (add_crc) ? pad+4 : 0)) return -1;
+    hdr = pkt_buf_push(buf, hdr_len);
+    if (protocol==IP_PROTO_UDP)
+         populate_udp_hdr((udp_hdr_t*)hdr, port_src, port_dst, payload_len);
+    else populate_tcp_hdr((tcp_hdr_t*)hdr, port_src, port_dst, num_seq, num_ack);
+    populate_ip_hdr( (ip_hdr_t*)pkt_buf_push(buf, IP_HDR_LEN)
+                   , ip_src
+                   , ip_dst
+                   , protocol
+                   , 0x01 // TTL
+                   , hdr_len + payload_len);
+    eth = pkt_buf_push(buf, ETH_HDR_LEN);
+    populate_eth_hdr((eth_hdr_t*)eth, mac_src, mac_dst, ETH_TYPE_IP);
+    if (check&&payload_len) {
+        populate_pseudo_ip_hdr(&pseudo_ip_hdr, ip_src, ip_dst, protocol, hdr_len+payload_len);
     }
+    pkt_buf_put(buf, fill_eth_payload( eth
+                                     , hdr
+                                     , hdr_len
+                                     , (protocol==IP_PROTO_UDP) ? 6 : 16
+                                     , hdr+hdr_len
+                                     , payload_len
+                                     , min_len
+                                     , (check&&payload_len) ? &pseudo_ip_hdr : NULL
+                                     , add_crc)-payload_len);
+    if (add_preamble) push_buf_preamble(buf);
+    return buf->len;
+}
+
+//-----------------------------------------------------
+// Same as gen_eth_ip_udp_packet() over the payload in 'buf'.
+int gen_eth_ip_udp_packet_buf( pkt_buf_t *buf
+                             , uint8_t    mac_src[6] // network order
+                             , uint8_t    mac_dst[6] // network order
+                             , uint32_t   ip_src     // host order
+                             , uint32_t   ip_dst     // host order
+                             , uint16_t   port_src   // host order
+                             , uint16_t   port_dst   // host order
+                             , int check             // update UDP header checksum when 1
+                             , int add_crc           // add CRC at the end of packet when 1
+                             , int add_preamble      // add preamble at the beginnin of packet when 1
+                             )
+{
+    return gen_eth_ip_l4_packet_buf( buf, mac_src, mac_dst, ip_src, ip_dst
+                                   , IP_PROTO_UDP, port_src, port_dst, 0, 0
+                                   , check, add_crc, add_preamble);
+}
+
+//-----------------------------------------------------
+// Same as gen_eth_ip_tcp_packet() over the payload in 'buf'.
+// As gen_eth_ip_tcp_packet(), CRC is not added when no payload.
+int gen_eth_ip_tcp_packet_buf( pkt_buf_t *buf
+                             , uint8_t    mac_src[6] // network order
+                             , uint8_t    mac_dst[6] // network order
+                             , uint32_t   ip_src     // host order
+                             , uint32_t   ip_dst     // host order
+                             , uint16_t   port_src   // host order
+                             , uint16_t   port_dst   // host order
+                             , uint32_t   num_seq    // host order
+                             , uint32_t   num_ack    // host order
+                             , int check             // update TCP header checksum when 1
+                             , int add_crc           // add CRC at the end of packet when 1
+                             , int add_preamble      // add preamble at the beginnin of packet when 1
+                             )
+{
+    return gen_eth_ip_l4_packet_buf( buf, mac_src, mac_dst, ip_src, ip_dst
+                                   , IP_PROTO_TCP, port_src, port_dst, num_seq, num_ack
+                                   , check, add_crc&&buf->len, add_preamble);
+}
+
+//-----------------------------------------------------------------------------
+// Builders on payload fragments.
+// Each writes fragments of 'iov' once after its header, while checksum
+// and CRC (if any) are computed over fragments as they are copied.
+// They return num of bytes of the packet as the ones on a single payload.
+//-----------------------------------------------------------------------------
+// It generates raw Ethernet packet of fragments.
+int gen_eth_packet_iov( uint8_t  *packet
+                      , uint8_t   mac_src[6] // network order
+                      , uint8_t   mac_dst[6] // network order
+                      , uint16_t  type_len   // type-length host order
+                      , const pkt_iovec_t *iov
+                      , int       iovcnt
+                      , int add_crc
+                      , int add_preamble
+                      )
+{
+    int pkt_len=0;
+    uint8_t *eth;
 
+    if (pkt_iovec_len(iov, iovcnt)>ETH_PAYLOAD_MAX) return -1;
+    //----------------------------------------------------------------------------
+    // add preamble
+    if (add_preamble) {
+        int idx;
+        for (idx=0; idx<7; idx++) packet[idx] = 0x55;
+        packet[7] = 0xD5;
+        pkt_len += 8;
+    }
     //----------------------------------------------------------------------------
+    // fill Ethernet header
+    eth = &packet[pkt_len];
+    pkt_len += populate_eth_hdr((eth_hdr_t*)eth, mac_src, mac_dst, type_len);
+
+    //----------------------------------------------------------------------------
+    // copy fragments while computing CRC if any
+    if (add_crc) {
+        pkt_len += fill_eth_payload_iov( eth
+                                       , eth+ETH_HDR_LEN
+                                       , 0, 0
+                                       , iov, iovcnt
+                                       , 46
+                                       , NULL
+                                       , 1);
+    } else {
+        pkt_len += copy_checksum_crc_iov(eth+ETH_HDR_LEN, iov, iovcnt, NULL, NULL);
+    }
+    return pkt_len;
+}
+
+//-----------------------------------------------------
+// It generates IP packet of fragments, which should hold UDP/TCP header
+// and its payload when 'check' is 1.
+int gen_ip_packet_iov( uint8_t  *packet
+                     , uint32_t  ip_src // host order
+                     , uint32_t  ip_dst // host order
+                     , uint8_t   protocol
+                     , uint8_t   ttl
+                     , const pkt_iovec_t *iov
+                     , int       iovcnt
+                     , int       check // update UDP or TCP header checksum when 1
+                     )
+{
+    uint8_t *pld = packet+IP_HDR_LEN;
+    uint32_t sum = 0;
+    int payload_len = pkt_iovec_len(iov, iovcnt);
+    int sum_off = -1;
+
+    if (payload_len>(IP_PKT_MAX-IP_HDR_LEN)) return -1;
+    populate_ip_hdr( (ip_hdr_t*)packet
+                   , ip_src
+                   , ip_dst
+                   , protocol
+                   , ttl
+                   , payload_len);
+    if (check) {
+        if (protocol==IP_PROTO_TCP) sum_off = 16; // the 9th 16-bit word
+        else if (protocol==IP_PROTO_UDP) sum_off = 6; // the 4th 16-bit word
+    }
+    if ((sum_off<0)||(payload_len<(sum_off+2))) {
+        copy_checksum_crc_iov(pld, iov, iovcnt, NULL, NULL);
+    } else {
+        pseudo_ip_hdr_t pseudo_ip_hdr;
+        uint64_t val;
+        uint16_t check_sum;
+        copy_checksum_crc_iov(pld, iov, iovcnt, &sum, NULL);
+        // The checksum field, which came with fragments, is taken out of
+        // the sum by adding its one's complement.
+        memcpy((void*)&check_sum, (void*)&pld[sum_off], 2);
+        populate_pseudo_ip_hdr(&pseudo_ip_hdr, ip_src, ip_dst, protocol, payload_len);
+        val = sum_checksum((const uint8_t*)&pseudo_ip_hdr, 12)
+            + sum
+            + ((~ntohs(check_sum))&0xFFFF);
+        check_sum = htons((~fold_checksum(val))&0xFFFF);
+        memcpy((void*)&pld[sum_off], (void*)&check_sum, 2);
+    }
+    return IP_HDR_LEN+payload_len;
+}
+
+//-----------------------------------------------------
+// It generates UDP packet of fragments with zero checksum.
+int gen_udp_packet_iov( uint8_t  *packet
+                      , uint16_t  port_src // host order
+                      , uint16_t  port_dst // host order
+                      , const pkt_iovec_t *iov
+                      , int       iovcnt
+                      )
+{
+    int payload_len = pkt_iovec_len(iov, iovcnt);
+    if (payload_len>UDP_PAYLOAD_MAX) return -1;
+    populate_udp_hdr( (udp_hdr_t*)packet
+                    , port_src
+                    , port_dst
+                    , payload_len);
+    return UDP_HDR_LEN+copy_checksum_crc_iov(packet+UDP_HDR_LEN, iov, iovcnt, NULL, NULL);
+}
+
+//-----------------------------------------------------
+// It generates TCP packet of fragments with zero checksum.
+int gen_tcp_packet_iov( uint8_t  *packet
+                      , uint16_t  port_src // host order
+                      , uint16_t  port_dst // host order
+                      , uint32_t  num_seq  // host order
+                      , uint32_t  num_ack  // host order
+                      , const pkt_iovec_t *iov
+                      , int       iovcnt
+                      )
+{
+    if (pkt_iovec_len(iov, iovcnt)>TCP_PAYLOAD_MAX) return -1;
+    populate_tcp_hdr( (tcp_hdr_t*)packet
+                    , port_src
+                    , port_dst
+                    , num_seq
+                    , num_ack);
+    return TCP_HDR_LEN+copy_checksum_crc_iov(packet+TCP_HDR_LEN, iov, iovcnt, NULL, NULL);
+}
+
+//-----------------------------------------------------
+// It builds UDP/IP/Ethernet or TCP/IP/Ethernet packet of fragments,
+// where checksum and CRC are computed while fragments are copied.
+static int gen_eth_ip_l4_packet_iov( uint8_t  *packet
+                                   , uint8_t   mac_src[6]
+                                   , uint8_t   mac_dst[6]
+                                   , uint32_t  ip_src
+                                   , uint32_t  ip_dst
+                                   , uint8_t   protocol
+                                   , uint16_t  port_src
+                                   , uint16_t  port_dst
+                                   , uint32_t  num_seq
+                                   , uint32_t  num_ack
+                                   , const pkt_iovec_t *iov
+                                   , int       iovcnt
+                                   , int check
+                                   , int add_crc
+                                   , int add_preamble)
+{
+    int payload_len = pkt_iovec_len(iov, iovcnt);
+    int hdr_len = (protocol==IP_PROTO_UDP) ? UDP_HDR_LEN : TCP_HDR_LEN;
+    int pkt_len = 0;
+    pseudo_ip_hdr_t pseudo_ip_hdr;
+    uint8_t *eth, *hdr;
+
+    if (payload_len>(IP_PKT_MAX-IP_HDR_LEN-hdr_len)) return -1;
+    if (add_preamble) {
+        int idx;
+        for (idx=0; idx<7; idx++) packet[idx] = 0x55;
+        packet[7] = 0xD5;
+        pkt_len = 8;
+    }
+    eth = &packet[pkt_len];
+    pkt_len += populate_eth_hdr((eth_hdr_t*)eth, mac_src, mac_dst, ETH_TYPE_IP);
+    pkt_len += populate_ip_hdr( (ip_hdr_t*)(eth+ETH_HDR_LEN)
+                              , ip_src
+                              , ip_dst
+                              , protocol
+                              , 0x01 // TTL
+                              , hdr_len + payload_len);
+    hdr = eth+ETH_HDR_LEN+IP_HDR_LEN;
+    if (protocol==IP_PROTO_UDP)
+         pkt_len += populate_udp_hdr((udp_hdr_t*)hdr, port_src, port_dst, payload_len);
+    else pkt_len += populate_tcp_hdr((tcp_hdr_t*)hdr, port_src, port_dst, num_seq, num_ack);
+    if (check&&payload_len) {
+        populate_pseudo_ip_hdr(&pseudo_ip_hdr, ip_src, ip_dst, protocol, hdr_len+payload_len);
+    }
+    pkt_len += fill_eth_payload_iov( eth
+                                   , hdr
+                                   , hdr_len
+                                   , (protocol==IP_PROTO_UDP) ? 6 : 16
+                                   , iov, iovcnt
+                                   , 46-IP_HDR_LEN
+                                   , (check&&payload_len) ? &pseudo_ip_hdr : NULL
+                                   , add_crc);
     return pkt_len;
 }
 
+//-----------------------------------------------------
+// Same as gen_eth_ip_udp_packet() over fragments.
+int gen_eth_ip_udp_packet_iov( uint8_t  *packet
+                             , uint8_t   mac_src[6] // network order
+                             , uint8_t   mac_dst[6] // network order
+                             , uint32_t  ip_src     // host order
+                             , uint32_t  ip_dst     // host order
+                             , uint16_t  port_src   // host order
+                             , uint16_t  port_dst   // host order
+                             , const pkt_iovec_t *iov
+                             , int       iovcnt
+                             , int check             // update UDP header checksum when 1
+                             , int add_crc           // add CRC at the end of packet when 1
+                             , int add_preamble      // add preamble at the beginnin of packet when 1
+                             )
+{
+    return gen_eth_ip_l4_packet_iov( packet, mac_src, mac_dst, ip_src, ip_dst
+                                   , IP_PROTO_UDP, port_src, port_dst, 0, 0
+                                   , iov, iovcnt, check, add_crc, add_preamble);
+}
+
+//-----------------------------------------------------
+// Same as gen_eth_ip_tcp_packet() over fragments.
+// As gen_eth_ip_tcp_packet(), CRC is not added when no payload.
+int gen_eth_ip_tcp_packet_iov( uint8_t  *packet
+                             , uint8_t   mac_src[6] // network order
+                             , uint8_t   mac_dst[6] // network order
+                             , uint32_t  ip_src     // host order
+                             , uint32_t  ip_dst     // host order
+                             , uint16_t  port_src   // host order
+                             , uint16_t  port_dst   // host order
+                             , uint32_t  num_seq    // host order
+                             , uint32_t  num_ack    // host order
+                             , const pkt_iovec_t *iov
+                             , int       iovcnt
+                             , int check             // update TCP header checksum when 1
+                             , int add_crc           // add CRC at the end of packet when 1
+                             , int add_preamble      // add preamble at the beginnin of packet when 1
+                             )
+{
+    return gen_eth_ip_l4_packet_iov( packet, mac_src, mac_dst, ip_src, ip_dst
+                                   , IP_PROTO_TCP, port_src, port_dst, num_seq, num_ack
+                                   , iov, iovcnt, check
+                                   , add_crc&&pkt_iovec_len(iov, iovcnt), add_preamble);
+}
+
 //-----------------------------------------------------------------------------
 int parser_eth_packet(uint8_t *pkt, int leng)
 {
@@ -1097,21 +3072,28 @@ int parser_eth_packet(uint8_t *pkt, int leng)
       for (idy=0; idy<6; idy++) printf("%02X",pkt[idx++]);
       printf("\n");
   }
-  if (leng>=(idx+2)) {
+  while (leng>=(idx+2)) {
       type_leng  = pkt[idx++]<<8;
       type_leng |= pkt[idx++];
       printf("ETH type leng: 0x%04X", type_leng);
       switch (type_leng) {
       case 0x0800: printf(" (IPv4  packet)\n"); break;
       case 0x0806: printf(" (ARP   packet)\n"); break;
-      case 0x08DD: printf(" (IPv6  packet)\n"); break;
+      case 0x86DD: printf(" (IPv6  packet)\n"); break;
       case 0x8100: printf(" (VLAN  packet)\n"); break;
+      case 0x88A8: printf(" (QinQ  packet)\n"); break;
       case 0x88F7: printf(" (PTPv2 raw packet)\n"); break;
       default:     printf("\n"); break;
       }
+      if ((type_leng!=ETH_TYPE_VLAN)&&(type_leng!=ETH_TYPE_QINQ)) break;
+      if (leng<(idx+2)) break;
+      printf("ETH VLAN tag : PCP=%d DEI=%d VID=%d\n", pkt[idx]>>5, (pkt[idx]>>4)&0x1
+                                                   , ((pkt[idx]&0xF)<<8)|pkt[idx+1]);
+      idx += 2;
    }
    switch (type_leng) {
-   case 0x0800: parser_ip_packet(pkt+ETH_HDR_LEN, leng-ETH_HDR_LEN); break;
+   case 0x0800: parser_ip_packet(pkt+idx, leng-idx); break;
+   case 0x86DD: parser_ipv6_packet(pkt+idx, leng-idx); break;
    }
    return 0;
 }
@@ -1157,6 +3139,11 @@ int parser_ip_packet(uint8_t *pkt, int leng)
     printf("IP source address        0x%08X\n", ntohl(ip_hdr->ip_src));
     printf("IP dest address          0x%08X\n", ntohl(ip_hdr->ip_dst));
 
+    if (ntohs(ip_hdr->ip_off)&IP_FRAG_OFFMASK) { // no UDP/TCP header
+        printf("IP fragment at offset    %d\n", (ntohs(ip_hdr->ip_off)&IP_FRAG_OFFMASK)*8);
+        return 0;
+    }
+    if (ntohs(ip_hdr->ip_off)&IP_FRAG_MF) printf("IP first fragment\n");
     switch (ip_hdr->ip_pro) {
     case 0x11: // UDP
          parser_udp_packet(pkt+(ip_hdr->ip_hdl*4), leng-(ip_hdr->ip_hdl*4));
@@ -1164,7 +3151,10 @@ int parser_ip_packet(uint8_t *pkt, int leng)
     case 0x06: // TCP
          parser_tcp_packet(pkt+(ip_hdr->ip_hdl*4), leng-(ip_hdr->ip_hdl*4));
          break;
-    case 0x01: // ICMP
+    case 0x01: // ICMP; checksum covers up to IP total length, not padding and CRC
+         if (ntohs(ip_hdr->ip_len)<leng) leng = ntohs(ip_hdr->ip_len);
+         parser_icmp_packet(pkt+(ip_hdr->ip_hdl*4), leng-(ip_hdr->ip_hdl*4));
+         break;
     case 0x02: // IGMP
     case 0x5E: // ICMP
     default: printf("not implemented yet\n");
@@ -1172,6 +3162,121 @@ int parser_ip_packet(uint8_t *pkt, int leng)
     return 0;
 }
 
+//-----------------------------------------------------------------------------
+// It returns num of bytes of IPv6 extension header 'ext' of type 'next_hdr',
+// 0 if 'next_hdr' is not an extension header to walk over,
+// -1 if 'leng' bytes do not cover it.
+static int ipv6_ext_len(const uint8_t *ext, int leng, uint8_t next_hdr)
+{
+    int len;
+    switch (next_hdr) {
+    case IPV6_NEXT_HOPOPTS:
+    case IPV6_NEXT_ROUTING:
+    case IPV6_NEXT_DSTOPTS: if (leng<2) return -1;
+                            len = (ext[1]+1)*8; break;
+    case IPV6_NEXT_FRAGMENT:len = 8; break;
+    case IPV6_NEXT_AH:      if (leng<2) return -1;
+                            len = (ext[1]+2)*4; break;
+    default: return 0; // upper-layer, ESP or no next header
+    }
+    return (len>leng) ? -1 : len;
+}
+
+//-----------------------------------------------------------------------------
+// It walks over extension headers of IPv6 packet and returns offset of
+// the upper-layer header from 'pkt' (-1 on error), where 'next_hdr' gets
+// its type, e.g., IP_PROTO_UDP, and 'frag_off' gets fragment offset in bytes
+// (0 if not fragmented or the first fragment).
+int get_ipv6_upper( const uint8_t *pkt, int leng, uint8_t *next_hdr, int *frag_off )
+{
+    int idx=IPV6_HDR_LEN, len;
+    uint8_t nxt;
+    if ((leng<IPV6_HDR_LEN)||((pkt[0]>>4)!=6)) return -1;
+    nxt = pkt[6];
+    if (frag_off!=NULL) *frag_off = 0;
+    while ((len=ipv6_ext_len(pkt+idx, leng-idx, nxt))>0) {
+        if ((nxt==IPV6_NEXT_FRAGMENT)&&(frag_off!=NULL)) {
+            *frag_off = ((pkt[idx+2]<<8)|pkt[idx+3])&0xFFF8;
+        }
+        nxt  = pkt[idx];
+        idx += len;
+    }
+    if (len<0) return -1;
+    if (next_hdr!=NULL) *next_hdr = nxt;
+    return idx;
+}
+
+//-----------------------------------------------------------------------------
+int parser_ipv6_packet(uint8_t *pkt, int leng)
+{
+    ipv6_hdr_t *ip_hdr = (ipv6_hdr_t*)pkt;
+    uint32_t vfc;
+    int idx, idy, len, off=0;
+    uint8_t nxt;
+    if (leng<IPV6_HDR_LEN) return -1;
+    memcpy((void*)&vfc, (void*)&ip_hdr->ip6_vfc, 4);
+    vfc = ntohl(vfc);
+    printf("IPv6 version             0x%01X\n", vfc>>28);
+    printf("IPv6 traffic class       0x%02X\n", (vfc>>20)&0xFF);
+    printf("IPv6 flow label          0x%05X\n", vfc&0xFFFFF);
+    printf("IPv6 payload length      0x%04X\n", (pkt[4]<<8)|pkt[5]);
+    printf("IPv6 hop limit           0x%02X\n", ip_hdr->ip6_hlim);
+    printf("IPv6 source address      0x");
+    for (idy=0; idy<IPV6_ADDR_LEN; idy++) printf("%02X", ip_hdr->ip6_src[idy]);
+    printf("\n");
+    printf("IPv6 dest address        0x");
+    for (idy=0; idy<IPV6_ADDR_LEN; idy++) printf("%02X", ip_hdr->ip6_dst[idy]);
+    printf("\n");
+
+    idx = IPV6_HDR_LEN;
+    nxt = ip_hdr->ip6_nxt;
+    while (1) {
+        printf("IPv6 next header         0x%02X  ", nxt);
+        switch (nxt) {
+        case IPV6_NEXT_HOPOPTS : printf("(Hop-by-Hop Options)\n"); break;
+        case IPV6_NEXT_ROUTING : printf("(Routing)\n"); break;
+        case IPV6_NEXT_FRAGMENT: printf("(Fragment)\n"); break;
+        case IPV6_NEXT_ESP     : printf("(ESP)\n"); break;
+        case IPV6_NEXT_AH      : printf("(AH)\n"); break;
+        case IPV6_NEXT_ICMPV6  : printf("(ICMPv6)\n"); break;
+        case IPV6_NEXT_NONE    : printf("(No Next Header)\n"); break;
+        case IPV6_NEXT_DSTOPTS : printf("(Destination Options)\n"); break;
+        case 0x11: printf("(UDP)\n"); break;
+        case 0x06: printf("(TCP)\n"); break;
+        default:   printf("\n"); break;
+        }
+        len = ipv6_ext_len(pkt+idx, leng-idx, nxt);
+        if (len<0) { printf("IPv6 extension header truncated\n"); return -1; }
+        if (len==0) break;
+        printf("IPv6 extension length    %d\n", len);
+        if (nxt==IPV6_NEXT_FRAGMENT) {
+            off = ((pkt[idx+2]<<8)|pkt[idx+3])&0xFFF8;
+            printf("IPv6 fragment offset     %d%s\n", off, (pkt[idx+3]&0x1) ? " (more)" : "");
+            printf("IPv6 fragment ID         0x%02X%02X%02X%02X\n"
+                  , pkt[idx+4], pkt[idx+5], pkt[idx+6], pkt[idx+7]);
+        }
+        nxt  = pkt[idx];
+        idx += len;
+    }
+    if (off) return 0; // no UDP/TCP header
+    switch (nxt) {
+    case 0x11: // UDP
+         parser_udp_packet(pkt+idx, leng-idx);
+         break;
+    case 0x06: // TCP
+         parser_tcp_packet(pkt+idx, leng-idx);
+         break;
+    case IPV6_NEXT_ICMPV6: // up to payload length, not padding and CRC
+         if ((IPV6_HDR_LEN+((pkt[4]<<8)|pkt[5]))<leng) leng = IPV6_HDR_LEN+((pkt[4]<<8)|pkt[5]);
+         parser_icmpv6_packet(pkt+idx, leng-idx);
+         break;
+    case IPV6_NEXT_NONE:
+         break;
+    default: printf("not implemented yet\n");
+    }
+    return 0;
+}
+
 //-----------------------------------------------------------------------------
 int parser_udp_packet(uint8_t *pkt, int leng)
 {
@@ -1191,14 +3296,59 @@ int parser_tcp_packet(uint8_t *pkt, int leng)
     printf("TCP destination port       0x%04X\n", ntohs(tcp_hdr->port_dst)); // destination port
     printf("TCP sequence number        0x%08X\n", ntohl(tcp_hdr->tcp_seq)); // sequence number
     printf("TCP acknowledgement number 0x%08X\n", ntohl(tcp_hdr->tcp_ack)); // acknowledgement number
-    printf("TCP header length          0x%01X\n",       tcp_hdr->tcp_hl); // header length (only higher 4-bit)
-    printf("TCP control                0x%02X\n",       tcp_hdr->tcp_ctl); // control (only lower 6-bit)
+    printf("TCP header length          0x%01X\n",       ((const uint8_t*)tcp_hdr)[12]>>4); // header length (only higher 4-bit)
+    printf("TCP control                0x%02X\n",       ((const uint8_t*)tcp_hdr)[13]&0x3F); // control (only lower 6-bit)
     printf("TCP window                 0x%04X\n", ntohs(tcp_hdr->tcp_win)); // window
     printf("TCP checksum               0x%04X\n", ntohs(tcp_hdr->tcp_sum)); // checksum
     printf("TCP urgent point           0x%04X\n", ntohs(tcp_hdr->tcp_pnt)); // urgent pointer
     return 0;
 }
 
+//-----------------------------------------------------------------------------
+// Echo request and reply carry identifier and sequence number.
+int parser_icmp_packet(uint8_t *pkt, int leng)
+{
+    if (leng<4) return -1;
+    printf("ICMP type                 0x%02X  ", pkt[0]);
+    switch (pkt[0]) {
+    case ICMP_TYPE_ECHO_REPLY             : printf("(Echo Reply)\n"); break;
+    case ICMP_TYPE_DESTINATION_UNREACHABLE: printf("(Destination Unreachable)\n"); break;
+    case ICMP_TYPE_ECHO_REQUEST           : printf("(Echo Request)\n"); break;
+    case ICMP_TYPE_TIME_EXCEEDED          : printf("(Time Exceeded)\n"); break;
+    default: printf("\n"); break;
+    }
+    printf("ICMP code                 0x%02X\n", pkt[1]);
+    printf("ICMP checksum             0x%04X%s\n", (pkt[2]<<8)|pkt[3]
+                                                , (check_checksum(pkt, leng)) ? " (error)" : "");
+    if (((pkt[0]==ICMP_TYPE_ECHO_REQUEST)||(pkt[0]==ICMP_TYPE_ECHO_REPLY))&&(leng>=ICMP_ECHO_HDR_LEN)) {
+        printf("ICMP identifier           0x%04X\n", (pkt[4]<<8)|pkt[5]);
+        printf("ICMP sequence number      0x%04X\n", (pkt[6]<<8)|pkt[7]);
+        printf("ICMP data length          %d\n", leng-ICMP_ECHO_HDR_LEN);
+    }
+    return 0;
+}
+
+//-----------------------------------------------------------------------------
+// Checksum is not checked since it covers IPv6 pseudo header.
+int parser_icmpv6_packet(uint8_t *pkt, int leng)
+{
+    if (leng<4) return -1;
+    printf("ICMPv6 type               0x%02X  ", pkt[0]);
+    switch (pkt[0]) {
+    case ICMPV6_TYPE_ECHO_REQUEST: printf("(Echo Request)\n"); break;
+    case ICMPV6_TYPE_ECHO_REPLY  : printf("(Echo Reply)\n"); break;
+    default: printf("\n"); break;
+    }
+    printf("ICMPv6 code               0x%02X\n", pkt[1]);
+    printf("ICMPv6 checksum           0x%04X\n", (pkt[2]<<8)|pkt[3]);
+    if (((pkt[0]==ICMPV6_TYPE_ECHO_REQUEST)||(pkt[0]==ICMPV6_TYPE_ECHO_REPLY))&&(leng>=ICMP_ECHO_HDR_LEN)) {
+        printf("ICMPv6 identifier         0x%04X\n", (pkt[4]<<8)|pkt[5]);
+        printf("ICMPv6 sequence number    0x%04X\n", (pkt[6]<<8)|pkt[7]);
+        printf("ICMPv6 data length        %d\n", leng-ICMP_ECHO_HDR_LEN);
+    }
+    return 0;
+}
+
 //-----------------------------------------------------------------------------
 int is_broadcast(uint32_t ip_addr, uint32_t ip_local, uint32_t subnet_mask)
 {
@@ -7,6 +7,7 @@
 // VERSION = 2019.05.20.
 //----------------------------------------------------------------------------
 #include "eth_ip_udp_tcp_data_type.h"
+#include "pkt_buf.h"
 
 //----------------------------------------------------------------------------
 extern uint32_t compute_eth_crc     ( uint8_t *pkt, int bnum );
@@ -19,6 +20,47 @@ extern int      check_checksum    ( uint8_t *pkt, int bnum );
 extern int      check_ip_checksum ( ip_hdr_t *iphdr );
 extern int      check_udp_checksum( pseudo_ip_hdr_t *ip_hdr, udp_hdr_t *hdr );
 extern int      check_tcp_checksum( pseudo_ip_hdr_t *ip_hdr, tcp_hdr_t *hdr );
+extern uint16_t compute_checksum_d8 ( uint8_t *pkt, int bnum ); // reference
+extern uint16_t compute_checksum_d16( uint8_t *pkt, int bnum ); // reference
+extern uint16_t compute_checksum_d32( uint8_t *pkt, int bnum ); // reference
+extern uint32_t compute_eth_crc_bitwise( uint8_t *pkt, int bnum ); // reference
+extern int      check_eth_crc_bitwise  ( uint8_t *pkt, int bnum ); // reference
+
+//----------------------------------------------------------------------------
+// How compute_eth_crc()/check_eth_crc() work.
+// It can be forced by 'NETWORK_VPI_CRC' environment variable.
+#define ETH_CRC_MODE_BITWISE  0 // bit-serial
+#define ETH_CRC_MODE_SLICE8   1 // slicing-by-8 tables
+#define ETH_CRC_MODE_PCLMUL   2 // carry-less multiply folding if the CPU supports it
+extern int      eth_crc_mode    ( void );
+extern int      set_eth_crc_mode( int mode ); // returns the mode taken
+
+//----------------------------------------------------------------------------
+// How compute_checksum() and compute/check_*_checksum() work.
+// It can be forced by 'NETWORK_VPI_CHECKSUM' environment variable.
+#define CHECKSUM_MODE_SCALAR  0 // 32-bit words into 64-bit accumulator
+#define CHECKSUM_MODE_SSE2    1 // 128-bit vectors if the CPU supports it
+#define CHECKSUM_MODE_AVX2    2 // 256-bit vectors if the CPU supports it
+extern int      checksum_mode    ( void );
+extern int      set_checksum_mode( int mode ); // returns the mode taken
+
+//----------------------------------------------------------------------------
+// Single pass copy with Internet checksum and Ethernet CRC;
+// 'crc' is what compute_eth_crc() returns so far (0 at first) and updated.
+extern uint16_t copy_checksum_crc( uint8_t *dst, const uint8_t *src, int bnum
+                                 , uint32_t *crc ); // not computed if NULL
+
+//----------------------------------------------------------------------------
+// Incremental checksum (RFC 1624); checksums are host order without inversion.
+extern uint16_t checksum_incremental_d16( uint16_t old_check, uint16_t old_val, uint16_t new_val );
+extern uint16_t checksum_incremental_d32( uint16_t old_check, uint32_t old_val, uint32_t new_val );
+extern uint16_t checksum_incremental_d64( uint16_t old_check, uint64_t old_val, uint64_t new_val );
+
+//----------------------------------------------------------------------------
+// Incremental FCS; see 'eth_ip_udp_tcp_pkt.c'.
+extern uint32_t combine_eth_crc ( uint32_t crcA, uint32_t crcB, int lenB );
+extern int      patch_eth_crc   ( uint8_t *pkt, int bnum // including FCS
+                                , int offset, const uint8_t *data, int num );
 
 //----------------------------------------------------------------------------
 extern int populate_eth_hdr( eth_hdr_t *ether_hdr
@@ -42,6 +84,17 @@ extern int populate_pseudo_ip_hdr( pseudo_ip_hdr_t *ip_hdr
                                  , uint32_t         ip_dst // host order
                                  , uint8_t          protocol
                                  , uint16_t         length);// pure payload size in host order
+extern int populate_ipv6_hdr( ipv6_hdr_t *ip_hdr
+                            , uint8_t     ip_src[16] // network order
+                            , uint8_t     ip_dst[16] // network order
+                            , uint8_t     next_hdr
+                            , uint8_t     hop_limit
+                            , uint16_t    payload_size);// payload size following IPv6 header in host order
+extern int populate_pseudo_ipv6_hdr( pseudo_ipv6_hdr_t *ip_hdr
+                                   , uint8_t            ip_src[16] // network order
+                                   , uint8_t            ip_dst[16] // network order
+                                   , uint8_t            next_hdr   // upper-layer protocol
+                                   , uint32_t           length);   // upper-layer packet size in host order
 extern int populate_udp_hdr( udp_hdr_t *udp_hdr
                            , uint16_t   port_src // host order
                            , uint16_t   port_dst // host order
@@ -51,17 +104,71 @@ extern int populate_tcp_hdr( tcp_hdr_t *tcp_hdr
                            , uint16_t   port_dst // host order
                            , uint32_t   num_seq  // host order
                            , uint32_t   num_ack);// host order
+extern int populate_icmp_echo_hdr( icmp_echo_hdr_t *icmp_hdr
+                                 , uint8_t   type // ICMP_TYPE_ECHO_* or ICMPV6_TYPE_ECHO_*
+                                 , uint16_t  id   // host order
+                                 , uint16_t  seq);// host order
+
+//----------------------------------------------------------------------------
+// Size model.
+// Lengths are 'int' num of bytes, which are bounded by 16-bit length fields
+// of the protocols rather than by MTU, so that jumbo frames and 64 KiB IP
+// datagrams are built without truncation.
+// Builders return -1 when a length goes beyond these.
+#define IP_PKT_MAX       65535 // IPv4 total length including IP header
+#define UDP_PAYLOAD_MAX  (IP_PKT_MAX-IP_HDR_LEN-UDP_HDR_LEN) // 65507
+#define TCP_PAYLOAD_MAX  (IP_PKT_MAX-IP_HDR_LEN-TCP_HDR_LEN) // 65495
+#define ETH_PAYLOAD_MAX  IP_PKT_MAX // Ethernet payload, i.e., the largest IP datagram
+#define ETH_FRAME_MAX    (8+ETH_HDR_LEN+ETH_PAYLOAD_MAX+4) // with preamble and CRC
+#define ETH_VLAN_FRAME_MAX (ETH_FRAME_MAX+PKT_VLAN_MAX*ETH_VLAN_TAG_LEN) // with tags
+#define IPV6_PAYLOAD_MAX (ETH_PAYLOAD_MAX-IPV6_HDR_LEN) // 65495, within the same Ethernet frame
+#define UDP6_PAYLOAD_MAX (IPV6_PAYLOAD_MAX-UDP_HDR_LEN) // 65487
+#define TCP6_PAYLOAD_MAX (IPV6_PAYLOAD_MAX-TCP_HDR_LEN) // 65475
+#define ICMP_PAYLOAD_MAX (IP_PKT_MAX-IP_HDR_LEN-ICMP_ECHO_HDR_LEN) // 65507, echo data
+#define ICMP6_PAYLOAD_MAX (IPV6_PAYLOAD_MAX-ICMP_ECHO_HDR_LEN) // 65487, echo data
+
+//----------------------------------------------------------------------------
+// VLAN tags, which are put between MAC SRC and type-length in the order
+// of the array, i.e., S-tag (0x88A8) first and then C-tag (0x8100) for QinQ.
+// Frames with tags keep 64-byte minimum, i.e., padding is reduced by tags.
+#define PKT_VLAN_MAX 2 // 802.1Q single tag or 802.1ad double tags
+#define PKT_VLAN_TCI(pcp,dei,vid) ((uint16_t)((((pcp)&0x7)<<13)|(((dei)&0x1)<<12)|((vid)&0xFFF)))
+typedef struct pkt_vlan {
+    uint16_t tpid; // tag protocol identifier, e.g., ETH_TYPE_VLAN; host order
+    uint16_t tci ; // PCP[15:13], DEI[12], VID[11:0]; host order
+} pkt_vlan_t;
+
+extern int populate_eth_vlan_hdr( uint8_t  *eth
+                                , uint8_t   mac_src[6] // network order
+                                , uint8_t   mac_dst[6] // network order
+                                , const pkt_vlan_t *vlan // outer first
+                                , int       vlan_num   // num of tags, 0 to PKT_VLAN_MAX
+                                , uint16_t  type_len); // host order
+// It returns num of bytes of Ethernet header including tags (-1 on error),
+// where 'type_len' gets the type-length after the tags.
+extern int get_eth_type( const uint8_t *eth, int leng, uint16_t *type_len );
 
 //----------------------------------------------------------------------------
 extern int gen_eth_packet( uint8_t  *packet
                          , uint8_t   mac_src[6] // network order
                          , uint8_t   mac_dst[6] // network order
                          , uint16_t  type_len   // type-length in host order
-                         , uint16_t  payload_len // payload length
+                         , int       payload_len // payload length
                          , uint8_t  *payload // payload if not 0
                          , int add_crc
                          , int add_preamble);
 
+extern int gen_eth_packet_vlan( uint8_t  *packet
+                              , uint8_t   mac_src[6] // network order
+                              , uint8_t   mac_dst[6] // network order
+                              , const pkt_vlan_t *vlan // tags, outer first
+                              , int       vlan_num   // num of tags
+                              , uint16_t  type_len   // type-length in host order
+                              , int       payload_len // payload length
+                              , uint8_t  *payload // payload if not 0
+                              , int add_crc
+                              , int add_preamble);
+
 // It fills ARP packet and returns length.
 #define gen_arp_packet populate_arp_hdr
 
@@ -70,14 +177,23 @@ extern int gen_ip_packet( uint8_t  *packet
                         , uint32_t  ip_dst // host order
                         , uint8_t   protocol // type-length in host order
                         , uint8_t   ttl      // time-to-live
-                        , uint16_t  payload_len // IP payload length
+                        , int       payload_len // IP payload length
                         , uint8_t  *payload   // payload if not 0
                         , int       check); // update TCP checksum if 1
 
+extern int gen_ipv6_packet( uint8_t  *packet
+                          , uint8_t   ip_src[16] // network order
+                          , uint8_t   ip_dst[16] // network order
+                          , uint8_t   next_hdr   // e.g., IP_PROTO_UDP
+                          , uint8_t   hop_limit
+                          , int       payload_len // IPv6 payload length
+                          , uint8_t  *payload   // payload if not 0
+                          , int       check); // update UDP/TCP/ICMPv6 checksum if 1
+
 extern int gen_udp_packet( uint8_t  *packet
                          , uint16_t  port_src // host order
                          , uint16_t  port_dst // host order
-                         , uint16_t  payload_len // UDP payload length
+                         , int       payload_len // UDP payload length
                          , uint8_t  *payload); // payload if not 0
 
 extern int gen_tcp_packet( uint8_t  *packet
@@ -85,7 +201,7 @@ extern int gen_tcp_packet( uint8_t  *packet
                          , uint16_t  port_dst // host order
                          , uint32_t  num_seq  // host order
                          , uint32_t  num_ack  // host order
-                         , uint16_t  payload_len // TCP payload length
+                         , int       payload_len // TCP payload length
                          , uint8_t  *payload); // payload if not 0
 
 // It fills ARP packet and returns length
@@ -97,6 +213,16 @@ extern int gen_eth_arp_packet( uint8_t  *packet
                              , uint32_t  ip_dst     // host order
                              , int add_crc // add CRC when 1
                              , int add_preamble); // add preamble when 1
+extern int gen_eth_arp_packet_vlan( uint8_t  *packet
+                                  , uint8_t   mac_src[6] // network order
+                                  , uint8_t   mac_dst[6] // network order
+                                  , const pkt_vlan_t *vlan // tags, outer first
+                                  , int       vlan_num   // num of tags
+                                  , uint16_t  type       // ARP type
+                                  , uint32_t  ip_src     // host order
+                                  , uint32_t  ip_dst     // host order
+                                  , int add_crc // add CRC when 1
+                                  , int add_preamble); // add preamble when 1
 
 extern int gen_eth_ip_udp_packet( uint8_t  *packet
                                 , uint8_t   mac_src[6] // network order
@@ -105,7 +231,7 @@ extern int gen_eth_ip_udp_packet( uint8_t  *packet
                                 , uint32_t  ip_dst     // host order
                                 , uint16_t  port_src   // host order
                                 , uint16_t  port_dst   // host order
-                                , uint16_t  payload_len// UDP payload length
+                                , int       payload_len// UDP payload length
                                 , uint8_t  *payload // payload if not 0
                                 , int check // update UDP header checksum
                                 , int add_crc // add CRC when 1
@@ -120,18 +246,316 @@ extern int gen_eth_ip_tcp_packet( uint8_t  *packet
                                 , uint16_t  port_dst   // host order
                                 , uint32_t  num_seq    // host order
                                 , uint32_t  num_ack    // host order
-                                , uint16_t  payload_len// TCP payload length
+                                , int       payload_len// TCP payload length
                                 , uint8_t  *payload // payload if not 0
                                 , int check // update TCP header checksum
                                 , int add_crc // add CRC when 1
                                 , int add_preamble); // add preamble when 1
+extern int gen_eth_ip_udp_packet_vlan( uint8_t  *packet
+                                     , uint8_t   mac_src[6] // network order
+                                     , uint8_t   mac_dst[6] // network order
+                                     , const pkt_vlan_t *vlan // tags, outer first
+                                     , int       vlan_num   // num of tags
+                                     , uint32_t  ip_src     // host order
+                                     , uint32_t  ip_dst     // host order
+                                     , uint16_t  port_src   // host order
+                                     , uint16_t  port_dst   // host order
+                                     , int       payload_len// UDP payload length
+                                     , uint8_t  *payload // payload if not 0
+                                     , int check // update UDP header checksum
+                                     , int add_crc // add CRC when 1
+                                     , int add_preamble); // add preamble when 1
+extern int gen_eth_ip_tcp_packet_vlan( uint8_t  *packet
+                                     , uint8_t   mac_src[6] // network order
+                                     , uint8_t   mac_dst[6] // network order
+                                     , const pkt_vlan_t *vlan // tags, outer first
+                                     , int       vlan_num   // num of tags
+                                     , uint32_t  ip_src     // host order
+                                     , uint32_t  ip_dst     // host order
+                                     , uint16_t  port_src   // host order
+                                     , uint16_t  port_dst   // host order
+                                     , uint32_t  num_seq    // host order
+                                     , uint32_t  num_ack    // host order
+                                     , int       payload_len// TCP payload length
+                                     , uint8_t  *payload // payload if not 0
+                                     , int check // update TCP header checksum
+                                     , int add_crc // add CRC when 1
+                                     , int add_preamble); // add preamble when 1
+
+//----------------------------------------------------------------------------
+// UDP/TCP over IPv6, where checksum covers IPv6 pseudo header
+// and UDP checksum 0 is sent as 0xFFFF.
+extern int gen_eth_ipv6_udp_packet( uint8_t  *packet
+                                  , uint8_t   mac_src[6] // network order
+                                  , uint8_t   mac_dst[6] // network order
+                                  , uint8_t   ip_src[16] // network order
+                                  , uint8_t   ip_dst[16] // network order
+                                  , uint8_t   hop_limit
+                                  , uint16_t  port_src   // host order
+                                  , uint16_t  port_dst   // host order
+                                  , int       payload_len// UDP payload length
+                                  , uint8_t  *payload // payload if not 0
+                                  , int check // update UDP header checksum
+                                  , int add_crc // add CRC when 1
+                                  , int add_preamble); // add preamble when 1
+extern int gen_eth_ipv6_tcp_packet( uint8_t  *packet
+                                  , uint8_t   mac_src[6] // network order
+                                  , uint8_t   mac_dst[6] // network order
+                                  , uint8_t   ip_src[16] // network order
+                                  , uint8_t   ip_dst[16] // network order
+                                  , uint8_t   hop_limit
+                                  , uint16_t  port_src   // host order
+                                  , uint16_t  port_dst   // host order
+                                  , uint32_t  num_seq    // host order
+                                  , uint32_t  num_ack    // host order
+                                  , int       payload_len// TCP payload length
+                                  , uint8_t  *payload // payload if not 0
+                                  , int check // update TCP header checksum
+                                  , int add_crc // add CRC when 1
+                                  , int add_preamble); // add preamble when 1
+extern int gen_eth_ipv6_udp_packet_vlan( uint8_t  *packet
+                                       , uint8_t   mac_src[6] // network order
+                                       , uint8_t   mac_dst[6] // network order
+                                       , const pkt_vlan_t *vlan // tags, outer first
+                                       , int       vlan_num   // num of tags
+                                       , uint8_t   ip_src[16] // network order
+                                       , uint8_t   ip_dst[16] // network order
+                                       , uint8_t   hop_limit
+                                       , uint16_t  port_src   // host order
+                                       , uint16_t  port_dst   // host order
+                                       , int       payload_len// UDP payload length
+                                       , uint8_t  *payload // payload if not 0
+                                       , int check // update UDP header checksum
+                                       , int add_crc // add CRC when 1
+                                       , int add_preamble); // add preamble when 1
+extern int gen_eth_ipv6_tcp_packet_vlan( uint8_t  *packet
+                                       , uint8_t   mac_src[6] // network order
+                                       , uint8_t   mac_dst[6] // network order
+                                       , const pkt_vlan_t *vlan // tags, outer first
+                                       , int       vlan_num   // num of tags
+                                       , uint8_t   ip_src[16] // network order
+                                       , uint8_t   ip_dst[16] // network order
+                                       , uint8_t   hop_limit
+                                       , uint16_t  port_src   // host order
+                                       , uint16_t  port_dst   // host order
+                                       , uint32_t  num_seq    // host order
+                                       , uint32_t  num_ack    // host order
+                                       , int       payload_len// TCP payload length
+                                       , uint8_t  *payload // payload if not 0
+                                       , int check // update TCP header checksum
+                                       , int add_crc // add CRC when 1
+                                       , int add_preamble); // add preamble when 1
+
+//----------------------------------------------------------------------------
+// ICMP echo over IP and ICMPv6 echo over IPv6, where checksum is computed
+// over echo data; ICMPv6 checksum covers IPv6 pseudo header.
+extern int gen_eth_ip_icmp_echo_packet( uint8_t  *packet
+                                      , uint8_t   mac_src[6] // network order
+                                      , uint8_t   mac_dst[6] // network order
+                                      , uint32_t  ip_src     // host order
+                                      , uint32_t  ip_dst     // host order
+                                      , uint8_t   ttl
+                                      , uint8_t   type       // ICMP_TYPE_ECHO_REQUEST or _REPLY
+                                      , uint16_t  id         // host order
+                                      , uint16_t  seq        // host order
+                                      , int       payload_len// echo data length
+                                      , uint8_t  *payload // payload if not 0
+                                      , int add_crc // add CRC when 1
+                                      , int add_preamble); // add preamble when 1
+extern int gen_eth_ip_icmp_echo_packet_vlan( uint8_t  *packet
+                                           , uint8_t   mac_src[6] // network order
+                                           , uint8_t   mac_dst[6] // network order
+                                           , const pkt_vlan_t *vlan // tags, outer first
+                                           , int       vlan_num   // num of tags
+                                           , uint32_t  ip_src     // host order
+                                           , uint32_t  ip_dst     // host order
+                                           , uint8_t   ttl
+                                           , uint8_t   type       // ICMP_TYPE_ECHO_REQUEST or _REPLY
+                                           , uint16_t  id         // host order
+                                           , uint16_t  seq        // host order
+                                           , int       payload_len// echo data length
+                                           , uint8_t  *payload // payload if not 0
+                                           , int add_crc // add CRC when 1
+                                           , int add_preamble); // add preamble when 1
+extern int gen_eth_ipv6_icmp_echo_packet( uint8_t  *packet
+                                        , uint8_t   mac_src[6] // network order
+                                        , uint8_t   mac_dst[6] // network order
+                                        , uint8_t   ip_src[16] // network order
+                                        , uint8_t   ip_dst[16] // network order
+                                        , uint8_t   hop_limit
+                                        , uint8_t   type       // ICMPV6_TYPE_ECHO_REQUEST or _REPLY
+                                        , uint16_t  id         // host order
+                                        , uint16_t  seq        // host order
+                                        , int       payload_len// echo data length
+                                        , uint8_t  *payload // payload if not 0
+                                        , int add_crc // add CRC when 1
+                                        , int add_preamble); // add preamble when 1
+extern int gen_eth_ipv6_icmp_echo_packet_vlan( uint8_t  *packet
+                                             , uint8_t   mac_src[6] // network order
+                                             , uint8_t   mac_dst[6] // network order
+                                             , const pkt_vlan_t *vlan // tags, outer first
+                                             , int       vlan_num   // num of tags
+                                             , uint8_t   ip_src[16] // network order
+                                             , uint8_t   ip_dst[16] // network order
+                                             , uint8_t   hop_limit
+                                             , uint8_t   type       // ICMPV6_TYPE_ECHO_REQUEST or _REPLY
+                                             , uint16_t  id         // host order
+                                             , uint16_t  seq        // host order
+                                             , int       payload_len// echo data length
+                                             , uint8_t  *payload // payload if not 0
+                                             , int add_crc // add CRC when 1
+                                             , int add_preamble); // add preamble when 1
+// Echo responder: it turns ICMP/ICMPv6 echo request in frame 'eth' (without
+// preamble) into echo reply with addresses swapped and VLAN tags kept;
+// 'packet' can be 'eth'. It returns num of bytes, 0 if not echo request.
+extern int gen_eth_icmp_echo_reply( uint8_t       *packet
+                                  , const uint8_t *eth
+                                  , int            leng
+                                  , int add_crc // add CRC when 1
+                                  , int add_preamble); // add preamble when 1
+
+//----------------------------------------------------------------------------
+// Variants on packet buffer; see 'pkt_buf.h'.
+// Each takes what 'buf' holds as its payload and prepends its header,
+// and returns num of bytes of the packet in 'buf' (-1 when no room or too long).
+extern int gen_eth_packet_buf( pkt_buf_t *buf
+                             , uint8_t    mac_src[6] // network order
+                             , uint8_t    mac_dst[6] // network order
+                             , uint16_t   type_len   // type-length in host order
+                             , int add_crc
+                             , int add_preamble);
+extern int gen_eth_packet_vlan_buf( pkt_buf_t *buf
+                                  , uint8_t    mac_src[6] // network order
+                                  , uint8_t    mac_dst[6] // network order
+                                  , const pkt_vlan_t *vlan // tags, outer first
+                                  , int        vlan_num   // num of tags
+                                  , uint16_t   type_len   // type-length in host order
+                                  , int add_crc
+                                  , int add_preamble);
+extern int gen_ip_packet_buf( pkt_buf_t *buf
+                            , uint32_t   ip_src // host order
+                            , uint32_t   ip_dst // host order
+                            , uint8_t    protocol
+                            , uint8_t    ttl
+                            , int        check); // update UDP/TCP checksum if 1
+extern int gen_udp_packet_buf( pkt_buf_t *buf
+                             , uint16_t   port_src  // host order
+                             , uint16_t   port_dst);// host order
+extern int gen_tcp_packet_buf( pkt_buf_t *buf
+                             , uint16_t   port_src // host order
+                             , uint16_t   port_dst // host order
+                             , uint32_t   num_seq  // host order
+                             , uint32_t   num_ack);// host order
+extern int gen_eth_arp_packet_buf( pkt_buf_t *buf // ARP packet is appended
+                                 , uint8_t    mac_src[6] // network order
+                                 , uint8_t    mac_dst[6] // network order
+                                 , uint16_t   type       // ARP type
+                                 , uint32_t   ip_src     // host order
+                                 , uint32_t   ip_dst     // host order
+                                 , int add_crc
+                                 , int add_preamble);
+extern int gen_eth_ip_udp_packet_buf( pkt_buf_t *buf
+                                    , uint8_t    mac_src[6] // network order
+                                    , uint8_t    mac_dst[6] // network order
+                                    , uint32_t   ip_src     // host order
+                                    , uint32_t   ip_dst     // host order
+                                    , uint16_t   port_src   // host order
+                                    , uint16_t   port_dst   // host order
+                                    , int check // update UDP header checksum
+                                    , int add_crc // add CRC when 1
+                                    , int add_preamble); // add preamble when 1
+extern int gen_eth_ip_tcp_packet_buf( pkt_buf_t *buf
+                                    , uint8_t    mac_src[6] // network order
+                                    , uint8_t    mac_dst[6] // network order
+                                    , uint32_t   ip_src     // host order
+                                    , uint32_t   ip_dst     // host order
+                                    , uint16_t   port_src   // host order
+                                    , uint16_t   port_dst   // host order
+                                    , uint32_t   num_seq    // host order
+                                    , uint32_t   num_ack    // host order
+                                    , int check // update TCP header checksum
+                                    , int add_crc // add CRC when 1
+                                    , int add_preamble); // add preamble when 1
+
+//----------------------------------------------------------------------------
+// Variants on payload given as a list of fragments.
+// Fragments are written into the packet one after another once,
+// while checksum and CRC are computed over them on the way.
+// A fragment of which 'base' is 0 is taken as being in place already.
+typedef struct pkt_iovec {
+    const uint8_t *base; // fragment if not 0
+    int            len ; // num of bytes of fragment
+} pkt_iovec_t;
+
+extern int pkt_iovec_len( const pkt_iovec_t *iov, int iovcnt ); // sum of 'len'
+extern int gen_eth_packet_iov( uint8_t  *packet
+                             , uint8_t   mac_src[6] // network order
+                             , uint8_t   mac_dst[6] // network order
+                             , uint16_t  type_len   // type-length in host order
+                             , const pkt_iovec_t *iov // payload fragments
+                             , int       iovcnt     // num of fragments
+                             , int add_crc
+                             , int add_preamble);
+extern int gen_ip_packet_iov( uint8_t  *packet
+                            , uint32_t  ip_src // host order
+                            , uint32_t  ip_dst // host order
+                            , uint8_t   protocol
+                            , uint8_t   ttl
+                            , const pkt_iovec_t *iov // UDP/TCP header and payload
+                            , int       iovcnt
+                            , int       check); // update UDP/TCP checksum if 1
+extern int gen_udp_packet_iov( uint8_t  *packet
+                             , uint16_t  port_src // host order
+                             , uint16_t  port_dst // host order
+                             , const pkt_iovec_t *iov
+                             , int       iovcnt);
+extern int gen_tcp_packet_iov( uint8_t  *packet
+                             , uint16_t  port_src // host order
+                             , uint16_t  port_dst // host order
+                             , uint32_t  num_seq  // host order
+                             , uint32_t  num_ack  // host order
+                             , const pkt_iovec_t *iov
+                             , int       iovcnt);
+extern int gen_eth_ip_udp_packet_iov( uint8_t  *packet
+                                    , uint8_t   mac_src[6] // network order
+                                    , uint8_t   mac_dst[6] // network order
+                                    , uint32_t  ip_src     // host order
+                                    , uint32_t  ip_dst     // host order
+                                    , uint16_t  port_src   // host order
+                                    , uint16_t  port_dst   // host order
+                                    , const pkt_iovec_t *iov // UDP payload fragments
+                                    , int       iovcnt
+                                    , int check // update UDP header checksum
+                                    , int add_crc // add CRC when 1
+                                    , int add_preamble); // add preamble when 1
+extern int gen_eth_ip_tcp_packet_iov( uint8_t  *packet
+                                    , uint8_t   mac_src[6] // network order
+                                    , uint8_t   mac_dst[6] // network order
+                                    , uint32_t  ip_src     // host order
+                                    , uint32_t  ip_dst     // host order
+                                    , uint16_t  port_src   // host order
+                                    , uint16_t  port_dst   // host order
+                                    , uint32_t  num_seq    // host order
+                                    , uint32_t  num_ack    // host order
+                                    , const pkt_iovec_t *iov // TCP payload fragments
+                                    , int       iovcnt
+                                    , int check // update TCP header checksum
+                                    , int add_crc // add CRC when 1
+                                    , int add_preamble); // add preamble when 1
 
 //----------------------------------------------------------------------------
 extern int parser_eth_packet   (uint8_t *pkt, int leng);
 extern int parser_pseudo_ip_hdr(uint8_t *pkt);
 extern int parser_ip_packet    (uint8_t *pkt, int leng);
+extern int parser_ipv6_packet  (uint8_t *pkt, int leng);
 extern int parser_udp_packet   (uint8_t *pkt, int leng);
 extern int parser_tcp_packet   (uint8_t *pkt, int leng);
+extern int parser_icmp_packet  (uint8_t *pkt, int leng);
+extern int parser_icmpv6_packet(uint8_t *pkt, int leng);
+// It returns offset of upper-layer header following IPv6 extension headers
+// (-1 on error), where 'next_hdr' gets its type and 'frag_off' gets
+// fragment offset in bytes; each can be NULL.
+extern int get_ipv6_upper( const uint8_t *pkt, int leng, uint8_t *next_hdr, int *frag_off );
 //----------------------------------------------------------------------------
 extern int is_broadcast(uint32_t ip_addr, uint32_t ip_local, uint32_t subnet_mask);
 extern int is_multicast(uint32_t ip_addr);
@@ -0,0 +1,285 @@
+//----------------------------------------------------------------------------
+// Copyright (c) 2019 by Ando Ki.
+// All right reserved.
+//----------------------------------------------------------------------------
+// network_dpi_lib.c
+//----------------------------------------------------------------------------
+// VERSION = 2019.05.20.
+//----------------------------------------------------------------------------
+// SystemVerilog DPI-C front end of the packet routines.
+// See 'network_dpi_lib.svh' for SystemVerilog side declarations.
+//
+// Packet and payload are 'byte unsigned' open arrays, which should be
+// dynamic arrays or unpacked arrays declared like '[0:N-1]'.
+// Packet is built directly in the simulator memory when svGetArrayPtr()
+// gives it; otherwise it is built in a scratch buffer and copied.
+//----------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "svdpi.h"
+#include "vpi_user.h"
+#include "eth_ip_udp_tcp_pkt.h"
+#include "ptpv2_message.h"
+#include "network_vpi_util.h"
+
+//----------------------------------------------------------------------------
+// Returns buffer to build 'num' bytes of packet in,
+// which is the memory of 'pkt' if possible.
+// Returns NULL when 'pkt' is shorter than 'num'.
+static uint8_t *dpi_out_buf(const svOpenArrayHandle pkt, int num)
+{
+  uint8_t *buf;
+  if ((svDimensions(pkt)!=1)||(svSize(pkt,1)<num)) return NULL;
+  buf = (uint8_t*)svGetArrayPtr(pkt);
+  if (buf!=NULL) return buf;
+  return vpi_scratch(VPI_SCRATCH_PKT, num);
+}
+
+//----------------------------------------------------------------------------
+// Copies 'num' bytes of 'buf' to 'pkt' unless it is built in place.
+static void dpi_out_done(const svOpenArrayHandle pkt, uint8_t *buf, int num)
+{
+  int idx, low;
+  if (buf==(uint8_t*)svGetArrayPtr(pkt)) return;
+  low = svLow(pkt,1);
+  for (idx=0; idx<num; idx++) {
+       uint8_t *ele = (uint8_t*)svGetArrElemPtr1(pkt, low+idx);
+       if (ele!=NULL) *ele = buf[idx];
+  }
+}
+
+//----------------------------------------------------------------------------
+// Returns 'num' bytes of 'payload', which is the memory of 'payload' if possible.
+// Returns NULL when 'payload' is shorter than 'num'.
+static uint8_t *dpi_in_buf(const svOpenArrayHandle payload, int num)
+{
+  int idx, low;
+  uint8_t *buf;
+  if ((svDimensions(payload)!=1)||(svSize(payload,1)<num)) return NULL;
+  buf = (uint8_t*)svGetArrayPtr(payload);
+  if (buf!=NULL) return buf;
+  buf = vpi_scratch(VPI_SCRATCH_PAYLOAD, num);
+  if (buf==NULL) return NULL;
+  low = svLow(payload,1);
+  for (idx=0; idx<num; idx++) {
+       uint8_t *ele = (uint8_t*)svGetArrElemPtr1(payload, low+idx);
+       buf[idx] = (ele!=NULL) ? *ele : 0;
+  }
+  return buf;
+}
+
+//----------------------------------------------------------------------------
+static void dpi_mac(uint8_t mac[6], uint64_t val)
+{
+  int idx;
+  for (idx=0; idx<6; idx++) mac[idx] = (val>>(8*(5-idx)))&0xFF; // [0]=msb
+}
+
+//----------------------------------------------------------------------------
+// Returns num of bytes of the whole packet, 0 on error.
+int dpi_pkt_ethernet( const svOpenArrayHandle pkt
+                    , uint64_t  mac_dst // [47:40]=msb
+                    , uint64_t  mac_src
+                    , uint16_t  type_len // use 'bnum_payload' when 0
+                    , int       bnum_payload
+                    , const svOpenArrayHandle payload
+                    , int       add_crc
+                    , int       add_preamble)
+{
+  uint8_t  mac_s[6], mac_d[6];
+  uint8_t *eth_pkt, *pld;
+  int tmp;
+
+  dpi_mac(mac_s, mac_src);
+  dpi_mac(mac_d, mac_dst);
+  if ((bnum_payload<0)||(bnum_payload>ETH_PAYLOAD_MAX)) {
+      vpi_printf("ERROR: %s bnum_payload %d beyond the size model.\n", __FUNCTION__, bnum_payload);
+      return 0;
+  }
+  if (type_len==0) type_len = bnum_payload;
+
+  tmp = (add_preamble) ? 8 : 0;
+  tmp += ETH_HDR_LEN;
+  tmp += (bnum_payload<46) ? 46 : bnum_payload;
+  tmp += (add_crc) ? 4 : 0; // num of bytes from preamble (if any) to crc (if any).
+  eth_pkt = dpi_out_buf(pkt, tmp);
+  if (eth_pkt==NULL) {
+      vpi_printf("ERROR: %s pkt must have %d bytes at least.\n", __FUNCTION__, tmp);
+      return 0;
+  }
+  pld = dpi_in_buf(payload, bnum_payload);
+  if (pld==NULL) {
+      vpi_printf("ERROR: %s payload must have %d bytes at least.\n", __FUNCTION__, bnum_payload);
+      return 0;
+  }
+  tmp = gen_eth_packet( eth_pkt
+                      , mac_s
+                      , mac_d
+                      , type_len
+                      , bnum_payload
+                      , pld
+                      , add_crc
+                      , add_preamble);
+  dpi_out_done(pkt, eth_pkt, tmp);
+  return tmp;
+}
+
+//----------------------------------------------------------------------------
+// Returns num of bytes of the whole packet, 0 on error.
+int dpi_pkt_udp_ip_ethernet( const svOpenArrayHandle pkt
+                           , uint16_t  port_src
+                           , uint16_t  port_dst
+                           , uint32_t  ip_src
+                           , uint32_t  ip_dst
+                           , uint8_t   ttl // not used yet as $pkt_udp_ip_ethernet
+                           , uint64_t  mac_src // [47:40]=msb
+                           , uint64_t  mac_dst
+                           , int       bnum_payload
+                           , const svOpenArrayHandle payload
+                           , int       add_crc
+                           , int       add_preamble)
+{
+  uint8_t  mac_s[6], mac_d[6];
+  uint8_t *eth_pkt, *pld;
+  int tmp;
+
+  dpi_mac(mac_s, mac_src);
+  dpi_mac(mac_d, mac_dst);
+  if ((bnum_payload<0)||(bnum_payload>UDP_PAYLOAD_MAX)) {
+      vpi_printf("ERROR: %s bnum_payload %d beyond the size model.\n", __FUNCTION__, bnum_payload);
+      return 0;
+  }
+
+  tmp = (add_preamble) ? 8 : 0;
+  tmp += ETH_HDR_LEN;
+  tmp += ((IP_HDR_LEN+UDP_HDR_LEN+bnum_payload)<46) ? 46 : (IP_HDR_LEN+UDP_HDR_LEN+bnum_payload);
+  tmp += (add_crc) ? 4 : 0;
+  eth_pkt = dpi_out_buf(pkt, tmp);
+  if (eth_pkt==NULL) {
+      vpi_printf("ERROR: %s pkt must have %d bytes at least.\n", __FUNCTION__, tmp);
+      return 0;
+  }
+  pld = dpi_in_buf(payload, bnum_payload);
+  if (pld==NULL) {
+      vpi_printf("ERROR: %s payload must have %d bytes at least.\n", __FUNCTION__, bnum_payload);
+      return 0;
+  }
+  tmp = gen_eth_ip_udp_packet( eth_pkt
+                             , mac_s
+                             , mac_d
+                             , ip_src
+                             , ip_dst
+                             , port_src
+                             , port_dst
+                             , bnum_payload // Pure UDP payload
+                             , pld
+                             , 1 // update UDP checksum
+                             , add_crc
+                             , add_preamble);
+  dpi_out_done(pkt, eth_pkt, tmp);
+  return tmp;
+}
+
+//----------------------------------------------------------------------------
+// Returns num of bytes of the whole packet, 0 on error.
+// 'secondsField' is 48-bit.
+int dpi_msg_ptpv2_udp_ip_ethernet( const svOpenArrayHandle pkt
+                                 , uint64_t  mac_src // [47:40]=msb
+                                 , uint32_t  ip_src
+                                 , uint8_t   messageType
+                                 , uint16_t  flagField
+                                 , uint64_t  correctionField
+                                 , uint64_t  sourceClockID
+                                 , uint16_t  sourcePortID
+                                 , uint16_t  sequenceID
+                                 , uint64_t  secondsField
+                                 , uint32_t  nanosecondsField
+                                 , uint64_t  reqClockID
+                                 , uint16_t  reqPortID
+                                 , int       add_crc
+                                 , int       add_preamble)
+{
+  ptpv2_msg_hdr_t ptpv2_msg_hdr;
+  PortIdentity_t  reqPort;
+  Timestamp_t     time;
+  uint8_t  mac_s[6];
+  uint8_t *ptpv2_msg;
+  int idx, msg_len, tmp;
+
+  dpi_mac(mac_s, mac_src);
+  msg_len = fill_ptpv2_msg_hdr( &ptpv2_msg_hdr
+                              , messageType
+                              , flagField
+                              , correctionField
+                              , sourceClockID
+                              , sourcePortID
+                              , sequenceID);
+  if (msg_len==0) {
+      vpi_printf("ERROR: %s unknown PTPv2 message type: %u\n", __FUNCTION__, messageType&0xF);
+      return 0;
+  }
+  for (idx=0; idx<8; idx++) reqPort.clockIdentity[idx] = (reqClockID>>(8*(7-idx)))&0xFF;
+  reqPort.portNumber = htons(reqPortID);
+  time.secondsField.msb = (secondsField>>32)&0xFFFF;
+  time.secondsField.lsb =  secondsField&0xFFFFFFFF;
+  time.nanosecondsField = nanosecondsField;
+
+  msg_len = ((UDP_HDR_LEN+IP_HDR_LEN+msg_len)<46) ? 46 : (UDP_HDR_LEN+IP_HDR_LEN+msg_len);
+  msg_len += ETH_HDR_LEN;
+  msg_len += (add_preamble) ? 8 : 0;
+  msg_len += (add_crc     ) ? 4 : 0;
+  ptpv2_msg = dpi_out_buf(pkt, msg_len);
+  if (ptpv2_msg==NULL) {
+      vpi_printf("ERROR: %s pkt must have %d bytes at least.\n", __FUNCTION__, msg_len);
+      return 0;
+  }
+  if (svSize(pkt,1)<PTPV2_FRAME_MAX) { // built apart and then copied
+      ptpv2_msg = vpi_scratch(VPI_SCRATCH_PKT, PTPV2_FRAME_MAX);
+      if (ptpv2_msg==NULL) {
+          vpi_printf("ERROR: %s scratch buffer error.\n", __FUNCTION__);
+          return 0;
+      }
+  }
+  tmp = gen_ptpv2_msg_udp_ip_ethernet( get_ptpv2_context()
+                                     , ptpv2_msg
+                                     , mac_s
+                                     , ip_src
+                                     ,&ptpv2_msg_hdr
+                                     ,&time
+                                     ,&reqPort
+                                     , add_crc
+                                     , add_preamble);
+  dpi_out_done(pkt, ptpv2_msg, tmp);
+  return tmp;
+}
+
+//----------------------------------------------------------------------------
+// Returns 0 on success.
+int dpi_pkt_ethernet_parser( const svOpenArrayHandle pkt
+                           , int       bnum_pkt
+                           , int       crc
+                           , int       preamble)
+{
+  uint8_t *eth_pkt;
+  int idx=0, leng;
+
+  eth_pkt = dpi_in_buf(pkt, bnum_pkt);
+  if (eth_pkt==NULL) {
+      vpi_printf("ERROR: %s pkt must have %d bytes at least.\n", __FUNCTION__, bnum_pkt);
+      return -1;
+  }
+  if (preamble&&(bnum_pkt>=8)) idx = 8;
+  leng = bnum_pkt-idx;
+  if (crc&&(leng>=4)) leng -= 4; // FCS is not parsed
+  parser_eth_packet(&eth_pkt[idx], leng);
+  fflush(stdout);
+  return 0;
+}
+
+//----------------------------------------------------------------------------
+// Revision history:
+//
+// 2019.05.20: Rewritten by Ando Ki (andoki@gmail.com)
+//----------------------------------------------------------------------------
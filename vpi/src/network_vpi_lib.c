@@ -23,6 +23,12 @@
 #include "vpi_user.h"
 #include "eth_ip_udp_tcp_pkt.h"
 #include "ptpv2_message.h"
+#include "pkt_template.h"
+#include "pkt_segment.h"
+#include "pkt_reasm.h"
+#include "pkt_stream.h"
+#include "pkt_arp.h"
+#include "network_vpi_util.h"
 
 //----------------------------------------------------------------------------
 static int m_verbose = 0;
@@ -104,6 +110,44 @@ PLI_INT32 pkt_tcp_Calltf   (PLI_BYTE8 *user_data);
 PLI_INT32 pkt_udp_ip_eth_Compiletf(PLI_BYTE8 *user_data);
 PLI_INT32 pkt_udp_ip_eth_Calltf   (PLI_BYTE8 *user_data);
 
+//----------------------------------------------------------------------------
+// Build a burst of frames into 2-D memory in a single call,
+// where some fields are incremented for each next frame.
+PLI_INT32 pkt_eth_burst_Compiletf(PLI_BYTE8 *user_data);
+PLI_INT32 pkt_eth_burst_Calltf   (PLI_BYTE8 *user_data);
+PLI_INT32 pkt_udp_ip_eth_burst_Compiletf(PLI_BYTE8 *user_data);
+PLI_INT32 pkt_udp_ip_eth_burst_Calltf   (PLI_BYTE8 *user_data);
+PLI_INT32 pkt_tcp_ip_eth_burst_Compiletf(PLI_BYTE8 *user_data);
+PLI_INT32 pkt_tcp_ip_eth_burst_Calltf   (PLI_BYTE8 *user_data);
+
+//----------------------------------------------------------------------------
+// Cut TCP payload into MSS-byte segments in a single call as TSO of NIC does,
+// where each segment goes to a row of 2-D memory.
+PLI_INT32 pkt_tcp_segment_Compiletf(PLI_BYTE8 *user_data);
+PLI_INT32 pkt_tcp_segment_Calltf   (PLI_BYTE8 *user_data);
+
+//----------------------------------------------------------------------------
+// Cut IP payload into IPv4 fragments fitting MTU in a single call,
+// where each fragment goes to a row of 2-D memory.
+PLI_INT32 pkt_ip_fragment_Compiletf(PLI_BYTE8 *user_data);
+PLI_INT32 pkt_ip_fragment_Calltf   (PLI_BYTE8 *user_data);
+
+//----------------------------------------------------------------------------
+// Build UDP/IP/Ethernet or TCP/IP/Ethernet frame once as a template
+// and emit its variants by patching fields named by strings.
+// $pkt_template_create( tpl // template id; -1 on failure
+//                     , protocol, port_src, port_dst, ip_src, ip_dst
+//                     , mac_src, mac_dst, bnum_payload, payload
+//                     , max_payload, add_crc, add_preamble);
+// $pkt_template_emit( pkt, bnum_pkt, tpl [, "field", value]*);
+// $pkt_template_release( tpl );
+PLI_INT32 pkt_template_create_Compiletf (PLI_BYTE8 *user_data);
+PLI_INT32 pkt_template_create_Calltf    (PLI_BYTE8 *user_data);
+PLI_INT32 pkt_template_emit_Compiletf   (PLI_BYTE8 *user_data);
+PLI_INT32 pkt_template_emit_Calltf      (PLI_BYTE8 *user_data);
+PLI_INT32 pkt_template_release_Compiletf(PLI_BYTE8 *user_data);
+PLI_INT32 pkt_template_release_Calltf   (PLI_BYTE8 *user_data);
+
 //----------------------------------------------------------------------------
 // Initialize PTPv2 context
 // $msg_ptpv2_set_context( ptp_version 
@@ -128,6 +172,46 @@ PLI_INT32 msg_ptpv2_set_context_Calltf   (PLI_BYTE8 *user_data);
 PLI_INT32 msg_ptpv2_get_context_Compiletf(PLI_BYTE8 *user_data);
 PLI_INT32 msg_ptpv2_get_context_Calltf   (PLI_BYTE8 *user_data);
 
+//----------------------------------------------------------------------------
+// Set fields of PTPv2 Announce and Management
+// $msg_ptpv2_set_announce( currentUtcOffset
+//                        , grandmasterPriority1
+//                        , grandmasterClockClass
+//                        , grandmasterClockAccuracy
+//                        , grandmasterClockVariance // offsetScaledLogVariance
+//                        , grandmasterPriority2
+//                        , grandmasterIdentity [63:0]
+//                        , stepsRemoved
+//                        , timeSource
+//                        );
+// $msg_ptpv2_set_management( actionField, boundaryHops );
+PLI_INT32 msg_ptpv2_set_announce_Compiletf(PLI_BYTE8 *user_data);
+PLI_INT32 msg_ptpv2_set_announce_Calltf   (PLI_BYTE8 *user_data);
+PLI_INT32 msg_ptpv2_set_management_Compiletf(PLI_BYTE8 *user_data);
+PLI_INT32 msg_ptpv2_set_management_Calltf   (PLI_BYTE8 *user_data);
+
+//----------------------------------------------------------------------------
+// Append TLV to PTPv2 messages of 'messageType' built afterwards,
+// where 'tlvType' 0 removes all TLVs of 'messageType'.
+// $msg_ptpv2_tlv( messageType [ 3:0]
+//               , tlvType     [15:0]
+//               , bnum_value  [15:0]
+//               , value       [ 7:0][0:N-1]
+//               );
+PLI_INT32 msg_ptpv2_tlv_Compiletf(PLI_BYTE8 *user_data);
+PLI_INT32 msg_ptpv2_tlv_Calltf   (PLI_BYTE8 *user_data);
+
+//----------------------------------------------------------------------------
+// Build whole PTPv2 exchanges into 2-D memory in a single call,
+// where timestamps advance by 'interval' for each exchange.
+// $msg_ptpv2_sequence( pkt, bnum_pkt, num_frame, exchange, num_exchange
+//                    , mac_src, ip_src, sourceClockID, sourcePortID
+//                    , mac_peer, ip_peer, peerClockID, peerPortID
+//                    , sequenceID, secondsField, nanosecondsField
+//                    , interval, delay, turnaround, udp, add_crc, add_preamble);
+PLI_INT32 msg_ptpv2_sequence_Compiletf(PLI_BYTE8 *user_data);
+PLI_INT32 msg_ptpv2_sequence_Calltf   (PLI_BYTE8 *user_data);
+
 //----------------------------------------------------------------------------
 // Build PTPv2 message
 // $msg_ptpv2( pkt             [ 7:0][0:1024*4-1]
@@ -196,6 +280,80 @@ PLI_INT32 msg_ptpv2_udp_ip_eth_Calltf   (PLI_BYTE8 *user_data);
 PLI_INT32 pkt_eth_parser_Compiletf(PLI_BYTE8 *user_data);
 PLI_INT32 pkt_eth_parser_Calltf   (PLI_BYTE8 *user_data);
 
+//----------------------------------------------------------------------------
+// $pkt_ip_reassembly( max_flows, max_bytes, timeout );
+// It sets IPv4 reassembly of $pkt_ethernet_parser, where fragments are kept
+// till their datagram is completed and then the datagram is parsed.
+PLI_INT32 pkt_ip_reassembly_Compiletf(PLI_BYTE8 *user_data);
+PLI_INT32 pkt_ip_reassembly_Calltf   (PLI_BYTE8 *user_data);
+
+//----------------------------------------------------------------------------
+// $pkt_tcp_stream( pkt, bnum_pkt, preamble, data, bnum_data );
+// It puts TCP segment in Ethernet frame to reassembly of its connection,
+// and returns bytes delivered in order by the segment through 'data'.
+// $pkt_tcp_stream_stat( ip_src, ip_dst, port_src, port_dst
+//                     , delivered, retransmits, gaps, window_violations );
+PLI_INT32 pkt_tcp_stream_Compiletf(PLI_BYTE8 *user_data);
+PLI_INT32 pkt_tcp_stream_Calltf   (PLI_BYTE8 *user_data);
+PLI_INT32 pkt_tcp_stream_stat_Compiletf(PLI_BYTE8 *user_data);
+PLI_INT32 pkt_tcp_stream_stat_Calltf   (PLI_BYTE8 *user_data);
+
+//----------------------------------------------------------------------------
+// $pkt_vlan( vlan_num, tag_outer, tag_inner );
+// It sets VLAN tags of frames built by $pkt_ethernet, $pkt_udp_ip_ethernet,
+// $pkt_*_ipv6_ethernet, burst of them, $msg_ptpv2_*ethernet and $msg_ptpv2_sequence,
+// where a tag is {TPID,TCI}.
+PLI_INT32 pkt_vlan_Compiletf(PLI_BYTE8 *user_data);
+PLI_INT32 pkt_vlan_Calltf   (PLI_BYTE8 *user_data);
+
+//----------------------------------------------------------------------------
+// $pkt_udp_ipv6_ethernet( pkt, bnum_pkt, port_src, port_dst
+//                       , ip_src[127:0], ip_dst[127:0], hop_limit
+//                       , mac_src, mac_dst, bnum_payload, payload
+//                       , add_crc, add_preamble);
+// $pkt_tcp_ipv6_ethernet( pkt, bnum_pkt, port_src, port_dst, seq_num, ack_num
+//                       , ip_src[127:0], ip_dst[127:0], hop_limit
+//                       , mac_src, mac_dst, bnum_payload, payload
+//                       , add_crc, add_preamble);
+PLI_INT32 pkt_udp_ipv6_eth_Compiletf(PLI_BYTE8 *user_data);
+PLI_INT32 pkt_udp_ipv6_eth_Calltf   (PLI_BYTE8 *user_data);
+PLI_INT32 pkt_tcp_ipv6_eth_Compiletf(PLI_BYTE8 *user_data);
+PLI_INT32 pkt_tcp_ipv6_eth_Calltf   (PLI_BYTE8 *user_data);
+
+//----------------------------------------------------------------------------
+// $pkt_arp( pkt, bnum_pkt, op, ip_src, ip_dst, mac_src, mac_dst
+//         , add_crc, add_preamble );
+// $pkt_arp_host( ip, mac ); // local host answered by the responder; mac 0 to remove
+// $pkt_arp_monitor( pkt, bnum_pkt, preamble, num_reply ); // frame received
+// $pkt_arp_reply( pkt, bnum_pkt, add_crc, add_preamble ); // reply queued; bnum_pkt 0 if none
+// $pkt_arp_lookup( ip, mac, found );
+PLI_INT32 pkt_arp_Compiletf(PLI_BYTE8 *user_data);
+PLI_INT32 pkt_arp_Calltf   (PLI_BYTE8 *user_data);
+PLI_INT32 pkt_arp_host_Compiletf(PLI_BYTE8 *user_data);
+PLI_INT32 pkt_arp_host_Calltf   (PLI_BYTE8 *user_data);
+PLI_INT32 pkt_arp_monitor_Compiletf(PLI_BYTE8 *user_data);
+PLI_INT32 pkt_arp_monitor_Calltf   (PLI_BYTE8 *user_data);
+PLI_INT32 pkt_arp_reply_Compiletf(PLI_BYTE8 *user_data);
+PLI_INT32 pkt_arp_reply_Calltf   (PLI_BYTE8 *user_data);
+PLI_INT32 pkt_arp_lookup_Compiletf(PLI_BYTE8 *user_data);
+PLI_INT32 pkt_arp_lookup_Calltf   (PLI_BYTE8 *user_data);
+
+//----------------------------------------------------------------------------
+// $pkt_icmp_ip_ethernet( pkt, bnum_pkt, type, id, seq, ip_src, ip_dst, ttl
+//                      , mac_src, mac_dst, bnum_payload, payload
+//                      , add_crc, add_preamble );
+// $pkt_icmp_ipv6_ethernet( pkt, bnum_pkt, type, id, seq, ip_src, ip_dst, hop_limit
+//                        , mac_src, mac_dst, bnum_payload, payload
+//                        , add_crc, add_preamble );
+// $pkt_icmp_echo_reply( pkt, bnum_pkt, preamble, reply, bnum_reply
+//                     , add_crc, add_preamble ); // bnum_reply 0 if not echo request
+PLI_INT32 pkt_icmp_ip_eth_Compiletf(PLI_BYTE8 *user_data);
+PLI_INT32 pkt_icmp_ip_eth_Calltf   (PLI_BYTE8 *user_data);
+PLI_INT32 pkt_icmp_ipv6_eth_Compiletf(PLI_BYTE8 *user_data);
+PLI_INT32 pkt_icmp_ipv6_eth_Calltf   (PLI_BYTE8 *user_data);
+PLI_INT32 pkt_icmp_echo_reply_Compiletf(PLI_BYTE8 *user_data);
+PLI_INT32 pkt_icmp_echo_reply_Calltf   (PLI_BYTE8 *user_data);
+
 //----------------------------------------------------------------------------
 // $pkt_eth_verbose; ==> $pkt_verbose(0);
 // $pkt_eth_verbose(); ==> $pkt_verbose(0);
@@ -204,6 +362,23 @@ PLI_INT32   pkt_eth_verbose_Calltf   (PLI_BYTE8 *user_data);
 PLI_INT32   pkt_eth_verbose_Compiletf(PLI_BYTE8 *user_data);
 PLI_INT32   pkt_eth_verbose_Sizetf   (PLI_BYTE8 *user_data);
 
+//----------------------------------------------------------------------------
+// It returns host wall-clock time in micro-seconds,
+// which is used to measure how many packets are built per second.
+// $pkt_wallclock ==> 64-bit
+PLI_INT32   pkt_wallclock_Calltf   (PLI_BYTE8 *user_data);
+PLI_INT32   pkt_wallclock_Sizetf   (PLI_BYTE8 *user_data);
+
+//----------------------------------------------------------------------------
+// It returns num of argument and array element handles obtained by the
+// library so far; it does not grow when the same call site is called again.
+// $pkt_vpi_handles ==> 32-bit
+PLI_INT32   pkt_vpi_handles_Calltf   (PLI_BYTE8 *user_data);
+PLI_INT32   pkt_vpi_handles_Sizetf   (PLI_BYTE8 *user_data);
+
+//----------------------------------------------------------------------------
+PLI_INT32   pkt_end_of_sim(p_cb_data cb_data);
+
 //----------------------------------------------------------------------------
 void pkt_register() {
     s_vpi_systf_data tf_data;
@@ -253,6 +428,78 @@ void pkt_register() {
     tf_data.user_data   = NULL;
     vpi_register_systf(&tf_data);
 
+    tf_data.type        = vpiSysTask;
+    tf_data.sysfunctype = 0;
+    tf_data.tfname      = "$pkt_ethernet_burst";
+    tf_data.calltf      = pkt_eth_burst_Calltf;
+    tf_data.compiletf   = pkt_eth_burst_Compiletf;
+    tf_data.sizetf      = NULL;
+    tf_data.user_data   = NULL;
+    vpi_register_systf(&tf_data);
+
+    tf_data.type        = vpiSysTask;
+    tf_data.sysfunctype = 0;
+    tf_data.tfname      = "$pkt_udp_ip_ethernet_burst";
+    tf_data.calltf      = pkt_udp_ip_eth_burst_Calltf;
+    tf_data.compiletf   = pkt_udp_ip_eth_burst_Compiletf;
+    tf_data.sizetf      = NULL;
+    tf_data.user_data   = NULL;
+    vpi_register_systf(&tf_data);
+
+    tf_data.type        = vpiSysTask;
+    tf_data.sysfunctype = 0;
+    tf_data.tfname      = "$pkt_tcp_ip_ethernet_burst";
+    tf_data.calltf      = pkt_tcp_ip_eth_burst_Calltf;
+    tf_data.compiletf   = pkt_tcp_ip_eth_burst_Compiletf;
+    tf_data.sizetf      = NULL;
+    tf_data.user_data   = NULL;
+    vpi_register_systf(&tf_data);
+
+    tf_data.type        = vpiSysTask;
+    tf_data.sysfunctype = 0;
+    tf_data.tfname      = "$pkt_tcp_segment";
+    tf_data.calltf      = pkt_tcp_segment_Calltf;
+    tf_data.compiletf   = pkt_tcp_segment_Compiletf;
+    tf_data.sizetf      = NULL;
+    tf_data.user_data   = NULL;
+    vpi_register_systf(&tf_data);
+
+    tf_data.type        = vpiSysTask;
+    tf_data.sysfunctype = 0;
+    tf_data.tfname      = "$pkt_ip_fragment";
+    tf_data.calltf      = pkt_ip_fragment_Calltf;
+    tf_data.compiletf   = pkt_ip_fragment_Compiletf;
+    tf_data.sizetf      = NULL;
+    tf_data.user_data   = NULL;
+    vpi_register_systf(&tf_data);
+
+    tf_data.type        = vpiSysTask;
+    tf_data.sysfunctype = 0;
+    tf_data.tfname      = "$pkt_template_create";
+    tf_data.calltf      = pkt_template_create_Calltf;
+    tf_data.compiletf   = pkt_template_create_Compiletf;
+    tf_data.sizetf      = NULL;
+    tf_data.user_data   = NULL;
+    vpi_register_systf(&tf_data);
+
+    tf_data.type        = vpiSysTask;
+    tf_data.sysfunctype = 0;
+    tf_data.tfname      = "$pkt_template_emit";
+    tf_data.calltf      = pkt_template_emit_Calltf;
+    tf_data.compiletf   = pkt_template_emit_Compiletf;
+    tf_data.sizetf      = NULL;
+    tf_data.user_data   = NULL;
+    vpi_register_systf(&tf_data);
+
+    tf_data.type        = vpiSysTask;
+    tf_data.sysfunctype = 0;
+    tf_data.tfname      = "$pkt_template_release";
+    tf_data.calltf      = pkt_template_release_Calltf;
+    tf_data.compiletf   = pkt_template_release_Compiletf;
+    tf_data.sizetf      = NULL;
+    tf_data.user_data   = NULL;
+    vpi_register_systf(&tf_data);
+
     tf_data.type        = vpiSysTask;
     tf_data.sysfunctype = 0;
     tf_data.tfname      = "$msg_ptpv2_set_context";
@@ -271,6 +518,42 @@ void pkt_register() {
     tf_data.user_data   = NULL;
     vpi_register_systf(&tf_data);
 
+    tf_data.type        = vpiSysTask;
+    tf_data.sysfunctype = 0;
+    tf_data.tfname      = "$msg_ptpv2_set_announce";
+    tf_data.calltf      = msg_ptpv2_set_announce_Calltf;
+    tf_data.compiletf   = msg_ptpv2_set_announce_Compiletf;
+    tf_data.sizetf      = NULL;
+    tf_data.user_data   = NULL;
+    vpi_register_systf(&tf_data);
+
+    tf_data.type        = vpiSysTask;
+    tf_data.sysfunctype = 0;
+    tf_data.tfname      = "$msg_ptpv2_set_management";
+    tf_data.calltf      = msg_ptpv2_set_management_Calltf;
+    tf_data.compiletf   = msg_ptpv2_set_management_Compiletf;
+    tf_data.sizetf      = NULL;
+    tf_data.user_data   = NULL;
+    vpi_register_systf(&tf_data);
+
+    tf_data.type        = vpiSysTask;
+    tf_data.sysfunctype = 0;
+    tf_data.tfname      = "$msg_ptpv2_tlv";
+    tf_data.calltf      = msg_ptpv2_tlv_Calltf;
+    tf_data.compiletf   = msg_ptpv2_tlv_Compiletf;
+    tf_data.sizetf      = NULL;
+    tf_data.user_data   = NULL;
+    vpi_register_systf(&tf_data);
+
+    tf_data.type        = vpiSysTask;
+    tf_data.sysfunctype = 0;
+    tf_data.tfname      = "$msg_ptpv2_sequence";
+    tf_data.calltf      = msg_ptpv2_sequence_Calltf;
+    tf_data.compiletf   = msg_ptpv2_sequence_Compiletf;
+    tf_data.sizetf      = NULL;
+    tf_data.user_data   = NULL;
+    vpi_register_systf(&tf_data);
+
     tf_data.type        = vpiSysTask;
     tf_data.sysfunctype = 0;
     tf_data.tfname      = "$msg_ptpv2";
@@ -307,6 +590,132 @@ void pkt_register() {
     tf_data.user_data   = NULL;
     vpi_register_systf(&tf_data);
 
+    tf_data.type        = vpiSysTask;
+    tf_data.sysfunctype = 0;
+    tf_data.tfname      = "$pkt_ip_reassembly";
+    tf_data.calltf      = pkt_ip_reassembly_Calltf;
+    tf_data.compiletf   = pkt_ip_reassembly_Compiletf;
+    tf_data.sizetf      = NULL;
+    tf_data.user_data   = NULL;
+    vpi_register_systf(&tf_data);
+
+    tf_data.type        = vpiSysTask;
+    tf_data.sysfunctype = 0;
+    tf_data.tfname      = "$pkt_tcp_stream";
+    tf_data.calltf      = pkt_tcp_stream_Calltf;
+    tf_data.compiletf   = pkt_tcp_stream_Compiletf;
+    tf_data.sizetf      = NULL;
+    tf_data.user_data   = NULL;
+    vpi_register_systf(&tf_data);
+
+    tf_data.type        = vpiSysTask;
+    tf_data.sysfunctype = 0;
+    tf_data.tfname      = "$pkt_tcp_stream_stat";
+    tf_data.calltf      = pkt_tcp_stream_stat_Calltf;
+    tf_data.compiletf   = pkt_tcp_stream_stat_Compiletf;
+    tf_data.sizetf      = NULL;
+    tf_data.user_data   = NULL;
+    vpi_register_systf(&tf_data);
+
+    tf_data.type        = vpiSysTask;
+    tf_data.sysfunctype = 0;
+    tf_data.tfname      = "$pkt_vlan";
+    tf_data.calltf      = pkt_vlan_Calltf;
+    tf_data.compiletf   = pkt_vlan_Compiletf;
+    tf_data.sizetf      = NULL;
+    tf_data.user_data   = NULL;
+    vpi_register_systf(&tf_data);
+
+    tf_data.type        = vpiSysTask;
+    tf_data.sysfunctype = 0;
+    tf_data.tfname      = "$pkt_udp_ipv6_ethernet";
+    tf_data.calltf      = pkt_udp_ipv6_eth_Calltf;
+    tf_data.compiletf   = pkt_udp_ipv6_eth_Compiletf;
+    tf_data.sizetf      = NULL;
+    tf_data.user_data   = NULL;
+    vpi_register_systf(&tf_data);
+
+    tf_data.type        = vpiSysTask;
+    tf_data.sysfunctype = 0;
+    tf_data.tfname      = "$pkt_tcp_ipv6_ethernet";
+    tf_data.calltf      = pkt_tcp_ipv6_eth_Calltf;
+    tf_data.compiletf   = pkt_tcp_ipv6_eth_Compiletf;
+    tf_data.sizetf      = NULL;
+    tf_data.user_data   = NULL;
+    vpi_register_systf(&tf_data);
+
+    tf_data.type        = vpiSysTask;
+    tf_data.sysfunctype = 0;
+    tf_data.tfname      = "$pkt_arp";
+    tf_data.calltf      = pkt_arp_Calltf;
+    tf_data.compiletf   = pkt_arp_Compiletf;
+    tf_data.sizetf      = NULL;
+    tf_data.user_data   = NULL;
+    vpi_register_systf(&tf_data);
+
+    tf_data.type        = vpiSysTask;
+    tf_data.sysfunctype = 0;
+    tf_data.tfname      = "$pkt_arp_host";
+    tf_data.calltf      = pkt_arp_host_Calltf;
+    tf_data.compiletf   = pkt_arp_host_Compiletf;
+    tf_data.sizetf      = NULL;
+    tf_data.user_data   = NULL;
+    vpi_register_systf(&tf_data);
+
+    tf_data.type        = vpiSysTask;
+    tf_data.sysfunctype = 0;
+    tf_data.tfname      = "$pkt_arp_monitor";
+    tf_data.calltf      = pkt_arp_monitor_Calltf;
+    tf_data.compiletf   = pkt_arp_monitor_Compiletf;
+    tf_data.sizetf      = NULL;
+    tf_data.user_data   = NULL;
+    vpi_register_systf(&tf_data);
+
+    tf_data.type        = vpiSysTask;
+    tf_data.sysfunctype = 0;
+    tf_data.tfname      = "$pkt_arp_reply";
+    tf_data.calltf      = pkt_arp_reply_Calltf;
+    tf_data.compiletf   = pkt_arp_reply_Compiletf;
+    tf_data.sizetf      = NULL;
+    tf_data.user_data   = NULL;
+    vpi_register_systf(&tf_data);
+
+    tf_data.type        = vpiSysTask;
+    tf_data.sysfunctype = 0;
+    tf_data.tfname      = "$pkt_arp_lookup";
+    tf_data.calltf      = pkt_arp_lookup_Calltf;
+    tf_data.compiletf   = pkt_arp_lookup_Compiletf;
+    tf_data.sizetf      = NULL;
+    tf_data.user_data   = NULL;
+    vpi_register_systf(&tf_data);
+
+    tf_data.type        = vpiSysTask;
+    tf_data.sysfunctype = 0;
+    tf_data.tfname      = "$pkt_icmp_ip_ethernet";
+    tf_data.calltf      = pkt_icmp_ip_eth_Calltf;
+    tf_data.compiletf   = pkt_icmp_ip_eth_Compiletf;
+    tf_data.sizetf      = NULL;
+    tf_data.user_data   = NULL;
+    vpi_register_systf(&tf_data);
+
+    tf_data.type        = vpiSysTask;
+    tf_data.sysfunctype = 0;
+    tf_data.tfname      = "$pkt_icmp_ipv6_ethernet";
+    tf_data.calltf      = pkt_icmp_ipv6_eth_Calltf;
+    tf_data.compiletf   = pkt_icmp_ipv6_eth_Compiletf;
+    tf_data.sizetf      = NULL;
+    tf_data.user_data   = NULL;
+    vpi_register_systf(&tf_data);
+
+    tf_data.type        = vpiSysTask;
+    tf_data.sysfunctype = 0;
+    tf_data.tfname      = "$pkt_icmp_echo_reply";
+    tf_data.calltf      = pkt_icmp_echo_reply_Calltf;
+    tf_data.compiletf   = pkt_icmp_echo_reply_Compiletf;
+    tf_data.sizetf      = NULL;
+    tf_data.user_data   = NULL;
+    vpi_register_systf(&tf_data);
+
     tf_data.type        = vpiSysFunc;
     tf_data.sysfunctype = vpiSizedFunc; //vpiSysFuncSized;
     tf_data.tfname      = "$pkt_eth_verbose";
@@ -315,6 +724,34 @@ void pkt_register() {
     tf_data.sizetf      = pkt_eth_verbose_Sizetf;
     tf_data.user_data   = NULL;
     vpi_register_systf(&tf_data);
+
+    tf_data.type        = vpiSysFunc;
+    tf_data.sysfunctype = vpiSizedFunc;
+    tf_data.tfname      = "$pkt_wallclock";
+    tf_data.calltf      = pkt_wallclock_Calltf;
+    tf_data.compiletf   = NULL;
+    tf_data.sizetf      = pkt_wallclock_Sizetf;
+    tf_data.user_data   = NULL;
+    vpi_register_systf(&tf_data);
+
+    tf_data.type        = vpiSysFunc;
+    tf_data.sysfunctype = vpiSizedFunc;
+    tf_data.tfname      = "$pkt_vpi_handles";
+    tf_data.calltf      = pkt_vpi_handles_Calltf;
+    tf_data.compiletf   = NULL;
+    tf_data.sizetf      = pkt_vpi_handles_Sizetf;
+    tf_data.user_data   = NULL;
+    vpi_register_systf(&tf_data);
+
+    s_cb_data cb_data;
+    cb_data.reason    = cbEndOfSimulation;
+    cb_data.cb_rtn    = pkt_end_of_sim;
+    cb_data.obj       = NULL;
+    cb_data.time      = NULL;
+    cb_data.value     = NULL;
+    cb_data.index     = 0;
+    cb_data.user_data = NULL;
+    vpi_register_cb(&cb_data);
 }
 
 //----------------------------------------------------------------------------
@@ -329,8 +766,12 @@ void pkt_register() {
               (C) = vpi_get(vpiSize, arg_handle);\
               ele_handle = vpi_handle_by_index(arg_handle, 0);\
               (D) = vpi_get(vpiSize, ele_handle);\
+          } else if (vpi_get(vpiVector, arg_handle)&&\
+                     ((vpi_get(vpiSize, arg_handle)%8)==0)) {\
+              (C) = vpi_get(vpiSize, arg_handle)/8;\
+              (D) = 8;\
           } else {\
-              vpi_printf("ERROR: %s %s argument must be array\n", TASK_NAME, (A));\
+              vpi_printf("ERROR: %s %s argument must be array or vector of bytes\n", TASK_NAME, (A));\
               vpi_free_object(arg_iterator);\
               pkt_control(vpiFinish);\
           }\
@@ -423,6 +864,8 @@ PLI_INT32 pkt_eth_Compiletf(PLI_BYTE8 *user_data) {
       pkt_control(vpiFinish);
   }
 
+  if (vpi_tf_ctx_build(systf_handle)==NULL) pkt_control(vpiFinish);
+
   return(0);
 }
 #undef TASK_NAME
@@ -436,21 +879,69 @@ PLI_INT32 pkt_eth_Compiletf(PLI_BYTE8 *user_data) {
         vpi_get_value((A), &value);\
         (C) = (B)value.value.integer;
 #define GET_ARRAY_ARG(A,B,C,D)\
-        value.format = vpiIntVal;\
-        for (idy=(B), idz=0; idy<(C); idy++, idz++) {\
-             vpiHandle ele = vpi_handle_by_index((A), idy);\
-             vpi_get_value(ele, &value);\
-             (D)[idz] = value.value.integer;\
-        }
+        vpi_array_get((A), (B), (C)-(B), (D));
+#define PUT_ARRAY_ARG(A,B,C,D)\
+        vpi_array_put((A), (B), (C)-(B), (D));
 //----------------------------------------------------------------------------
 #define PUT_INT_ARG(h,t,v)\
         value.format = vpiIntVal;\
         value.value.integer = (v);\
         vpi_put_value((h), &value, NULL, vpiNoDelay);
 
+//----------------------------------------------------------------------------
+// Size model: packet and payload lengths are 'int' up to ETH_FRAME_MAX,
+// i.e., jumbo frame and 64 KiB IP datagram, so that 'bnum' arguments
+// may be wider than 16 bits, e.g., 'integer'.
+//
+// It checks 'num' bytes fit 'idx'-th array argument; 'num' is -1 when
+// the builder finds the length beyond the size model.
+// return 0 on success, -1 on failure
+static int pkt_fit_array(vpi_tf_ctx_t *tf_ctx, int idx, int num, const char *func)
+{
+  vpi_array_t *array = vpi_tf_ctx_array(tf_ctx, idx);
+  if (num<0) {
+      vpi_printf("ERROR: %s() length beyond the size model.\n", func);
+      return -1;
+  }
+  if ((array!=NULL)&&(array->num<num)) {
+      vpi_printf("ERROR: %s() argument %d must have %d bytes at least, but %d.\n"
+                , func, idx+1, num, array->num);
+      return -1;
+  }
+  return 0;
+}
+
+//----------------------------------------------------------------------------
+// It puts 'num' to 'handle' after checking it is not truncated,
+// e.g., 9600-byte jumbo frame does not fit 'reg [12:0]'.
+// 0 is a valid count, e.g., no reply or no byte delivered.
+// return 0 on success, -1 on truncation
+static int pkt_put_bnum(vpiHandle handle, int num, const char *func)
+{
+  s_vpi_value value;
+  int width = vpi_get(vpiSize, handle);
+  int ret = 0;
+  if ((width<31)&&(num>=(1<<width))) {
+      vpi_printf("ERROR: %s() %d does not fit %d-bit length argument.\n", func, num, width);
+      num = 0;
+      ret = -1;
+  }
+  value.format = vpiIntVal;
+  value.value.integer = num;
+  vpi_put_value(handle, &value, NULL, vpiNoDelay);
+  return ret;
+}
+
+//----------------------------------------------------------------------------
+// VLAN tags of frames built by Ethernet builders, which are set by $pkt_vlan;
+// no tag by default.
+static pkt_vlan_t m_vlan[PKT_VLAN_MAX];
+static int        m_vlan_num=0;
+
 //----------------------------------------------------------------------------
 PLI_INT32 pkt_eth_Calltf(PLI_BYTE8 *user_data) {
-  vpiHandle systf_handle, arg_iterator;
+  vpiHandle systf_handle;
+  vpi_tf_ctx_t *tf_ctx;
   vpiHandle H_pkt     ;
   vpiHandle H_bnum_pkt;
   vpiHandle H_mac_dst ;
@@ -462,11 +953,11 @@ PLI_INT32 pkt_eth_Calltf(PLI_BYTE8 *user_data) {
   vpiHandle H_preamble;
   s_vpi_value value;
   PLI_UINT32 val32, val8;
-  PLI_UINT16 bnum_pkt;
+  PLI_INT32  bnum_pkt;
   PLI_UBYTE8 mac_dst[6];
   PLI_UBYTE8 mac_src[6];
   PLI_UINT16 type_len;
-  PLI_UINT16 bnum_payload;
+  PLI_INT32  bnum_payload;
   PLI_UINT32 add_crc;
   PLI_UINT32 add_preamble;
   int idx, idy, idz;
@@ -477,16 +968,21 @@ PLI_INT32 pkt_eth_Calltf(PLI_BYTE8 *user_data) {
 
   //--------------------Get all handlers
   systf_handle = vpi_handle(vpiSysTfCall, NULL);
-  arg_iterator = vpi_iterate(vpiArgument, systf_handle);
-  H_pkt          = vpi_scan(arg_iterator);
-  H_bnum_pkt     = vpi_scan(arg_iterator);
-  H_mac_src      = vpi_scan(arg_iterator);
-  H_mac_dst      = vpi_scan(arg_iterator);
-  H_type_len     = vpi_scan(arg_iterator);
-  H_bnum_payload = vpi_scan(arg_iterator);
-  H_payload      = vpi_scan(arg_iterator);
-  H_crc          = vpi_scan(arg_iterator);
-  H_preamble     = vpi_scan(arg_iterator);
+  tf_ctx       = vpi_tf_ctx_get(systf_handle);
+  if (tf_ctx==NULL) {
+      vpi_printf("ERROR: calloc error.\n");
+      pkt_control(vpiFinish);
+      return(0);
+  }
+  H_pkt          = tf_ctx->arg[0];
+  H_bnum_pkt     = tf_ctx->arg[1];
+  H_mac_src      = tf_ctx->arg[2];
+  H_mac_dst      = tf_ctx->arg[3];
+  H_type_len     = tf_ctx->arg[4];
+  H_bnum_payload = tf_ctx->arg[5];
+  H_payload      = tf_ctx->arg[6];
+  H_crc          = tf_ctx->arg[7];
+  H_preamble     = tf_ctx->arg[8];
 
   //--------------------MAC DST
   GET_WIDE_ARG(H_mac_dst)
@@ -514,7 +1010,11 @@ PLI_INT32 pkt_eth_Calltf(PLI_BYTE8 *user_data) {
   GET_INT_ARG(H_type_len,PLI_UINT16,type_len)
 
   //--------------------num of bytes of payload
-  GET_INT_ARG(H_bnum_payload,PLI_UINT16,bnum_payload)
+  GET_INT_ARG(H_bnum_payload,PLI_INT32,bnum_payload)
+  if (pkt_fit_array(tf_ctx,6,bnum_payload,__FUNCTION__)) {
+      pkt_control(vpiFinish);
+      return(0);
+  }
 
   //--------------------crc
   GET_INT_ARG(H_crc,PLI_UINT32,add_crc)
@@ -529,38 +1029,40 @@ PLI_INT32 pkt_eth_Calltf(PLI_BYTE8 *user_data) {
 
   //--------------------build Ethernet packet
   tmp = (add_preamble) ? 8 : 0;
-  tmp += ETH_HDR_LEN;
+  tmp += ETH_HDR_LEN+m_vlan_num*ETH_VLAN_TAG_LEN;
   tmp += (bnum_payload<46) ? 46 : bnum_payload;
   tmp += (add_crc) ? 4 : 0; // num of bytes from preamble (if any) to crc (if any).
-  eth_pkt = (uint8_t*)calloc(tmp, 1);
+  eth_pkt = vpi_scratch(VPI_SCRATCH_PKT, tmp);
   if (eth_pkt==NULL) {
-      vpi_printf("ERROR: calloc error.\n");
-      vpi_free_object(arg_iterator);
+      vpi_printf("ERROR: scratch buffer error.\n");
       pkt_control(vpiFinish);
+      return(0);
   }
-  payload = (uint8_t*)calloc(bnum_payload, 1);
+  payload = vpi_scratch(VPI_SCRATCH_PAYLOAD, bnum_payload);
   if (payload==NULL) {
-      vpi_printf("ERROR: calloc error.\n");
-      vpi_free_object(arg_iterator);
+      vpi_printf("ERROR: scratch buffer error.\n");
       pkt_control(vpiFinish);
+      return(0);
   }
-  GET_ARRAY_ARG(H_payload,0,bnum_payload,payload)
-
-  tmp = gen_eth_packet( eth_pkt
-                      , mac_src
-                      , mac_dst
-                      , type_len
-                      , bnum_payload
-                      , payload
-                      , add_crc
-                      , add_preamble
-                      );
+  GET_ARRAY_ARG(vpi_tf_ctx_array(tf_ctx,6),0,bnum_payload,payload)
+
+  tmp = gen_eth_packet_vlan( eth_pkt
+                           , mac_src
+                           , mac_dst
+                           , m_vlan
+                           , m_vlan_num
+                           , type_len
+                           , bnum_payload
+                           , payload
+                           , add_crc
+                           , add_preamble
+                           );
 
 #if defined(RIGOR)
   int xxy = (add_preamble) ? 8 : 0;
-  xxy += ETH_HDR_LEN;
+  xxy += ETH_HDR_LEN+m_vlan_num*ETH_VLAN_TAG_LEN;
   if (add_crc) {
-      xxy += (bnum_payload<46) ? 46 : bnum_payload;
+      xxy += (bnum_payload<(46-m_vlan_num*ETH_VLAN_TAG_LEN)) ? (46-m_vlan_num*ETH_VLAN_TAG_LEN) : bnum_payload;
       xxy += (add_crc) ? 4 : 0;
   } else {
       xxy += bnum_payload;
@@ -571,20 +1073,14 @@ PLI_INT32 pkt_eth_Calltf(PLI_BYTE8 *user_data) {
 #endif
 
   //--------------------copy all generated contents
-  for (idy=0; idy<tmp; idy++) {
-       vpiHandle ele = vpi_handle_by_index(H_pkt, idy);
-       value.value.integer = eth_pkt[idy];
-       vpi_put_value(ele, &value, NULL, vpiNoDelay);
+  if (pkt_fit_array(tf_ctx,0,tmp,__FUNCTION__)) {
+      pkt_control(vpiFinish);
+      return(0);
   }
+  PUT_ARRAY_ARG(vpi_tf_ctx_array(tf_ctx,0),0,tmp,eth_pkt)
 
   //--------------------put num of bytes of Ethernet packet
-  value.format = vpiIntVal;
-  value.value.integer = tmp;
-  vpi_put_value(H_bnum_pkt, &value, NULL, vpiNoDelay);
-
-  free(eth_pkt);
-  free(payload);
-  vpi_free_object(arg_iterator);
+  if (pkt_put_bnum(H_bnum_pkt, tmp, __FUNCTION__)) pkt_control(vpiFinish);
 
   return(0);
 }
@@ -646,12 +1142,15 @@ PLI_INT32 pkt_ip_Compiletf(PLI_BYTE8 *user_data) {
       pkt_control(vpiFinish);
   }
 
+  if (vpi_tf_ctx_build(systf_handle)==NULL) pkt_control(vpiFinish);
+
   return(0);
 }
 #undef TASK_NAME
 //----------------------------------------------------------------------------
 PLI_INT32 pkt_ip_Calltf(PLI_BYTE8 *user_data) {
-  vpiHandle systf_handle, arg_iterator;
+  vpiHandle systf_handle;
+  vpi_tf_ctx_t *tf_ctx;
   vpiHandle H_pkt      ;
   vpiHandle H_bnum_pkt ;
   vpiHandle H_ip_dst   ;
@@ -663,12 +1162,12 @@ PLI_INT32 pkt_ip_Calltf(PLI_BYTE8 *user_data) {
   vpiHandle H_tcp_check;
   s_vpi_value value;
   PLI_UINT32 val32, val8;
-  PLI_UINT16 bnum_pkt;
+  PLI_INT32  bnum_pkt;
   PLI_UINT32 ip_dst  ;
   PLI_UINT32 ip_src  ;
   PLI_UBYTE8 protocol;
   PLI_UBYTE8 ttl     ;
-  PLI_UINT16 bnum_payload;
+  PLI_INT32  bnum_payload;
   PLI_UINT32 tcp_check;
   int idx, idy, idz;
   uint8_t *ip_pkt; // buffer to hold whole IP packet
@@ -677,39 +1176,48 @@ PLI_INT32 pkt_ip_Calltf(PLI_BYTE8 *user_data) {
 
   //--------------------Get all handlers
   systf_handle = vpi_handle(vpiSysTfCall, NULL);
-  arg_iterator = vpi_iterate(vpiArgument, systf_handle);
-  H_pkt          = vpi_scan(arg_iterator);
-  H_bnum_pkt     = vpi_scan(arg_iterator);
-  H_ip_src       = vpi_scan(arg_iterator);
-  H_ip_dst       = vpi_scan(arg_iterator);
-  H_protocol     = vpi_scan(arg_iterator);
-  H_ttl          = vpi_scan(arg_iterator);
-  H_bnum_payload = vpi_scan(arg_iterator);
-  H_payload      = vpi_scan(arg_iterator);
-  H_tcp_check    = vpi_scan(arg_iterator);
+  tf_ctx       = vpi_tf_ctx_get(systf_handle);
+  if (tf_ctx==NULL) {
+      vpi_printf("ERROR: calloc error.\n");
+      pkt_control(vpiFinish);
+      return(0);
+  }
+  H_pkt          = tf_ctx->arg[0];
+  H_bnum_pkt     = tf_ctx->arg[1];
+  H_ip_src       = tf_ctx->arg[2];
+  H_ip_dst       = tf_ctx->arg[3];
+  H_protocol     = tf_ctx->arg[4];
+  H_ttl          = tf_ctx->arg[5];
+  H_bnum_payload = tf_ctx->arg[6];
+  H_payload      = tf_ctx->arg[7];
+  H_tcp_check    = tf_ctx->arg[8];
 
   GET_INT_ARG(H_ip_src  ,PLI_UINT32,ip_src)
   GET_INT_ARG(H_ip_dst  ,PLI_UINT32,ip_dst)
   GET_INT_ARG(H_protocol,PLI_UBYTE8,protocol)
   GET_INT_ARG(H_ttl     ,PLI_UBYTE8,ttl)
-  GET_INT_ARG(H_bnum_payload,PLI_UINT16,bnum_payload)
+  GET_INT_ARG(H_bnum_payload,PLI_INT32,bnum_payload)
+  if (pkt_fit_array(tf_ctx,7,bnum_payload,__FUNCTION__)) {
+      pkt_control(vpiFinish);
+      return(0);
+  }
   GET_INT_ARG(H_tcp_check,PLI_UINT32,tcp_check)
 
   //--------------------build Ethernet packet
   tmp = IP_HDR_LEN + bnum_payload;
-  ip_pkt = (uint8_t*)calloc(tmp, 1);
+  ip_pkt = vpi_scratch(VPI_SCRATCH_PKT, tmp);
   if (ip_pkt==NULL) {
-      vpi_printf("ERROR: calloc error.\n");
-      vpi_free_object(arg_iterator);
+      vpi_printf("ERROR: scratch buffer error.\n");
       pkt_control(vpiFinish);
+      return(0);
   }
-  payload = (uint8_t*)calloc(bnum_payload, 1);
+  payload = vpi_scratch(VPI_SCRATCH_PAYLOAD, bnum_payload);
   if (payload==NULL) {
-      vpi_printf("ERROR: calloc error.\n");
-      vpi_free_object(arg_iterator);
+      vpi_printf("ERROR: scratch buffer error.\n");
       pkt_control(vpiFinish);
+      return(0);
   }
-  GET_ARRAY_ARG(H_payload,0,bnum_payload,payload)
+  GET_ARRAY_ARG(vpi_tf_ctx_array(tf_ctx,7),0,bnum_payload,payload)
 
   tmp = gen_ip_packet( ip_pkt
                      , ip_src
@@ -729,20 +1237,14 @@ PLI_INT32 pkt_ip_Calltf(PLI_BYTE8 *user_data) {
 #endif
 
   //--------------------copy all generated contents
-  for (idy=0; idy<tmp; idy++) {
-       vpiHandle ele = vpi_handle_by_index(H_pkt, idy);
-       value.value.integer = ip_pkt[idy];
-       vpi_put_value(ele, &value, NULL, vpiNoDelay);
+  if (pkt_fit_array(tf_ctx,0,tmp,__FUNCTION__)) {
+      pkt_control(vpiFinish);
+      return(0);
   }
+  PUT_ARRAY_ARG(vpi_tf_ctx_array(tf_ctx,0),0,tmp,ip_pkt)
 
   //--------------------put num of bytes of Ethernet packet
-  value.format = vpiIntVal;
-  value.value.integer = tmp;
-  vpi_put_value(H_bnum_pkt, &value, NULL, vpiNoDelay);
-
-  free(ip_pkt);
-  free(payload);
-  vpi_free_object(arg_iterator);
+  if (pkt_put_bnum(H_bnum_pkt, tmp, __FUNCTION__)) pkt_control(vpiFinish);
 
   return(0);
 }
@@ -798,12 +1300,15 @@ PLI_INT32 pkt_udp_Compiletf(PLI_BYTE8 *user_data) {
       pkt_control(vpiFinish);
   }
 
+  if (vpi_tf_ctx_build(systf_handle)==NULL) pkt_control(vpiFinish);
+
   return(0);
 }
 #undef TASK_NAME
 //----------------------------------------------------------------------------
 PLI_INT32 pkt_udp_Calltf(PLI_BYTE8 *user_data) {
-  vpiHandle systf_handle, arg_iterator;
+  vpiHandle systf_handle;
+  vpi_tf_ctx_t *tf_ctx;
   vpiHandle H_pkt     ;
   vpiHandle H_bnum_pkt;
   vpiHandle H_port_dst;
@@ -812,10 +1317,10 @@ PLI_INT32 pkt_udp_Calltf(PLI_BYTE8 *user_data) {
   vpiHandle H_payload ;
   s_vpi_value value;
   PLI_UINT32 val32, val8;
-  PLI_UINT16 bnum_pkt;
+  PLI_INT32  bnum_pkt;
   PLI_UINT16 port_dst  ;
   PLI_UINT16 port_src  ;
-  PLI_UINT16 bnum_payload;
+  PLI_INT32  bnum_payload;
   int idx, idy, idz;
   uint8_t *udp_pkt; // buffer to hold whole UDP packet
   uint8_t *payload; // buffer to hold payload data
@@ -823,33 +1328,42 @@ PLI_INT32 pkt_udp_Calltf(PLI_BYTE8 *user_data) {
 
   //--------------------Get all handlers
   systf_handle = vpi_handle(vpiSysTfCall, NULL);
-  arg_iterator = vpi_iterate(vpiArgument, systf_handle);
-  H_pkt          = vpi_scan(arg_iterator);
-  H_bnum_pkt     = vpi_scan(arg_iterator);
-  H_port_src     = vpi_scan(arg_iterator);
-  H_port_dst     = vpi_scan(arg_iterator);
-  H_bnum_payload = vpi_scan(arg_iterator);
-  H_payload      = vpi_scan(arg_iterator);
-
-  GET_INT_ARG(H_port_src,PLI_UINT16,port_src)
+  tf_ctx       = vpi_tf_ctx_get(systf_handle);
+  if (tf_ctx==NULL) {
+      vpi_printf("ERROR: calloc error.\n");
+      pkt_control(vpiFinish);
+      return(0);
+  }
+  H_pkt          = tf_ctx->arg[0];
+  H_bnum_pkt     = tf_ctx->arg[1];
+  H_port_src     = tf_ctx->arg[2];
+  H_port_dst     = tf_ctx->arg[3];
+  H_bnum_payload = tf_ctx->arg[4];
+  H_payload      = tf_ctx->arg[5];
+
+  GET_INT_ARG(H_port_src,PLI_UINT16,port_src)
   GET_INT_ARG(H_port_dst,PLI_UINT16,port_dst)
-  GET_INT_ARG(H_bnum_payload,PLI_UINT16,bnum_payload)
+  GET_INT_ARG(H_bnum_payload,PLI_INT32,bnum_payload)
+  if (pkt_fit_array(tf_ctx,5,bnum_payload,__FUNCTION__)) {
+      pkt_control(vpiFinish);
+      return(0);
+  }
 
   //--------------------build Ethernet packet
   tmp = UDP_HDR_LEN + bnum_payload;
-  udp_pkt = (uint8_t*)calloc(tmp, 1);
+  udp_pkt = vpi_scratch(VPI_SCRATCH_PKT, tmp);
   if (udp_pkt==NULL) {
-      vpi_printf("ERROR: calloc error.\n");
-      vpi_free_object(arg_iterator);
+      vpi_printf("ERROR: scratch buffer error.\n");
       pkt_control(vpiFinish);
+      return(0);
   }
-  payload = (uint8_t*)calloc(bnum_payload, 1);
+  payload = vpi_scratch(VPI_SCRATCH_PAYLOAD, bnum_payload);
   if (payload==NULL) {
-      vpi_printf("ERROR: calloc error.\n");
-      vpi_free_object(arg_iterator);
+      vpi_printf("ERROR: scratch buffer error.\n");
       pkt_control(vpiFinish);
+      return(0);
   }
-  GET_ARRAY_ARG(H_payload,0,bnum_payload,payload)
+  GET_ARRAY_ARG(vpi_tf_ctx_array(tf_ctx,5),0,bnum_payload,payload)
 
   tmp = gen_udp_packet( udp_pkt
                       , port_src
@@ -866,20 +1380,14 @@ PLI_INT32 pkt_udp_Calltf(PLI_BYTE8 *user_data) {
 #endif
 
   //--------------------copy all generated contents
-  for (idy=0; idy<tmp; idy++) {
-       vpiHandle ele = vpi_handle_by_index(H_pkt, idy);
-       value.value.integer = udp_pkt[idy];
-       vpi_put_value(ele, &value, NULL, vpiNoDelay);
+  if (pkt_fit_array(tf_ctx,0,tmp,__FUNCTION__)) {
+      pkt_control(vpiFinish);
+      return(0);
   }
+  PUT_ARRAY_ARG(vpi_tf_ctx_array(tf_ctx,0),0,tmp,udp_pkt)
 
   //--------------------put num of bytes of Ethernet packet
-  value.format = vpiIntVal;
-  value.value.integer = tmp;
-  vpi_put_value(H_bnum_pkt, &value, NULL, vpiNoDelay);
-
-  free(udp_pkt);
-  free(payload);
-  vpi_free_object(arg_iterator);
+  if (pkt_put_bnum(H_bnum_pkt, tmp, __FUNCTION__)) pkt_control(vpiFinish);
 
   return(0);
 }
@@ -939,12 +1447,15 @@ PLI_INT32 pkt_tcp_Compiletf(PLI_BYTE8 *user_data) {
       pkt_control(vpiFinish);
   }
 
+  if (vpi_tf_ctx_build(systf_handle)==NULL) pkt_control(vpiFinish);
+
   return(0);
 }
 #undef TASK_NAME
 //----------------------------------------------------------------------------
 PLI_INT32 pkt_tcp_Calltf(PLI_BYTE8 *user_data) {
-  vpiHandle systf_handle, arg_iterator;
+  vpiHandle systf_handle;
+  vpi_tf_ctx_t *tf_ctx;
   vpiHandle H_pkt     ;
   vpiHandle H_bnum_pkt;
   vpiHandle H_port_dst;
@@ -955,12 +1466,12 @@ PLI_INT32 pkt_tcp_Calltf(PLI_BYTE8 *user_data) {
   vpiHandle H_payload ;
   s_vpi_value value;
   PLI_UINT32 val32, val8;
-  PLI_UINT16 bnum_pkt;
+  PLI_INT32  bnum_pkt;
   PLI_UINT16 port_dst  ;
   PLI_UINT16 port_src  ;
   PLI_UINT32 num_seq;
   PLI_UINT32 num_ack;
-  PLI_UINT16 bnum_payload;
+  PLI_INT32  bnum_payload;
   int idx, idy, idz;
   uint8_t *tcp_pkt; // buffer to hold whole UDP packet
   uint8_t *payload; // buffer to hold payload data
@@ -968,37 +1479,46 @@ PLI_INT32 pkt_tcp_Calltf(PLI_BYTE8 *user_data) {
 
   //--------------------Get all handlers
   systf_handle = vpi_handle(vpiSysTfCall, NULL);
-  arg_iterator = vpi_iterate(vpiArgument, systf_handle);
-  H_pkt          = vpi_scan(arg_iterator);
-  H_bnum_pkt     = vpi_scan(arg_iterator);
-  H_port_src     = vpi_scan(arg_iterator);
-  H_port_dst     = vpi_scan(arg_iterator);
-  H_num_seq      = vpi_scan(arg_iterator);
-  H_num_ack      = vpi_scan(arg_iterator);
-  H_bnum_payload = vpi_scan(arg_iterator);
-  H_payload      = vpi_scan(arg_iterator);
+  tf_ctx       = vpi_tf_ctx_get(systf_handle);
+  if (tf_ctx==NULL) {
+      vpi_printf("ERROR: calloc error.\n");
+      pkt_control(vpiFinish);
+      return(0);
+  }
+  H_pkt          = tf_ctx->arg[0];
+  H_bnum_pkt     = tf_ctx->arg[1];
+  H_port_src     = tf_ctx->arg[2];
+  H_port_dst     = tf_ctx->arg[3];
+  H_num_seq      = tf_ctx->arg[4];
+  H_num_ack      = tf_ctx->arg[5];
+  H_bnum_payload = tf_ctx->arg[6];
+  H_payload      = tf_ctx->arg[7];
 
   GET_INT_ARG(H_port_src,PLI_UINT16,port_src)
   GET_INT_ARG(H_port_dst,PLI_UINT16,port_dst)
   GET_INT_ARG(H_num_seq,PLI_UINT32,num_seq)
   GET_INT_ARG(H_num_ack,PLI_UINT32,num_ack)
-  GET_INT_ARG(H_bnum_payload,PLI_UINT16,bnum_payload)
+  GET_INT_ARG(H_bnum_payload,PLI_INT32,bnum_payload)
+  if (pkt_fit_array(tf_ctx,7,bnum_payload,__FUNCTION__)) {
+      pkt_control(vpiFinish);
+      return(0);
+  }
 
   //--------------------build Ethernet packet
   tmp = TCP_HDR_LEN + bnum_payload;
-  tcp_pkt = (uint8_t*)calloc(tmp, 1);
+  tcp_pkt = vpi_scratch(VPI_SCRATCH_PKT, tmp);
   if (tcp_pkt==NULL) {
-      vpi_printf("ERROR: calloc error.\n");
-      vpi_free_object(arg_iterator);
+      vpi_printf("ERROR: scratch buffer error.\n");
       pkt_control(vpiFinish);
+      return(0);
   }
-  payload = (uint8_t*)calloc(bnum_payload, 1);
+  payload = vpi_scratch(VPI_SCRATCH_PAYLOAD, bnum_payload);
   if (payload==NULL) {
-      vpi_printf("ERROR: calloc error.\n");
-      vpi_free_object(arg_iterator);
+      vpi_printf("ERROR: scratch buffer error.\n");
       pkt_control(vpiFinish);
+      return(0);
   }
-  GET_ARRAY_ARG(H_payload,0,bnum_payload,payload)
+  GET_ARRAY_ARG(vpi_tf_ctx_array(tf_ctx,7),0,bnum_payload,payload)
 
   tmp = gen_tcp_packet( tcp_pkt
                       , port_src
@@ -1017,20 +1537,14 @@ PLI_INT32 pkt_tcp_Calltf(PLI_BYTE8 *user_data) {
 #endif
 
   //--------------------copy all generated contents
-  for (idy=0; idy<tmp; idy++) {
-       vpiHandle ele = vpi_handle_by_index(H_pkt, idy);
-       value.value.integer = tcp_pkt[idy];
-       vpi_put_value(ele, &value, NULL, vpiNoDelay);
+  if (pkt_fit_array(tf_ctx,0,tmp,__FUNCTION__)) {
+      pkt_control(vpiFinish);
+      return(0);
   }
+  PUT_ARRAY_ARG(vpi_tf_ctx_array(tf_ctx,0),0,tmp,tcp_pkt)
 
   //--------------------put num of bytes of Ethernet packet
-  value.format = vpiIntVal;
-  value.value.integer = tmp;
-  vpi_put_value(H_bnum_pkt, &value, NULL, vpiNoDelay);
-
-  free(tcp_pkt);
-  free(payload);
-  vpi_free_object(arg_iterator);
+  if (pkt_put_bnum(H_bnum_pkt, tmp, __FUNCTION__)) pkt_control(vpiFinish);
 
   return(0);
 }
@@ -1100,12 +1614,15 @@ PLI_INT32 pkt_udp_ip_eth_Compiletf(PLI_BYTE8 *user_data) {
       pkt_control(vpiFinish);
   }
 
+  if (vpi_tf_ctx_build(systf_handle)==NULL) pkt_control(vpiFinish);
+
   return(0);
 }
 #undef TASK_NAME
 //----------------------------------------------------------------------------
 PLI_INT32 pkt_udp_ip_eth_Calltf(PLI_BYTE8 *user_data) {
-  vpiHandle systf_handle, arg_iterator;
+  vpiHandle systf_handle;
+  vpi_tf_ctx_t *tf_ctx;
   vpiHandle H_pkt     ;
   vpiHandle H_bnum_pkt;
   vpiHandle H_port_dst;
@@ -1123,7 +1640,7 @@ PLI_INT32 pkt_udp_ip_eth_Calltf(PLI_BYTE8 *user_data) {
   vpiHandle H_preamble;
   s_vpi_value value;
   PLI_UINT32 val32, val8;
-  PLI_UINT16 bnum_pkt;
+  PLI_INT32  bnum_pkt;
   PLI_UINT16 port_dst  ;
   PLI_UINT16 port_src  ;
   PLI_UINT32 ip_dst  ;
@@ -1133,7 +1650,7 @@ PLI_INT32 pkt_udp_ip_eth_Calltf(PLI_BYTE8 *user_data) {
   PLI_UBYTE8 mac_dst[6];
   PLI_UBYTE8 mac_src[6];
   PLI_UINT16 type_len=ETH_TYPE_IP;
-  PLI_UINT16 bnum_payload;
+  PLI_INT32  bnum_payload;
   PLI_UINT32 add_crc;
   PLI_UINT32 add_preamble;
   int idx, idy, idz;
@@ -1143,24 +1660,29 @@ PLI_INT32 pkt_udp_ip_eth_Calltf(PLI_BYTE8 *user_data) {
 
   //--------------------Get all handlers
   systf_handle = vpi_handle(vpiSysTfCall, NULL);
-  arg_iterator = vpi_iterate(vpiArgument, systf_handle);
-  H_pkt          = vpi_scan(arg_iterator);
-  H_bnum_pkt     = vpi_scan(arg_iterator);
-  H_port_src     = vpi_scan(arg_iterator);
-  H_port_dst     = vpi_scan(arg_iterator);
-  H_ip_src       = vpi_scan(arg_iterator);
-  H_ip_dst       = vpi_scan(arg_iterator);
-  H_ttl          = vpi_scan(arg_iterator);
-  H_mac_src      = vpi_scan(arg_iterator);
-  H_mac_dst      = vpi_scan(arg_iterator);
-  H_bnum_payload = vpi_scan(arg_iterator);
-  H_payload      = vpi_scan(arg_iterator);
-  H_crc          = vpi_scan(arg_iterator);
-  H_preamble     = vpi_scan(arg_iterator);
+  tf_ctx       = vpi_tf_ctx_get(systf_handle);
+  if (tf_ctx==NULL) {
+      vpi_printf("ERROR: calloc error.\n");
+      pkt_control(vpiFinish);
+      return(0);
+  }
+  H_pkt          = tf_ctx->arg[0];
+  H_bnum_pkt     = tf_ctx->arg[1];
+  H_port_src     = tf_ctx->arg[2];
+  H_port_dst     = tf_ctx->arg[3];
+  H_ip_src       = tf_ctx->arg[4];
+  H_ip_dst       = tf_ctx->arg[5];
+  H_ttl          = tf_ctx->arg[6];
+  H_mac_src      = tf_ctx->arg[7];
+  H_mac_dst      = tf_ctx->arg[8];
+  H_bnum_payload = tf_ctx->arg[9];
+  H_payload      = tf_ctx->arg[10];
+  H_crc          = tf_ctx->arg[11];
+  H_preamble     = tf_ctx->arg[12];
 
   GET_INT_ARG(H_port_src,PLI_UINT16,port_src)
   GET_INT_ARG(H_port_dst,PLI_UINT16,port_dst)
-  GET_INT_ARG(H_bnum_payload,PLI_UINT16,bnum_payload)
+  GET_INT_ARG(H_bnum_payload,PLI_INT32,bnum_payload)
   GET_INT_ARG(H_ip_src  ,PLI_UINT32,ip_src)
   GET_INT_ARG(H_ip_dst  ,PLI_UINT32,ip_dst)
   GET_INT_ARG(H_ttl     ,PLI_UBYTE8,ttl)
@@ -1185,508 +1707,933 @@ PLI_INT32 pkt_udp_ip_eth_Calltf(PLI_BYTE8 *user_data) {
   mac_src[1] =  val32     &0xFF;
   mac_src[0] = (val32>> 8)&0xFF; // msb
   //--------------------num of bytes of payload
-  GET_INT_ARG(H_bnum_payload,PLI_UINT16,bnum_payload)
+  GET_INT_ARG(H_bnum_payload,PLI_INT32,bnum_payload)
+  if (pkt_fit_array(tf_ctx,10,bnum_payload,__FUNCTION__)) {
+      pkt_control(vpiFinish);
+      return(0);
+  }
   //--------------------crc
   GET_INT_ARG(H_crc,PLI_UINT32,add_crc)
   //--------------------preamble
   GET_INT_ARG(H_preamble,PLI_UINT32,add_preamble)
 
   //--------------------build Ethernet packet
-  tmp = ETH_HDR_LEN + IP_HDR_LEN + UDP_HDR_LEN + bnum_payload;
-  eth_pkt = (uint8_t*)calloc(tmp, 1);
+  tmp = (add_preamble) ? 8 : 0;
+  tmp += ETH_HDR_LEN+m_vlan_num*ETH_VLAN_TAG_LEN;
+  tmp += ((IP_HDR_LEN+UDP_HDR_LEN+bnum_payload)<46) ? 46 : (IP_HDR_LEN+UDP_HDR_LEN+bnum_payload);
+  tmp += (add_crc) ? 4 : 0; // num of bytes from preamble (if any) to crc (if any).
+  eth_pkt = vpi_scratch(VPI_SCRATCH_PKT, tmp);
   if (eth_pkt==NULL) {
-      vpi_printf("ERROR: calloc error.\n");
-      vpi_free_object(arg_iterator);
+      vpi_printf("ERROR: scratch buffer error.\n");
       pkt_control(vpiFinish);
+      return(0);
   }
-  payload = (uint8_t*)calloc(bnum_payload, 1);
+  payload = vpi_scratch(VPI_SCRATCH_PAYLOAD, bnum_payload);
   if (payload==NULL) {
-      vpi_printf("ERROR: calloc error.\n");
-      vpi_free_object(arg_iterator);
+      vpi_printf("ERROR: scratch buffer error.\n");
       pkt_control(vpiFinish);
+      return(0);
   }
-  GET_ARRAY_ARG(H_payload,0,bnum_payload,payload)
-
-  tmp = gen_eth_ip_udp_packet( eth_pkt //uint8_t  *packet
-                             , mac_src
-                             , mac_dst
-                             , ip_src
-                             , ip_dst
-                             , port_src
-                             , port_dst
-                             , bnum_payload // Pure UDP payload
-                             , payload
-                             , 1 // update UDP checksum
-                             , add_crc
-                             , add_preamble);
+  GET_ARRAY_ARG(vpi_tf_ctx_array(tf_ctx,10),0,bnum_payload,payload)
+
+  tmp = gen_eth_ip_udp_packet_vlan( eth_pkt //uint8_t  *packet
+                                  , mac_src
+                                  , mac_dst
+                                  , m_vlan
+                                  , m_vlan_num
+                                  , ip_src
+                                  , ip_dst
+                                  , port_src
+                                  , port_dst
+                                  , bnum_payload // Pure UDP payload
+                                  , payload
+                                  , 1 // update UDP checksum
+                                  , add_crc
+                                  , add_preamble);
 
 #if defined(RIGOR)
-  int xxy = ETH_HDR_LEN + IP_HDR_LEN + UDP_HDR_LEN + bnum_payload;
+  int xxy = (add_preamble) ? 8 : 0;
+  xxy += ETH_HDR_LEN+m_vlan_num*ETH_VLAN_TAG_LEN;
+  if (add_crc) {
+      xxy += ((IP_HDR_LEN+UDP_HDR_LEN+bnum_payload)<(46-m_vlan_num*ETH_VLAN_TAG_LEN))
+           ? (46-m_vlan_num*ETH_VLAN_TAG_LEN) : (IP_HDR_LEN+UDP_HDR_LEN+bnum_payload);
+      xxy += 4;
+  } else {
+      xxy += IP_HDR_LEN + UDP_HDR_LEN + bnum_payload;
+  }
   if (tmp!=xxy) {
        vpi_printf("ERROR: %s()@%s whole packet length error %d %d\n", __FUNCTION__, __FILE__, tmp, xxy);
   }
 #endif
 
   //--------------------copy all generated contents
-  for (idy=0; idy<tmp; idy++) {
-       vpiHandle ele = vpi_handle_by_index(H_pkt, idy);
-       value.value.integer = eth_pkt[idy];
-       vpi_put_value(ele, &value, NULL, vpiNoDelay);
+  if (pkt_fit_array(tf_ctx,0,tmp,__FUNCTION__)) {
+      pkt_control(vpiFinish);
+      return(0);
   }
+  PUT_ARRAY_ARG(vpi_tf_ctx_array(tf_ctx,0),0,tmp,eth_pkt)
 
   //--------------------put num of bytes of Ethernet packet
-  value.format = vpiIntVal;
-  value.value.integer = tmp;
-  vpi_put_value(H_bnum_pkt, &value, NULL, vpiNoDelay);
-
-  free(eth_pkt);
-  free(payload);
-  vpi_free_object(arg_iterator);
+  if (pkt_put_bnum(H_bnum_pkt, tmp, __FUNCTION__)) pkt_control(vpiFinish);
 
   return(0);
 }
 
 //----------------------------------------------------------------------------
-// Initialize PTPv2 context
-// $msg_ptpv2_set_context( ptp_version 
-//                       , ptp_domain
-//                       , one_step_clock
-//                       , unicast_port
-//                       , profile_spec1
-//                       , profile_spec2
-//                       );
-#define TASK_NAME "$msg_ptpv2_set_context"
-PLI_INT32 msg_ptpv2_set_context_Compiletf(PLI_BYTE8 *user_data) {
-  vpiHandle systf_handle, arg_iterator, arg_handle;
-  PLI_INT32 arg_type;
+// Burst of frames
+//
+// Frames are built into rows of 2-D memory, e.g., 'reg [7:0] pkt[0:N-1][0:4095]',
+// and num of bytes of each frame goes to 'bnum_pkt[0:N-1]'.
+// Each field given by 'inc_*' is incremented by it for each next frame,
+// so that frame 'n' has 'port_src+n*inc_port_src' and so on.
+//----------------------------------------------------------------------------
+#define CHECK_FRAMES_ARG(A,B,C,D,E)\
+        arg_handle = vpi_scan(arg_iterator);\
+        if (arg_handle==NULL) {\
+            vpi_printf("ERROR: %s must have %s argument.\n", TASK_NAME, (B));\
+            vpi_free_object(arg_iterator);\
+            pkt_control(vpiFinish);\
+        } else  {\
+          ele_handle = (vpi_get(vpiArray, arg_handle))\
+                     ? vpi_handle_by_index(arg_handle, vpi_get(vpiLeftRange, arg_handle))\
+                     : NULL;\
+          if ((ele_handle!=NULL)&&vpi_get(vpiArray, ele_handle)) {\
+              (C) = vpi_get(vpiLeftRange, arg_handle) - vpi_get(vpiRightRange, arg_handle);\
+              if ((C)<0) (C) = -(C);\
+              (C) += 1;\
+              (D) = vpi_get(vpiSize, ele_handle);\
+              ele_handle = vpi_handle_by_index(ele_handle, vpi_get(vpiLeftRange, ele_handle));\
+              (E) = (ele_handle!=NULL) ? vpi_get(vpiSize, ele_handle) : 0;\
+          } else {\
+              vpi_printf("ERROR: %s %s argument must be 2-D array\n", TASK_NAME, (A));\
+              vpi_free_object(arg_iterator);\
+              pkt_control(vpiFinish);\
+          }\
+        }
+
+//----------------------------------------------------------------------------
+// It reads 48-bit MAC address; mac[0] is the msb.
+static void pkt_get_mac(vpiHandle H_mac, PLI_UBYTE8 mac[6])
+{
+  s_vpi_value value;
+  PLI_UINT32 val32;
+  GET_WIDE_ARG(H_mac)
+  val32 = value.value.vector[0].aval;
+  mac[5] =  val32     &0xFF;
+  mac[4] = (val32>> 8)&0xFF;
+  mac[3] = (val32>>16)&0xFF;
+  mac[2] = (val32>>24)&0xFF;
+  val32 = value.value.vector[1].aval;
+  mac[1] =  val32     &0xFF;
+  mac[0] = (val32>> 8)&0xFF; // msb
+}
+
+//----------------------------------------------------------------------------
+// Returns num of payload bytes of frame 'idx', which is limited by 'max'.
+static int pkt_burst_leng(int bnum_payload, int inc, int idx, int max)
+{
+  int leng = bnum_payload + idx*inc;
+  if (leng<0) leng = 0;
+  if (leng>max) leng = max;
+  return leng;
+}
+
+//----------------------------------------------------------------------------
+// It reads payload that covers all frames of the burst.
+// Returns NULL on error.
+static uint8_t *pkt_burst_payload( vpi_array_t *array
+                                 , int          bnum_payload
+                                 , int          inc
+                                 , int          num_frame
+                                 , int         *max)
+{
+  uint8_t *payload;
+  int first = pkt_burst_leng(bnum_payload, inc, 0, array->num);
+  int last  = pkt_burst_leng(bnum_payload, inc, num_frame-1, array->num);
+  *max = array->num;
+  payload = vpi_scratch(VPI_SCRATCH_PAYLOAD, (first>last) ? first : last);
+  if (payload!=NULL) GET_ARRAY_ARG(array,0,(first>last) ? first : last,payload)
+  return payload;
+}
+
+//----------------------------------------------------------------------------
+// It puts frame 'idx' to row 'idx' of 'frames'.
+// 'leng' is -1 when the frame is beyond the size model,
+// and it should fit elements of 'lengs'.
+// Returns 0 on success.
+static int pkt_burst_put( vpi_array_t *frames
+                        , vpi_array_t *lengs
+                        , int          idx
+                        , uint8_t     *pkt
+                        , int          leng)
+{
+  vpi_array_t *row = vpi_array_row(frames, idx);
+  if (row==NULL) return -1;
+  if (leng<0) {
+      vpi_printf("ERROR: frame %d beyond the size model\n", idx);
+      return -1;
+  }
+  if ((lengs->width<31)&&(leng>=(1<<lengs->width))) {
+      vpi_printf("ERROR: frame %d of %d bytes does not fit %d-bit length\n", idx, leng, lengs->width);
+      return -1;
+  }
+  if (leng>row->num) {
+      vpi_printf("ERROR: frame %d of %d bytes does not fit %d-byte row\n", idx, leng, row->num);
+      return -1;
+  }
+  PUT_ARRAY_ARG(row,0,leng,pkt)
+  return 0;
+}
+
+//----------------------------------------------------------------------------
+// It limits num of frames to the rows of 'frames' and 'bnum_pkt[]'.
+static int pkt_burst_num( vpi_array_t *frames
+                        , vpi_array_t *lengs
+                        , int          num_frame)
+{
+  int rows = (frames->left<=frames->right) ? frames->right-frames->left+1
+                                           : frames->left-frames->right+1;
+  if ((num_frame>rows)||(num_frame>lengs->num)) {
+      vpi_printf("ERROR: %d frames requested, but only %d rows\n"
+                , num_frame, (rows<lengs->num) ? rows : lengs->num);
+      num_frame = (rows<lengs->num) ? rows : lengs->num;
+  }
+  return (num_frame<0) ? 0 : num_frame;
+}
+
+//----------------------------------------------------------------------------
+// $pkt_ethernet_burst( pkt     [7:0][0:N-1][0:4095] // N frames
+//                    , bnum_pkt[15:0][0:N-1] // num of bytes of each frame
+//                    , num_frame // num of frames to build
+//                    , mac_src [47:0]
+//                    , mac_dst [47:0]
+//                    , type_len[15:0] // use num of bytes of payload when 0
+//                    , bnum_payload[15:0] // num of bytes of payload of the first frame
+//                    , payload [7:0][0:4095]
+//                    , add_crc      //
+//                    , add_preamble //
+//                    , inc_bnum_payload
+//                    );
+//----------------------------------------------------------------------------
+#define TASK_NAME "$pkt_ethernet_burst"
+PLI_INT32 pkt_eth_burst_Compiletf(PLI_BYTE8 *user_data) {
+  vpiHandle systf_handle, arg_iterator, arg_handle, ele_handle;
+  PLI_INT32 tfarg_type, arg_type;
+  int width;
+  int numA, lengA, widthA;
+  int numB, widthB;
+  int numC, widthC;
 
   systf_handle = vpi_handle(vpiSysTfCall, NULL);
   arg_iterator = vpi_iterate(vpiArgument, systf_handle);
   if (arg_iterator==NULL) {
-      vpi_printf("ERROR: %s must have six arguments.\n", TASK_NAME);
+      vpi_printf("ERROR: %s must have 11 arguments.\n", TASK_NAME);
       pkt_control(vpiFinish);
   }
 
-  CHECK_INT_ARG  ("1st", "six")
-  CHECK_INT_ARG  ("2nd", "six")
-  CHECK_INT_ARG  ("3rd", "six")
-  CHECK_INT_ARG  ("4th", "six")
-  CHECK_INT_ARG  ("5th", "six")
-  CHECK_INT_ARG  ("6th", "six")
+  CHECK_FRAMES_ARG("1st", "11", numA, lengA, widthA) // frames
+  CHECK_ARRAY_ARG ("2nd", "11", numB, widthB) // bnum pkt
+  CHECK_INT_ARG   ("3rd", "11") // num frame
+  CHECK_WIDE_ARG  ("4th", "11", 48) // SRC MAC
+  CHECK_WIDE_ARG  ("5th", "11", 48) // DST MAC
+  CHECK_WIDE_ARG  ("6th", "11", 16) // TYPE_LENG
+  CHECK_WIDE_ARG  ("7th", "11", 16) // bnum payload
+  CHECK_ARRAY_ARG ("8th", "11", numC, widthC) // payload
+  CHECK_INT_ARG   ("9th", "11") // add crc
+  CHECK_INT_ARG   ("10th","11") // add preamble
+  CHECK_INT_ARG   ("11th","11") // inc bnum payload
 
   arg_handle = vpi_scan(arg_iterator);
   if (arg_handle!=NULL) {
-      vpi_printf("ERROR: %s must have six arguments.\n", TASK_NAME);
+      vpi_printf("ERROR: %s must have 11 arguments.\n", TASK_NAME);
       vpi_free_object(arg_iterator);
       pkt_control(vpiFinish);
   }
 
+  if (widthA!=8) {
+      vpi_printf("ERROR: %s first argument must be 8-bit 2-D array.\n", TASK_NAME);
+      pkt_control(vpiFinish);
+  }
+  if (widthB<16) {
+      vpi_printf("ERROR: %s second argument must be 16-bit array.\n", TASK_NAME);
+      pkt_control(vpiFinish);
+  }
+  if (widthC!=8) {
+      vpi_printf("ERROR: %s eighth argument must be 8-bit array.\n", TASK_NAME);
+      pkt_control(vpiFinish);
+  }
+
+  if (vpi_tf_ctx_build(systf_handle)==NULL) pkt_control(vpiFinish);
+
   return(0);
 }
 #undef TASK_NAME
 //----------------------------------------------------------------------------
-PLI_INT32 msg_ptpv2_set_context_Calltf(PLI_BYTE8 *user_data) {
-  vpiHandle systf_handle, arg_iterator;
-  vpiHandle H_ptp_version   ;
-  vpiHandle H_ptp_domain    ;
-  vpiHandle H_one_step_clock;
-  vpiHandle H_unicast_port  ;
-  vpiHandle H_profile_spec1 ;
-  vpiHandle H_profile_spec2 ;
+PLI_INT32 pkt_eth_burst_Calltf(PLI_BYTE8 *user_data) {
+  vpiHandle systf_handle;
+  vpi_tf_ctx_t *tf_ctx;
+  vpi_array_t *frames, *lengs;
   s_vpi_value value;
-  PLI_UINT32 ptp_version   ;
-  PLI_UINT32 ptp_domain    ;
-  PLI_UINT32 one_step_clock;
-  PLI_UINT32 unicast_port  ;
-  PLI_UINT32 profile_spec1 ;
-  PLI_UINT32 profile_spec2 ;
+  PLI_INT32  num_frame;
+  PLI_UBYTE8 mac_src[6];
+  PLI_UBYTE8 mac_dst[6];
+  PLI_UINT16 type_len;
+  PLI_INT32  bnum_payload;
+  PLI_UINT32 add_crc;
+  PLI_UINT32 add_preamble;
+  PLI_INT32  inc_bnum_payload;
+  PLI_INT32 *bnum_pkt;
+  uint8_t *eth_pkt; // buffer to hold a frame
+  uint8_t *payload; // buffer to hold payload data of all frames
+  int idx, leng, max, tmp;
 
   //--------------------Get all handlers
   systf_handle = vpi_handle(vpiSysTfCall, NULL);
-  arg_iterator = vpi_iterate(vpiArgument, systf_handle);
-  H_ptp_version    = vpi_scan(arg_iterator);
-  H_ptp_domain     = vpi_scan(arg_iterator);
-  H_one_step_clock = vpi_scan(arg_iterator);
-  H_unicast_port   = vpi_scan(arg_iterator);
-  H_profile_spec1  = vpi_scan(arg_iterator);
-  H_profile_spec2  = vpi_scan(arg_iterator);
-
-  GET_INT_ARG (H_ptp_version   , PLI_UINT32, ptp_version   );
-  GET_INT_ARG (H_ptp_domain    , PLI_UINT32, ptp_domain    );
-  GET_INT_ARG (H_one_step_clock, PLI_UINT32, one_step_clock);
-  GET_INT_ARG (H_unicast_port  , PLI_UINT32, unicast_port  );
-  GET_INT_ARG (H_profile_spec1 , PLI_UINT32, profile_spec1 );
-  GET_INT_ARG (H_profile_spec2 , PLI_UINT32, profile_spec2 );
+  tf_ctx       = vpi_tf_ctx_get(systf_handle);
+  if (tf_ctx==NULL) {
+      vpi_printf("ERROR: calloc error.\n");
+      pkt_control(vpiFinish);
+      return(0);
+  }
+  frames = vpi_tf_ctx_array(tf_ctx,0);
+  lengs  = vpi_tf_ctx_array(tf_ctx,1);
+
+  GET_INT_ARG(tf_ctx->arg[2] ,PLI_INT32 ,num_frame)
+  pkt_get_mac(tf_ctx->arg[3], mac_src);
+  pkt_get_mac(tf_ctx->arg[4], mac_dst);
+  GET_INT_ARG(tf_ctx->arg[5] ,PLI_UINT16,type_len)
+  GET_INT_ARG(tf_ctx->arg[6] ,PLI_INT32,bnum_payload)
+  GET_INT_ARG(tf_ctx->arg[8] ,PLI_UINT32,add_crc)
+  GET_INT_ARG(tf_ctx->arg[9] ,PLI_UINT32,add_preamble)
+  GET_INT_ARG(tf_ctx->arg[10],PLI_INT32 ,inc_bnum_payload)
+
+  num_frame = pkt_burst_num(frames, lengs, num_frame);
+  if (num_frame==0) return(0);
+  payload  = pkt_burst_payload(vpi_tf_ctx_array(tf_ctx,7), bnum_payload
+                              , inc_bnum_payload, num_frame, &max);
+  bnum_pkt = (PLI_INT32*)vpi_scratch(VPI_SCRATCH_AUX, num_frame*sizeof(PLI_INT32));
+  eth_pkt  = vpi_scratch(VPI_SCRATCH_PKT, 8+ETH_HDR_LEN+m_vlan_num*ETH_VLAN_TAG_LEN+((max<46) ? 46 : max)+4);
+  if ((payload==NULL)||(bnum_pkt==NULL)||(eth_pkt==NULL)) {
+      vpi_printf("ERROR: scratch buffer error.\n");
+      pkt_control(vpiFinish);
+      return(0);
+  }
 
-  gen_ptpv2_context( ptp_version   
-                   , ptp_domain    
-                   , one_step_clock
-                   , unicast_port  
-                   , profile_spec1 
-                   , profile_spec2 
-                   );
-  vpi_free_object(arg_iterator);
+  //--------------------build all frames
+  for (idx=0; idx<num_frame; idx++) {
+       leng = pkt_burst_leng(bnum_payload, inc_bnum_payload, idx, max);
+       tmp = gen_eth_packet_vlan( eth_pkt
+                                , mac_src
+                                , mac_dst
+                                , m_vlan
+                                , m_vlan_num
+                                , (type_len==0) ? leng : type_len
+                                , leng
+                                , payload
+                                , add_crc
+                                , add_preamble
+                                );
+       if (pkt_burst_put(frames, lengs, idx, eth_pkt, tmp)) {
+           pkt_control(vpiFinish);
+           return(0);
+       }
+       bnum_pkt[idx] = tmp;
+  }
+  vpi_array_put_int(lengs, 0, num_frame, bnum_pkt);
 
   return(0);
 }
 
 //----------------------------------------------------------------------------
-// Get PTPv2 context
-// $msg_ptpv2_get_context( ptp_version 
-//                       , ptp_domain
-//                       , one_step_clock
-//                       , unicast_port
-//                       , profile_spec1
-//                       , profile_spec2
-//                       );
-#define TASK_NAME "$msg_ptpv2_get_context"
-PLI_INT32 msg_ptpv2_get_context_Compiletf(PLI_BYTE8 *user_data) {
-  vpiHandle systf_handle, arg_iterator, arg_handle;
-  PLI_INT32 arg_type;
+// $pkt_udp_ip_ethernet_burst( pkt     [7:0][0:N-1][0:4095] // N frames
+//                           , bnum_pkt[15:0][0:N-1] // num of bytes of each frame
+//                           , num_frame // num of frames to build
+//                           , port_src[15:0]
+//                           , port_dst[15:0]
+//                           , ip_src  [31:0]
+//                           , ip_dst  [31:0]
+//                           , ttl     [ 7:0]
+//                           , mac_src [47:0]
+//                           , mac_dst [47:0]
+//                           , bnum_payload[15:0] // num of bytes of payload of the first frame
+//                           , payload [7:0][0:4095]
+//                           , add_crc      //
+//                           , add_preamble //
+//                           , inc_port_src
+//                           , inc_port_dst
+//                           , inc_ip_src
+//                           , inc_ip_dst
+//                           , inc_bnum_payload
+//                           );
+//----------------------------------------------------------------------------
+#define TASK_NAME "$pkt_udp_ip_ethernet_burst"
+PLI_INT32 pkt_udp_ip_eth_burst_Compiletf(PLI_BYTE8 *user_data) {
+  vpiHandle systf_handle, arg_iterator, arg_handle, ele_handle;
+  PLI_INT32 tfarg_type, arg_type;
+  int width;
+  int numA, lengA, widthA;
+  int numB, widthB;
+  int numC, widthC;
 
   systf_handle = vpi_handle(vpiSysTfCall, NULL);
   arg_iterator = vpi_iterate(vpiArgument, systf_handle);
   if (arg_iterator==NULL) {
-      vpi_printf("ERROR: %s must have six arguments.\n", TASK_NAME);
+      vpi_printf("ERROR: %s must have 19 arguments.\n", TASK_NAME);
       pkt_control(vpiFinish);
   }
 
-  CHECK_INT_ARG  ("first" , "six")
-  CHECK_INT_ARG  ("second", "six")
-  CHECK_INT_ARG  ("third" , "six")
-  CHECK_INT_ARG  ("fourth", "six")
-  CHECK_INT_ARG  ("fifth" , "six")
-  CHECK_INT_ARG  ("sixth" , "six")
+  CHECK_FRAMES_ARG("1st", "19", numA, lengA, widthA) // frames
+  CHECK_ARRAY_ARG ("2nd", "19", numB, widthB) // bnum pkt
+  CHECK_INT_ARG   ("3rd", "19") // num frame
+  CHECK_INT_ARG   ("4th", "19") // SRC port
+  CHECK_INT_ARG   ("5th", "19") // DST port
+  CHECK_INT_ARG   ("6th", "19") // SRC IP
+  CHECK_INT_ARG   ("7th", "19") // DST IP
+  CHECK_INT_ARG   ("8th", "19") // TTL
+  CHECK_WIDE_ARG  ("9th", "19", 48) // SRC MAC
+  CHECK_WIDE_ARG  ("10th","19", 48) // DST MAC
+  CHECK_WIDE_ARG  ("11th","19", 16) // bnum payload
+  CHECK_ARRAY_ARG ("12th","19", numC, widthC) // payload
+  CHECK_INT_ARG   ("13th","19") // add crc
+  CHECK_INT_ARG   ("14th","19") // add preamble
+  CHECK_INT_ARG   ("15th","19") // inc SRC port
+  CHECK_INT_ARG   ("16th","19") // inc DST port
+  CHECK_INT_ARG   ("17th","19") // inc SRC IP
+  CHECK_INT_ARG   ("18th","19") // inc DST IP
+  CHECK_INT_ARG   ("19th","19") // inc bnum payload
 
   arg_handle = vpi_scan(arg_iterator);
   if (arg_handle!=NULL) {
-      vpi_printf("ERROR: %s must have six arguments.\n", TASK_NAME);
+      vpi_printf("ERROR: %s must have 19 arguments.\n", TASK_NAME);
       vpi_free_object(arg_iterator);
       pkt_control(vpiFinish);
   }
 
+  if (widthA!=8) {
+      vpi_printf("ERROR: %s first argument must be 8-bit 2-D array.\n", TASK_NAME);
+      pkt_control(vpiFinish);
+  }
+  if (widthB<16) {
+      vpi_printf("ERROR: %s second argument must be 16-bit array.\n", TASK_NAME);
+      pkt_control(vpiFinish);
+  }
+  if (widthC!=8) {
+      vpi_printf("ERROR: %s 12th argument must be 8-bit array.\n", TASK_NAME);
+      pkt_control(vpiFinish);
+  }
+
+  if (vpi_tf_ctx_build(systf_handle)==NULL) pkt_control(vpiFinish);
+
   return(0);
 }
 #undef TASK_NAME
 //----------------------------------------------------------------------------
-PLI_INT32 msg_ptpv2_get_context_Calltf(PLI_BYTE8 *user_data) {
-  vpiHandle systf_handle, arg_iterator;
-  vpiHandle H_ptp_version   ;
-  vpiHandle H_ptp_domain    ;
-  vpiHandle H_one_step_clock;
-  vpiHandle H_unicast_port  ;
-  vpiHandle H_profile_spec1 ;
-  vpiHandle H_profile_spec2 ;
+PLI_INT32 pkt_udp_ip_eth_burst_Calltf(PLI_BYTE8 *user_data) {
+  vpiHandle systf_handle;
+  vpi_tf_ctx_t *tf_ctx;
+  vpi_array_t *frames, *lengs;
   s_vpi_value value;
-  PLI_UINT32 ptp_version   ;
-  PLI_UINT32 ptp_domain    ;
-  PLI_UINT32 one_step_clock;
-  PLI_UINT32 unicast_port  ;
-  PLI_UINT32 profile_spec1 ;
-  PLI_UINT32 profile_spec2 ;
+  PLI_INT32  num_frame;
+  PLI_UINT16 port_src;
+  PLI_UINT16 port_dst;
+  PLI_UINT32 ip_src;
+  PLI_UINT32 ip_dst;
+  PLI_UBYTE8 ttl;
+  PLI_UBYTE8 mac_src[6];
+  PLI_UBYTE8 mac_dst[6];
+  PLI_INT32  bnum_payload;
+  PLI_UINT32 add_crc;
+  PLI_UINT32 add_preamble;
+  PLI_INT32  inc_port_src, inc_port_dst;
+  PLI_INT32  inc_ip_src, inc_ip_dst;
+  PLI_INT32  inc_bnum_payload;
+  PLI_INT32 *bnum_pkt;
+  uint8_t *eth_pkt; // buffer to hold a frame
+  uint8_t *payload; // buffer to hold payload data of all frames
+  int idx, leng, max, tmp;
 
   //--------------------Get all handlers
   systf_handle = vpi_handle(vpiSysTfCall, NULL);
-  arg_iterator = vpi_iterate(vpiArgument, systf_handle);
-  H_ptp_version    = vpi_scan(arg_iterator);
-  H_ptp_domain     = vpi_scan(arg_iterator);
-  H_one_step_clock = vpi_scan(arg_iterator);
-  H_unicast_port   = vpi_scan(arg_iterator);
-  H_profile_spec1  = vpi_scan(arg_iterator);
-  H_profile_spec2  = vpi_scan(arg_iterator);
-
-  ptpv2_ctx_t *ptpv2_ctx = get_ptpv2_context();
-  ptp_version    = ptpv2_ctx->ptp_version   ;
-  ptp_domain     = ptpv2_ctx->ptp_domain    ;
-  one_step_clock = ptpv2_ctx->one_step_clock;
-  unicast_port   = ptpv2_ctx->unicast_port  ;
-  profile_spec1  = ptpv2_ctx->profile_spec1 ;
-  profile_spec2  = ptpv2_ctx->profile_spec2 ;
-
-  PUT_INT_ARG (H_ptp_version   , PLI_UINT32, ptp_version   );
-  PUT_INT_ARG (H_ptp_domain    , PLI_UINT32, ptp_domain    );
-  PUT_INT_ARG (H_one_step_clock, PLI_UINT32, one_step_clock);
-  PUT_INT_ARG (H_unicast_port  , PLI_UINT32, unicast_port  );
-  PUT_INT_ARG (H_profile_spec1 , PLI_UINT32, profile_spec1 );
-  PUT_INT_ARG (H_profile_spec2 , PLI_UINT32, profile_spec2 );
+  tf_ctx       = vpi_tf_ctx_get(systf_handle);
+  if (tf_ctx==NULL) {
+      vpi_printf("ERROR: calloc error.\n");
+      pkt_control(vpiFinish);
+      return(0);
+  }
+  frames = vpi_tf_ctx_array(tf_ctx,0);
+  lengs  = vpi_tf_ctx_array(tf_ctx,1);
+
+  GET_INT_ARG(tf_ctx->arg[2] ,PLI_INT32 ,num_frame)
+  GET_INT_ARG(tf_ctx->arg[3] ,PLI_UINT16,port_src)
+  GET_INT_ARG(tf_ctx->arg[4] ,PLI_UINT16,port_dst)
+  GET_INT_ARG(tf_ctx->arg[5] ,PLI_UINT32,ip_src)
+  GET_INT_ARG(tf_ctx->arg[6] ,PLI_UINT32,ip_dst)
+  GET_INT_ARG(tf_ctx->arg[7] ,PLI_UBYTE8,ttl)
+  pkt_get_mac(tf_ctx->arg[8], mac_src);
+  pkt_get_mac(tf_ctx->arg[9], mac_dst);
+  GET_INT_ARG(tf_ctx->arg[10],PLI_INT32,bnum_payload)
+  GET_INT_ARG(tf_ctx->arg[12],PLI_UINT32,add_crc)
+  GET_INT_ARG(tf_ctx->arg[13],PLI_UINT32,add_preamble)
+  GET_INT_ARG(tf_ctx->arg[14],PLI_INT32 ,inc_port_src)
+  GET_INT_ARG(tf_ctx->arg[15],PLI_INT32 ,inc_port_dst)
+  GET_INT_ARG(tf_ctx->arg[16],PLI_INT32 ,inc_ip_src)
+  GET_INT_ARG(tf_ctx->arg[17],PLI_INT32 ,inc_ip_dst)
+  GET_INT_ARG(tf_ctx->arg[18],PLI_INT32 ,inc_bnum_payload)
+
+  num_frame = pkt_burst_num(frames, lengs, num_frame);
+  if (num_frame==0) return(0);
+  payload  = pkt_burst_payload(vpi_tf_ctx_array(tf_ctx,11), bnum_payload
+                              , inc_bnum_payload, num_frame, &max);
+  bnum_pkt = (PLI_INT32*)vpi_scratch(VPI_SCRATCH_AUX, num_frame*sizeof(PLI_INT32));
+  eth_pkt  = vpi_scratch(VPI_SCRATCH_PKT, 8+ETH_HDR_LEN+m_vlan_num*ETH_VLAN_TAG_LEN+IP_HDR_LEN+UDP_HDR_LEN+max+46+4);
+  if ((payload==NULL)||(bnum_pkt==NULL)||(eth_pkt==NULL)) {
+      vpi_printf("ERROR: scratch buffer error.\n");
+      pkt_control(vpiFinish);
+      return(0);
+  }
 
-  vpi_free_object(arg_iterator);
+  //--------------------build all frames
+  for (idx=0; idx<num_frame; idx++) {
+       leng = pkt_burst_leng(bnum_payload, inc_bnum_payload, idx, max);
+       tmp = gen_eth_ip_udp_packet_vlan( eth_pkt
+                                       , mac_src
+                                       , mac_dst
+                                       , m_vlan
+                                       , m_vlan_num
+                                       , ip_src + idx*inc_ip_src
+                                       , ip_dst + idx*inc_ip_dst
+                                       , port_src + idx*inc_port_src
+                                       , port_dst + idx*inc_port_dst
+                                       , leng // Pure UDP payload
+                                       , payload
+                                       , 1 // update UDP checksum
+                                       , add_crc
+                                       , add_preamble);
+       if (pkt_burst_put(frames, lengs, idx, eth_pkt, tmp)) {
+           pkt_control(vpiFinish);
+           return(0);
+       }
+       bnum_pkt[idx] = tmp;
+  }
+  vpi_array_put_int(lengs, 0, num_frame, bnum_pkt);
 
   return(0);
 }
 
 //----------------------------------------------------------------------------
-// returns PTPv2 message length
-//
-// 'sourcePortIdentity'
-// [9:8] = port identity
-// [7:5] = oui
-// [4:0] = uuid
-int msg_ptpv2_header(ptpv2_msg_hdr_t *ptpv2_msg_hdr
-                    ,vpiHandle H_messageType
-                    ,vpiHandle H_flagField
-                    ,vpiHandle H_correctionField
-                    ,vpiHandle H_sourceClockID
-                    ,vpiHandle H_sourcePortID
-                    ,vpiHandle H_sequenceID)
-{
-  s_vpi_value value;
-  PLI_UINT32 val32;
-  PLI_UINT16 val16;
-  PLI_UBYTE8  val8;
-  memset((void*)ptpv2_msg_hdr, 0, sizeof(ptpv2_msg_hdr_t));
-
-  GET_INT_ARG (H_messageType,PLI_UBYTE8,val8)
-  ptpv2_msg_hdr->messageType = val8&0xF;
-  ptpv2_msg_hdr->versionPTP  = 0x2;
+// $pkt_tcp_ip_ethernet_burst( pkt     [7:0][0:N-1][0:4095] // N frames
+//                           , bnum_pkt[15:0][0:N-1] // num of bytes of each frame
+//                           , num_frame // num of frames to build
+//                           , port_src[15:0]
+//                           , port_dst[15:0]
+//                           , seq_num [31:0]
+//                           , ack_num [31:0]
+//                           , ip_src  [31:0]
+//                           , ip_dst  [31:0]
+//                           , ttl     [ 7:0]
+//                           , mac_src [47:0]
+//                           , mac_dst [47:0]
+//                           , bnum_payload[15:0] // num of bytes of payload of the first frame
+//                           , payload [7:0][0:4095]
+//                           , add_crc      //
+//                           , add_preamble //
+//                           , inc_port_src
+//                           , inc_port_dst
+//                           , inc_ip_src
+//                           , inc_ip_dst
+//                           , inc_seq_num
+//                           , inc_bnum_payload
+//                           );
+//----------------------------------------------------------------------------
+#define TASK_NAME "$pkt_tcp_ip_ethernet_burst"
+PLI_INT32 pkt_tcp_ip_eth_burst_Compiletf(PLI_BYTE8 *user_data) {
+  vpiHandle systf_handle, arg_iterator, arg_handle, ele_handle;
+  PLI_INT32 tfarg_type, arg_type;
+  int width;
+  int numA, lengA, widthA;
+  int numB, widthB;
+  int numC, widthC;
 
-  GET_INT_ARG(H_flagField,PLI_UINT16,val16)
-  ptpv2_msg_hdr->flagField = htons(val16);
+  systf_handle = vpi_handle(vpiSysTfCall, NULL);
+  arg_iterator = vpi_iterate(vpiArgument, systf_handle);
+  if (arg_iterator==NULL) {
+      vpi_printf("ERROR: %s must have 22 arguments.\n", TASK_NAME);
+      pkt_control(vpiFinish);
+  }
 
-  GET_WIDE_ARG(H_correctionField) //64-bit
-  val32 = value.value.vector[0].aval;
-  ptpv2_msg_hdr->correctionField.low = htonl(val32);
-  val32 = value.value.vector[1].aval;
-  ptpv2_msg_hdr->correctionField.high = htonl(val32);
+  CHECK_FRAMES_ARG("1st", "22", numA, lengA, widthA) // frames
+  CHECK_ARRAY_ARG ("2nd", "22", numB, widthB) // bnum pkt
+  CHECK_INT_ARG   ("3rd", "22") // num frame
+  CHECK_INT_ARG   ("4th", "22") // SRC port
+  CHECK_INT_ARG   ("5th", "22") // DST port
+  CHECK_INT_ARG   ("6th", "22") // SEQ num
+  CHECK_INT_ARG   ("7th", "22") // ACK num
+  CHECK_INT_ARG   ("8th", "22") // SRC IP
+  CHECK_INT_ARG   ("9th", "22") // DST IP
+  CHECK_INT_ARG   ("10th","22") // TTL
+  CHECK_WIDE_ARG  ("11th","22", 48) // SRC MAC
+  CHECK_WIDE_ARG  ("12th","22", 48) // DST MAC
+  CHECK_WIDE_ARG  ("13th","22", 16) // bnum payload
+  CHECK_ARRAY_ARG ("14th","22", numC, widthC) // payload
+  CHECK_INT_ARG   ("15th","22") // add crc
+  CHECK_INT_ARG   ("16th","22") // add preamble
+  CHECK_INT_ARG   ("17th","22") // inc SRC port
+  CHECK_INT_ARG   ("18th","22") // inc DST port
+  CHECK_INT_ARG   ("19th","22") // inc SRC IP
+  CHECK_INT_ARG   ("20th","22") // inc DST IP
+  CHECK_INT_ARG   ("21st","22") // inc SEQ num
+  CHECK_INT_ARG   ("22nd","22") // inc bnum payload
 
-  GET_WIDE_ARG(H_sourceClockID) //64-bit
-  val32 = value.value.vector[0].aval;
+  arg_handle = vpi_scan(arg_iterator);
+  if (arg_handle!=NULL) {
+      vpi_printf("ERROR: %s must have 22 arguments.\n", TASK_NAME);
+      vpi_free_object(arg_iterator);
+      pkt_control(vpiFinish);
+  }
 
-  ptpv2_msg_hdr->sourcePortIdentity.clockIdentity[7] = val32&0x000000FF;
-  ptpv2_msg_hdr->sourcePortIdentity.clockIdentity[6] =(val32&0x0000FF00)>>8;
-  ptpv2_msg_hdr->sourcePortIdentity.clockIdentity[5] =(val32&0x00FF0000)>>16;
-  ptpv2_msg_hdr->sourcePortIdentity.clockIdentity[4] =(val32&0xFF000000)>>24;
-  val32 = value.value.vector[1].aval;
+  if (widthA!=8) {
+      vpi_printf("ERROR: %s first argument must be 8-bit 2-D array.\n", TASK_NAME);
+      pkt_control(vpiFinish);
+  }
+  if (widthB<16) {
+      vpi_printf("ERROR: %s second argument must be 16-bit array.\n", TASK_NAME);
+      pkt_control(vpiFinish);
+  }
+  if (widthC!=8) {
+      vpi_printf("ERROR: %s 14th argument must be 8-bit array.\n", TASK_NAME);
+      pkt_control(vpiFinish);
+  }
 
-  ptpv2_msg_hdr->sourcePortIdentity.clockIdentity[3] = val32&0x000000FF;
-  ptpv2_msg_hdr->sourcePortIdentity.clockIdentity[2] =(val32&0x0000FF00)>>8;
-  ptpv2_msg_hdr->sourcePortIdentity.clockIdentity[1] =(val32&0x00FF0000)>>16;
-  ptpv2_msg_hdr->sourcePortIdentity.clockIdentity[0] =(val32&0xFF000000)>>24;
+  if (vpi_tf_ctx_build(systf_handle)==NULL) pkt_control(vpiFinish);
 
-  GET_INT_ARG(H_sourcePortID,PLI_UINT16,val16)
-  ptpv2_msg_hdr->sourcePortIdentity.portNumber = htons(val16);
+  return(0);
+}
+#undef TASK_NAME
+//----------------------------------------------------------------------------
+PLI_INT32 pkt_tcp_ip_eth_burst_Calltf(PLI_BYTE8 *user_data) {
+  vpiHandle systf_handle;
+  vpi_tf_ctx_t *tf_ctx;
+  vpi_array_t *frames, *lengs;
+  s_vpi_value value;
+  PLI_INT32  num_frame;
+  PLI_UINT16 port_src;
+  PLI_UINT16 port_dst;
+  PLI_UINT32 seq_num;
+  PLI_UINT32 ack_num;
+  PLI_UINT32 ip_src;
+  PLI_UINT32 ip_dst;
+  PLI_UBYTE8 ttl;
+  PLI_UBYTE8 mac_src[6];
+  PLI_UBYTE8 mac_dst[6];
+  PLI_INT32  bnum_payload;
+  PLI_UINT32 add_crc;
+  PLI_UINT32 add_preamble;
+  PLI_INT32  inc_port_src, inc_port_dst;
+  PLI_INT32  inc_ip_src, inc_ip_dst;
+  PLI_INT32  inc_seq_num;
+  PLI_INT32  inc_bnum_payload;
+  PLI_INT32 *bnum_pkt;
+  uint8_t *eth_pkt; // buffer to hold a frame
+  uint8_t *payload; // buffer to hold payload data of all frames
+  int idx, leng, max, tmp;
 
-  GET_INT_ARG(H_sequenceID,PLI_UINT16,val16)
-  ptpv2_msg_hdr->sequenceID = htons(val16);
+  //--------------------Get all handlers
+  systf_handle = vpi_handle(vpiSysTfCall, NULL);
+  tf_ctx       = vpi_tf_ctx_get(systf_handle);
+  if (tf_ctx==NULL) {
+      vpi_printf("ERROR: calloc error.\n");
+      pkt_control(vpiFinish);
+      return(0);
+  }
+  frames = vpi_tf_ctx_array(tf_ctx,0);
+  lengs  = vpi_tf_ctx_array(tf_ctx,1);
+
+  GET_INT_ARG(tf_ctx->arg[2] ,PLI_INT32 ,num_frame)
+  GET_INT_ARG(tf_ctx->arg[3] ,PLI_UINT16,port_src)
+  GET_INT_ARG(tf_ctx->arg[4] ,PLI_UINT16,port_dst)
+  GET_INT_ARG(tf_ctx->arg[5] ,PLI_UINT32,seq_num)
+  GET_INT_ARG(tf_ctx->arg[6] ,PLI_UINT32,ack_num)
+  GET_INT_ARG(tf_ctx->arg[7] ,PLI_UINT32,ip_src)
+  GET_INT_ARG(tf_ctx->arg[8] ,PLI_UINT32,ip_dst)
+  GET_INT_ARG(tf_ctx->arg[9] ,PLI_UBYTE8,ttl)
+  pkt_get_mac(tf_ctx->arg[10], mac_src);
+  pkt_get_mac(tf_ctx->arg[11], mac_dst);
+  GET_INT_ARG(tf_ctx->arg[12],PLI_INT32,bnum_payload)
+  GET_INT_ARG(tf_ctx->arg[14],PLI_UINT32,add_crc)
+  GET_INT_ARG(tf_ctx->arg[15],PLI_UINT32,add_preamble)
+  GET_INT_ARG(tf_ctx->arg[16],PLI_INT32 ,inc_port_src)
+  GET_INT_ARG(tf_ctx->arg[17],PLI_INT32 ,inc_port_dst)
+  GET_INT_ARG(tf_ctx->arg[18],PLI_INT32 ,inc_ip_src)
+  GET_INT_ARG(tf_ctx->arg[19],PLI_INT32 ,inc_ip_dst)
+  GET_INT_ARG(tf_ctx->arg[20],PLI_INT32 ,inc_seq_num)
+  GET_INT_ARG(tf_ctx->arg[21],PLI_INT32 ,inc_bnum_payload)
+
+  num_frame = pkt_burst_num(frames, lengs, num_frame);
+  if (num_frame==0) return(0);
+  payload  = pkt_burst_payload(vpi_tf_ctx_array(tf_ctx,13), bnum_payload
+                              , inc_bnum_payload, num_frame, &max);
+  bnum_pkt = (PLI_INT32*)vpi_scratch(VPI_SCRATCH_AUX, num_frame*sizeof(PLI_INT32));
+  eth_pkt  = vpi_scratch(VPI_SCRATCH_PKT, 8+ETH_HDR_LEN+m_vlan_num*ETH_VLAN_TAG_LEN+IP_HDR_LEN+TCP_HDR_LEN+max+46+4);
+  if ((payload==NULL)||(bnum_pkt==NULL)||(eth_pkt==NULL)) {
+      vpi_printf("ERROR: scratch buffer error.\n");
+      pkt_control(vpiFinish);
+      return(0);
+  }
 
-  uint16_t msg_len;
-  switch (ptpv2_msg_hdr->messageType) {
-  case PTPV2_MSG_Sync                 : msg_len=sizeof(ptpv2_msg_sync_t                 ); break;
-  case PTPV2_MSG_Delay_Req            : msg_len=sizeof(ptpv2_msg_delay_req_t            ); break;
-  case PTPV2_MSG_Pdelay_Req           : msg_len=sizeof(ptpv2_msg_pdelay_req_t           ); break;
-  case PTPV2_MSG_Pdelay_Resp          : msg_len=sizeof(ptpv2_msg_pdelay_resp_t          ); break;
-  case PTPV2_MSG_Follow_Up            : msg_len=sizeof(ptpv2_msg_follow_up_t            ); break;
-  case PTPV2_MSG_Delay_Resp           : msg_len=sizeof(ptpv2_msg_delay_resp_t           ); break;
-  case PTPV2_MSG_Pdelay_Resp_Follow_Up: msg_len=sizeof(ptpv2_msg_pdelay_resp_follow_up_t); break;
-  case PTPV2_MSG_Announce             : msg_len=sizeof(ptpv2_msg_announce_t             ); break;
-  case PTPV2_MSG_Signaling            : msg_len=sizeof(ptpv2_msg_signaling_t            ); break;
-  case PTPV2_MSG_Management           : msg_len=sizeof(ptpv2_msg_management_t           ); break;
-  default: vpi_printf("Unknown PTPv22 message type: %u\n", ptpv2_msg_hdr->messageType);
-           return 0;
-  }
-  ptpv2_msg_hdr->messageLength = htons(msg_len);
-  uint8_t logInterval;
-  uint8_t unicast=0; // 0: multicst, 1: unicast [NEED attention...]
-  switch (ptpv2_msg_hdr->messageType) {
-  case PTPV2_MSG_Sync                 : logInterval = (unicast) ? 0x7F: 0x03; break;
-  case PTPV2_MSG_Delay_Req            : logInterval = (unicast) ? 0x7F: 0x03; break;
-  case PTPV2_MSG_Pdelay_Req           : logInterval=0x7F; break;
-  case PTPV2_MSG_Pdelay_Resp          : logInterval=0x7F; break;
-  case PTPV2_MSG_Follow_Up            : logInterval = (unicast) ? 0x7F: 0x03; break;
-  case PTPV2_MSG_Delay_Resp           : logInterval = (unicast) ? 0x7F: 0x03; break;
-  case PTPV2_MSG_Pdelay_Resp_Follow_Up: logInterval=0x7F; break;
-  case PTPV2_MSG_Announce             : logInterval=0x7F; break;
-  case PTPV2_MSG_Signaling            : logInterval=0x7F; break;
-  case PTPV2_MSG_Management           : logInterval=0x7F; break;
-  }
-  ptpv2_msg_hdr->logMessageInterval = logInterval;
+  //--------------------build all frames
+  for (idx=0; idx<num_frame; idx++) {
+       leng = pkt_burst_leng(bnum_payload, inc_bnum_payload, idx, max);
+       tmp = gen_eth_ip_tcp_packet_vlan( eth_pkt
+                                       , mac_src
+                                       , mac_dst
+                                       , m_vlan
+                                       , m_vlan_num
+                                       , ip_src + idx*inc_ip_src
+                                       , ip_dst + idx*inc_ip_dst
+                                       , port_src + idx*inc_port_src
+                                       , port_dst + idx*inc_port_dst
+                                       , seq_num + idx*inc_seq_num
+                                       , ack_num
+                                       , leng // Pure TCP payload
+                                       , payload
+                                       , 1 // update TCP checksum
+                                       , add_crc
+                                       , add_preamble);
+       if (pkt_burst_put(frames, lengs, idx, eth_pkt, tmp)) {
+           pkt_control(vpiFinish);
+           return(0);
+       }
+       bnum_pkt[idx] = tmp;
+  }
+  vpi_array_put_int(lengs, 0, num_frame, bnum_pkt);
 
-  return msg_len;
+  return(0);
 }
 
 //----------------------------------------------------------------------------
-// $msg_ptpv2( pkt             [ 7:0][0:1024*4-1]
-//           , bnum_pkt        [15:0] // num of bytes of the whole message
-//           , messageType     [ 3:0]
-//           , flagField       [15:0]
-//           , correctionField [63:0]
-//           , sourceClockID   [63:0]
-//           , sourcePortID    [15:0]
-//           , sequenceID      [15:0]
-//           , secondsField    [47:0]
-//           , nanosecondsField[31:0]
-//           );
+// $pkt_tcp_segment( pkt     [7:0][0:N-1][0:1535] // N segment frames
+//                 , bnum_pkt[15:0][0:N-1] // num of bytes of each frame
+//                 , num_seg  // num of segments built
+//                 , port_src[15:0]
+//                 , port_dst[15:0]
+//                 , seq_num [31:0] // sequence number of the first segment
+//                 , ack_num [31:0]
+//                 , ip_src  [31:0]
+//                 , ip_dst  [31:0]
+//                 , ip_id   [15:0] // IP ID of the first segment
+//                 , mac_src [47:0]
+//                 , mac_dst [47:0]
+//                 , mss     [15:0] // max segment size
+//                 , bnum_payload[31:0] // num of bytes of the whole payload
+//                 , payload [7:0][0:65535]
+//                 , flags      [7:0] // TCP flags of all segments, e.g., ACK
+//                 , flags_last [7:0] // TCP flags added to the last, e.g., PSH
+//                 , add_crc      //
+//                 , add_preamble //
+//                 );
 //----------------------------------------------------------------------------
-#define TASK_NAME "$msg_ptpv2"
-PLI_INT32 msg_ptpv2_Compiletf(PLI_BYTE8 *user_data) {
+#define TASK_NAME "$pkt_tcp_segment"
+PLI_INT32 pkt_tcp_segment_Compiletf(PLI_BYTE8 *user_data) {
   vpiHandle systf_handle, arg_iterator, arg_handle, ele_handle;
   PLI_INT32 tfarg_type, arg_type;
   int width;
-  int numA, widthA;
+  int numA, lengA, widthA;
+  int numB, widthB;
+  int numC, widthC;
 
   systf_handle = vpi_handle(vpiSysTfCall, NULL);
   arg_iterator = vpi_iterate(vpiArgument, systf_handle);
   if (arg_iterator==NULL) {
-      vpi_printf("ERROR: %s must have ten arguments.\n", TASK_NAME);
+      vpi_printf("ERROR: %s must have 19 arguments.\n", TASK_NAME);
       pkt_control(vpiFinish);
   }
 
-  CHECK_ARRAY_ARG("1st", "ten", numA, widthA)
-  CHECK_INT_ARG  ("2nd", "ten") // bnum pkt
-  CHECK_INT_ARG  ("3rd", "ten") // message type
-  CHECK_INT_ARG  ("4th", "ten") // flagField
-  CHECK_WIDE_ARG ("5th", "ten", 64)  // correctionField
-  CHECK_WIDE_ARG ("6th", "ten", 64)  // sourceClockID
-  CHECK_INT_ARG  ("7th", "ten")  // sourcePortID
-  CHECK_INT_ARG  ("8th", "ten") // sequence ID
-  CHECK_WIDE_ARG ("9th", "ten", 48)  // seconds
-  CHECK_INT_ARG  ("10th","ten") // nano
+  CHECK_FRAMES_ARG("1st", "19", numA, lengA, widthA) // frames
+  CHECK_ARRAY_ARG ("2nd", "19", numB, widthB) // bnum pkt
+  CHECK_INT_ARG   ("3rd", "19") // num seg
+  CHECK_INT_ARG   ("4th", "19") // SRC port
+  CHECK_INT_ARG   ("5th", "19") // DST port
+  CHECK_INT_ARG   ("6th", "19") // SEQ num
+  CHECK_INT_ARG   ("7th", "19") // ACK num
+  CHECK_INT_ARG   ("8th", "19") // SRC IP
+  CHECK_INT_ARG   ("9th", "19") // DST IP
+  CHECK_INT_ARG   ("10th","19") // IP ID
+  CHECK_WIDE_ARG  ("11th","19", 48) // SRC MAC
+  CHECK_WIDE_ARG  ("12th","19", 48) // DST MAC
+  CHECK_INT_ARG   ("13th","19") // MSS
+  CHECK_WIDE_ARG  ("14th","19", 16) // bnum payload
+  CHECK_ARRAY_ARG ("15th","19", numC, widthC) // payload
+  CHECK_INT_ARG   ("16th","19") // flags
+  CHECK_INT_ARG   ("17th","19") // flags of the last
+  CHECK_INT_ARG   ("18th","19") // add crc
+  CHECK_INT_ARG   ("19th","19") // add preamble
 
   arg_handle = vpi_scan(arg_iterator);
   if (arg_handle!=NULL) {
-      vpi_printf("ERROR: %s must have 10 arguments.\n", TASK_NAME);
+      vpi_printf("ERROR: %s must have 19 arguments.\n", TASK_NAME);
       vpi_free_object(arg_iterator);
       pkt_control(vpiFinish);
   }
 
   if (widthA!=8) {
-      vpi_printf("ERROR: %s first argument must be 8-bit array.\n", TASK_NAME);
+      vpi_printf("ERROR: %s first argument must be 8-bit 2-D array.\n", TASK_NAME);
+      pkt_control(vpiFinish);
+  }
+  if (widthB<16) {
+      vpi_printf("ERROR: %s second argument must be 16-bit array.\n", TASK_NAME);
+      pkt_control(vpiFinish);
+  }
+  if (widthC!=8) {
+      vpi_printf("ERROR: %s 15th argument must be 8-bit array.\n", TASK_NAME);
       pkt_control(vpiFinish);
   }
 
+  if (vpi_tf_ctx_build(systf_handle)==NULL) pkt_control(vpiFinish);
+
   return(0);
 }
 #undef TASK_NAME
 //----------------------------------------------------------------------------
-PLI_INT32 msg_ptpv2_Calltf(PLI_BYTE8 *user_data) {
-  vpiHandle systf_handle, arg_iterator;
-  vpiHandle H_pkt         ;
-  vpiHandle H_bnum_pkt    ;
-  vpiHandle H_messageType ;
-  vpiHandle H_secondsField;
-  vpiHandle H_nanoField   ;
-  vpiHandle H_sequenceID  ;
-  vpiHandle H_sourceClockID;
-  vpiHandle H_sourcePortID ;
-  vpiHandle H_correctionField   ;
-  vpiHandle H_flagField         ;
+// Segments are built back to back in a scratch buffer, which is
+// a stream of frames, and then each goes to its own row.
+PLI_INT32 pkt_tcp_segment_Calltf(PLI_BYTE8 *user_data) {
+  vpiHandle systf_handle;
+  vpi_tf_ctx_t *tf_ctx;
+  vpi_array_t *frames, *lengs;
   s_vpi_value value;
-  PLI_UINT32 val32, val8;
-  PLI_UINT16 bnum_pkt;
-  //PLI_UBYTE8 messageType;
-  PLI_UINT16 secondsMsb ;
-  PLI_UINT32 secondsLsb ;
-  PLI_UINT32 nanoseconds;
-  //PLI_UINT16 sequenceID ;
-  PLI_UINT16 flagField  ;
-  int idx, idy, idz;
+  PLI_UINT16 port_src;
+  PLI_UINT16 port_dst;
+  PLI_UINT32 seq_num;
+  PLI_UINT32 ack_num;
+  PLI_UINT32 ip_src;
+  PLI_UINT32 ip_dst;
+  PLI_UINT16 ip_id;
+  PLI_UBYTE8 mac_src[6];
+  PLI_UBYTE8 mac_dst[6];
+  PLI_INT32  mss;
+  PLI_INT32  bnum_payload;
+  PLI_UBYTE8 flags;
+  PLI_UBYTE8 flags_last;
+  PLI_UINT32 add_crc;
+  PLI_UINT32 add_preamble;
+  PLI_INT32 *bnum_pkt;
+  uint8_t *eth_pkt; // buffer to hold all segment frames
+  uint8_t *payload; // buffer to hold the whole payload
+  int idx, num, off;
 
   //--------------------Get all handlers
   systf_handle = vpi_handle(vpiSysTfCall, NULL);
-  arg_iterator = vpi_iterate(vpiArgument, systf_handle);
-
-  H_pkt          = vpi_scan(arg_iterator);
-  H_bnum_pkt     = vpi_scan(arg_iterator);
-  H_messageType  = vpi_scan(arg_iterator);
-  H_flagField       = vpi_scan(arg_iterator);
-  H_correctionField = vpi_scan(arg_iterator);
-  H_sourceClockID = vpi_scan(arg_iterator);
-  H_sourcePortID  = vpi_scan(arg_iterator);
-  H_sequenceID   = vpi_scan(arg_iterator);
-  H_secondsField = vpi_scan(arg_iterator);
-  H_nanoField    = vpi_scan(arg_iterator);
-
-  GET_WIDE_ARG(H_secondsField)
-  val32 = value.value.vector[0].aval;
-  secondsLsb = val32;
-  val32 = value.value.vector[1].aval;
-  secondsMsb = val32&0xFFFF;
-  GET_INT_ARG(H_nanoField,PLI_UINT32,nanoseconds)
-
-  //--------------------build Ethernet packet
-  ptpv2_msg_hdr_t ptpv2_msg_hdr;
-  uint16_t msg_len;
-  msg_len = msg_ptpv2_header(&ptpv2_msg_hdr
-                            ,H_messageType
-                            ,H_flagField
-                            ,H_correctionField
-                            ,H_sourceClockID
-                            ,H_sourcePortID
-                            ,H_sequenceID);
-  if (msg_len==0) {
-      vpi_free_object(arg_iterator);
+  tf_ctx       = vpi_tf_ctx_get(systf_handle);
+  if (tf_ctx==NULL) {
+      vpi_printf("ERROR: calloc error.\n");
       pkt_control(vpiFinish);
+      return(0);
   }
-
-  uint8_t *ptpv2_msg; // buffer to hold whole PTPV2 message
-  ptpv2_msg = (uint8_t*)calloc(msg_len, 1);
-  if (ptpv2_msg==NULL) {
-      vpi_printf("ERROR: calloc error.\n");
-      vpi_free_object(arg_iterator);
+  frames = vpi_tf_ctx_array(tf_ctx,0);
+  lengs  = vpi_tf_ctx_array(tf_ctx,1);
+
+  GET_INT_ARG(tf_ctx->arg[3] ,PLI_UINT16,port_src)
+  GET_INT_ARG(tf_ctx->arg[4] ,PLI_UINT16,port_dst)
+  GET_INT_ARG(tf_ctx->arg[5] ,PLI_UINT32,seq_num)
+  GET_INT_ARG(tf_ctx->arg[6] ,PLI_UINT32,ack_num)
+  GET_INT_ARG(tf_ctx->arg[7] ,PLI_UINT32,ip_src)
+  GET_INT_ARG(tf_ctx->arg[8] ,PLI_UINT32,ip_dst)
+  GET_INT_ARG(tf_ctx->arg[9] ,PLI_UINT16,ip_id)
+  pkt_get_mac(tf_ctx->arg[10], mac_src);
+  pkt_get_mac(tf_ctx->arg[11], mac_dst);
+  GET_INT_ARG(tf_ctx->arg[12],PLI_INT32 ,mss)
+  GET_INT_ARG(tf_ctx->arg[13],PLI_INT32 ,bnum_payload)
+  GET_INT_ARG(tf_ctx->arg[15],PLI_UBYTE8,flags)
+  GET_INT_ARG(tf_ctx->arg[16],PLI_UBYTE8,flags_last)
+  GET_INT_ARG(tf_ctx->arg[17],PLI_UINT32,add_crc)
+  GET_INT_ARG(tf_ctx->arg[18],PLI_UINT32,add_preamble)
+  PUT_INT_ARG(tf_ctx->arg[2] ,PLI_INT32 ,0)
+
+  num = pkt_tcp_segment_num(bnum_payload, mss);
+  if (num<0) {
+      vpi_printf("ERROR: %s() %d-byte payload with MSS %d.\n", __FUNCTION__, bnum_payload, mss);
       pkt_control(vpiFinish);
+      return(0);
   }
-
-  ptpv2_ctx_t *ctx = get_ptpv2_context();
-
-  Timestamp_t time;
-  time.secondsField.msb = secondsMsb;
-  time.secondsField.lsb = secondsLsb;
-  time.nanosecondsField = nanoseconds;
-
-  msg_len = gen_ptpv2_msg[ptpv2_msg_hdr.messageType]( ctx
-                                                    , ptpv2_msg
-                                                    ,&ptpv2_msg_hdr
-                                                    ,&time
-                                                    , NULL);
-  if (msg_len==0) {
-      vpi_printf("something wrong while building PTPv2 header\n");
-      vpi_free_object(arg_iterator);
+  if (pkt_fit_array(tf_ctx,14,(bnum_payload>TCP_PAYLOAD_MAX) ? -1 : bnum_payload,__FUNCTION__)||
+      (pkt_burst_num(frames, lengs, num)!=num)) {
       pkt_control(vpiFinish);
+      return(0);
   }
-
-  //--------------------copy all generated contents
-  int tmp=msg_len; // [Need attension]
-  for (idy=0; idy<tmp; idy++) {
-       vpiHandle ele = vpi_handle_by_index(H_pkt, idy);
-       value.value.integer = ptpv2_msg[idy];
-       vpi_put_value(ele, &value, NULL, vpiNoDelay);
+  payload  = vpi_scratch(VPI_SCRATCH_PAYLOAD, bnum_payload);
+  bnum_pkt = (PLI_INT32*)vpi_scratch(VPI_SCRATCH_AUX, num*sizeof(PLI_INT32));
+  eth_pkt  = vpi_scratch(VPI_SCRATCH_PKT, bnum_payload+num*PKT_SEGMENT_FRAME_MAX(0));
+  if ((payload==NULL)||(bnum_pkt==NULL)||(eth_pkt==NULL)) {
+      vpi_printf("ERROR: scratch buffer error.\n");
+      pkt_control(vpiFinish);
+      return(0);
   }
-
-  //--------------------put num of bytes of Ethernet packet
-  value.format = vpiIntVal;
-  value.value.integer = tmp;
-  vpi_put_value(H_bnum_pkt, &value, NULL, vpiNoDelay);
-
-  free(ptpv2_msg);
-  vpi_free_object(arg_iterator);
+  GET_ARRAY_ARG(vpi_tf_ctx_array(tf_ctx,14),0,bnum_payload,payload)
+
+  //--------------------build all segments
+  num = gen_eth_ip_tcp_segments( eth_pkt
+                               , 0 // back to back
+                               , bnum_pkt
+                               , num
+                               , mac_src
+                               , mac_dst
+                               , ip_src
+                               , ip_dst
+                               , ip_id
+                               , port_src
+                               , port_dst
+                               , seq_num
+                               , ack_num
+                               , flags
+                               , flags_last
+                               , mss
+                               , bnum_payload
+                               , payload
+                               , add_crc
+                               , add_preamble);
+  if (num<0) {
+      vpi_printf("ERROR: %s() segmentation error.\n", __FUNCTION__);
+      pkt_control(vpiFinish);
+      return(0);
+  }
+  for (idx=0, off=0; idx<num; off+=bnum_pkt[idx], idx++) {
+       if (pkt_burst_put(frames, lengs, idx, &eth_pkt[off], bnum_pkt[idx])) {
+           pkt_control(vpiFinish);
+           return(0);
+       }
+  }
+  vpi_array_put_int(lengs, 0, num, bnum_pkt);
+  PUT_INT_ARG(tf_ctx->arg[2] ,PLI_INT32 ,num)
 
   return(0);
 }
 
 //----------------------------------------------------------------------------
-// $msg_ptpv2_ethernet ( pkt               [ 7:0][0:1024*4-1]
-//                     , bnum_pkt          [15:0] // num of bytes of the whole message
-//                     , mac_src           [47:0]
-//                     , messageType       [ 3:0]
-//                     , flagField         [15:0]
-//                     , correctionField   [63:0]
-//                     , sourceClockID     [63:0]
-//                     , sourcePortID      [15:0]
-//                     , sequenceID        [15:0]
-//                     , secondsField      [47:0]
-//                     , nanosecondsField  [31:0]
-//                     , reqClockID        [64:0] // PortId(2, MSBytes)+ClockId(8)
-//                     , reqPortID         [15:0] // PortId(2, MSBytes)+ClockId(8)
-//                     , add_crc
-//                     , add_preamble
-//                     )
+// $pkt_ip_fragment( pkt     [7:0][0:N-1][0:1535] // N fragment frames
+//                 , bnum_pkt[15:0][0:N-1] // num of bytes of each frame
+//                 , num_frag // num of fragments built
+//                 , ip_src  [31:0]
+//                 , ip_dst  [31:0]
+//                 , protocol[ 7:0]
+//                 , ttl     [ 7:0]
+//                 , ip_id   // IP ID; negative for the next ID of the flow
+//                 , mac_src [47:0]
+//                 , mac_dst [47:0]
+//                 , mtu     [15:0] // num of bytes of IP packet at most
+//                 , bnum_payload[31:0] // num of bytes of IP payload
+//                 , payload [7:0][0:65514] // e.g., UDP header and its payload
+//                 , add_crc      //
+//                 , add_preamble //
+//                 );
 //----------------------------------------------------------------------------
-#define TASK_NAME "$msg_ptpv2_ethernet"
-PLI_INT32 msg_ptpv2_eth_Compiletf(PLI_BYTE8 *user_data) {
+#define TASK_NAME "$pkt_ip_fragment"
+PLI_INT32 pkt_ip_fragment_Compiletf(PLI_BYTE8 *user_data) {
   vpiHandle systf_handle, arg_iterator, arg_handle, ele_handle;
   PLI_INT32 tfarg_type, arg_type;
   int width;
-  int numA, widthA;
+  int numA, lengA, widthA;
+  int numB, widthB;
+  int numC, widthC;
 
   systf_handle = vpi_handle(vpiSysTfCall, NULL);
   arg_iterator = vpi_iterate(vpiArgument, systf_handle);
@@ -1695,21 +2642,21 @@ PLI_INT32 msg_ptpv2_eth_Compiletf(PLI_BYTE8 *user_data) {
       pkt_control(vpiFinish);
   }
 
-  CHECK_ARRAY_ARG("1st", "15", numA, widthA)
-  CHECK_INT_ARG  ("2nd", "15") // bnum pkt
-  CHECK_WIDE_ARG ("3rd", "15", 48) // MAC SRC
-  CHECK_INT_ARG  ("4rd", "15") // message type
-  CHECK_INT_ARG  ("5th", "15") // flagField
-  CHECK_WIDE_ARG ("6th", "15", 64)  // correctionField
-  CHECK_WIDE_ARG ("7th", "15", 64)  // sourcePortIdentify
-  CHECK_INT_ARG  ("8th", "15")  // sourcePortIdentify
-  CHECK_INT_ARG  ("9th", "15") // sequence ID
-  CHECK_WIDE_ARG ("10th","15", 48)  // seconds
-  CHECK_INT_ARG  ("11th","15") // nano
-  CHECK_WIDE_ARG ("12th","15", 64) // reqClockID
-  CHECK_INT_ARG  ("13th","15") // reqClockID
-  CHECK_INT_ARG  ("14th","15") // crc
-  CHECK_INT_ARG  ("15th","15") // preamble
+  CHECK_FRAMES_ARG("1st", "15", numA, lengA, widthA) // frames
+  CHECK_ARRAY_ARG ("2nd", "15", numB, widthB) // bnum pkt
+  CHECK_INT_ARG   ("3rd", "15") // num frag
+  CHECK_INT_ARG   ("4th", "15") // SRC IP
+  CHECK_INT_ARG   ("5th", "15") // DST IP
+  CHECK_INT_ARG   ("6th", "15") // protocol
+  CHECK_INT_ARG   ("7th", "15") // TTL
+  CHECK_INT_ARG   ("8th", "15") // IP ID
+  CHECK_WIDE_ARG  ("9th", "15", 48) // SRC MAC
+  CHECK_WIDE_ARG  ("10th","15", 48) // DST MAC
+  CHECK_INT_ARG   ("11th","15") // MTU
+  CHECK_WIDE_ARG  ("12th","15", 16) // bnum payload
+  CHECK_ARRAY_ARG ("13th","15", numC, widthC) // payload
+  CHECK_INT_ARG   ("14th","15") // add crc
+  CHECK_INT_ARG   ("15th","15") // add preamble
 
   arg_handle = vpi_scan(arg_iterator);
   if (arg_handle!=NULL) {
@@ -1719,230 +2666,3054 @@ PLI_INT32 msg_ptpv2_eth_Compiletf(PLI_BYTE8 *user_data) {
   }
 
   if (widthA!=8) {
-      vpi_printf("ERROR: %s first argument must be 8-bit array.\n", TASK_NAME);
+      vpi_printf("ERROR: %s first argument must be 8-bit 2-D array.\n", TASK_NAME);
+      pkt_control(vpiFinish);
+  }
+  if (widthB<16) {
+      vpi_printf("ERROR: %s second argument must be 16-bit array.\n", TASK_NAME);
+      pkt_control(vpiFinish);
+  }
+  if (widthC!=8) {
+      vpi_printf("ERROR: %s 13th argument must be 8-bit array.\n", TASK_NAME);
       pkt_control(vpiFinish);
   }
 
+  if (vpi_tf_ctx_build(systf_handle)==NULL) pkt_control(vpiFinish);
+
   return(0);
 }
 #undef TASK_NAME
 //----------------------------------------------------------------------------
-PLI_INT32 msg_ptpv2_eth_Calltf(PLI_BYTE8 *user_data) {
-  vpiHandle systf_handle, arg_iterator;
-  vpiHandle H_pkt         ;
-  vpiHandle H_bnum_pkt    ;
-  vpiHandle H_messageType ;
-  vpiHandle H_secondsField;
-  vpiHandle H_nanoField   ;
-  vpiHandle H_sequenceID  ;
-  vpiHandle H_sourceClockID;
-  vpiHandle H_sourcePortID;
-  vpiHandle H_correctionField   ;
-  vpiHandle H_flagField ;
-  vpiHandle H_reqClockID;
-  vpiHandle H_reqPortID ;
-  vpiHandle H_mac_src   ;
-  vpiHandle H_crc     ;
-  vpiHandle H_preamble;
+// Fragments are built back to back in a scratch buffer, which is
+// a stream of frames, and then each goes to its own row.
+PLI_INT32 pkt_ip_fragment_Calltf(PLI_BYTE8 *user_data) {
+  vpiHandle systf_handle;
+  vpi_tf_ctx_t *tf_ctx;
+  vpi_array_t *frames, *lengs;
   s_vpi_value value;
-  PLI_UINT32 val32, val16, val8;
-  PLI_UINT16 bnum_pkt   ;
-  //PLI_UBYTE8 messageType;
-  PLI_UINT16 secondsMsb ;
-  PLI_UINT32 secondsLsb ;
-  PLI_UINT32 nanoseconds;
-  //PLI_UINT16 sequenceID ;
-  PLI_UBYTE8 mac_src[6] ;
-  PLI_UINT32 add_crc     ;
+  PLI_UINT32 ip_src;
+  PLI_UINT32 ip_dst;
+  PLI_UBYTE8 protocol;
+  PLI_UBYTE8 ttl;
+  PLI_INT32  ip_id;
+  PLI_UBYTE8 mac_src[6];
+  PLI_UBYTE8 mac_dst[6];
+  PLI_INT32  mtu;
+  PLI_INT32  bnum_payload;
+  PLI_UINT32 add_crc;
   PLI_UINT32 add_preamble;
-  int idx, idy, idz;
-  uint8_t *ptpv2_msg; // buffer to hold whole Ethernet packet
-  int tmp;
+  PLI_INT32 *bnum_pkt;
+  uint8_t *eth_pkt; // buffer to hold all fragment frames
+  uint8_t *payload; // buffer to hold IP payload
+  int idx, num, off;
 
-//printf("%s()@%s 0\n", __FUNCTION__, __FILE__); fflush(stdout); vpi_flush();
   //--------------------Get all handlers
   systf_handle = vpi_handle(vpiSysTfCall, NULL);
-  arg_iterator = vpi_iterate(vpiArgument, systf_handle);
-
-  H_pkt             = vpi_scan(arg_iterator);
-  H_bnum_pkt        = vpi_scan(arg_iterator);
-  H_mac_src         = vpi_scan(arg_iterator);
-  H_messageType     = vpi_scan(arg_iterator);
-  H_flagField       = vpi_scan(arg_iterator);
-  H_correctionField = vpi_scan(arg_iterator);
-  H_sourceClockID   = vpi_scan(arg_iterator);
-  H_sourcePortID    = vpi_scan(arg_iterator);
-  H_sequenceID      = vpi_scan(arg_iterator);
-  H_secondsField    = vpi_scan(arg_iterator);
-  H_nanoField       = vpi_scan(arg_iterator);
-  H_reqClockID      = vpi_scan(arg_iterator);
-  H_reqPortID       = vpi_scan(arg_iterator);
-  H_crc             = vpi_scan(arg_iterator);
-  H_preamble        = vpi_scan(arg_iterator);
-  
-//printf("%s()@%s 1\n", __FUNCTION__, __FILE__); fflush(stdout); vpi_flush();
-  GET_WIDE_ARG(H_secondsField)
-  val32 = value.value.vector[0].aval;
-  secondsLsb = val32;
-  val32 = value.value.vector[1].aval;
+  tf_ctx       = vpi_tf_ctx_get(systf_handle);
+  if (tf_ctx==NULL) {
+      vpi_printf("ERROR: calloc error.\n");
+      pkt_control(vpiFinish);
+      return(0);
+  }
+  frames = vpi_tf_ctx_array(tf_ctx,0);
+  lengs  = vpi_tf_ctx_array(tf_ctx,1);
+
+  GET_INT_ARG(tf_ctx->arg[3] ,PLI_UINT32,ip_src)
+  GET_INT_ARG(tf_ctx->arg[4] ,PLI_UINT32,ip_dst)
+  GET_INT_ARG(tf_ctx->arg[5] ,PLI_UBYTE8,protocol)
+  GET_INT_ARG(tf_ctx->arg[6] ,PLI_UBYTE8,ttl)
+  GET_INT_ARG(tf_ctx->arg[7] ,PLI_INT32 ,ip_id)
+  pkt_get_mac(tf_ctx->arg[8], mac_src);
+  pkt_get_mac(tf_ctx->arg[9], mac_dst);
+  GET_INT_ARG(tf_ctx->arg[10],PLI_INT32 ,mtu)
+  GET_INT_ARG(tf_ctx->arg[11],PLI_INT32 ,bnum_payload)
+  GET_INT_ARG(tf_ctx->arg[13],PLI_UINT32,add_crc)
+  GET_INT_ARG(tf_ctx->arg[14],PLI_UINT32,add_preamble)
+  PUT_INT_ARG(tf_ctx->arg[2] ,PLI_INT32 ,0)
+
+  num = pkt_ip_fragment_num(bnum_payload, mtu);
+  if (num<0) {
+      vpi_printf("ERROR: %s() %d-byte payload with MTU %d.\n", __FUNCTION__, bnum_payload, mtu);
+      pkt_control(vpiFinish);
+      return(0);
+  }
+  if (pkt_fit_array(tf_ctx,12,bnum_payload,__FUNCTION__)||
+      (pkt_burst_num(frames, lengs, num)!=num)) {
+      pkt_control(vpiFinish);
+      return(0);
+  }
+  payload  = vpi_scratch(VPI_SCRATCH_PAYLOAD, bnum_payload);
+  bnum_pkt = (PLI_INT32*)vpi_scratch(VPI_SCRATCH_AUX, num*sizeof(PLI_INT32));
+  eth_pkt  = vpi_scratch(VPI_SCRATCH_PKT, bnum_payload+num*(PKT_FRAGMENT_FRAME_MAX(0)+8));
+  if ((payload==NULL)||(bnum_pkt==NULL)||(eth_pkt==NULL)) {
+      vpi_printf("ERROR: scratch buffer error.\n");
+      pkt_control(vpiFinish);
+      return(0);
+  }
+  GET_ARRAY_ARG(vpi_tf_ctx_array(tf_ctx,12),0,bnum_payload,payload)
+  if (ip_id<0) ip_id = pkt_ip_flow_id(ip_src, ip_dst, protocol);
+
+  //--------------------build all fragments
+  num = gen_eth_ip_fragments( eth_pkt
+                            , 0 // back to back
+                            , bnum_pkt
+                            , num
+                            , mac_src
+                            , mac_dst
+                            , ip_src
+                            , ip_dst
+                            , protocol
+                            , ttl
+                            , (uint16_t)ip_id
+                            , mtu
+                            , bnum_payload
+                            , payload
+                            , add_crc
+                            , add_preamble);
+  if (num<0) {
+      vpi_printf("ERROR: %s() fragmentation error.\n", __FUNCTION__);
+      pkt_control(vpiFinish);
+      return(0);
+  }
+  for (idx=0, off=0; idx<num; off+=bnum_pkt[idx], idx++) {
+       if (pkt_burst_put(frames, lengs, idx, &eth_pkt[off], bnum_pkt[idx])) {
+           pkt_control(vpiFinish);
+           return(0);
+       }
+  }
+  vpi_array_put_int(lengs, 0, num, bnum_pkt);
+  PUT_INT_ARG(tf_ctx->arg[2] ,PLI_INT32 ,num)
+
+  return(0);
+}
+
+//----------------------------------------------------------------------------
+// Templates created by $pkt_template_create; id is index of 'm_tpl[]'.
+static pkt_template_t **m_tpl=NULL;
+static int              m_tpl_num=0;
+
+//----------------------------------------------------------------------------
+// Returns template of 'id', NULL if not valid.
+static pkt_template_t *pkt_template_get(int id)
+{
+  if ((id<0)||(id>=m_tpl_num)) return NULL;
+  return m_tpl[id];
+}
+
+//----------------------------------------------------------------------------
+// Keeps 'tpl' in an empty slot and returns its id, -1 on failure.
+static int pkt_template_add(pkt_template_t *tpl)
+{
+  pkt_template_t **tmp;
+  int id;
+  for (id=0; id<m_tpl_num; id++) {
+       if (m_tpl[id]==NULL) { m_tpl[id] = tpl; return id; }
+  }
+  tmp = (pkt_template_t**)realloc(m_tpl, (m_tpl_num+16)*sizeof(pkt_template_t*));
+  if (tmp==NULL) return -1;
+  memset((void*)&tmp[m_tpl_num], 0, 16*sizeof(pkt_template_t*));
+  m_tpl = tmp;
+  m_tpl[m_tpl_num] = tpl;
+  m_tpl_num += 16;
+  return m_tpl_num-16;
+}
+
+//----------------------------------------------------------------------------
+// Releases all templates; called at the end of simulation.
+static void pkt_template_cleanup(void)
+{
+  int id;
+  for (id=0; id<m_tpl_num; id++) pkt_template_release(m_tpl[id]);
+  free(m_tpl);
+  m_tpl     = NULL;
+  m_tpl_num = 0;
+}
+
+//----------------------------------------------------------------------------
+// It reads up to 64-bit value, e.g., 48-bit MAC address.
+static uint64_t pkt_get_u64(vpiHandle H_val)
+{
+  s_vpi_value value;
+  uint64_t val64;
+  GET_WIDE_ARG(H_val)
+  val64 = (PLI_UINT32)value.value.vector[0].aval;
+  if (vpi_get(vpiSize, H_val)>32) {
+      val64 |= ((uint64_t)(PLI_UINT32)value.value.vector[1].aval)<<32;
+  }
+  return val64;
+}
+
+//----------------------------------------------------------------------------
+// $pkt_template_create( tpl // output: template id, -1 on failure
+//                     , protocol[ 7:0] // 17 for UDP, 6 for TCP
+//                     , port_src[15:0]
+//                     , port_dst[15:0]
+//                     , ip_src  [31:0]
+//                     , ip_dst  [31:0]
+//                     , mac_src [47:0]
+//                     , mac_dst [47:0]
+//                     , bnum_payload[15:0] // num of bytes of payload
+//                     , payload [7:0][0:4095]
+//                     , max_payload[15:0] // 'bnum_payload' can grow up to it
+//                     , add_crc      //
+//                     , add_preamble //
+//                     );
+// UDP/TCP checksum is always kept.
+//----------------------------------------------------------------------------
+#define TASK_NAME "$pkt_template_create"
+PLI_INT32 pkt_template_create_Compiletf(PLI_BYTE8 *user_data) {
+  vpiHandle systf_handle, arg_iterator, arg_handle, ele_handle;
+  PLI_INT32 arg_type;
+  int width;
+  int numA, widthA;
+
+  systf_handle = vpi_handle(vpiSysTfCall, NULL);
+  arg_iterator = vpi_iterate(vpiArgument, systf_handle);
+  if (arg_iterator==NULL) {
+      vpi_printf("ERROR: %s must have 13 arguments.\n", TASK_NAME);
+      pkt_control(vpiFinish);
+  }
+
+  CHECK_INT_ARG  ("1st", "13-th"              ) // template id
+  CHECK_INT_ARG  ("2nd", "13-th"              ) // protocol
+  CHECK_INT_ARG  ("3rd", "13-th"              ) // SRC port
+  CHECK_INT_ARG  ("4th", "13-th"              ) // DST port
+  CHECK_INT_ARG  ("5th", "13-th"              ) // SRC IP
+  CHECK_INT_ARG  ("6th", "13-th"              ) // DST IP
+  CHECK_WIDE_ARG ("7th", "13-th", 48          ) // SRC MAC
+  CHECK_WIDE_ARG ("8th", "13-th", 48          ) // DST MAC
+  CHECK_WIDE_ARG ("9th", "13-th", 16          ) // bnum payload
+  CHECK_ARRAY_ARG("10th","13-th", numA, widthA) // payload
+  CHECK_INT_ARG  ("11th","13-th"              ) // max payload
+  CHECK_INT_ARG  ("12th","13-th"              ) // add crc
+  CHECK_INT_ARG  ("13th","13-th"              ) // add preamble
+
+  arg_handle = vpi_scan(arg_iterator);
+  if (arg_handle!=NULL) {
+      vpi_printf("ERROR: %s must have 13 arguments.\n", TASK_NAME);
+      vpi_free_object(arg_iterator);
+      pkt_control(vpiFinish);
+  }
+
+  if (widthA!=8) {
+      vpi_printf("ERROR: %s 10th argument must be 8-bit array.\n", TASK_NAME);
+      pkt_control(vpiFinish);
+  }
+
+  if (vpi_tf_ctx_build(systf_handle)==NULL) pkt_control(vpiFinish);
+
+  return(0);
+}
+//----------------------------------------------------------------------------
+PLI_INT32 pkt_template_create_Calltf(PLI_BYTE8 *user_data) {
+  vpiHandle systf_handle;
+  vpi_tf_ctx_t *tf_ctx;
+  pkt_template_t *tpl;
+  s_vpi_value value;
+  PLI_UBYTE8 protocol;
+  PLI_UINT16 port_src;
+  PLI_UINT16 port_dst;
+  PLI_UINT32 ip_src;
+  PLI_UINT32 ip_dst;
+  PLI_UBYTE8 mac_src[6];
+  PLI_UBYTE8 mac_dst[6];
+  PLI_INT32  bnum_payload;
+  PLI_INT32  max_payload;
+  PLI_UINT32 add_crc;
+  PLI_UINT32 add_preamble;
+  uint8_t *payload; // buffer to hold payload data
+  int id;
+
+  //--------------------Get all handlers
+  systf_handle = vpi_handle(vpiSysTfCall, NULL);
+  tf_ctx       = vpi_tf_ctx_get(systf_handle);
+  if (tf_ctx==NULL) {
+      vpi_printf("ERROR: calloc error.\n");
+      pkt_control(vpiFinish);
+      return(0);
+  }
+
+  GET_INT_ARG(tf_ctx->arg[1] ,PLI_UBYTE8,protocol)
+  GET_INT_ARG(tf_ctx->arg[2] ,PLI_UINT16,port_src)
+  GET_INT_ARG(tf_ctx->arg[3] ,PLI_UINT16,port_dst)
+  GET_INT_ARG(tf_ctx->arg[4] ,PLI_UINT32,ip_src)
+  GET_INT_ARG(tf_ctx->arg[5] ,PLI_UINT32,ip_dst)
+  pkt_get_mac(tf_ctx->arg[6], mac_src);
+  pkt_get_mac(tf_ctx->arg[7], mac_dst);
+  GET_INT_ARG(tf_ctx->arg[8] ,PLI_INT32,bnum_payload)
+  GET_INT_ARG(tf_ctx->arg[10],PLI_INT32,max_payload)
+  GET_INT_ARG(tf_ctx->arg[11],PLI_UINT32,add_crc)
+  GET_INT_ARG(tf_ctx->arg[12],PLI_UINT32,add_preamble)
+
+  if (pkt_fit_array(tf_ctx,9,bnum_payload,__FUNCTION__)) {
+      pkt_control(vpiFinish);
+      return(0);
+  }
+  payload = vpi_scratch(VPI_SCRATCH_PAYLOAD, bnum_payload);
+  if (payload==NULL) {
+      vpi_printf("ERROR: scratch buffer error.\n");
+      pkt_control(vpiFinish);
+      return(0);
+  }
+  GET_ARRAY_ARG(vpi_tf_ctx_array(tf_ctx,9),0,bnum_payload,payload)
+
+  //--------------------build template
+  tpl = pkt_template_create( protocol
+                           , mac_src
+                           , mac_dst
+                           , ip_src
+                           , ip_dst
+                           , port_src
+                           , port_dst
+                           , bnum_payload
+                           , payload
+                           , max_payload
+                           , 1 // keep UDP/TCP checksum
+                           , add_crc
+                           , add_preamble);
+  id = (tpl==NULL) ? -1 : pkt_template_add(tpl);
+  if (tpl==NULL) {
+      vpi_printf("ERROR: %s protocol %d or max_payload %d not supported.\n", TASK_NAME, protocol, max_payload);
+  } else if (id<0) {
+      pkt_template_release(tpl);
+  }
+
+  PUT_INT_ARG(tf_ctx->arg[0],PLI_INT32,id)
+
+  return(0);
+}
+#undef TASK_NAME
+
+//----------------------------------------------------------------------------
+// $pkt_template_emit( pkt     [7:0][0:4095]
+//                   , bnum_pkt[15:0] // num of bytes of the whole packet
+//                   , tpl // template id
+//                   , "seq_num", seq_num // pairs of field name and value
+//                   , ...
+//                   );
+// Fields are patched in order and stay in the template for the next call.
+// Field names are: "mac_src", "mac_dst", "ip_id", "ttl", "ip_src", "ip_dst",
+//                  "port_src", "port_dst", "seq_num", "ack_num", "bnum_payload".
+//----------------------------------------------------------------------------
+#define TASK_NAME "$pkt_template_emit"
+PLI_INT32 pkt_template_emit_Compiletf(PLI_BYTE8 *user_data) {
+  vpiHandle systf_handle, arg_iterator, arg_handle, ele_handle;
+  PLI_INT32 arg_type;
+  s_vpi_value value;
+  int numA, widthA;
+
+  systf_handle = vpi_handle(vpiSysTfCall, NULL);
+  arg_iterator = vpi_iterate(vpiArgument, systf_handle);
+  if (arg_iterator==NULL) {
+      vpi_printf("ERROR: %s must have at least three arguments.\n", TASK_NAME);
+      pkt_control(vpiFinish);
+  }
+
+  CHECK_ARRAY_ARG("1st", "three", numA, widthA) // ethernet pkt
+  CHECK_INT_ARG  ("2nd", "three"              ) // bnum pkt
+  CHECK_INT_ARG  ("3rd", "three"              ) // template id
+
+  //--------------------pairs of field name and value
+  while ((arg_handle=vpi_scan(arg_iterator))!=NULL) {
+      if (vpi_get(vpiType, arg_handle)!=vpiConstant) {
+          vpi_printf("ERROR: %s field name must be a string.\n", TASK_NAME);
+          vpi_free_object(arg_iterator);
+          pkt_control(vpiFinish);
+          break;
+      }
+      value.format = vpiStringVal;
+      vpi_get_value(arg_handle, &value);
+      if (pkt_template_field(value.value.str)<0) {
+          vpi_printf("ERROR: %s unknown field \"%s\".\n", TASK_NAME, value.value.str);
+          vpi_free_object(arg_iterator);
+          pkt_control(vpiFinish);
+          break;
+      }
+      CHECK_INT_ARG("value", "pair of field")
+  }
+
+  if (widthA!=8) {
+      vpi_printf("ERROR: %s first argument must be 8-bit array.\n", TASK_NAME);
+      pkt_control(vpiFinish);
+  }
+
+  if (vpi_tf_ctx_build(systf_handle)==NULL) pkt_control(vpiFinish);
+
+  return(0);
+}
+//----------------------------------------------------------------------------
+PLI_INT32 pkt_template_emit_Calltf(PLI_BYTE8 *user_data) {
+  vpiHandle systf_handle;
+  vpi_tf_ctx_t *tf_ctx;
+  pkt_template_t *tpl;
+  s_vpi_value value;
+  PLI_INT32 id;
+  uint8_t *eth_pkt; // buffer to hold whole packet
+  int idx, field, tmp;
+
+  //--------------------Get all handlers
+  systf_handle = vpi_handle(vpiSysTfCall, NULL);
+  tf_ctx       = vpi_tf_ctx_get(systf_handle);
+  if (tf_ctx==NULL) {
+      vpi_printf("ERROR: calloc error.\n");
+      pkt_control(vpiFinish);
+      return(0);
+  }
+
+  GET_INT_ARG(tf_ctx->arg[2],PLI_INT32,id)
+  tpl = pkt_template_get(id);
+  if (tpl==NULL) {
+      vpi_printf("ERROR: %s template %d not valid.\n", TASK_NAME, id);
+      pkt_control(vpiFinish);
+      return(0);
+  }
+
+  //--------------------patch fields
+  for (idx=3; (idx+1)<tf_ctx->num_arg; idx+=2) {
+       value.format = vpiStringVal;
+       vpi_get_value(tf_ctx->arg[idx], &value);
+       field = pkt_template_field(value.value.str);
+       if (pkt_template_set(tpl, field, pkt_get_u64(tf_ctx->arg[idx+1]))) {
+           vpi_printf("ERROR: %s field \"%s\" can not be set.\n", TASK_NAME, value.value.str);
+       }
+  }
+
+  //--------------------copy the frame
+  eth_pkt = vpi_scratch(VPI_SCRATCH_PKT, tpl->bnum);
+  if (eth_pkt==NULL) {
+      vpi_printf("ERROR: scratch buffer error.\n");
+      pkt_control(vpiFinish);
+      return(0);
+  }
+  tmp = pkt_template_emit(tpl, eth_pkt);
+  if (pkt_fit_array(tf_ctx,0,tmp,__FUNCTION__)) {
+      pkt_control(vpiFinish);
+      return(0);
+  }
+
+  PUT_ARRAY_ARG(vpi_tf_ctx_array(tf_ctx,0),0,tmp,eth_pkt)
+
+  //--------------------put num of bytes of Ethernet packet
+  if (pkt_put_bnum(tf_ctx->arg[1], tmp, __FUNCTION__)) pkt_control(vpiFinish);
+
+  return(0);
+}
+#undef TASK_NAME
+
+//----------------------------------------------------------------------------
+// $pkt_template_release( tpl );
+//----------------------------------------------------------------------------
+#define TASK_NAME "$pkt_template_release"
+PLI_INT32 pkt_template_release_Compiletf(PLI_BYTE8 *user_data) {
+  vpiHandle systf_handle, arg_iterator, arg_handle;
+  PLI_INT32 arg_type;
+
+  systf_handle = vpi_handle(vpiSysTfCall, NULL);
+  arg_iterator = vpi_iterate(vpiArgument, systf_handle);
+  if (arg_iterator==NULL) {
+      vpi_printf("ERROR: %s must have one argument.\n", TASK_NAME);
+      pkt_control(vpiFinish);
+  }
+
+  CHECK_INT_ARG  ("1st", "one") // template id
+
+  arg_handle = vpi_scan(arg_iterator);
+  if (arg_handle!=NULL) {
+      vpi_printf("ERROR: %s must have one argument.\n", TASK_NAME);
+      vpi_free_object(arg_iterator);
+      pkt_control(vpiFinish);
+  }
+
+  return(0);
+}
+//----------------------------------------------------------------------------
+PLI_INT32 pkt_template_release_Calltf(PLI_BYTE8 *user_data) {
+  vpiHandle systf_handle, arg_iterator;
+  s_vpi_value value;
+  PLI_INT32 id;
+
+  systf_handle = vpi_handle(vpiSysTfCall, NULL);
+  arg_iterator = vpi_iterate(vpiArgument, systf_handle);
+  GET_INT_ARG(vpi_scan(arg_iterator),PLI_INT32,id)
+  vpi_free_object(arg_iterator);
+  if (pkt_template_get(id)!=NULL) {
+      pkt_template_release(m_tpl[id]);
+      m_tpl[id] = NULL;
+  }
+
+  return(0);
+}
+#undef TASK_NAME
+
+//----------------------------------------------------------------------------
+// Initialize PTPv2 context
+// $msg_ptpv2_set_context( ptp_version 
+//                       , ptp_domain
+//                       , one_step_clock
+//                       , unicast_port
+//                       , profile_spec1
+//                       , profile_spec2
+//                       );
+#define TASK_NAME "$msg_ptpv2_set_context"
+PLI_INT32 msg_ptpv2_set_context_Compiletf(PLI_BYTE8 *user_data) {
+  vpiHandle systf_handle, arg_iterator, arg_handle;
+  PLI_INT32 arg_type;
+
+  systf_handle = vpi_handle(vpiSysTfCall, NULL);
+  arg_iterator = vpi_iterate(vpiArgument, systf_handle);
+  if (arg_iterator==NULL) {
+      vpi_printf("ERROR: %s must have six arguments.\n", TASK_NAME);
+      pkt_control(vpiFinish);
+  }
+
+  CHECK_INT_ARG  ("1st", "six")
+  CHECK_INT_ARG  ("2nd", "six")
+  CHECK_INT_ARG  ("3rd", "six")
+  CHECK_INT_ARG  ("4th", "six")
+  CHECK_INT_ARG  ("5th", "six")
+  CHECK_INT_ARG  ("6th", "six")
+
+  arg_handle = vpi_scan(arg_iterator);
+  if (arg_handle!=NULL) {
+      vpi_printf("ERROR: %s must have six arguments.\n", TASK_NAME);
+      vpi_free_object(arg_iterator);
+      pkt_control(vpiFinish);
+  }
+
+  if (vpi_tf_ctx_build(systf_handle)==NULL) pkt_control(vpiFinish);
+
+  return(0);
+}
+#undef TASK_NAME
+//----------------------------------------------------------------------------
+PLI_INT32 msg_ptpv2_set_context_Calltf(PLI_BYTE8 *user_data) {
+  vpiHandle systf_handle;
+  vpi_tf_ctx_t *tf_ctx;
+  vpiHandle H_ptp_version   ;
+  vpiHandle H_ptp_domain    ;
+  vpiHandle H_one_step_clock;
+  vpiHandle H_unicast_port  ;
+  vpiHandle H_profile_spec1 ;
+  vpiHandle H_profile_spec2 ;
+  s_vpi_value value;
+  PLI_UINT32 ptp_version   ;
+  PLI_UINT32 ptp_domain    ;
+  PLI_UINT32 one_step_clock;
+  PLI_UINT32 unicast_port  ;
+  PLI_UINT32 profile_spec1 ;
+  PLI_UINT32 profile_spec2 ;
+
+  //--------------------Get all handlers
+  systf_handle = vpi_handle(vpiSysTfCall, NULL);
+  tf_ctx       = vpi_tf_ctx_get(systf_handle);
+  if (tf_ctx==NULL) {
+      vpi_printf("ERROR: calloc error.\n");
+      pkt_control(vpiFinish);
+      return(0);
+  }
+  H_ptp_version    = tf_ctx->arg[0];
+  H_ptp_domain     = tf_ctx->arg[1];
+  H_one_step_clock = tf_ctx->arg[2];
+  H_unicast_port   = tf_ctx->arg[3];
+  H_profile_spec1  = tf_ctx->arg[4];
+  H_profile_spec2  = tf_ctx->arg[5];
+
+  GET_INT_ARG (H_ptp_version   , PLI_UINT32, ptp_version   );
+  GET_INT_ARG (H_ptp_domain    , PLI_UINT32, ptp_domain    );
+  GET_INT_ARG (H_one_step_clock, PLI_UINT32, one_step_clock);
+  GET_INT_ARG (H_unicast_port  , PLI_UINT32, unicast_port  );
+  GET_INT_ARG (H_profile_spec1 , PLI_UINT32, profile_spec1 );
+  GET_INT_ARG (H_profile_spec2 , PLI_UINT32, profile_spec2 );
+
+  gen_ptpv2_context( ptp_version   
+                   , ptp_domain    
+                   , one_step_clock
+                   , unicast_port  
+                   , profile_spec1 
+                   , profile_spec2 
+                   );
+
+  return(0);
+}
+
+//----------------------------------------------------------------------------
+// Get PTPv2 context
+// $msg_ptpv2_get_context( ptp_version 
+//                       , ptp_domain
+//                       , one_step_clock
+//                       , unicast_port
+//                       , profile_spec1
+//                       , profile_spec2
+//                       );
+#define TASK_NAME "$msg_ptpv2_get_context"
+PLI_INT32 msg_ptpv2_get_context_Compiletf(PLI_BYTE8 *user_data) {
+  vpiHandle systf_handle, arg_iterator, arg_handle;
+  PLI_INT32 arg_type;
+
+  systf_handle = vpi_handle(vpiSysTfCall, NULL);
+  arg_iterator = vpi_iterate(vpiArgument, systf_handle);
+  if (arg_iterator==NULL) {
+      vpi_printf("ERROR: %s must have six arguments.\n", TASK_NAME);
+      pkt_control(vpiFinish);
+  }
+
+  CHECK_INT_ARG  ("first" , "six")
+  CHECK_INT_ARG  ("second", "six")
+  CHECK_INT_ARG  ("third" , "six")
+  CHECK_INT_ARG  ("fourth", "six")
+  CHECK_INT_ARG  ("fifth" , "six")
+  CHECK_INT_ARG  ("sixth" , "six")
+
+  arg_handle = vpi_scan(arg_iterator);
+  if (arg_handle!=NULL) {
+      vpi_printf("ERROR: %s must have six arguments.\n", TASK_NAME);
+      vpi_free_object(arg_iterator);
+      pkt_control(vpiFinish);
+  }
+
+  if (vpi_tf_ctx_build(systf_handle)==NULL) pkt_control(vpiFinish);
+
+  return(0);
+}
+#undef TASK_NAME
+//----------------------------------------------------------------------------
+PLI_INT32 msg_ptpv2_get_context_Calltf(PLI_BYTE8 *user_data) {
+  vpiHandle systf_handle;
+  vpi_tf_ctx_t *tf_ctx;
+  vpiHandle H_ptp_version   ;
+  vpiHandle H_ptp_domain    ;
+  vpiHandle H_one_step_clock;
+  vpiHandle H_unicast_port  ;
+  vpiHandle H_profile_spec1 ;
+  vpiHandle H_profile_spec2 ;
+  s_vpi_value value;
+  PLI_UINT32 ptp_version   ;
+  PLI_UINT32 ptp_domain    ;
+  PLI_UINT32 one_step_clock;
+  PLI_UINT32 unicast_port  ;
+  PLI_UINT32 profile_spec1 ;
+  PLI_UINT32 profile_spec2 ;
+
+  //--------------------Get all handlers
+  systf_handle = vpi_handle(vpiSysTfCall, NULL);
+  tf_ctx       = vpi_tf_ctx_get(systf_handle);
+  if (tf_ctx==NULL) {
+      vpi_printf("ERROR: calloc error.\n");
+      pkt_control(vpiFinish);
+      return(0);
+  }
+  H_ptp_version    = tf_ctx->arg[0];
+  H_ptp_domain     = tf_ctx->arg[1];
+  H_one_step_clock = tf_ctx->arg[2];
+  H_unicast_port   = tf_ctx->arg[3];
+  H_profile_spec1  = tf_ctx->arg[4];
+  H_profile_spec2  = tf_ctx->arg[5];
+
+  ptpv2_ctx_t *ptpv2_ctx = get_ptpv2_context();
+  ptp_version    = ptpv2_ctx->ptp_version   ;
+  ptp_domain     = ptpv2_ctx->ptp_domain    ;
+  one_step_clock = ptpv2_ctx->one_step_clock;
+  unicast_port   = ptpv2_ctx->unicast_port  ;
+  profile_spec1  = ptpv2_ctx->profile_spec1 ;
+  profile_spec2  = ptpv2_ctx->profile_spec2 ;
+
+  PUT_INT_ARG (H_ptp_version   , PLI_UINT32, ptp_version   );
+  PUT_INT_ARG (H_ptp_domain    , PLI_UINT32, ptp_domain    );
+  PUT_INT_ARG (H_one_step_clock, PLI_UINT32, one_step_clock);
+  PUT_INT_ARG (H_unicast_port  , PLI_UINT32, unicast_port  );
+  PUT_INT_ARG (H_profile_spec1 , PLI_UINT32, profile_spec1 );
+  PUT_INT_ARG (H_profile_spec2 , PLI_UINT32, profile_spec2 );
+
+
+  return(0);
+}
+
+//----------------------------------------------------------------------------
+// $msg_ptpv2_set_announce( currentUtcOffset
+//                        , grandmasterPriority1
+//                        , grandmasterClockClass
+//                        , grandmasterClockAccuracy
+//                        , grandmasterClockVariance
+//                        , grandmasterPriority2
+//                        , grandmasterIdentity [63:0]
+//                        , stepsRemoved
+//                        , timeSource
+//                        );
+#define TASK_NAME "$msg_ptpv2_set_announce"
+PLI_INT32 msg_ptpv2_set_announce_Compiletf(PLI_BYTE8 *user_data) {
+  vpiHandle systf_handle, arg_iterator, arg_handle;
+  PLI_INT32 arg_type;
+  int width;
+
+  systf_handle = vpi_handle(vpiSysTfCall, NULL);
+  arg_iterator = vpi_iterate(vpiArgument, systf_handle);
+  if (arg_iterator==NULL) {
+      vpi_printf("ERROR: %s must have nine arguments.\n", TASK_NAME);
+      pkt_control(vpiFinish);
+  }
+
+  CHECK_INT_ARG  ("1st", "nine") // currentUtcOffset
+  CHECK_INT_ARG  ("2nd", "nine") // priority1
+  CHECK_INT_ARG  ("3rd", "nine") // clockClass
+  CHECK_INT_ARG  ("4th", "nine") // clockAccuracy
+  CHECK_INT_ARG  ("5th", "nine") // offsetScaledLogVariance
+  CHECK_INT_ARG  ("6th", "nine") // priority2
+  CHECK_WIDE_ARG ("7th", "nine", 64) // grandmasterIdentity
+  CHECK_INT_ARG  ("8th", "nine") // stepsRemoved
+  CHECK_INT_ARG  ("9th", "nine") // timeSource
+
+  arg_handle = vpi_scan(arg_iterator);
+  if (arg_handle!=NULL) {
+      vpi_printf("ERROR: %s must have nine arguments.\n", TASK_NAME);
+      vpi_free_object(arg_iterator);
+      pkt_control(vpiFinish);
+  }
+
+  if (vpi_tf_ctx_build(systf_handle)==NULL) pkt_control(vpiFinish);
+
+  return(0);
+}
+#undef TASK_NAME
+//----------------------------------------------------------------------------
+PLI_INT32 msg_ptpv2_set_announce_Calltf(PLI_BYTE8 *user_data) {
+  vpiHandle systf_handle;
+  vpi_tf_ctx_t *tf_ctx;
+  s_vpi_value value;
+  PLI_UINT32 utc_offset, priority1, clock_class, clock_accuracy;
+  PLI_UINT32 clock_variance, priority2, steps_removed, time_source;
+  uint64_t   gm_identity;
+
+  //--------------------Get all handlers
+  systf_handle = vpi_handle(vpiSysTfCall, NULL);
+  tf_ctx       = vpi_tf_ctx_get(systf_handle);
+  if (tf_ctx==NULL) {
+      vpi_printf("ERROR: calloc error.\n");
+      pkt_control(vpiFinish);
+      return(0);
+  }
+  GET_INT_ARG (tf_ctx->arg[0], PLI_UINT32, utc_offset    )
+  GET_INT_ARG (tf_ctx->arg[1], PLI_UINT32, priority1     )
+  GET_INT_ARG (tf_ctx->arg[2], PLI_UINT32, clock_class   )
+  GET_INT_ARG (tf_ctx->arg[3], PLI_UINT32, clock_accuracy)
+  GET_INT_ARG (tf_ctx->arg[4], PLI_UINT32, clock_variance)
+  GET_INT_ARG (tf_ctx->arg[5], PLI_UINT32, priority2     )
+  GET_WIDE_ARG(tf_ctx->arg[6]) //64-bit
+  gm_identity = ((uint64_t)(uint32_t)value.value.vector[1].aval<<32)
+              |  (uint64_t)(uint32_t)value.value.vector[0].aval;
+  GET_INT_ARG (tf_ctx->arg[7], PLI_UINT32, steps_removed )
+  GET_INT_ARG (tf_ctx->arg[8], PLI_UINT32, time_source   )
+
+  set_ptpv2_announce( get_ptpv2_context()
+                    , utc_offset&0xFFFF
+                    , priority1&0xFF
+                    , clock_class&0xFF
+                    , clock_accuracy&0xFF
+                    , clock_variance&0xFFFF
+                    , priority2&0xFF
+                    , gm_identity
+                    , steps_removed&0xFFFF
+                    , time_source&0xFF);
+
+  return(0);
+}
+
+//----------------------------------------------------------------------------
+// $msg_ptpv2_set_management( actionField, boundaryHops );
+#define TASK_NAME "$msg_ptpv2_set_management"
+PLI_INT32 msg_ptpv2_set_management_Compiletf(PLI_BYTE8 *user_data) {
+  vpiHandle systf_handle, arg_iterator, arg_handle;
+  PLI_INT32 arg_type;
+
+  systf_handle = vpi_handle(vpiSysTfCall, NULL);
+  arg_iterator = vpi_iterate(vpiArgument, systf_handle);
+  if (arg_iterator==NULL) {
+      vpi_printf("ERROR: %s must have two arguments.\n", TASK_NAME);
+      pkt_control(vpiFinish);
+  }
+
+  CHECK_INT_ARG  ("1st", "two") // actionField
+  CHECK_INT_ARG  ("2nd", "two") // boundaryHops
+
+  arg_handle = vpi_scan(arg_iterator);
+  if (arg_handle!=NULL) {
+      vpi_printf("ERROR: %s must have two arguments.\n", TASK_NAME);
+      vpi_free_object(arg_iterator);
+      pkt_control(vpiFinish);
+  }
+
+  if (vpi_tf_ctx_build(systf_handle)==NULL) pkt_control(vpiFinish);
+
+  return(0);
+}
+#undef TASK_NAME
+//----------------------------------------------------------------------------
+PLI_INT32 msg_ptpv2_set_management_Calltf(PLI_BYTE8 *user_data) {
+  vpiHandle systf_handle;
+  vpi_tf_ctx_t *tf_ctx;
+  s_vpi_value value;
+  PLI_UINT32 action, boundary_hops;
+
+  //--------------------Get all handlers
+  systf_handle = vpi_handle(vpiSysTfCall, NULL);
+  tf_ctx       = vpi_tf_ctx_get(systf_handle);
+  if (tf_ctx==NULL) {
+      vpi_printf("ERROR: calloc error.\n");
+      pkt_control(vpiFinish);
+      return(0);
+  }
+  GET_INT_ARG (tf_ctx->arg[0], PLI_UINT32, action       )
+  GET_INT_ARG (tf_ctx->arg[1], PLI_UINT32, boundary_hops)
+
+  set_ptpv2_management(get_ptpv2_context(), action, boundary_hops);
+
+  return(0);
+}
+
+//----------------------------------------------------------------------------
+// $msg_ptpv2_tlv( messageType [ 3:0]
+//               , tlvType     [15:0] // 0 removes all TLVs of 'messageType'
+//               , bnum_value  [15:0]
+//               , value       [ 7:0][0:N-1]
+//               );
+#define TASK_NAME "$msg_ptpv2_tlv"
+PLI_INT32 msg_ptpv2_tlv_Compiletf(PLI_BYTE8 *user_data) {
+  vpiHandle systf_handle, arg_iterator, arg_handle, ele_handle;
+  PLI_INT32 tfarg_type, arg_type;
+  int width;
+  int numA, widthA;
+
+  systf_handle = vpi_handle(vpiSysTfCall, NULL);
+  arg_iterator = vpi_iterate(vpiArgument, systf_handle);
+  if (arg_iterator==NULL) {
+      vpi_printf("ERROR: %s must have four arguments.\n", TASK_NAME);
+      pkt_control(vpiFinish);
+  }
+
+  CHECK_INT_ARG  ("1st", "four") // messageType
+  CHECK_INT_ARG  ("2nd", "four") // tlvType
+  CHECK_WIDE_ARG ("3rd", "four", 16) // bnum value
+  CHECK_ARRAY_ARG("4th", "four", numA, widthA) // value
+
+  arg_handle = vpi_scan(arg_iterator);
+  if (arg_handle!=NULL) {
+      vpi_printf("ERROR: %s must have four arguments.\n", TASK_NAME);
+      vpi_free_object(arg_iterator);
+      pkt_control(vpiFinish);
+  }
+
+  if (widthA!=8) {
+      vpi_printf("ERROR: %s value argument must be 8-bit array.\n", TASK_NAME);
+      pkt_control(vpiFinish);
+  }
+
+  if (vpi_tf_ctx_build(systf_handle)==NULL) pkt_control(vpiFinish);
+
+  return(0);
+}
+#undef TASK_NAME
+//----------------------------------------------------------------------------
+PLI_INT32 msg_ptpv2_tlv_Calltf(PLI_BYTE8 *user_data) {
+  vpiHandle systf_handle;
+  vpi_tf_ctx_t *tf_ctx;
+  s_vpi_value value;
+  PLI_UBYTE8 type;
+  PLI_UINT16 tlv_type;
+  PLI_INT32  bnum_value;
+  uint8_t   *tlv; // buffer to hold value
+
+  //--------------------Get all handlers
+  systf_handle = vpi_handle(vpiSysTfCall, NULL);
+  tf_ctx       = vpi_tf_ctx_get(systf_handle);
+  if (tf_ctx==NULL) {
+      vpi_printf("ERROR: calloc error.\n");
+      pkt_control(vpiFinish);
+      return(0);
+  }
+  GET_INT_ARG(tf_ctx->arg[0],PLI_UBYTE8,type)
+  GET_INT_ARG(tf_ctx->arg[1],PLI_UINT16,tlv_type)
+  GET_INT_ARG(tf_ctx->arg[2],PLI_INT32 ,bnum_value)
+  if (tlv_type==0) {
+      clear_ptpv2_tlv(get_ptpv2_context(), type);
+      return(0);
+  }
+  if ((bnum_value<0)||(bnum_value>PTPV2_TLV_MAX)) bnum_value = -1;
+  if (pkt_fit_array(tf_ctx,3,bnum_value,__FUNCTION__)) {
+      pkt_control(vpiFinish);
+      return(0);
+  }
+  tlv = vpi_scratch(VPI_SCRATCH_PAYLOAD, bnum_value);
+  if (tlv==NULL) {
+      vpi_printf("ERROR: scratch buffer error.\n");
+      pkt_control(vpiFinish);
+      return(0);
+  }
+  GET_ARRAY_ARG(vpi_tf_ctx_array(tf_ctx,3),0,bnum_value,tlv)
+
+  if (add_ptpv2_tlv(get_ptpv2_context(), type, tlv_type, tlv, bnum_value)<0) {
+      vpi_printf("ERROR: %s() no room for %d-byte TLV.\n", __FUNCTION__, bnum_value);
+      pkt_control(vpiFinish);
+  }
+
+  return(0);
+}
+
+//----------------------------------------------------------------------------
+// It reads PortIdentity in network order from clockIdentity and portNumber.
+static void pkt_get_port_identity(vpiHandle H_clock, vpiHandle H_port, PortIdentity_t *port)
+{
+  s_vpi_value value;
+  uint64_t clock_id = pkt_get_u64(H_clock);
+  PLI_UINT16 port_id;
+  int idx;
+  for (idx=0; idx<8; idx++) port->clockIdentity[idx] = (clock_id>>(8*(7-idx)))&0xFF;
+  GET_INT_ARG(H_port,PLI_UINT16,port_id)
+  port->portNumber = htons(port_id);
+}
+
+//----------------------------------------------------------------------------
+// $msg_ptpv2_sequence( pkt          [7:0][0:N-1][0:1535] // N frames
+//                    , bnum_pkt     [15:0][0:N-1] // num of bytes of each frame
+//                    , num_frame    // output: num of frames built
+//                    , exchange     // 0: Sync/Follow_Up, 1: Delay_Req/Delay_Resp, 2: Pdelay
+//                    , num_exchange // num of exchanges to build
+//                    , mac_src      [47:0] // master of Sync, requester of others
+//                    , ip_src       [31:0]
+//                    , sourceClockID[63:0]
+//                    , sourcePortID [15:0]
+//                    , mac_peer     [47:0] // responder; not used by Sync
+//                    , ip_peer      [31:0]
+//                    , peerClockID  [63:0]
+//                    , peerPortID   [15:0]
+//                    , sequenceID   [15:0] // of the first exchange
+//                    , secondsField [47:0] // start of the first exchange
+//                    , nanosecondsField[31:0]
+//                    , interval     [63:0] // nano-seconds between exchanges
+//                    , delay        [31:0] // nano-seconds from request to its receipt
+//                    , turnaround   [31:0] // nano-seconds from receipt of Pdelay_Req to Pdelay_Resp
+//                    , udp          // 1 for UDP/IP, 0 for Ethernet
+//                    , add_crc      //
+//                    , add_preamble //
+//                    );
+//----------------------------------------------------------------------------
+#define TASK_NAME "$msg_ptpv2_sequence"
+PLI_INT32 msg_ptpv2_sequence_Compiletf(PLI_BYTE8 *user_data) {
+  vpiHandle systf_handle, arg_iterator, arg_handle, ele_handle;
+  PLI_INT32 tfarg_type, arg_type;
+  int width;
+  int numA, lengA, widthA;
+  int numB, widthB;
+
+  systf_handle = vpi_handle(vpiSysTfCall, NULL);
+  arg_iterator = vpi_iterate(vpiArgument, systf_handle);
+  if (arg_iterator==NULL) {
+      vpi_printf("ERROR: %s must have 22 arguments.\n", TASK_NAME);
+      pkt_control(vpiFinish);
+  }
+
+  CHECK_FRAMES_ARG("1st", "22", numA, lengA, widthA) // frames
+  CHECK_ARRAY_ARG ("2nd", "22", numB, widthB) // bnum pkt
+  CHECK_INT_ARG   ("3rd", "22") // num frame
+  CHECK_INT_ARG   ("4th", "22") // exchange
+  CHECK_INT_ARG   ("5th", "22") // num exchange
+  CHECK_WIDE_ARG  ("6th", "22", 48) // SRC MAC
+  CHECK_INT_ARG   ("7th", "22") // SRC IP
+  CHECK_WIDE_ARG  ("8th", "22", 64) // SRC clockIdentity
+  CHECK_INT_ARG   ("9th", "22") // SRC portNumber
+  CHECK_WIDE_ARG  ("10th","22", 48) // peer MAC
+  CHECK_INT_ARG   ("11th","22") // peer IP
+  CHECK_WIDE_ARG  ("12th","22", 64) // peer clockIdentity
+  CHECK_INT_ARG   ("13th","22") // peer portNumber
+  CHECK_INT_ARG   ("14th","22") // sequence ID
+  CHECK_WIDE_ARG  ("15th","22", 48) // seconds
+  CHECK_INT_ARG   ("16th","22") // nano
+  CHECK_INT_ARG   ("17th","22") // interval
+  CHECK_INT_ARG   ("18th","22") // delay
+  CHECK_INT_ARG   ("19th","22") // turnaround
+  CHECK_INT_ARG   ("20th","22") // udp
+  CHECK_INT_ARG   ("21st","22") // add crc
+  CHECK_INT_ARG   ("22nd","22") // add preamble
+
+  arg_handle = vpi_scan(arg_iterator);
+  if (arg_handle!=NULL) {
+      vpi_printf("ERROR: %s must have 22 arguments.\n", TASK_NAME);
+      vpi_free_object(arg_iterator);
+      pkt_control(vpiFinish);
+  }
+
+  if (widthA!=8) {
+      vpi_printf("ERROR: %s first argument must be 8-bit 2-D array.\n", TASK_NAME);
+      pkt_control(vpiFinish);
+  }
+  if (widthB<16) {
+      vpi_printf("ERROR: %s second argument must be 16-bit array.\n", TASK_NAME);
+      pkt_control(vpiFinish);
+  }
+
+  if (vpi_tf_ctx_build(systf_handle)==NULL) pkt_control(vpiFinish);
+
+  return(0);
+}
+#undef TASK_NAME
+//----------------------------------------------------------------------------
+// Frames are emitted from templates of the sequence, so that only
+// sequenceId, timestamp and FCS are computed for each frame.
+PLI_INT32 msg_ptpv2_sequence_Calltf(PLI_BYTE8 *user_data) {
+  vpiHandle systf_handle;
+  vpi_tf_ctx_t *tf_ctx;
+  vpi_array_t *frames, *lengs;
+  s_vpi_value value;
+  PLI_INT32  exchange;
+  PLI_INT32  num_exchange;
+  PLI_UBYTE8 mac_src[6];
+  PLI_UINT32 ip_src;
+  PLI_UBYTE8 mac_peer[6];
+  PLI_UINT32 ip_peer;
+  PLI_UINT16 sequenceID;
+  PLI_UINT32 nanoseconds;
+  PLI_UINT32 delay;
+  PLI_UINT32 turnaround;
+  PLI_UINT32 udp;
+  PLI_UINT32 add_crc;
+  PLI_UINT32 add_preamble;
+  PortIdentity_t port_src, port_peer;
+  Timestamp_t start;
+  uint64_t seconds, interval;
+  ptpv2_sequence_t *seq;
+  PLI_INT32 *bnum_pkt;
+  uint8_t *eth_pkt; // buffer to hold a frame
+  int idx, num;
+
+  //--------------------Get all handlers
+  systf_handle = vpi_handle(vpiSysTfCall, NULL);
+  tf_ctx       = vpi_tf_ctx_get(systf_handle);
+  if (tf_ctx==NULL) {
+      vpi_printf("ERROR: calloc error.\n");
+      pkt_control(vpiFinish);
+      return(0);
+  }
+  frames = vpi_tf_ctx_array(tf_ctx,0);
+  lengs  = vpi_tf_ctx_array(tf_ctx,1);
+
+  GET_INT_ARG(tf_ctx->arg[3] ,PLI_INT32 ,exchange)
+  GET_INT_ARG(tf_ctx->arg[4] ,PLI_INT32 ,num_exchange)
+  pkt_get_mac(tf_ctx->arg[5], mac_src);
+  GET_INT_ARG(tf_ctx->arg[6] ,PLI_UINT32,ip_src)
+  pkt_get_port_identity(tf_ctx->arg[7], tf_ctx->arg[8], &port_src);
+  pkt_get_mac(tf_ctx->arg[9], mac_peer);
+  GET_INT_ARG(tf_ctx->arg[10],PLI_UINT32,ip_peer)
+  pkt_get_port_identity(tf_ctx->arg[11], tf_ctx->arg[12], &port_peer);
+  GET_INT_ARG(tf_ctx->arg[13],PLI_UINT16,sequenceID)
+  seconds = pkt_get_u64(tf_ctx->arg[14]);
+  GET_INT_ARG(tf_ctx->arg[15],PLI_UINT32,nanoseconds)
+  interval = pkt_get_u64(tf_ctx->arg[16]);
+  GET_INT_ARG(tf_ctx->arg[17],PLI_UINT32,delay)
+  GET_INT_ARG(tf_ctx->arg[18],PLI_UINT32,turnaround)
+  GET_INT_ARG(tf_ctx->arg[19],PLI_UINT32,udp)
+  GET_INT_ARG(tf_ctx->arg[20],PLI_UINT32,add_crc)
+  GET_INT_ARG(tf_ctx->arg[21],PLI_UINT32,add_preamble)
+  PUT_INT_ARG(tf_ctx->arg[2] ,PLI_INT32 ,0)
+
+  start.secondsField.msb = (seconds>>32)&0xFFFF;
+  start.secondsField.lsb = (uint32_t)seconds;
+  start.nanosecondsField = nanoseconds;
+  seq = ptpv2_sequence_create( get_ptpv2_context()
+                             , exchange
+                             , mac_src
+                             , ip_src
+                             ,&port_src
+                             , mac_peer
+                             , ip_peer
+                             ,&port_peer
+                             , m_vlan
+                             , m_vlan_num
+                             , (udp) ? 1 : 0
+                             , sequenceID
+                             ,&start
+                             , interval
+                             , delay
+                             , turnaround
+                             , add_crc
+                             , add_preamble);
+  if (seq==NULL) {
+      vpi_printf("ERROR: %s() exchange %d.\n", __FUNCTION__, exchange);
+      pkt_control(vpiFinish);
+      return(0);
+  }
+  num = (num_exchange<0) ? 0 : num_exchange*seq->num_msg;
+  if (pkt_burst_num(frames, lengs, num)!=num) {
+      ptpv2_sequence_release(seq);
+      pkt_control(vpiFinish);
+      return(0);
+  }
+  bnum_pkt = (PLI_INT32*)vpi_scratch(VPI_SCRATCH_AUX, num*sizeof(PLI_INT32));
+  eth_pkt  = vpi_scratch(VPI_SCRATCH_PKT, PTPV2_FRAME_MAX);
+  if ((bnum_pkt==NULL)||(eth_pkt==NULL)) {
+      vpi_printf("ERROR: scratch buffer error.\n");
+      ptpv2_sequence_release(seq);
+      pkt_control(vpiFinish);
+      return(0);
+  }
+
+  //--------------------build all frames
+  for (idx=0; idx<num; idx++) {
+       bnum_pkt[idx] = ptpv2_sequence_emit(seq, eth_pkt);
+       if (pkt_burst_put(frames, lengs, idx, eth_pkt, bnum_pkt[idx])) {
+           ptpv2_sequence_release(seq);
+           pkt_control(vpiFinish);
+           return(0);
+       }
+  }
+  ptpv2_sequence_release(seq);
+  vpi_array_put_int(lengs, 0, num, bnum_pkt);
+  PUT_INT_ARG(tf_ctx->arg[2] ,PLI_INT32 ,num)
+
+  return(0);
+}
+
+//----------------------------------------------------------------------------
+// returns PTPv2 message length
+//
+// 'sourcePortIdentity'
+// [9:8] = port identity
+// [7:5] = oui
+// [4:0] = uuid
+int msg_ptpv2_header(ptpv2_msg_hdr_t *ptpv2_msg_hdr
+                    ,vpiHandle H_messageType
+                    ,vpiHandle H_flagField
+                    ,vpiHandle H_correctionField
+                    ,vpiHandle H_sourceClockID
+                    ,vpiHandle H_sourcePortID
+                    ,vpiHandle H_sequenceID)
+{
+  s_vpi_value value;
+  PLI_UINT16 flagField, sourcePortID, sequenceID;
+  PLI_UBYTE8 messageType;
+  uint64_t   correctionField, sourceClockID;
+  uint16_t   msg_len;
+
+  GET_INT_ARG (H_messageType,PLI_UBYTE8,messageType)
+  GET_INT_ARG (H_flagField,PLI_UINT16,flagField)
+  GET_WIDE_ARG(H_correctionField) //64-bit
+  correctionField = ((uint64_t)(uint32_t)value.value.vector[1].aval<<32)
+                  |  (uint64_t)(uint32_t)value.value.vector[0].aval;
+  GET_WIDE_ARG(H_sourceClockID) //64-bit
+  sourceClockID   = ((uint64_t)(uint32_t)value.value.vector[1].aval<<32)
+                  |  (uint64_t)(uint32_t)value.value.vector[0].aval;
+  GET_INT_ARG (H_sourcePortID,PLI_UINT16,sourcePortID)
+  GET_INT_ARG (H_sequenceID,PLI_UINT16,sequenceID)
+
+  msg_len = fill_ptpv2_msg_hdr( ptpv2_msg_hdr
+                              , messageType
+                              , flagField
+                              , correctionField
+                              , sourceClockID
+                              , sourcePortID
+                              , sequenceID);
+  if (msg_len==0) {
+      vpi_printf("Unknown PTPv22 message type: %u\n", messageType&0xF);
+  }
+  return msg_len;
+}
+
+//----------------------------------------------------------------------------
+// $msg_ptpv2( pkt             [ 7:0][0:1024*4-1]
+//           , bnum_pkt        [15:0] // num of bytes of the whole message
+//           , messageType     [ 3:0]
+//           , flagField       [15:0]
+//           , correctionField [63:0]
+//           , sourceClockID   [63:0]
+//           , sourcePortID    [15:0]
+//           , sequenceID      [15:0]
+//           , secondsField    [47:0]
+//           , nanosecondsField[31:0]
+//           );
+//----------------------------------------------------------------------------
+#define TASK_NAME "$msg_ptpv2"
+PLI_INT32 msg_ptpv2_Compiletf(PLI_BYTE8 *user_data) {
+  vpiHandle systf_handle, arg_iterator, arg_handle, ele_handle;
+  PLI_INT32 tfarg_type, arg_type;
+  int width;
+  int numA, widthA;
+
+  systf_handle = vpi_handle(vpiSysTfCall, NULL);
+  arg_iterator = vpi_iterate(vpiArgument, systf_handle);
+  if (arg_iterator==NULL) {
+      vpi_printf("ERROR: %s must have ten arguments.\n", TASK_NAME);
+      pkt_control(vpiFinish);
+  }
+
+  CHECK_ARRAY_ARG("1st", "ten", numA, widthA)
+  CHECK_INT_ARG  ("2nd", "ten") // bnum pkt
+  CHECK_INT_ARG  ("3rd", "ten") // message type
+  CHECK_INT_ARG  ("4th", "ten") // flagField
+  CHECK_WIDE_ARG ("5th", "ten", 64)  // correctionField
+  CHECK_WIDE_ARG ("6th", "ten", 64)  // sourceClockID
+  CHECK_INT_ARG  ("7th", "ten")  // sourcePortID
+  CHECK_INT_ARG  ("8th", "ten") // sequence ID
+  CHECK_WIDE_ARG ("9th", "ten", 48)  // seconds
+  CHECK_INT_ARG  ("10th","ten") // nano
+
+  arg_handle = vpi_scan(arg_iterator);
+  if (arg_handle!=NULL) {
+      vpi_printf("ERROR: %s must have 10 arguments.\n", TASK_NAME);
+      vpi_free_object(arg_iterator);
+      pkt_control(vpiFinish);
+  }
+
+  if (widthA!=8) {
+      vpi_printf("ERROR: %s first argument must be 8-bit array.\n", TASK_NAME);
+      pkt_control(vpiFinish);
+  }
+
+  if (vpi_tf_ctx_build(systf_handle)==NULL) pkt_control(vpiFinish);
+
+  return(0);
+}
+#undef TASK_NAME
+//----------------------------------------------------------------------------
+PLI_INT32 msg_ptpv2_Calltf(PLI_BYTE8 *user_data) {
+  vpiHandle systf_handle;
+  vpi_tf_ctx_t *tf_ctx;
+  vpiHandle H_pkt         ;
+  vpiHandle H_bnum_pkt    ;
+  vpiHandle H_messageType ;
+  vpiHandle H_secondsField;
+  vpiHandle H_nanoField   ;
+  vpiHandle H_sequenceID  ;
+  vpiHandle H_sourceClockID;
+  vpiHandle H_sourcePortID ;
+  vpiHandle H_correctionField   ;
+  vpiHandle H_flagField         ;
+  s_vpi_value value;
+  PLI_UINT32 val32, val8;
+  PLI_INT32  bnum_pkt;
+  //PLI_UBYTE8 messageType;
+  PLI_UINT16 secondsMsb ;
+  PLI_UINT32 secondsLsb ;
+  PLI_UINT32 nanoseconds;
+  //PLI_UINT16 sequenceID ;
+  PLI_UINT16 flagField  ;
+  int idx, idy, idz;
+
+  //--------------------Get all handlers
+  systf_handle = vpi_handle(vpiSysTfCall, NULL);
+  tf_ctx       = vpi_tf_ctx_get(systf_handle);
+  if (tf_ctx==NULL) {
+      vpi_printf("ERROR: calloc error.\n");
+      pkt_control(vpiFinish);
+      return(0);
+  }
+
+  H_pkt          = tf_ctx->arg[0];
+  H_bnum_pkt     = tf_ctx->arg[1];
+  H_messageType  = tf_ctx->arg[2];
+  H_flagField       = tf_ctx->arg[3];
+  H_correctionField = tf_ctx->arg[4];
+  H_sourceClockID = tf_ctx->arg[5];
+  H_sourcePortID  = tf_ctx->arg[6];
+  H_sequenceID   = tf_ctx->arg[7];
+  H_secondsField = tf_ctx->arg[8];
+  H_nanoField    = tf_ctx->arg[9];
+
+  GET_WIDE_ARG(H_secondsField)
+  val32 = value.value.vector[0].aval;
+  secondsLsb = val32;
+  val32 = value.value.vector[1].aval;
+  secondsMsb = val32&0xFFFF;
+  GET_INT_ARG(H_nanoField,PLI_UINT32,nanoseconds)
+
+  //--------------------build Ethernet packet
+  ptpv2_msg_hdr_t ptpv2_msg_hdr;
+  uint16_t msg_len;
+  msg_len = msg_ptpv2_header(&ptpv2_msg_hdr
+                            ,H_messageType
+                            ,H_flagField
+                            ,H_correctionField
+                            ,H_sourceClockID
+                            ,H_sourcePortID
+                            ,H_sequenceID);
+  if (msg_len==0) {
+      pkt_control(vpiFinish);
+  }
+
+  uint8_t *ptpv2_msg; // buffer to hold whole PTPV2 message
+  ptpv2_msg = vpi_scratch(VPI_SCRATCH_PKT, msg_len);
+  if (ptpv2_msg==NULL) {
+      vpi_printf("ERROR: scratch buffer error.\n");
+      pkt_control(vpiFinish);
+      return(0);
+  }
+
+  ptpv2_ctx_t *ctx = get_ptpv2_context();
+
+  Timestamp_t time;
+  time.secondsField.msb = secondsMsb;
+  time.secondsField.lsb = secondsLsb;
+  time.nanosecondsField = nanoseconds;
+
+  msg_len = gen_ptpv2_msg[ptpv2_msg_hdr.messageType]( ctx
+                                                    , ptpv2_msg
+                                                    ,&ptpv2_msg_hdr
+                                                    ,&time
+                                                    , NULL);
+  if (msg_len==0) {
+      vpi_printf("something wrong while building PTPv2 header\n");
+      pkt_control(vpiFinish);
+  }
+
+  //--------------------copy all generated contents
+  int tmp=msg_len; // [Need attension]
+  if (pkt_fit_array(tf_ctx,0,tmp,__FUNCTION__)) {
+      pkt_control(vpiFinish);
+      return(0);
+  }
+  PUT_ARRAY_ARG(vpi_tf_ctx_array(tf_ctx,0),0,tmp,ptpv2_msg)
+
+  //--------------------put num of bytes of Ethernet packet
+  if (pkt_put_bnum(H_bnum_pkt, tmp, __FUNCTION__)) pkt_control(vpiFinish);
+
+  return(0);
+}
+
+//----------------------------------------------------------------------------
+// $msg_ptpv2_ethernet ( pkt               [ 7:0][0:1024*4-1]
+//                     , bnum_pkt          [15:0] // num of bytes of the whole message
+//                     , mac_src           [47:0]
+//                     , messageType       [ 3:0]
+//                     , flagField         [15:0]
+//                     , correctionField   [63:0]
+//                     , sourceClockID     [63:0]
+//                     , sourcePortID      [15:0]
+//                     , sequenceID        [15:0]
+//                     , secondsField      [47:0]
+//                     , nanosecondsField  [31:0]
+//                     , reqClockID        [64:0] // PortId(2, MSBytes)+ClockId(8)
+//                     , reqPortID         [15:0] // PortId(2, MSBytes)+ClockId(8)
+//                     , add_crc
+//                     , add_preamble
+//                     )
+//----------------------------------------------------------------------------
+#define TASK_NAME "$msg_ptpv2_ethernet"
+PLI_INT32 msg_ptpv2_eth_Compiletf(PLI_BYTE8 *user_data) {
+  vpiHandle systf_handle, arg_iterator, arg_handle, ele_handle;
+  PLI_INT32 tfarg_type, arg_type;
+  int width;
+  int numA, widthA;
+
+  systf_handle = vpi_handle(vpiSysTfCall, NULL);
+  arg_iterator = vpi_iterate(vpiArgument, systf_handle);
+  if (arg_iterator==NULL) {
+      vpi_printf("ERROR: %s must have 15 arguments.\n", TASK_NAME);
+      pkt_control(vpiFinish);
+  }
+
+  CHECK_ARRAY_ARG("1st", "15", numA, widthA)
+  CHECK_INT_ARG  ("2nd", "15") // bnum pkt
+  CHECK_WIDE_ARG ("3rd", "15", 48) // MAC SRC
+  CHECK_INT_ARG  ("4rd", "15") // message type
+  CHECK_INT_ARG  ("5th", "15") // flagField
+  CHECK_WIDE_ARG ("6th", "15", 64)  // correctionField
+  CHECK_WIDE_ARG ("7th", "15", 64)  // sourcePortIdentify
+  CHECK_INT_ARG  ("8th", "15")  // sourcePortIdentify
+  CHECK_INT_ARG  ("9th", "15") // sequence ID
+  CHECK_WIDE_ARG ("10th","15", 48)  // seconds
+  CHECK_INT_ARG  ("11th","15") // nano
+  CHECK_WIDE_ARG ("12th","15", 64) // reqClockID
+  CHECK_INT_ARG  ("13th","15") // reqClockID
+  CHECK_INT_ARG  ("14th","15") // crc
+  CHECK_INT_ARG  ("15th","15") // preamble
+
+  arg_handle = vpi_scan(arg_iterator);
+  if (arg_handle!=NULL) {
+      vpi_printf("ERROR: %s must have 15 arguments.\n", TASK_NAME);
+      vpi_free_object(arg_iterator);
+      pkt_control(vpiFinish);
+  }
+
+  if (widthA!=8) {
+      vpi_printf("ERROR: %s first argument must be 8-bit array.\n", TASK_NAME);
+      pkt_control(vpiFinish);
+  }
+
+  if (vpi_tf_ctx_build(systf_handle)==NULL) pkt_control(vpiFinish);
+
+  return(0);
+}
+#undef TASK_NAME
+//----------------------------------------------------------------------------
+PLI_INT32 msg_ptpv2_eth_Calltf(PLI_BYTE8 *user_data) {
+  vpiHandle systf_handle;
+  vpi_tf_ctx_t *tf_ctx;
+  vpiHandle H_pkt         ;
+  vpiHandle H_bnum_pkt    ;
+  vpiHandle H_messageType ;
+  vpiHandle H_secondsField;
+  vpiHandle H_nanoField   ;
+  vpiHandle H_sequenceID  ;
+  vpiHandle H_sourceClockID;
+  vpiHandle H_sourcePortID;
+  vpiHandle H_correctionField   ;
+  vpiHandle H_flagField ;
+  vpiHandle H_reqClockID;
+  vpiHandle H_reqPortID ;
+  vpiHandle H_mac_src   ;
+  vpiHandle H_crc     ;
+  vpiHandle H_preamble;
+  s_vpi_value value;
+  PLI_UINT32 val32, val16, val8;
+  PLI_INT32  bnum_pkt   ;
+  //PLI_UBYTE8 messageType;
+  PLI_UINT16 secondsMsb ;
+  PLI_UINT32 secondsLsb ;
+  PLI_UINT32 nanoseconds;
+  //PLI_UINT16 sequenceID ;
+  PLI_UBYTE8 mac_src[6] ;
+  PLI_UINT32 add_crc     ;
+  PLI_UINT32 add_preamble;
+  int idx, idy, idz;
+  uint8_t *ptpv2_msg; // buffer to hold whole Ethernet packet
+  int tmp;
+
+//printf("%s()@%s 0\n", __FUNCTION__, __FILE__); fflush(stdout); vpi_flush();
+  //--------------------Get all handlers
+  systf_handle = vpi_handle(vpiSysTfCall, NULL);
+  tf_ctx       = vpi_tf_ctx_get(systf_handle);
+  if (tf_ctx==NULL) {
+      vpi_printf("ERROR: calloc error.\n");
+      pkt_control(vpiFinish);
+      return(0);
+  }
+
+  H_pkt             = tf_ctx->arg[0];
+  H_bnum_pkt        = tf_ctx->arg[1];
+  H_mac_src         = tf_ctx->arg[2];
+  H_messageType     = tf_ctx->arg[3];
+  H_flagField       = tf_ctx->arg[4];
+  H_correctionField = tf_ctx->arg[5];
+  H_sourceClockID   = tf_ctx->arg[6];
+  H_sourcePortID    = tf_ctx->arg[7];
+  H_sequenceID      = tf_ctx->arg[8];
+  H_secondsField    = tf_ctx->arg[9];
+  H_nanoField       = tf_ctx->arg[10];
+  H_reqClockID      = tf_ctx->arg[11];
+  H_reqPortID       = tf_ctx->arg[12];
+  H_crc             = tf_ctx->arg[13];
+  H_preamble        = tf_ctx->arg[14];
+  
+//printf("%s()@%s 1\n", __FUNCTION__, __FILE__); fflush(stdout); vpi_flush();
+  GET_WIDE_ARG(H_secondsField)
+  val32 = value.value.vector[0].aval;
+  secondsLsb = val32;
+  val32 = value.value.vector[1].aval;
+  secondsMsb = val32&0xFFFF;
+  GET_INT_ARG(H_nanoField,PLI_UINT32,nanoseconds)
+//printf("%s()@%s secondMSB=0x%08X LSB=0x%08X NS=0x%08X\n", __FUNCTION__, __FILE__, secondsMsb, secondsLsb, nanoseconds);
+
+//printf("%s()@%s 2\n", __FUNCTION__, __FILE__); fflush(stdout); vpi_flush();
+  GET_WIDE_ARG(H_mac_src)
+  val32 = value.value.vector[0].aval;
+  mac_src[5] =  val32     &0xFF;
+  mac_src[4] = (val32>> 8)&0xFF;
+  mac_src[3] = (val32>>16)&0xFF;
+  mac_src[2] = (val32>>24)&0xFF;
+  val32 = value.value.vector[1].aval;
+  mac_src[1] =  val32     &0xFF;
+  mac_src[0] = (val32>> 8)&0xFF; // msb
+
+//printf("%s()@%s 3\n", __FUNCTION__, __FILE__); fflush(stdout); vpi_flush();
+  PortIdentity_t reqClockID;
+  GET_WIDE_ARG(H_reqClockID)
+  val32 = value.value.vector[0].aval;
+//printf("%s val32 0x%08X\n", __FUNCTION__, val32);
+  reqClockID.clockIdentity[7] = (val32&0x000000FF);
+  reqClockID.clockIdentity[6] = (val32&0x0000FF00)>>8;
+  reqClockID.clockIdentity[5] = (val32&0x00FF0000)>>16;
+  reqClockID.clockIdentity[4] = (val32&0xFF000000)>>24;
+  val32 = value.value.vector[1].aval;
+//printf("%s val32 0x%08X\n", __FUNCTION__, val32);
+  reqClockID.clockIdentity[3] = (val32&0x000000FF);
+  reqClockID.clockIdentity[2] = (val32&0x0000FF00)>>8;
+  reqClockID.clockIdentity[1] = (val32&0x00FF0000)>>16;
+  reqClockID.clockIdentity[0] = (val32&0xFF000000)>>24;
+
+  GET_INT_ARG(H_reqPortID,PLI_UINT16,val16)
+  reqClockID.portNumber = htons(val16);
+
+  GET_INT_ARG(H_crc,PLI_UINT32,add_crc)
+  GET_INT_ARG(H_preamble,PLI_UINT16,add_preamble)
+
+  //--------------------build Ethernet packet
+  ptpv2_msg_hdr_t ptpv2_msg_hdr;
+  uint16_t msg_len;
+  msg_len = msg_ptpv2_header(&ptpv2_msg_hdr
+                            ,H_messageType
+                            ,H_flagField
+                            ,H_correctionField
+                            ,H_sourceClockID
+                            ,H_sourcePortID
+                            ,H_sequenceID);
+  if (msg_len==0) {
+      vpi_printf("something wrong while building PTPv2 header\n");
+      pkt_control(vpiFinish);
+  }
+
+  msg_len = (add_crc&&(msg_len<(46-m_vlan_num*ETH_VLAN_TAG_LEN))) ? (46-m_vlan_num*ETH_VLAN_TAG_LEN) : msg_len;
+  msg_len += ETH_HDR_LEN+m_vlan_num*ETH_VLAN_TAG_LEN;
+  msg_len += (add_preamble) ? 8 : 0;
+  msg_len += (add_crc     ) ? 4 : 0;
+
+  ptpv2_msg = vpi_scratch(VPI_SCRATCH_PKT, PTPV2_FRAME_MAX);
+  if (ptpv2_msg==NULL) {
+      vpi_printf("ERROR: scratch buffer error.\n");
+      pkt_control(vpiFinish);
+      return(0);
+  }
+
+  ptpv2_ctx_t *ctx = get_ptpv2_context();
+
+  Timestamp_t time;
+  time.secondsField.msb = secondsMsb;
+  time.secondsField.lsb = secondsLsb;
+  time.nanosecondsField = nanoseconds;
+
+  tmp = gen_ptpv2_msg_ethernet_vlan( ctx
+                                   , ptpv2_msg
+                                   , mac_src
+                                   , m_vlan
+                                   , m_vlan_num
+                                   ,&ptpv2_msg_hdr
+                                   ,&time
+                                   ,&reqClockID
+                                   , add_crc
+                                   , add_preamble
+                                   );
+
+#if defined(RIGOR)
+  if (tmp!=msg_len) {
+       vpi_printf("ERROR: %s()@%s whole packet length error %d %d\n", __FUNCTION__, __FILE__, tmp, msg_len);
+  }
+#endif
+
+  //--------------------copy all generated contents
+  if (pkt_fit_array(tf_ctx,0,tmp,__FUNCTION__)) {
+      pkt_control(vpiFinish);
+      return(0);
+  }
+  PUT_ARRAY_ARG(vpi_tf_ctx_array(tf_ctx,0),0,tmp,ptpv2_msg)
+
+  //--------------------put num of bytes of Ethernet packet
+  if (pkt_put_bnum(H_bnum_pkt, tmp, __FUNCTION__)) pkt_control(vpiFinish);
+
+  return(0);
+}
+//----------------------------------------------------------------------------
+// $msg_ptpv2_udp_ip_ethernet ( pkt               [7:0][0:1024*4-1]
+//                            , bnum_pkt          [15:0] // num of bytes of the whole message
+//                            , mac_src           [47:0]
+//                            , ip_src            [31:0]
+//                            , messageType       [ 3:0]
+//                            , flagField         [15:0]
+//                            , correctionField   [63:0]
+//                            , sourceClockID     [63:0]
+//                            , sourcePortID      [15:0]
+//                            , sequenceID        [15:0]
+//                            , secondsField      [47:0]
+//                            , nanosecondsField  [31:0]
+//                            , reqClockID        [63:0]
+//                            , reqPortID         [16:0]
+//                            , add_crc      //
+//                            , add_preamble //
+//                            );
+//----------------------------------------------------------------------------
+#define TASK_NAME "$msg_ptpv2_udp_ip_ethernet"
+PLI_INT32 msg_ptpv2_udp_ip_eth_Compiletf(PLI_BYTE8 *user_data) {
+  vpiHandle systf_handle, arg_iterator, arg_handle, ele_handle;
+  PLI_INT32 tfarg_type, arg_type;
+  int width;
+  int numA, widthA;
+
+  systf_handle = vpi_handle(vpiSysTfCall, NULL);
+  arg_iterator = vpi_iterate(vpiArgument, systf_handle);
+  if (arg_iterator==NULL) {
+      vpi_printf("ERROR: %s must have 16 arguments.\n", TASK_NAME);
+      pkt_control(vpiFinish);
+  }
+
+  CHECK_ARRAY_ARG("1st", "16", numA, widthA)
+  CHECK_INT_ARG  ("2nd", "16") // bnum pkt
+  CHECK_WIDE_ARG ("3rd", "16", 48) // MAC SRC
+  CHECK_INT_ARG  ("4th", "16") // IP SRC
+  CHECK_INT_ARG  ("5th", "16") // message type
+  CHECK_INT_ARG  ("6th", "16") // flagField
+  CHECK_WIDE_ARG ("7th", "16", 64)  // correctionField
+  CHECK_WIDE_ARG ("8th", "16", 64)  // sourcePortIdentify
+  CHECK_INT_ARG  ("9th", "16")  // sourcePortIdentify
+  CHECK_INT_ARG  ("10th","16") // sequence ID
+  CHECK_WIDE_ARG ("11th","16", 48)  // seconds
+  CHECK_INT_ARG  ("12th","16") // nano
+  CHECK_WIDE_ARG ("13th","16", 64) // 
+  CHECK_INT_ARG  ("14th","16") // 
+  CHECK_INT_ARG  ("15th","16") // crc
+  CHECK_INT_ARG  ("16th","16") // preamble
+
+  arg_handle = vpi_scan(arg_iterator);
+  if (arg_handle!=NULL) {
+      vpi_printf("ERROR: %s must have 16 arguments.\n", TASK_NAME);
+      vpi_free_object(arg_iterator);
+      pkt_control(vpiFinish);
+  }
+
+  if (widthA!=8) {
+      vpi_printf("ERROR: %s first argument must be 8-bit array.\n", TASK_NAME);
+      pkt_control(vpiFinish);
+  }
+
+  if (vpi_tf_ctx_build(systf_handle)==NULL) pkt_control(vpiFinish);
+
+  return(0);
+}
+#undef TASK_NAME
+//----------------------------------------------------------------------------
+PLI_INT32 msg_ptpv2_udp_ip_eth_Calltf(PLI_BYTE8 *user_data) {
+  vpiHandle systf_handle;
+  vpi_tf_ctx_t *tf_ctx;
+  vpiHandle H_pkt         ;
+  vpiHandle H_bnum_pkt    ;
+  vpiHandle H_messageType ;
+  vpiHandle H_secondsField;
+  vpiHandle H_nanoField   ;
+  vpiHandle H_sequenceID  ;
+  vpiHandle H_sourceClockID;
+  vpiHandle H_sourcePortID;
+  vpiHandle H_correctionField   ;
+  vpiHandle H_flagField         ;
+  vpiHandle H_reqClockID        ;
+  vpiHandle H_reqPortID        ;
+  vpiHandle H_ip_src      ;
+  vpiHandle H_mac_src     ;
+  vpiHandle H_crc     ;
+  vpiHandle H_preamble;
+  s_vpi_value value;
+  PLI_UINT32 val32, val16, val8;
+  PLI_INT32  bnum_pkt   ;
+  PLI_UBYTE8 messageType;
+  PLI_UINT16 secondsMsb ;
+  PLI_UINT32 secondsLsb ;
+  PLI_UINT32 nanoseconds;
+  PLI_UINT16 sequenceID ;
+  PLI_UINT32 ip_src     ;
+  PLI_UBYTE8 mac_src[6] ;
+  PLI_UINT32 add_crc     ;
+  PLI_UINT32 add_preamble;
+  int idx, idy, idz;
+  uint8_t *ptpv2_msg; // buffer to hold whole Ethernet packet
+  int tmp;
+
+  //--------------------Get all handlers
+  systf_handle = vpi_handle(vpiSysTfCall, NULL);
+  tf_ctx       = vpi_tf_ctx_get(systf_handle);
+  if (tf_ctx==NULL) {
+      vpi_printf("ERROR: calloc error.\n");
+      pkt_control(vpiFinish);
+      return(0);
+  }
+
+  H_pkt          = tf_ctx->arg[0];
+  H_bnum_pkt     = tf_ctx->arg[1];
+  H_mac_src      = tf_ctx->arg[2];
+  H_ip_src       = tf_ctx->arg[3];
+  H_messageType  = tf_ctx->arg[4];
+  H_flagField          = tf_ctx->arg[5];
+  H_correctionField    = tf_ctx->arg[6];
+  H_sourceClockID = tf_ctx->arg[7];
+  H_sourcePortID = tf_ctx->arg[8];
+  H_sequenceID   = tf_ctx->arg[9];
+  H_secondsField = tf_ctx->arg[10];
+  H_nanoField    = tf_ctx->arg[11];
+  H_reqClockID   = tf_ctx->arg[12];
+  H_reqPortID   = tf_ctx->arg[13];
+  H_crc          = tf_ctx->arg[14];
+  H_preamble     = tf_ctx->arg[15];
+  
+  GET_WIDE_ARG(H_secondsField)
+  val32 = value.value.vector[0].aval;
+  secondsLsb = val32;
+  val32 = value.value.vector[1].aval;
   secondsMsb = val32&0xFFFF;
   GET_INT_ARG(H_nanoField,PLI_UINT32,nanoseconds)
-//printf("%s()@%s secondMSB=0x%08X LSB=0x%08X NS=0x%08X\n", __FUNCTION__, __FILE__, secondsMsb, secondsLsb, nanoseconds);
+  GET_INT_ARG(H_sequenceID,PLI_UINT16,sequenceID)
+
+  GET_INT_ARG(H_ip_src,PLI_UINT32,ip_src)
+  GET_WIDE_ARG(H_mac_src)
+  val32 = value.value.vector[0].aval;
+  mac_src[5] =  val32     &0xFF;
+  mac_src[4] = (val32>> 8)&0xFF;
+  mac_src[3] = (val32>>16)&0xFF;
+  mac_src[2] = (val32>>24)&0xFF;
+  val32 = value.value.vector[1].aval;
+  mac_src[1] =  val32     &0xFF;
+  mac_src[0] = (val32>> 8)&0xFF; // msb
+
+  PortIdentity_t reqClockID;
+  GET_WIDE_ARG(H_reqClockID)
+
+  val32 = value.value.vector[0].aval;
+  reqClockID.clockIdentity[7] = (val32&0x000000FF);
+  reqClockID.clockIdentity[6] = (val32&0x0000FF00)>>8;
+  reqClockID.clockIdentity[5] = (val32&0x00FF0000)>>16;
+  reqClockID.clockIdentity[4] = (val32&0xFF000000)>>24;
+
+  val32 = value.value.vector[1].aval;
+  reqClockID.clockIdentity[3] = (val32&0x000000FF);
+  reqClockID.clockIdentity[2] = (val32&0x0000FF00)>>8;
+  reqClockID.clockIdentity[1] = (val32&0x00FF0000)>>16;
+  reqClockID.clockIdentity[0] = (val32&0xFF000000)>>24;
+
+  GET_INT_ARG(H_reqPortID,PLI_UINT16,val16)
+  reqClockID.portNumber = htons(val16);
+
+  GET_INT_ARG(H_crc,PLI_UINT32,add_crc)
+  GET_INT_ARG(H_preamble,PLI_UINT16,add_preamble)
+
+  //--------------------build Ethernet packet
+  ptpv2_msg_hdr_t ptpv2_msg_hdr;
+  uint16_t msg_len;
+  msg_len = msg_ptpv2_header(&ptpv2_msg_hdr
+                            ,H_messageType
+                            ,H_flagField
+                            ,H_correctionField
+                            ,H_sourceClockID
+                            ,H_sourcePortID
+                            ,H_sequenceID);
+  if (msg_len==0) {
+      vpi_printf("something wrong while building PTPv2 header\n");
+      pkt_control(vpiFinish);
+  }
+
+  msg_len = ((UDP_HDR_LEN+IP_HDR_LEN+msg_len)<(46-m_vlan_num*ETH_VLAN_TAG_LEN))
+          ? (46-m_vlan_num*ETH_VLAN_TAG_LEN) : (UDP_HDR_LEN+IP_HDR_LEN+msg_len);
+  msg_len += ETH_HDR_LEN+m_vlan_num*ETH_VLAN_TAG_LEN;
+  msg_len += (add_preamble) ? 8 : 0;
+  msg_len += (add_crc     ) ? 4 : 0;
+
+  ptpv2_msg = vpi_scratch(VPI_SCRATCH_PKT, PTPV2_FRAME_MAX);
+  if (ptpv2_msg==NULL) {
+      vpi_printf("ERROR: scratch buffer error.\n");
+      pkt_control(vpiFinish);
+      return(0);
+  }
+
+  ptpv2_ctx_t *ctx = get_ptpv2_context();
+
+  Timestamp_t time;
+  time.secondsField.msb = secondsMsb;
+  time.secondsField.lsb = secondsLsb;
+  time.nanosecondsField = nanoseconds;
+
+  tmp = gen_ptpv2_msg_udp_ip_ethernet_vlan( ctx
+                                          , ptpv2_msg
+                                          , mac_src
+                                          , m_vlan
+                                          , m_vlan_num
+                                          , ip_src
+                                          ,&ptpv2_msg_hdr
+                                          ,&time
+                                          ,&reqClockID
+                                          , add_crc
+                                          , add_preamble
+                                          );
+#if defined(RIGOR)
+  if (tmp!=msg_len) {
+       vpi_printf("ERROR: %s()@%s whole packet length error %d %d\n", __FUNCTION__, __FILE__, tmp, msg_len);
+  }
+#endif
+
+  //--------------------copy all generated contents
+  if (pkt_fit_array(tf_ctx,0,tmp,__FUNCTION__)) {
+      pkt_control(vpiFinish);
+      return(0);
+  }
+  PUT_ARRAY_ARG(vpi_tf_ctx_array(tf_ctx,0),0,tmp,ptpv2_msg)
+
+  //--------------------put num of bytes of Ethernet packet
+  if (pkt_put_bnum(H_bnum_pkt, tmp, __FUNCTION__)) pkt_control(vpiFinish);
+
+  return(0);
+}
+
+//----------------------------------------------------------------------------
+// $pkt_ethernet_parser( pkt     [ 7:0][0:1024*4-1]
+//                     , bnum_pkt[15:0]
+//                     , crc   
+//                     , preamble
+//                     );
+//----------------------------------------------------------------------------
+#define TASK_NAME "$pkt_ethernet_parser"
+PLI_INT32 pkt_eth_parser_Compiletf(PLI_BYTE8 *user_data) {
+  vpiHandle systf_handle, arg_iterator, arg_handle, ele_handle;
+  PLI_INT32 tfarg_type, arg_type;
+  int width;
+  int numA, widthA;
+
+  systf_handle = vpi_handle(vpiSysTfCall, NULL);
+  arg_iterator = vpi_iterate(vpiArgument, systf_handle);
+  if (arg_iterator==NULL) {
+      vpi_printf("ERROR: %s must have four arguments.\n", TASK_NAME);
+      pkt_control(vpiFinish);
+  }
+
+  CHECK_ARRAY_ARG("1st", "four", numA, widthA)
+  CHECK_INT_ARG  ("2nd", "four") // bnum_pkt
+  CHECK_INT_ARG  ("3rd", "four") // crc
+  CHECK_INT_ARG  ("4th", "four") // preamble
+
+  arg_handle = vpi_scan(arg_iterator);
+  if (arg_handle!=NULL) {
+      vpi_printf("ERROR: %s must have four arguments.\n", TASK_NAME);
+      vpi_free_object(arg_iterator);
+      pkt_control(vpiFinish);
+  }
+
+  if (widthA!=8) {
+      vpi_printf("ERROR: %s first argument must be 8-bit array.\n", TASK_NAME);
+      pkt_control(vpiFinish);
+  }
+
+  if (vpi_tf_ctx_build(systf_handle)==NULL) pkt_control(vpiFinish);
+
+  return(0);
+}
+#undef TASK_NAME
+//----------------------------------------------------------------------------
+// IPv4 reassembly of $pkt_ethernet_parser, which is made at the first use.
+static pkt_reasm_t *m_reasm=NULL;
+
+#define PKT_REASM_FLOWS   1024
+#define PKT_REASM_BYTES   (16*1024*1024)
+#define PKT_REASM_TIMEOUT 15 // in seconds as RFC 791 suggests
+
+// It returns PKT_REASM_TIMEOUT in simulation precision.
+static uint64_t pkt_reasm_timeout(void)
+{
+  uint64_t timeout = PKT_REASM_TIMEOUT;
+  int prec = vpi_get(vpiTimePrecision, NULL); // e.g., -12 for 1ps
+  for (; prec<0; prec++) timeout *= 10;
+  return timeout;
+}
+
+static pkt_reasm_t *pkt_reasm_get(void)
+{
+  if (m_reasm==NULL) m_reasm = pkt_reasm_create(PKT_REASM_FLOWS, PKT_REASM_BYTES
+                                                , pkt_reasm_timeout());
+  return m_reasm;
+}
+
+//----------------------------------------------------------------------------
+// It returns simulation time in simulation precision.
+static uint64_t pkt_sim_time(void)
+{
+  s_vpi_time sim_time;
+  sim_time.type = vpiSimTime;
+  vpi_get_time(NULL, &sim_time);
+  return ((uint64_t)sim_time.high<<32)|sim_time.low;
+}
+
+//----------------------------------------------------------------------------
+PLI_INT32 pkt_eth_parser_Calltf(PLI_BYTE8 *user_data) {
+  vpiHandle systf_handle;
+  vpi_tf_ctx_t *tf_ctx;
+  vpiHandle H_pkt     ;
+  vpiHandle H_bnum_pkt;
+  vpiHandle H_crc     ;
+  vpiHandle H_preamble;
+  s_vpi_value value;
+  PLI_UINT32 val32, val8;
+  PLI_INT32  leng;
+  PLI_UINT32 crc ;
+  PLI_UINT32 preamble ;
+  int idx, idy, idz;
+  uint8_t *eth_pkt; // buffer to hold whole Ethernet packet
+  uint16_t type_leng;
+  int hdr_len; // Ethernet header including VLAN tags
+  int tmp;
+
+  //--------------------Get all handlers
+  systf_handle = vpi_handle(vpiSysTfCall, NULL);
+  tf_ctx       = vpi_tf_ctx_get(systf_handle);
+  if (tf_ctx==NULL) {
+      vpi_printf("ERROR: calloc error.\n");
+      pkt_control(vpiFinish);
+      return(0);
+  }
+  H_pkt        = tf_ctx->arg[0];
+  H_bnum_pkt   = tf_ctx->arg[1];
+  H_crc        = tf_ctx->arg[2];
+  H_preamble   = tf_ctx->arg[3];
+
+  //--------------------Get all values
+  GET_INT_ARG(H_bnum_pkt,PLI_INT32 ,leng    )
+  GET_INT_ARG(H_crc     ,PLI_UINT32,crc     )
+  GET_INT_ARG(H_preamble,PLI_UINT32,preamble)
+  if (pkt_fit_array(tf_ctx,0,leng,__FUNCTION__)) {
+      pkt_control(vpiFinish);
+      return(0);
+  }
+  //--------------------parsing
+  eth_pkt = vpi_scratch(VPI_SCRATCH_PKT, leng);
+  if (eth_pkt==NULL) {
+      vpi_printf("ERROR: scratch buffer error.\n");
+      pkt_control(vpiFinish);
+      return(0);
+  }
+  GET_ARRAY_ARG(vpi_tf_ctx_array(tf_ctx,0),0,leng,eth_pkt)
+  //--------------------parsing
+  idx = 0;
+  if (preamble&(leng>=8)) {
+      //vpi_printf("preamble: 0x");
+      //for (idy=0; idy<8; idy++) vpi_printf("%02X",eth_pkt[idy]);
+      //vpi_printf("\n");
+      idx = 8;
+  }
+  if (crc&&(leng>=(idx+4))) leng -= 4; // FCS is not parsed
+  parser_eth_packet(&eth_pkt[idx], leng-idx);
+  hdr_len = get_eth_type(&eth_pkt[idx], leng-idx, &type_leng);
+  if (hdr_len<0) goto end;
+  //if (leng>=(idx+6)) {
+  //    vpi_printf("mac dst  : 0x");
+  //    for (idy=0; idy<6; idy++) vpi_printf("%02X",eth_pkt[idx++]);
+  //    vpi_printf("\n");
+  //} else goto end;
+  //if (leng>=(idx+6)) {
+  //    vpi_printf("mac src  : 0x");
+  //    for (idy=0; idy<6; idy++) vpi_printf("%02X",eth_pkt[idx++]);
+  //    vpi_printf("\n");
+  //} else goto end;
+  //if (leng>=(idx+2)) {
+  //    type_leng  = eth_pkt[idx++]<<8;
+  //    type_leng |= eth_pkt[idx++];
+  //    vpi_printf("type leng: 0x%04X", type_leng);
+  //    switch (type_leng) {
+  //    case 0x0800: vpi_printf(" IPv4  packet\n"); break;
+  //    case 0x0806: vpi_printf(" ARP   packet\n"); break;
+  //    case 0x86DD: vpi_printf(" IPv6  packet\n"); break;
+  //    case 0x8100: vpi_printf(" VLAN  packet\n"); break;
+  //    case 0x88F7: vpi_printf(" PTPv2 raw packet\n"); break;
+  //    default:     vpi_printf("\n"); break;
+  //    }
+  //} else goto end;
+  if ((type_leng==0x0800)&&(leng>=(idx+hdr_len+IP_HDR_LEN))) { // IP packet
+      const uint8_t *ip = &eth_pkt[idx+hdr_len];
+      tmp = leng-idx-hdr_len;
+      if ((ip[6]&0x3F)||ip[7]) { // fragment, i.e., MF or offset
+          tmp = pkt_reasm_put(pkt_reasm_get(), ip, tmp, pkt_sim_time(), &ip);
+          if (tmp>0) {
+              vpi_flush(); vpi_printf("IP datagram reassembled %d bytes\n", tmp);
+              fflush(stderr); fflush(stdout);
+              parser_ip_packet((uint8_t*)ip, tmp);
+              fflush(stderr); fflush(stdout);
+          }
+      }
+      if ((tmp>=28)&&(ip[9]==0x11)) { // UDP
+          uint16_t port_src  = ip[20]<<8;
+                   port_src |= ip[21];
+          uint16_t port_dst  = ip[22]<<8;
+                   port_dst |= ip[23];
+          if ((port_src==319)||(port_src==320)||
+              (port_dst==319)||(port_dst==320)) {
+             vpi_flush(); vpi_printf("\n");
+             fflush(stderr); fflush(stdout);
+             parser_ptpv2_message((uint8_t*)&ip[28],tmp-28);
+             fflush(stderr); fflush(stdout);
+          }
+      }
+  }
+  if (type_leng==0x88F7) { // PTPv2 raw packet
+      vpi_flush(); vpi_printf("\n");
+      fflush(stderr); fflush(stdout);
+      parser_ptpv2_message(&eth_pkt[idx+hdr_len],leng-idx-hdr_len);
+      fflush(stderr); fflush(stdout);
+  }
+
+  //--------------------return
+end:
+  return(0);
+}
+
+//----------------------------------------------------------------------------
+// $pkt_ip_reassembly( max_flows    // num of datagrams in reassembly
+//                   , max_bytes    // num of bytes kept for all of them
+//                   , timeout[63:0]// in simulation precision; 0 for no timeout
+//                   );
+// Datagrams in reassembly are dropped.
+// Without it, 1024 flows of 16 MiB with 15 sec of simulation time
+// for timeout are used.
+//----------------------------------------------------------------------------
+#define TASK_NAME "$pkt_ip_reassembly"
+PLI_INT32 pkt_ip_reassembly_Compiletf(PLI_BYTE8 *user_data) {
+  vpiHandle systf_handle, arg_iterator, arg_handle;
+  PLI_INT32 tfarg_type, arg_type;
+
+  systf_handle = vpi_handle(vpiSysTfCall, NULL);
+  arg_iterator = vpi_iterate(vpiArgument, systf_handle);
+  if (arg_iterator==NULL) {
+      vpi_printf("ERROR: %s must have three arguments.\n", TASK_NAME);
+      pkt_control(vpiFinish);
+  }
+
+  CHECK_INT_ARG  ("1st", "three") // max flows
+  CHECK_INT_ARG  ("2nd", "three") // max bytes
+  CHECK_INT_ARG  ("3rd", "three") // timeout
+
+  arg_handle = vpi_scan(arg_iterator);
+  if (arg_handle!=NULL) {
+      vpi_printf("ERROR: %s must have three arguments.\n", TASK_NAME);
+      vpi_free_object(arg_iterator);
+      pkt_control(vpiFinish);
+  }
+
+  if (vpi_tf_ctx_build(systf_handle)==NULL) pkt_control(vpiFinish);
+
+  return(0);
+}
+#undef TASK_NAME
+//----------------------------------------------------------------------------
+PLI_INT32 pkt_ip_reassembly_Calltf(PLI_BYTE8 *user_data) {
+  vpiHandle systf_handle;
+  vpi_tf_ctx_t *tf_ctx;
+  s_vpi_value value;
+  PLI_INT32 max_flows;
+  PLI_INT32 max_bytes;
+  uint64_t  timeout;
+
+  systf_handle = vpi_handle(vpiSysTfCall, NULL);
+  tf_ctx       = vpi_tf_ctx_get(systf_handle);
+  if (tf_ctx==NULL) {
+      vpi_printf("ERROR: calloc error.\n");
+      pkt_control(vpiFinish);
+      return(0);
+  }
+  GET_INT_ARG(tf_ctx->arg[0],PLI_INT32,max_flows)
+  GET_INT_ARG(tf_ctx->arg[1],PLI_INT32,max_bytes)
+  GET_WIDE_ARG(tf_ctx->arg[2])
+  timeout = value.value.vector[0].aval;
+  if (vpi_get(vpiSize, tf_ctx->arg[2])>32)
+      timeout |= (uint64_t)value.value.vector[1].aval<<32;
+
+  pkt_reasm_release(m_reasm);
+  m_reasm = pkt_reasm_create(max_flows, max_bytes, timeout);
+  if (m_reasm==NULL) {
+      vpi_printf("ERROR: %s() %d flows of %d bytes.\n", __FUNCTION__, max_flows, max_bytes);
+      pkt_control(vpiFinish);
+  }
+  return(0);
+}
+
+//----------------------------------------------------------------------------
+// $pkt_tcp_stream( pkt     [ 7:0][0:1024*4-1] // Ethernet frame
+//                , bnum_pkt[15:0]
+//                , preamble
+//                , data    [ 7:0][0:1024*64-1] // bytes delivered in order
+//                , bnum_data[31:0] // num of bytes of 'data'
+//                );
+// A connection is a direction of (ip_src, ip_dst, port_src, port_dst),
+// which starts at SYN or at the first segment seen. IPv4 fragments go
+// through reassembly of its own first, so that a frame can be given to
+// $pkt_ethernet_parser as well.
+//----------------------------------------------------------------------------
+#define TASK_NAME "$pkt_tcp_stream"
+PLI_INT32 pkt_tcp_stream_Compiletf(PLI_BYTE8 *user_data) {
+  vpiHandle systf_handle, arg_iterator, arg_handle, ele_handle;
+  PLI_INT32 tfarg_type, arg_type;
+  int numA, widthA;
+  int numB, widthB;
+
+  systf_handle = vpi_handle(vpiSysTfCall, NULL);
+  arg_iterator = vpi_iterate(vpiArgument, systf_handle);
+  if (arg_iterator==NULL) {
+      vpi_printf("ERROR: %s must have five arguments.\n", TASK_NAME);
+      pkt_control(vpiFinish);
+  }
+
+  CHECK_ARRAY_ARG("1st", "five", numA, widthA) // ethernet pkt
+  CHECK_INT_ARG  ("2nd", "five") // bnum_pkt
+  CHECK_INT_ARG  ("3rd", "five") // preamble
+  CHECK_ARRAY_ARG("4th", "five", numB, widthB) // data
+  CHECK_INT_ARG  ("5th", "five") // bnum_data
+
+  arg_handle = vpi_scan(arg_iterator);
+  if (arg_handle!=NULL) {
+      vpi_printf("ERROR: %s must have five arguments.\n", TASK_NAME);
+      vpi_free_object(arg_iterator);
+      pkt_control(vpiFinish);
+  }
+
+  if (widthA!=8) {
+      vpi_printf("ERROR: %s first argument must be 8-bit array.\n", TASK_NAME);
+      pkt_control(vpiFinish);
+  }
+  if (widthB!=8) {
+      vpi_printf("ERROR: %s fourth argument must be 8-bit array.\n", TASK_NAME);
+      pkt_control(vpiFinish);
+  }
+
+  if (vpi_tf_ctx_build(systf_handle)==NULL) pkt_control(vpiFinish);
+
+  return(0);
+}
+#undef TASK_NAME
+//----------------------------------------------------------------------------
+// TCP stream reassembly of $pkt_tcp_stream, which is made at the first use
+// along with IPv4 reassembly apart from that of $pkt_ethernet_parser.
+static pkt_stream_t *m_stream=NULL;
+static pkt_reasm_t  *m_stream_reasm=NULL;
+static int m_stream_num=0; // num of bytes delivered by the current segment
+
+#define PKT_STREAM_CONNS  65536
+#define PKT_STREAM_BYTES  (64*1024*1024)
+#define PKT_STREAM_WINDOW 65535
+
+// It gathers bytes delivered in order to the payload scratch buffer.
+static void pkt_stream_deliver(void *user, pkt_stream_conn_t *conn, const uint8_t *data, int num)
+{
+  uint8_t *buf;
+  if (num<=0) return;
+  buf = vpi_scratch(VPI_SCRATCH_PAYLOAD, m_stream_num+num);
+  if (buf==NULL) return;
+  memcpy((void*)&buf[m_stream_num], (const void*)data, num);
+  m_stream_num += num;
+}
+
+static pkt_stream_t *pkt_stream_get(void)
+{
+  if (m_stream_reasm==NULL) m_stream_reasm = pkt_reasm_create(PKT_REASM_FLOWS, PKT_REASM_BYTES
+                                                              , pkt_reasm_timeout());
+  if (m_stream_reasm==NULL) return NULL;
+  if (m_stream==NULL) m_stream = pkt_stream_create(PKT_STREAM_CONNS, PKT_STREAM_BYTES
+                                                  , PKT_STREAM_WINDOW, pkt_stream_deliver, NULL);
+  return m_stream;
+}
+
+static void pkt_stream_cleanup(void)
+{
+  pkt_stream_release(m_stream);
+  pkt_reasm_release(m_stream_reasm);
+  m_stream       = NULL;
+  m_stream_reasm = NULL;
+}
+
+//----------------------------------------------------------------------------
+PLI_INT32 pkt_tcp_stream_Calltf(PLI_BYTE8 *user_data) {
+  vpiHandle systf_handle;
+  vpi_tf_ctx_t *tf_ctx;
+  s_vpi_value value;
+  PLI_INT32  leng;
+  PLI_UINT32 preamble;
+  const uint8_t *ip;
+  uint8_t *eth_pkt;
+  uint16_t type_leng;
+  int idx, hdr_len, tmp;
+
+  systf_handle = vpi_handle(vpiSysTfCall, NULL);
+  tf_ctx       = vpi_tf_ctx_get(systf_handle);
+  if (tf_ctx==NULL) {
+      vpi_printf("ERROR: calloc error.\n");
+      pkt_control(vpiFinish);
+      return(0);
+  }
+  GET_INT_ARG(tf_ctx->arg[1],PLI_INT32 ,leng    )
+  GET_INT_ARG(tf_ctx->arg[2],PLI_UINT32,preamble)
+  if (pkt_fit_array(tf_ctx,0,leng,__FUNCTION__)) {
+      pkt_control(vpiFinish);
+      return(0);
+  }
+  eth_pkt = vpi_scratch(VPI_SCRATCH_PKT, leng);
+  if ((eth_pkt==NULL)||(pkt_stream_get()==NULL)) {
+      vpi_printf("ERROR: scratch buffer error.\n");
+      pkt_control(vpiFinish);
+      return(0);
+  }
+  GET_ARRAY_ARG(vpi_tf_ctx_array(tf_ctx,0),0,leng,eth_pkt)
+
+  //--------------------reassembly
+  m_stream_num = 0;
+  idx = (preamble&&(leng>=8)) ? 8 : 0;
+  hdr_len = get_eth_type(&eth_pkt[idx], leng-idx, &type_leng); // VLAN tags skipped
+  if ((hdr_len>0)&&(leng>=(idx+hdr_len+IP_HDR_LEN))&&
+      (type_leng==ETH_TYPE_IP)) { // IP packet
+      ip  = &eth_pkt[idx+hdr_len];
+      tmp = leng-idx-hdr_len;
+      if ((ip[6]&0x3F)||ip[7]) { // fragment, i.e., MF or offset
+          tmp = pkt_reasm_put(m_stream_reasm, ip, tmp, pkt_sim_time(), &ip);
+      }
+      if ((tmp>0)&&(ip[9]==IP_PROTO_TCP)) pkt_stream_put(m_stream, ip, tmp);
+  }
+
+  //--------------------return
+  if (pkt_fit_array(tf_ctx,3,m_stream_num,__FUNCTION__)) {
+      pkt_control(vpiFinish);
+      return(0);
+  }
+  if (m_stream_num>0) {
+      PUT_ARRAY_ARG(vpi_tf_ctx_array(tf_ctx,3),0,m_stream_num,vpi_scratch(VPI_SCRATCH_PAYLOAD, m_stream_num))
+  }
+  if (pkt_put_bnum(tf_ctx->arg[4], m_stream_num, __FUNCTION__)) pkt_control(vpiFinish);
+  return(0);
+}
+
+//----------------------------------------------------------------------------
+// $pkt_tcp_stream_stat( ip_src   [31:0]
+//                     , ip_dst   [31:0]
+//                     , port_src [15:0]
+//                     , port_dst [15:0]
+//                     , delivered   // num of bytes delivered in order
+//                     , retransmits // num of segments retransmitted
+//                     , gaps        // num of segments arrived beyond a hole
+//                     , window_violations // num of segments beyond window
+//                     );
+// Counters are -1 when the connection is not found.
+//----------------------------------------------------------------------------
+#define TASK_NAME "$pkt_tcp_stream_stat"
+PLI_INT32 pkt_tcp_stream_stat_Compiletf(PLI_BYTE8 *user_data) {
+  vpiHandle systf_handle, arg_iterator, arg_handle;
+  PLI_INT32 tfarg_type, arg_type;
+
+  systf_handle = vpi_handle(vpiSysTfCall, NULL);
+  arg_iterator = vpi_iterate(vpiArgument, systf_handle);
+  if (arg_iterator==NULL) {
+      vpi_printf("ERROR: %s must have eight arguments.\n", TASK_NAME);
+      pkt_control(vpiFinish);
+  }
+
+  CHECK_INT_ARG  ("1st", "eight") // SRC IP
+  CHECK_INT_ARG  ("2nd", "eight") // DST IP
+  CHECK_INT_ARG  ("3rd", "eight") // SRC port
+  CHECK_INT_ARG  ("4th", "eight") // DST port
+  CHECK_INT_ARG  ("5th", "eight") // delivered
+  CHECK_INT_ARG  ("6th", "eight") // retransmits
+  CHECK_INT_ARG  ("7th", "eight") // gaps
+  CHECK_INT_ARG  ("8th", "eight") // window violations
+
+  arg_handle = vpi_scan(arg_iterator);
+  if (arg_handle!=NULL) {
+      vpi_printf("ERROR: %s must have eight arguments.\n", TASK_NAME);
+      vpi_free_object(arg_iterator);
+      pkt_control(vpiFinish);
+  }
+
+  if (vpi_tf_ctx_build(systf_handle)==NULL) pkt_control(vpiFinish);
+
+  return(0);
+}
+#undef TASK_NAME
+//----------------------------------------------------------------------------
+PLI_INT32 pkt_tcp_stream_stat_Calltf(PLI_BYTE8 *user_data) {
+  vpiHandle systf_handle;
+  vpi_tf_ctx_t *tf_ctx;
+  s_vpi_value value;
+  PLI_UINT32 ip_src;
+  PLI_UINT32 ip_dst;
+  PLI_UINT32 port_src;
+  PLI_UINT32 port_dst;
+  pkt_stream_conn_t *conn;
+
+  systf_handle = vpi_handle(vpiSysTfCall, NULL);
+  tf_ctx       = vpi_tf_ctx_get(systf_handle);
+  if (tf_ctx==NULL) {
+      vpi_printf("ERROR: calloc error.\n");
+      pkt_control(vpiFinish);
+      return(0);
+  }
+  GET_INT_ARG(tf_ctx->arg[0],PLI_UINT32,ip_src  )
+  GET_INT_ARG(tf_ctx->arg[1],PLI_UINT32,ip_dst  )
+  GET_INT_ARG(tf_ctx->arg[2],PLI_UINT32,port_src)
+  GET_INT_ARG(tf_ctx->arg[3],PLI_UINT32,port_dst)
+  conn = pkt_stream_find(m_stream, ip_src, ip_dst, (uint16_t)port_src, (uint16_t)port_dst);
+  PUT_INT_ARG(tf_ctx->arg[4],PLI_INT32,(conn==NULL) ? -1 : (PLI_INT32)conn->delivered)
+  PUT_INT_ARG(tf_ctx->arg[5],PLI_INT32,(conn==NULL) ? -1 : (PLI_INT32)conn->retransmits)
+  PUT_INT_ARG(tf_ctx->arg[6],PLI_INT32,(conn==NULL) ? -1 : (PLI_INT32)conn->gaps)
+  PUT_INT_ARG(tf_ctx->arg[7],PLI_INT32,(conn==NULL) ? -1 : (PLI_INT32)conn->window_violations)
+  return(0);
+}
+
+//----------------------------------------------------------------------------
+// $pkt_vlan( vlan_num     // num of tags, 0 for untagged
+//          , tag_outer[31:0] // {TPID,TCI}, e.g., {16'h88A8,3'pcp,1'dei,12'vid}
+//          , tag_inner[31:0] // {TPID,TCI}, e.g., {16'h8100,3'pcp,1'dei,12'vid}
+//          );
+// 'tag_outer' is the only tag when 'vlan_num' is 1.
+//----------------------------------------------------------------------------
+#define TASK_NAME "$pkt_vlan"
+PLI_INT32 pkt_vlan_Compiletf(PLI_BYTE8 *user_data) {
+  vpiHandle systf_handle, arg_iterator, arg_handle;
+  PLI_INT32 arg_type;
+
+  systf_handle = vpi_handle(vpiSysTfCall, NULL);
+  arg_iterator = vpi_iterate(vpiArgument, systf_handle);
+  if (arg_iterator==NULL) {
+      vpi_printf("ERROR: %s must have three arguments.\n", TASK_NAME);
+      pkt_control(vpiFinish);
+  }
+
+  CHECK_INT_ARG  ("1st", "three") // num of tags
+  CHECK_INT_ARG  ("2nd", "three") // outer tag
+  CHECK_INT_ARG  ("3rd", "three") // inner tag
+
+  arg_handle = vpi_scan(arg_iterator);
+  if (arg_handle!=NULL) {
+      vpi_printf("ERROR: %s must have three arguments.\n", TASK_NAME);
+      vpi_free_object(arg_iterator);
+      pkt_control(vpiFinish);
+  }
+
+  if (vpi_tf_ctx_build(systf_handle)==NULL) pkt_control(vpiFinish);
+
+  return(0);
+}
+#undef TASK_NAME
+//----------------------------------------------------------------------------
+PLI_INT32 pkt_vlan_Calltf(PLI_BYTE8 *user_data) {
+  vpiHandle systf_handle;
+  vpi_tf_ctx_t *tf_ctx;
+  s_vpi_value value;
+  PLI_INT32  vlan_num;
+  PLI_UINT32 tag[PKT_VLAN_MAX];
+  int idx;
+
+  systf_handle = vpi_handle(vpiSysTfCall, NULL);
+  tf_ctx       = vpi_tf_ctx_get(systf_handle);
+  if (tf_ctx==NULL) {
+      vpi_printf("ERROR: calloc error.\n");
+      pkt_control(vpiFinish);
+      return(0);
+  }
+  GET_INT_ARG(tf_ctx->arg[0],PLI_INT32 ,vlan_num)
+  GET_INT_ARG(tf_ctx->arg[1],PLI_UINT32,tag[0])
+  GET_INT_ARG(tf_ctx->arg[2],PLI_UINT32,tag[1])
+  if ((vlan_num<0)||(vlan_num>PKT_VLAN_MAX)) {
+      vpi_printf("ERROR: %s() %d tags, but up to %d.\n", __FUNCTION__, vlan_num, PKT_VLAN_MAX);
+      pkt_control(vpiFinish);
+      return(0);
+  }
+  for (idx=0; idx<PKT_VLAN_MAX; idx++) {
+       m_vlan[idx].tpid = (tag[idx]>>16)&0xFFFF;
+       m_vlan[idx].tci  =  tag[idx]     &0xFFFF;
+  }
+  m_vlan_num = vlan_num;
+  return(0);
+}
+
+//----------------------------------------------------------------------------
+// $pkt_udp_ipv6_ethernet( pkt     [7:0][0:4095]
+//                       , bnum_pkt[15:0] // num of bytes of the whole packet
+//                       , port_src[15:0]
+//                       , port_dst[15:0]
+//                       , ip_src  [127:0]
+//                       , ip_dst  [127:0]
+//                       , hop_limit[7:0]
+//                       , mac_src [47:0]
+//                       , mac_dst [47:0]
+//                       , bnum_payload[15:0] // num of bytes of payload
+//                       , payload [7:0][0:4095]
+//                       , add_crc      //
+//                       , add_preamble //
+//                       );
+// $pkt_tcp_ipv6_ethernet( pkt     [7:0][0:4095]
+//                       , bnum_pkt[15:0] // num of bytes of the whole packet
+//                       , port_src[15:0]
+//                       , port_dst[15:0]
+//                       , seq_num [31:0]
+//                       , ack_num [31:0]
+//                       , ip_src  [127:0]
+//                       , ip_dst  [127:0]
+//                       , hop_limit[7:0]
+//                       , mac_src [47:0]
+//                       , mac_dst [47:0]
+//                       , bnum_payload[15:0] // num of bytes of payload
+//                       , payload [7:0][0:4095]
+//                       , add_crc      //
+//                       , add_preamble //
+//                       );
+//----------------------------------------------------------------------------
+#define TASK_NAME ((tcp) ? "$pkt_tcp_ipv6_ethernet" : "$pkt_udp_ipv6_ethernet")
+static PLI_INT32 pkt_ipv6_eth_Compiletf(int tcp) {
+  vpiHandle systf_handle, arg_iterator, arg_handle, ele_handle;
+  PLI_INT32 tfarg_type, arg_type;
+  int width;
+  int numA, widthA;
+  int numB, widthB;
+  const char *num = (tcp) ? "15" : "13";
+
+  systf_handle = vpi_handle(vpiSysTfCall, NULL);
+  arg_iterator = vpi_iterate(vpiArgument, systf_handle);
+  if (arg_iterator==NULL) {
+      vpi_printf("ERROR: %s must have %s arguments.\n", TASK_NAME, num);
+      pkt_control(vpiFinish);
+  }
+
+  CHECK_ARRAY_ARG("1st", num, numA, widthA) // ethernet pkt
+  CHECK_INT_ARG  ("2nd", num              ) // bnum pkt
+  CHECK_INT_ARG  ("3rd", num              ) // SRC port
+  CHECK_INT_ARG  ("4th", num              ) // DST port
+  if (tcp) {
+  CHECK_INT_ARG  ("5th", num              ) // SEQ num
+  CHECK_INT_ARG  ("6th", num              ) // ACK num
+  }
+  CHECK_WIDE_ARG ("SRC IP", num, 128      ) // SRC IP
+  CHECK_WIDE_ARG ("DST IP", num, 128      ) // DST IP
+  CHECK_INT_ARG  ("hop limit", num        ) // hop limit
+  CHECK_WIDE_ARG ("SRC MAC", num, 48      ) // SRC MAC
+  CHECK_WIDE_ARG ("DST MAC", num, 48      ) // DST MAC
+  CHECK_WIDE_ARG ("bnum payload", num, 16 ) // bnum payload
+  CHECK_ARRAY_ARG("payload", num, numB, widthB) // payload
+  CHECK_INT_ARG  ("add crc", num          ) // add crc
+  CHECK_INT_ARG  ("add preamble", num     ) // add preamble
+
+  arg_handle = vpi_scan(arg_iterator);
+  if (arg_handle!=NULL) {
+      vpi_printf("ERROR: %s must have %s arguments.\n", TASK_NAME, num);
+      vpi_free_object(arg_iterator);
+      pkt_control(vpiFinish);
+  }
+
+  if (widthA!=8) {
+      vpi_printf("ERROR: %s first argument must be 8-bit array.\n", TASK_NAME);
+      pkt_control(vpiFinish);
+  }
+  if (widthB!=8) {
+      vpi_printf("ERROR: %s payload argument must be 8-bit array.\n", TASK_NAME);
+      pkt_control(vpiFinish);
+  }
+
+  if (vpi_tf_ctx_build(systf_handle)==NULL) pkt_control(vpiFinish);
+
+  return(0);
+}
+#undef TASK_NAME
+PLI_INT32 pkt_udp_ipv6_eth_Compiletf(PLI_BYTE8 *user_data) {
+  return pkt_ipv6_eth_Compiletf(0);
+}
+PLI_INT32 pkt_tcp_ipv6_eth_Compiletf(PLI_BYTE8 *user_data) {
+  return pkt_ipv6_eth_Compiletf(1);
+}
+//----------------------------------------------------------------------------
+// It reads 128-bit IPv6 address; ip[0] is the msb.
+static void pkt_get_ipv6(vpiHandle H_ip, PLI_UBYTE8 ip[16])
+{
+  s_vpi_value value;
+  PLI_UINT32 val32;
+  int idx;
+  GET_WIDE_ARG(H_ip)
+  for (idx=0; idx<4; idx++) {
+       val32 = value.value.vector[3-idx].aval;
+       ip[idx*4  ] = (val32>>24)&0xFF;
+       ip[idx*4+1] = (val32>>16)&0xFF;
+       ip[idx*4+2] = (val32>> 8)&0xFF;
+       ip[idx*4+3] =  val32     &0xFF;
+  }
+}
+//----------------------------------------------------------------------------
+// Arguments of TCP have SEQ and ACK numbers after ports, i.e., 'off' is 2.
+static PLI_INT32 pkt_ipv6_eth_Calltf(int tcp) {
+  vpiHandle systf_handle;
+  vpi_tf_ctx_t *tf_ctx;
+  s_vpi_value value;
+  PLI_UINT16 port_src;
+  PLI_UINT16 port_dst;
+  PLI_UINT32 seq_num=0;
+  PLI_UINT32 ack_num=0;
+  PLI_UBYTE8 ip_src[16];
+  PLI_UBYTE8 ip_dst[16];
+  PLI_UBYTE8 hop_limit;
+  PLI_UBYTE8 mac_src[6];
+  PLI_UBYTE8 mac_dst[6];
+  PLI_INT32  bnum_payload;
+  PLI_UINT32 add_crc;
+  PLI_UINT32 add_preamble;
+  uint8_t *eth_pkt; // buffer to hold whole packet
+  uint8_t *payload; // buffer to hold payload data
+  int off = (tcp) ? 2 : 0;
+  int hdr = (tcp) ? TCP_HDR_LEN : UDP_HDR_LEN;
+  int tmp;
+
+  //--------------------Get all handlers
+  systf_handle = vpi_handle(vpiSysTfCall, NULL);
+  tf_ctx       = vpi_tf_ctx_get(systf_handle);
+  if (tf_ctx==NULL) {
+      vpi_printf("ERROR: calloc error.\n");
+      pkt_control(vpiFinish);
+      return(0);
+  }
+  GET_INT_ARG(tf_ctx->arg[2],PLI_UINT16,port_src)
+  GET_INT_ARG(tf_ctx->arg[3],PLI_UINT16,port_dst)
+  if (tcp) {
+      GET_INT_ARG(tf_ctx->arg[4],PLI_UINT32,seq_num)
+      GET_INT_ARG(tf_ctx->arg[5],PLI_UINT32,ack_num)
+  }
+  pkt_get_ipv6(tf_ctx->arg[off+4], ip_src);
+  pkt_get_ipv6(tf_ctx->arg[off+5], ip_dst);
+  GET_INT_ARG(tf_ctx->arg[off+6],PLI_UBYTE8,hop_limit)
+  pkt_get_mac(tf_ctx->arg[off+7], mac_src);
+  pkt_get_mac(tf_ctx->arg[off+8], mac_dst);
+  GET_INT_ARG(tf_ctx->arg[off+9] ,PLI_INT32 ,bnum_payload)
+  GET_INT_ARG(tf_ctx->arg[off+11],PLI_UINT32,add_crc)
+  GET_INT_ARG(tf_ctx->arg[off+12],PLI_UINT32,add_preamble)
+  if (pkt_fit_array(tf_ctx,off+10,bnum_payload,__FUNCTION__)) {
+      pkt_control(vpiFinish);
+      return(0);
+  }
+
+  //--------------------build Ethernet packet
+  tmp = 8+ETH_HDR_LEN+m_vlan_num*ETH_VLAN_TAG_LEN;
+  tmp += ((IPV6_HDR_LEN+hdr+bnum_payload)<46) ? 46 : (IPV6_HDR_LEN+hdr+bnum_payload);
+  tmp += 4; // num of bytes from preamble to crc at most.
+  eth_pkt = vpi_scratch(VPI_SCRATCH_PKT, tmp);
+  payload = vpi_scratch(VPI_SCRATCH_PAYLOAD, bnum_payload);
+  if ((eth_pkt==NULL)||(payload==NULL)) {
+      vpi_printf("ERROR: scratch buffer error.\n");
+      pkt_control(vpiFinish);
+      return(0);
+  }
+  GET_ARRAY_ARG(vpi_tf_ctx_array(tf_ctx,off+10),0,bnum_payload,payload)
+
+  if (tcp) {
+      tmp = gen_eth_ipv6_tcp_packet_vlan( eth_pkt
+                                        , mac_src
+                                        , mac_dst
+                                        , m_vlan
+                                        , m_vlan_num
+                                        , ip_src
+                                        , ip_dst
+                                        , hop_limit
+                                        , port_src
+                                        , port_dst
+                                        , seq_num
+                                        , ack_num
+                                        , bnum_payload // Pure TCP payload
+                                        , payload
+                                        , 1 // update TCP checksum
+                                        , add_crc
+                                        , add_preamble);
+  } else {
+      tmp = gen_eth_ipv6_udp_packet_vlan( eth_pkt
+                                        , mac_src
+                                        , mac_dst
+                                        , m_vlan
+                                        , m_vlan_num
+                                        , ip_src
+                                        , ip_dst
+                                        , hop_limit
+                                        , port_src
+                                        , port_dst
+                                        , bnum_payload // Pure UDP payload
+                                        , payload
+                                        , 1 // update UDP checksum
+                                        , add_crc
+                                        , add_preamble);
+  }
+  if (tmp<0) {
+      vpi_printf("ERROR: %s() %d-byte payload.\n", __FUNCTION__, bnum_payload);
+      pkt_control(vpiFinish);
+      return(0);
+  }
+
+  //--------------------copy all generated contents
+  if (pkt_fit_array(tf_ctx,0,tmp,__FUNCTION__)) {
+      pkt_control(vpiFinish);
+      return(0);
+  }
+  PUT_ARRAY_ARG(vpi_tf_ctx_array(tf_ctx,0),0,tmp,eth_pkt)
+
+  //--------------------put num of bytes of Ethernet packet
+  if (pkt_put_bnum(tf_ctx->arg[1], tmp, __FUNCTION__)) pkt_control(vpiFinish);
+
+  return(0);
+}
+PLI_INT32 pkt_udp_ipv6_eth_Calltf(PLI_BYTE8 *user_data) {
+  return pkt_ipv6_eth_Calltf(0);
+}
+PLI_INT32 pkt_tcp_ipv6_eth_Calltf(PLI_BYTE8 *user_data) {
+  return pkt_ipv6_eth_Calltf(1);
+}
+
+//----------------------------------------------------------------------------
+// $pkt_arp( pkt     [7:0][0:1023]
+//         , bnum_pkt[15:0] // num of bytes of the whole packet
+//         , op      [15:0] // 1: request, 2: reply
+//         , ip_src  [31:0] // sender
+//         , ip_dst  [31:0] // target
+//         , mac_src [47:0] // sender
+//         , mac_dst [47:0] // target, e.g., broadcast for request
+//         , add_crc
+//         , add_preamble
+//         );
+// Tags set by $pkt_vlan are added.
+//----------------------------------------------------------------------------
+#define TASK_NAME "$pkt_arp"
+PLI_INT32 pkt_arp_Compiletf(PLI_BYTE8 *user_data) {
+  vpiHandle systf_handle, arg_iterator, arg_handle, ele_handle;
+  PLI_INT32 tfarg_type, arg_type;
+  int width;
+  int numA, widthA;
+
+  systf_handle = vpi_handle(vpiSysTfCall, NULL);
+  arg_iterator = vpi_iterate(vpiArgument, systf_handle);
+  if (arg_iterator==NULL) {
+      vpi_printf("ERROR: %s must have nine arguments.\n", TASK_NAME);
+      pkt_control(vpiFinish);
+  }
+
+  CHECK_ARRAY_ARG("1st", "nine", numA, widthA) // ethernet pkt
+  CHECK_INT_ARG  ("2nd", "nine") // bnum pkt
+  CHECK_INT_ARG  ("3rd", "nine") // op
+  CHECK_INT_ARG  ("4th", "nine") // SRC IP
+  CHECK_INT_ARG  ("5th", "nine") // DST IP
+  CHECK_WIDE_ARG ("6th", "nine", 48) // SRC MAC
+  CHECK_WIDE_ARG ("7th", "nine", 48) // DST MAC
+  CHECK_INT_ARG  ("8th", "nine") // add crc
+  CHECK_INT_ARG  ("9th", "nine") // add preamble
+
+  arg_handle = vpi_scan(arg_iterator);
+  if (arg_handle!=NULL) {
+      vpi_printf("ERROR: %s must have nine arguments.\n", TASK_NAME);
+      vpi_free_object(arg_iterator);
+      pkt_control(vpiFinish);
+  }
+
+  if (widthA!=8) {
+      vpi_printf("ERROR: %s first argument must be 8-bit array.\n", TASK_NAME);
+      pkt_control(vpiFinish);
+  }
+
+  if (vpi_tf_ctx_build(systf_handle)==NULL) pkt_control(vpiFinish);
+
+  return(0);
+}
+#undef TASK_NAME
+//----------------------------------------------------------------------------
+PLI_INT32 pkt_arp_Calltf(PLI_BYTE8 *user_data) {
+  vpiHandle systf_handle;
+  vpi_tf_ctx_t *tf_ctx;
+  s_vpi_value value;
+  PLI_UINT16 op;
+  PLI_UINT32 ip_src;
+  PLI_UINT32 ip_dst;
+  PLI_UBYTE8 mac_src[6];
+  PLI_UBYTE8 mac_dst[6];
+  PLI_UINT32 add_crc;
+  PLI_UINT32 add_preamble;
+  uint8_t *eth_pkt; // buffer to hold whole packet
+  int tmp;
 
-//printf("%s()@%s 2\n", __FUNCTION__, __FILE__); fflush(stdout); vpi_flush();
-  GET_WIDE_ARG(H_mac_src)
-  val32 = value.value.vector[0].aval;
-  mac_src[5] =  val32     &0xFF;
-  mac_src[4] = (val32>> 8)&0xFF;
-  mac_src[3] = (val32>>16)&0xFF;
-  mac_src[2] = (val32>>24)&0xFF;
-  val32 = value.value.vector[1].aval;
-  mac_src[1] =  val32     &0xFF;
-  mac_src[0] = (val32>> 8)&0xFF; // msb
+  systf_handle = vpi_handle(vpiSysTfCall, NULL);
+  tf_ctx       = vpi_tf_ctx_get(systf_handle);
+  if (tf_ctx==NULL) {
+      vpi_printf("ERROR: calloc error.\n");
+      pkt_control(vpiFinish);
+      return(0);
+  }
+  GET_INT_ARG(tf_ctx->arg[2],PLI_UINT16,op)
+  GET_INT_ARG(tf_ctx->arg[3],PLI_UINT32,ip_src)
+  GET_INT_ARG(tf_ctx->arg[4],PLI_UINT32,ip_dst)
+  pkt_get_mac(tf_ctx->arg[5], mac_src);
+  pkt_get_mac(tf_ctx->arg[6], mac_dst);
+  GET_INT_ARG(tf_ctx->arg[7],PLI_UINT32,add_crc)
+  GET_INT_ARG(tf_ctx->arg[8],PLI_UINT32,add_preamble)
+
+  eth_pkt = vpi_scratch(VPI_SCRATCH_PKT, 8+ETH_HDR_LEN+m_vlan_num*ETH_VLAN_TAG_LEN+46+4);
+  if (eth_pkt==NULL) {
+      vpi_printf("ERROR: scratch buffer error.\n");
+      pkt_control(vpiFinish);
+      return(0);
+  }
+  tmp = gen_eth_arp_packet_vlan( eth_pkt
+                               , mac_src
+                               , mac_dst
+                               , m_vlan
+                               , m_vlan_num
+                               , op
+                               , ip_src
+                               , ip_dst
+                               , add_crc
+                               , add_preamble);
 
-//printf("%s()@%s 3\n", __FUNCTION__, __FILE__); fflush(stdout); vpi_flush();
-  PortIdentity_t reqClockID;
-  GET_WIDE_ARG(H_reqClockID)
-  val32 = value.value.vector[0].aval;
-//printf("%s val32 0x%08X\n", __FUNCTION__, val32);
-  reqClockID.clockIdentity[7] = (val32&0x000000FF);
-  reqClockID.clockIdentity[6] = (val32&0x0000FF00)>>8;
-  reqClockID.clockIdentity[5] = (val32&0x00FF0000)>>16;
-  reqClockID.clockIdentity[4] = (val32&0xFF000000)>>24;
-  val32 = value.value.vector[1].aval;
-//printf("%s val32 0x%08X\n", __FUNCTION__, val32);
-  reqClockID.clockIdentity[3] = (val32&0x000000FF);
-  reqClockID.clockIdentity[2] = (val32&0x0000FF00)>>8;
-  reqClockID.clockIdentity[1] = (val32&0x00FF0000)>>16;
-  reqClockID.clockIdentity[0] = (val32&0xFF000000)>>24;
+  //--------------------copy all generated contents
+  if (pkt_fit_array(tf_ctx,0,tmp,__FUNCTION__)) {
+      pkt_control(vpiFinish);
+      return(0);
+  }
+  PUT_ARRAY_ARG(vpi_tf_ctx_array(tf_ctx,0),0,tmp,eth_pkt)
 
-  GET_INT_ARG(H_reqPortID,PLI_UINT16,val16)
-  reqClockID.portNumber = htons(val16);
+  //--------------------put num of bytes of Ethernet packet
+  if (pkt_put_bnum(tf_ctx->arg[1], tmp, __FUNCTION__)) pkt_control(vpiFinish);
 
-  GET_INT_ARG(H_crc,PLI_UINT32,add_crc)
-  GET_INT_ARG(H_preamble,PLI_UINT16,add_preamble)
+  return(0);
+}
 
-  //--------------------build Ethernet packet
-  ptpv2_msg_hdr_t ptpv2_msg_hdr;
-  uint16_t msg_len;
-  msg_len = msg_ptpv2_header(&ptpv2_msg_hdr
-                            ,H_messageType
-                            ,H_flagField
-                            ,H_correctionField
-                            ,H_sourceClockID
-                            ,H_sourcePortID
-                            ,H_sequenceID);
-  if (msg_len==0) {
-      vpi_printf("something wrong while building PTPv2 header\n");
+//----------------------------------------------------------------------------
+// ARP responder of $pkt_arp_*, which is made at the first use.
+static pkt_arp_t *m_arp=NULL;
+
+#define PKT_ARP_ENTRIES 65536
+#define PKT_ARP_QUEUE   1024
+
+static pkt_arp_t *pkt_arp_ctx(void)
+{
+  if (m_arp==NULL) m_arp = pkt_arp_create(PKT_ARP_ENTRIES, PKT_ARP_QUEUE);
+  return m_arp;
+}
+
+//----------------------------------------------------------------------------
+// $pkt_arp_host( ip [31:0]
+//              , mac[47:0] // 0 to remove
+//              );
+//----------------------------------------------------------------------------
+#define TASK_NAME "$pkt_arp_host"
+PLI_INT32 pkt_arp_host_Compiletf(PLI_BYTE8 *user_data) {
+  vpiHandle systf_handle, arg_iterator, arg_handle;
+  PLI_INT32 tfarg_type, arg_type;
+  int width;
+
+  systf_handle = vpi_handle(vpiSysTfCall, NULL);
+  arg_iterator = vpi_iterate(vpiArgument, systf_handle);
+  if (arg_iterator==NULL) {
+      vpi_printf("ERROR: %s must have two arguments.\n", TASK_NAME);
+      pkt_control(vpiFinish);
+  }
+
+  CHECK_INT_ARG  ("1st", "two") // IP
+  CHECK_WIDE_ARG ("2nd", "two", 48) // MAC
+
+  arg_handle = vpi_scan(arg_iterator);
+  if (arg_handle!=NULL) {
+      vpi_printf("ERROR: %s must have two arguments.\n", TASK_NAME);
       vpi_free_object(arg_iterator);
       pkt_control(vpiFinish);
   }
 
-  msg_len = (add_crc&&(msg_len<46)) ? 46 : msg_len;
-  msg_len += ETH_HDR_LEN;
-  msg_len += (add_preamble) ? 8 : 0;
-  msg_len += (add_crc     ) ? 4 : 0;
+  if (vpi_tf_ctx_build(systf_handle)==NULL) pkt_control(vpiFinish);
 
-  ptpv2_msg = (uint8_t*)calloc(msg_len, 1);
-  if (ptpv2_msg==NULL) {
+  return(0);
+}
+#undef TASK_NAME
+PLI_INT32 pkt_arp_host_Calltf(PLI_BYTE8 *user_data) {
+  vpiHandle systf_handle;
+  vpi_tf_ctx_t *tf_ctx;
+  s_vpi_value value;
+  PLI_UINT32 ip;
+  PLI_UBYTE8 mac[6];
+  static const PLI_UBYTE8 zero[6] = { 0, 0, 0, 0, 0, 0 };
+
+  systf_handle = vpi_handle(vpiSysTfCall, NULL);
+  tf_ctx       = vpi_tf_ctx_get(systf_handle);
+  if ((tf_ctx==NULL)||(pkt_arp_ctx()==NULL)) {
       vpi_printf("ERROR: calloc error.\n");
+      pkt_control(vpiFinish);
+      return(0);
+  }
+  GET_INT_ARG(tf_ctx->arg[0],PLI_UINT32,ip)
+  pkt_get_mac(tf_ctx->arg[1], mac);
+  if (!memcmp(mac, zero, 6)) {
+      pkt_arp_delete(m_arp, ip);
+  } else if (pkt_arp_add(m_arp, ip, mac, 1)) {
+      vpi_printf("ERROR: %s() no room for host 0x%08X.\n", __FUNCTION__, ip);
+      pkt_control(vpiFinish);
+  }
+  return(0);
+}
+
+//----------------------------------------------------------------------------
+// $pkt_arp_monitor( pkt     [7:0][0:1535] // Ethernet frame received
+//                 , bnum_pkt[15:0]
+//                 , preamble  // 'pkt' has preamble when 1
+//                 , num_reply // output: num of replies queued
+//                 );
+// Frames other than ARP are ignored, so that it can take all frames.
+//----------------------------------------------------------------------------
+#define TASK_NAME "$pkt_arp_monitor"
+PLI_INT32 pkt_arp_monitor_Compiletf(PLI_BYTE8 *user_data) {
+  vpiHandle systf_handle, arg_iterator, arg_handle, ele_handle;
+  PLI_INT32 tfarg_type, arg_type;
+  int numA, widthA;
+
+  systf_handle = vpi_handle(vpiSysTfCall, NULL);
+  arg_iterator = vpi_iterate(vpiArgument, systf_handle);
+  if (arg_iterator==NULL) {
+      vpi_printf("ERROR: %s must have four arguments.\n", TASK_NAME);
+      pkt_control(vpiFinish);
+  }
+
+  CHECK_ARRAY_ARG("1st", "four", numA, widthA) // ethernet pkt
+  CHECK_INT_ARG  ("2nd", "four") // bnum_pkt
+  CHECK_INT_ARG  ("3rd", "four") // preamble
+  CHECK_INT_ARG  ("4th", "four") // num_reply
+
+  arg_handle = vpi_scan(arg_iterator);
+  if (arg_handle!=NULL) {
+      vpi_printf("ERROR: %s must have four arguments.\n", TASK_NAME);
       vpi_free_object(arg_iterator);
       pkt_control(vpiFinish);
   }
 
-  ptpv2_ctx_t *ctx = get_ptpv2_context();
+  if (widthA!=8) {
+      vpi_printf("ERROR: %s first argument must be 8-bit array.\n", TASK_NAME);
+      pkt_control(vpiFinish);
+  }
 
-  Timestamp_t time;
-  time.secondsField.msb = secondsMsb;
-  time.secondsField.lsb = secondsLsb;
-  time.nanosecondsField = nanoseconds;
+  if (vpi_tf_ctx_build(systf_handle)==NULL) pkt_control(vpiFinish);
 
-  tmp = gen_ptpv2_msg_ethernet( ctx
-                              , ptpv2_msg
-                              , mac_src
-                              ,&ptpv2_msg_hdr
-                              ,&time
-                              ,&reqClockID
-                              , add_crc
-                              , add_preamble
-                              );
+  return(0);
+}
+#undef TASK_NAME
+PLI_INT32 pkt_arp_monitor_Calltf(PLI_BYTE8 *user_data) {
+  vpiHandle systf_handle;
+  vpi_tf_ctx_t *tf_ctx;
+  s_vpi_value value;
+  PLI_INT32  leng;
+  PLI_UINT32 preamble;
+  uint8_t *eth_pkt;
+  int idx;
 
-#if defined(RIGOR)
-  if (tmp!=msg_len) {
-       vpi_printf("ERROR: %s()@%s whole packet length error %d %d\n", __FUNCTION__, __FILE__, tmp, msg_len);
+  systf_handle = vpi_handle(vpiSysTfCall, NULL);
+  tf_ctx       = vpi_tf_ctx_get(systf_handle);
+  if ((tf_ctx==NULL)||(pkt_arp_ctx()==NULL)) {
+      vpi_printf("ERROR: calloc error.\n");
+      pkt_control(vpiFinish);
+      return(0);
   }
-#endif
+  GET_INT_ARG(tf_ctx->arg[1],PLI_INT32 ,leng    )
+  GET_INT_ARG(tf_ctx->arg[2],PLI_UINT32,preamble)
+  if (pkt_fit_array(tf_ctx,0,leng,__FUNCTION__)) {
+      pkt_control(vpiFinish);
+      return(0);
+  }
+  eth_pkt = vpi_scratch(VPI_SCRATCH_PKT, leng);
+  if (eth_pkt==NULL) {
+      vpi_printf("ERROR: scratch buffer error.\n");
+      pkt_control(vpiFinish);
+      return(0);
+  }
+  GET_ARRAY_ARG(vpi_tf_ctx_array(tf_ctx,0),0,leng,eth_pkt)
+  idx = (preamble&&(leng>=8)) ? 8 : 0;
+  pkt_arp_put(m_arp, &eth_pkt[idx], leng-idx);
+  PUT_INT_ARG(tf_ctx->arg[3],PLI_INT32,m_arp->queue_num)
+  return(0);
+}
 
-  //--------------------copy all generated contents
-  for (idy=0; idy<tmp; idy++) {
-       vpiHandle ele = vpi_handle_by_index(H_pkt, idy);
-       value.value.integer = ptpv2_msg[idy];
-       vpi_put_value(ele, &value, NULL, vpiNoDelay);
+//----------------------------------------------------------------------------
+// $pkt_arp_reply( pkt     [7:0][0:1023]
+//               , bnum_pkt[15:0] // output: 0 if no reply queued
+//               , add_crc
+//               , add_preamble
+//               );
+//----------------------------------------------------------------------------
+#define TASK_NAME "$pkt_arp_reply"
+PLI_INT32 pkt_arp_reply_Compiletf(PLI_BYTE8 *user_data) {
+  vpiHandle systf_handle, arg_iterator, arg_handle, ele_handle;
+  PLI_INT32 tfarg_type, arg_type;
+  int numA, widthA;
+
+  systf_handle = vpi_handle(vpiSysTfCall, NULL);
+  arg_iterator = vpi_iterate(vpiArgument, systf_handle);
+  if (arg_iterator==NULL) {
+      vpi_printf("ERROR: %s must have four arguments.\n", TASK_NAME);
+      pkt_control(vpiFinish);
   }
 
-  //--------------------put num of bytes of Ethernet packet
-  value.format = vpiIntVal;
-  value.value.integer = tmp;
-  vpi_put_value(H_bnum_pkt, &value, NULL, vpiNoDelay);
+  CHECK_ARRAY_ARG("1st", "four", numA, widthA) // ethernet pkt
+  CHECK_INT_ARG  ("2nd", "four") // bnum_pkt
+  CHECK_INT_ARG  ("3rd", "four") // add crc
+  CHECK_INT_ARG  ("4th", "four") // add preamble
 
-  free(ptpv2_msg);
-  vpi_free_object(arg_iterator);
+  arg_handle = vpi_scan(arg_iterator);
+  if (arg_handle!=NULL) {
+      vpi_printf("ERROR: %s must have four arguments.\n", TASK_NAME);
+      vpi_free_object(arg_iterator);
+      pkt_control(vpiFinish);
+  }
+
+  if (widthA!=8) {
+      vpi_printf("ERROR: %s first argument must be 8-bit array.\n", TASK_NAME);
+      pkt_control(vpiFinish);
+  }
+
+  if (vpi_tf_ctx_build(systf_handle)==NULL) pkt_control(vpiFinish);
+
+  return(0);
+}
+#undef TASK_NAME
+PLI_INT32 pkt_arp_reply_Calltf(PLI_BYTE8 *user_data) {
+  vpiHandle systf_handle;
+  vpi_tf_ctx_t *tf_ctx;
+  s_vpi_value value;
+  PLI_UINT32 add_crc;
+  PLI_UINT32 add_preamble;
+  uint8_t *eth_pkt;
+  int tmp;
 
+  systf_handle = vpi_handle(vpiSysTfCall, NULL);
+  tf_ctx       = vpi_tf_ctx_get(systf_handle);
+  if ((tf_ctx==NULL)||(pkt_arp_ctx()==NULL)) {
+      vpi_printf("ERROR: calloc error.\n");
+      pkt_control(vpiFinish);
+      return(0);
+  }
+  GET_INT_ARG(tf_ctx->arg[2],PLI_UINT32,add_crc)
+  GET_INT_ARG(tf_ctx->arg[3],PLI_UINT32,add_preamble)
+  eth_pkt = vpi_scratch(VPI_SCRATCH_PKT, 8+ETH_HDR_LEN+PKT_VLAN_MAX*ETH_VLAN_TAG_LEN+46+4);
+  if (eth_pkt==NULL) {
+      vpi_printf("ERROR: scratch buffer error.\n");
+      pkt_control(vpiFinish);
+      return(0);
+  }
+  tmp = pkt_arp_get(m_arp, eth_pkt, add_crc, add_preamble);
+  if (tmp>0) {
+      if (pkt_fit_array(tf_ctx,0,tmp,__FUNCTION__)) {
+          pkt_control(vpiFinish);
+          return(0);
+      }
+      PUT_ARRAY_ARG(vpi_tf_ctx_array(tf_ctx,0),0,tmp,eth_pkt)
+  }
+  if (pkt_put_bnum(tf_ctx->arg[1], tmp, __FUNCTION__)) pkt_control(vpiFinish);
   return(0);
 }
+
 //----------------------------------------------------------------------------
-// $msg_ptpv2_udp_ip_ethernet ( pkt               [7:0][0:1024*4-1]
-//                            , bnum_pkt          [15:0] // num of bytes of the whole message
-//                            , mac_src           [47:0]
-//                            , ip_src            [31:0]
-//                            , messageType       [ 3:0]
-//                            , flagField         [15:0]
-//                            , correctionField   [63:0]
-//                            , sourceClockID     [63:0]
-//                            , sourcePortID      [15:0]
-//                            , sequenceID        [15:0]
-//                            , secondsField      [47:0]
-//                            , nanosecondsField  [31:0]
-//                            , reqClockID        [63:0]
-//                            , reqPortID         [16:0]
-//                            , add_crc      //
-//                            , add_preamble //
-//                            );
+// $pkt_arp_lookup( ip   [31:0]
+//                , mac  [47:0] // output
+//                , found       // output: 0 if not found
+//                );
 //----------------------------------------------------------------------------
-#define TASK_NAME "$msg_ptpv2_udp_ip_ethernet"
-PLI_INT32 msg_ptpv2_udp_ip_eth_Compiletf(PLI_BYTE8 *user_data) {
+#define TASK_NAME "$pkt_arp_lookup"
+PLI_INT32 pkt_arp_lookup_Compiletf(PLI_BYTE8 *user_data) {
+  vpiHandle systf_handle, arg_iterator, arg_handle;
+  PLI_INT32 tfarg_type, arg_type;
+  int width;
+
+  systf_handle = vpi_handle(vpiSysTfCall, NULL);
+  arg_iterator = vpi_iterate(vpiArgument, systf_handle);
+  if (arg_iterator==NULL) {
+      vpi_printf("ERROR: %s must have three arguments.\n", TASK_NAME);
+      pkt_control(vpiFinish);
+  }
+
+  CHECK_INT_ARG  ("1st", "three") // IP
+  CHECK_WIDE_ARG ("2nd", "three", 48) // MAC
+  CHECK_INT_ARG  ("3rd", "three") // found
+
+  arg_handle = vpi_scan(arg_iterator);
+  if (arg_handle!=NULL) {
+      vpi_printf("ERROR: %s must have three arguments.\n", TASK_NAME);
+      vpi_free_object(arg_iterator);
+      pkt_control(vpiFinish);
+  }
+
+  if (vpi_tf_ctx_build(systf_handle)==NULL) pkt_control(vpiFinish);
+
+  return(0);
+}
+#undef TASK_NAME
+PLI_INT32 pkt_arp_lookup_Calltf(PLI_BYTE8 *user_data) {
+  vpiHandle systf_handle;
+  vpi_tf_ctx_t *tf_ctx;
+  s_vpi_value value;
+  s_vpi_vecval vector[2];
+  PLI_UINT32 ip;
+  pkt_arp_entry_t *entry;
+
+  systf_handle = vpi_handle(vpiSysTfCall, NULL);
+  tf_ctx       = vpi_tf_ctx_get(systf_handle);
+  if ((tf_ctx==NULL)||(pkt_arp_ctx()==NULL)) {
+      vpi_printf("ERROR: calloc error.\n");
+      pkt_control(vpiFinish);
+      return(0);
+  }
+  GET_INT_ARG(tf_ctx->arg[0],PLI_UINT32,ip)
+  entry = pkt_arp_lookup(m_arp, ip);
+  if (entry!=NULL) {
+      vector[0].aval = ((PLI_UINT32)entry->mac[2]<<24)|((PLI_UINT32)entry->mac[3]<<16)
+                     | ((PLI_UINT32)entry->mac[4]<< 8)| (PLI_UINT32)entry->mac[5];
+      vector[1].aval = ((PLI_UINT32)entry->mac[0]<< 8)| (PLI_UINT32)entry->mac[1]; // msb
+      vector[0].bval = 0;
+      vector[1].bval = 0;
+      value.format       = vpiVectorVal;
+      value.value.vector = vector;
+      vpi_put_value(tf_ctx->arg[1], &value, NULL, vpiNoDelay);
+  }
+  PUT_INT_ARG(tf_ctx->arg[2],PLI_INT32,(entry!=NULL) ? 1 : 0)
+  return(0);
+}
+
+//----------------------------------------------------------------------------
+// $pkt_icmp_ip_ethernet( pkt     [7:0][0:4095]
+//                      , bnum_pkt[15:0] // num of bytes of the whole packet
+//                      , type    [7:0]  // 8: echo request, 0: echo reply
+//                      , id      [15:0]
+//                      , seq     [15:0]
+//                      , ip_src  [31:0]
+//                      , ip_dst  [31:0]
+//                      , ttl     [7:0]
+//                      , mac_src [47:0]
+//                      , mac_dst [47:0]
+//                      , bnum_payload[15:0] // num of bytes of echo data
+//                      , payload [7:0][0:4095]
+//                      , add_crc      //
+//                      , add_preamble //
+//                      );
+// $pkt_icmp_ipv6_ethernet( pkt     [7:0][0:4095]
+//                        , bnum_pkt[15:0] // num of bytes of the whole packet
+//                        , type    [7:0]  // 128: echo request, 129: echo reply
+//                        , id      [15:0]
+//                        , seq     [15:0]
+//                        , ip_src  [127:0]
+//                        , ip_dst  [127:0]
+//                        , hop_limit[7:0]
+//                        , mac_src [47:0]
+//                        , mac_dst [47:0]
+//                        , bnum_payload[15:0] // num of bytes of echo data
+//                        , payload [7:0][0:4095]
+//                        , add_crc      //
+//                        , add_preamble //
+//                        );
+// Tags set by $pkt_vlan are added.
+//----------------------------------------------------------------------------
+#define TASK_NAME ((v6) ? "$pkt_icmp_ipv6_ethernet" : "$pkt_icmp_ip_ethernet")
+static PLI_INT32 pkt_icmp_eth_Compiletf(int v6) {
   vpiHandle systf_handle, arg_iterator, arg_handle, ele_handle;
   PLI_INT32 tfarg_type, arg_type;
   int width;
   int numA, widthA;
+  int numB, widthB;
 
   systf_handle = vpi_handle(vpiSysTfCall, NULL);
   arg_iterator = vpi_iterate(vpiArgument, systf_handle);
   if (arg_iterator==NULL) {
-      vpi_printf("ERROR: %s must have 16 arguments.\n", TASK_NAME);
+      vpi_printf("ERROR: %s must have fourteen arguments.\n", TASK_NAME);
       pkt_control(vpiFinish);
   }
 
-  CHECK_ARRAY_ARG("1st", "16", numA, widthA)
-  CHECK_INT_ARG  ("2nd", "16") // bnum pkt
-  CHECK_WIDE_ARG ("3rd", "16", 48) // MAC SRC
-  CHECK_INT_ARG  ("4th", "16") // IP SRC
-  CHECK_INT_ARG  ("5th", "16") // message type
-  CHECK_INT_ARG  ("6th", "16") // flagField
-  CHECK_WIDE_ARG ("7th", "16", 64)  // correctionField
-  CHECK_WIDE_ARG ("8th", "16", 64)  // sourcePortIdentify
-  CHECK_INT_ARG  ("9th", "16")  // sourcePortIdentify
-  CHECK_INT_ARG  ("10th","16") // sequence ID
-  CHECK_WIDE_ARG ("11th","16", 48)  // seconds
-  CHECK_INT_ARG  ("12th","16") // nano
-  CHECK_WIDE_ARG ("13th","16", 64) // 
-  CHECK_INT_ARG  ("14th","16") // 
-  CHECK_INT_ARG  ("15th","16") // crc
-  CHECK_INT_ARG  ("16th","16") // preamble
+  CHECK_ARRAY_ARG("1st", "fourteen", numA, widthA) // ethernet pkt
+  CHECK_INT_ARG  ("2nd", "fourteen") // bnum pkt
+  CHECK_INT_ARG  ("3rd", "fourteen") // type
+  CHECK_INT_ARG  ("4th", "fourteen") // id
+  CHECK_INT_ARG  ("5th", "fourteen") // seq
+  if (v6) {
+  CHECK_WIDE_ARG ("6th", "fourteen", 128) // SRC IP
+  CHECK_WIDE_ARG ("7th", "fourteen", 128) // DST IP
+  } else {
+  CHECK_INT_ARG  ("6th", "fourteen") // SRC IP
+  CHECK_INT_ARG  ("7th", "fourteen") // DST IP
+  }
+  CHECK_INT_ARG  ("8th", "fourteen") // TTL or hop limit
+  CHECK_WIDE_ARG ("9th", "fourteen", 48) // SRC MAC
+  CHECK_WIDE_ARG ("10th", "fourteen", 48) // DST MAC
+  CHECK_WIDE_ARG ("11th", "fourteen", 16) // bnum payload
+  CHECK_ARRAY_ARG("12th", "fourteen", numB, widthB) // payload
+  CHECK_INT_ARG  ("13th", "fourteen") // add crc
+  CHECK_INT_ARG  ("14th", "fourteen") // add preamble
 
   arg_handle = vpi_scan(arg_iterator);
   if (arg_handle!=NULL) {
-      vpi_printf("ERROR: %s must have 16 arguments.\n", TASK_NAME);
+      vpi_printf("ERROR: %s must have fourteen arguments.\n", TASK_NAME);
       vpi_free_object(arg_iterator);
       pkt_control(vpiFinish);
   }
@@ -1951,315 +5722,240 @@ PLI_INT32 msg_ptpv2_udp_ip_eth_Compiletf(PLI_BYTE8 *user_data) {
       vpi_printf("ERROR: %s first argument must be 8-bit array.\n", TASK_NAME);
       pkt_control(vpiFinish);
   }
+  if (widthB!=8) {
+      vpi_printf("ERROR: %s payload argument must be 8-bit array.\n", TASK_NAME);
+      pkt_control(vpiFinish);
+  }
+
+  if (vpi_tf_ctx_build(systf_handle)==NULL) pkt_control(vpiFinish);
 
   return(0);
 }
 #undef TASK_NAME
+PLI_INT32 pkt_icmp_ip_eth_Compiletf(PLI_BYTE8 *user_data) {
+  return pkt_icmp_eth_Compiletf(0);
+}
+PLI_INT32 pkt_icmp_ipv6_eth_Compiletf(PLI_BYTE8 *user_data) {
+  return pkt_icmp_eth_Compiletf(1);
+}
 //----------------------------------------------------------------------------
-PLI_INT32 msg_ptpv2_udp_ip_eth_Calltf(PLI_BYTE8 *user_data) {
-  vpiHandle systf_handle, arg_iterator;
-  vpiHandle H_pkt         ;
-  vpiHandle H_bnum_pkt    ;
-  vpiHandle H_messageType ;
-  vpiHandle H_secondsField;
-  vpiHandle H_nanoField   ;
-  vpiHandle H_sequenceID  ;
-  vpiHandle H_sourceClockID;
-  vpiHandle H_sourcePortID;
-  vpiHandle H_correctionField   ;
-  vpiHandle H_flagField         ;
-  vpiHandle H_reqClockID        ;
-  vpiHandle H_reqPortID        ;
-  vpiHandle H_ip_src      ;
-  vpiHandle H_mac_src     ;
-  vpiHandle H_crc     ;
-  vpiHandle H_preamble;
+static PLI_INT32 pkt_icmp_eth_Calltf(int v6) {
+  vpiHandle systf_handle;
+  vpi_tf_ctx_t *tf_ctx;
   s_vpi_value value;
-  PLI_UINT32 val32, val16, val8;
-  PLI_UINT16 bnum_pkt   ;
-  PLI_UBYTE8 messageType;
-  PLI_UINT16 secondsMsb ;
-  PLI_UINT32 secondsLsb ;
-  PLI_UINT32 nanoseconds;
-  PLI_UINT16 sequenceID ;
-  PLI_UINT32 ip_src     ;
-  PLI_UBYTE8 mac_src[6] ;
-  PLI_UINT32 add_crc     ;
+  PLI_UBYTE8 type;
+  PLI_UINT16 id;
+  PLI_UINT16 seq;
+  PLI_UINT32 ip_src=0;
+  PLI_UINT32 ip_dst=0;
+  PLI_UBYTE8 ip6_src[16];
+  PLI_UBYTE8 ip6_dst[16];
+  PLI_UBYTE8 ttl;
+  PLI_UBYTE8 mac_src[6];
+  PLI_UBYTE8 mac_dst[6];
+  PLI_INT32  bnum_payload;
+  PLI_UINT32 add_crc;
   PLI_UINT32 add_preamble;
-  int idx, idy, idz;
-  uint8_t *ptpv2_msg; // buffer to hold whole Ethernet packet
+  uint8_t *eth_pkt; // buffer to hold whole packet
+  uint8_t *payload; // buffer to hold payload data
   int tmp;
 
   //--------------------Get all handlers
   systf_handle = vpi_handle(vpiSysTfCall, NULL);
-  arg_iterator = vpi_iterate(vpiArgument, systf_handle);
-
-  H_pkt          = vpi_scan(arg_iterator);
-  H_bnum_pkt     = vpi_scan(arg_iterator);
-  H_mac_src      = vpi_scan(arg_iterator);
-  H_ip_src       = vpi_scan(arg_iterator);
-  H_messageType  = vpi_scan(arg_iterator);
-  H_flagField          = vpi_scan(arg_iterator);
-  H_correctionField    = vpi_scan(arg_iterator);
-  H_sourceClockID = vpi_scan(arg_iterator);
-  H_sourcePortID = vpi_scan(arg_iterator);
-  H_sequenceID   = vpi_scan(arg_iterator);
-  H_secondsField = vpi_scan(arg_iterator);
-  H_nanoField    = vpi_scan(arg_iterator);
-  H_reqClockID   = vpi_scan(arg_iterator);
-  H_reqPortID   = vpi_scan(arg_iterator);
-  H_crc          = vpi_scan(arg_iterator);
-  H_preamble     = vpi_scan(arg_iterator);
-  
-  GET_WIDE_ARG(H_secondsField)
-  val32 = value.value.vector[0].aval;
-  secondsLsb = val32;
-  val32 = value.value.vector[1].aval;
-  secondsMsb = val32&0xFFFF;
-  GET_INT_ARG(H_nanoField,PLI_UINT32,nanoseconds)
-  GET_INT_ARG(H_sequenceID,PLI_UINT16,sequenceID)
-
-  GET_INT_ARG(H_ip_src,PLI_UINT32,ip_src)
-  GET_WIDE_ARG(H_mac_src)
-  val32 = value.value.vector[0].aval;
-  mac_src[5] =  val32     &0xFF;
-  mac_src[4] = (val32>> 8)&0xFF;
-  mac_src[3] = (val32>>16)&0xFF;
-  mac_src[2] = (val32>>24)&0xFF;
-  val32 = value.value.vector[1].aval;
-  mac_src[1] =  val32     &0xFF;
-  mac_src[0] = (val32>> 8)&0xFF; // msb
-
-  PortIdentity_t reqClockID;
-  GET_WIDE_ARG(H_reqClockID)
-
-  val32 = value.value.vector[0].aval;
-  reqClockID.clockIdentity[7] = (val32&0x000000FF);
-  reqClockID.clockIdentity[6] = (val32&0x0000FF00)>>8;
-  reqClockID.clockIdentity[5] = (val32&0x00FF0000)>>16;
-  reqClockID.clockIdentity[4] = (val32&0xFF000000)>>24;
-
-  val32 = value.value.vector[1].aval;
-  reqClockID.clockIdentity[3] = (val32&0x000000FF);
-  reqClockID.clockIdentity[2] = (val32&0x0000FF00)>>8;
-  reqClockID.clockIdentity[1] = (val32&0x00FF0000)>>16;
-  reqClockID.clockIdentity[0] = (val32&0xFF000000)>>24;
-
-  GET_INT_ARG(H_reqPortID,PLI_UINT16,val16)
-  reqClockID.portNumber = htons(val16);
-
-  GET_INT_ARG(H_crc,PLI_UINT32,add_crc)
-  GET_INT_ARG(H_preamble,PLI_UINT16,add_preamble)
-
-  //--------------------build Ethernet packet
-  ptpv2_msg_hdr_t ptpv2_msg_hdr;
-  uint16_t msg_len;
-  msg_len = msg_ptpv2_header(&ptpv2_msg_hdr
-                            ,H_messageType
-                            ,H_flagField
-                            ,H_correctionField
-                            ,H_sourceClockID
-                            ,H_sourcePortID
-                            ,H_sequenceID);
-  if (msg_len==0) {
-      vpi_printf("something wrong while building PTPv2 header\n");
-      vpi_free_object(arg_iterator);
+  tf_ctx       = vpi_tf_ctx_get(systf_handle);
+  if (tf_ctx==NULL) {
+      vpi_printf("ERROR: calloc error.\n");
       pkt_control(vpiFinish);
+      return(0);
   }
-
-  msg_len = ((UDP_HDR_LEN+IP_HDR_LEN+msg_len)<46) ? 46 : (UDP_HDR_LEN+IP_HDR_LEN+msg_len);
-  msg_len += ETH_HDR_LEN;
-  msg_len += (add_preamble) ? 8 : 0;
-  msg_len += (add_crc     ) ? 4 : 0;
-
-  ptpv2_msg = (uint8_t*)calloc(msg_len, 1);
-  if (ptpv2_msg==NULL) {
-      vpi_printf("ERROR: calloc error.\n");
-      vpi_free_object(arg_iterator);
+  GET_INT_ARG(tf_ctx->arg[2],PLI_UBYTE8,type)
+  GET_INT_ARG(tf_ctx->arg[3],PLI_UINT16,id)
+  GET_INT_ARG(tf_ctx->arg[4],PLI_UINT16,seq)
+  if (v6) {
+      pkt_get_ipv6(tf_ctx->arg[5], ip6_src);
+      pkt_get_ipv6(tf_ctx->arg[6], ip6_dst);
+  } else {
+      GET_INT_ARG(tf_ctx->arg[5],PLI_UINT32,ip_src)
+      GET_INT_ARG(tf_ctx->arg[6],PLI_UINT32,ip_dst)
+  }
+  GET_INT_ARG(tf_ctx->arg[7],PLI_UBYTE8,ttl)
+  pkt_get_mac(tf_ctx->arg[8], mac_src);
+  pkt_get_mac(tf_ctx->arg[9], mac_dst);
+  GET_INT_ARG(tf_ctx->arg[10],PLI_INT32 ,bnum_payload)
+  GET_INT_ARG(tf_ctx->arg[12],PLI_UINT32,add_crc)
+  GET_INT_ARG(tf_ctx->arg[13],PLI_UINT32,add_preamble)
+  if (pkt_fit_array(tf_ctx,11,bnum_payload,__FUNCTION__)) {
       pkt_control(vpiFinish);
+      return(0);
   }
 
-  ptpv2_ctx_t *ctx = get_ptpv2_context();
-
-  Timestamp_t time;
-  time.secondsField.msb = secondsMsb;
-  time.secondsField.lsb = secondsLsb;
-  time.nanosecondsField = nanoseconds;
-
-  tmp = gen_ptpv2_msg_udp_ip_ethernet( ctx
-                                     , ptpv2_msg
-                                     , mac_src
-                                     , ip_src
-                                     ,&ptpv2_msg_hdr
-                                     ,&time
-                                     ,&reqClockID
-                                     , add_crc
-                                     , add_preamble
-                                     );
-#if defined(RIGOR)
-  if (tmp!=msg_len) {
-       vpi_printf("ERROR: %s()@%s whole packet length error %d %d\n", __FUNCTION__, __FILE__, tmp, msg_len);
+  //--------------------build Ethernet packet
+  tmp = 8+ETH_HDR_LEN+m_vlan_num*ETH_VLAN_TAG_LEN+((v6) ? IPV6_HDR_LEN : IP_HDR_LEN)+ICMP_ECHO_HDR_LEN;
+  tmp += (bnum_payload<46) ? 46 : bnum_payload;
+  tmp += 4; // num of bytes from preamble to crc at most.
+  eth_pkt = vpi_scratch(VPI_SCRATCH_PKT, tmp);
+  payload = vpi_scratch(VPI_SCRATCH_PAYLOAD, bnum_payload);
+  if ((eth_pkt==NULL)||(payload==NULL)) {
+      vpi_printf("ERROR: scratch buffer error.\n");
+      pkt_control(vpiFinish);
+      return(0);
+  }
+  GET_ARRAY_ARG(vpi_tf_ctx_array(tf_ctx,11),0,bnum_payload,payload)
+
+  if (v6) {
+      tmp = gen_eth_ipv6_icmp_echo_packet_vlan( eth_pkt
+                                              , mac_src
+                                              , mac_dst
+                                              , m_vlan
+                                              , m_vlan_num
+                                              , ip6_src
+                                              , ip6_dst
+                                              , ttl
+                                              , type
+                                              , id
+                                              , seq
+                                              , bnum_payload // Pure echo data
+                                              , payload
+                                              , add_crc
+                                              , add_preamble);
+  } else {
+      tmp = gen_eth_ip_icmp_echo_packet_vlan( eth_pkt
+                                            , mac_src
+                                            , mac_dst
+                                            , m_vlan
+                                            , m_vlan_num
+                                            , ip_src
+                                            , ip_dst
+                                            , ttl
+                                            , type
+                                            , id
+                                            , seq
+                                            , bnum_payload // Pure echo data
+                                            , payload
+                                            , add_crc
+                                            , add_preamble);
+  }
+  if (tmp<0) {
+      vpi_printf("ERROR: %s() %d-byte payload.\n", __FUNCTION__, bnum_payload);
+      pkt_control(vpiFinish);
+      return(0);
   }
-#endif
 
   //--------------------copy all generated contents
-  for (idy=0; idy<tmp; idy++) {
-       vpiHandle ele = vpi_handle_by_index(H_pkt, idy);
-       value.value.integer = ptpv2_msg[idy];
-       vpi_put_value(ele, &value, NULL, vpiNoDelay);
+  if (pkt_fit_array(tf_ctx,0,tmp,__FUNCTION__)) {
+      pkt_control(vpiFinish);
+      return(0);
   }
+  PUT_ARRAY_ARG(vpi_tf_ctx_array(tf_ctx,0),0,tmp,eth_pkt)
 
   //--------------------put num of bytes of Ethernet packet
-  value.format = vpiIntVal;
-  value.value.integer = tmp;
-  vpi_put_value(H_bnum_pkt, &value, NULL, vpiNoDelay);
-
-  free(ptpv2_msg);
-  vpi_free_object(arg_iterator);
+  if (pkt_put_bnum(tf_ctx->arg[1], tmp, __FUNCTION__)) pkt_control(vpiFinish);
 
   return(0);
 }
+PLI_INT32 pkt_icmp_ip_eth_Calltf(PLI_BYTE8 *user_data) {
+  return pkt_icmp_eth_Calltf(0);
+}
+PLI_INT32 pkt_icmp_ipv6_eth_Calltf(PLI_BYTE8 *user_data) {
+  return pkt_icmp_eth_Calltf(1);
+}
 
 //----------------------------------------------------------------------------
-// $pkt_ethernet_parser( pkt     [ 7:0][0:1024*4-1]
-//                     , bnum_pkt[15:0]
-//                     , crc   
-//                     , preamble
+// $pkt_icmp_echo_reply( pkt       [7:0][0:1535] // frame received
+//                     , bnum_pkt  [15:0]
+//                     , preamble  // 'pkt' has preamble when 1
+//                     , reply     [7:0][0:1535]
+//                     , bnum_reply[15:0] // output: 0 if 'pkt' is not echo request
+//                     , add_crc
+//                     , add_preamble
 //                     );
+// It answers ICMP or ICMPv6 echo request with addresses swapped
+// and VLAN tags kept, so that it can take all frames from a monitor.
 //----------------------------------------------------------------------------
-#define TASK_NAME "$pkt_ethernet_parser"
-PLI_INT32 pkt_eth_parser_Compiletf(PLI_BYTE8 *user_data) {
+#define TASK_NAME "$pkt_icmp_echo_reply"
+PLI_INT32 pkt_icmp_echo_reply_Compiletf(PLI_BYTE8 *user_data) {
   vpiHandle systf_handle, arg_iterator, arg_handle, ele_handle;
   PLI_INT32 tfarg_type, arg_type;
-  int width;
   int numA, widthA;
+  int numB, widthB;
 
   systf_handle = vpi_handle(vpiSysTfCall, NULL);
   arg_iterator = vpi_iterate(vpiArgument, systf_handle);
   if (arg_iterator==NULL) {
-      vpi_printf("ERROR: %s must have four arguments.\n", TASK_NAME);
+      vpi_printf("ERROR: %s must have seven arguments.\n", TASK_NAME);
       pkt_control(vpiFinish);
   }
 
-  CHECK_ARRAY_ARG("1st", "four", numA, widthA)
-  CHECK_INT_ARG  ("2nd", "four") // bnum_pkt
-  CHECK_INT_ARG  ("3rd", "four") // crc
-  CHECK_INT_ARG  ("4th", "four") // preamble
+  CHECK_ARRAY_ARG("1st", "seven", numA, widthA) // ethernet pkt
+  CHECK_INT_ARG  ("2nd", "seven") // bnum_pkt
+  CHECK_INT_ARG  ("3rd", "seven") // preamble
+  CHECK_ARRAY_ARG("4th", "seven", numB, widthB) // reply
+  CHECK_INT_ARG  ("5th", "seven") // bnum_reply
+  CHECK_INT_ARG  ("6th", "seven") // add crc
+  CHECK_INT_ARG  ("7th", "seven") // add preamble
 
   arg_handle = vpi_scan(arg_iterator);
   if (arg_handle!=NULL) {
-      vpi_printf("ERROR: %s must have four arguments.\n", TASK_NAME);
+      vpi_printf("ERROR: %s must have seven arguments.\n", TASK_NAME);
       vpi_free_object(arg_iterator);
       pkt_control(vpiFinish);
   }
 
-  if (widthA!=8) {
-      vpi_printf("ERROR: %s first argument must be 8-bit array.\n", TASK_NAME);
+  if ((widthA!=8)||(widthB!=8)) {
+      vpi_printf("ERROR: %s first and fourth arguments must be 8-bit array.\n", TASK_NAME);
       pkt_control(vpiFinish);
   }
 
+  if (vpi_tf_ctx_build(systf_handle)==NULL) pkt_control(vpiFinish);
+
   return(0);
 }
 #undef TASK_NAME
-//----------------------------------------------------------------------------
-PLI_INT32 pkt_eth_parser_Calltf(PLI_BYTE8 *user_data) {
-  vpiHandle systf_handle, arg_iterator;
-  vpiHandle H_pkt     ;
-  vpiHandle H_bnum_pkt;
-  vpiHandle H_crc     ;
-  vpiHandle H_preamble;
+PLI_INT32 pkt_icmp_echo_reply_Calltf(PLI_BYTE8 *user_data) {
+  vpiHandle systf_handle;
+  vpi_tf_ctx_t *tf_ctx;
   s_vpi_value value;
-  PLI_UINT32 val32, val8;
-  PLI_UINT16 leng;
-  PLI_UINT32 crc ;
-  PLI_UINT32 preamble ;
-  int idx, idy, idz;
-  uint8_t *eth_pkt; // buffer to hold whole Ethernet packet
-  uint16_t type_leng;
-  int tmp;
+  PLI_INT32  leng;
+  PLI_UINT32 preamble;
+  PLI_UINT32 add_crc;
+  PLI_UINT32 add_preamble;
+  uint8_t *eth_pkt;
+  int idx, tmp;
 
-  //--------------------Get all handlers
   systf_handle = vpi_handle(vpiSysTfCall, NULL);
-  arg_iterator = vpi_iterate(vpiArgument, systf_handle);
-  H_pkt        = vpi_scan(arg_iterator);
-  H_bnum_pkt   = vpi_scan(arg_iterator);
-  H_crc        = vpi_scan(arg_iterator);
-  H_preamble   = vpi_scan(arg_iterator);
-
-  //--------------------Get all values
-  GET_INT_ARG(H_bnum_pkt,PLI_UBYTE8,leng    )
-  GET_INT_ARG(H_crc     ,PLI_UINT32,crc     )
-  GET_INT_ARG(H_preamble,PLI_UINT32,preamble)
-  //--------------------parsing
-  eth_pkt = (uint8_t*)calloc(leng, 1);
-  if (eth_pkt==NULL) {
+  tf_ctx       = vpi_tf_ctx_get(systf_handle);
+  if (tf_ctx==NULL) {
       vpi_printf("ERROR: calloc error.\n");
-      vpi_free_object(arg_iterator);
       pkt_control(vpiFinish);
+      return(0);
   }
-  GET_ARRAY_ARG(H_pkt,0,leng,eth_pkt)
-  //--------------------parsing
-  idx = 0;
-  if (preamble&(leng>=8)) {
-      //vpi_printf("preamble: 0x");
-      //for (idy=0; idy<8; idy++) vpi_printf("%02X",eth_pkt[idy]);
-      //vpi_printf("\n");
-      idx = 8;
+  GET_INT_ARG(tf_ctx->arg[1],PLI_INT32 ,leng    )
+  GET_INT_ARG(tf_ctx->arg[2],PLI_UINT32,preamble)
+  GET_INT_ARG(tf_ctx->arg[5],PLI_UINT32,add_crc )
+  GET_INT_ARG(tf_ctx->arg[6],PLI_UINT32,add_preamble)
+  if (pkt_fit_array(tf_ctx,0,leng,__FUNCTION__)) {
+      pkt_control(vpiFinish);
+      return(0);
   }
-  parser_eth_packet(&eth_pkt[idx], leng-idx);
-  type_leng  = eth_pkt[idx+12]<<8;
-  type_leng |= eth_pkt[idx+13];
-  //if (leng>=(idx+6)) {
-  //    vpi_printf("mac dst  : 0x");
-  //    for (idy=0; idy<6; idy++) vpi_printf("%02X",eth_pkt[idx++]);
-  //    vpi_printf("\n");
-  //} else goto end;
-  //if (leng>=(idx+6)) {
-  //    vpi_printf("mac src  : 0x");
-  //    for (idy=0; idy<6; idy++) vpi_printf("%02X",eth_pkt[idx++]);
-  //    vpi_printf("\n");
-  //} else goto end;
-  //if (leng>=(idx+2)) {
-  //    type_leng  = eth_pkt[idx++]<<8;
-  //    type_leng |= eth_pkt[idx++];
-  //    vpi_printf("type leng: 0x%04X", type_leng);
-  //    switch (type_leng) {
-  //    case 0x0800: vpi_printf(" IPv4  packet\n"); break;
-  //    case 0x0806: vpi_printf(" ARP   packet\n"); break;
-  //    case 0x08DD: vpi_printf(" IPv6  packet\n"); break;
-  //    case 0x8100: vpi_printf(" VLAN  packet\n"); break;
-  //    case 0x88F7: vpi_printf(" PTPv2 raw packet\n"); break;
-  //    default:     vpi_printf("\n"); break;
-  //    }
-  //} else goto end;
-  if (type_leng==0x0800) { // IP packet
-      uint8_t protocol = eth_pkt[idx+14+9];
-      if (protocol==0x11) { // UDP
-          uint16_t port_src  = eth_pkt[idx+14+20]<<8;
-                   port_src |= eth_pkt[idx+14+21];
-          uint16_t port_dst  = eth_pkt[idx+14+22]<<8;
-                   port_dst |= eth_pkt[idx+14+23];
-          if ((port_src==319)||(port_src==320)||
-              (port_dst==319)||(port_dst==320)) {
-             vpi_flush(); vpi_printf("\n");
-             fflush(stderr); fflush(stdout);
-             parser_ptpv2_message(&eth_pkt[idx+14+28],leng-idx-14-28);
-             fflush(stderr); fflush(stdout);
-          }
-      }
+  // reply is built in place, which is 8 bytes longer with preamble and
+  // 46-byte minimum payload and CRC at most
+  eth_pkt = vpi_scratch(VPI_SCRATCH_PKT, leng+8+64);
+  if (eth_pkt==NULL) {
+      vpi_printf("ERROR: scratch buffer error.\n");
+      pkt_control(vpiFinish);
+      return(0);
   }
-  if (type_leng==0x88F7) { // PTPv2 raw packet
-      vpi_flush(); vpi_printf("\n");
-      fflush(stderr); fflush(stdout);
-      parser_ptpv2_message(&eth_pkt[idx+14],leng-idx-14);
-      fflush(stderr); fflush(stdout);
+  GET_ARRAY_ARG(vpi_tf_ctx_array(tf_ctx,0),0,leng,eth_pkt)
+  idx = (preamble&&(leng>=8)) ? 8 : 0;
+  tmp = gen_eth_icmp_echo_reply(eth_pkt, &eth_pkt[idx], leng-idx, add_crc, add_preamble);
+  if (tmp>0) {
+      if (pkt_fit_array(tf_ctx,3,tmp,__FUNCTION__)) {
+          pkt_control(vpiFinish);
+          return(0);
+      }
+      PUT_ARRAY_ARG(vpi_tf_ctx_array(tf_ctx,3),0,tmp,eth_pkt)
   }
-
-  //--------------------return
-end:
-  free(eth_pkt);
-  vpi_free_object(arg_iterator);
-
+  if (pkt_put_bnum(tf_ctx->arg[4], tmp, __FUNCTION__)) pkt_control(vpiFinish);
   return(0);
 }
 
@@ -2339,6 +6035,61 @@ PLI_INT32 pkt_eth_verbose_Sizetf(PLI_BYTE8 *user_data) {
   return(32); /* $pkt_verbose() returns 32-bit */
 }
 
+//----------------------------------------------------------------------------
+// $pkt_wallclock
+//----------------------------------------------------------------------------
+PLI_INT32 pkt_wallclock_Calltf(PLI_BYTE8 *user_data) {
+  vpiHandle systf_handle;
+  s_vpi_value value;
+  s_vpi_vecval vector[2];
+  uint64_t usec;
+
+  systf_handle = vpi_handle(vpiSysTfCall, NULL);
+  usec = vpi_wallclock_usec();
+  vector[0].aval = (PLI_INT32)(usec&0xFFFFFFFF);
+  vector[0].bval = 0;
+  vector[1].aval = (PLI_INT32)(usec>>32);
+  vector[1].bval = 0;
+  value.format = vpiVectorVal;
+  value.value.vector = vector;
+  vpi_put_value(systf_handle, &value, NULL, vpiNoDelay);
+  return(0);
+}
+
+//----------------------------------------------------------------------------
+PLI_INT32 pkt_wallclock_Sizetf(PLI_BYTE8 *user_data) {
+  return(64); /* $pkt_wallclock returns 64-bit */
+}
+
+//----------------------------------------------------------------------------
+// $pkt_vpi_handles
+//----------------------------------------------------------------------------
+PLI_INT32 pkt_vpi_handles_Calltf(PLI_BYTE8 *user_data) {
+  vpiHandle systf_handle;
+  s_vpi_value value;
+
+  systf_handle = vpi_handle(vpiSysTfCall, NULL);
+  value.format = vpiIntVal;
+  value.value.integer = vpi_handle_count();
+  vpi_put_value(systf_handle, &value, NULL, vpiNoDelay);
+  return(0);
+}
+
+//----------------------------------------------------------------------------
+PLI_INT32 pkt_vpi_handles_Sizetf(PLI_BYTE8 *user_data) {
+  return(32); /* $pkt_vpi_handles returns 32-bit */
+}
+
+//----------------------------------------------------------------------------
+// It releases all handles kept by the library.
+PLI_INT32 pkt_end_of_sim(p_cb_data cb_data) {
+  pkt_template_cleanup();
+  pkt_stream_cleanup();
+  vpi_tf_ctx_cleanup();
+  vpi_scratch_release();
+  return(0);
+}
+
 //----------------------------------------------------------------------------
 void (*vlog_startup_routines[])() = {
       pkt_register,
@@ -0,0 +1,523 @@
+//----------------------------------------------------------------------------
+// Copyright (c) 2019 by Ando Ki.
+// All right reserved.
+//----------------------------------------------------------------------------
+// network_vpi_util.c
+//----------------------------------------------------------------------------
+// VERSION = 2019.05.20.
+//----------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#if defined(_MSC_VER)
+#   include <windows.h>
+#else
+#   include <sys/time.h>
+#endif
+#include "network_vpi_util.h"
+
+//----------------------------------------------------------------------------
+static int         m_mode=-1;   // one of VPI_ARRAY_MODE_*
+static vpi_tf_ctx_t *m_tf_ctx=NULL; // all call-site contexts
+static uint32_t    m_handle_count=0; // num of handles obtained by the library
+static uint8_t    *m_scratch     [VPI_SCRATCH_NUM]={NULL}; // see vpi_scratch()
+static int         m_scratch_size[VPI_SCRATCH_NUM]={0};
+static s_vpi_vecval *m_vec_buf=NULL; // staging buffer for packed vector
+static int         m_vec_num=0;
+#if defined(VPI_VALUE_ARRAY)
+static int         m_bulk_ok=1; // cleared when the simulator refuses bulk transfer
+static PLI_INT32  *m_int_buf=NULL; // staging buffer for bulk transfer
+static int         m_int_num=0;
+#endif
+
+//----------------------------------------------------------------------------
+// NETWORK_VPI_ARRAY=bulk|cache|index
+int vpi_array_mode(void)
+{
+    if (m_mode<0) {
+        char *str = getenv("NETWORK_VPI_ARRAY");
+        m_mode = VPI_ARRAY_MODE_BULK;
+        if (str!=NULL) {
+                 if (!strcmp(str, "cache")) m_mode = VPI_ARRAY_MODE_CACHE;
+            else if (!strcmp(str, "index")) m_mode = VPI_ARRAY_MODE_INDEX;
+        }
+#if !defined(VPI_VALUE_ARRAY)
+        if (m_mode==VPI_ARRAY_MODE_BULK) m_mode = VPI_ARRAY_MODE_CACHE;
+#endif
+    }
+    return m_mode;
+}
+
+//----------------------------------------------------------------------------
+// Returns num of handles obtained by the library so far.
+// It does not grow when the same call site is called again.
+uint32_t vpi_handle_count(void)
+{
+    return m_handle_count;
+}
+
+//----------------------------------------------------------------------------
+// Returns 0 on success.
+int vpi_array_init(vpi_array_t *array, vpiHandle handle)
+{
+    memset((void*)array, 0, sizeof(vpi_array_t));
+    array->handle = handle;
+    if (vpi_get(vpiArray, handle)!=1) { // packed vector
+        array->vector = 1;
+        array->num    = vpi_get(vpiSize, handle)/8;
+        array->width  = 8;
+        array->left   = 0;
+        array->right  = (array->num>0) ? array->num-1 : 0;
+        return 0;
+    }
+    array->num    = vpi_get(vpiSize, handle);
+    array->left   = vpi_get(vpiLeftRange, handle);
+    array->right  = vpi_get(vpiRightRange, handle);
+    if (array->num<=0) array->num = 0;
+    if (array->num>0) {
+        vpiHandle ele = vpi_handle_by_index(handle, array->left);
+        array->width = (ele!=NULL) ? vpi_get(vpiSize, ele) : 8;
+        if (ele!=NULL) vpi_free_object(ele);
+    }
+    return 0;
+}
+
+//----------------------------------------------------------------------------
+void vpi_array_release(vpi_array_t *array)
+{
+    int idx;
+    if (array->row!=NULL) {
+        for (idx=0; idx<array->rows; idx++) vpi_array_release(&array->row[idx]);
+        free(array->row);
+    }
+    if (array->ele!=NULL) {
+        for (idx=0; idx<array->num; idx++) {
+             if (array->ele[idx]!=NULL) vpi_free_object(array->ele[idx]);
+        }
+        free(array->ele);
+    }
+    memset((void*)array, 0, sizeof(vpi_array_t));
+}
+
+//----------------------------------------------------------------------------
+// Returns element handle of index 'index'.
+static vpiHandle vpi_array_element(vpi_array_t *array, int index)
+{
+    int low = (array->left<array->right) ? array->left : array->right;
+    int off = index - low;
+    if ((off<0)||(off>=array->num)) return NULL;
+    if (vpi_array_mode()==VPI_ARRAY_MODE_INDEX) {
+        m_handle_count++;
+        return vpi_handle_by_index(array->handle, index);
+    }
+    if (array->ele==NULL) {
+        array->ele = (vpiHandle*)calloc(array->num, sizeof(vpiHandle));
+        if (array->ele==NULL) return vpi_handle_by_index(array->handle, index);
+    }
+    if (array->ele[off]==NULL) {
+        array->ele[off] = vpi_handle_by_index(array->handle, index);
+        m_handle_count++;
+    }
+    return array->ele[off];
+}
+
+//----------------------------------------------------------------------------
+// It limits 'num' not to go beyond the array.
+static int vpi_array_clip(vpi_array_t *array, int start, int num)
+{
+    int low  = (array->left<array->right) ? array->left : array->right;
+    int high = low + array->num - 1;
+    if ((num<=0)||(start<low)||(start>high)) return 0;
+    if ((start+num-1)>high) num = high - start + 1;
+    return num;
+}
+
+//----------------------------------------------------------------------------
+#if defined(VPI_VALUE_ARRAY)
+static PLI_INT32 *vpi_array_int_buf(int num)
+{
+    if (num>m_int_num) {
+        PLI_INT32 *buf = (PLI_INT32*)realloc(m_int_buf, num*sizeof(PLI_INT32));
+        if (buf==NULL) return NULL;
+        m_int_buf = buf;
+        m_int_num = num;
+    }
+    return m_int_buf;
+}
+
+//----------------------------------------------------------------------------
+// Returns 1 when bulk transfer can be tried on the array.
+// Only ascending array is used since the order of the elements
+// for the descending array differs from simulator to simulator.
+static int vpi_array_bulk(vpi_array_t *array)
+{
+    return (vpi_array_mode()==VPI_ARRAY_MODE_BULK)&&m_bulk_ok&&
+           (array->left<=array->right);
+}
+#endif
+
+//----------------------------------------------------------------------------
+void vpi_bytes_to_vecval( s_vpi_vecval  *vec
+                        , int            vnum
+                        , int            start
+                        , int            num
+                        , const uint8_t *buf)
+{
+    int idx=0, off;
+    memset((void*)vec, 0, vnum*sizeof(s_vpi_vecval));
+    if ((start&0x3)==0) { // word by word
+        s_vpi_vecval *pv = &vec[start>>2];
+        for (; (idx+4)<=num; idx+=4, pv++) {
+             pv->aval = (PLI_INT32)( (uint32_t)buf[idx  ]
+                                   |((uint32_t)buf[idx+1]<< 8)
+                                   |((uint32_t)buf[idx+2]<<16)
+                                   |((uint32_t)buf[idx+3]<<24));
+        }
+    }
+    for (; idx<num; idx++) {
+         off = start + idx;
+         vec[off>>2].aval |= (PLI_INT32)((uint32_t)buf[idx]<<(8*(off&0x3)));
+    }
+}
+
+//----------------------------------------------------------------------------
+void vpi_vecval_to_bytes( uint8_t            *buf
+                        , const s_vpi_vecval *vec
+                        , int                 start
+                        , int                 num)
+{
+    int idx=0, off;
+    uint32_t val;
+    if ((start&0x3)==0) { // word by word
+        const s_vpi_vecval *pv = &vec[start>>2];
+        for (; (idx+4)<=num; idx+=4, pv++) {
+             val = (uint32_t)pv->aval&~(uint32_t)pv->bval;
+             buf[idx  ] =  val     &0xFF;
+             buf[idx+1] = (val>> 8)&0xFF;
+             buf[idx+2] = (val>>16)&0xFF;
+             buf[idx+3] = (val>>24)&0xFF;
+        }
+    }
+    for (; idx<num; idx++) {
+         off = start + idx;
+         val = (uint32_t)vec[off>>2].aval&~(uint32_t)vec[off>>2].bval;
+         buf[idx] = (val>>(8*(off&0x3)))&0xFF;
+    }
+}
+
+//----------------------------------------------------------------------------
+static s_vpi_vecval *vpi_vecval_buf(int num)
+{
+    if (num>m_vec_num) {
+        s_vpi_vecval *buf = (s_vpi_vecval*)realloc(m_vec_buf, num*sizeof(s_vpi_vecval));
+        if (buf==NULL) return NULL;
+        m_vec_buf = buf;
+        m_vec_num = num;
+    }
+    return m_vec_buf;
+}
+
+//----------------------------------------------------------------------------
+// The whole vector is written at once,
+// so that bytes other than 'start' to 'start+num-1' become 0.
+static int vpi_vector_put( vpi_array_t   *array
+                         , int            start
+                         , int            num
+                         , const uint8_t *buf)
+{
+    s_vpi_value value;
+    int vnum = (array->num+3)/4;
+    s_vpi_vecval *vec = vpi_vecval_buf(vnum);
+    if (vec==NULL) return 0;
+    vpi_bytes_to_vecval(vec, vnum, start, num, buf);
+    value.format = vpiVectorVal;
+    value.value.vector = vec;
+    vpi_put_value(array->handle, &value, NULL, vpiNoDelay);
+    return num;
+}
+
+//----------------------------------------------------------------------------
+static int vpi_vector_get( vpi_array_t *array
+                         , int          start
+                         , int          num
+                         , uint8_t     *buf)
+{
+    s_vpi_value value;
+    value.format = vpiVectorVal;
+    vpi_get_value(array->handle, &value);
+    vpi_vecval_to_bytes(buf, value.value.vector, start, num);
+    return num;
+}
+
+//----------------------------------------------------------------------------
+// Writes bytes of 'buf8' or integers of 'buf32' whichever is not NULL.
+static int vpi_array_put_val( vpi_array_t     *array
+                            , int              start
+                            , int              num
+                            , const uint8_t   *buf8
+                            , const PLI_INT32 *buf32)
+{
+    s_vpi_value value;
+    int idx;
+
+#if defined(VPI_VALUE_ARRAY)
+    if (vpi_array_bulk(array)) {
+        s_vpi_arrayvalue arrayvalue;
+        PLI_INT32 index[1];
+        PLI_INT32 *ibuf = vpi_array_int_buf(num);
+        if (ibuf!=NULL) {
+            if (buf8!=NULL) for (idx=0; idx<num; idx++) ibuf[idx] = buf8[idx];
+            else            memcpy((void*)ibuf, (void*)buf32, num*sizeof(PLI_INT32));
+            arrayvalue.format = vpiIntVal;
+            arrayvalue.flags  = 0;
+            arrayvalue.value.integers = ibuf;
+            index[0] = start;
+            vpi_put_value_array(array->handle, &arrayvalue, index, num);
+            if (!vpi_chk_error(NULL)) return num;
+            m_bulk_ok = 0; // fall back to element-wise from now on
+        }
+    }
+#endif
+    value.format = vpiIntVal;
+    for (idx=0; idx<num; idx++) {
+         vpiHandle ele = vpi_array_element(array, start+idx);
+         value.value.integer = (buf8!=NULL) ? buf8[idx] : buf32[idx];
+         vpi_put_value(ele, &value, NULL, vpiNoDelay);
+    }
+    return num;
+}
+
+//----------------------------------------------------------------------------
+// Returns num of bytes written.
+int vpi_array_put( vpi_array_t   *array
+                 , int            start
+                 , int            num
+                 , const uint8_t *buf)
+{
+    num = vpi_array_clip(array, start, num);
+    if (num==0) return 0;
+    if (array->vector) return vpi_vector_put(array, start, num, buf);
+    return vpi_array_put_val(array, start, num, buf, NULL);
+}
+
+//----------------------------------------------------------------------------
+// Returns num of elements written, e.g., 'reg [15:0] leng[0:15]'.
+int vpi_array_put_int( vpi_array_t     *array
+                     , int              start
+                     , int              num
+                     , const PLI_INT32 *buf)
+{
+    num = vpi_array_clip(array, start, num);
+    if ((num==0)||array->vector) return 0;
+    return vpi_array_put_val(array, start, num, NULL, buf);
+}
+
+//----------------------------------------------------------------------------
+// Returns row 'row' of 2-D array; row 0 is the left-most one.
+// Rows are prepared when they are first asked and kept.
+// Returns NULL when 'row' is out of range.
+vpi_array_t *vpi_array_row(vpi_array_t *array, int row)
+{
+    if (array->row==NULL) {
+        int num = (array->left<=array->right) ? array->right-array->left+1
+                                              : array->left-array->right+1;
+        array->row = (vpi_array_t*)calloc(num, sizeof(vpi_array_t));
+        if (array->row==NULL) return NULL;
+        array->rows = num;
+    }
+    if ((row<0)||(row>=array->rows)) return NULL;
+    if (array->row[row].handle==NULL) {
+        int index = (array->left<=array->right) ? array->left+row : array->left-row;
+        vpiHandle handle = vpi_handle_by_index(array->handle, index);
+        if (handle==NULL) return NULL;
+        m_handle_count++;
+        vpi_array_init(&array->row[row], handle);
+    }
+    return &array->row[row];
+}
+
+//----------------------------------------------------------------------------
+// Returns num of bytes read.
+int vpi_array_get( vpi_array_t *array
+                 , int          start
+                 , int          num
+                 , uint8_t     *buf)
+{
+    s_vpi_value value;
+    int idx;
+
+    num = vpi_array_clip(array, start, num);
+    if (num==0) return 0;
+    if (array->vector) return vpi_vector_get(array, start, num, buf);
+#if defined(VPI_VALUE_ARRAY)
+    if (vpi_array_bulk(array)) {
+        s_vpi_arrayvalue arrayvalue;
+        PLI_INT32 index[1];
+        PLI_INT32 *ibuf = vpi_array_int_buf(num);
+        if (ibuf!=NULL) {
+            arrayvalue.format = vpiIntVal;
+            arrayvalue.flags  = 0;
+            arrayvalue.value.integers = ibuf;
+            index[0] = start;
+            vpi_get_value_array(array->handle, &arrayvalue, index, num);
+            if (!vpi_chk_error(NULL)) {
+                for (idx=0; idx<num; idx++) buf[idx] = ibuf[idx];
+                return num;
+            }
+            m_bulk_ok = 0; // fall back to element-wise from now on
+        }
+    }
+#endif
+    value.format = vpiIntVal;
+    for (idx=0; idx<num; idx++) {
+         vpiHandle ele = vpi_array_element(array, start+idx);
+         vpi_get_value(ele, &value);
+         buf[idx] = value.value.integer;
+    }
+    return num;
+}
+
+//----------------------------------------------------------------------------
+// It scans all arguments of the call and keeps their handles.
+// It should be called from compiletf after arguments are checked.
+// return NULL on failure, e.g., more than VPI_TF_MAX_ARG arguments
+vpi_tf_ctx_t *vpi_tf_ctx_build(vpiHandle systf_handle)
+{
+    vpi_tf_ctx_t *ctx;
+    vpiHandle arg_iterator, arg_handle;
+    int over=0;
+
+    ctx = (vpi_tf_ctx_t*)vpi_get_userdata(systf_handle);
+    if (ctx!=NULL) return ctx;
+    ctx = (vpi_tf_ctx_t*)calloc(1, sizeof(vpi_tf_ctx_t));
+    if (ctx==NULL) return NULL;
+    arg_iterator = vpi_iterate(vpiArgument, systf_handle);
+    if (arg_iterator!=NULL) {
+        while ((arg_handle=vpi_scan(arg_iterator))!=NULL) {
+            m_handle_count++;
+            if (ctx->num_arg>=VPI_TF_MAX_ARG) {
+                vpi_printf("ERROR: %s must have no more than %d arguments.\n"
+                          , vpi_get_str(vpiName, systf_handle), VPI_TF_MAX_ARG);
+                vpi_free_object(arg_iterator);
+                over = 1;
+                break;
+            }
+            ctx->arg[ctx->num_arg] = arg_handle;
+            if (vpi_get(vpiArray, arg_handle)==1) {
+                vpi_array_t *array = (vpi_array_t*)calloc(1, sizeof(vpi_array_t));
+                if (array!=NULL) vpi_array_init(array, arg_handle);
+                ctx->array[ctx->num_arg] = array;
+            }
+            ctx->num_arg++;
+        }
+    }
+    ctx->next = m_tf_ctx; // kept till vpi_tf_ctx_cleanup() even when 'over'
+    m_tf_ctx  = ctx;
+    if (over) return NULL;
+    vpi_put_userdata(systf_handle, (void*)ctx);
+    return ctx;
+}
+
+//----------------------------------------------------------------------------
+// Returns context of the call; it is built if not yet.
+vpi_tf_ctx_t *vpi_tf_ctx_get(vpiHandle systf_handle)
+{
+    vpi_tf_ctx_t *ctx = (vpi_tf_ctx_t*)vpi_get_userdata(systf_handle);
+    if (ctx==NULL) ctx = vpi_tf_ctx_build(systf_handle);
+    return ctx;
+}
+
+//----------------------------------------------------------------------------
+// Returns array or packed vector of argument 'idx'.
+// Packed vector is prepared when it is first asked.
+vpi_array_t *vpi_tf_ctx_array(vpi_tf_ctx_t *ctx, int idx)
+{
+    if ((idx<0)||(idx>=ctx->num_arg)) return NULL;
+    if (ctx->array[idx]==NULL) {
+        vpi_array_t *array = (vpi_array_t*)calloc(1, sizeof(vpi_array_t));
+        if (array==NULL) return NULL;
+        vpi_array_init(array, ctx->arg[idx]);
+        ctx->array[idx] = array;
+    }
+    return ctx->array[idx];
+}
+
+//----------------------------------------------------------------------------
+// Releases all contexts and handles kept; called at the end of simulation.
+void vpi_tf_ctx_cleanup(void)
+{
+    int idx;
+    while (m_tf_ctx!=NULL) {
+        vpi_tf_ctx_t *ctx = m_tf_ctx;
+        m_tf_ctx = ctx->next;
+        for (idx=0; idx<ctx->num_arg; idx++) {
+            if (ctx->array[idx]!=NULL) {
+                vpi_array_release(ctx->array[idx]);
+                free(ctx->array[idx]);
+            }
+        }
+        free(ctx);
+    }
+    if (m_vec_buf!=NULL) free(m_vec_buf);
+    m_vec_buf = NULL;
+    m_vec_num = 0;
+#if defined(VPI_VALUE_ARRAY)
+    if (m_int_buf!=NULL) free(m_int_buf);
+    m_int_buf = NULL;
+    m_int_num = 0;
+#endif
+}
+
+//----------------------------------------------------------------------------
+// Returns scratch buffer 'id' having at least 'size' bytes.
+// It starts from VPI_SCRATCH_SIZE and grows for jumbo frame,
+// but never shrinks until vpi_scratch_release().
+// Returns NULL on allocation failure.
+uint8_t *vpi_scratch(int id, int size)
+{
+    if ((id<0)||(id>=VPI_SCRATCH_NUM)) return NULL;
+    if (size<1) size = 1;
+    if (size>m_scratch_size[id]) {
+        int num = (m_scratch_size[id]>0) ? m_scratch_size[id] : VPI_SCRATCH_SIZE;
+        uint8_t *buf;
+        while (num<size) num *= 2;
+        buf = (uint8_t*)realloc(m_scratch[id], num);
+        if (buf==NULL) return NULL;
+        m_scratch[id] = buf;
+        m_scratch_size[id] = num;
+    }
+    return m_scratch[id];
+}
+
+//----------------------------------------------------------------------------
+void vpi_scratch_release(void)
+{
+    int id;
+    for (id=0; id<VPI_SCRATCH_NUM; id++) {
+        if (m_scratch[id]!=NULL) free(m_scratch[id]);
+        m_scratch[id] = NULL;
+        m_scratch_size[id] = 0;
+    }
+}
+
+//----------------------------------------------------------------------------
+// Returns host wall-clock time in micro-seconds.
+uint64_t vpi_wallclock_usec(void)
+{
+#if defined(_MSC_VER)
+    LARGE_INTEGER freq, count;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&count);
+    return (uint64_t)((count.QuadPart*1000000.0)/freq.QuadPart);
+#else
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (uint64_t)tv.tv_sec*1000000+tv.tv_usec;
+#endif
+}
+
+//----------------------------------------------------------------------------
+// Revision history:
+//
+// 2019.05.20: Rewritten by Ando Ki (andoki@gmail.com)
+//----------------------------------------------------------------------------
@@ -0,0 +1,131 @@
+#ifndef NETWORK_VPI_UTIL_H
+#define NETWORK_VPI_UTIL_H
+//----------------------------------------------------------------------------
+// Copyright (c) 2019 by Ando Ki.
+// All right reserved.
+//----------------------------------------------------------------------------
+// VERSION = 2019.05.20.
+//----------------------------------------------------------------------------
+// network_vpi_util.h
+//----------------------------------------------------------------------------
+#include <stdint.h>
+#include "vpi_user.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//----------------------------------------------------------------------------
+// Bulk transfer is used when the simulator provides
+// vpi_put_value_array()/vpi_get_value_array() (IEEE 1800-2009 and later).
+// Define NO_VPI_VALUE_ARRAY when the header declares them
+// but the simulator library does not carry them.
+#if defined(vpiUserAllocFlag)&&!defined(NO_VPI_VALUE_ARRAY)
+#define VPI_VALUE_ARRAY
+#endif
+
+//----------------------------------------------------------------------------
+// How array contents are moved between Verilog and C.
+// It can be forced by 'NETWORK_VPI_ARRAY' environment variable.
+#define VPI_ARRAY_MODE_BULK   0 // vpi_put/get_value_array() if possible
+#define VPI_ARRAY_MODE_CACHE  1 // element handles resolved once and reused
+#define VPI_ARRAY_MODE_INDEX  2 // vpi_handle_by_index() for each byte
+
+//----------------------------------------------------------------------------
+// Verilog array of bytes, e.g., 'reg [7:0] pkt[0:4095]',
+// or packed vector of bytes, e.g., 'reg [8*4096-1:0] pkt',
+// where byte 'n' is 'pkt[8*n+7:8*n]'.
+// Packed vector is moved by single vpi_get_value()/vpi_put_value().
+typedef struct vpi_array {
+    vpiHandle  handle; // array or vector handle
+    int        num   ; // num of elements (bytes for vector)
+    int        width ; // bit-width of each element
+    int        left  ; // index of the left-most element
+    int        right ; // index of the right-most element
+    int        vector; // 1 when packed vector
+    vpiHandle *ele   ; // element handles; resolved on demand and kept
+    int        rows  ; // num of rows of 2-D array when 'row' is not NULL
+    struct vpi_array *row; // rows of 2-D array, e.g., 'reg [7:0] pkt[0:15][0:4095]'
+} vpi_array_t;
+
+//----------------------------------------------------------------------------
+// Context of each call site of a task, e.g., each '$pkt_ethernet(...)' line.
+// It is built by compiletf and kept as user data of the call,
+// so that calltf does not look up argument and element handles again.
+#ifndef VPI_TF_MAX_ARG
+#define VPI_TF_MAX_ARG  32
+#endif
+typedef struct vpi_tf_ctx {
+    int          num_arg;
+    vpiHandle    arg  [VPI_TF_MAX_ARG]; // argument handles
+    vpi_array_t *array[VPI_TF_MAX_ARG]; // not NULL when the argument is an array
+    struct vpi_tf_ctx *next; // list of all contexts
+} vpi_tf_ctx_t;
+
+//----------------------------------------------------------------------------
+extern int          vpi_array_mode   (void);
+extern int          vpi_array_init   (vpi_array_t *array, vpiHandle handle);
+extern void         vpi_array_release(vpi_array_t *array);
+extern int          vpi_array_put    ( vpi_array_t   *array
+                                     , int            start // index of the first element
+                                     , int            num   // num of bytes
+                                     , const uint8_t *buf);
+extern int          vpi_array_get    ( vpi_array_t   *array
+                                     , int            start // index of the first element
+                                     , int            num   // num of bytes
+                                     , uint8_t       *buf);
+extern int          vpi_array_put_int( vpi_array_t     *array
+                                     , int              start // index of the first element
+                                     , int              num   // num of elements
+                                     , const PLI_INT32 *buf);
+extern vpi_array_t *vpi_array_row    ( vpi_array_t   *array
+                                     , int            row); // 0 for the left-most row
+
+//----------------------------------------------------------------------------
+// Byte <-> s_vpi_vecval conversion; byte 'n' occupies bits [8*n+7:8*n].
+// vpi_bytes_to_vecval() clears all bits of 'vec' that are not written.
+// vpi_vecval_to_bytes() reads X and Z as 0.
+extern void         vpi_bytes_to_vecval( s_vpi_vecval  *vec
+                                       , int            vnum  // num of words of 'vec'
+                                       , int            start // byte offset in 'vec'
+                                       , int            num   // num of bytes
+                                       , const uint8_t *buf);
+extern void         vpi_vecval_to_bytes( uint8_t            *buf
+                                       , const s_vpi_vecval *vec
+                                       , int                 start // byte offset in 'vec'
+                                       , int                 num); // num of bytes
+
+//----------------------------------------------------------------------------
+extern vpi_tf_ctx_t *vpi_tf_ctx_build  (vpiHandle systf_handle);
+extern vpi_tf_ctx_t *vpi_tf_ctx_get    (vpiHandle systf_handle);
+extern vpi_array_t  *vpi_tf_ctx_array  (vpi_tf_ctx_t *ctx, int idx);
+extern void          vpi_tf_ctx_cleanup(void);
+extern uint32_t      vpi_handle_count  (void);
+
+//----------------------------------------------------------------------------
+// Scratch buffers owned by the library and reused across calls,
+// so that calltf does not allocate packet and payload on each call.
+// Contents are not cleared; builders write all bytes they return.
+#define VPI_SCRATCH_PKT      0 // packet to be built or parsed
+#define VPI_SCRATCH_PAYLOAD  1 // payload read from Verilog
+#define VPI_SCRATCH_AUX      2 // others, e.g., lengths of frames
+#define VPI_SCRATCH_NUM      3
+#ifndef VPI_SCRATCH_SIZE
+#define VPI_SCRATCH_SIZE  2048 // initial size covering the maximum frame
+#endif
+extern uint8_t     *vpi_scratch        (int id, int size);
+extern void         vpi_scratch_release(void);
+
+//----------------------------------------------------------------------------
+extern uint64_t     vpi_wallclock_usec(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+//----------------------------------------------------------------------------
+// Revision history:
+//
+// 2019.05.20: Rewritten by Ando Ki (andoki@gmail.com)
+//----------------------------------------------------------------------------
+#endif /*NETWORK_VPI_UTIL_H*/
@@ -0,0 +1,289 @@
+//----------------------------------------------------------------------------
+// Copyright (c) 2019 by Ando Ki.
+// All right reserved.
+//----------------------------------------------------------------------------
+// VERSION = 2019.05.20.
+//----------------------------------------------------------------------------
+// ARP responder routines.
+// Entries are found by hash of IP address, and learned ones are kept
+// in order of their latest use, so that the least recently used one is
+// dropped in constant time when the cache is full.
+// Local hosts are never dropped.
+//----------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "eth_ip_udp_tcp_pkt.h"
+#include "pkt_arp.h"
+
+//-----------------------------------------------------
+static uint16_t arp_get16(const uint8_t *pt) {
+    return (uint16_t)((pt[0]<<8)|pt[1]);
+}
+static uint32_t arp_get32(const uint8_t *pt) {
+    return ((uint32_t)arp_get16(pt)<<16)|arp_get16(pt+2);
+}
+
+//-----------------------------------------------------
+static int arp_hash(pkt_arp_t *ctx, uint32_t ip)
+{
+    uint32_t hash = ip*0x9E3779B1U;
+    hash ^= hash>>16;
+    return (int)(hash&(uint32_t)ctx->bucket_mask);
+}
+
+//-----------------------------------------------------
+// It takes learned entry 'idx' out of the order of use.
+static void arp_unlink(pkt_arp_t *ctx, int idx)
+{
+    pkt_arp_entry_t *entry = &ctx->entry[idx];
+    if (entry->older==-1) ctx->oldest = entry->newer;
+    else ctx->entry[entry->older].newer = entry->newer;
+    if (entry->newer==-1) ctx->newest = entry->older;
+    else ctx->entry[entry->newer].older = entry->older;
+}
+
+//-----------------------------------------------------
+// It makes learned entry 'idx' the latest one used.
+static void arp_link(pkt_arp_t *ctx, int idx)
+{
+    pkt_arp_entry_t *entry = &ctx->entry[idx];
+    entry->older = ctx->newest;
+    entry->newer = -1;
+    if (ctx->newest==-1) ctx->oldest = idx;
+    else ctx->entry[ctx->newest].newer = idx;
+    ctx->newest = idx;
+}
+
+//-----------------------------------------------------
+// It takes entry 'idx' out of hash chain and order of use,
+// and puts it to free list.
+static void arp_free(pkt_arp_t *ctx, int idx)
+{
+    pkt_arp_entry_t *entry = &ctx->entry[idx];
+    int *pt = &ctx->bucket[arp_hash(ctx, entry->ip)];
+    while ((*pt!=-1)&&(*pt!=idx)) pt = &ctx->entry[*pt].next;
+    if (*pt==idx) *pt = entry->next;
+    if (!entry->local) arp_unlink(ctx, idx);
+    ctx->entries--;
+    memset((void*)entry, 0, sizeof(*entry));
+    entry->next = ctx->free;
+    ctx->free   = idx;
+}
+
+//-----------------------------------------------------
+// It finds entry of 'ip'; -1 if not found.
+static int arp_find(pkt_arp_t *ctx, uint32_t ip)
+{
+    int idx = ctx->bucket[arp_hash(ctx, ip)];
+    while ((idx!=-1)&&(ctx->entry[idx].ip!=ip)) idx = ctx->entry[idx].next;
+    return idx;
+}
+
+//-----------------------------------------------------
+// It adds or updates entry of 'ip', where the least recently used learned
+// one is dropped when no room.
+// return index of the entry, -1 when all are local hosts
+static int arp_set(pkt_arp_t *ctx, uint32_t ip, const uint8_t mac[6], int local)
+{
+    pkt_arp_entry_t *entry;
+    int idx, *head;
+    idx = arp_find(ctx, ip);
+    if (idx>=0) {
+        entry = &ctx->entry[idx];
+        if (!entry->local) arp_unlink(ctx, idx);
+    } else {
+        if (ctx->free==-1) {
+            if (ctx->oldest==-1) return -1;
+            arp_free(ctx, ctx->oldest);
+            ctx->evictions++;
+        }
+        idx   = ctx->free;
+        entry = &ctx->entry[idx];
+        ctx->free = entry->next;
+        entry->ip = ip;
+        head = &ctx->bucket[arp_hash(ctx, ip)];
+        entry->next = *head;
+        *head       = idx;
+        ctx->entries++;
+    }
+    memcpy((void*)entry->mac, (const void*)mac, 6);
+    entry->local = local;
+    if (!local) arp_link(ctx, idx);
+    return idx;
+}
+
+//-----------------------------------------------------
+// max_entries: num of entries kept including local hosts
+// max_queue: num of replies queued till they are taken
+// return NULL on failure
+pkt_arp_t *pkt_arp_create( int max_entries
+                         , int max_queue)
+{
+    pkt_arp_t *ctx;
+    int idx, num;
+    if ((max_entries<=0)||(max_queue<=0)) return NULL;
+    for (num=2; (num<(2*max_entries))&&(num<(1<<30)); num*=2);
+    ctx = (pkt_arp_t*)calloc(1, sizeof(pkt_arp_t));
+    if (ctx==NULL) return NULL;
+    ctx->entry  = (pkt_arp_entry_t*)calloc(max_entries, sizeof(pkt_arp_entry_t));
+    ctx->bucket = (int*)malloc(num*sizeof(int));
+    ctx->queue  = (pkt_arp_reply_t*)calloc(max_queue, sizeof(pkt_arp_reply_t));
+    if ((ctx->entry==NULL)||(ctx->bucket==NULL)||(ctx->queue==NULL)) {
+        pkt_arp_release(ctx);
+        return NULL;
+    }
+    for (idx=0; idx<num; idx++) ctx->bucket[idx] = -1;
+    for (idx=0; idx<max_entries; idx++) ctx->entry[idx].next = idx+1;
+    ctx->entry[max_entries-1].next = -1;
+    ctx->bucket_mask = num-1;
+    ctx->max_entries = max_entries;
+    ctx->max_queue   = max_queue;
+    ctx->free        = 0;
+    ctx->oldest      = -1;
+    ctx->newest      = -1;
+    return ctx;
+}
+
+//-----------------------------------------------------
+void pkt_arp_release(pkt_arp_t *ctx)
+{
+    if (ctx==NULL) return;
+    free(ctx->entry);
+    free(ctx->bucket);
+    free(ctx->queue);
+    free(ctx);
+}
+
+//-----------------------------------------------------
+// local: 1 for local host, for which the responder answers requests
+// return 0 on success, -1 when no room
+int pkt_arp_add( pkt_arp_t *ctx
+               , uint32_t  ip
+               , uint8_t   mac[6]
+               , int       local)
+{
+    if ((ctx==NULL)||(mac==NULL)) return -1;
+    return (arp_set(ctx, ip, mac, (local) ? 1 : 0)<0) ? -1 : 0;
+}
+
+//-----------------------------------------------------
+int pkt_arp_delete(pkt_arp_t *ctx, uint32_t ip)
+{
+    int idx;
+    if (ctx==NULL) return -1;
+    idx = arp_find(ctx, ip);
+    if (idx<0) return -1;
+    arp_free(ctx, idx);
+    return 0;
+}
+
+//-----------------------------------------------------
+// A learned entry found becomes the latest one used.
+pkt_arp_entry_t *pkt_arp_lookup(pkt_arp_t *ctx, uint32_t ip)
+{
+    int idx;
+    if (ctx==NULL) return NULL;
+    idx = arp_find(ctx, ip);
+    if (idx<0) return NULL;
+    if (!ctx->entry[idx].local) {
+        arp_unlink(ctx, idx);
+        arp_link(ctx, idx);
+    }
+    return &ctx->entry[idx];
+}
+
+//-----------------------------------------------------
+// It takes Ethernet frame, which can have VLAN tags and CRC.
+// Sender of ARP is learned as RFC 826, i.e., updated if it is kept already
+// and added if the target is a local host.
+// A reply is queued for a request to a local host.
+// return 1 if reply queued, 0 if not, -1 on error
+int pkt_arp_put( pkt_arp_t *ctx
+               , const uint8_t *eth
+               , int       leng)
+{
+    const uint8_t *arp;
+    pkt_arp_reply_t *reply;
+    pkt_arp_entry_t *entry;
+    uint32_t sip, tip;
+    uint16_t type_len, op;
+    int idx, hdr;
+
+    if ((ctx==NULL)||(eth==NULL)) return -1;
+    hdr = get_eth_type(eth, leng, &type_len);
+    if ((hdr<0)||(type_len!=ETH_TYPE_ARP)) return 0;
+    if (((hdr-ETH_HDR_LEN)/ETH_VLAN_TAG_LEN)>PKT_VLAN_MAX) return 0; // too many tags to reply
+    if (leng<(hdr+ARP_HDR_LEN)) return -1;
+    arp = &eth[hdr];
+    if ((arp_get16(&arp[0])!=ARP_HRD_ETHERNET)||(arp_get16(&arp[2])!=ARP_PRO_IP)||
+        (arp[4]!=ETH_ADDR_LEN)||(arp[5]!=4)) return 0;
+    op  = arp_get16(&arp[6]);
+    sip = arp_get32(&arp[14]);
+    tip = arp_get32(&arp[24]);
+
+    //-------------------------------------------------
+    idx   = arp_find(ctx, tip);
+    entry = (idx<0) ? NULL : &ctx->entry[idx];
+    if ((entry!=NULL)&&!entry->local) entry = NULL;
+    idx = arp_find(ctx, sip);
+    if (((idx>=0)&&!ctx->entry[idx].local)||((idx<0)&&(entry!=NULL)&&sip)) {
+        arp_set(ctx, sip, &arp[8], 0);
+        ctx->learned++;
+    }
+    if ((op!=ARP_OP_REQUEST)||(entry==NULL)) return 0;
+    ctx->requests++;
+
+    //-------------------------------------------------
+    if (ctx->queue_num>=ctx->max_queue) {
+        ctx->drops++;
+        return 0;
+    }
+    reply = &ctx->queue[(ctx->queue_head+ctx->queue_num)%ctx->max_queue];
+    memcpy((void*)reply->mac_src, (void*)entry->mac, 6);
+    memcpy((void*)reply->mac_dst, (const void*)&arp[8], 6);
+    reply->ip_src   = tip;
+    reply->ip_dst   = sip;
+    reply->vlan_num = (hdr-ETH_HDR_LEN)/ETH_VLAN_TAG_LEN;
+    for (idx=0; idx<reply->vlan_num; idx++) {
+         reply->vlan[idx].tpid = arp_get16(&eth[12+idx*ETH_VLAN_TAG_LEN]);
+         reply->vlan[idx].tci  = arp_get16(&eth[14+idx*ETH_VLAN_TAG_LEN]);
+    }
+    ctx->queue_num++;
+    return 1;
+}
+
+//-----------------------------------------------------
+// It builds the oldest reply queued, which has tags of its request.
+// return num of bytes of the frame, 0 if none
+int pkt_arp_get( pkt_arp_t *ctx
+               , uint8_t  *packet
+               , int add_crc
+               , int add_preamble)
+{
+    pkt_arp_reply_t *reply;
+    int len;
+    if ((ctx==NULL)||(ctx->queue_num==0)) return 0;
+    reply = &ctx->queue[ctx->queue_head];
+    len = gen_eth_arp_packet_vlan( packet
+                                 , reply->mac_src
+                                 , reply->mac_dst
+                                 , reply->vlan
+                                 , reply->vlan_num
+                                 , ARP_OP_REPLY
+                                 , reply->ip_src
+                                 , reply->ip_dst
+                                 , add_crc
+                                 , add_preamble);
+    ctx->queue_head = (ctx->queue_head+1)%ctx->max_queue;
+    ctx->queue_num--;
+    ctx->replies++;
+    return len;
+}
+
+//----------------------------------------------------------------------------
+// Revision history:
+//
+// 2019.05.20: Rewritten by Ando Ki (andoki@gmail.com)
+//----------------------------------------------------------------------------
@@ -0,0 +1,88 @@
+#ifndef PKT_ARP_H
+#define PKT_ARP_H
+//----------------------------------------------------------------------------
+// Copyright (c) 2019 by Ando Ki.
+// All right reserved.
+//----------------------------------------------------------------------------
+// VERSION = 2019.05.20.
+//----------------------------------------------------------------------------
+// ARP responder: it answers ARP requests for local hosts, which are
+// emulated by the model, and learns sender of ARP frames in a cache
+// keyed by IP address, where replies are queued till they are taken.
+//----------------------------------------------------------------------------
+#include <stdint.h>
+#include "eth_ip_udp_tcp_pkt.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//----------------------------------------------------------------------------
+// Entry of the cache.
+typedef struct pkt_arp_entry {
+    uint32_t  ip;       // host order
+    uint8_t   mac[6];   // network order
+    int       local;    // 1 for local host answered by the responder; never dropped
+    int       next;     // next in hash chain or free list; -1 if none
+    int       older;    // order of the latest use of learned ones; -1 if none
+    int       newer;
+} pkt_arp_entry_t;
+
+// Reply queued, which is built when it is taken.
+typedef struct pkt_arp_reply {
+    uint8_t   mac_src[6]; // local host
+    uint8_t   mac_dst[6]; // requester
+    uint32_t  ip_src;     // host order
+    uint32_t  ip_dst;     // host order
+    pkt_vlan_t vlan[PKT_VLAN_MAX]; // tags of the request
+    int       vlan_num;
+} pkt_arp_reply_t;
+
+typedef struct pkt_arp {
+    pkt_arp_entry_t *entry; // 'max_entries' entries
+    int      *bucket;   // heads of hash chains
+    int       bucket_mask;
+    int       max_entries;
+    int       free;     // free list
+    int       oldest;   // order of the latest use of learned entries
+    int       newest;
+    int       entries;  // num of entries kept
+    pkt_arp_reply_t *queue; // ring of 'max_queue' replies
+    int       max_queue;
+    int       queue_head;
+    int       queue_num;
+    uint64_t  requests; // requests for local hosts
+    uint64_t  replies;  // replies taken
+    uint64_t  learned;  // entries added or updated by frames
+    uint64_t  evictions;// learned entries dropped by 'max_entries'
+    uint64_t  drops;    // replies dropped by 'max_queue'
+} pkt_arp_t;
+
+//----------------------------------------------------------------------------
+extern pkt_arp_t *pkt_arp_create( int max_entries // num of entries kept
+                                , int max_queue); // num of replies queued; NULL on failure
+extern void pkt_arp_release( pkt_arp_t *ctx );
+extern int  pkt_arp_add( pkt_arp_t *ctx
+                       , uint32_t  ip     // host order
+                       , uint8_t   mac[6] // network order
+                       , int       local);// 1 for local host; returns 0 on success
+extern int  pkt_arp_delete( pkt_arp_t *ctx, uint32_t ip ); // returns 0 on success
+extern pkt_arp_entry_t *pkt_arp_lookup( pkt_arp_t *ctx, uint32_t ip ); // NULL if none
+extern int  pkt_arp_put( pkt_arp_t *ctx
+                       , const uint8_t *eth // Ethernet frame without preamble
+                       , int       leng);   // returns 1 if reply queued, 0 if not, -1 on error
+extern int  pkt_arp_get( pkt_arp_t *ctx
+                       , uint8_t  *packet   // reply frame; at least 8+64+PKT_VLAN_MAX*4 bytes
+                       , int add_crc
+                       , int add_preamble); // returns num of bytes, 0 if none
+
+#ifdef __cplusplus
+}
+#endif
+
+//----------------------------------------------------------------------------
+// Revision history:
+//
+// 2019.05.20: Rewritten by Ando Ki (andoki@gmail.com)
+//----------------------------------------------------------------------------
+#endif /*PKT_ARP_H*/
@@ -0,0 +1,105 @@
+//----------------------------------------------------------------------------
+// Copyright (c) 2019 by Ando Ki.
+// All right reserved.
+//----------------------------------------------------------------------------
+// VERSION = 2019.05.20.
+//----------------------------------------------------------------------------
+// Packet buffer routines.
+// A packet grows at its front by pkt_buf_push() and at its tail by pkt_buf_put(),
+// while its bytes stay where they are.
+//----------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "pkt_buf.h"
+
+//-----------------------------------------------------
+// It prepares empty packet on 'mem', where 'headroom' bytes are
+// left for headers to be prepended.
+// return 0 on success, -1 on failure
+int pkt_buf_init(pkt_buf_t *buf, uint8_t *mem, int size, int headroom) {
+    if ((buf==NULL)||(mem==NULL)||(headroom<0)||(headroom>size)) return -1;
+    buf->head = mem;
+    buf->data = mem+headroom;
+    buf->len  = 0;
+    buf->size = size;
+    buf->own  = 0;
+    return 0;
+}
+
+//-----------------------------------------------------
+// It allocates a buffer of 'size' bytes as well as its descriptor.
+pkt_buf_t *pkt_buf_alloc(int size, int headroom) {
+    pkt_buf_t *buf;
+    uint8_t *mem;
+    if ((size<=0)||(headroom<0)||(headroom>size)) return NULL;
+    buf = (pkt_buf_t*)calloc(1, sizeof(pkt_buf_t));
+    if (buf==NULL) return NULL;
+    mem = (uint8_t*)malloc(size);
+    if (mem==NULL) { free(buf); return NULL; }
+    pkt_buf_init(buf, mem, size, headroom);
+    buf->own = 1;
+    return buf;
+}
+
+//-----------------------------------------------------
+void pkt_buf_release(pkt_buf_t *buf) {
+    if (buf==NULL) return;
+    if (buf->own) {
+        free(buf->head);
+        free(buf);
+    }
+}
+
+//-----------------------------------------------------
+int pkt_buf_headroom(const pkt_buf_t *buf) {
+    return (int)(buf->data-buf->head);
+}
+
+//-----------------------------------------------------
+int pkt_buf_tailroom(const pkt_buf_t *buf) {
+    return buf->size-pkt_buf_headroom(buf)-buf->len;
+}
+
+//-----------------------------------------------------
+// It adds 'num' bytes in front of the packet and returns the new front.
+uint8_t *pkt_buf_push(pkt_buf_t *buf, int num) {
+    if ((num<0)||(num>pkt_buf_headroom(buf))) return NULL;
+    buf->data -= num;
+    buf->len  += num;
+    return buf->data;
+}
+
+//-----------------------------------------------------
+// It removes 'num' bytes from front of the packet and returns the new front.
+uint8_t *pkt_buf_pull(pkt_buf_t *buf, int num) {
+    if ((num<0)||(num>buf->len)) return NULL;
+    buf->data += num;
+    buf->len  -= num;
+    return buf->data;
+}
+
+//-----------------------------------------------------
+// It adds 'num' bytes at the end of the packet and returns the first of them.
+uint8_t *pkt_buf_put(pkt_buf_t *buf, int num) {
+    uint8_t *tail = buf->data+buf->len;
+    if ((num<0)||(num>pkt_buf_tailroom(buf))) return NULL;
+    buf->len += num;
+    return tail;
+}
+
+//-----------------------------------------------------
+// It cuts the packet to 'len' bytes.
+// return 0 on success, -1 on failure
+int pkt_buf_trim(pkt_buf_t *buf, int len) {
+    if ((len<0)||(len>buf->len)) return -1;
+    buf->len = len;
+    return 0;
+}
+
+//----------------------------------------------------------------------------
+// Revision history:
+//
+// 2019.05.20: Rewritten by Ando Ki (andoki@gmail.com)
+//----------------------------------------------------------------------------
@@ -0,0 +1,59 @@
+#ifndef PKT_BUF_H
+#define PKT_BUF_H
+//----------------------------------------------------------------------------
+// Copyright (c) 2019 by Ando Ki.
+// All right reserved.
+//----------------------------------------------------------------------------
+// VERSION = 2019.05.20.
+//----------------------------------------------------------------------------
+// Packet buffer with headroom and tailroom.
+// Payload is placed first and headers of each layer are prepended to it
+// by pkt_buf_push(), so that no offset is computed backwards nor copied.
+//
+//   head         data              data+len           head+size
+//    |<-headroom->|<------len------->|<----tailroom---->|
+//----------------------------------------------------------------------------
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//----------------------------------------------------------------------------
+typedef struct pkt_buf {
+    uint8_t *head; // the first byte of buffer
+    uint8_t *data; // the first byte of packet
+    int      len ; // num of bytes of packet
+    int      size; // num of bytes of buffer
+    int      own ; // 'head' is freed by pkt_buf_release() when 1
+} pkt_buf_t;
+
+//----------------------------------------------------------------------------
+// Room to be reserved for all headers followed by payload,
+// i.e., preamble, Ethernet, IP and TCP.
+#define PKT_BUF_HEADROOM  (8+14+20+20)
+
+//----------------------------------------------------------------------------
+extern int        pkt_buf_init    ( pkt_buf_t *buf
+                                  , uint8_t   *mem      // buffer given by the caller
+                                  , int        size     // num of bytes of 'mem'
+                                  , int        headroom);
+extern pkt_buf_t *pkt_buf_alloc   ( int size, int headroom ); // NULL on failure
+extern void       pkt_buf_release ( pkt_buf_t *buf );
+extern int        pkt_buf_headroom( const pkt_buf_t *buf );
+extern int        pkt_buf_tailroom( const pkt_buf_t *buf );
+extern uint8_t   *pkt_buf_push    ( pkt_buf_t *buf, int num ); // prepend; NULL if no room
+extern uint8_t   *pkt_buf_pull    ( pkt_buf_t *buf, int num ); // strip;   NULL if too short
+extern uint8_t   *pkt_buf_put     ( pkt_buf_t *buf, int num ); // append;  NULL if no room
+extern int        pkt_buf_trim    ( pkt_buf_t *buf, int len ); // cut tail to 'len'
+
+#ifdef __cplusplus
+}
+#endif
+
+//----------------------------------------------------------------------------
+// Revision history:
+//
+// 2019.05.20: Rewritten by Ando Ki (andoki@gmail.com)
+//----------------------------------------------------------------------------
+#endif /*PKT_BUF_H*/
@@ -0,0 +1,364 @@
+//----------------------------------------------------------------------------
+// Copyright (c) 2019 by Ando Ki.
+// All right reserved.
+//----------------------------------------------------------------------------
+// VERSION = 2019.05.20.
+//----------------------------------------------------------------------------
+// IPv4 reassembly routines.
+// Datagrams in reassembly are found by hash of (src, dst, protocol, id),
+// and are kept in arrival order of their first fragments, so that both
+// lookup and timeout take constant time regardless of num of datagrams.
+// Each datagram keeps holes sorted, where a fragment finds its hole by
+// binary search.
+//----------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "eth_ip_udp_tcp_pkt.h"
+#include "pkt_reasm.h"
+
+//-----------------------------------------------------
+static uint16_t reasm_get16(const uint8_t *pt) {
+    return (uint16_t)((pt[0]<<8)|pt[1]);
+}
+static uint32_t reasm_get32(const uint8_t *pt) {
+    return ((uint32_t)reasm_get16(pt)<<16)|reasm_get16(pt+2);
+}
+static void reasm_put16(uint8_t *pt, uint16_t value) {
+    pt[0] = value>>8;
+    pt[1] = value&0xFF;
+}
+
+//-----------------------------------------------------
+static int reasm_hash( pkt_reasm_t *ctx
+                     , uint32_t ip_src, uint32_t ip_dst
+                     , uint8_t protocol, uint16_t ip_id)
+{
+    uint32_t hash = (ip_src*0x9E3779B1U)^(ip_dst*0x85EBCA77U)
+                  ^(((uint32_t)ip_id<<8)|protocol)*0xC2B2AE3DU;
+    hash ^= hash>>16;
+    return (int)(hash&(uint32_t)ctx->bucket_mask);
+}
+
+//-----------------------------------------------------
+// It takes flow 'idx' out of hash chain and arrival order,
+// and puts it to free list.
+static void reasm_free(pkt_reasm_t *ctx, int idx)
+{
+    pkt_reasm_flow_t *flow = &ctx->flow[idx];
+    int *pt = &ctx->bucket[reasm_hash(ctx, flow->ip_src, flow->ip_dst, flow->protocol, flow->ip_id)];
+    while ((*pt!=-1)&&(*pt!=idx)) pt = &ctx->flow[*pt].next;
+    if (*pt==idx) *pt = flow->next;
+    if (flow->older==-1) ctx->oldest = flow->newer;
+    else ctx->flow[flow->older].newer = flow->newer;
+    if (flow->newer==-1) ctx->newest = flow->older;
+    else ctx->flow[flow->newer].older = flow->older;
+    ctx->bytes -= flow->size;
+    ctx->flows--;
+    free(flow->data);
+    free(flow->hole);
+    memset((void*)flow, 0, sizeof(*flow));
+    flow->next = ctx->free;
+    ctx->free  = idx;
+}
+
+//-----------------------------------------------------
+// It finds flow of the key; -1 if not found.
+static int reasm_find( pkt_reasm_t *ctx
+                     , uint32_t ip_src, uint32_t ip_dst
+                     , uint8_t protocol, uint16_t ip_id)
+{
+    int idx = ctx->bucket[reasm_hash(ctx, ip_src, ip_dst, protocol, ip_id)];
+    while (idx!=-1) {
+        pkt_reasm_flow_t *flow = &ctx->flow[idx];
+        if ((flow->ip_src==ip_src)&&(flow->ip_dst==ip_dst)&&
+            (flow->protocol==protocol)&&(flow->ip_id==ip_id)) return idx;
+        idx = flow->next;
+    }
+    return -1;
+}
+
+//-----------------------------------------------------
+// It makes a new flow, where the oldest one is dropped when no room.
+// return index of the flow, -1 on failure
+static int reasm_new( pkt_reasm_t *ctx
+                    , uint32_t ip_src, uint32_t ip_dst
+                    , uint8_t protocol, uint16_t ip_id
+                    , uint64_t now)
+{
+    pkt_reasm_flow_t *flow;
+    int idx, *head;
+    if (ctx->free==-1) {
+        reasm_free(ctx, ctx->oldest);
+        ctx->stat.drops++;
+    }
+    idx  = ctx->free;
+    flow = &ctx->flow[idx];
+    ctx->free = flow->next;
+    flow->hole = (pkt_reasm_hole_t*)malloc(4*sizeof(pkt_reasm_hole_t));
+    if (flow->hole==NULL) {
+        flow->next = ctx->free;
+        ctx->free  = idx;
+        return -1;
+    }
+    flow->hole[0].first = 0;
+    flow->hole[0].last  = PKT_REASM_INF;
+    flow->hole_num = 1;
+    flow->hole_max = 4;
+    flow->ip_src   = ip_src;
+    flow->ip_dst   = ip_dst;
+    flow->protocol = protocol;
+    flow->ip_id    = ip_id;
+    flow->time     = now;
+    flow->total    = -1;
+    head = &ctx->bucket[reasm_hash(ctx, ip_src, ip_dst, protocol, ip_id)];
+    flow->next  = *head;
+    *head       = idx;
+    flow->older = ctx->newest;
+    flow->newer = -1;
+    if (ctx->newest==-1) ctx->oldest = idx;
+    else ctx->flow[ctx->newest].newer = idx;
+    ctx->newest = idx;
+    ctx->flows++;
+    return idx;
+}
+
+//-----------------------------------------------------
+// It makes 'data' of flow 'idx' hold 'size' bytes at least,
+// where older flows are dropped to keep 'max_bytes'.
+// return 0 on success, -1 on failure
+static int reasm_grow(pkt_reasm_t *ctx, int idx, int size)
+{
+    pkt_reasm_flow_t *flow = &ctx->flow[idx];
+    uint8_t *data;
+    if (size<=flow->size) return 0;
+    if (flow->total<0) { // grows by twice up to the largest datagram
+        if (size<(2*flow->size)) size = 2*flow->size;
+        if (size>IP_PKT_MAX) size = IP_PKT_MAX;
+    }
+    while (((ctx->bytes+size-flow->size)>ctx->max_bytes)&&(ctx->oldest!=idx)) {
+        reasm_free(ctx, ctx->oldest);
+        ctx->stat.drops++;
+    }
+    if ((ctx->bytes+size-flow->size)>ctx->max_bytes) return -1;
+    data = (uint8_t*)realloc(flow->data, size);
+    if (data==NULL) return -1;
+    ctx->bytes += size-flow->size;
+    flow->data  = data;
+    flow->size  = size;
+    return 0;
+}
+
+//-----------------------------------------------------
+// It fills holes by fragment of bytes from 'first' to 'last'.
+// return num of bytes of holes filled, -1 on failure
+static int reasm_fill(pkt_reasm_flow_t *flow, int first, int last, int more)
+{
+    pkt_reasm_hole_t hole[2], *hl=flow->hole;
+    int lo=0, hi=flow->hole_num, idx, num=0, filled=0;
+    while (lo<hi) { // the first hole ending at 'first' or later
+        int mid = (lo+hi)/2;
+        if (hl[mid].last<first) lo = mid+1;
+        else hi = mid;
+    }
+    for (idx=lo; (idx<flow->hole_num)&&(hl[idx].first<=last); idx++) {
+        filled += ((hl[idx].last<last) ? hl[idx].last : last)
+                - ((hl[idx].first>first) ? hl[idx].first : first) + 1;
+    }
+    if (idx==lo) return 0;
+    if (first>hl[lo].first) {
+        hole[num].first = hl[lo].first;
+        hole[num].last  = first-1;
+        num++;
+    }
+    if ((last<hl[idx-1].last)&&more) {
+        hole[num].first = last+1;
+        hole[num].last  = hl[idx-1].last;
+        num++;
+    }
+    if ((flow->hole_num-(idx-lo)+num)>flow->hole_max) {
+        pkt_reasm_hole_t *tmp = (pkt_reasm_hole_t*)realloc(hl, 2*flow->hole_max*sizeof(pkt_reasm_hole_t));
+        if (tmp==NULL) return -1;
+        flow->hole = hl = tmp;
+        flow->hole_max *= 2;
+    }
+    memmove((void*)&hl[lo+num], (void*)&hl[idx], (flow->hole_num-idx)*sizeof(pkt_reasm_hole_t));
+    memcpy((void*)&hl[lo], (void*)hole, num*sizeof(pkt_reasm_hole_t));
+    flow->hole_num += num-(idx-lo);
+    return filled;
+}
+
+//-----------------------------------------------------
+// max_flows: num of datagrams in reassembly at the same time
+// max_bytes: num of bytes of fragments kept for all datagrams
+// timeout: a datagram is dropped when not completed in it since its first
+//          fragment, where it is the same unit of 'now'; 0 for no timeout.
+// return NULL on failure
+pkt_reasm_t *pkt_reasm_create(int max_flows, int max_bytes, uint64_t timeout)
+{
+    pkt_reasm_t *ctx;
+    int idx, num;
+    if ((max_flows<=0)||(max_bytes<=0)) return NULL;
+    for (num=2; (num<(2*max_flows))&&(num<(1<<30)); num*=2);
+    ctx = (pkt_reasm_t*)calloc(1, sizeof(pkt_reasm_t));
+    if (ctx==NULL) return NULL;
+    ctx->flow   = (pkt_reasm_flow_t*)calloc(max_flows, sizeof(pkt_reasm_flow_t));
+    ctx->bucket = (int*)malloc(num*sizeof(int));
+    ctx->out    = (uint8_t*)malloc(IP_PKT_MAX);
+    if ((ctx->flow==NULL)||(ctx->bucket==NULL)||(ctx->out==NULL)) {
+        pkt_reasm_release(ctx);
+        return NULL;
+    }
+    for (idx=0; idx<num; idx++) ctx->bucket[idx] = -1;
+    for (idx=0; idx<max_flows; idx++) ctx->flow[idx].next = idx+1;
+    ctx->flow[max_flows-1].next = -1;
+    ctx->bucket_mask = num-1;
+    ctx->max_flows   = max_flows;
+    ctx->max_bytes   = max_bytes;
+    ctx->timeout     = timeout;
+    ctx->free        = 0;
+    ctx->oldest      = -1;
+    ctx->newest      = -1;
+    ctx->out_size    = IP_PKT_MAX;
+    return ctx;
+}
+
+//-----------------------------------------------------
+void pkt_reasm_release(pkt_reasm_t *ctx)
+{
+    int idx;
+    if (ctx==NULL) return;
+    if (ctx->flow!=NULL) {
+        for (idx=0; idx<ctx->max_flows; idx++) {
+            free(ctx->flow[idx].data);
+            free(ctx->flow[idx].hole);
+        }
+    }
+    free(ctx->flow);
+    free(ctx->bucket);
+    free(ctx->out);
+    free(ctx);
+}
+
+//-----------------------------------------------------
+// It drops datagrams not completed in 'timeout' since their first fragments.
+// return num of datagrams dropped
+int pkt_reasm_expire(pkt_reasm_t *ctx, uint64_t now)
+{
+    int num=0;
+    if ((ctx==NULL)||(ctx->timeout==0)) return 0;
+    while ((ctx->oldest!=-1)&&(now>=ctx->flow[ctx->oldest].time)&&
+           ((now-ctx->flow[ctx->oldest].time)>=ctx->timeout)) {
+        reasm_free(ctx, ctx->oldest);
+        ctx->stat.timeouts++;
+        num++;
+    }
+    return num;
+}
+
+//-----------------------------------------------------
+// It takes IP packet, which is returned as it is when not a fragment.
+// A fragment is kept till all fragments of its datagram arrive,
+// and then the whole datagram is returned through 'datagram',
+// which is valid till the next call.
+// return num of bytes of 'datagram', 0 when kept, -1 on error
+int pkt_reasm_put( pkt_reasm_t *ctx
+                 , const uint8_t *ip
+                 , int       leng
+                 , uint64_t  now
+                 , const uint8_t **datagram)
+{
+    pkt_reasm_flow_t *flow;
+    uint32_t ip_src, ip_dst;
+    uint16_t ip_id, ip_off;
+    uint8_t  protocol;
+    int idx, hl, tot, first, len, more, filled;
+
+    if ((ctx==NULL)||(ip==NULL)||(leng<IP_HDR_LEN)) return -1;
+    hl  = (ip[0]&0x0F)*4;
+    tot = reasm_get16(&ip[2]);
+    if (((ip[0]>>4)!=4)||(hl<IP_HDR_LEN)||(tot<hl)||(tot>leng)||
+        (compute_checksum((uint8_t*)ip, hl)!=0xFFFF)) {
+        ctx->stat.errors++;
+        return -1;
+    }
+    ip_off = reasm_get16(&ip[6]);
+    first  = (ip_off&IP_FRAG_OFFMASK)*8;
+    more   = (ip_off&IP_FRAG_MF)!=0;
+    len    = tot-hl;
+    if ((first==0)&&!more) {
+        if (datagram!=NULL) *datagram = ip;
+        return tot;
+    }
+    if ((more&&((len==0)||(len%8)))||((hl+first+len)>IP_PKT_MAX)) {
+        ctx->stat.errors++;
+        return -1;
+    }
+    pkt_reasm_expire(ctx, now);
+    ip_src   = reasm_get32(&ip[12]);
+    ip_dst   = reasm_get32(&ip[16]);
+    ip_id    = reasm_get16(&ip[4]);
+    protocol = ip[9];
+    idx = reasm_find(ctx, ip_src, ip_dst, protocol, ip_id);
+    if (idx<0) idx = reasm_new(ctx, ip_src, ip_dst, protocol, ip_id, now);
+    if (idx<0) return -1;
+    flow = &ctx->flow[idx];
+    if (!more) {
+        if (((flow->total>=0)&&(flow->total!=(first+len)))||
+            ((flow->hdr_len+first+len)>IP_PKT_MAX)) {
+            reasm_free(ctx, idx);
+            ctx->stat.errors++;
+            return -1;
+        }
+        flow->total = first+len;
+    } else if ((flow->total>=0)&&((first+len)>flow->total)) {
+        reasm_free(ctx, idx);
+        ctx->stat.errors++;
+        return -1;
+    }
+    if (reasm_grow(ctx, idx, first+len)) {
+        reasm_free(ctx, idx);
+        ctx->stat.drops++;
+        return -1;
+    }
+    if (len>0) memcpy((void*)&flow->data[first], (const void*)&ip[hl], len);
+    if (first==0) {
+        memcpy((void*)flow->hdr, (const void*)ip, hl);
+        flow->hdr_len = hl;
+    }
+    filled = (len>0) ? reasm_fill(flow, first, first+len-1, more) : 0;
+    if (filled<0) {
+        reasm_free(ctx, idx);
+        ctx->stat.drops++;
+        return -1;
+    }
+    if (filled<len) ctx->stat.overlaps++;
+    if (!more) { // no holes beyond the end
+        while ((flow->hole_num>0)&&(flow->hole[flow->hole_num-1].first>=flow->total)) flow->hole_num--;
+        if ((flow->hole_num>0)&&(flow->hole[flow->hole_num-1].last>=flow->total))
+            flow->hole[flow->hole_num-1].last = flow->total-1;
+    }
+    ctx->stat.fragments++;
+    if ((flow->total<0)||(flow->hole_num>0)||(flow->hdr_len==0)) return 0;
+
+    //-------------------------------------------------
+    // completed
+    tot = flow->hdr_len+flow->total;
+    memcpy((void*)ctx->out, (const void*)flow->hdr, flow->hdr_len);
+    memcpy((void*)&ctx->out[flow->hdr_len], (const void*)flow->data, flow->total);
+    reasm_put16(&ctx->out[ 2], (uint16_t)tot);
+    reasm_put16(&ctx->out[ 6], 0);
+    reasm_put16(&ctx->out[10], 0);
+    reasm_put16(&ctx->out[10], ~compute_checksum(ctx->out, flow->hdr_len));
+    reasm_free(ctx, idx);
+    ctx->stat.datagrams++;
+    if (datagram!=NULL) *datagram = ctx->out;
+    return tot;
+}
+
+//----------------------------------------------------------------------------
+// Revision history:
+//
+// 2019.05.20: Rewritten by Ando Ki (andoki@gmail.com)
+//----------------------------------------------------------------------------
@@ -0,0 +1,96 @@
+#ifndef PKT_REASM_H
+#define PKT_REASM_H
+//----------------------------------------------------------------------------
+// Copyright (c) 2019 by Ando Ki.
+// All right reserved.
+//----------------------------------------------------------------------------
+// VERSION = 2019.05.20.
+//----------------------------------------------------------------------------
+// IPv4 reassembly: fragments of a datagram are kept by (src, dst, protocol, id)
+// until all of them arrive, where missing parts are tracked by hole
+// descriptors (RFC 815). Datagrams not completed in 'timeout' are dropped,
+// and bytes of fragments kept are bounded by 'max_bytes'.
+//----------------------------------------------------------------------------
+#include <stdint.h>
+#include "eth_ip_udp_tcp_pkt.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//----------------------------------------------------------------------------
+typedef struct pkt_reasm_hole {
+    int first; // first byte missing
+    int last;  // last byte missing; PKT_REASM_INF till the last fragment
+} pkt_reasm_hole_t;
+
+#define PKT_REASM_INF 0x7FFFFFFF
+
+typedef struct pkt_reasm_flow {
+    uint32_t  ip_src;   // host order
+    uint32_t  ip_dst;   // host order
+    uint16_t  ip_id;
+    uint8_t   protocol;
+    uint64_t  time;     // when the first fragment arrived
+    uint8_t   hdr[60];  // IP header of the first fragment (offset 0)
+    int       hdr_len;  // 0 till the first fragment arrives
+    uint8_t  *data;     // payload of the datagram
+    int       size;     // num of bytes of 'data'
+    int       total;    // num of bytes of payload; -1 till the last fragment
+    pkt_reasm_hole_t *hole; // holes sorted by 'first'
+    int       hole_num;
+    int       hole_max;
+    int       next;     // next in hash chain or free list; -1 if none
+    int       older;    // arrival order; -1 if none
+    int       newer;
+} pkt_reasm_flow_t;
+
+typedef struct pkt_reasm_stat {
+    uint64_t  fragments; // fragments accepted
+    uint64_t  datagrams; // datagrams reassembled
+    uint64_t  overlaps;  // fragments overlapping parts already received
+    uint64_t  timeouts;  // datagrams dropped by timeout
+    uint64_t  drops;     // datagrams dropped by 'max_flows' or 'max_bytes'
+    uint64_t  errors;    // malformed fragments
+} pkt_reasm_stat_t;
+
+typedef struct pkt_reasm {
+    pkt_reasm_flow_t *flow; // 'max_flows' entries
+    int      *bucket;   // heads of hash chains
+    int       bucket_mask;
+    int       max_flows;
+    int       max_bytes;
+    uint64_t  timeout;  // in unit of 'now' of pkt_reasm_put()
+    int       free;     // free list
+    int       oldest;   // arrival order of flows
+    int       newest;
+    int       flows;    // num of flows kept
+    int       bytes;    // num of bytes kept
+    uint8_t  *out;      // reassembled datagram
+    int       out_size;
+    pkt_reasm_stat_t stat;
+} pkt_reasm_t;
+
+//----------------------------------------------------------------------------
+extern pkt_reasm_t *pkt_reasm_create( int      max_flows // num of datagrams in reassembly
+                                    , int      max_bytes // num of bytes kept for all of them
+                                    , uint64_t timeout); // NULL on failure
+extern void pkt_reasm_release( pkt_reasm_t *ctx );
+extern int  pkt_reasm_put( pkt_reasm_t *ctx
+                         , const uint8_t *ip  // IP packet, which may be a fragment
+                         , int       leng     // num of bytes of 'ip'
+                         , uint64_t  now      // e.g., simulation time
+                         , const uint8_t **datagram); // whole datagram when completed
+                         // returns num of bytes of 'datagram', 0 when kept, -1 on error
+extern int  pkt_reasm_expire( pkt_reasm_t *ctx, uint64_t now ); // returns num of datagrams dropped
+
+#ifdef __cplusplus
+}
+#endif
+
+//----------------------------------------------------------------------------
+// Revision history:
+//
+// 2019.05.20: Rewritten by Ando Ki (andoki@gmail.com)
+//----------------------------------------------------------------------------
+#endif /*PKT_REASM_H*/
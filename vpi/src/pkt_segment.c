@@ -0,0 +1,307 @@
+//----------------------------------------------------------------------------
+// Copyright (c) 2019 by Ando Ki.
+// All right reserved.
+//----------------------------------------------------------------------------
+// VERSION = 2019.05.20.
+//----------------------------------------------------------------------------
+// TCP segmentation routines.
+// Headers are built once for all segments, where sums of their constant
+// words are kept, so that each segment adds only IP length and ID to the
+// IP checksum, and length, sequence number, flags and its payload to the
+// TCP checksum. Payload is read once while its checksum and FCS are computed,
+// and the TCP checksum is patched into FCS afterwards.
+//
+// IPv4 fragmentation routines.
+// Fragments share the payload of the datagram, where each of them has its
+// own IP header whose checksum adds only length and offset to the sum of
+// the constant words.
+//----------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "eth_ip_udp_tcp_pkt.h"
+#include "pkt_segment.h"
+
+//-----------------------------------------------------
+static const uint8_t seg_zero[46] = { 0 };
+
+//-----------------------------------------------------
+// Big-endian access to the frame.
+static void seg_put16(uint8_t *pt, uint16_t value) {
+    pt[0] = value>>8;
+    pt[1] = value&0xFF;
+}
+static void seg_put32(uint8_t *pt, uint32_t value) {
+    seg_put16(pt  , value>>16);
+    seg_put16(pt+2, value&0xFFFF);
+}
+
+//-----------------------------------------------------
+static uint16_t seg_fold(uint32_t sum) {
+    sum = (sum&0xFFFF)+(sum>>16);
+    sum = (sum&0xFFFF)+(sum>>16);
+    return (uint16_t)sum;
+}
+
+//-----------------------------------------------------
+// return num of segments of 'payload_len' bytes, -1 on failure
+int pkt_tcp_segment_num(int payload_len, int mss) {
+    if ((payload_len<0)||(mss<=0)||(mss>TCP_PAYLOAD_MAX)) return -1;
+    return (payload_len==0) ? 1 : (payload_len+mss-1)/mss;
+}
+
+//-----------------------------------------------------
+// It cuts 'payload_len' bytes of 'payload' into 'mss'-byte segments
+// and builds TCP/IP/Ethernet frame of each, where IP ID and sequence
+// number advance segment by segment.
+// Each segment gets 'flags' and the last one gets 'flags_last' as well.
+// Segments have TCP checksum always, even when payload is empty.
+// packet: frame 'n' is at 'packet+n*stride', or just after frame 'n-1'
+//         when 'stride' is 0, i.e., a stream of frames.
+// leng: num of bytes of each frame
+// return num of segments, -1 on failure
+int gen_eth_ip_tcp_segments( uint8_t  *packet
+                           , int       stride
+                           , int      *leng
+                           , int       max_seg
+                           , uint8_t   mac_src[6] // network order
+                           , uint8_t   mac_dst[6] // network order
+                           , uint32_t  ip_src     // host order
+                           , uint32_t  ip_dst     // host order
+                           , uint16_t  ip_id      // IP ID of the first segment
+                           , uint16_t  port_src   // host order
+                           , uint16_t  port_dst   // host order
+                           , uint32_t  num_seq    // host order
+                           , uint32_t  num_ack    // host order
+                           , uint8_t   flags
+                           , uint8_t   flags_last
+                           , int       mss
+                           , int       payload_len
+                           , const uint8_t *payload
+                           , int       add_crc
+                           , int       add_preamble)
+{
+    uint8_t  hdr[8+ETH_HDR_LEN+IP_HDR_LEN+TCP_HDR_LEN];
+    uint8_t *frame, *eth, *ip, *tcp;
+    uint8_t  buf[2], ctl;
+    uint32_t ip_base, tcp_base, sum, crc=0, seq;
+    int num, idx, pre, hdr_len, off, len, pad, bnum;
+
+    num = pkt_tcp_segment_num(payload_len, mss);
+    if ((num<0)||(num>max_seg)) return -1;
+    pre = (add_preamble) ? 8 : 0;
+    if (stride&&(stride<(pre+ETH_HDR_LEN+IP_HDR_LEN+TCP_HDR_LEN
+                        +(((add_crc)&&(mss<6)) ? 6 : mss)+((add_crc) ? 4 : 0)))) return -1;
+
+    //-------------------------------------------------
+    // headers shared by all segments, where IP length, IP checksum,
+    // sequence number, flags and TCP checksum are zero.
+    hdr_len = gen_eth_ip_tcp_packet( hdr, mac_src, mac_dst, ip_src, ip_dst
+                                   , port_src, port_dst, 0, num_ack
+                                   , 0, 0, 0, 0, add_preamble);
+    ip  = &hdr[pre+ETH_HDR_LEN];
+    tcp = &ip[IP_HDR_LEN];
+    seg_put16(&ip[ 2], 0);
+    seg_put16(&ip[10], 0);
+    ip_base  = compute_checksum(ip, IP_HDR_LEN);
+    tcp_base = compute_checksum(tcp, TCP_HDR_LEN)
+             + (ip_src>>16)+(ip_src&0xFFFF)+(ip_dst>>16)+(ip_dst&0xFFFF)
+             + IP_PROTO_TCP; // pseudo header without length
+
+    //-------------------------------------------------
+    frame = packet;
+    for (idx=0, off=0; idx<num; idx++, off+=len) {
+        len = ((payload_len-off)<mss) ? (payload_len-off) : mss;
+        seq = num_seq+(uint32_t)off;
+        ctl = flags|((idx==(num-1)) ? flags_last : 0);
+        memcpy((void*)frame, (const void*)hdr, hdr_len);
+        eth = &frame[pre];
+        ip  = &eth[ETH_HDR_LEN];
+        tcp = &ip[IP_HDR_LEN];
+        seg_put16(&ip[2], IP_HDR_LEN+TCP_HDR_LEN+len);
+        seg_put16(&ip[4], (uint16_t)(ip_id+idx));
+        seg_put16(&ip[10], ~seg_fold(ip_base+IP_HDR_LEN+TCP_HDR_LEN+len+(uint16_t)(ip_id+idx)));
+        seg_put32(&tcp[4], seq);
+        tcp[13] = ctl;
+        bnum = ETH_HDR_LEN+IP_HDR_LEN+TCP_HDR_LEN;
+        if (add_crc) {
+            crc = compute_eth_crc(eth, bnum);
+            sum = copy_checksum_crc(&eth[bnum], &payload[off], len, &crc);
+            bnum += len;
+            pad   = (len<6) ? 6-len : 0; // Ethernet payload of 46 bytes at least
+            copy_checksum_crc(&eth[bnum], seg_zero, pad, &crc);
+            bnum += pad;
+            eth[bnum  ] = (crc>> 0)&0xFF; // LSByte first
+            eth[bnum+1] = (crc>> 8)&0xFF;
+            eth[bnum+2] = (crc>>16)&0xFF;
+            eth[bnum+3] = (crc>>24)&0xFF;
+            bnum += 4;
+        } else {
+            sum = (len) ? copy_checksum_crc(&eth[bnum], &payload[off], len, NULL) : 0;
+            bnum += len;
+        }
+        sum += tcp_base+TCP_HDR_LEN+len+(seq>>16)+(seq&0xFFFF)+ctl;
+        seg_put16(buf, ~seg_fold(sum));
+        if (add_crc) patch_eth_crc(eth, bnum, ETH_HDR_LEN+IP_HDR_LEN+16, buf, 2);
+        else         memcpy((void*)&tcp[16], (const void*)buf, 2);
+        leng[idx] = pre+bnum;
+        frame += (stride) ? stride : leng[idx];
+    }
+    return num;
+}
+
+//-----------------------------------------------------
+// IP ID counters of flows, which are hashed by addresses and protocol.
+static uint16_t m_ip_flow_id[PKT_IP_FLOW_NUM];
+
+uint16_t pkt_ip_flow_id(uint32_t ip_src, uint32_t ip_dst, uint8_t protocol) {
+    uint32_t hash = (ip_src*0x9E3779B1U)^(ip_dst*0x85EBCA77U)^protocol;
+    hash ^= hash>>15;
+    return m_ip_flow_id[hash%PKT_IP_FLOW_NUM]++;
+}
+
+void pkt_ip_flow_reset(void) {
+    memset((void*)m_ip_flow_id, 0, sizeof(m_ip_flow_id));
+}
+
+//-----------------------------------------------------
+// Num of payload bytes of each fragment but the last,
+// which is multiple of 8 bytes.
+static int frag_step(int mtu) {
+    return ((mtu-IP_HDR_LEN)/8)*8;
+}
+
+//-----------------------------------------------------
+// return num of fragments of 'payload_len' bytes, -1 on failure
+int pkt_ip_fragment_num(int payload_len, int mtu) {
+    if ((mtu<(IP_HDR_LEN+8))||(mtu>IP_PKT_MAX)) return -1;
+    if ((payload_len<0)||(payload_len>(IP_PKT_MAX-IP_HDR_LEN))) return -1;
+    if (payload_len<=(mtu-IP_HDR_LEN)) return 1;
+    return (payload_len+frag_step(mtu)-1)/frag_step(mtu);
+}
+
+//-----------------------------------------------------
+// IP header shared by all fragments, where length, offset and checksum
+// are zero; returns sum of the header.
+static uint32_t frag_base( uint8_t  *hdr
+                         , uint32_t  ip_src
+                         , uint32_t  ip_dst
+                         , uint8_t   protocol
+                         , uint8_t   ttl
+                         , uint16_t  ip_id)
+{
+    ip_hdr_t iphdr;
+    populate_ip_hdr(&iphdr, ip_src, ip_dst, protocol, ttl, 0);
+    memcpy((void*)hdr, (const void*)&iphdr, IP_HDR_LEN);
+    seg_put16(&hdr[ 2], 0);
+    seg_put16(&hdr[ 4], ip_id);
+    seg_put16(&hdr[ 6], 0);
+    seg_put16(&hdr[10], 0);
+    return compute_checksum(hdr, IP_HDR_LEN);
+}
+
+//-----------------------------------------------------
+// It fills fragment 'idx' of 'num'.
+static void frag_fill( pkt_ip_frag_t *frag
+                     , const uint8_t *base_hdr
+                     , uint32_t       base_sum
+                     , int            idx
+                     , int            num
+                     , int            step
+                     , int            payload_len
+                     , const uint8_t *payload)
+{
+    int off = idx*step;
+    int len = (idx==(num-1)) ? payload_len-off : step;
+    uint16_t foff = (uint16_t)((off/8)|((idx==(num-1)) ? 0 : IP_FRAG_MF));
+    memcpy((void*)frag->hdr, (const void*)base_hdr, IP_HDR_LEN);
+    seg_put16(&frag->hdr[ 2], IP_HDR_LEN+len);
+    seg_put16(&frag->hdr[ 6], foff);
+    seg_put16(&frag->hdr[10], ~seg_fold(base_sum+IP_HDR_LEN+len+foff));
+    frag->iov[0].base = frag->hdr;
+    frag->iov[0].len  = IP_HDR_LEN;
+    frag->iov[1].base = (payload!=NULL) ? payload+off : NULL;
+    frag->iov[1].len  = len;
+}
+
+//-----------------------------------------------------
+// It cuts 'payload_len' bytes of IP payload, e.g., UDP header and its
+// payload, into fragments of 'mtu' bytes at most, where all fragments
+// have 'ip_id' and all but the last have MF flag.
+// Payload is not copied; 'iov[1]' of each fragment points its part.
+// return num of fragments, -1 on failure
+int gen_ip_fragments( pkt_ip_frag_t *frag
+                    , int       max_frag
+                    , uint32_t  ip_src
+                    , uint32_t  ip_dst
+                    , uint8_t   protocol
+                    , uint8_t   ttl
+                    , uint16_t  ip_id
+                    , int       mtu
+                    , int       payload_len
+                    , const uint8_t *payload)
+{
+    uint8_t  hdr[IP_HDR_LEN];
+    uint32_t base;
+    int num, idx;
+
+    num = pkt_ip_fragment_num(payload_len, mtu);
+    if ((num<0)||(num>max_frag)) return -1;
+    base = frag_base(hdr, ip_src, ip_dst, protocol, ttl, ip_id);
+    for (idx=0; idx<num; idx++) {
+        frag_fill(&frag[idx], hdr, base, idx, num, frag_step(mtu), payload_len, payload);
+    }
+    return num;
+}
+
+//-----------------------------------------------------
+// It builds IP/Ethernet frame of each fragment.
+// packet: frame 'n' is at 'packet+n*stride', or just after frame 'n-1'
+//         when 'stride' is 0, i.e., a stream of frames.
+// leng: num of bytes of each frame
+// return num of fragments, -1 on failure
+int gen_eth_ip_fragments( uint8_t  *packet
+                        , int       stride
+                        , int      *leng
+                        , int       max_frag
+                        , uint8_t   mac_src[6] // network order
+                        , uint8_t   mac_dst[6] // network order
+                        , uint32_t  ip_src     // host order
+                        , uint32_t  ip_dst     // host order
+                        , uint8_t   protocol
+                        , uint8_t   ttl
+                        , uint16_t  ip_id
+                        , int       mtu
+                        , int       payload_len
+                        , const uint8_t *payload
+                        , int       add_crc
+                        , int       add_preamble)
+{
+    pkt_ip_frag_t frag;
+    uint8_t  hdr[IP_HDR_LEN];
+    uint8_t *frame;
+    uint32_t base;
+    int num, idx, max;
+
+    num = pkt_ip_fragment_num(payload_len, mtu);
+    if ((num<0)||(num>max_frag)) return -1;
+    max = IP_HDR_LEN+((num==1) ? payload_len : frag_step(mtu));
+    if ((add_crc)&&(max<46)) max = 46;
+    if (stride&&(stride<(((add_preamble) ? 8 : 0)+ETH_HDR_LEN+max+((add_crc) ? 4 : 0)))) return -1;
+    base = frag_base(hdr, ip_src, ip_dst, protocol, ttl, ip_id);
+    frame = packet;
+    for (idx=0; idx<num; idx++) {
+        frag_fill(&frag, hdr, base, idx, num, frag_step(mtu), payload_len, payload);
+        leng[idx] = gen_eth_packet_iov( frame, mac_src, mac_dst, ETH_TYPE_IP
+                                      , frag.iov, 2, add_crc, add_preamble);
+        frame += (stride) ? stride : leng[idx];
+    }
+    return num;
+}
+
+//----------------------------------------------------------------------------
+// Revision history:
+//
+// 2019.05.20: Rewritten by Ando Ki (andoki@gmail.com)
+//----------------------------------------------------------------------------
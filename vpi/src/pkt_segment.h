@@ -0,0 +1,101 @@
+#ifndef PKT_SEGMENT_H
+#define PKT_SEGMENT_H
+//----------------------------------------------------------------------------
+// Copyright (c) 2019 by Ando Ki.
+// All right reserved.
+//----------------------------------------------------------------------------
+// VERSION = 2019.05.20.
+//----------------------------------------------------------------------------
+// TCP segmentation as TSO/LSO of NIC does: a large TCP payload is cut into
+// MSS-byte segments, each of which is a whole TCP/IP/Ethernet frame.
+// IPv4 fragmentation: an IP payload is cut into fragments fitting MTU.
+//----------------------------------------------------------------------------
+#include <stdint.h>
+#include "eth_ip_udp_tcp_pkt.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//----------------------------------------------------------------------------
+// Num of bytes of a segment frame carrying 'mss' bytes of payload at most.
+#define PKT_SEGMENT_FRAME_MAX(mss) (8+ETH_HDR_LEN+IP_HDR_LEN+TCP_HDR_LEN+(((mss)<6) ? 6 : (mss))+4)
+
+//----------------------------------------------------------------------------
+extern int pkt_tcp_segment_num( int payload_len, int mss ); // -1 on failure
+extern int gen_eth_ip_tcp_segments( uint8_t  *packet     // segment frames
+                                  , int       stride     // num of bytes from a frame to the next; 0 for back to back
+                                  , int      *leng       // num of bytes of each frame
+                                  , int       max_seg    // num of entries of 'leng'
+                                  , uint8_t   mac_src[6] // network order
+                                  , uint8_t   mac_dst[6] // network order
+                                  , uint32_t  ip_src     // host order
+                                  , uint32_t  ip_dst     // host order
+                                  , uint16_t  ip_id      // IP ID of the first segment
+                                  , uint16_t  port_src   // host order
+                                  , uint16_t  port_dst   // host order
+                                  , uint32_t  num_seq    // sequence number of the first segment
+                                  , uint32_t  num_ack    // host order
+                                  , uint8_t   flags      // TCP_FLAG_* of all segments
+                                  , uint8_t   flags_last // TCP_FLAG_* added to the last, e.g., PSH and FIN
+                                  , int       mss        // max segment size
+                                  , int       payload_len// num of bytes of the whole payload
+                                  , const uint8_t *payload
+                                  , int       add_crc
+                                  , int       add_preamble); // returns num of segments
+
+//----------------------------------------------------------------------------
+// IPv4 fragment, which refers to its part of the payload of the datagram
+// instead of a copy; 'iov' can be given to gen_eth_packet_iov() as it is.
+typedef struct pkt_ip_frag {
+    uint8_t     hdr[IP_HDR_LEN]; // IP header of the fragment
+    pkt_iovec_t iov[2];          // 'hdr' and its part of the payload
+} pkt_ip_frag_t;
+
+// Num of bytes of a fragment frame of 'mtu' at most.
+#define PKT_FRAGMENT_FRAME_MAX(mtu) (8+ETH_HDR_LEN+(((mtu)<46) ? 46 : (mtu))+4)
+
+// Num of IP ID counters; flows hashed to the same one share it,
+// so that IDs of a flow still advance one by one.
+#define PKT_IP_FLOW_NUM 4096
+
+extern uint16_t pkt_ip_flow_id( uint32_t ip_src, uint32_t ip_dst, uint8_t protocol ); // next IP ID of the flow
+extern void     pkt_ip_flow_reset( void );
+extern int pkt_ip_fragment_num( int payload_len, int mtu ); // -1 on failure
+extern int gen_ip_fragments( pkt_ip_frag_t *frag     // fragments
+                           , int       max_frag   // num of entries of 'frag'
+                           , uint32_t  ip_src     // host order
+                           , uint32_t  ip_dst     // host order
+                           , uint8_t   protocol
+                           , uint8_t   ttl
+                           , uint16_t  ip_id      // e.g., pkt_ip_flow_id()
+                           , int       mtu        // num of bytes of IP packet at most
+                           , int       payload_len// num of bytes of IP payload
+                           , const uint8_t *payload); // returns num of fragments
+extern int gen_eth_ip_fragments( uint8_t  *packet     // fragment frames
+                               , int       stride     // num of bytes from a frame to the next; 0 for back to back
+                               , int      *leng       // num of bytes of each frame
+                               , int       max_frag   // num of entries of 'leng'
+                               , uint8_t   mac_src[6] // network order
+                               , uint8_t   mac_dst[6] // network order
+                               , uint32_t  ip_src     // host order
+                               , uint32_t  ip_dst     // host order
+                               , uint8_t   protocol
+                               , uint8_t   ttl
+                               , uint16_t  ip_id
+                               , int       mtu
+                               , int       payload_len
+                               , const uint8_t *payload
+                               , int       add_crc
+                               , int       add_preamble); // returns num of fragments
+
+#ifdef __cplusplus
+}
+#endif
+
+//----------------------------------------------------------------------------
+// Revision history:
+//
+// 2019.05.20: Rewritten by Ando Ki (andoki@gmail.com)
+//----------------------------------------------------------------------------
+#endif /*PKT_SEGMENT_H*/
@@ -0,0 +1,419 @@
+//----------------------------------------------------------------------------
+// Copyright (c) 2019 by Ando Ki.
+// All right reserved.
+//----------------------------------------------------------------------------
+// VERSION = 2019.05.20.
+//----------------------------------------------------------------------------
+// TCP stream reassembly routines.
+// Connections are found by hash of (src, dst, src port, dst port),
+// and are kept in order of their latest use, so that the least recently
+// used one is dropped in constant time when the table is full.
+// Out-of-order segments of a connection are kept without overlaps
+// in order of sequence number.
+//----------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "eth_ip_udp_tcp_pkt.h"
+#include "pkt_stream.h"
+
+//-----------------------------------------------------
+static uint16_t stream_get16(const uint8_t *pt) {
+    return (uint16_t)((pt[0]<<8)|pt[1]);
+}
+static uint32_t stream_get32(const uint8_t *pt) {
+    return ((uint32_t)stream_get16(pt)<<16)|stream_get16(pt+2);
+}
+
+// sequence number 'a' minus 'b' in modulo 2^32
+#define SEQ_DIFF(a, b) ((int32_t)((uint32_t)(a)-(uint32_t)(b)))
+
+//-----------------------------------------------------
+static int stream_hash( pkt_stream_t *ctx
+                      , uint32_t ip_src, uint32_t ip_dst
+                      , uint16_t port_src, uint16_t port_dst)
+{
+    uint32_t hash = (ip_src*0x9E3779B1U)^(ip_dst*0x85EBCA77U)
+                  ^(((uint32_t)port_src<<16)|port_dst)*0xC2B2AE3DU;
+    hash ^= hash>>16;
+    return (int)(hash&(uint32_t)ctx->bucket_mask);
+}
+
+//-----------------------------------------------------
+static void stream_free_ooo(pkt_stream_t *ctx, pkt_stream_conn_t *conn)
+{
+    pkt_stream_seg_t *seg;
+    while (conn->ooo!=NULL) {
+        seg = conn->ooo;
+        conn->ooo = seg->next;
+        free(seg);
+    }
+    ctx->bytes -= conn->ooo_bytes;
+    conn->ooo_bytes = 0;
+}
+
+//-----------------------------------------------------
+// It takes connection 'idx' out of the order of use.
+static void stream_unlink(pkt_stream_t *ctx, int idx)
+{
+    pkt_stream_conn_t *conn = &ctx->conn[idx];
+    if (conn->older==-1) ctx->oldest = conn->newer;
+    else ctx->conn[conn->older].newer = conn->newer;
+    if (conn->newer==-1) ctx->newest = conn->older;
+    else ctx->conn[conn->newer].older = conn->older;
+}
+
+//-----------------------------------------------------
+// It makes connection 'idx' the latest one used.
+static void stream_link(pkt_stream_t *ctx, int idx)
+{
+    pkt_stream_conn_t *conn = &ctx->conn[idx];
+    conn->older = ctx->newest;
+    conn->newer = -1;
+    if (ctx->newest==-1) ctx->oldest = idx;
+    else ctx->conn[ctx->newest].newer = idx;
+    ctx->newest = idx;
+}
+
+//-----------------------------------------------------
+// It takes connection 'idx' out of hash chain and order of use,
+// and puts it to free list.
+static void stream_free(pkt_stream_t *ctx, int idx)
+{
+    pkt_stream_conn_t *conn = &ctx->conn[idx];
+    int *pt = &ctx->bucket[stream_hash(ctx, conn->ip_src, conn->ip_dst, conn->port_src, conn->port_dst)];
+    while ((*pt!=-1)&&(*pt!=idx)) pt = &ctx->conn[*pt].next;
+    if (*pt==idx) *pt = conn->next;
+    stream_unlink(ctx, idx);
+    stream_free_ooo(ctx, conn);
+    ctx->conns--;
+    memset((void*)conn, 0, sizeof(*conn));
+    conn->next = ctx->free;
+    ctx->free  = idx;
+}
+
+//-----------------------------------------------------
+// It finds connection of the key; -1 if not found.
+static int stream_find( pkt_stream_t *ctx
+                      , uint32_t ip_src, uint32_t ip_dst
+                      , uint16_t port_src, uint16_t port_dst)
+{
+    int idx = ctx->bucket[stream_hash(ctx, ip_src, ip_dst, port_src, port_dst)];
+    while (idx!=-1) {
+        pkt_stream_conn_t *conn = &ctx->conn[idx];
+        if ((conn->ip_src==ip_src)&&(conn->ip_dst==ip_dst)&&
+            (conn->port_src==port_src)&&(conn->port_dst==port_dst)) return idx;
+        idx = conn->next;
+    }
+    return -1;
+}
+
+//-----------------------------------------------------
+// It makes a new connection, where the least recently used one is
+// dropped when no room.
+// return index of the connection
+static int stream_new( pkt_stream_t *ctx
+                     , uint32_t ip_src, uint32_t ip_dst
+                     , uint16_t port_src, uint16_t port_dst
+                     , uint32_t seq)
+{
+    pkt_stream_conn_t *conn;
+    int idx, *head;
+    if (ctx->free==-1) {
+        stream_free(ctx, ctx->oldest);
+        ctx->evictions++;
+    }
+    idx  = ctx->free;
+    conn = &ctx->conn[idx];
+    ctx->free = conn->next;
+    conn->ip_src   = ip_src;
+    conn->ip_dst   = ip_dst;
+    conn->port_src = port_src;
+    conn->port_dst = port_dst;
+    conn->next_seq = seq;
+    head = &ctx->bucket[stream_hash(ctx, ip_src, ip_dst, port_src, port_dst)];
+    conn->next = *head;
+    *head      = idx;
+    stream_link(ctx, idx);
+    ctx->conns++;
+    return idx;
+}
+
+//-----------------------------------------------------
+static void stream_deliver( pkt_stream_t *ctx
+                          , pkt_stream_conn_t *conn
+                          , const uint8_t *data
+                          , int len)
+{
+    conn->next_seq  += (uint32_t)len;
+    conn->delivered += (uint64_t)len;
+    if (ctx->deliver!=NULL) ctx->deliver(ctx->user, conn, data, len);
+}
+
+//-----------------------------------------------------
+// It keeps segment of 'len' bytes from 'seq', which is beyond 'next_seq',
+// where bytes kept already are cut out.
+static void stream_queue( pkt_stream_t *ctx
+                        , pkt_stream_conn_t *conn
+                        , uint32_t seq
+                        , const uint8_t *data
+                        , int len)
+{
+    pkt_stream_seg_t **pt=&conn->ooo, *seg;
+    int num;
+    while ((*pt!=NULL)&&(SEQ_DIFF((*pt)->seq+(uint32_t)(*pt)->len, seq)<=0)) pt = &(*pt)->next;
+    if ((*pt!=NULL)&&(SEQ_DIFF((*pt)->seq, seq)<=0)) { // the previous one covers the head
+        num = SEQ_DIFF((*pt)->seq+(uint32_t)(*pt)->len, seq);
+        if (num>=len) {
+            conn->retransmits++;
+            return;
+        }
+        conn->overlaps++;
+        seq  += (uint32_t)num;
+        data += num;
+        len  -= num;
+        pt = &(*pt)->next;
+    }
+    while ((*pt!=NULL)&&(SEQ_DIFF((*pt)->seq+(uint32_t)(*pt)->len, seq+(uint32_t)len)<=0)) {
+        seg = *pt; // covered by the new one
+        *pt = seg->next;
+        conn->ooo_bytes -= seg->len;
+        ctx->bytes      -= seg->len;
+        free(seg);
+        conn->overlaps++;
+    }
+    if ((*pt!=NULL)&&(SEQ_DIFF((*pt)->seq, seq+(uint32_t)len)<0)) { // the next one covers the tail
+        len = SEQ_DIFF((*pt)->seq, seq);
+        conn->overlaps++;
+        if (len<=0) return;
+    }
+    if ((ctx->bytes+len)>ctx->max_bytes) {
+        conn->drops++;
+        return;
+    }
+    seg = (pkt_stream_seg_t*)malloc(sizeof(pkt_stream_seg_t)+len);
+    if (seg==NULL) {
+        conn->drops++;
+        return;
+    }
+    seg->seq  = seq;
+    seg->len  = len;
+    seg->next = *pt;
+    memcpy((void*)seg->data, (const void*)data, len);
+    *pt = seg;
+    conn->ooo_bytes += len;
+    ctx->bytes      += len;
+    conn->gaps++;
+}
+
+//-----------------------------------------------------
+// It delivers out-of-order segments reached by 'next_seq'.
+// return num of bytes delivered
+static int stream_drain(pkt_stream_t *ctx, pkt_stream_conn_t *conn)
+{
+    pkt_stream_seg_t *seg;
+    int num=0, off;
+    while ((conn->ooo!=NULL)&&(SEQ_DIFF(conn->ooo->seq, conn->next_seq)<=0)) {
+        seg = conn->ooo;
+        conn->ooo = seg->next;
+        conn->ooo_bytes -= seg->len;
+        ctx->bytes      -= seg->len;
+        off = SEQ_DIFF(conn->next_seq, seg->seq);
+        if (off<seg->len) {
+            stream_deliver(ctx, conn, &seg->data[off], seg->len-off);
+            num += seg->len-off;
+        }
+        free(seg);
+    }
+    return num;
+}
+
+//-----------------------------------------------------
+// max_conns: num of connections kept, where a direction is a connection
+// max_bytes: num of bytes of out-of-order segments kept for all connections
+// window: receive window of a connection till the other direction
+//         advertises one by ACK
+// deliver: called with bytes delivered in order; NULL for none
+// return NULL on failure
+pkt_stream_t *pkt_stream_create( int       max_conns
+                               , int       max_bytes
+                               , uint32_t  window
+                               , pkt_stream_deliver_t deliver
+                               , void     *user)
+{
+    pkt_stream_t *ctx;
+    int idx, num;
+    if ((max_conns<=0)||(max_bytes<0)) return NULL;
+    for (num=2; (num<(2*max_conns))&&(num<(1<<30)); num*=2);
+    ctx = (pkt_stream_t*)calloc(1, sizeof(pkt_stream_t));
+    if (ctx==NULL) return NULL;
+    ctx->conn   = (pkt_stream_conn_t*)calloc(max_conns, sizeof(pkt_stream_conn_t));
+    ctx->bucket = (int*)malloc(num*sizeof(int));
+    if ((ctx->conn==NULL)||(ctx->bucket==NULL)) {
+        pkt_stream_release(ctx);
+        return NULL;
+    }
+    for (idx=0; idx<num; idx++) ctx->bucket[idx] = -1;
+    for (idx=0; idx<max_conns; idx++) ctx->conn[idx].next = idx+1;
+    ctx->conn[max_conns-1].next = -1;
+    ctx->bucket_mask = num-1;
+    ctx->max_conns   = max_conns;
+    ctx->max_bytes   = max_bytes;
+    ctx->window      = window;
+    ctx->free        = 0;
+    ctx->oldest      = -1;
+    ctx->newest      = -1;
+    ctx->deliver     = deliver;
+    ctx->user        = user;
+    return ctx;
+}
+
+//-----------------------------------------------------
+void pkt_stream_release(pkt_stream_t *ctx)
+{
+    int idx;
+    if (ctx==NULL) return;
+    if (ctx->conn!=NULL) {
+        for (idx=0; idx<ctx->max_conns; idx++) stream_free_ooo(ctx, &ctx->conn[idx]);
+    }
+    free(ctx->conn);
+    free(ctx->bucket);
+    free(ctx);
+}
+
+//-----------------------------------------------------
+pkt_stream_conn_t *pkt_stream_find( pkt_stream_t *ctx
+                                  , uint32_t ip_src, uint32_t ip_dst
+                                  , uint16_t port_src, uint16_t port_dst)
+{
+    int idx;
+    if (ctx==NULL) return NULL;
+    idx = stream_find(ctx, ip_src, ip_dst, port_src, port_dst);
+    return (idx<0) ? NULL : &ctx->conn[idx];
+}
+
+//-----------------------------------------------------
+// It takes IP packet carrying TCP segment, which should not be a fragment.
+// A connection starts at SYN, or at the first segment seen, and starts over
+// at SYN of another sequence number or after it has been closed.
+// Bytes are delivered in order through 'deliver' of the context,
+// and 'deliver' gets 0 byte when the connection is closed by FIN or RST.
+// return num of bytes delivered, -1 on error
+int pkt_stream_put( pkt_stream_t *ctx
+                  , const uint8_t *ip
+                  , int       leng)
+{
+    pkt_stream_conn_t *conn;
+    const uint8_t *tcp, *data;
+    uint32_t ip_src, ip_dst, seq, ack;
+    uint16_t port_src, port_dst;
+    uint8_t  flags;
+    int idx, hl, thl, tot, len, rel, num=0;
+
+    if ((ctx==NULL)||(ip==NULL)||(leng<IP_HDR_LEN)) return -1;
+    hl  = (ip[0]&0x0F)*4;
+    tot = stream_get16(&ip[2]);
+    if (((ip[0]>>4)!=4)||(hl<IP_HDR_LEN)||(tot>leng)||(tot<(hl+TCP_HDR_LEN))||
+        (ip[9]!=IP_PROTO_TCP)||(ip[6]&0x3F)||ip[7]) return -1;
+    tcp = &ip[hl];
+    thl = (tcp[12]>>4)*4;
+    len = tot-hl-thl;
+    if ((thl<TCP_HDR_LEN)||(len<0)) return -1;
+    data     = &tcp[thl];
+    ip_src   = stream_get32(&ip[12]);
+    ip_dst   = stream_get32(&ip[16]);
+    port_src = stream_get16(&tcp[0]);
+    port_dst = stream_get16(&tcp[2]);
+    seq      = stream_get32(&tcp[4]);
+    ack      = stream_get32(&tcp[8]);
+    flags    = tcp[13]&0x3F;
+
+    //-------------------------------------------------
+    // ACK advertises receive window of the other direction.
+    if (flags&TCP_FLAG_ACK) {
+        idx = stream_find(ctx, ip_dst, ip_src, port_dst, port_src);
+        if (idx>=0) {
+            ctx->conn[idx].wnd_end   = ack+stream_get16(&tcp[14]);
+            ctx->conn[idx].wnd_valid = 1;
+        }
+    }
+    idx = stream_find(ctx, ip_src, ip_dst, port_src, port_dst);
+    if (idx<0) {
+        if (flags&TCP_FLAG_RST) return 0;
+        idx = stream_new(ctx, ip_src, ip_dst, port_src, port_dst
+                        , (flags&TCP_FLAG_SYN) ? seq+1 : seq);
+    } else {
+        stream_unlink(ctx, idx);
+        stream_link(ctx, idx);
+    }
+    conn = &ctx->conn[idx];
+    if (flags&TCP_FLAG_SYN) {
+        if (conn->syn&&!conn->closed&&(conn->isn==seq)) {
+            conn->retransmits++;
+        } else if (conn->syn||conn->closed) { // port reused; a new connection
+            stream_free_ooo(ctx, conn);
+            conn->next_seq  = seq+1;
+            conn->wnd_valid = 0;
+            conn->fin       = 0;
+            conn->closed    = 0;
+        }
+        conn->syn = 1;
+        conn->isn = seq;
+    }
+    conn->segments++;
+    if (conn->closed) {
+        if ((len>0)||(flags&TCP_FLAG_FIN)) conn->retransmits++;
+        return 0;
+    }
+    if (flags&TCP_FLAG_RST) {
+        stream_free_ooo(ctx, conn);
+        conn->closed = 1;
+        if (ctx->deliver!=NULL) ctx->deliver(ctx->user, conn, NULL, 0);
+        return 0;
+    }
+    if (flags&TCP_FLAG_SYN) seq++; // data follows SYN
+    if ((flags&TCP_FLAG_FIN)&&!conn->fin) {
+        conn->fin     = 1;
+        conn->fin_seq = seq+(uint32_t)len;
+    }
+
+    //-------------------------------------------------
+    if (len>0) {
+        rel = SEQ_DIFF(seq, conn->next_seq);
+        if ((rel+len)<=0) {
+            conn->retransmits++;
+        } else {
+            if (rel<0) { // the head has been delivered
+                conn->overlaps++;
+                seq  -= (uint32_t)rel;
+                data -= rel;
+                len  += rel;
+                rel   = 0;
+            }
+            if (SEQ_DIFF(seq+(uint32_t)len, (conn->wnd_valid) ? conn->wnd_end
+                                            : conn->next_seq+ctx->window)>0) {
+                conn->window_violations++;
+            }
+            if (rel==0) {
+                stream_deliver(ctx, conn, data, len);
+                num = len+stream_drain(ctx, conn);
+            } else {
+                stream_queue(ctx, conn, seq, data, len);
+            }
+        }
+    }
+    if (conn->fin&&(conn->next_seq==conn->fin_seq)) {
+        conn->next_seq++; // FIN takes a sequence number
+        conn->closed = 1;
+        stream_free_ooo(ctx, conn);
+        if (ctx->deliver!=NULL) ctx->deliver(ctx->user, conn, NULL, 0);
+    }
+    return num;
+}
+
+//----------------------------------------------------------------------------
+// Revision history:
+//
+// 2019.05.20: Rewritten by Ando Ki (andoki@gmail.com)
+//----------------------------------------------------------------------------
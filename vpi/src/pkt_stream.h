@@ -0,0 +1,104 @@
+#ifndef PKT_STREAM_H
+#define PKT_STREAM_H
+//----------------------------------------------------------------------------
+// Copyright (c) 2019 by Ando Ki.
+// All right reserved.
+//----------------------------------------------------------------------------
+// VERSION = 2019.05.20.
+//----------------------------------------------------------------------------
+// TCP stream reassembly: segments of each connection are put in order of
+// sequence number, where out-of-order ones are kept till the hole before
+// them is filled, and retransmitted or overlapping bytes are delivered once.
+//----------------------------------------------------------------------------
+#include <stdint.h>
+#include "eth_ip_udp_tcp_pkt.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//----------------------------------------------------------------------------
+// Out-of-order segment kept in a connection.
+typedef struct pkt_stream_seg {
+    uint32_t  seq;      // sequence number of the first byte
+    int       len;      // num of bytes of 'data'
+    struct pkt_stream_seg *next; // in order of 'seq'
+    uint8_t   data[1];  // 'len' bytes
+} pkt_stream_seg_t;
+
+// A direction of TCP connection, i.e., from source to destination.
+typedef struct pkt_stream_conn {
+    uint32_t  ip_src;   // host order
+    uint32_t  ip_dst;   // host order
+    uint16_t  port_src; // host order
+    uint16_t  port_dst; // host order
+    uint32_t  isn;      // sequence number of SYN when 'syn' is 1
+    uint32_t  next_seq; // sequence number of the next byte to deliver
+    uint32_t  fin_seq;  // sequence number of FIN when 'fin' is 1
+    uint32_t  wnd_end;  // right edge of receive window advertised by the other direction
+    int       wnd_valid;// 'wnd_end' is valid; otherwise 'window' of pkt_stream_t from 'next_seq'
+    int       syn;      // SYN has arrived
+    int       fin;      // FIN has arrived
+    int       closed;   // all bytes up to FIN have been delivered, or RST
+    pkt_stream_seg_t *ooo; // out-of-order segments
+    int       ooo_bytes;
+    uint64_t  segments;    // segments arrived
+    uint64_t  delivered;   // bytes delivered in order
+    uint64_t  retransmits; // segments of bytes delivered or kept already
+    uint64_t  overlaps;    // segments partly retransmitted
+    uint64_t  gaps;        // segments arrived beyond a hole
+    uint64_t  window_violations; // segments beyond 'window'
+    uint64_t  drops;       // segments dropped by 'max_bytes'
+    int       next;     // next in hash chain or free list; -1 if none
+    int       older;    // order of the latest use; -1 if none
+    int       newer;
+} pkt_stream_conn_t;
+
+// It is called with 'num' bytes of 'data' delivered in order,
+// and with 'num' 0 when the connection is closed.
+typedef void (*pkt_stream_deliver_t)( void *user
+                                    , pkt_stream_conn_t *conn
+                                    , const uint8_t *data
+                                    , int num);
+
+typedef struct pkt_stream {
+    pkt_stream_conn_t *conn; // 'max_conns' entries
+    int      *bucket;   // heads of hash chains
+    int       bucket_mask;
+    int       max_conns;
+    int       max_bytes;// num of bytes of out-of-order segments of all connections
+    uint32_t  window;   // receive window till the other direction advertises one
+    int       free;     // free list
+    int       oldest;   // order of the latest use of connections
+    int       newest;
+    int       conns;    // num of connections kept
+    int       bytes;    // num of bytes of out-of-order segments kept
+    uint64_t  evictions;// connections dropped by 'max_conns'
+    pkt_stream_deliver_t deliver;
+    void     *user;
+} pkt_stream_t;
+
+//----------------------------------------------------------------------------
+extern pkt_stream_t *pkt_stream_create( int       max_conns // num of connections kept
+                                      , int       max_bytes // num of bytes of out-of-order segments kept
+                                      , uint32_t  window    // receive window by default, e.g., 65535
+                                      , pkt_stream_deliver_t deliver
+                                      , void     *user); // NULL on failure
+extern void pkt_stream_release( pkt_stream_t *ctx );
+extern int  pkt_stream_put( pkt_stream_t *ctx
+                          , const uint8_t *ip  // IP packet carrying TCP segment
+                          , int       leng);   // returns num of bytes delivered, -1 on error
+extern pkt_stream_conn_t *pkt_stream_find( pkt_stream_t *ctx
+                                         , uint32_t ip_src, uint32_t ip_dst
+                                         , uint16_t port_src, uint16_t port_dst); // NULL if none
+
+#ifdef __cplusplus
+}
+#endif
+
+//----------------------------------------------------------------------------
+// Revision history:
+//
+// 2019.05.20: Rewritten by Ando Ki (andoki@gmail.com)
+//----------------------------------------------------------------------------
+#endif /*PKT_STREAM_H*/
@@ -0,0 +1,339 @@
+//----------------------------------------------------------------------------
+// Copyright (c) 2019 by Ando Ki.
+// All right reserved.
+//----------------------------------------------------------------------------
+// VERSION = 2019.05.20.
+//----------------------------------------------------------------------------
+// Packet template routines.
+// A template keeps the whole frame, so that each field is patched in place.
+// IP/UDP/TCP checksums are updated by checksum_incremental_d16/d32/d64()
+// (RFC 1624) and FCS is updated by patch_eth_crc().
+// Bytes after UDP/TCP payload up to 'max_len' are kept zero.
+//----------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "eth_ip_udp_tcp_pkt.h"
+#include "pkt_template.h"
+
+//-----------------------------------------------------
+static const char *pkt_field_name[PKT_FIELD_NUM] = {
+       "mac_src"
+     , "mac_dst"
+     , "ip_id"
+     , "ttl"
+     , "ip_src"
+     , "ip_dst"
+     , "port_src"
+     , "port_dst"
+     , "seq_num"
+     , "ack_num"
+     , "bnum_payload"
+};
+
+//-----------------------------------------------------
+// Big-endian access to the frame.
+static uint16_t tpl_get16(const uint8_t *pt) {
+    return ((uint16_t)pt[0]<<8)|pt[1];
+}
+static uint32_t tpl_get32(const uint8_t *pt) {
+    return ((uint32_t)tpl_get16(pt)<<16)|tpl_get16(pt+2);
+}
+static uint64_t tpl_get64(const uint8_t *pt) {
+    return ((uint64_t)tpl_get32(pt)<<32)|tpl_get32(pt+4);
+}
+static void tpl_put(uint8_t *pt, uint64_t value, int num) {
+    int idx;
+    for (idx=num-1; idx>=0; idx--) { pt[idx] = value&0xFF; value >>= 8; }
+}
+
+//-----------------------------------------------------
+// It writes 'num' bytes at 'offset' of the frame and keeps FCS.
+static void tpl_write(pkt_template_t *tpl, int offset, const uint8_t *data, int num) {
+    if (tpl->add_crc) {
+        patch_eth_crc(&tpl->frame[tpl->eth], tpl->bnum-tpl->eth, offset-tpl->eth, data, num);
+    } else {
+        memcpy((void*)&tpl->frame[offset], (const void*)data, num);
+    }
+}
+
+//-----------------------------------------------------
+// It updates checksum field at 'offset' for a word changed from 'old_val' to 'new_val'.
+// Checksum field keeps inverted sum, while checksum_incremental_*()
+// takes and returns not-inverted one.
+static void tpl_check16(pkt_template_t *tpl, int offset, uint16_t old_val, uint16_t new_val) {
+    uint8_t  buf[2];
+    uint16_t check = ~tpl_get16(&tpl->frame[offset]);
+    check = checksum_incremental_d16(check, old_val, new_val);
+    tpl_put(buf, (uint16_t)~check, 2);
+    tpl_write(tpl, offset, buf, 2);
+}
+static void tpl_check32(pkt_template_t *tpl, int offset, uint32_t old_val, uint32_t new_val) {
+    uint8_t  buf[2];
+    uint16_t check = ~tpl_get16(&tpl->frame[offset]);
+    check = checksum_incremental_d32(check, old_val, new_val);
+    tpl_put(buf, (uint16_t)~check, 2);
+    tpl_write(tpl, offset, buf, 2);
+}
+static void tpl_check64(pkt_template_t *tpl, int offset, uint64_t old_val, uint64_t new_val) {
+    uint8_t  buf[2];
+    uint16_t check = ~tpl_get16(&tpl->frame[offset]);
+    check = checksum_incremental_d64(check, old_val, new_val);
+    tpl_put(buf, (uint16_t)~check, 2);
+    tpl_write(tpl, offset, buf, 2);
+}
+
+//-----------------------------------------------------
+// It sets 'bnum' from payload length and fills FCS if any,
+// where padding is added along with FCS as the builders do.
+static void tpl_fcs(pkt_template_t *tpl) {
+    int min = (tpl->add_crc) ? 46-IP_HDR_LEN-tpl->hdr_len : 0; // min of payload
+    tpl->bnum = tpl->l4+tpl->hdr_len+((tpl->payload_len<min) ? min : tpl->payload_len);
+    if (tpl->add_crc) {
+        uint32_t crc = compute_eth_crc(&tpl->frame[tpl->eth], tpl->bnum-tpl->eth);
+        memcpy((void*)&tpl->frame[tpl->bnum], (void*)&crc, 4); // LSByte first
+        tpl->bnum += 4;
+    }
+}
+
+//-----------------------------------------------------
+// It replaces payload bytes and updates UDP/TCP checksum.
+// Words of 16, 32 and 64 bits go through checksum_incremental_*(),
+// otherwise sums of 16-bit words covering them before and after are used.
+static void tpl_payload(pkt_template_t *tpl, int offset, const uint8_t *data, int num) {
+    uint8_t *l4 = &tpl->frame[tpl->l4];
+    int rel = tpl->hdr_len+offset; // from UDP/TCP header
+    int sum = tpl->l4+tpl->sum_off;
+    int start, end;
+    uint16_t old;
+    if (num<=0) return;
+    if (!tpl->check) {
+        tpl_write(tpl, tpl->l4+rel, data, num);
+        return;
+    }
+    if ((rel%2)==0) {
+        switch (num) {
+        case 2: tpl_check16(tpl, sum, tpl_get16(&l4[rel]), tpl_get16(data));
+                tpl_write(tpl, tpl->l4+rel, data, num);
+                return;
+        case 4: tpl_check32(tpl, sum, tpl_get32(&l4[rel]), tpl_get32(data));
+                tpl_write(tpl, tpl->l4+rel, data, num);
+                return;
+        case 8: tpl_check64(tpl, sum, tpl_get64(&l4[rel]), tpl_get64(data));
+                tpl_write(tpl, tpl->l4+rel, data, num);
+                return;
+        }
+    }
+    start = rel&~1;
+    end   = (rel+num+1)&~1;
+    if (end>(tpl->hdr_len+tpl->payload_len)) end = tpl->hdr_len+tpl->payload_len;
+    old = compute_checksum(&l4[start], end-start);
+    tpl_write(tpl, tpl->l4+rel, data, num);
+    tpl_check16(tpl, sum, old, compute_checksum(&l4[start], end-start));
+}
+
+//-----------------------------------------------------
+// It changes UDP/TCP payload length, where payload bytes appended are zero.
+// FCS is computed again since it moves.
+static void tpl_length(pkt_template_t *tpl, int leng) {
+    uint8_t *ip  = &tpl->frame[tpl->ip];
+    uint8_t *l4  = &tpl->frame[tpl->l4];
+    int add_crc  = tpl->add_crc;
+    int old      = tpl->payload_len;
+    uint8_t buf[2];
+
+    tpl->add_crc = 0; // FCS is not patched on the way
+    if (add_crc) memset((void*)&tpl->frame[tpl->bnum-4], 0, 4);
+    if (leng<old) {
+        uint8_t *zero = (uint8_t*)calloc(old-leng, 1);
+        if (zero!=NULL) {
+            tpl_payload(tpl, leng, zero, old-leng);
+            free(zero);
+        }
+    }
+    tpl->payload_len = leng;
+    tpl_check16(tpl, tpl->ip+10, tpl_get16(&ip[2]), IP_HDR_LEN+tpl->hdr_len+leng);
+    tpl_put(buf, IP_HDR_LEN+tpl->hdr_len+leng, 2);
+    tpl_write(tpl, tpl->ip+2, buf, 2);
+    if (tpl->check) { // length in pseudo header
+        tpl_check16(tpl, tpl->l4+tpl->sum_off, tpl->hdr_len+old, tpl->hdr_len+leng);
+    }
+    if (tpl->protocol==IP_PROTO_UDP) {
+        if (tpl->check) tpl_check16(tpl, tpl->l4+tpl->sum_off, tpl_get16(&l4[4]), tpl->hdr_len+leng);
+        tpl_put(buf, tpl->hdr_len+leng, 2);
+        tpl_write(tpl, tpl->l4+4, buf, 2);
+    }
+    tpl->add_crc = add_crc;
+    tpl_fcs(tpl);
+}
+
+//-----------------------------------------------------
+// It builds a frame of the template.
+// max_len: payload length can be changed up to it.
+// return NULL on failure
+pkt_template_t *pkt_template_create( uint8_t   protocol
+                                   , uint8_t   mac_src[6] // network order
+                                   , uint8_t   mac_dst[6] // network order
+                                   , uint32_t  ip_src     // host order
+                                   , uint32_t  ip_dst     // host order
+                                   , uint16_t  port_src   // host order
+                                   , uint16_t  port_dst   // host order
+                                   , int       payload_len// UDP/TCP payload length
+                                   , uint8_t  *payload    // zero payload if 0
+                                   , int       max_len    // max of payload length
+                                   , int check
+                                   , int add_crc
+                                   , int add_preamble
+                                   )
+{
+    pkt_template_t *tpl;
+    pseudo_ip_hdr_t pseudo_ip_hdr;
+    int hdr_len, size;
+
+    if (protocol==IP_PROTO_UDP) hdr_len = UDP_HDR_LEN;
+    else if (protocol==IP_PROTO_TCP) hdr_len = TCP_HDR_LEN;
+    else return NULL;
+    if (max_len<payload_len) max_len = payload_len;
+    if ((payload_len<0)||(max_len>(IP_PKT_MAX-IP_HDR_LEN-hdr_len))) return NULL;
+    size  = 8+ETH_HDR_LEN+IP_HDR_LEN+hdr_len+4;
+    size += (max_len<(46-IP_HDR_LEN-hdr_len)) ? (46-IP_HDR_LEN-hdr_len) : max_len;
+    tpl = (pkt_template_t*)calloc(1, sizeof(pkt_template_t));
+    if (tpl==NULL) return NULL;
+    tpl->frame = (uint8_t*)calloc(size, 1); // payload and padding are zero
+    if (tpl->frame==NULL) { free(tpl); return NULL; }
+
+    tpl->eth         = (add_preamble) ? 8 : 0;
+    tpl->ip          = tpl->eth+ETH_HDR_LEN;
+    tpl->l4          = tpl->ip+IP_HDR_LEN;
+    tpl->hdr_len     = hdr_len;
+    tpl->sum_off     = (protocol==IP_PROTO_UDP) ? 6 : 16;
+    tpl->payload_len = payload_len;
+    tpl->max_len     = max_len;
+    tpl->protocol    = protocol;
+    tpl->check       = check;
+    tpl->add_crc     = add_crc;
+
+    // checksum and FCS are filled below regardless of payload length
+    if (protocol==IP_PROTO_UDP)
+         gen_eth_ip_udp_packet( tpl->frame, mac_src, mac_dst, ip_src, ip_dst
+                              , port_src, port_dst, payload_len, payload
+                              , 0, 0, add_preamble);
+    else gen_eth_ip_tcp_packet( tpl->frame, mac_src, mac_dst, ip_src, ip_dst
+                              , port_src, port_dst, 0, 0, payload_len, payload
+                              , 0, 0, add_preamble);
+    if (check) {
+        populate_pseudo_ip_hdr( &pseudo_ip_hdr, ip_src, ip_dst, protocol
+                              , hdr_len+payload_len);
+        if (protocol==IP_PROTO_UDP) {
+            udp_hdr_t *udp_hdr = (udp_hdr_t*)&tpl->frame[tpl->l4];
+            udp_hdr->udp_sum = htons(compute_udp_checksum(&pseudo_ip_hdr, udp_hdr));
+        } else {
+            tcp_hdr_t *tcp_hdr = (tcp_hdr_t*)&tpl->frame[tpl->l4];
+            tcp_hdr->tcp_sum = htons(compute_tcp_checksum(&pseudo_ip_hdr, tcp_hdr));
+        }
+    }
+    tpl_fcs(tpl);
+    return tpl;
+}
+
+//-----------------------------------------------------
+void pkt_template_release(pkt_template_t *tpl) {
+    if (tpl==NULL) return;
+    free(tpl->frame);
+    free(tpl);
+}
+
+//-----------------------------------------------------
+// return PKT_FIELD_* of 'name', e.g., "seq_num", -1 if unknown.
+int pkt_template_field(const char *name) {
+    int field;
+    if (name==NULL) return -1;
+    for (field=0; field<PKT_FIELD_NUM; field++) {
+         if (!strcmp(name, pkt_field_name[field])) return field;
+    }
+    return -1;
+}
+
+//-----------------------------------------------------
+// It patches 'field' with 'value' in host order.
+// return 0 on success, -1 on failure
+int pkt_template_set(pkt_template_t *tpl, int field, uint64_t value) {
+    uint8_t *ip = &tpl->frame[tpl->ip];
+    uint8_t *l4 = &tpl->frame[tpl->l4];
+    int ip_sum = tpl->ip+10;
+    int l4_sum = tpl->l4+tpl->sum_off;
+    uint8_t  buf[6];
+    uint16_t old16;
+    uint32_t old32;
+
+    switch (field) {
+    case PKT_FIELD_MAC_SRC:
+    case PKT_FIELD_MAC_DST:
+         tpl_put(buf, value, 6);
+         tpl_write(tpl, tpl->eth+((field==PKT_FIELD_MAC_DST) ? 0 : 6), buf, 6);
+         break;
+    case PKT_FIELD_IP_ID:
+         tpl_check16(tpl, ip_sum, tpl_get16(&ip[4]), (uint16_t)value);
+         tpl_put(buf, value, 2);
+         tpl_write(tpl, tpl->ip+4, buf, 2);
+         break;
+    case PKT_FIELD_TTL: // it shares 16-bit word with protocol
+         old16 = tpl_get16(&ip[8]);
+         tpl_put(buf, ((value&0xFF)<<8)|(old16&0xFF), 2);
+         tpl_check16(tpl, ip_sum, old16, tpl_get16(buf));
+         tpl_write(tpl, tpl->ip+8, buf, 2);
+         break;
+    case PKT_FIELD_IP_SRC:
+    case PKT_FIELD_IP_DST: // in pseudo header as well
+         old32 = tpl_get32(&ip[(field==PKT_FIELD_IP_SRC) ? 12 : 16]);
+         tpl_check32(tpl, ip_sum, old32, (uint32_t)value);
+         if (tpl->check) tpl_check32(tpl, l4_sum, old32, (uint32_t)value);
+         tpl_put(buf, value, 4);
+         tpl_write(tpl, tpl->ip+((field==PKT_FIELD_IP_SRC) ? 12 : 16), buf, 4);
+         break;
+    case PKT_FIELD_PORT_SRC:
+    case PKT_FIELD_PORT_DST:
+         old16 = tpl_get16(&l4[(field==PKT_FIELD_PORT_SRC) ? 0 : 2]);
+         if (tpl->check) tpl_check16(tpl, l4_sum, old16, (uint16_t)value);
+         tpl_put(buf, value, 2);
+         tpl_write(tpl, tpl->l4+((field==PKT_FIELD_PORT_SRC) ? 0 : 2), buf, 2);
+         break;
+    case PKT_FIELD_SEQ_NUM:
+    case PKT_FIELD_ACK_NUM:
+         if (tpl->protocol!=IP_PROTO_TCP) return -1;
+         old32 = tpl_get32(&l4[(field==PKT_FIELD_SEQ_NUM) ? 4 : 8]);
+         if (tpl->check) tpl_check32(tpl, l4_sum, old32, (uint32_t)value);
+         tpl_put(buf, value, 4);
+         tpl_write(tpl, tpl->l4+((field==PKT_FIELD_SEQ_NUM) ? 4 : 8), buf, 4);
+         break;
+    case PKT_FIELD_BNUM_PAYLOAD:
+         if (value>(uint64_t)tpl->max_len) return -1;
+         if ((int)value!=tpl->payload_len) tpl_length(tpl, (int)value);
+         break;
+    default: return -1;
+    }
+    return 0;
+}
+
+//-----------------------------------------------------
+// It patches 'num' bytes of payload at 'offset', e.g., timestamp.
+// return 0 on success, -1 on failure
+int pkt_template_set_payload(pkt_template_t *tpl, int offset, const uint8_t *data, int num) {
+    if ((offset<0)||(num<0)||((offset+num)>tpl->payload_len)) return -1;
+    tpl_payload(tpl, offset, data, num);
+    return 0;
+}
+
+//-----------------------------------------------------
+// It copies the frame to 'packet' and returns num of bytes.
+int pkt_template_emit(pkt_template_t *tpl, uint8_t *packet) {
+    memcpy((void*)packet, (void*)tpl->frame, tpl->bnum);
+    return tpl->bnum;
+}
+
+//----------------------------------------------------------------------------
+// Revision history:
+//
+// 2019.05.20: Rewritten by Ando Ki (andoki@gmail.com)
+//----------------------------------------------------------------------------
@@ -0,0 +1,86 @@
+#ifndef PKT_TEMPLATE_H
+#define PKT_TEMPLATE_H
+//----------------------------------------------------------------------------
+// Copyright (c) 2019 by Ando Ki.
+// All right reserved.
+//----------------------------------------------------------------------------
+// VERSION = 2019.05.20.
+//----------------------------------------------------------------------------
+// Packet template: an Ethernet/IP/UDP or Ethernet/IP/TCP frame is built once
+// and its variants are emitted by patching fields, where IP/UDP/TCP checksums
+// and FCS are updated incrementally instead of being computed again.
+//----------------------------------------------------------------------------
+#include <stdint.h>
+#include "eth_ip_udp_tcp_pkt.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//----------------------------------------------------------------------------
+typedef struct pkt_template {
+    uint8_t  *frame;  // whole frame including preamble and FCS if any
+    int       bnum;   // num of bytes of 'frame'
+    int       eth;    // offset of Ethernet header; 8 when preamble
+    int       ip;     // offset of IP header
+    int       l4;     // offset of UDP/TCP header
+    int       hdr_len;// num of bytes of UDP/TCP header
+    int       sum_off;// offset of checksum field in UDP/TCP header
+    int       payload_len; // num of bytes of UDP/TCP payload
+    int       max_len;// 'payload_len' can grow up to this
+    uint8_t   protocol; // IP_PROTO_UDP or IP_PROTO_TCP
+    int       check;  // UDP/TCP checksum is kept when 1
+    int       add_crc;// FCS is kept when 1
+} pkt_template_t;
+
+//----------------------------------------------------------------------------
+// Fields to be patched; 'value' of pkt_template_set() is in host order.
+#define PKT_FIELD_MAC_SRC       0 // 48-bit
+#define PKT_FIELD_MAC_DST       1 // 48-bit
+#define PKT_FIELD_IP_ID         2 // 16-bit
+#define PKT_FIELD_TTL           3 // 8-bit
+#define PKT_FIELD_IP_SRC        4 // 32-bit
+#define PKT_FIELD_IP_DST        5 // 32-bit
+#define PKT_FIELD_PORT_SRC      6 // 16-bit
+#define PKT_FIELD_PORT_DST      7 // 16-bit
+#define PKT_FIELD_SEQ_NUM       8 // 32-bit, TCP only
+#define PKT_FIELD_ACK_NUM       9 // 32-bit, TCP only
+#define PKT_FIELD_BNUM_PAYLOAD 10 // num of bytes of UDP/TCP payload up to 'max_len'
+#define PKT_FIELD_NUM          11
+
+//----------------------------------------------------------------------------
+extern pkt_template_t *pkt_template_create( uint8_t   protocol   // IP_PROTO_UDP or IP_PROTO_TCP
+                                          , uint8_t   mac_src[6] // network order
+                                          , uint8_t   mac_dst[6] // network order
+                                          , uint32_t  ip_src     // host order
+                                          , uint32_t  ip_dst     // host order
+                                          , uint16_t  port_src   // host order
+                                          , uint16_t  port_dst   // host order
+                                          , int       payload_len// UDP/TCP payload length
+                                          , uint8_t  *payload    // zero payload if 0
+                                          , int       max_len    // max of payload length
+                                          , int check            // keep UDP/TCP checksum
+                                          , int add_crc          // add CRC when 1
+                                          , int add_preamble);   // add preamble when 1
+extern void pkt_template_release    ( pkt_template_t *tpl );
+extern int  pkt_template_field      ( const char *name ); // PKT_FIELD_* by name, -1 if unknown
+extern int  pkt_template_set        ( pkt_template_t *tpl
+                                    , int             field  // PKT_FIELD_*
+                                    , uint64_t        value);// host order
+extern int  pkt_template_set_payload( pkt_template_t *tpl
+                                    , int             offset // from the first byte of payload
+                                    , const uint8_t  *data
+                                    , int             num);
+extern int  pkt_template_emit       ( pkt_template_t *tpl
+                                    , uint8_t        *packet); // returns num of bytes
+
+#ifdef __cplusplus
+}
+#endif
+
+//----------------------------------------------------------------------------
+// Revision history:
+//
+// 2019.05.20: Rewritten by Ando Ki (andoki@gmail.com)
+//----------------------------------------------------------------------------
+#endif /*PKT_TEMPLATE_H*/
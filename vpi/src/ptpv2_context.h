@@ -20,6 +20,10 @@ typedef struct ptpv2_cfg {
    uint32_t  verbose; // verbose level
 } ptpv2_cfg_t;
 
+//----------------------------------------------------------------------------
+// Room for TLVs appended to messages of a type.
+#define PTPV2_TLV_MAX  1024
+
 //----------------------------------------------------------------------------
 typedef struct ptpv2_ctx {
    uint32_t ptp_version   ;
@@ -28,6 +32,22 @@ typedef struct ptpv2_ctx {
    uint32_t unicast_port  ;
    uint32_t profile_spec1 ;
    uint32_t profile_spec2 ;
+   // carried by Announce; see IEEE.Std 1588-2008 13.5
+   uint32_t utc_offset    ; // currentUtcOffset
+   uint32_t gm_priority1  ;
+   uint32_t gm_clock_class;
+   uint32_t gm_clock_accuracy;
+   uint32_t gm_clock_variance; // offsetScaledLogVariance
+   uint32_t gm_priority2  ;
+   uint64_t gm_identity   ;
+   uint32_t steps_removed ;
+   uint32_t time_source   ;
+   // carried by Management; see IEEE.Std 1588-2008 15.4
+   uint32_t boundary_hops ; // startingBoundaryHops and boundaryHops
+   uint32_t action        ; // actionField
+   // TLVs in network order appended to each message type
+   uint16_t tlv_len[16];
+   uint8_t  tlv[16][PTPV2_TLV_MAX];
 } ptpv2_ctx_t;
 
 //----------------------------------------------------------------------------
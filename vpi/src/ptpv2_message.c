@@ -5,6 +5,8 @@
 // VERSION = 2019.05.20.
 //----------------------------------------------------------------------------
 #include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
 #include <string.h>
 #include <stdint.h>
 #include "ptpv2_etc.h"
@@ -80,11 +82,29 @@ inline static uint16_t get_msg_length(uint8_t type)
       case PTPV2_MSG_Delay_Resp           : return sizeof(ptpv2_msg_delay_resp_t); break;
       case PTPV2_MSG_Pdelay_Resp_Follow_Up: return sizeof(ptpv2_msg_pdelay_resp_follow_up_t); break;
       case PTPV2_MSG_Announce             : return sizeof(ptpv2_msg_announce_t); break;
-      case PTPV2_MSG_Signaling            : return sizeof(ptpv2_msg_signaling_t); break;
-      case PTPV2_MSG_Management           : return sizeof(ptpv2_msg_management_t); break;
+      case PTPV2_MSG_Signaling            : return offsetof(ptpv2_msg_signaling_t, TLVs); break;
+      case PTPV2_MSG_Management           : return offsetof(ptpv2_msg_management_t, managementTLV); break;
       default: PTPV2_ERROR("Un-known PTPv22 message type: %u\n", type); return 0;
       }
 }
+//-----------------------------------------------------------------------------
+// Return offset of timestamp which the message carries from 'time',
+// 0 when it has none or it is zero due to one-step clock.
+inline static int get_msg_time_offset(ptpv2_ctx_t *ctx, uint8_t type)
+{
+      switch (type) {
+      case PTPV2_MSG_Sync                 :
+      case PTPV2_MSG_Delay_Req            :
+      case PTPV2_MSG_Pdelay_Req           :
+      case PTPV2_MSG_Pdelay_Resp          : return (ctx->one_step_clock) ? 0 : PTPV2_HDR_LEN; break;
+      case PTPV2_MSG_Delay_Resp           : // receiveTimestamp for both one-step and two-step
+      case PTPV2_MSG_Follow_Up            :
+      case PTPV2_MSG_Pdelay_Resp_Follow_Up:
+      case PTPV2_MSG_Announce             : return PTPV2_HDR_LEN; break;
+      default:                              return 0; break;
+      }
+}
+
 //-----------------------------------------------------------------------------
 // see IEEE.Std 1588-2008 pp.126
 // Return message flags
@@ -154,7 +174,7 @@ int populate_ptpv2_msg_hdr( ptpv2_ctx_t     *ctx
     msg_hdr->transportSpecific   = 0x0;
     msg_hdr->messageType         = type&0xF; // lower 4-bit
     msg_hdr->versionPTP          = ctx->ptp_version&0xF; // it should be 2
-    msg_hdr->messageLength       = htons(get_msg_length(type));
+    msg_hdr->messageLength       = htons(get_msg_length(type)+ctx->tlv_len[type&0xF]);
     msg_hdr->domainNumber        = ctx->ptp_domain;
     msg_hdr->flagField           = htons(get_msg_flags(ctx,type));
     msg_hdr->correctionField.low = 0x0;
@@ -167,6 +187,86 @@ int populate_ptpv2_msg_hdr( ptpv2_ctx_t     *ctx
     return PTPV2_HDR_LEN; // 34
 }
 
+//-----------------------------------------------------------------------------
+// It fills PTPv2 message header from values in host order,
+// which is used by VPI and DPI tasks.
+// Returns message length including TLVs of get_ptpv2_context(),
+// 0 when message type is unknown.
+int fill_ptpv2_msg_hdr( ptpv2_msg_hdr_t *msg_hdr
+                      , uint8_t          type
+                      , uint16_t         flag
+                      , uint64_t         correction // 8-byte
+                      , uint64_t         clock_id // 8-byte
+                      , uint16_t         port_id
+                      , uint16_t         seq_id)
+{
+    uint16_t msg_len;
+    uint8_t  unicast=0; // 0: multicst, 1: unicast [NEED attention...]
+    int idx;
+
+    memset((void*)msg_hdr, 0, sizeof(ptpv2_msg_hdr_t));
+    msg_hdr->messageType = type&0xF;
+    msg_hdr->versionPTP  = 0x2;
+    msg_hdr->flagField   = htons(flag);
+    msg_hdr->correctionField.low  = htonl((uint32_t)correction);
+    msg_hdr->correctionField.high = htonl((uint32_t)(correction>>32));
+    for (idx=0; idx<8; idx++) {
+         msg_hdr->sourcePortIdentity.clockIdentity[idx] = (clock_id>>(8*(7-idx)))&0xFF;
+    }
+    msg_hdr->sourcePortIdentity.portNumber = htons(port_id);
+    msg_hdr->sequenceID = htons(seq_id);
+
+    msg_len = get_msg_length(msg_hdr->messageType);
+    if (msg_len==0) return 0;
+    msg_len += get_ptpv2_context()->tlv_len[msg_hdr->messageType];
+    msg_hdr->messageLength = htons(msg_len);
+    switch (msg_hdr->messageType) {
+    case PTPV2_MSG_Sync      :
+    case PTPV2_MSG_Delay_Req :
+    case PTPV2_MSG_Follow_Up :
+    case PTPV2_MSG_Delay_Resp: msg_hdr->logMessageInterval = (unicast) ? 0x7F: 0x03; break;
+    default:                   msg_hdr->logMessageInterval = 0x7F; break;
+    }
+    return msg_len;
+}
+
+//-----------------------------------------------------------------------------
+// It appends TLVs of the message type after 'leng' bytes of 'msg'
+// and sets messageLength.
+// Return message length.
+static int put_msg_tlv(ptpv2_ctx_t *ctx, uint8_t *msg, int leng)
+{
+    ptpv2_msg_hdr_t *hdr = (ptpv2_msg_hdr_t*)msg;
+    int num = ctx->tlv_len[hdr->messageType];
+    if (num>0) memcpy((void*)&msg[leng], (void*)ctx->tlv[hdr->messageType], num);
+    hdr->messageLength = htons(leng+num);
+    return leng+num;
+}
+
+//-----------------------------------------------------------------------------
+// 'time' in host order; zero if NULL.
+static void put_msg_time(Timestamp_t *field, Timestamp_t *time)
+{
+    if (time==NULL) {
+        memset((void*)field, 0, sizeof(Timestamp_t));
+    } else {
+        field->secondsField.msb = htons(time->secondsField.msb);
+        field->secondsField.lsb = htonl(time->secondsField.lsb);
+        field->nanosecondsField = htonl(time->nanosecondsField);
+    }
+}
+
+//-----------------------------------------------------------------------------
+// 'port' in network order; all 'fill' if NULL.
+static void put_msg_port(PortIdentity_t *field, PortIdentity_t *port, uint8_t fill)
+{
+    if (port==NULL) {
+        memset((void*)field, fill, sizeof(PortIdentity_t));
+    } else {
+        memcpy((void*)field, (void*)port, sizeof(PortIdentity_t));
+    }
+}
+
 //-----------------------------------------------------------------------------
 int gen_ptpv2_msg_sync( ptpv2_ctx_t     *ctx
                       , uint8_t         *msg
@@ -192,7 +292,7 @@ int gen_ptpv2_msg_sync( ptpv2_ctx_t     *ctx
       msg_sync->originTimestamp.secondsField.lsb = htonl(time->secondsField.lsb);
       msg_sync->originTimestamp.nanosecondsField = htonl(time->nanosecondsField);
     }
-    return sizeof(ptpv2_msg_sync_t);
+    return put_msg_tlv(ctx, msg, sizeof(ptpv2_msg_sync_t));
 }
 
 //-----------------------------------------------------------------------------
@@ -218,7 +318,7 @@ int gen_ptpv2_msg_follow_up( ptpv2_ctx_t *ctx
     msg_fol->preciseOriginTimestamp.secondsField.lsb = htonl(time->secondsField.lsb);
     msg_fol->preciseOriginTimestamp.nanosecondsField = htonl(time->nanosecondsField);
 
-    return sizeof(ptpv2_msg_follow_up_t);
+    return put_msg_tlv(ctx, msg, sizeof(ptpv2_msg_follow_up_t));
 }
 int gen_ptpv2_msg_delay_req( ptpv2_ctx_t *ctx
                       , uint8_t          *msg
@@ -248,7 +348,7 @@ int gen_ptpv2_msg_delay_req( ptpv2_ctx_t *ctx
       msg_delay_req->originTimestamp.secondsField.lsb = htonl(time->secondsField.lsb);
       msg_delay_req->originTimestamp.nanosecondsField = htonl(time->nanosecondsField);
     }
-    return sizeof(ptpv2_msg_delay_req_t);
+    return put_msg_tlv(ctx, msg, sizeof(ptpv2_msg_delay_req_t));
 }
 int gen_ptpv2_msg_delay_resp( ptpv2_ctx_t *ctx
                            , uint8_t     *msg
@@ -267,17 +367,8 @@ int gen_ptpv2_msg_delay_resp( ptpv2_ctx_t *ctx
     //                            , PTPV2_MSG_Delay_Resp
     //                            , seq_id
     //                            );
-    if (ctx->one_step_clock) {
-      memset((void*)&(msg_delay_resp->receiveTimestamp), 0, sizeof(Timestamp_t));
-    } else {
-      //ret = ptp_get_time_rtc(&sec_msb, &sec_lsb, &nano);
-      //if (ret) {
-      //    PTPV2_ERROR("something wrong while getting ptp_get_time\n");
-      //}
-      msg_delay_resp->receiveTimestamp.secondsField.msb = htons(time->secondsField.msb);
-      msg_delay_resp->receiveTimestamp.secondsField.lsb = htonl(time->secondsField.lsb);
-      msg_delay_resp->receiveTimestamp.nanosecondsField = htonl(time->nanosecondsField);
-    }
+    // receiveTimestamp is carried by both one-step and two-step clock
+    put_msg_time(&msg_delay_resp->receiveTimestamp, time);
     if (port==NULL) {
         memset((void*)&(msg_delay_resp->requestingPortIdentity), 0, sizeof(PortIdentity_t));
     } else {
@@ -292,58 +383,158 @@ int gen_ptpv2_msg_delay_resp( ptpv2_ctx_t *ctx
 //                                                  , port->clockIdentity[7]);
 //printf("PTPv2 portId=+=*=0x%02X\n", ntohs(port->portNumber));
     }
-    return sizeof(ptpv2_msg_delay_resp_t);
+    return put_msg_tlv(ctx, msg, sizeof(ptpv2_msg_delay_resp_t));
 }
+//-----------------------------------------------------------------------------
+// originTimestamp is zero for one-step clock as Delay_Req.
 int gen_ptpv2_msg_pdelay_req( ptpv2_ctx_t *ctx
                             , uint8_t     *msg
                             , ptpv2_msg_hdr_t *hdr
                             , Timestamp_t     *time
                             , PortIdentity_t  *port)
-{ return 0; }
+{
+    ptpv2_msg_pdelay_req_t *msg_pdelay_req = (ptpv2_msg_pdelay_req_t*)msg;
+    if (hdr==NULL) {
+        return 0;
+    } else {
+        memcpy((void*)msg_pdelay_req, (void*)hdr, PTPV2_HDR_LEN);
+    }
+    put_msg_time(&msg_pdelay_req->originTimestamp, (ctx->one_step_clock) ? NULL : time);
+    memset((void*)msg_pdelay_req->res, 0, sizeof(msg_pdelay_req->res));
+    return put_msg_tlv(ctx, msg, sizeof(ptpv2_msg_pdelay_req_t));
+}
+
+//-----------------------------------------------------------------------------
+// 'time': receipt time of Pdelay_Req, which is zero for one-step clock,
+//         since it goes to correctionField.
+// 'port': sourcePortIdentity of Pdelay_Req.
 int gen_ptpv2_msg_pdelay_resp( ptpv2_ctx_t *ctx
                              , uint8_t     *msg
                              , ptpv2_msg_hdr_t *hdr
                              , Timestamp_t     *time
                              , PortIdentity_t  *port)
-{ return 0; }
+{
+    ptpv2_msg_pdelay_resp_t *msg_pdelay_resp = (ptpv2_msg_pdelay_resp_t*)msg;
+    if (hdr==NULL) {
+        return 0;
+    } else {
+        memcpy((void*)msg_pdelay_resp, (void*)hdr, PTPV2_HDR_LEN);
+    }
+    put_msg_time(&msg_pdelay_resp->requestReceiptTimestamp, (ctx->one_step_clock) ? NULL : time);
+    put_msg_port(&msg_pdelay_resp->requestingPortIdentity, port, 0x00);
+    return put_msg_tlv(ctx, msg, sizeof(ptpv2_msg_pdelay_resp_t));
+}
+
+//-----------------------------------------------------------------------------
+// 'time': origin time of Pdelay_Resp.
+// 'port': sourcePortIdentity of Pdelay_Req.
 int gen_ptpv2_msg_pdelay_resp_follow_up( ptpv2_ctx_t *ctx
                                        , uint8_t     *msg
                                        , ptpv2_msg_hdr_t *hdr
                                        , Timestamp_t     *time
                                        , PortIdentity_t  *port)
-{ return 0; }
+{
+    ptpv2_msg_pdelay_resp_follow_up_t *msg_pdelay_fol = (ptpv2_msg_pdelay_resp_follow_up_t*)msg;
+    if (hdr==NULL) {
+        return 0;
+    } else {
+        memcpy((void*)msg_pdelay_fol, (void*)hdr, PTPV2_HDR_LEN);
+    }
+    put_msg_time(&msg_pdelay_fol->responseOriginTimestamp, time);
+    put_msg_port(&msg_pdelay_fol->requestingPortIdentity, port, 0x00);
+    return put_msg_tlv(ctx, msg, sizeof(ptpv2_msg_pdelay_resp_follow_up_t));
+}
+
+//-----------------------------------------------------------------------------
+// Grandmaster and time properties come from 'ctx'; see set_ptpv2_announce().
 int gen_ptpv2_msg_announce( ptpv2_ctx_t *ctx
                           , uint8_t     *msg
                           , ptpv2_msg_hdr_t *hdr
                           , Timestamp_t     *time
                           , PortIdentity_t  *port)
-{ return 0; }
+{
+    ptpv2_msg_announce_t *msg_announce = (ptpv2_msg_announce_t*)msg;
+    int idx;
+    if (hdr==NULL) {
+        return 0;
+    } else {
+        memcpy((void*)msg_announce, (void*)hdr, PTPV2_HDR_LEN);
+    }
+    put_msg_time(&msg_announce->originTimestamp, time);
+    msg_announce->currentUTCOffset     = htons(ctx->utc_offset);
+    msg_announce->res                  = 0;
+    msg_announce->grandmasterPriority1 = ctx->gm_priority1;
+    msg_announce->grandmasterClockQuality.clockClass              = ctx->gm_clock_class;
+    msg_announce->grandmasterClockQuality.clockAccuracy           = ctx->gm_clock_accuracy;
+    msg_announce->grandmasterClockQuality.offsetScaledLogVariance = htons(ctx->gm_clock_variance);
+    msg_announce->grandmasterPriority2 = ctx->gm_priority2;
+    for (idx=0; idx<8; idx++) {
+         msg_announce->grandmasterIdentity[idx] = (ctx->gm_identity>>(8*(7-idx)))&0xFF;
+    }
+    msg_announce->stepsRemoved         = htons(ctx->steps_removed);
+    msg_announce->timeSource           = ctx->time_source;
+    return put_msg_tlv(ctx, msg, sizeof(ptpv2_msg_announce_t));
+}
+
+//-----------------------------------------------------------------------------
+// 'port': targetPortIdentity; all ports if NULL.
+// TLVs come from 'ctx'; see add_ptpv2_tlv().
 int gen_ptpv2_msg_signaling( ptpv2_ctx_t *ctx
                            , uint8_t     *msg
                            , ptpv2_msg_hdr_t *hdr
                            , Timestamp_t     *time
                            , PortIdentity_t  *port)
-{ return 0; }
+{
+    ptpv2_msg_signaling_t *msg_signaling = (ptpv2_msg_signaling_t*)msg;
+    if (hdr==NULL) {
+        return 0;
+    } else {
+        memcpy((void*)msg_signaling, (void*)hdr, PTPV2_HDR_LEN);
+    }
+    put_msg_port(&msg_signaling->targetPortIdentity, port, 0xFF);
+    return put_msg_tlv(ctx, msg, offsetof(ptpv2_msg_signaling_t, TLVs));
+}
+
+//-----------------------------------------------------------------------------
+// 'port': targetPortIdentity; all ports if NULL.
+// actionField and boundary hops come from 'ctx'; see set_ptpv2_management().
+// Management TLV comes from 'ctx'; see add_ptpv2_tlv().
 int gen_ptpv2_msg_management( ptpv2_ctx_t *ctx
                             , uint8_t     *msg
                             , ptpv2_msg_hdr_t *hdr
                             , Timestamp_t     *time
                             , PortIdentity_t  *port)
-{ return 0; }
+{
+    ptpv2_msg_management_t *msg_management = (ptpv2_msg_management_t*)msg;
+    if (hdr==NULL) {
+        return 0;
+    } else {
+        memcpy((void*)msg_management, (void*)hdr, PTPV2_HDR_LEN);
+    }
+    put_msg_port(&msg_management->targetPortIdentity, port, 0xFF);
+    msg_management->startingBoundaryHops = ctx->boundary_hops;
+    msg_management->BoundaryHops         = ctx->boundary_hops;
+    msg_management->rese                 = 0;
+    msg_management->actionField          = ctx->action&0xF;
+    msg_management->reserve              = 0;
+    return put_msg_tlv(ctx, msg, offsetof(ptpv2_msg_management_t, managementTLV));
+}
 
 //-----------------------------------------------------------------------------
-int gen_ptpv2_msg_ethernet ( ptpv2_ctx_t *ctx
-                           , uint8_t     *msg  // PTPv2 over Ethernet message to be built
-                           , uint8_t      mac_src[6]
-                           , ptpv2_msg_hdr_t *hdr
-                           , Timestamp_t     *time // timestamp
-                           , PortIdentity_t  *port // requesting PTPv2 port for Delay_Resp, Pdelay_Resp, Pdelay_Resp_Follow_Up
-                           , int          add_crc // add CRC at the end
-                           , int          add_preamble // add preamble at the beginning
-                           )
+int gen_ptpv2_msg_ethernet_vlan( ptpv2_ctx_t *ctx
+                               , uint8_t     *msg  // PTPv2 over Ethernet message to be built
+                               , uint8_t      mac_src[6]
+                               , const pkt_vlan_t *vlan // VLAN tags, outer first
+                               , int          vlan_num  // num of tags
+                               , ptpv2_msg_hdr_t *hdr
+                               , Timestamp_t     *time // timestamp
+                               , PortIdentity_t  *port // requesting PTPv2 port for Delay_Resp, Pdelay_Resp, Pdelay_Resp_Follow_Up
+                               , int          add_crc // add CRC at the end
+                               , int          add_preamble // add preamble at the beginning
+                               )
 {
-     uint16_t msg_leng;
-     uint8_t  loc = (add_preamble) ? ETH_HDR_LEN+8 : ETH_HDR_LEN;
+     pkt_buf_t buf;
+     int      msg_leng;
      uint8_t  mac_dst[6];
      switch (hdr->messageType) {
      case 0x0: // Event:Sync
@@ -379,37 +570,57 @@ int gen_ptpv2_msg_ethernet ( ptpv2_ctx_t *ctx
 //                                                     , port->clockIdentity[6]
 //                                                     , port->clockIdentity[7]);
 //printf("%s PTPv2 portId=+=*=0x%02X\n", __FUNCTION__, ntohs(port->portNumber));
+     if ((vlan_num<0)||(vlan_num>PKT_VLAN_MAX)) return -1;
+     pkt_buf_init(&buf, msg, PTPV2_FRAME_MAX, ((add_preamble) ? 8 : 0)+ETH_HDR_LEN
+                                             +vlan_num*ETH_VLAN_TAG_LEN);
      msg_leng = gen_ptpv2_msg[hdr->messageType]( ctx
-                                   , &msg[loc]
+                                   , buf.data
                                    , hdr
                                    , time
                                    , port);
+     pkt_buf_put(&buf, msg_leng);
 
-     msg_leng = gen_eth_packet( msg
-                              , mac_src
-                              , mac_dst
-                              , PTPV2_ETHERNET_TYPE_LENGTH // 0x88F7
-                              , msg_leng // payload length, i.e., PTPv2 message length
-                              , 0 // since already copied
-                              , add_crc
-                              , add_preamble);
-     return msg_leng;
+     return gen_eth_packet_vlan_buf( &buf
+                                   , mac_src
+                                   , mac_dst
+                                   , vlan
+                                   , vlan_num
+                                   , PTPV2_ETHERNET_TYPE_LENGTH // 0x88F7
+                                   , add_crc
+                                   , add_preamble);
 }
 
 //-----------------------------------------------------------------------------
-int gen_ptpv2_msg_udp_ip_ethernet( ptpv2_ctx_t *ctx
-                                 , uint8_t     *msg  // PTPv2 over Ethernet message to be built
-                                 , uint8_t      mac_src[6]
-                                 , uint32_t     ip_src
-                                 , ptpv2_msg_hdr_t *hdr
-                                 , Timestamp_t     *time
-                                 , PortIdentity_t  *port
-                                 , int          add_crc // add CRC at the end
-                                 , int          add_preamble // add preamble at the beginning
-                                 )
+int gen_ptpv2_msg_ethernet ( ptpv2_ctx_t *ctx
+                           , uint8_t     *msg  // PTPv2 over Ethernet message to be built
+                           , uint8_t      mac_src[6]
+                           , ptpv2_msg_hdr_t *hdr
+                           , Timestamp_t     *time // timestamp
+                           , PortIdentity_t  *port // requesting PTPv2 port for Delay_Resp, Pdelay_Resp, Pdelay_Resp_Follow_Up
+                           , int          add_crc // add CRC at the end
+                           , int          add_preamble // add preamble at the beginning
+                           )
 {
-     uint16_t msg_leng;
-     uint8_t  loc;
+     return gen_ptpv2_msg_ethernet_vlan( ctx, msg, mac_src, NULL, 0, hdr, time, port
+                                       , add_crc, add_preamble);
+}
+
+//-----------------------------------------------------------------------------
+int gen_ptpv2_msg_udp_ip_ethernet_vlan( ptpv2_ctx_t *ctx
+                                      , uint8_t     *msg  // PTPv2 over Ethernet message to be built
+                                      , uint8_t      mac_src[6]
+                                      , const pkt_vlan_t *vlan // VLAN tags, outer first
+                                      , int          vlan_num  // num of tags
+                                      , uint32_t     ip_src
+                                      , ptpv2_msg_hdr_t *hdr
+                                      , Timestamp_t     *time
+                                      , PortIdentity_t  *port
+                                      , int          add_crc // add CRC at the end
+                                      , int          add_preamble // add preamble at the beginning
+                                      )
+{
+     pkt_buf_t buf;
+     int      msg_leng;
      uint8_t  mac_dst[6];
      uint16_t port_src, port_dst;
      uint32_t ip_dst;
@@ -419,14 +630,7 @@ int gen_ptpv2_msg_udp_ip_ethernet( ptpv2_ctx_t *ctx
      case 0x2: // Event:Pdelay_Req
      case 0x3: // Event:Pdelay_Resp
                port_src   = 319;
-               port_dst   = 319;
-               ip_dst     = 0xE0000181;
-               mac_dst[0] = 0x01;
-               mac_dst[1] = 0x00;
-               mac_dst[2] = 0x5E;
-               mac_dst[3] = 0x00;
-               mac_dst[4] = 0x01;
-               mac_dst[5] = 0x81; break;
+               port_dst   = 319; break;
      case 0x8: // General:Follow_Up
      case 0x9: // General:Delay_Resp
      case 0xA: // General:Pdelay_Resp_Follow_Up
@@ -434,7 +638,15 @@ int gen_ptpv2_msg_udp_ip_ethernet( ptpv2_ctx_t *ctx
      case 0xC: // General:Signaling
      case 0xD: // General:Management
                port_src   = 320;
-               port_dst   = 320;
+               port_dst   = 320; break;
+     default: PTPV2_ERROR("undefined PTPv2 message type: 0x%1X", hdr->messageType);
+     }
+     // see IEEE.Std 1588-2008 Annex D, where peer delay messages
+     // go to 224.0.0.107 and the others to 224.0.1.129.
+     switch (hdr->messageType) {
+     case 0x2: // Pdelay_Req
+     case 0x3: // Pdelay_Resp
+     case 0xA: // Pdelay_Resp_Follow_Up
                ip_dst     = 0xE000006B;
                mac_dst[0] = 0x01;
                mac_dst[1] = 0x00;
@@ -442,47 +654,77 @@ int gen_ptpv2_msg_udp_ip_ethernet( ptpv2_ctx_t *ctx
                mac_dst[3] = 0x00;
                mac_dst[4] = 0x00;
                mac_dst[5] = 0x6B; break;
-     default: PTPV2_ERROR("undefined PTPv2 message type: 0x%1X", hdr->messageType);
+     default:  ip_dst     = 0xE0000181;
+               mac_dst[0] = 0x01;
+               mac_dst[1] = 0x00;
+               mac_dst[2] = 0x5E;
+               mac_dst[3] = 0x00;
+               mac_dst[4] = 0x01;
+               mac_dst[5] = 0x81; break;
      }
-     loc = ETH_HDR_LEN+IP_HDR_LEN+UDP_HDR_LEN;
-     if (add_preamble) loc += 8;
-     msg_leng = (gen_ptpv2_msg[hdr->messageType])(ctx, &msg[loc], hdr, time, port);
-     loc -= UDP_HDR_LEN;
-     msg_leng = gen_udp_packet( &msg[loc]
-                              , port_src // host order
-                              , port_dst // host order
-                              , msg_leng // UDP payload length
-                              , 0); // since already copied
-     loc -= IP_HDR_LEN;
-     msg_leng = gen_ip_packet( &msg[loc]
-                             , ip_src // host order
-                             , ip_dst // host order
-                             , IP_PROTO_UDP // 0x11
-                             , 0 // ttl      // type-length in host order
-                             , msg_leng
-                             , 0   // since already copied
-                             , 0); // since it is UDP, not TCP
-     loc -= ETH_HDR_LEN;
-     if (add_preamble) loc -= 8;
-     msg_leng = gen_eth_packet( &msg[loc]
-                              , mac_src
-                              , mac_dst
-                              , ETH_TYPE_IP // 0x0800
-                              , msg_leng
-                              , 0 // since already copied
-                              , add_crc
-                              , add_preamble);
-     return msg_leng;
+     // PTPv2 message is built after room for all headers,
+     // which are prepended layer by layer.
+     if ((vlan_num<0)||(vlan_num>PKT_VLAN_MAX)) return -1;
+     pkt_buf_init(&buf, msg, PTPV2_FRAME_MAX
+                 , ((add_preamble) ? 8 : 0)+ETH_HDR_LEN+vlan_num*ETH_VLAN_TAG_LEN
+                 +IP_HDR_LEN+UDP_HDR_LEN);
+     msg_leng = (gen_ptpv2_msg[hdr->messageType])(ctx, buf.data, hdr, time, port);
+     pkt_buf_put(&buf, msg_leng);
+     gen_udp_packet_buf( &buf
+                       , port_src // host order
+                       , port_dst); // host order; checksum zero
+     gen_ip_packet_buf( &buf
+                      , ip_src // host order
+                      , ip_dst // host order
+                      , IP_PROTO_UDP // 0x11
+                      , 0 // ttl
+                      , 0); // UDP checksum stays zero
+     return gen_eth_packet_vlan_buf( &buf
+                                   , mac_src
+                                   , mac_dst
+                                   , vlan
+                                   , vlan_num
+                                   , ETH_TYPE_IP // 0x0800
+                                   , add_crc
+                                   , add_preamble);
+}
+
+//-----------------------------------------------------------------------------
+int gen_ptpv2_msg_udp_ip_ethernet( ptpv2_ctx_t *ctx
+                                 , uint8_t     *msg  // PTPv2 over Ethernet message to be built
+                                 , uint8_t      mac_src[6]
+                                 , uint32_t     ip_src
+                                 , ptpv2_msg_hdr_t *hdr
+                                 , Timestamp_t     *time
+                                 , PortIdentity_t  *port
+                                 , int          add_crc // add CRC at the end
+                                 , int          add_preamble // add preamble at the beginning
+                                 )
+{
+     return gen_ptpv2_msg_udp_ip_ethernet_vlan( ctx, msg, mac_src, NULL, 0, ip_src, hdr, time, port
+                                              , add_crc, add_preamble);
 }
 
 //-----------------------------------------------------------------------------
 static ptpv2_ctx_t ptpv2_ctx = {
-       2, // ptpv2_ctx.ptp_version   
-       0, // ptpv2_ctx.ptp_domain    
-       0, // ptpv2_ctx.one_step_clock (0=Two Step Clock, which means Follow_Up is required)
-       0, // ptpv2_ctx.unicast_port  
-       0, // ptpv2_ctx.profile_spec1 
-       0  // ptpv2_ctx.profile_spec2 
+       .ptp_version       = 2,
+       .ptp_domain        = 0,
+       .one_step_clock    = 0, // 0=Two Step Clock, which means Follow_Up is required
+       .unicast_port      = 0,
+       .profile_spec1     = 0,
+       .profile_spec2     = 0,
+       .utc_offset        = 37, // TAI-UTC since 2017
+       .gm_priority1      = 128,
+       .gm_clock_class    = 248, // default of slave-only is 255
+       .gm_clock_accuracy = 0xFE, // unknown
+       .gm_clock_variance = 0xFFFF,
+       .gm_priority2      = 128,
+       .gm_identity       = 0,
+       .steps_removed     = 0,
+       .time_source       = 0xA0, // INTERNAL_OSCILLATOR
+       .boundary_hops     = 0,
+       .action            = PTPV2_MGT_GET
+       // tlv_len and tlv are zero; no TLV
        };
 
 //-----------------------------------------------------------------------------
@@ -508,6 +750,300 @@ ptpv2_ctx_t *get_ptpv2_context( ) {
     return &ptpv2_ctx;
 }
 
+//-----------------------------------------------------------------------------
+// It sets fields of Announce, which are in host order.
+void set_ptpv2_announce( ptpv2_ctx_t *ctx
+                       , uint32_t utc_offset
+                       , uint32_t gm_priority1
+                       , uint32_t gm_clock_class
+                       , uint32_t gm_clock_accuracy
+                       , uint32_t gm_clock_variance
+                       , uint32_t gm_priority2
+                       , uint64_t gm_identity
+                       , uint32_t steps_removed
+                       , uint32_t time_source
+                       )
+{
+    ctx->utc_offset        = utc_offset       ;
+    ctx->gm_priority1      = gm_priority1     ;
+    ctx->gm_clock_class    = gm_clock_class   ;
+    ctx->gm_clock_accuracy = gm_clock_accuracy;
+    ctx->gm_clock_variance = gm_clock_variance;
+    ctx->gm_priority2      = gm_priority2     ;
+    ctx->gm_identity       = gm_identity      ;
+    ctx->steps_removed     = steps_removed    ;
+    ctx->time_source       = time_source      ;
+}
+
+//-----------------------------------------------------------------------------
+// It sets fields of Management.
+void set_ptpv2_management( ptpv2_ctx_t *ctx
+                         , uint32_t action // PTPV2_MGT_*
+                         , uint32_t boundary_hops)
+{
+    ctx->action        = action&0xF;
+    ctx->boundary_hops = boundary_hops&0xFF;
+}
+
+//-----------------------------------------------------------------------------
+// It appends a TLV to messages of 'type', where 'value' of odd length
+// is padded with zero since lengthField should be even.
+// 'value' is zero if NULL.
+// Return num of bytes of TLVs of 'type', -1 when no room.
+int add_ptpv2_tlv( ptpv2_ctx_t   *ctx
+                 , uint8_t        type
+                 , uint16_t       tlv_type
+                 , const uint8_t *value
+                 , int            leng)
+{
+    uint8_t *tlv;
+    int num = (leng+1)&~1;
+    type &= 0xF;
+    if ((leng<0)||((ctx->tlv_len[type]+PTPV2_TLV_HDR_LEN+num)>PTPV2_TLV_MAX)) return -1;
+    tlv = &ctx->tlv[type][ctx->tlv_len[type]];
+    tlv[0] = tlv_type>>8;
+    tlv[1] = tlv_type&0xFF;
+    tlv[2] = num>>8;
+    tlv[3] = num&0xFF;
+    if (value==NULL) memset((void*)&tlv[PTPV2_TLV_HDR_LEN], 0, num);
+    else {
+        memcpy((void*)&tlv[PTPV2_TLV_HDR_LEN], (const void*)value, leng);
+        if (num>leng) tlv[PTPV2_TLV_HDR_LEN+leng] = 0;
+    }
+    ctx->tlv_len[type] += PTPV2_TLV_HDR_LEN+num;
+    return ctx->tlv_len[type];
+}
+
+//-----------------------------------------------------------------------------
+// It removes TLVs of 'type'.
+void clear_ptpv2_tlv( ptpv2_ctx_t *ctx
+                    , uint8_t      type)
+{
+    ctx->tlv_len[type&0xF] = 0;
+}
+
+//-----------------------------------------------------------------------------
+// It builds a frame of the template, which goes over UDP/IP when 'udp' is 1
+// and over Ethernet otherwise.
+// return NULL on failure
+ptpv2_template_t *ptpv2_template_create( ptpv2_ctx_t *ctx
+                                       , uint8_t      mac_src[6]
+                                       , const pkt_vlan_t *vlan
+                                       , int          vlan_num
+                                       , int          udp
+                                       , uint32_t     ip_src
+                                       , ptpv2_msg_hdr_t *hdr
+                                       , Timestamp_t     *time
+                                       , PortIdentity_t  *port
+                                       , int          add_crc
+                                       , int          add_preamble)
+{
+    ptpv2_template_t *tpl;
+    int time_off;
+    if ((hdr==NULL)||(get_msg_length(hdr->messageType)==0)) return NULL;
+    tpl = (ptpv2_template_t*)calloc(1, sizeof(ptpv2_template_t));
+    if (tpl==NULL) return NULL;
+    if (udp) tpl->bnum = gen_ptpv2_msg_udp_ip_ethernet_vlan( ctx, tpl->frame, mac_src, vlan, vlan_num
+                                                           , ip_src, hdr, time, port
+                                                           , add_crc, add_preamble);
+    else     tpl->bnum = gen_ptpv2_msg_ethernet_vlan( ctx, tpl->frame, mac_src, vlan, vlan_num
+                                                    , hdr, time, port
+                                                    , add_crc, add_preamble);
+    if (tpl->bnum<=0) { free(tpl); return NULL; }
+    tpl->eth     = (add_preamble) ? 8 : 0;
+    tpl->msg     = tpl->eth+ETH_HDR_LEN+vlan_num*ETH_VLAN_TAG_LEN
+                 +((udp) ? IP_HDR_LEN+UDP_HDR_LEN : 0);
+    time_off     = get_msg_time_offset(ctx, hdr->messageType);
+    tpl->time    = (time_off) ? tpl->msg+time_off : 0;
+    tpl->add_crc = add_crc;
+    return tpl;
+}
+
+//-----------------------------------------------------------------------------
+void ptpv2_template_release(ptpv2_template_t *tpl) {
+    free(tpl);
+}
+
+//-----------------------------------------------------------------------------
+// It patches sequenceId and timestamp, and copies the frame to 'packet'.
+// Timestamp is kept if 'time' is NULL or the message has none.
+// FCS is computed again rather than by patch_eth_crc(), since a sliced
+// pass over a frame as short as PTPv2 message costs less than its
+// shift by x^(8n) and multiplications, although they are O(log n).
+// return num of bytes
+int ptpv2_template_emit( ptpv2_template_t *tpl
+                       , uint8_t          *packet
+                       , uint16_t          seq_id
+                       , Timestamp_t      *time)
+{
+    uint8_t buf[PTPV2_HDR_LEN+sizeof(Timestamp_t)];
+    int seq = tpl->msg+offsetof(ptpv2_msg_hdr_t, sequenceID);
+    int num = 2;
+    buf[0] = seq_id>>8;
+    buf[1] = seq_id&0xFF;
+    if ((time!=NULL)&&tpl->time) {
+        num = tpl->time-seq;
+        memcpy((void*)&buf[2], (void*)&tpl->frame[seq+2], num-2);
+        put_msg_time((Timestamp_t*)&buf[num], time);
+        num += sizeof(Timestamp_t);
+    }
+    memcpy((void*)&tpl->frame[seq], (void*)buf, num);
+    if (tpl->add_crc) {
+        uint32_t crc = compute_eth_crc(&tpl->frame[tpl->eth], tpl->bnum-tpl->eth-4);
+        memcpy((void*)&tpl->frame[tpl->bnum-4], (void*)&crc, 4); // LSByte first
+    }
+    memcpy((void*)packet, (void*)tpl->frame, tpl->bnum);
+    return tpl->bnum;
+}
+
+//-----------------------------------------------------------------------------
+// It gives 'time' advanced by 'ns' nano-seconds.
+static void add_msg_time(Timestamp_t *dst, Timestamp_t *time, uint64_t ns)
+{
+    uint64_t sec  = ((uint64_t)time->secondsField.msb<<32)|time->secondsField.lsb;
+    uint64_t nano = time->nanosecondsField+ns;
+    sec += nano/1000000000;
+    dst->secondsField.msb = (sec>>32)&0xFFFF;
+    dst->secondsField.lsb = (uint32_t)sec;
+    dst->nanosecondsField = (uint32_t)(nano%1000000000);
+}
+
+//-----------------------------------------------------------------------------
+// It builds template of message 'idx' of the sequence.
+// 'port' is sourcePortIdentity and 'req' is requestingPortIdentity.
+static int seq_msg_template( ptpv2_ctx_t      *ctx
+                           , ptpv2_sequence_t *seq
+                           , int               idx
+                           , uint8_t           type
+                           , uint64_t          correction // scaled nano-seconds
+                           , uint64_t          offset
+                           , uint8_t           mac_src[6]
+                           , uint32_t          ip_src
+                           , PortIdentity_t   *port
+                           , PortIdentity_t   *req
+                           , const pkt_vlan_t *vlan
+                           , int               vlan_num
+                           , int               udp
+                           , int               add_crc
+                           , int               add_preamble)
+{
+    ptpv2_msg_hdr_t hdr;
+    Timestamp_t time;
+    populate_ptpv2_msg_hdr(ctx, &hdr, type, 0, 0, 0, 0, 0, seq->seq_id, 0);
+    hdr.correctionField.high = htonl((uint32_t)(correction>>32));
+    hdr.correctionField.low  = htonl((uint32_t)correction);
+    put_msg_port(&hdr.sourcePortIdentity, port, 0x00);
+    add_msg_time(&time, &seq->time, offset);
+    seq->tpl[idx] = ptpv2_template_create( ctx, mac_src, vlan, vlan_num, udp, ip_src
+                                         , &hdr, &time, req, add_crc, add_preamble);
+    seq->offset[idx] = offset;
+    return (seq->tpl[idx]==NULL) ? -1 : 0;
+}
+
+//-----------------------------------------------------------------------------
+// It builds templates of all messages of an exchange, where timestamps
+// follow IEEE.Std 1588-2008 11.3 and 11.4, e.g., for Pdelay of two-step clock
+// t1=start, t2=t1+delay for Pdelay_Resp, t3=t2+turnaround for Pdelay_Resp_Follow_Up.
+// Pdelay_Resp of one-step clock carries turnaround in correctionField.
+// return NULL on failure
+ptpv2_sequence_t *ptpv2_sequence_create( ptpv2_ctx_t *ctx
+                                       , int          kind
+                                       , uint8_t      mac_src[6]
+                                       , uint32_t     ip_src
+                                       , PortIdentity_t *port_src
+                                       , uint8_t      mac_peer[6]
+                                       , uint32_t     ip_peer
+                                       , PortIdentity_t *port_peer
+                                       , const pkt_vlan_t *vlan
+                                       , int          vlan_num
+                                       , int          udp
+                                       , uint16_t     seq_id
+                                       , Timestamp_t *start
+                                       , uint64_t     interval
+                                       , uint32_t     delay
+                                       , uint32_t     turnaround
+                                       , int          add_crc
+                                       , int          add_preamble)
+{
+    ptpv2_sequence_t *seq;
+    int ret=0;
+    if ((ctx==NULL)||(start==NULL)) return NULL;
+    seq = (ptpv2_sequence_t*)calloc(1, sizeof(ptpv2_sequence_t));
+    if (seq==NULL) return NULL;
+    seq->seq_id   = seq_id;
+    seq->time     = *start;
+    seq->interval = interval;
+    switch (kind) {
+    case PTPV2_SEQ_SYNC:
+         ret |= seq_msg_template(ctx, seq, 0, PTPV2_MSG_Sync, 0, 0
+                                , mac_src, ip_src, port_src, NULL
+                                , vlan, vlan_num, udp, add_crc, add_preamble);
+         if (!ctx->one_step_clock)
+         ret |= seq_msg_template(ctx, seq, 1, PTPV2_MSG_Follow_Up, 0, 0
+                                , mac_src, ip_src, port_src, NULL
+                                , vlan, vlan_num, udp, add_crc, add_preamble);
+         seq->num_msg = (ctx->one_step_clock) ? 1 : 2;
+         break;
+    case PTPV2_SEQ_DELAY:
+         ret |= seq_msg_template(ctx, seq, 0, PTPV2_MSG_Delay_Req, 0, 0
+                                , mac_src, ip_src, port_src, NULL
+                                , vlan, vlan_num, udp, add_crc, add_preamble);
+         ret |= seq_msg_template(ctx, seq, 1, PTPV2_MSG_Delay_Resp, 0, delay
+                                , mac_peer, ip_peer, port_peer, port_src
+                                , vlan, vlan_num, udp, add_crc, add_preamble);
+         seq->num_msg = 2;
+         break;
+    case PTPV2_SEQ_PDELAY:
+         ret |= seq_msg_template(ctx, seq, 0, PTPV2_MSG_Pdelay_Req, 0, 0
+                                , mac_src, ip_src, port_src, NULL
+                                , vlan, vlan_num, udp, add_crc, add_preamble);
+         ret |= seq_msg_template(ctx, seq, 1, PTPV2_MSG_Pdelay_Resp
+                                , (ctx->one_step_clock) ? (uint64_t)turnaround<<16 : 0, delay
+                                , mac_peer, ip_peer, port_peer, port_src
+                                , vlan, vlan_num, udp, add_crc, add_preamble);
+         if (!ctx->one_step_clock)
+         ret |= seq_msg_template(ctx, seq, 2, PTPV2_MSG_Pdelay_Resp_Follow_Up, 0
+                                , (uint64_t)delay+turnaround
+                                , mac_peer, ip_peer, port_peer, port_src
+                                , vlan, vlan_num, udp, add_crc, add_preamble);
+         seq->num_msg = (ctx->one_step_clock) ? 2 : 3;
+         break;
+    default: ret = -1;
+    }
+    if (ret) {
+        ptpv2_sequence_release(seq);
+        return NULL;
+    }
+    return seq;
+}
+
+//-----------------------------------------------------------------------------
+void ptpv2_sequence_release(ptpv2_sequence_t *seq) {
+    int idx;
+    if (seq==NULL) return;
+    for (idx=0; idx<3; idx++) ptpv2_template_release(seq->tpl[idx]);
+    free(seq);
+}
+
+//-----------------------------------------------------------------------------
+// It emits the next message of the sequence, where sequenceId and the start
+// of exchange advance after the last message of an exchange.
+// return num of bytes
+int ptpv2_sequence_emit( ptpv2_sequence_t *seq
+                       , uint8_t          *packet)
+{
+    Timestamp_t time;
+    int leng;
+    add_msg_time(&time, &seq->time, seq->offset[seq->idx]);
+    leng = ptpv2_template_emit(seq->tpl[seq->idx], packet, seq->seq_id, &time);
+    if (++seq->idx>=seq->num_msg) {
+        seq->idx = 0;
+        seq->seq_id++;
+        add_msg_time(&seq->time, &seq->time, seq->interval);
+    }
+    return leng;
+}
+
 //-----------------------------------------------------------------------------
 int parser_ptpv2_message(uint8_t *pkt, int leng)
 {
@@ -565,6 +1101,46 @@ int parser_ptpv2_message(uint8_t *pkt, int leng)
          printf("PTPv2 clockId            0x%02X%02X%02X%02X%02X%02X%02X%02X\n",ppt[0],ppt[1],ppt[2],ppt[3],ppt[4],ppt[5],ppt[6],ppt[7]);
          printf("PTPv2 portId             0x%02X%02X\n",ppt[8],ppt[9]);
          break;
+    case PTPV2_MSG_Announce             ://  0xB
+         // haeder(34)+timeStamp(10)+grandmaster(20)
+         printf("PTPv2 second             0x%02X%02X%02X%02X%02X%02X\n",tpt[0],tpt[1],tpt[2],tpt[3],tpt[4],tpt[5]);
+         printf("PTPv2 nanosecond         0x%02X%02X%02X%02X\n",tpt[6],tpt[7],tpt[8],tpt[9]);
+         printf("PTPv2 currentUtcOffset   0x%02X%02X\n",tpt[10],tpt[11]);
+         printf("PTPv2 gmPriority1        0x%02X\n",tpt[13]);
+         printf("PTPv2 gmClockClass       0x%02X\n",tpt[14]);
+         printf("PTPv2 gmClockAccuracy    0x%02X\n",tpt[15]);
+         printf("PTPv2 gmClockVariance    0x%02X%02X\n",tpt[16],tpt[17]);
+         printf("PTPv2 gmPriority2        0x%02X\n",tpt[18]);
+         printf("PTPv2 gmIdentity         0x%02X%02X%02X%02X%02X%02X%02X%02X\n",tpt[19],tpt[20],tpt[21],tpt[22],tpt[23],tpt[24],tpt[25],tpt[26]);
+         printf("PTPv2 stepsRemoved       0x%02X%02X\n",tpt[27],tpt[28]);
+         printf("PTPv2 timeSource         0x%02X\n",tpt[29]);
+         break;
+    case PTPV2_MSG_Signaling            ://  0xC
+    case PTPV2_MSG_Management           ://  0xD
+         // haeder(34)+TargetPort(10)
+         printf("PTPv2 targetClockId      0x%02X%02X%02X%02X%02X%02X%02X%02X\n",tpt[0],tpt[1],tpt[2],tpt[3],tpt[4],tpt[5],tpt[6],tpt[7]);
+         printf("PTPv2 targetPortId       0x%02X%02X\n",tpt[8],tpt[9]);
+         if (hdr->messageType==PTPV2_MSG_Signaling) break;
+         printf("PTPv2 startBoundaryHops  0x%02X\n",tpt[10]);
+         printf("PTPv2 boundaryHops       0x%02X\n",tpt[11]);
+         printf("PTPv2 actionField        0x%01X\n",tpt[12]&0xF);
+         break;
+    default: return 0;
+    }
+
+    // TLVs after the fixed part up to messageLength
+    int off = get_msg_length(hdr->messageType);
+    int end = ntohs(hdr->messageLength);
+    if (end>leng) end = leng;
+    while ((off+PTPV2_TLV_HDR_LEN)<=end) {
+         int tlv_type = (pkt[off  ]<<8)|pkt[off+1];
+         int tlv_len  = (pkt[off+2]<<8)|pkt[off+3];
+         printf("PTPv2 tlvType            0x%04X\n", tlv_type);
+         printf("PTPv2 tlvLength          0x%04X\n", tlv_len);
+         if ((tlv_type==PTPV2_TLV_MANAGEMENT)&&(tlv_len>=2)) {
+             printf("PTPv2 managementId       0x%02X%02X\n",pkt[off+4],pkt[off+5]);
+         }
+         off += PTPV2_TLV_HDR_LEN+tlv_len;
     }
 
     return 0;
@@ -34,6 +34,14 @@ extern int populate_ptpv2_msg_hdr( ptpv2_ctx_t     *ctx
                                  , uint16_t         seq_id
                                  , uint8_t          control);
 
+extern int fill_ptpv2_msg_hdr( ptpv2_msg_hdr_t *msg_hdr
+                             , uint8_t          type
+                             , uint16_t         flag
+                             , uint64_t         correction // 8-byte
+                             , uint64_t         clock_id // 8-byte
+                             , uint16_t         port_id
+                             , uint16_t         seq_id);
+
 extern int gen_ptpv2_msg_sync( ptpv2_ctx_t *ctx
                              , uint8_t     *msg
                              , ptpv2_msg_hdr_t *hdr
@@ -94,6 +102,12 @@ extern int gen_ptpv2_msg_management( ptpv2_ctx_t *ctx
                                    , Timestamp_t     *time
                                    , PortIdentity_t  *port);
 
+// Room for PTPv2 frame, which is within a standard Ethernet frame
+// with VLAN tags if any.
+#define PTPV2_FRAME_MAX  (8+ETH_HDR_LEN+PKT_VLAN_MAX*ETH_VLAN_TAG_LEN+1500+4)
+
+// 'msg' of the followings must have room for PTPV2_FRAME_MAX bytes,
+// since headers are prepended to PTPv2 message built in place.
 extern int gen_ptpv2_msg_ethernet( ptpv2_ctx_t *ctx
                                  , uint8_t     *msg  // PTPv2 over Ethernet message to be buit
                                  , uint8_t      mac_src[6]
@@ -113,6 +127,28 @@ extern int gen_ptpv2_msg_udp_ip_ethernet( ptpv2_ctx_t *ctx
                                         , int          add_crc // add CRC at the end
                                         , int          add_preamble // add preamble at the beginning
                                         );
+// Same as above with VLAN tags; see 'pkt_vlan_t'.
+extern int gen_ptpv2_msg_ethernet_vlan( ptpv2_ctx_t *ctx
+                                      , uint8_t     *msg
+                                      , uint8_t      mac_src[6]
+                                      , const pkt_vlan_t *vlan // tags, outer first
+                                      , int          vlan_num // num of tags
+                                      , ptpv2_msg_hdr_t *hdr
+                                      , Timestamp_t     *time
+                                      , PortIdentity_t  *port
+                                      , int          add_crc
+                                      , int          add_preamble);
+extern int gen_ptpv2_msg_udp_ip_ethernet_vlan( ptpv2_ctx_t *ctx
+                                             , uint8_t     *msg
+                                             , uint8_t      mac_src[6]
+                                             , const pkt_vlan_t *vlan // tags, outer first
+                                             , int          vlan_num // num of tags
+                                             , uint32_t     ip_src
+                                             , ptpv2_msg_hdr_t *hdr
+                                             , Timestamp_t     *time
+                                             , PortIdentity_t  *port
+                                             , int          add_crc
+                                             , int          add_preamble);
 ptpv2_ctx_t *gen_ptpv2_context( uint32_t ptp_version   
                               , uint32_t ptp_domain    
                               , uint32_t one_step_clock
@@ -123,6 +159,101 @@ ptpv2_ctx_t *gen_ptpv2_context( uint32_t ptp_version
 
 ptpv2_ctx_t *get_ptpv2_context( );
 
+// Fields of Announce and Management in host order.
+extern void set_ptpv2_announce( ptpv2_ctx_t *ctx
+                              , uint32_t utc_offset // currentUtcOffset
+                              , uint32_t gm_priority1
+                              , uint32_t gm_clock_class
+                              , uint32_t gm_clock_accuracy
+                              , uint32_t gm_clock_variance // offsetScaledLogVariance
+                              , uint32_t gm_priority2
+                              , uint64_t gm_identity
+                              , uint32_t steps_removed
+                              , uint32_t time_source);
+extern void set_ptpv2_management( ptpv2_ctx_t *ctx
+                                , uint32_t action // PTPV2_MGT_*
+                                , uint32_t boundary_hops);
+
+// TLVs appended to messages of a type, e.g., Management TLV,
+// REQUEST_UNICAST_TRANSMISSION of Signaling and PATH_TRACE of Announce.
+extern int  add_ptpv2_tlv( ptpv2_ctx_t   *ctx
+                         , uint8_t        type // messageType
+                         , uint16_t       tlv_type // PTPV2_TLV_*
+                         , const uint8_t *value // zero if NULL
+                         , int            leng); // returns num of bytes of TLVs of 'type', -1 if no room
+extern void clear_ptpv2_tlv( ptpv2_ctx_t *ctx
+                           , uint8_t      type);
+
+//----------------------------------------------------------------------------
+// PTPv2 template: a frame of a message type is built once and repeated
+// messages are emitted by patching sequenceId and timestamp,
+// where only FCS is computed again since UDP checksum stays zero.
+typedef struct ptpv2_template {
+    uint8_t  frame[PTPV2_FRAME_MAX]; // whole frame including preamble and FCS if any
+    int      bnum;    // num of bytes of 'frame'
+    int      eth;     // offset of Ethernet header; 8 when preamble
+    int      msg;     // offset of PTPv2 message
+    int      time;    // offset of timestamp; 0 if none or zero
+    int      add_crc; // FCS is kept when 1
+} ptpv2_template_t;
+
+extern ptpv2_template_t *ptpv2_template_create( ptpv2_ctx_t *ctx
+                                              , uint8_t      mac_src[6]
+                                              , const pkt_vlan_t *vlan // tags, outer first
+                                              , int          vlan_num // num of tags
+                                              , int          udp // 1 for UDP/IP, 0 for Ethernet
+                                              , uint32_t     ip_src // only valid when 'udp'
+                                              , ptpv2_msg_hdr_t *hdr
+                                              , Timestamp_t     *time
+                                              , PortIdentity_t  *port
+                                              , int          add_crc
+                                              , int          add_preamble); // NULL on failure
+extern void ptpv2_template_release( ptpv2_template_t *tpl );
+extern int  ptpv2_template_emit( ptpv2_template_t *tpl
+                               , uint8_t          *packet
+                               , uint16_t          seq_id
+                               , Timestamp_t      *time); // kept if NULL; returns num of bytes
+
+//----------------------------------------------------------------------------
+// PTPv2 sequence: whole exchanges of messages are emitted from templates
+// in order of transmission, where exchange 'n' starts at 'start+n*interval'
+// and all messages of an exchange carry the same sequenceId.
+#define PTPV2_SEQ_SYNC    0 // Sync, and Follow_Up for two-step clock
+#define PTPV2_SEQ_DELAY   1 // Delay_Req and Delay_Resp
+#define PTPV2_SEQ_PDELAY  2 // Pdelay_Req, Pdelay_Resp, and Pdelay_Resp_Follow_Up for two-step clock
+
+typedef struct ptpv2_sequence {
+    ptpv2_template_t *tpl[3]; // messages of an exchange
+    uint64_t    offset[3]; // nano-seconds of each message from the start of exchange
+    int         num_msg;   // num of messages of an exchange
+    int         idx;       // message to be emitted next
+    uint16_t    seq_id;    // sequenceId of the current exchange
+    Timestamp_t time;      // start of the current exchange
+    uint64_t    interval;  // nano-seconds between exchanges
+} ptpv2_sequence_t;
+
+extern ptpv2_sequence_t *ptpv2_sequence_create( ptpv2_ctx_t *ctx
+                                              , int          kind // PTPV2_SEQ_*
+                                              , uint8_t      mac_src[6] // master of Sync, requester of others
+                                              , uint32_t     ip_src
+                                              , PortIdentity_t *port_src // network order
+                                              , uint8_t      mac_peer[6] // responder; not used by Sync
+                                              , uint32_t     ip_peer
+                                              , PortIdentity_t *port_peer
+                                              , const pkt_vlan_t *vlan // tags, outer first
+                                              , int          vlan_num // num of tags
+                                              , int          udp // 1 for UDP/IP, 0 for Ethernet
+                                              , uint16_t     seq_id // sequenceId of the first exchange
+                                              , Timestamp_t *start
+                                              , uint64_t     interval // nano-seconds between exchanges
+                                              , uint32_t     delay // nano-seconds from request to its receipt
+                                              , uint32_t     turnaround // nano-seconds from receipt of Pdelay_Req to Pdelay_Resp
+                                              , int          add_crc
+                                              , int          add_preamble); // NULL on failure
+extern void ptpv2_sequence_release( ptpv2_sequence_t *seq );
+extern int  ptpv2_sequence_emit( ptpv2_sequence_t *seq
+                               , uint8_t          *packet); // returns num of bytes of the next message
+
 extern int parser_ptpv2_message(uint8_t *pkt, int leng);
 
 #ifdef __cplusplus
@@ -237,6 +237,29 @@ typedef struct FaultRecord { UInteger16   faultRecordLength;
 #define PTPV2_MSG_CTRL_Management  0x04
 #define PTPV2_MSG_CTRL_All_others  0x05
 
+//----------------------------------------------------------------------------
+// TLV types.
+// see IEEE.Std 1588-2008 14.1.1
+#define PTPV2_TLV_HDR_LEN  4 // tlvType and lengthField
+#define PTPV2_TLV_MANAGEMENT                              0x0001
+#define PTPV2_TLV_MANAGEMENT_ERROR_STATUS                 0x0002
+#define PTPV2_TLV_ORGANIZATION_EXTENSION                  0x0003
+#define PTPV2_TLV_REQUEST_UNICAST_TRANSMISSION            0x0004
+#define PTPV2_TLV_GRANT_UNICAST_TRANSMISSION              0x0005
+#define PTPV2_TLV_CANCEL_UNICAST_TRANSMISSION             0x0006
+#define PTPV2_TLV_ACKNOWLEDGE_CANCEL_UNICAST_TRANSMISSION 0x0007
+#define PTPV2_TLV_PATH_TRACE                              0x0008
+#define PTPV2_TLV_ALTERNATE_TIME_OFFSET_INDICATOR         0x0009
+
+//----------------------------------------------------------------------------
+// Management message actionField values.
+// see IEEE.Std 1588-2008 15.4.1.6
+#define PTPV2_MGT_GET          0x0
+#define PTPV2_MGT_SET          0x1
+#define PTPV2_MGT_RESPONSE     0x2
+#define PTPV2_MGT_COMMAND      0x3
+#define PTPV2_MGT_ACKNOWLEDGE  0x4
+
 //----------------------------------------------------------------------------
 // Default value for logMessageInterval 
 // (for Delay_Req, Signaling, Management, Pdelay_Req, 
@@ -444,8 +467,8 @@ typedef struct ptpv2_msg_management {
     PortIdentity_t  targetPortIdentity;
     uint8_t         startingBoundaryHops;
     uint8_t         BoundaryHops;
-    uint8_t         rese:4;
-    uint8_t         actionField:4;
+    uint8_t         actionField:4; // lower 4-bit
+    uint8_t         rese:4; // higher 4-bit
     uint8_t         reserve;
     managementTLV_t managementTLV;
 } ptpv2_msg_management_t;
@@ -456,8 +479,8 @@ typedef struct ptpv2_msg_management {
     PortIdentity_t  targetPortIdentity;
     uint8_t         startingBoundaryHops;
     uint8_t         BoundaryHops;
-    uint8_t         rese:4;
-    uint8_t         actionField:4;
+    uint8_t         actionField:4; // lower 4-bit
+    uint8_t         rese:4; // higher 4-bit
     uint8_t         reserve;
     managementTLV_t managementTLV;
 } __attribute__ ((packed)) ptpv2_msg_management_t;
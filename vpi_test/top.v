@@ -12,11 +12,35 @@ module top;
         $dumpvars(0);
         if (1) test_ethernet;
         if (1) test_udp_ip_ethernet;
+        if (1) test_burst;
+        if (1) test_template;
+        if (1) test_jumbo;
+        if (1) test_segment;
+        if (1) test_fragment;
+        if (1) test_stream;
+        if (1) test_vlan;
+        if (1) test_ipv6;
+        if (1) test_arp;
+        if (1) test_icmp;
+        if (1) test_ptpv2;
+        if ($test$plusargs("bench")) test_bench;
         #10; $finish(2);
     end
     //------------------------------------------------------------------------
     `include "top_tasks_ethernet.v"
     `include "top_tasks_udp_ip_ethernet.v"
+    `include "top_tasks_burst.v"
+    `include "top_tasks_template.v"
+    `include "top_tasks_jumbo.v"
+    `include "top_tasks_segment.v"
+    `include "top_tasks_fragment.v"
+    `include "top_tasks_stream.v"
+    `include "top_tasks_vlan.v"
+    `include "top_tasks_ipv6.v"
+    `include "top_tasks_arp.v"
+    `include "top_tasks_icmp.v"
+    `include "top_tasks_ptpv2.v"
+    `include "top_tasks_bench.v"
 endmodule
 //----------------------------------------------------------------------------
 // Revision history:
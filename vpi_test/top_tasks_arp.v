@@ -0,0 +1,67 @@
+`ifndef TOP_TASKS_ARP_V
+`define TOP_TASKS_ARP_V
+//----------------------------------------------------------------------------
+// It hands a request of DUT to the ARP responder, which answers it
+// for a local host and learns DUT.
+task test_arp;
+    reg [  7:0] pkt_eth[0:1535];
+    reg [ 15:0] bnum_pkt;
+    reg [ 47:0] mac_dut;
+    reg [ 47:0] mac_host;
+    reg [ 47:0] mac;
+    reg [ 31:0] ip_dut;
+    reg [ 31:0] ip_host;
+    integer     num_reply;
+    integer     found;
+    integer     add_crc;
+    integer     add_preamble;
+begin
+        mac_dut =48'h02_11_22_33_44_55;
+        mac_host=48'h02_12_34_56_78_9A;
+        ip_dut  ={8'd192,8'd168,8'd1,8'd1};
+        ip_host ={8'd192,8'd168,8'd1,8'd100};
+        add_crc=1;
+        add_preamble=1;
+//--------------------
+        $pkt_arp_host(ip_host, mac_host);
+        $pkt_arp( pkt_eth
+                , bnum_pkt
+                , 1 // request
+                , ip_dut
+                , ip_host
+                , mac_dut
+                , 48'hFF_FF_FF_FF_FF_FF
+                , add_crc
+                , add_preamble
+                );
+        $pkt_arp_monitor( pkt_eth
+                        , bnum_pkt
+                        , add_preamble
+                        , num_reply
+                        );
+        $pkt_arp_reply( pkt_eth
+                      , bnum_pkt
+                      , add_crc
+                      , add_preamble
+                      );
+        $display("%m reply bnum_pkt=%0d %s", bnum_pkt,
+                 ((num_reply==1)&&(bnum_pkt==(8+64))&&(pkt_eth[8+12]==8'h08)&&(pkt_eth[8+13]==8'h06)&&
+                  (pkt_eth[8+21]==8'h02)&&(pkt_eth[8+6]==8'h02)&&(pkt_eth[8+11]==8'h9A)) ? "OK" : "ERROR");
+        $pkt_ethernet_parser( pkt_eth
+                            , bnum_pkt
+                            , add_crc
+                            , add_preamble
+                            );
+        $pkt_arp_lookup(ip_dut, mac, found);
+        $display("%m lookup %s", ((found==1)&&(mac==mac_dut)) ? "OK" : "ERROR");
+//--------------------
+        $pkt_arp_reply( pkt_eth // queue is empty
+                      , bnum_pkt
+                      , add_crc
+                      , add_preamble
+                      );
+        $display("%m no reply %s", (bnum_pkt==0) ? "OK" : "ERROR");
+        #10;
+    end
+endtask
+`endif
@@ -0,0 +1,126 @@
+`ifndef TOP_TASKS_BENCH_V
+`define TOP_TASKS_BENCH_V
+//----------------------------------------------------------------------------
+// It builds 1500-byte UDP/IP/Ethernet frames repeatedly and reports
+// how many frames are built per second in terms of host wall-clock.
+// Run with '+bench' and optionally '+bench_num=<num-of-frames>'.
+// It is done for both array and packed vector of bytes,
+// and for bursts of 16 frames built by '$pkt_udp_ip_ethernet_burst'.
+task test_bench;
+    reg [ 7:0] pkt_eth[0:4095];
+    reg [8*4096-1:0] pkt_vec;
+    reg [8*4096-1:0] payload_vec;
+    reg [ 7:0] pkt_burst[0:15][0:2047];
+    reg [15:0] bnum_burst[0:15];
+    reg [15:0] bnum_pkt;
+    reg [47:0] mac_src;
+    reg [47:0] mac_dst;
+    reg [31:0] ip_src  ;
+    reg [31:0] ip_dst  ;
+    reg [ 7:0] ttl     ;
+    reg [15:0] port_src;
+    reg [15:0] port_dst;
+    reg [15:0] bnum_payload;
+    reg [ 7:0] payload[0:4095];
+    reg [31:0] add_crc;
+    integer    add_preamble;
+    integer    idx, num;
+    reg [63:0] start, stop;
+    reg [31:0] handles;
+begin
+        if (!$value$plusargs("bench_num=%d", num)) num = 10000;
+        mac_src=48'h02_12_34_56_78_9A;
+        mac_dst=48'h02_11_22_33_44_55;
+        ip_src  =32'hC0ABCDEF;
+        ip_dst  =32'hC1234567;
+        ttl     =1;
+        port_src=16'h2112;
+        port_dst=16'h1221;
+        bnum_payload=1500-14-20-8; // 1500-byte frame without FCS
+        for (idx=0; idx<4096; idx=idx+1) payload[idx] = idx+1;
+        for (idx=0; idx<4096; idx=idx+1) payload_vec[8*idx+:8] = idx+1;
+        add_crc=0;
+        add_preamble=0;
+        handles = $pkt_vpi_handles;
+        start = $pkt_wallclock;
+        for (idx=0; idx<num; idx=idx+1) begin
+            $pkt_udp_ip_ethernet( pkt_eth
+                                , bnum_pkt
+                                , port_src
+                                , port_dst
+                                , ip_src
+                                , ip_dst
+                                , ttl
+                                , mac_src
+                                , mac_dst
+                                , bnum_payload
+                                , payload
+                                , add_crc
+                                , add_preamble
+                                );
+        end
+        stop = $pkt_wallclock;
+        handles = $pkt_vpi_handles - handles;
+        if (stop==start) stop = start + 1;
+        $display("%m %0d frames of %0d bytes in %0d usec: %0d frames/sec",
+                  num, bnum_pkt, stop-start, (num*64'd1000000)/(stop-start));
+        $display("%m %0d VPI handles obtained during %0d frames", handles, num);
+        //--------------------------------------------------------------------
+        handles = $pkt_vpi_handles;
+        start = $pkt_wallclock;
+        for (idx=0; idx<num; idx=idx+1) begin
+            $pkt_udp_ip_ethernet( pkt_vec
+                                , bnum_pkt
+                                , port_src
+                                , port_dst
+                                , ip_src
+                                , ip_dst
+                                , ttl
+                                , mac_src
+                                , mac_dst
+                                , bnum_payload
+                                , payload_vec
+                                , add_crc
+                                , add_preamble
+                                );
+        end
+        stop = $pkt_wallclock;
+        handles = $pkt_vpi_handles - handles;
+        if (stop==start) stop = start + 1;
+        $display("%m packed vector %0d frames of %0d bytes in %0d usec: %0d frames/sec",
+                  num, bnum_pkt, stop-start, (num*64'd1000000)/(stop-start));
+        $display("%m packed vector %0d VPI handles obtained during %0d frames", handles, num);
+        //--------------------------------------------------------------------
+        handles = $pkt_vpi_handles;
+        start = $pkt_wallclock;
+        for (idx=0; idx<num; idx=idx+16) begin
+            $pkt_udp_ip_ethernet_burst( pkt_burst
+                                      , bnum_burst
+                                      , ((num-idx)<16) ? (num-idx) : 16
+                                      , port_src
+                                      , port_dst
+                                      , ip_src
+                                      , ip_dst
+                                      , ttl
+                                      , mac_src
+                                      , mac_dst
+                                      , bnum_payload
+                                      , payload
+                                      , add_crc
+                                      , add_preamble
+                                      , 1 // inc_port_src
+                                      , 0
+                                      , 0
+                                      , 0
+                                      , 0
+                                      );
+        end
+        stop = $pkt_wallclock;
+        handles = $pkt_vpi_handles - handles;
+        if (stop==start) stop = start + 1;
+        $display("%m burst %0d frames of %0d bytes in %0d usec: %0d frames/sec",
+                  num, bnum_burst[0], stop-start, (num*64'd1000000)/(stop-start));
+        $display("%m burst %0d VPI handles obtained during %0d frames", handles, num);
+    end
+endtask
+`endif
@@ -0,0 +1,68 @@
+`ifndef TOP_TASKS_BURST_V
+`define TOP_TASKS_BURST_V
+//----------------------------------------------------------------------------
+// It builds a burst of UDP/IP/Ethernet frames into 2-D memory in a single call,
+// where source port and payload length grow frame by frame.
+task test_burst;
+    reg [ 7:0] pkt_eth[0:3][0:2047];
+    reg [15:0] bnum_pkt[0:3];
+    reg [ 7:0] frame[0:2047];
+    reg [47:0] mac_src;
+    reg [47:0] mac_dst;
+    reg [31:0] ip_src  ;
+    reg [31:0] ip_dst  ;
+    reg [ 7:0] ttl     ;
+    reg [15:0] port_src;
+    reg [15:0] port_dst;
+    reg [15:0] bnum_payload;
+    reg [ 7:0] payload[0:2047];
+    reg [31:0] add_crc;
+    integer    add_preamble;
+    integer idx, fdx;
+begin
+        mac_src=48'h02_12_34_56_78_9A;
+        mac_dst=48'h02_11_22_33_44_55;
+        ip_src  =32'hC0ABCDEF;
+        ip_dst  =32'hC1234567;
+        ttl     =1;
+        port_src=16'h2112;
+        port_dst=16'h1221;
+        bnum_payload=10;
+        for (idx=0; idx<2048; idx=idx+1) payload[idx] = idx+1;
+        add_crc=1;
+        add_preamble=0;
+//--------------------
+        $pkt_udp_ip_ethernet_burst( pkt_eth
+                                  , bnum_pkt
+                                  , 4 // num_frame
+                                  , port_src
+                                  , port_dst
+                                  , ip_src
+                                  , ip_dst
+                                  , ttl
+                                  , mac_src
+                                  , mac_dst
+                                  , bnum_payload
+                                  , payload
+                                  , add_crc
+                                  , add_preamble
+                                  , 1   // inc_port_src
+                                  , 0   // inc_port_dst
+                                  , 0   // inc_ip_src
+                                  , 0   // inc_ip_dst
+                                  , 100 // inc_bnum_payload
+                                  );
+        for (fdx=0; fdx<4; fdx=fdx+1) begin
+            $display("%m frame %0d bnum_pkt=%0d %s", fdx, bnum_pkt[fdx],
+                     (bnum_pkt[fdx]==(14+20+8+10+100*fdx+4)) ? "OK" : "ERROR");
+            for (idx=0; idx<bnum_pkt[fdx]; idx=idx+1) frame[idx] = pkt_eth[fdx][idx];
+            $pkt_ethernet_parser( frame
+                                , bnum_pkt[fdx]
+                                , add_crc
+                                , add_preamble
+                                );
+        end
+        #10;
+    end
+endtask
+`endif
@@ -0,0 +1,63 @@
+`ifndef TOP_TASKS_FRAGMENT_V
+`define TOP_TASKS_FRAGMENT_V
+//----------------------------------------------------------------------------
+// It cuts 3000-byte UDP datagram into fragments of 1500-byte MTU
+// in a single call, where IP ID is the next one of the flow.
+// The parser reassembles fragments and parses the datagram at the last one.
+task test_fragment;
+    reg [ 7:0] pkt_eth[0:3][0:1535];
+    reg [15:0] bnum_pkt[0:3];
+    reg [ 7:0] frame[0:1535];
+    integer    num_frag;
+    reg [47:0] mac_src;
+    reg [47:0] mac_dst;
+    reg [31:0] ip_src  ;
+    reg [31:0] ip_dst  ;
+    integer    bnum_payload;
+    reg [ 7:0] payload[0:2999];
+    integer    add_crc;
+    integer    add_preamble;
+    integer idx, fdx, len;
+begin
+        mac_src=48'h02_12_34_56_78_9A;
+        mac_dst=48'h02_11_22_33_44_55;
+        ip_src  =32'hC0ABCDEF;
+        ip_dst  =32'hC1234567;
+        bnum_payload=3000;
+        for (idx=0; idx<3000; idx=idx+1) payload[idx] = idx;
+        add_crc=1;
+        add_preamble=0;
+        $pkt_ip_reassembly(16, 1024*1024, 1000000);
+//--------------------
+        $pkt_ip_fragment( pkt_eth
+                        , bnum_pkt
+                        , num_frag
+                        , ip_src
+                        , ip_dst
+                        , 8'h11 // UDP
+                        , 8'h40 // TTL
+                        , -1    // next IP ID of the flow
+                        , mac_src
+                        , mac_dst
+                        , 1500  // MTU
+                        , bnum_payload
+                        , payload
+                        , add_crc
+                        , add_preamble
+                        );
+        $display("%m num_frag=%0d %s", num_frag, (num_frag==3) ? "OK" : "ERROR");
+        for (fdx=0; fdx<num_frag; fdx=fdx+1) begin
+            len = (fdx<2) ? 1480 : 3000-2*1480;
+            $display("%m fragment %0d bnum_pkt=%0d %s", fdx, bnum_pkt[fdx],
+                     (bnum_pkt[fdx]==(14+20+len+4)) ? "OK" : "ERROR");
+            for (idx=0; idx<bnum_pkt[fdx]; idx=idx+1) frame[idx] = pkt_eth[fdx][idx];
+            $pkt_ethernet_parser( frame
+                                , bnum_pkt[fdx]
+                                , add_crc
+                                , add_preamble
+                                );
+        end
+        #10;
+    end
+endtask
+`endif
@@ -0,0 +1,113 @@
+`ifndef TOP_TASKS_ICMP_V
+`define TOP_TASKS_ICMP_V
+//----------------------------------------------------------------------------
+// It builds ICMP and ICMPv6 echo requests and turns them into replies.
+task test_icmp;
+    reg [  7:0] pkt_eth[0:1535];
+    reg [ 15:0] bnum_pkt;
+    reg [  7:0] pkt_reply[0:1535];
+    reg [ 15:0] bnum_reply;
+    reg [ 47:0] mac_src;
+    reg [ 47:0] mac_dst;
+    reg [ 31:0] ip_src  ;
+    reg [ 31:0] ip_dst  ;
+    reg [127:0] ip6_src ;
+    reg [127:0] ip6_dst ;
+    integer     bnum_payload;
+    reg [  7:0] payload[0:1499];
+    integer     add_crc;
+    integer     add_preamble;
+    integer idx;
+begin
+        mac_src=48'h02_12_34_56_78_9A;
+        mac_dst=48'h02_11_22_33_44_55;
+        ip_src ={8'd192,8'd168,8'd1,8'd100};
+        ip_dst ={8'd192,8'd168,8'd1,8'd1};
+        ip6_src=128'h2001_0DB8_0000_0001_0211_22FF_FE33_4455;
+        ip6_dst=128'hFE80_0000_0000_0000_F1AA_BBFF_FECC_DDEE;
+        bnum_payload=56;
+        for (idx=0; idx<1500; idx=idx+1) payload[idx] = idx;
+        add_crc=1;
+        add_preamble=0;
+//--------------------
+        $pkt_icmp_ip_ethernet( pkt_eth
+                             , bnum_pkt
+                             , 8 // echo request
+                             , 16'h1234 // id
+                             , 16'h0001 // seq
+                             , ip_src
+                             , ip_dst
+                             , 64 // ttl
+                             , mac_src
+                             , mac_dst
+                             , bnum_payload
+                             , payload
+                             , add_crc
+                             , add_preamble
+                             );
+        $pkt_ethernet_parser( pkt_eth
+                            , bnum_pkt
+                            , add_crc
+                            , add_preamble
+                            );
+        $pkt_icmp_echo_reply( pkt_eth
+                            , bnum_pkt
+                            , add_preamble
+                            , pkt_reply
+                            , bnum_reply
+                            , add_crc
+                            , add_preamble
+                            );
+        $display("%m ICMP reply bnum_reply=%0d %s", bnum_reply,
+                 ((bnum_reply==bnum_pkt)&&(pkt_reply[34]==8'h00)&&(pkt_reply[5]==8'h9A)&&
+                  (pkt_reply[33]==8'd100)) ? "OK" : "ERROR");
+        $pkt_ethernet_parser( pkt_reply
+                            , bnum_reply
+                            , add_crc
+                            , add_preamble
+                            );
+//--------------------
+        $pkt_icmp_ipv6_ethernet( pkt_eth
+                               , bnum_pkt
+                               , 128 // echo request
+                               , 16'h1234 // id
+                               , 16'h0002 // seq
+                               , ip6_src
+                               , ip6_dst
+                               , 255 // hop limit
+                               , mac_src
+                               , mac_dst
+                               , bnum_payload
+                               , payload
+                               , add_crc
+                               , add_preamble
+                               );
+        $pkt_icmp_echo_reply( pkt_eth
+                            , bnum_pkt
+                            , add_preamble
+                            , pkt_reply
+                            , bnum_reply
+                            , add_crc
+                            , add_preamble
+                            );
+        $display("%m ICMPv6 reply bnum_reply=%0d %s", bnum_reply,
+                 ((bnum_reply==bnum_pkt)&&(pkt_reply[54]==8'd129)) ? "OK" : "ERROR");
+        $pkt_ethernet_parser( pkt_reply
+                            , bnum_reply
+                            , add_crc
+                            , add_preamble
+                            );
+//--------------------
+        $pkt_icmp_echo_reply( pkt_reply // reply is not answered
+                            , bnum_reply
+                            , add_preamble
+                            , pkt_eth
+                            , bnum_pkt
+                            , add_crc
+                            , add_preamble
+                            );
+        $display("%m no reply %s", (bnum_pkt==0) ? "OK" : "ERROR");
+        #10;
+    end
+endtask
+`endif
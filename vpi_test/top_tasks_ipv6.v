@@ -0,0 +1,83 @@
+`ifndef TOP_TASKS_IPV6_V
+`define TOP_TASKS_IPV6_V
+//----------------------------------------------------------------------------
+// It builds UDP and TCP over IPv6 frames and parses them,
+// where checksum covers IPv6 pseudo header.
+task test_ipv6;
+    reg [  7:0] pkt_eth[0:1535];
+    reg [ 15:0] bnum_pkt;
+    reg [ 47:0] mac_src;
+    reg [ 47:0] mac_dst;
+    reg [127:0] ip_src  ;
+    reg [127:0] ip_dst  ;
+    reg [ 15:0] port_src;
+    reg [ 15:0] port_dst;
+    reg [  7:0] hop_limit;
+    integer     bnum_payload;
+    reg [  7:0] payload[0:1499];
+    integer     add_crc;
+    integer     add_preamble;
+    integer idx;
+begin
+        mac_src=48'h02_12_34_56_78_9A;
+        mac_dst=48'h02_11_22_33_44_55;
+        ip_src  =128'h2001_0DB8_0000_0001_0211_22FF_FE33_4455;
+        ip_dst  =128'hFE80_0000_0000_0000_F1AA_BBFF_FECC_DDEE;
+        port_src=16'h4114;
+        port_dst=16'h1441;
+        hop_limit=8'h40;
+        bnum_payload=100;
+        for (idx=0; idx<1500; idx=idx+1) payload[idx] = idx;
+        add_crc=1;
+        add_preamble=0;
+//--------------------
+        $pkt_udp_ipv6_ethernet( pkt_eth
+                              , bnum_pkt
+                              , port_src
+                              , port_dst
+                              , ip_src
+                              , ip_dst
+                              , hop_limit
+                              , mac_src
+                              , mac_dst
+                              , bnum_payload
+                              , payload
+                              , add_crc
+                              , add_preamble
+                              );
+        $display("%m UDP bnum_pkt=%0d %s", bnum_pkt,
+                 ((bnum_pkt==(14+40+8+100+4))&&(pkt_eth[12]==8'h86)&&(pkt_eth[13]==8'hDD)&&
+                  (pkt_eth[20]==8'h11)&&(pkt_eth[22]==8'h20)) ? "OK" : "ERROR");
+        $pkt_ethernet_parser( pkt_eth
+                            , bnum_pkt
+                            , add_crc
+                            , add_preamble
+                            );
+//--------------------
+        $pkt_tcp_ipv6_ethernet( pkt_eth
+                              , bnum_pkt
+                              , port_src
+                              , port_dst
+                              , 32'h1000 // seq
+                              , 32'h2000 // ack
+                              , ip_src
+                              , ip_dst
+                              , hop_limit
+                              , mac_src
+                              , mac_dst
+                              , bnum_payload
+                              , payload
+                              , add_crc
+                              , add_preamble
+                              );
+        $display("%m TCP bnum_pkt=%0d %s", bnum_pkt,
+                 ((bnum_pkt==(14+40+20+100+4))&&(pkt_eth[20]==8'h06)) ? "OK" : "ERROR");
+        $pkt_ethernet_parser( pkt_eth
+                            , bnum_pkt
+                            , add_crc
+                            , add_preamble
+                            );
+        #10;
+    end
+endtask
+`endif
@@ -0,0 +1,79 @@
+`ifndef TOP_TASKS_JUMBO_V
+`define TOP_TASKS_JUMBO_V
+//----------------------------------------------------------------------------
+// It builds a 9600-byte jumbo frame and 65507-byte UDP datagram,
+// i.e., the largest of 64 KiB IP datagram, where 'bnum' is 'integer'
+// since the length does not fit 16 bits with preamble and CRC.
+`define JUMBO_FRAME_MAX  65562 // ETH_FRAME_MAX
+task test_jumbo;
+    reg [ 7:0] pkt_eth[0:`JUMBO_FRAME_MAX-1];
+    integer    bnum_pkt;
+    reg [47:0] mac_src;
+    reg [47:0] mac_dst;
+    reg [31:0] ip_src  ;
+    reg [31:0] ip_dst  ;
+    reg [15:0] port_src;
+    reg [15:0] port_dst;
+    reg [ 7:0] ttl     ;
+    integer    bnum_payload;
+    reg [ 7:0] payload[0:`JUMBO_FRAME_MAX-1];
+    integer    add_crc;
+    integer    add_preamble;
+    integer idx;
+begin
+        mac_src=48'h02_12_34_56_78_9A;
+        mac_dst=48'h02_11_22_33_44_55;
+        ip_src  =32'hC0ABCDEF;
+        ip_dst  =32'hC1234567;
+        port_src=16'h2112;
+        port_dst=16'h1221;
+        ttl     =8'h40;
+        for (idx=0; idx<`JUMBO_FRAME_MAX; idx=idx+1) payload[idx] = idx;
+        add_crc=1;
+        add_preamble=1;
+//--------------------jumbo frame
+        bnum_payload=9600;
+        $pkt_ethernet( pkt_eth
+                     , bnum_pkt
+                     , mac_src
+                     , mac_dst
+                     , 16'h88B5 // local experimental
+                     , bnum_payload
+                     , payload
+                     , add_crc
+                     , add_preamble
+                     );
+        $display("%m jumbo bnum_pkt=%0d %s", bnum_pkt,
+                 (bnum_pkt==(8+14+bnum_payload+4)) ? "OK" : "ERROR");
+        $pkt_ethernet_parser( pkt_eth
+                            , bnum_pkt
+                            , add_crc
+                            , add_preamble
+                            );
+//--------------------64 KiB IP datagram
+        bnum_payload=65507;
+        $pkt_udp_ip_ethernet( pkt_eth
+                            , bnum_pkt
+                            , port_src
+                            , port_dst
+                            , ip_src
+                            , ip_dst
+                            , ttl
+                            , mac_src
+                            , mac_dst
+                            , bnum_payload
+                            , payload
+                            , add_crc
+                            , add_preamble
+                            );
+        $display("%m 64KiB bnum_pkt=%0d %s", bnum_pkt,
+                 (bnum_pkt==`JUMBO_FRAME_MAX) ? "OK" : "ERROR");
+        $pkt_ethernet_parser( pkt_eth
+                            , bnum_pkt
+                            , add_crc
+                            , add_preamble
+                            );
+        #10;
+    end
+endtask
+`endif
@@ -0,0 +1,132 @@
+`ifndef TOP_TASKS_PTPV2_V
+`define TOP_TASKS_PTPV2_V
+//----------------------------------------------------------------------------
+// It builds Sync/Follow_Up and Pdelay exchanges of two-step clock in single
+// calls, and an Announce with a TLV.
+task test_ptpv2;
+    reg [  7:0] pkt_eth[0:7][0:1535];
+    reg [ 15:0] bnum_pkt[0:7];
+    reg [  7:0] frame[0:1535];
+    reg [ 15:0] bnum;
+    reg [  7:0] value[0:7];
+    integer     num_frame;
+    reg [ 47:0] mac_src;
+    reg [ 47:0] mac_peer;
+    reg [ 31:0] ip_src;
+    reg [ 31:0] ip_peer;
+    reg [ 63:0] clock_src;
+    reg [ 63:0] clock_peer;
+    integer     add_crc;
+    integer     add_preamble;
+    reg [ 15:0] seq_id;
+    integer idx, fdx, err;
+begin
+        mac_src   =48'h02_12_34_56_78_9A;
+        mac_peer  =48'h02_11_22_33_44_55;
+        ip_src    ={8'd192,8'd168,8'd1,8'd100};
+        ip_peer   ={8'd192,8'd168,8'd1,8'd1};
+        clock_src =64'h0212_34FF_FE56_789A;
+        clock_peer=64'h0211_22FF_FE33_4455;
+        add_crc=1;
+        add_preamble=0;
+        $msg_ptpv2_set_context(2, 0, 0, 0, 0, 0); // two-step
+//--------------------
+        // exchange 1 starts at 101.000000000, where message starts at 42 over UDP/IP
+        $msg_ptpv2_sequence( pkt_eth
+                           , bnum_pkt
+                           , num_frame
+                           , 0 // Sync/Follow_Up
+                           , 4 // num of exchanges
+                           , mac_src
+                           , ip_src
+                           , clock_src
+                           , 16'h0001
+                           , mac_peer
+                           , ip_peer
+                           , clock_peer
+                           , 16'h0001
+                           , 16'hFFFE // sequenceID wraps
+                           , 48'd100
+                           , 875000000
+                           , 125000000 // interval
+                           , 0
+                           , 0
+                           , 1 // UDP/IP
+                           , add_crc
+                           , add_preamble
+                           );
+        err = (num_frame!=8);
+        for (fdx=0; fdx<8; fdx=fdx+1) begin
+            seq_id = 16'hFFFE+fdx/2;
+            if ((pkt_eth[fdx][42][3:0]!=((fdx%2) ? 4'h8 : 4'h0))||
+                ({pkt_eth[fdx][72],pkt_eth[fdx][73]}!=seq_id)) err = 1;
+        end
+        if ((pkt_eth[3][81]!=8'd101)||({pkt_eth[3][82],pkt_eth[3][83],pkt_eth[3][84],pkt_eth[3][85]}!=0)) err = 1;
+        $display("%m Sync/Follow_Up num_frame=%0d %s", num_frame, (err) ? "ERROR" : "OK");
+        for (idx=0; idx<bnum_pkt[1]; idx=idx+1) frame[idx] = pkt_eth[1][idx];
+        $pkt_ethernet_parser( frame
+                            , bnum_pkt[1]
+                            , add_crc
+                            , add_preamble
+                            );
+//--------------------
+        $msg_ptpv2_sequence( pkt_eth
+                           , bnum_pkt
+                           , num_frame
+                           , 2 // Pdelay
+                           , 2 // num of exchanges
+                           , mac_src
+                           , ip_src
+                           , clock_src
+                           , 16'h0001
+                           , mac_peer
+                           , ip_peer
+                           , clock_peer
+                           , 16'h0002
+                           , 16'h0100
+                           , 48'd100
+                           , 0
+                           , 1000000000 // interval
+                           , 1500 // delay
+                           , 700  // turnaround
+                           , 1 // UDP/IP
+                           , add_crc
+                           , add_preamble
+                           );
+        err = (num_frame!=6);
+        for (fdx=0; fdx<6; fdx=fdx+1) begin
+            if (pkt_eth[fdx][42][3:0]!=((fdx%3==0) ? 4'h2 : (fdx%3==1) ? 4'h3 : 4'hA)) err = 1;
+        end
+        // Pdelay_Resp_Follow_Up of exchange 1 at 101.000002200 from peer port 2
+        if ((pkt_eth[5][81]!=8'd101)||({pkt_eth[5][84],pkt_eth[5][85]}!=16'd2200)||
+            ({pkt_eth[5][70],pkt_eth[5][71]}!=16'h0002)||
+            ({pkt_eth[5][94],pkt_eth[5][95]}!=16'h0001)) err = 1;
+        $display("%m Pdelay num_frame=%0d %s", num_frame, (err) ? "ERROR" : "OK");
+//--------------------
+        for (idx=0; idx<8; idx=idx+1) value[idx] = idx;
+        $msg_ptpv2_set_announce(37, 128, 6, 8'h21, 16'h4E5D, 128, clock_src, 0, 8'h20);
+        $msg_ptpv2_tlv(4'hB, 16'h0008, 8, value); // PATH_TRACE
+        $msg_ptpv2_udp_ip_ethernet( frame
+                                  , bnum
+                                  , mac_src
+                                  , ip_src
+                                  , 4'hB // Announce
+                                  , 16'h0
+                                  , 64'h0
+                                  , clock_src
+                                  , 16'h0001
+                                  , 16'h0001
+                                  , 48'd100
+                                  , 0
+                                  , 64'h0
+                                  , 16'h0
+                                  , add_crc
+                                  , add_preamble
+                                  );
+        $display("%m Announce with TLV messageLength=%0d %s", {frame[44],frame[45]},
+                 ({frame[44],frame[45]}==16'd76) ? "OK" : "ERROR");
+        $msg_ptpv2_tlv(4'hB, 16'h0000, 0, value); // removes
+        #10;
+    end
+endtask
+`endif
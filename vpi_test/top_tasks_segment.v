@@ -0,0 +1,69 @@
+`ifndef TOP_TASKS_SEGMENT_V
+`define TOP_TASKS_SEGMENT_V
+//----------------------------------------------------------------------------
+// It cuts 4000-byte TCP payload into 1460-byte segments in a single call,
+// where the last one carries PSH and FIN.
+task test_segment;
+    reg [ 7:0] pkt_eth[0:3][0:1535];
+    reg [15:0] bnum_pkt[0:3];
+    reg [ 7:0] frame[0:1535];
+    integer    num_seg;
+    reg [47:0] mac_src;
+    reg [47:0] mac_dst;
+    reg [31:0] ip_src  ;
+    reg [31:0] ip_dst  ;
+    reg [15:0] port_src;
+    reg [15:0] port_dst;
+    integer    bnum_payload;
+    reg [ 7:0] payload[0:3999];
+    integer    add_crc;
+    integer    add_preamble;
+    integer idx, fdx, len;
+begin
+        mac_src=48'h02_12_34_56_78_9A;
+        mac_dst=48'h02_11_22_33_44_55;
+        ip_src  =32'hC0ABCDEF;
+        ip_dst  =32'hC1234567;
+        port_src=16'h2112;
+        port_dst=16'h1221;
+        bnum_payload=4000;
+        for (idx=0; idx<4000; idx=idx+1) payload[idx] = idx;
+        add_crc=1;
+        add_preamble=0;
+//--------------------
+        $pkt_tcp_segment( pkt_eth
+                        , bnum_pkt
+                        , num_seg
+                        , port_src
+                        , port_dst
+                        , 32'h1000 // seq_num
+                        , 32'h2000 // ack_num
+                        , ip_src
+                        , ip_dst
+                        , 16'h0100 // ip_id
+                        , mac_src
+                        , mac_dst
+                        , 1460 // mss
+                        , bnum_payload
+                        , payload
+                        , 8'h10 // ACK
+                        , 8'h09 // PSH|FIN
+                        , add_crc
+                        , add_preamble
+                        );
+        $display("%m num_seg=%0d %s", num_seg, (num_seg==3) ? "OK" : "ERROR");
+        for (fdx=0; fdx<num_seg; fdx=fdx+1) begin
+            len = (fdx<2) ? 1460 : 4000-2*1460;
+            $display("%m segment %0d bnum_pkt=%0d %s", fdx, bnum_pkt[fdx],
+                     (bnum_pkt[fdx]==(14+20+20+len+4)) ? "OK" : "ERROR");
+            for (idx=0; idx<bnum_pkt[fdx]; idx=idx+1) frame[idx] = pkt_eth[fdx][idx];
+            $pkt_ethernet_parser( frame
+                                , bnum_pkt[fdx]
+                                , add_crc
+                                , add_preamble
+                                );
+        end
+        #10;
+    end
+endtask
+`endif
@@ -0,0 +1,139 @@
+`ifndef TOP_TASKS_STREAM_V
+`define TOP_TASKS_STREAM_V
+//----------------------------------------------------------------------------
+// It puts three segments of 4000-byte TCP payload out of order with
+// a retransmit, and checks bytes delivered in order and counters.
+// Then a segment cut into IP fragments is given to both
+// $pkt_ethernet_parser and $pkt_tcp_stream, which reassemble it apart.
+task test_stream;
+    reg [ 7:0] pkt_eth[0:3][0:1535];
+    reg [15:0] bnum_pkt[0:3];
+    reg [ 7:0] frame[0:1535];
+    integer    num_seg;
+    reg [47:0] mac_src;
+    reg [47:0] mac_dst;
+    reg [31:0] ip_src  ;
+    reg [31:0] ip_dst  ;
+    reg [15:0] port_src;
+    reg [15:0] port_dst;
+    integer    bnum_payload;
+    reg [ 7:0] payload[0:3999];
+    reg [ 7:0] data[0:3999];
+    integer    bnum_data;
+    integer    delivered, retransmits, gaps, window_violations;
+    reg [ 7:0] frag_eth[0:1][0:1535];
+    reg [15:0] bnum_frag[0:1];
+    integer    num_frag;
+    reg [ 7:0] segment[0:2019]; // TCP header and 2000-byte payload
+    integer idx, fdx, sdx, num, err;
+begin
+        mac_src=48'h02_12_34_56_78_9A;
+        mac_dst=48'h02_11_22_33_44_55;
+        ip_src  =32'hC0ABCDEF;
+        ip_dst  =32'hC1234567;
+        port_src=16'h3113;
+        port_dst=16'h1331;
+        bnum_payload=4000;
+        for (idx=0; idx<4000; idx=idx+1) payload[idx] = idx*7;
+//--------------------
+        $pkt_tcp_segment( pkt_eth
+                        , bnum_pkt
+                        , num_seg
+                        , port_src
+                        , port_dst
+                        , 32'hFFFFF800 // seq_num wraps
+                        , 32'h2000 // ack_num
+                        , ip_src
+                        , ip_dst
+                        , 16'h0200 // ip_id
+                        , mac_src
+                        , mac_dst
+                        , 1460 // mss
+                        , bnum_payload
+                        , payload
+                        , 8'h10 // ACK
+                        , 8'h09 // PSH|FIN
+                        , 1 // add_crc
+                        , 0 // add_preamble
+                        );
+        num = 0;
+        err = 0;
+        for (sdx=0; sdx<4; sdx=sdx+1) begin
+            fdx = (sdx==0) ? 0 : (sdx==1) ? 2 : (sdx==2) ? 2 : 1; // 2nd is missing till the last
+            for (idx=0; idx<bnum_pkt[fdx]; idx=idx+1) frame[idx] = pkt_eth[fdx][idx];
+            $pkt_tcp_stream( frame
+                           , bnum_pkt[fdx]
+                           , 0 // preamble
+                           , data
+                           , bnum_data
+                           );
+            for (idx=0; idx<bnum_data; idx=idx+1) begin
+                if (data[idx]!==payload[num+idx]) err = err+1;
+            end
+            num = num+bnum_data;
+        end
+        $display("%m delivered %0d bytes %s", num, ((num==4000)&&(err==0)) ? "OK" : "ERROR");
+        $pkt_tcp_stream_stat( ip_src
+                            , ip_dst
+                            , port_src
+                            , port_dst
+                            , delivered
+                            , retransmits
+                            , gaps
+                            , window_violations
+                            );
+        $display("%m delivered=%0d retransmits=%0d gaps=%0d window_violations=%0d %s"
+                , delivered, retransmits, gaps, window_violations
+                , ((delivered==4000)&&(retransmits==1)&&(gaps==1)&&(window_violations==0)) ? "OK" : "ERROR");
+//--------------------
+        port_src=16'h4114;
+        for (idx=0; idx<20; idx=idx+1) segment[idx] = 0;
+        {segment[0],segment[1]} = port_src;
+        {segment[2],segment[3]} = port_dst;
+        {segment[4],segment[5],segment[6],segment[7]} = 32'h1000; // seq_num
+        segment[12] = 8'h50; // header length
+        segment[13] = 8'h18; // PSH|ACK
+        {segment[14],segment[15]} = 16'hFFFF; // window
+        for (idx=0; idx<2000; idx=idx+1) segment[20+idx] = payload[idx];
+        $pkt_ip_fragment( frag_eth
+                        , bnum_frag
+                        , num_frag
+                        , ip_src
+                        , ip_dst
+                        , 8'h06 // TCP
+                        , 8'h40 // TTL
+                        , -1    // next IP ID of the flow
+                        , mac_src
+                        , mac_dst
+                        , 1500  // MTU
+                        , 2020
+                        , segment
+                        , 1 // add_crc
+                        , 0 // add_preamble
+                        );
+        num = 0;
+        err = 0;
+        for (fdx=0; fdx<num_frag; fdx=fdx+1) begin
+            for (idx=0; idx<bnum_frag[fdx]; idx=idx+1) frame[idx] = frag_eth[fdx][idx];
+            $pkt_ethernet_parser( frame
+                                , bnum_frag[fdx]
+                                , 1 // add_crc
+                                , 0 // add_preamble
+                                );
+            $pkt_tcp_stream( frame
+                           , bnum_frag[fdx]
+                           , 0 // preamble
+                           , data
+                           , bnum_data
+                           );
+            for (idx=0; idx<bnum_data; idx=idx+1) begin
+                if (data[idx]!==payload[num+idx]) err = err+1;
+            end
+            num = num+bnum_data;
+        end
+        $display("%m fragmented segment of %0d fragments delivered %0d bytes %s", num_frag, num
+                , ((num_frag==2)&&(num==2000)&&(err==0)) ? "OK" : "ERROR");
+        #10;
+    end
+endtask
+`endif
@@ -0,0 +1,71 @@
+`ifndef TOP_TASKS_TEMPLATE_V
+`define TOP_TASKS_TEMPLATE_V
+//----------------------------------------------------------------------------
+// It builds a TCP/IP/Ethernet frame once as a template and emits frames
+// of it by patching sequence number, IP ID and payload length.
+task test_template;
+    reg [ 7:0] pkt_eth[0:2047];
+    reg [15:0] bnum_pkt;
+    reg [47:0] mac_src;
+    reg [47:0] mac_dst;
+    reg [31:0] ip_src  ;
+    reg [31:0] ip_dst  ;
+    reg [15:0] port_src;
+    reg [15:0] port_dst;
+    reg [31:0] seq_num ;
+    reg [15:0] bnum_payload;
+    reg [ 7:0] payload[0:2047];
+    reg [31:0] add_crc;
+    integer    add_preamble;
+    integer    tpl;
+    integer idx, fdx;
+begin
+        mac_src=48'h02_12_34_56_78_9A;
+        mac_dst=48'h02_11_22_33_44_55;
+        ip_src  =32'hC0ABCDEF;
+        ip_dst  =32'hC1234567;
+        port_src=16'h2112;
+        port_dst=16'h1221;
+        seq_num =32'h1000;
+        bnum_payload=10;
+        for (idx=0; idx<2048; idx=idx+1) payload[idx] = 0;
+        add_crc=1;
+        add_preamble=0;
+//--------------------
+        $pkt_template_create( tpl
+                            , 6 // TCP
+                            , port_src
+                            , port_dst
+                            , ip_src
+                            , ip_dst
+                            , mac_src
+                            , mac_dst
+                            , bnum_payload
+                            , payload
+                            , 1460 // max_payload
+                            , add_crc
+                            , add_preamble
+                            );
+        for (fdx=0; fdx<4; fdx=fdx+1) begin
+            $pkt_template_emit( pkt_eth
+                              , bnum_pkt
+                              , tpl
+                              , "seq_num", seq_num
+                              , "ip_id", fdx
+                              , "bnum_payload", bnum_payload
+                              );
+            $display("%m frame %0d bnum_pkt=%0d %s", fdx, bnum_pkt,
+                     (bnum_pkt==(14+20+20+bnum_payload+4)) ? "OK" : "ERROR");
+            $pkt_ethernet_parser( pkt_eth
+                                , bnum_pkt
+                                , add_crc
+                                , add_preamble
+                                );
+            seq_num = seq_num + bnum_payload;
+            bnum_payload = bnum_payload + 100;
+        end
+        $pkt_template_release(tpl);
+        #10;
+    end
+endtask
+`endif
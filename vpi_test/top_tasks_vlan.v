@@ -0,0 +1,63 @@
+`ifndef TOP_TASKS_VLAN_V
+`define TOP_TASKS_VLAN_V
+//----------------------------------------------------------------------------
+// It builds 802.1Q and 802.1ad (QinQ) tagged frames of short UDP payload,
+// which are padded to 64-byte minimum frame, and parses them through tags.
+task test_vlan;
+    reg [ 7:0] pkt_eth[0:1535];
+    reg [15:0] bnum_pkt;
+    reg [47:0] mac_src;
+    reg [47:0] mac_dst;
+    reg [31:0] ip_src  ;
+    reg [31:0] ip_dst  ;
+    reg [15:0] port_src;
+    reg [15:0] port_dst;
+    reg [ 7:0] ttl     ;
+    integer    bnum_payload;
+    reg [ 7:0] payload[0:1499];
+    integer    add_crc;
+    integer    add_preamble;
+    integer idx, num;
+begin
+        mac_src=48'h02_12_34_56_78_9A;
+        mac_dst=48'h02_11_22_33_44_55;
+        ip_src  =32'hC0ABCDEF;
+        ip_dst  =32'hC1234567;
+        port_src=16'h4114;
+        port_dst=16'h1441;
+        ttl     =8'h40;
+        bnum_payload=6;
+        for (idx=0; idx<1500; idx=idx+1) payload[idx] = idx;
+        add_crc=1;
+        add_preamble=0;
+        for (num=1; num<=2; num=num+1) begin
+            if (num==1) $pkt_vlan(1, {16'h8100,3'd3,1'b0,12'd100}, 0);
+            else        $pkt_vlan(2, {16'h88A8,3'd5,1'b0,12'd200}, {16'h8100,3'd3,1'b0,12'd100});
+            $pkt_udp_ip_ethernet( pkt_eth
+                                , bnum_pkt
+                                , port_src
+                                , port_dst
+                                , ip_src
+                                , ip_dst
+                                , ttl
+                                , mac_src
+                                , mac_dst
+                                , bnum_payload
+                                , payload
+                                , add_crc
+                                , add_preamble
+                                );
+            $display("%m %0d tags bnum_pkt=%0d %s", num, bnum_pkt,
+                     ((bnum_pkt==64)&&(pkt_eth[12]==((num==1) ? 8'h81 : 8'h88))&&
+                      (pkt_eth[12+4*num]==8'h08)&&(pkt_eth[13+4*num]==8'h00)) ? "OK" : "ERROR");
+            $pkt_ethernet_parser( pkt_eth
+                                , bnum_pkt
+                                , add_crc
+                                , add_preamble
+                                );
+        end
+        $pkt_vlan(0, 0, 0); // untagged for others
+        #10;
+    end
+endtask
+`endif